@@ -409,10 +409,39 @@ protected:
   /** AccumulateDerivatives threader callback function. */
   static ITK_THREAD_RETURN_TYPE AccumulateDerivativesThreaderCallback( void * arg );
 
+  /** Decide whether the derivatives of the threads are accumulated sparsely.
+   * With a transform with compact support, such as the B-spline transform,
+   * every sample only contributes to GetNumberOfNonZeroJacobianIndices()
+   * parameters. When the number of samples times this number is smaller than
+   * the number of parameters, the threads record the parameters they touch,
+   * and only those are accumulated and reset, instead of all parameters of
+   * all threads. To be called before launching the threads.
+   */
+  void InitializeSparseDerivativeAccumulation( void ) const;
+
+  /** Record the parameters to which a sample of this thread contributes. */
+  void RecordTouchedParameters( const ThreadIdType threadId,
+    const NonZeroJacobianIndicesType & nzji ) const
+  {
+    if( this->m_UseSparseDerivativeAccumulation )
+    {
+      NonZeroJacobianIndicesType & touched
+        = this->m_GetValueAndDerivativePerThreadVariables[ threadId ].st_TouchedParameters;
+      touched.insert( touched.end(), nzji.begin(), nzji.end() );
+    }
+  }
+
+  /** Accumulate the derivatives of all threads, multiplied by the
+   * normalization, in the recorded parameters only, and reset them.
+   */
+  void AccumulateSparseDerivatives( DerivativeType & derivative,
+    const DerivativeValueType normalization ) const;
+
   /** Variables for multi-threading. */
-  bool m_UseMetricSingleThreaded;
-  bool m_UseMultiThread;
-  bool m_UseOpenMP;
+  bool         m_UseMetricSingleThreaded;
+  bool         m_UseMultiThread;
+  bool         m_UseOpenMP;
+  mutable bool m_UseSparseDerivativeAccumulation;
 
   /** Helper structs that multi-threads the computation of
    * the metric derivative using ITK threads.
@@ -452,9 +481,10 @@ protected:
   // test per thread struct with padding and alignment
   struct GetValueAndDerivativePerThreadStruct
   {
-    SizeValueType  st_NumberOfPixelsCounted;
-    MeasureType    st_Value;
-    DerivativeType st_Derivative;
+    SizeValueType              st_NumberOfPixelsCounted;
+    MeasureType                st_Value;
+    DerivativeType             st_Derivative;
+    NonZeroJacobianIndicesType st_TouchedParameters;
   };
   itkPadStruct( ITK_CACHE_LINE_ALIGNMENT, GetValueAndDerivativePerThreadStruct,
     PaddedGetValueAndDerivativePerThreadStruct );
@@ -501,6 +531,30 @@ protected:
     RealType & movingImageValue,
     MovingImageDerivativeType * gradient ) const;
 
+  /** The number of points that EvaluateMovingImageValuesAndDerivatives()
+   * evaluates at once. Metrics can process their samples in blocks of this size.
+   */
+  itkStaticConstMacro( MovingImageBatchSize, unsigned int, 64 );
+
+  /** Compute the image values and derivatives at a batch of transformed points.
+   * Only the points for which sampleOk is true are evaluated; for points outside
+   * the moving image buffer sampleOk is set to false. If an
+   * AdvancedLinearInterpolateImageFunction is used, the values and derivatives
+   * of the points are interpolated per block of MovingImageBatchSize points at
+   * once. Otherwise EvaluateMovingImageValueAndDerivative() is called per point.
+   */
+  virtual void EvaluateMovingImageValuesAndDerivatives(
+    const MovingImagePointType * mappedPoints,
+    RealType * movingImageValues,
+    MovingImageDerivativeType * gradients,
+    bool * sampleOk,
+    const unsigned int numberOfPoints ) const;
+
+  /** Multiply a moving image gradient with the MovingImageDerivativeScales,
+   * if UseMovingImageDerivativeScales is true.
+   */
+  void ScaleMovingImageDerivative( MovingImageDerivativeType & gradient ) const;
+
   /** Computes the inner product of transform Jacobian with moving image gradient.
    * The results are stored in imageJacobian, which is supposed
    * to have the right size (same length as Jacobian's number of columns).
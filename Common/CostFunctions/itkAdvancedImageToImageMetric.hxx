@@ -85,8 +85,9 @@ AdvancedImageToImageMetric< TFixedImage, TMovingImage >
   this->m_MovingImageMaxLimit   = NumericTraits< MovingImageLimiterOutputType >::One;
 
   /** Threading related variables. */
-  this->m_UseMetricSingleThreaded = true;
-  this->m_UseMultiThread = false;
+  this->m_UseMetricSingleThreaded         = true;
+  this->m_UseMultiThread                  = false;
+  this->m_UseSparseDerivativeAccumulation = false;
 
 #if ITK_VERSION_MAJOR < 5
   // Note: This `#if` is a workaround for ITK5, which no longer supports calling
@@ -237,6 +238,7 @@ AdvancedImageToImageMetric< TFixedImage, TMovingImage >
     this->m_GetValueAndDerivativePerThreadVariables[ i ].st_Value                 = NumericTraits< MeasureType >::Zero;
     this->m_GetValueAndDerivativePerThreadVariables[ i ].st_Derivative.SetSize( this->GetNumberOfParameters() );
     this->m_GetValueAndDerivativePerThreadVariables[ i ].st_Derivative.Fill( NumericTraits< DerivativeValueType >::ZeroValue() );
+    this->m_GetValueAndDerivativePerThreadVariables[ i ].st_TouchedParameters.clear();
   }
 
 } // end InitializeThreadingParameters()
@@ -647,44 +649,7 @@ AdvancedImageToImageMetric< TFixedImage, TMovingImage >
       }
 
       /** The moving image gradient is multiplied with its scales, when requested. */
-      if( this->m_UseMovingImageDerivativeScales )
-      {
-        if( !this->m_ScaleGradientWithRespectToMovingImageOrientation )
-        {
-          for( unsigned int i = 0; i < MovingImageDimension; ++i )
-          {
-            ( *gradient )[ i ] *= this->m_MovingImageDerivativeScales[ i ];
-          }
-        }
-        else
-        {
-          /** Optionally, the scales are applied with respect to the moving image orientation.
-           * The above default option implicitly applies the scales with respect to the
-           * orientation of the transformation axis. In some cases you may want to restrict
-           * moving image motion with respect to its own axes. This is achieved below by pre
-           * and post rotation by the direction cosines of the moving image.
-           * First the gradient is rotated backwards to a standardized axis.
-           */
-          typedef typename MovingImageType::DirectionType::InternalMatrixType InternalMatrixType;
-          const InternalMatrixType M                    = this->GetMovingImage()->GetDirection().GetVnlMatrix();
-          vnl_vector< double >     rotated_gradient_vnl = M.transpose() * gradient->GetVnlVector();
-
-          /** Then scales are applied. */
-          for( unsigned int i = 0; i < MovingImageDimension; ++i )
-          {
-            rotated_gradient_vnl[ i ] *= this->m_MovingImageDerivativeScales[ i ];
-          }
-
-          /** The scaled gradient is then rotated forwards again. */
-          rotated_gradient_vnl = M * rotated_gradient_vnl;
-
-          /** Copy the vnl version back to the original. */
-          for( unsigned int i = 0; i < MovingImageDimension; ++i )
-          {
-            ( *gradient )[ i ] = rotated_gradient_vnl[ i ];
-          }
-        }
-      } // end if m_UseMovingImageDerivativeScales
+      this->ScaleMovingImageDerivative( *gradient );
     } // end if gradient
     else
     {
@@ -697,6 +662,129 @@ AdvancedImageToImageMetric< TFixedImage, TMovingImage >
 } // end EvaluateMovingImageValueAndDerivative()
 
 
+/**
+ * ******************* EvaluateMovingImageValuesAndDerivatives ******************
+ */
+
+template< class TFixedImage, class TMovingImage >
+void
+AdvancedImageToImageMetric< TFixedImage, TMovingImage >
+::EvaluateMovingImageValuesAndDerivatives(
+  const MovingImagePointType * mappedPoints,
+  RealType * movingImageValues,
+  MovingImageDerivativeType * gradients,
+  bool * sampleOk,
+  const unsigned int numberOfPoints ) const
+{
+  /** Without the linear interpolator, the points are evaluated one by one. */
+  if( !this->m_InterpolatorIsLinear || this->GetComputeGradient() )
+  {
+    for( unsigned int i = 0; i < numberOfPoints; ++i )
+    {
+      if( sampleOk[ i ] )
+      {
+        sampleOk[ i ] = this->EvaluateMovingImageValueAndDerivative(
+          mappedPoints[ i ], movingImageValues[ i ], &gradients[ i ] );
+      }
+    }
+    return;
+  }
+
+  /** Per block, the points inside the moving image buffer are collected, and
+   * interpolated with one call of the linear interpolator.
+   */
+  MovingImageContinuousIndexType cindices[ MovingImageBatchSize ];
+  RealType                       values[ MovingImageBatchSize ];
+  MovingImageDerivativeType      derivatives[ MovingImageBatchSize ];
+  unsigned int                   pointIds[ MovingImageBatchSize ];
+  const unsigned int             batchSize = MovingImageBatchSize;
+  for( unsigned int blockBegin = 0; blockBegin < numberOfPoints; blockBegin += batchSize )
+  {
+    const unsigned int blockEnd = ( blockBegin + batchSize < numberOfPoints )
+      ? blockBegin + batchSize : numberOfPoints;
+    unsigned int numberOfInsidePoints = 0;
+    for( unsigned int i = blockBegin; i < blockEnd; ++i )
+    {
+      if( !sampleOk[ i ] )
+      {
+        continue;
+      }
+      MovingImageContinuousIndexType & cindex = cindices[ numberOfInsidePoints ];
+      this->m_Interpolator->ConvertPointToContinuousIndex( mappedPoints[ i ], cindex );
+      sampleOk[ i ] = this->m_Interpolator->IsInsideBuffer( cindex );
+      if( sampleOk[ i ] )
+      {
+        pointIds[ numberOfInsidePoints++ ] = i;
+      }
+    }
+
+    this->m_LinearInterpolator->EvaluateValueAndDerivativeAtContinuousIndices(
+      cindices, values, derivatives, numberOfInsidePoints );
+
+    for( unsigned int j = 0; j < numberOfInsidePoints; ++j )
+    {
+      movingImageValues[ pointIds[ j ] ] = values[ j ];
+      gradients[ pointIds[ j ] ]         = derivatives[ j ];
+      this->ScaleMovingImageDerivative( gradients[ pointIds[ j ] ] );
+    }
+  }
+
+} // end EvaluateMovingImageValuesAndDerivatives()
+
+
+/**
+ * ******************* ScaleMovingImageDerivative ******************
+ */
+
+template< class TFixedImage, class TMovingImage >
+void
+AdvancedImageToImageMetric< TFixedImage, TMovingImage >
+::ScaleMovingImageDerivative( MovingImageDerivativeType & gradient ) const
+{
+  if( !this->m_UseMovingImageDerivativeScales )
+  {
+    return;
+  }
+
+  if( !this->m_ScaleGradientWithRespectToMovingImageOrientation )
+  {
+    for( unsigned int i = 0; i < MovingImageDimension; ++i )
+    {
+      gradient[ i ] *= this->m_MovingImageDerivativeScales[ i ];
+    }
+  }
+  else
+  {
+    /** Optionally, the scales are applied with respect to the moving image orientation.
+     * The above default option implicitly applies the scales with respect to the
+     * orientation of the transformation axis. In some cases you may want to restrict
+     * moving image motion with respect to its own axes. This is achieved below by pre
+     * and post rotation by the direction cosines of the moving image.
+     * First the gradient is rotated backwards to a standardized axis.
+     */
+    typedef typename MovingImageType::DirectionType::InternalMatrixType InternalMatrixType;
+    const InternalMatrixType M                    = this->GetMovingImage()->GetDirection().GetVnlMatrix();
+    vnl_vector< double >     rotated_gradient_vnl = M.transpose() * gradient.GetVnlVector();
+
+    /** Then scales are applied. */
+    for( unsigned int i = 0; i < MovingImageDimension; ++i )
+    {
+      rotated_gradient_vnl[ i ] *= this->m_MovingImageDerivativeScales[ i ];
+    }
+
+    /** The scaled gradient is then rotated forwards again. */
+    rotated_gradient_vnl = M * rotated_gradient_vnl;
+
+    /** Copy the vnl version back to the original. */
+    for( unsigned int i = 0; i < MovingImageDimension; ++i )
+    {
+      gradient[ i ] = rotated_gradient_vnl[ i ];
+    }
+  }
+
+} // end ScaleMovingImageDerivative()
+
+
 /**
  * *************** EvaluateTransformJacobianInnerProduct ****************
  */
@@ -1001,6 +1089,84 @@ AdvancedImageToImageMetric< TFixedImage, TMovingImage >
 } // end AccumulateDerivativesThreaderCallback()
 
 
+/**
+ *********** InitializeSparseDerivativeAccumulation *************
+ */
+
+template< class TFixedImage, class TMovingImage >
+void
+AdvancedImageToImageMetric< TFixedImage, TMovingImage >
+::InitializeSparseDerivativeAccumulation( void ) const
+{
+  this->m_UseSparseDerivativeAccumulation = false;
+  if( !this->m_TransformIsAdvanced || !this->m_UseImageSampler )
+  {
+    return;
+  }
+
+  /** Accumulating sparsely pays off when the samples together touch fewer
+   * parameters than a single dense derivative has, since the dense
+   * accumulation visits every parameter of every thread.
+   */
+  const NumberOfParametersType numberOfParameters = this->GetNumberOfParameters();
+  const NumberOfParametersType nnzji
+    = this->m_AdvancedTransform->GetNumberOfNonZeroJacobianIndices();
+  const double numberOfTouchedParameters
+    = static_cast< double >( this->GetImageSampler()->GetOutput()->Size() )
+    * static_cast< double >( nnzji );
+  this->m_UseSparseDerivativeAccumulation = nnzji < numberOfParameters
+    && numberOfTouchedParameters < static_cast< double >( numberOfParameters );
+
+  /** Prepare the lists of touched parameters. */
+  if( this->m_UseSparseDerivativeAccumulation )
+  {
+    const ThreadIdType  numberOfThreads  = Self::GetNumberOfThreads();
+    const unsigned long touchedPerThread = static_cast< unsigned long >(
+      std::ceil( numberOfTouchedParameters / static_cast< double >( numberOfThreads ) ) );
+    for( ThreadIdType i = 0; i < numberOfThreads; ++i )
+    {
+      this->m_GetValueAndDerivativePerThreadVariables[ i ].st_TouchedParameters.clear();
+      this->m_GetValueAndDerivativePerThreadVariables[ i ].st_TouchedParameters.reserve( touchedPerThread );
+    }
+  }
+
+} // end InitializeSparseDerivativeAccumulation()
+
+
+/**
+ *********** AccumulateSparseDerivatives *************
+ */
+
+template< class TFixedImage, class TMovingImage >
+void
+AdvancedImageToImageMetric< TFixedImage, TMovingImage >
+::AccumulateSparseDerivatives( DerivativeType & derivative,
+  const DerivativeValueType normalization ) const
+{
+  const ThreadIdType        numberOfThreads = Self::GetNumberOfThreads();
+  const DerivativeValueType zero            = NumericTraits< DerivativeValueType >::Zero;
+
+  derivative.Fill( zero );
+
+  /** A parameter may be recorded more than once. Since the sub-derivative is
+   * reset after it is added, the next time nothing is added.
+   */
+  for( ThreadIdType i = 0; i < numberOfThreads; ++i )
+  {
+    DerivativeType &             subDerivative = this->m_GetValueAndDerivativePerThreadVariables[ i ].st_Derivative;
+    NonZeroJacobianIndicesType & touched       = this->m_GetValueAndDerivativePerThreadVariables[ i ].st_TouchedParameters;
+    for( typename NonZeroJacobianIndicesType::const_iterator it = touched.begin();
+      it != touched.end(); ++it )
+    {
+      derivative[ *it ]   += subDerivative[ *it ] * normalization;
+      subDerivative[ *it ] = zero;
+    }
+    touched.clear();
+  }
+
+} // end AccumulateSparseDerivatives()
+
+
 /**
  * *********************** CheckNumberOfSamples ***********************
  */
@@ -95,6 +95,7 @@ public:
   typedef typename Superclass::ImageSampleContainerPointer ImageSampleContainerPointer;
   typedef typename Superclass::ThreaderType                ThreaderType;
   typedef typename Superclass::ThreadInfoType              ThreadInfoType;
+  typedef typename Superclass::NumberOfParametersType      NumberOfParametersType;
 
   /** Typedef's for the B-spline transform. */
   typedef typename Superclass::CombinationTransformType       CombinationTransformType;
@@ -119,16 +120,86 @@ public:
   /** Define the dimension. */
   itkStaticConstMacro( FixedImageDimension, unsigned int, FixedImageType::ImageDimension );
 
+  /** Typedefs for points and indices. */
+  typedef typename Superclass::FixedImagePointType        FixedImagePointType;
+  typedef typename Superclass::MovingImagePointType       MovingImagePointType;
+  typedef typename Superclass::NonZeroJacobianIndicesType NonZeroJacobianIndicesType;
+
+  /** Shared evaluation of the transform at the samples.
+   *
+   * Penalty terms that use the same image sampler, transform and moving
+   * image mask all evaluate the transform at the same points. The
+   * CombinationImageToImageMetric then evaluates the transform only once per
+   * sample, for all these penalty terms, and lets every penalty term
+   * accumulate its contribution from the shared results:
+   * - GetSampleRequirements() tells which transform quantities are needed,
+   * - EvaluateSample() computes them for a sample, and
+   * - AccumulateSample() adds the contribution of a sample to the
+   *   variables of a thread, such that AfterAccumulateSamples() combines
+   *   the results of all threads into the value and derivative.
+   * The samples should only be accumulated after
+   * BeforeThreadedGetValueAndDerivative() has been called.
+   */
+  typedef enum {
+    SampleRequiresJacobian                 = 1,
+    SampleRequiresJacobianOfSpatialHessian = 2
+  } SampleRequirementType;
+
+  /** The transform quantities at a sample. Only the quantities that were
+   * required by EvaluateSample() are filled.
+   */
+  struct SampleType
+  {
+    FixedImagePointType          FixedPoint;
+    MovingImagePointType         MappedPoint;
+    TransformJacobianType        Jacobian;
+    NonZeroJacobianIndicesType   JacobianIndices;
+    SpatialHessianType           SpatialHessian;
+    JacobianOfSpatialHessianType JacobianOfSpatialHessian;
+    NonZeroJacobianIndicesType   HessianIndices;
+  };
+
+  /** Get the transform quantities needed by AccumulateSample(), as a
+   * combination of SampleRequirementType flags. Zero means that this penalty
+   * term does not support the shared evaluation, which is the default.
+   */
+  virtual unsigned int GetSampleRequirements( void ) const
+  {
+    return 0;
+  }
+
+
+  /** Check if this penalty term can accumulate samples for the given number
+   * of threads, with the current settings.
+   */
+  bool CanAccumulateSamples( const ThreadIdType numberOfThreads ) const;
+
+  /** Evaluate the transform at a fixed point. Returns false if the point
+   * does not map inside the transform support region or inside the moving
+   * image mask, in which case the sample does not count. Thread-safe.
+   */
+  bool EvaluateSample( const FixedImagePointType & fixedPoint,
+    const unsigned int requirements, SampleType & sample ) const;
+
+  /** Add the contribution of a valid sample to the variables of a thread.
+   * Thread-safe, as long as the thread ids differ.
+   */
+  virtual void AccumulateSample( const ThreadIdType threadId,
+    const SampleType & sample ) const {}
+
+  /** Combine the accumulated samples of all threads. By default, the values
+   * and derivatives are summed and divided by the number of valid samples.
+   */
+  virtual void AfterAccumulateSamples(
+    MeasureType & value, DerivativeType & derivative ) const;
+
 protected:
 
   /** Typedefs for indices and points. */
   typedef typename Superclass::FixedImageIndexType            FixedImageIndexType;
   typedef typename Superclass::FixedImageIndexValueType       FixedImageIndexValueType;
   typedef typename Superclass::MovingImageIndexType           MovingImageIndexType;
-  typedef typename Superclass::FixedImagePointType            FixedImagePointType;
-  typedef typename Superclass::MovingImagePointType           MovingImagePointType;
   typedef typename Superclass::MovingImageContinuousIndexType MovingImageContinuousIndexType;
-  typedef typename Superclass::NonZeroJacobianIndicesType     NonZeroJacobianIndicesType;
 
   /** The constructor. */
   TransformPenaltyTerm(){}
@@ -19,6 +19,7 @@
 #define __itkTransformPenaltyTerm_hxx
 
 #include "itkTransformPenaltyTerm.h"
+#include "vnl/vnl_math.h"
 
 namespace itk
 {
@@ -66,6 +67,136 @@ TransformPenaltyTerm< TFixedImage, TScalarType >
 } // end CheckForBSplineTransform()
 
 
+/**
+ * ****************** CanAccumulateSamples *******************************
+ */
+
+template< class TFixedImage, class TScalarType >
+bool
+TransformPenaltyTerm< TFixedImage, TScalarType >
+::CanAccumulateSamples( const ThreadIdType numberOfThreads ) const
+{
+  /** The samples are accumulated in the variables of the multi-threaded
+   * GetValueAndDerivative(), which are only allocated when multi-threading
+   * is used.
+   */
+  return this->GetSampleRequirements() != 0
+         && this->m_UseMultiThread
+         && this->m_UseImageSampler
+         && this->m_TransformIsAdvanced
+         && Self::GetNumberOfThreads() == numberOfThreads
+         && this->m_GetValueAndDerivativePerThreadVariablesSize == numberOfThreads;
+
+} // end CanAccumulateSamples()
+
+
+/**
+ * ****************** EvaluateSample *******************************
+ */
+
+template< class TFixedImage, class TScalarType >
+bool
+TransformPenaltyTerm< TFixedImage, TScalarType >
+::EvaluateSample( const FixedImagePointType & fixedPoint,
+  const unsigned int requirements, SampleType & sample ) const
+{
+  /** Transform point and check if it is inside the B-spline support region
+   * and inside the moving image mask.
+   */
+  sample.FixedPoint = fixedPoint;
+  bool sampleOk = this->TransformPoint( fixedPoint, sample.MappedPoint );
+  if( sampleOk )
+  {
+    sampleOk = this->IsInsideMovingMask( sample.MappedPoint );
+  }
+  if( !sampleOk )
+  {
+    return false;
+  }
+
+  /** The sizes of the sample quantities only change when the transform
+   * changes, so they are only set the first time.
+   */
+  const NumberOfParametersType numberOfNonZeroJacobianIndices
+    = this->m_AdvancedTransform->GetNumberOfNonZeroJacobianIndices();
+
+  /** Get the TransformJacobian dT/dmu. */
+  if( requirements & SampleRequiresJacobian )
+  {
+    if( sample.JacobianIndices.size() != numberOfNonZeroJacobianIndices )
+    {
+      sample.Jacobian.SetSize( FixedImageDimension, numberOfNonZeroJacobianIndices );
+      sample.Jacobian.Fill( 0.0 );
+      sample.JacobianIndices.resize( numberOfNonZeroJacobianIndices );
+    }
+    this->EvaluateTransformJacobian( fixedPoint,
+      sample.Jacobian, sample.JacobianIndices );
+  }
+
+  /** Get the spatial Hessian and its derivative to mu. */
+  if( requirements & SampleRequiresJacobianOfSpatialHessian )
+  {
+    if( sample.HessianIndices.size() != numberOfNonZeroJacobianIndices )
+    {
+      sample.JacobianOfSpatialHessian.resize( numberOfNonZeroJacobianIndices );
+      sample.HessianIndices.resize( numberOfNonZeroJacobianIndices );
+    }
+    this->m_AdvancedTransform->GetJacobianOfSpatialHessian( fixedPoint,
+      sample.SpatialHessian, sample.JacobianOfSpatialHessian, sample.HessianIndices );
+  }
+
+  return true;
+
+} // end EvaluateSample()
+
+
+/**
+ * ****************** AfterAccumulateSamples *******************************
+ */
+
+template< class TFixedImage, class TScalarType >
+void
+TransformPenaltyTerm< TFixedImage, TScalarType >
+::AfterAccumulateSamples(
+  MeasureType & value, DerivativeType & derivative ) const
+{
+  const ThreadIdType numberOfThreads = Self::GetNumberOfThreads();
+
+  /** Accumulate the number of pixels and the values. */
+  this->m_NumberOfPixelsCounted = 0;
+  value = NumericTraits< MeasureType >::Zero;
+  for( ThreadIdType i = 0; i < numberOfThreads; ++i )
+  {
+    this->m_NumberOfPixelsCounted += this->m_GetValueAndDerivativePerThreadVariables[ i ].st_NumberOfPixelsCounted;
+    value                 += this->m_GetValueAndDerivativePerThreadVariables[ i ].st_Value;
+
+    /** Reset these variables for the next iteration. */
+    this->m_GetValueAndDerivativePerThreadVariables[ i ].st_NumberOfPixelsCounted = 0;
+    this->m_GetValueAndDerivativePerThreadVariables[ i ].st_Value = NumericTraits< MeasureType >::Zero;
+  }
+
+  /** Check if enough samples were valid. */
+  ImageSampleContainerPointer sampleContainer = this->GetImageSampler()->GetOutput();
+  this->CheckNumberOfSamples( sampleContainer->Size(), this->m_NumberOfPixelsCounted );
+
+  /** Normalize the value. */
+  const DerivativeValueType normalization = vnl_math_max(
+    NumericTraits< DerivativeValueType >::One,
+    static_cast< DerivativeValueType >( this->m_NumberOfPixelsCounted ) );
+  value /= normalization;
+
+  /** Accumulate and normalize the derivatives multi-threadedly. */
+  derivative.SetSize( this->GetNumberOfParameters() );
+  this->m_ThreaderMetricParameters.st_DerivativePointer   = derivative.begin();
+  this->m_ThreaderMetricParameters.st_NormalizationFactor = normalization;
+
+  this->m_Threader->SetSingleMethod( this->AccumulateDerivativesThreaderCallback,
+    const_cast< void * >( static_cast< const void * >( &this->m_ThreaderMetricParameters ) ) );
+  this->m_Threader->SingleMethodExecute();
+
+} // end AfterAccumulateSamples()
+
+
 } // end namespace itk
 
 #endif // #ifndef __itkTransformPenaltyTerm_hxx
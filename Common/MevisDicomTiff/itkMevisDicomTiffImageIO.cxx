@@ -47,6 +47,7 @@
 #include <sstream>
 #include <string>
 #include <vector>
+#include <algorithm>
 #include <fstream>
 #include <iostream>
 
@@ -76,6 +77,9 @@ MevisDicomTiffImageIO
   m_TileLength( 0 ),
   m_TileDepth( 0 ),
   m_NumberOfTiles( 0 ),
+  m_IsWritingTiles( false ),
+  m_NextSlice( 0 ),
+  m_NextRow( 0 ),
   m_RescaleSlope( NumericTraits< double >::OneValue() ),
   m_RescaleIntercept( NumericTraits< double >::ZeroValue() ),
   m_GantryTilt( NumericTraits< double >::ZeroValue() ),
@@ -104,7 +108,7 @@ MevisDicomTiffImageIO
 // destructor
 MevisDicomTiffImageIO::~MevisDicomTiffImageIO()
 {
-  if( m_IsOpen )
+  if( m_IsOpen || m_IsWritingTiles )
   {
     TIFFClose( m_TIFFImage );
   }
@@ -129,6 +133,7 @@ MevisDicomTiffImageIO::PrintSelf( std::ostream & os, Indent indent ) const
   os << indent << "TileWidth        : " << m_TileWidth << std::endl;
   os << indent << "TileLength       : " << m_TileLength << std::endl;
   os << indent << "TileDepth        : " << m_TileDepth << std::endl;
+  os << indent << "IsWritingTiles   : " << m_IsWritingTiles << std::endl;
   os << indent << "NumberOfTiles    : " << m_NumberOfTiles << std::endl;
   os << indent << "RescaleIntercept : " << m_RescaleIntercept << std::endl;
   os << indent << "RescaleSlope     : " << m_RescaleSlope << std::endl;
@@ -824,9 +829,9 @@ MevisDicomTiffImageIO::Read( void * buffer )
   // TIFFTileSize     returns size of one tile in bytes
   // TIFFReadTile     reads one tile, returns number of bytes in decoded tile
   //
-  // note *buffer goes in scanline order!
-  // very inconvenient if the tiff image is tiled, which damned
-  // is the case for mevislab images!
+  // note *buffer goes in scanline order, and only contains the
+  // requested io region! we only decode the tiles that overlap
+  // with that region, and copy the overlapping part of each row.
   // note buffer is already allocated, according to size!
 
   short int p;
@@ -843,357 +848,122 @@ MevisDicomTiffImageIO::Read( void * buffer )
     }
   }
 
-  if( m_IsTiled )
+  if( !m_IsTiled )
   {
-    // only works for tile depth == 1 (used by mevislab),
-    // therefore in z-direction we do not need to do checking
-    // if the volume is multiple of tile.
-    if( m_TIFFDimension == 3 && m_TileDepth != 1 )
-    {
-      itkExceptionMacro( << "mevisIO:read(): unsupported tiledepth (should be one)! " );
-      return;
-    }
-
-    // buffer pointer is scanline based (one dimensional array)
-    // tile is positioned on x,y,z; we read each tile, and fill
-    // the corresponding positions in the onedimensional array
-    unsigned char * vol = reinterpret_cast< unsigned char * >( buffer );
+    // if not tiled then img is stripped
+    itkExceptionMacro( << "mevisIO:read(): non-tiled dcm/tiff reading not (yet) implemented" );
+    return;
+  }
 
-    const unsigned int tilesize       = TIFFTileSize( m_TIFFImage );
-    const unsigned int tilerowbytes   = TIFFTileRowSize( m_TIFFImage );
-    const unsigned int bytespersample = m_BitsPerSample / 8;
+  // only works for tile depth == 1 (used by mevislab),
+  // therefore in z-direction we do not need to do checking
+  // if the volume is multiple of tile.
+  if( m_TIFFDimension == 3 && m_TileDepth != 1 )
+  {
+    itkExceptionMacro( << "mevisIO:read(): unsupported tiledepth (should be one)! " );
+    return;
+  }
 
-    unsigned char * tilebuf = static_cast< unsigned char * >( _TIFFmalloc( tilesize ) );
+  // the region to read, as start and size in 4d
+  unsigned int start[ 4 ];
+  unsigned int size[ 4 ];
+  this->GetRegionToReadOrWrite( start, size );
 
-    //
-    // special cases, if the tilexy is larger than or equal to the image
-    // size itself, treat as three separate cases, both are larger/equal,
-    // or only direction
-    //
-    bool tileoversized( false );
+  unsigned char *    vol            = reinterpret_cast< unsigned char * >( buffer );
+  const unsigned int tilesize       = TIFFTileSize( m_TIFFImage );
+  const unsigned int tilerowbytes   = TIFFTileRowSize( m_TIFFImage );
+  const unsigned int bytespersample = m_BitsPerSample / 8;
+  const unsigned int rowbytes       = size[ 0 ] * bytespersample;
 
-    if( m_TileLength >= m_Length || m_TileWidth >= m_Width )
-    {
-      tileoversized = true;
+  unsigned char * tilebuf = static_cast< unsigned char * >( _TIFFmalloc( tilesize ) );
 
-      // case one both x,y is larger
-      if( m_TileLength >= m_Length && m_TileWidth >= m_Width )
-      {
-        for( unsigned int z0 = 0; z0 < ( m_TIFFDimension == 3 ? m_Depth : 1 ); z0++ )
-        {
-          if( TIFFReadTile( m_TIFFImage, tilebuf, 0, 0, z0, 0 ) < 0 )
-          {
-            _TIFFfree( tilebuf );
-            itkExceptionMacro( << "mevisIO:read(): error reading tile (topleft)" );
-            return;
-          }
-          else
-          {
-            // do row based copy of tile into volume
-            const unsigned     lenx       = m_Width;
-            const unsigned     leny       = m_Length;
-            const unsigned int tilexbytes = lenx * bytespersample;
+  // the first and last tile in x and y that overlap with the region
+  const unsigned int x1 = start[ 0 ] + size[ 0 ];
+  const unsigned int y1 = start[ 1 ] + size[ 1 ];
+  const unsigned int tx0 = ( start[ 0 ] / m_TileWidth ) * m_TileWidth;
+  const unsigned int ty0 = ( start[ 1 ] / m_TileLength ) * m_TileLength;
 
-            unsigned char *    pv = vol;
-            const unsigned int p  = z0 * m_Length * m_Width;
-            pv += p * bytespersample;
+  // loop over the slices of the region; in 4d the slices of
+  // all time points are stored after each other in the tiff
+  for( unsigned int t = start[ 3 ]; t < start[ 3 ] + size[ 3 ]; ++t )
+  {
+    for( unsigned int z = start[ 2 ]; z < start[ 2 ] + size[ 2 ]; ++z )
+    {
+      const unsigned int z0 = ( m_TIFFDimension == 3 ) ? t * m_Dimensions[ 2 ] + z : 0;
 
-            unsigned char * pb = tilebuf;
-            for( unsigned int r = 0; r < leny; ++r )
-            {
-              memcpy( pv, pb, tilexbytes );
-              pv += tilexbytes;
-              pb += tilerowbytes;
-            }
-          }
-        }
-      } // end case one
+      // pointer to the first row of this slice in the volume
+      unsigned char * pslice = vol
+        + ( ( t - start[ 3 ] ) * size[ 2 ] + ( z - start[ 2 ] ) ) * size[ 1 ] * rowbytes;
 
-      // case two, larger x, smaller y
-      if( m_TileWidth >= m_Width && m_TileLength < m_Length )
+      for( unsigned int y0 = ty0; y0 < y1; y0 += m_TileLength )
       {
+        // rows of this tile inside the region
+        const unsigned int ya = std::max( y0, start[ 1 ] );
+        const unsigned int yb = std::min( y0 + m_TileLength, y1 );
 
-        const unsigned     lenx       = m_Width;
-        const unsigned int tilexbytes = lenx * bytespersample;
-
-        const bool my = ( m_Length % m_TileLength == 0 ) ? true : false;
-        for( unsigned int z0 = 0; z0 < ( m_TIFFDimension == 3 ? m_Depth : 1 ); z0++ )
+        for( unsigned int x0 = tx0; x0 < x1; x0 += m_TileWidth )
         {
-          for( unsigned int y0 = 0; y0 < ( my ? m_Length : m_Length - m_TileLength ); y0 += m_TileLength )
-          {
-            if( TIFFReadTile( m_TIFFImage, tilebuf, 0, y0, z0, 0 ) < 0 )
-            {
-              _TIFFfree( tilebuf );
-              itkExceptionMacro( << "mevisIO:read(): error reading tile (top image)" );
-              return;
-            }
-            else
-            {
+          // columns of this tile inside the region
+          const unsigned int xa = std::max( x0, start[ 0 ] );
+          const unsigned int xb = std::min( x0 + m_TileWidth, x1 );
 
-              unsigned char *    pb = tilebuf;
-              unsigned char *    pv = vol;
-              const unsigned int p  = z0 * m_Length * m_Width + y0 * m_Width;
-              pv += p * bytespersample;
-
-              for( unsigned int r = 0; r < m_TileLength; ++r )
-              {
-                memcpy( pv, pb, tilerowbytes );
-                pv += tilexbytes;
-                pb += tilerowbytes;
-              }
-            }
-          }
-
-          if( !my )
+          if( TIFFReadTile( m_TIFFImage, tilebuf, x0, y0, z0, 0 ) < 0 )
           {
-            const unsigned     leny = m_Length % m_TileLength;
-            const unsigned int y0   = m_Length - leny;
-
-            if( TIFFReadTile( m_TIFFImage, tilebuf, 0, y0, z0, 0 ) < 0 )
-            {
-              _TIFFfree( tilebuf );
-              itkExceptionMacro( << "mevisIO:read(): error reading tile (strip bottom)" );
-              return;
-            }
-            else
-            {
-              unsigned char *    pb = tilebuf;
-              unsigned char *    pv = vol;
-              const unsigned int p  = z0 * m_Length * m_Width + y0 * m_Width;
-              pv += p * bytespersample;
-
-              for( unsigned int r = 0; r < leny; ++r )
-              {
-                memcpy( pv, pb, tilexbytes );
-                pv += tilexbytes;
-                pb += tilerowbytes;
-              }
-            }
+            _TIFFfree( tilebuf );
+            itkExceptionMacro( << "mevisIO:read(): error reading tile at "
+                               << x0 << ", " << y0 << ", " << z0 );
+            return;
           }
-        }
-
-      } // end case two
 
-      // case three, smaller x, larger y
-      if( m_TileWidth < m_Width && m_TileLength >= m_Length )
-      {
-
-        const unsigned leny = m_Length;
-        const bool     mx   = ( m_Width % m_TileWidth == 0 ) ? true : false;
-
-        for( unsigned int z0 = 0; z0 < ( m_TIFFDimension == 3 ? m_Depth : 1 ); z0++ )
-        {
-          for( unsigned int x0 = 0; x0 < ( mx ? m_Width : m_Width - m_TileWidth ); x0 += m_TileWidth )
+          // do row based copy of tile into volume
+          unsigned char * pb = tilebuf
+            + ( ya - y0 ) * tilerowbytes + ( xa - x0 ) * bytespersample;
+          unsigned char * pv = pslice
+            + ( ya - start[ 1 ] ) * rowbytes + ( xa - start[ 0 ] ) * bytespersample;
+          const unsigned int tilexbytes = ( xb - xa ) * bytespersample;
+          for( unsigned int r = ya; r < yb; ++r )
           {
-            // read tile
-            if( TIFFReadTile( m_TIFFImage, tilebuf, x0, 0, z0, 0 ) < 0 )
-            {
-              _TIFFfree( tilebuf );
-              itkExceptionMacro( << "mevisIO:read(): error reading tile (top image)" );
-              return;
-            }
-            else
-            {
-              unsigned char *    pb = tilebuf;
-              unsigned char *    pv = vol;
-              const unsigned int p  = z0 * m_Length * m_Width + x0;
-              pv += p * bytespersample;
-
-              for( unsigned int r = 0; r < leny; ++r )
-              {
-                memcpy( pv, pb, tilerowbytes );
-                pv += m_Width * bytespersample;
-                pb += tilerowbytes;
-              }
-            }
-          }
-          // fill strip right
-          if( !mx )
-          {
-            const unsigned     lenx       = m_Width % m_TileWidth;
-            const unsigned int x0         = m_Width - lenx;
-            const unsigned int tilexbytes = lenx * bytespersample;
-
-            if( TIFFReadTile( m_TIFFImage, tilebuf, x0, 0, z0, 0 ) < 0 )
-            {
-              _TIFFfree( tilebuf );
-              itkExceptionMacro( << "mevisIO:read(): error reading tile (strip right)" );
-              return;
-            }
-            else
-            {
-              unsigned char *    pb = tilebuf;
-              unsigned char *    pv = vol;
-              const unsigned int p  = z0 * m_Length * m_Width + x0;
-              pv += p * bytespersample;
-
-              for( unsigned int r = 0; r < leny; ++r )
-              {
-                memcpy( pv, pb, tilexbytes );
-                pv += m_Width * bytespersample;
-                pb += tilerowbytes;
-              }
-            }
+            memcpy( pv, pb, tilexbytes );
+            pv += rowbytes;
+            pb += tilerowbytes;
           }
         }
+      }
+    }
+  }
 
-      } // end case three
+  _TIFFfree( tilebuf );
+  return;
+}
 
-    } // end oversized tile
 
-    //
-    // normal case, tile is smaller than image
-    //
-    if( !tileoversized )
+// getregiontoreadorwrite
+void
+MevisDicomTiffImageIO::GetRegionToReadOrWrite(
+  unsigned int start[ 4 ], unsigned int size[ 4 ] ) const
+{
+  // the io region, padded to 4d; an io region that does not fit
+  // the image (for example when it was never set) means the
+  // whole image
+  const ImageIORegion & region = this->GetIORegion();
+  const bool            useregion
+    = region.GetImageDimension() == m_NumberOfDimensions
+    && region.GetNumberOfPixels() > 0;
+
+  for( unsigned int i = 0; i < 4; ++i )
+  {
+    start[ i ] = 0;
+    size[ i ]  = 1;
+    if( i < m_NumberOfDimensions )
     {
-      // is volume direction a multiple of tiledirection?
-      const bool mx = ( m_Width % m_TileWidth == 0 ) ? true : false;
-      const bool my = ( m_Length % m_TileLength == 0 ) ? true : false;
-
-      // fill everything inside ie from topleft
-      for( unsigned int z0 = 0; z0 < ( m_TIFFDimension == 3 ? m_Depth : 1 ); z0++ )
+      size[ i ] = static_cast< unsigned int >( m_Dimensions[ i ] );
+      if( useregion )
       {
-        for( unsigned int y0 = 0; y0 < ( my ? m_Length : m_Length - m_TileLength ); y0 += m_TileLength )
-        {
-          for( unsigned int x0 = 0; x0 < ( mx ? m_Width : m_Width - m_TileWidth ); x0 += m_TileWidth )
-          {
-            // x0,y0,z0 is position of tile in volume, top left corner
-            // pointer to volume (at 0,0,0)
-            unsigned char * pv = vol;
-
-            // set pointer of volume to y0,x0,z0 position
-            const unsigned int p = z0 * m_Length * m_Width + y0 * m_Width + x0;
-            pv += p * bytespersample;
-
-            // read tile
-            if( TIFFReadTile( m_TIFFImage, tilebuf, x0, y0, z0, 0 ) < 0 )
-            {
-              _TIFFfree( tilebuf );
-              itkExceptionMacro( << "mevisIO:read(): error reading tile (topleft image)" );
-              return;
-            }
-            else
-            {
-              // do row based copy of tile into volume
-              unsigned char * pb = tilebuf;
-              for( unsigned int r = 0; r < m_TileLength; ++r )
-              {
-                memcpy( pv, pb, tilerowbytes );
-                // move pointers
-                // x remain same, y is one complete vol line
-                // (ie width of image)
-                pv += m_Width * bytespersample;
-                pb += tilerowbytes;
-              }
-            }
-
-          }
-        }
-        // fill boundaries
-        if( !mx )
-        {
-          // x is fixed
-          const unsigned     lenx       = m_Width % m_TileWidth;
-          const unsigned int x0         = m_Width - lenx;
-          const unsigned int tilexbytes = lenx * bytespersample;
-
-          for( unsigned int y0 = 0; y0 < ( my ? m_Length : m_Length - m_TileLength ); y0 += m_TileLength )
-          {
-            unsigned char *    pv = vol;
-            const unsigned int p  = z0 * m_Length * m_Width + y0 * m_Width + x0;
-            pv += p * bytespersample;
-
-            if( TIFFReadTile( m_TIFFImage, tilebuf, x0, y0, z0, 0 ) < 0 )
-            {
-              _TIFFfree( tilebuf );
-              itkExceptionMacro( << "mevisIO:read(): error reading tile (ydirection)" );
-              return;
-            }
-            else
-            {
-              unsigned char * pb = tilebuf;
-              for( unsigned int r = 0; r < m_TileLength; ++r )
-              {
-                memcpy( pv, pb, tilexbytes );
-                pv += m_Width * bytespersample;
-                pb += tilerowbytes;
-              }
-            }
-          }
-        }
-        if( !my )
-        {
-          // y is fixed
-          const unsigned     leny = m_Length % m_TileLength;
-          const unsigned int y0   = m_Length - leny;
-
-          for( unsigned int x0 = 0; x0 < ( mx ? m_Width : m_Width - m_TileWidth ); x0 += m_TileWidth )
-          {
-            unsigned char *    pv = vol;
-            const unsigned int p  = z0 * m_Length * m_Width + y0 * m_Width + x0;
-            pv += p * bytespersample;
-
-            if( TIFFReadTile( m_TIFFImage, tilebuf, x0, y0, z0, 0 ) < 0 )
-            {
-              _TIFFfree( tilebuf );
-              itkExceptionMacro( << "mevisIO:read(): error reading tile (x-direction)" );
-              return;
-            }
-            else
-            {
-              unsigned char * pb = tilebuf;
-              for( unsigned int r = 0; r < leny; ++r )
-              {
-                memcpy( pv, pb, tilerowbytes );
-                pv += m_Width * bytespersample;
-                pb += tilerowbytes;
-              }
-            }
-          }
-        }
-        // fill corner bottom
-        if( !mx && !my )
-        {
-          // x0,y0 is fixed
-          const unsigned     lenx       = m_Width % m_TileWidth;
-          const unsigned int x0         = m_Width - lenx;
-          const unsigned int tilexbytes = lenx * bytespersample;
-          const unsigned     leny       = m_Length % m_TileLength;
-          const unsigned int y0         = m_Length - leny;
-
-          unsigned char *    pv = vol;
-          const unsigned int p  = z0 * m_Length * m_Width + y0 * m_Width + x0;
-          pv += p * bytespersample;
-
-          if( TIFFReadTile( m_TIFFImage, tilebuf, x0, y0, z0, 0 ) < 0 )
-          {
-            _TIFFfree( tilebuf );
-            itkExceptionMacro( << "mevisIO:read(): error reading tile (corner bottom)" );
-            return;
-          }
-          else
-          {
-            unsigned char * pb = tilebuf;
-            for( unsigned int r = 0; r < leny; ++r )
-            {
-              memcpy( pv, pb, tilexbytes );
-              pv += m_Width * bytespersample;
-              pb += tilerowbytes;
-            }
-          }
-        }
+        start[ i ] = static_cast< unsigned int >( region.GetIndex( i ) );
+        size[ i ]  = static_cast< unsigned int >( region.GetSize( i ) );
       }
     }
-
-    _TIFFfree( tilebuf );
   }
-  else
-  {
-    // if not tiled then img is stripped
-    itkExceptionMacro( << "mevisIO:read(): non-tiled dcm/tiff reading not (yet) implemented" );
-    return;
-  }
-  return;
 }
 
 
@@ -1281,6 +1051,25 @@ MevisDicomTiffImageIO
     itkExceptionMacro( << "mevisIO:write(): dcm/tiff writer only supports 2D/3D/4D" );
   }
 
+  // streamed writing: only the first piece, which starts at the
+  // origin of the image, writes the headers. the next pieces only
+  // add their rows to the tiff file
+  unsigned int start[ 4 ];
+  unsigned int size[ 4 ];
+  this->GetRegionToReadOrWrite( start, size );
+  if( start[ 0 ] != 0 || start[ 1 ] != 0 || start[ 2 ] != 0 || start[ 3 ] != 0 )
+  {
+    this->WriteTileRows( buffer );
+    return;
+  }
+
+  // a previous (streamed) write that was not completed
+  if( m_IsWritingTiles )
+  {
+    TIFFClose( m_TIFFImage );
+    m_IsWritingTiles = false;
+  }
+
   std::ofstream dcmfile( m_DcmFileName.c_str(), std::ios::out | std::ios::binary );
   if( !dcmfile.is_open() )
   {
@@ -1709,6 +1498,13 @@ MevisDicomTiffImageIO
   // default   minisblack
   // default   tiled
 
+  // the tiff may still be open for reading
+  if( m_IsOpen )
+  {
+    TIFFClose( m_TIFFImage );
+    m_IsOpen = false;
+  }
+
   m_TIFFImage = TIFFOpen( m_TiffFileName.c_str(), "w" );
   if( !m_TIFFImage )
   {
@@ -1970,12 +1766,11 @@ MevisDicomTiffImageIO
     itkExceptionMacro( << "mevisIO:write(): error setting TILELENGTH, m_TileLength" );
   }
 
-  // now filling the image with buffer provided
-  // the provided buffer is one dimensional array,
-  // we apply the same routines as for reading the image
-  // except, no boundary checking is required for writing
-  // the tiles. Boundary checking on the input pointer to
-  // prevent assessing memblocks outside the array
+  // now filling the image with buffer provided. the tiles are
+  // filled per band of m_TileLength rows, which is written as
+  // soon as it is complete, so that the image can be written
+  // in pieces of complete rows. the band holds all tiles of the
+  // band one after the other.
 
   if( smallimg )
   {
@@ -1988,149 +1783,114 @@ MevisDicomTiffImageIO
     itkExceptionMacro( << "mevisIO:write(): image x,y smaller than tilesize (16)! Consider different layout for tif (eg scanline layout)" );
     return;
   }
-  else
+
+  const unsigned int tilesx = ( m_Width + m_TileWidth - 1 ) / m_TileWidth;
+  m_TileBand.resize( tilesx * TIFFTileSize( m_TIFFImage ) );
+  m_NextSlice      = 0;
+  m_NextRow        = 0;
+  m_IsWritingTiles = true;
+
+  this->WriteTileRows( buffer );
+
+  return;
+}
+
+
+// writetilerows
+void
+MevisDicomTiffImageIO::WriteTileRows( const void * buffer )
+{
+  if( !m_IsWritingTiles )
+  {
+    itkExceptionMacro( << "mevisIO:write(): writing a region requires a streamed write that starts at the origin" );
+  }
+
+  unsigned int start[ 4 ];
+  unsigned int size[ 4 ];
+  this->GetRegionToReadOrWrite( start, size );
+
+  // the pieces should consist of complete rows
+  if( start[ 0 ] != 0 || size[ 0 ] != m_Width )
   {
-    const unsigned int tilesize       = TIFFTileSize( m_TIFFImage );
-    const unsigned int tilerowbytes   = TIFFTileRowSize( m_TIFFImage );
-    const unsigned int bytespersample = m_BitsPerSample / 8;
+    TIFFClose( m_TIFFImage );
+    m_IsWritingTiles = false;
+    itkExceptionMacro( << "mevisIO:write(): a streamed piece should contain complete rows" );
+  }
 
-    const unsigned char * vol     = reinterpret_cast< const unsigned char * >( buffer );
-    unsigned char *       tilebuf = static_cast< unsigned char * >( _TIFFmalloc( tilesize ) );
+  const unsigned int tilesize       = TIFFTileSize( m_TIFFImage );
+  const unsigned int tilerowbytes   = TIFFTileRowSize( m_TIFFImage );
+  const unsigned int bytespersample = m_BitsPerSample / 8;
+  const unsigned int rowbytes       = m_Width * bytespersample;
+  const unsigned int depth          = m_NumberOfDimensions > 2 ? m_Dimensions[ 2 ] : 1;
+  const unsigned int slices         = m_TIFFDimension == 3 ? m_Depth : 1;
 
-    // is volume direction a multiple of tiledirection?
-    const bool mx = ( m_Width % m_TileWidth == 0 ) ? true : false;
-    const bool my = ( m_Length % m_TileLength == 0 ) ? true : false;
+  const unsigned char * pv = reinterpret_cast< const unsigned char * >( buffer );
 
-    for( unsigned int z0 = 0; z0 < ( m_TIFFDimension == 3 ? m_Depth : 1 ); z0++ )
+  for( unsigned int t = start[ 3 ]; t < start[ 3 ] + size[ 3 ]; ++t )
+  {
+    for( unsigned int z = start[ 2 ]; z < start[ 2 ] + size[ 2 ]; ++z )
     {
-      for( unsigned int y0 = 0; y0 < ( my ? m_Length : m_Length - m_TileLength ); y0 += m_TileLength )
+      for( unsigned int y = start[ 1 ]; y < start[ 1 ] + size[ 1 ]; ++y, pv += rowbytes )
       {
-        for( unsigned int x0 = 0; x0 < ( mx ? m_Width : m_Width - m_TileWidth ); x0 += m_TileWidth )
+        // the rows should come in order
+        const unsigned int slice = t * depth + z;
+        if( slice != m_NextSlice || y != m_NextRow )
         {
-          // set bufferpointer to begin of tile
-          const unsigned char * pv = vol;
-          const unsigned int    p  = z0 * m_Length * m_Width + y0 * m_Width + x0;
-          pv += p * bytespersample;
-
-          // fill tile
-          unsigned char * pb = tilebuf;
-          for( unsigned int r = 0; r < m_TileLength; ++r )
-          {
-            memcpy( pb, pv, tilerowbytes );
-            pv += m_Width * bytespersample;
-            pb += tilerowbytes;
-          }
-          // write tile
-          if( TIFFWriteTile( m_TIFFImage, tilebuf, x0, y0, z0, 0 ) < 0 )
-          {
-
-            _TIFFfree( tilebuf );
-            TIFFClose( m_TIFFImage );
-            itkExceptionMacro( << "mevisIO:write(): error writing tile." );
-            return;
-          }
+          TIFFClose( m_TIFFImage );
+          m_IsWritingTiles = false;
+          itkExceptionMacro( << "mevisIO:write(): streamed pieces should be written in order" );
         }
-      }
-      // boundaries
-      if( !mx )
-      {
-        // x is fixed
-        const unsigned     lenx       = m_Width % m_TileWidth;
-        const unsigned int x0         = m_Width - lenx;
-        const unsigned int tilexbytes = lenx * bytespersample;
 
-        for( unsigned int y0 = 0; y0 < ( my ? m_Length : m_Length - m_TileLength ); y0 += m_TileLength )
+        // copy the row into the tiles of the band, the tiles at
+        // the boundaries are padded with zeros
+        const unsigned int r = y % m_TileLength;
+        if( r == 0 )
         {
-          const unsigned char * pv = vol;
-          const unsigned int    p  = z0 * m_Length * m_Width + y0 * m_Width + x0;
-          pv += p * bytespersample;
-
-          unsigned char * pb = tilebuf;
-          memset( pb, 0, tilesize );
-
-          // fill tile
-          for( unsigned int r = 0; r < m_TileLength; ++r )
-          {
-            memcpy( pb, pv, tilexbytes );
-            pv += m_Width * bytespersample;
-            pb += tilerowbytes;
-          }
-
-          if( TIFFWriteTile( m_TIFFImage, tilebuf, x0, y0, z0, 0 ) < 0 )
-          {
-            _TIFFfree( tilebuf );
-            TIFFClose( m_TIFFImage );
-            itkExceptionMacro( << "mevisIO:write(): error writing tile (ydirection)" );
-            return;
-          }
+          memset( &m_TileBand[ 0 ], 0, m_TileBand.size() );
         }
-      }
-      if( !my )
-      {
-        const unsigned     leny = m_Length % m_TileLength;
-        const unsigned int y0   = m_Length - leny;
-
-        for( unsigned int x0 = 0; x0 < ( mx ? m_Width : m_Width - m_TileWidth ); x0 += m_TileWidth )
+        unsigned char * pb = &m_TileBand[ 0 ] + r * tilerowbytes;
+        for( unsigned int x0 = 0; x0 < m_Width; x0 += m_TileWidth, pb += tilesize )
         {
-          const unsigned char * pv = vol;
-          const unsigned int    p  = z0 * m_Length * m_Width + y0 * m_Width + x0;
-          pv += p * bytespersample;
-
-          unsigned char * pb = tilebuf;
-          memset( pb, 0, tilesize );
-
-          for( unsigned int r = 0; r < leny; ++r )
-          {
-            memcpy( pb, pv, tilerowbytes );
-            pv += m_Width * bytespersample;
-            pb += tilerowbytes;
-          }
-
-          if( TIFFWriteTile( m_TIFFImage, tilebuf, x0, y0, z0, 0 ) < 0 )
-          {
-            _TIFFfree( tilebuf );
-            TIFFClose( m_TIFFImage );
-            itkExceptionMacro( << "mevisIO:write(): error writing tile (x-direction)" );
-            return;
-          }
+          const unsigned int lenx = std::min( m_TileWidth, m_Width - x0 );
+          memcpy( pb, pv + x0 * bytespersample, lenx * bytespersample );
         }
-      }
-      if( !mx && !my )
-      {
-        // x0,y0 is fixed
-        const unsigned     lenx       = m_Width % m_TileWidth;
-        const unsigned int x0         = m_Width - lenx;
-        const unsigned int tilexbytes = lenx * bytespersample;
-        const unsigned     leny       = m_Length % m_TileLength;
-        const unsigned int y0         = m_Length - leny;
 
-        const unsigned char * pv = vol;
-        const unsigned int    p  = z0 * m_Length * m_Width + y0 * m_Width + x0;
-        pv += p * bytespersample;
-
-        unsigned char * pb = tilebuf;
-        memset( pb, 0, tilesize );
-
-        for( unsigned int r = 0; r < leny; ++r )
+        // write the band when it is complete
+        if( r == m_TileLength - 1 || y == m_Length - 1 )
         {
-          memcpy( pb, pv, tilexbytes );
-          pv += m_Width * bytespersample;
-          pb += tilerowbytes;
+          const unsigned int z0 = m_TIFFDimension == 3 ? slice : 0;
+          const unsigned int y0 = y - r;
+          pb = &m_TileBand[ 0 ];
+          for( unsigned int x0 = 0; x0 < m_Width; x0 += m_TileWidth, pb += tilesize )
+          {
+            if( TIFFWriteTile( m_TIFFImage, pb, x0, y0, z0, 0 ) < 0 )
+            {
+              TIFFClose( m_TIFFImage );
+              m_IsWritingTiles = false;
+              itkExceptionMacro( << "mevisIO:write(): error writing tile at "
+                                 << x0 << ", " << y0 << ", " << z0 );
+              return;
+            }
+          }
         }
 
-        if( TIFFWriteTile( m_TIFFImage, tilebuf, x0, y0, z0, 0 ) < 0 )
+        ++m_NextRow;
+        if( m_NextRow == m_Length )
         {
-          _TIFFfree( tilebuf );
-          TIFFClose( m_TIFFImage );
-          itkExceptionMacro( << "mevisIO:write(): error writing tile (corner bottom)" );
-          return;
+          m_NextRow = 0;
+          ++m_NextSlice;
         }
       }
-    } // end z
-    _TIFFfree( tilebuf );
+    }
   }
 
-  TIFFClose( m_TIFFImage );
+  // the last piece closes the file
+  if( m_NextSlice == slices )
+  {
+    TIFFClose( m_TIFFImage );
+    m_IsWritingTiles = false;
+    std::vector< unsigned char >().swap( m_TileBand );
+  }
 
   return;
 }
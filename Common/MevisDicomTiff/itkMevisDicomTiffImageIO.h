@@ -29,6 +29,7 @@
 
 #include <fstream>
 #include <string>
+#include <vector>
 
 namespace itk
 {
@@ -132,15 +133,22 @@ public:
 
   virtual void Write( const void * buffer );
 
+  /** Reading only decodes the tiles that overlap with the requested
+   * region.
+   */
   virtual bool CanStreamRead()
   {
-    return false;
+    return true;
   }
 
 
+  /** Streamed writing requires pieces of complete rows, that are written
+   * in order, starting at the origin of the image. This is how the
+   * ImageFileWriter splits the image.
+   */
   virtual bool CanStreamWrite()
   {
-    return false;
+    return true;
   }
 
 
@@ -158,6 +166,12 @@ private:
   bool FindElement( const gdcm::DataSet ds, const gdcm::Tag tag, gdcm::DataElement & de,
     const bool breadthfirstsearch );
 
+  // the io region padded to 4d, or the whole image if not set
+  void GetRegionToReadOrWrite( unsigned int start[ 4 ], unsigned int size[ 4 ] ) const;
+
+  // add the rows of a (streamed) piece to the tiff
+  void WriteTileRows( const void * buffer );
+
   // the following may include the pathname
   std::string m_DcmFileName;
   std::string m_TiffFileName;
@@ -176,6 +190,12 @@ private:
   unsigned int   m_TileDepth;
   unsigned short m_NumberOfTiles;
 
+  // state of a streamed write, the band holds one row of tiles
+  bool                         m_IsWritingTiles;
+  unsigned int                 m_NextSlice;
+  unsigned int                 m_NextRow;
+  std::vector< unsigned char > m_TileBand;
+
   double m_RescaleSlope;
   double m_RescaleIntercept;
   double m_GantryTilt;
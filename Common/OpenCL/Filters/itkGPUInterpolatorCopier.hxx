@@ -23,7 +23,7 @@
 // ITK CPU interpolators
 #include "itkNearestNeighborInterpolateImageFunction.h"
 #include "itkLinearInterpolateImageFunction.h"
-#include "itkBSplineInterpolateImageFunction.h"
+#include "itkMultiThreadedBSplineInterpolateImageFunction.h"
 
 // ITK GPU interpolators
 #include "itkGPUNearestNeighborInterpolateImageFunction.h"
@@ -154,7 +154,7 @@ GPUInterpolatorCopier< TTypeList, NDimensions, TInterpolator, TOutputCoordRep >
       else
       {
         // Create GPU BSpline interpolator in implicit mode
-        typedef BSplineInterpolateImageFunction<
+        typedef MultiThreadedBSplineInterpolateImageFunction<
           CPUInputImageType, GPUCoordRepType, GPUCoordRepType > GPUBSplineInterpolatorType;
         typename GPUBSplineInterpolatorType::Pointer bsplineInterpolator
           = GPUBSplineInterpolatorType::New();
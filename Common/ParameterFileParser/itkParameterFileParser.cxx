@@ -22,7 +22,8 @@
 #include "itkParameterFileParser.h"
 
 #include <itksys/SystemTools.hxx>
-#include <itksys/RegularExpression.hxx>
+
+#include <algorithm>
 
 namespace itk
 {
@@ -47,11 +48,7 @@ ParameterFileParser
 ParameterFileParser
 ::~ParameterFileParser()
 {
-  if( this->m_ParameterFile.is_open() )
-  {
-    this->m_ParameterFile.close();
-  }
-
+  // empty
 } // end Destructor()
 
 
@@ -76,35 +73,35 @@ void
 ParameterFileParser
 ::ReadParameterFile( void )
 {
-  /** Perform some basic checks. */
-  this->BasicFileChecking();
-
-  /** Open the parameter file for reading. */
-  if( this->m_ParameterFile.is_open() )
-  {
-    this->m_ParameterFile.clear();
-    this->m_ParameterFile.close();
-  }
-  this->m_ParameterFile.open( this->m_ParameterFileName.c_str(), std::fstream::in );
-
-  /** Check if it opened. */
-  if( !this->m_ParameterFile.is_open() )
-  {
-    itkExceptionMacro( << "ERROR: could not open "
-                       << this->m_ParameterFileName
-                       << " for reading." );
-  }
+  /** Read the complete parameter file in memory. */
+  std::string fileContent;
+  this->ReadFileContent( fileContent );
 
   /** Clear the map. */
   this->m_ParameterMap.clear();
 
-  /** Loop over the parameter file, line by line. */
-  std::string lineIn  = "";
-  std::string lineOut = "";
-  while( this->m_ParameterFile.good() )
+  /** Loop over the file content, line by line. Every character is visited
+   * a constant number of times, so that the parse time is linear in the
+   * file size, also for lines with millions of values.
+   */
+  std::string            lineIn  = "";
+  std::string            lineOut = "";
+  std::string::size_type lineStart = 0;
+  while( lineStart < fileContent.size() )
   {
-    /** Extract a line. */
-    itksys::SystemTools::GetLineFromStream( this->m_ParameterFile, lineIn );
+    /** Extract a line, without the end-of-line characters. */
+    std::string::size_type lineEnd = fileContent.find( '\n', lineStart );
+    if( lineEnd == std::string::npos )
+    {
+      lineEnd = fileContent.size();
+    }
+    std::string::size_type lineLength = lineEnd - lineStart;
+    if( lineLength > 0 && fileContent[ lineEnd - 1 ] == '\r' )
+    {
+      --lineLength;
+    }
+    lineIn.assign( fileContent, lineStart, lineLength );
+    lineStart = lineEnd + 1;
 
     /** Check this line. */
     bool validLine = this->CheckLine( lineIn, lineOut );
@@ -118,10 +115,6 @@ ParameterFileParser
 
   }
 
-  /** Close the parameter file. */
-  this->m_ParameterFile.clear();
-  this->m_ParameterFile.close();
-
 } // end ReadParameterFile()
 
 
@@ -172,6 +165,51 @@ ParameterFileParser
 } // end BasicFileChecking()
 
 
+/**
+ * **************** ReadFileContent ***************
+ */
+
+void
+ParameterFileParser
+::ReadFileContent( std::string & fileContent ) const
+{
+  /** Perform some basic checks. */
+  this->BasicFileChecking();
+
+  /** Open the parameter file for reading. */
+  std::ifstream parameterFile( this->m_ParameterFileName.c_str(),
+    std::ios::in | std::ios::binary );
+
+  /** Check if it opened. */
+  if( !parameterFile.is_open() )
+  {
+    itkExceptionMacro( << "ERROR: could not open "
+                       << this->m_ParameterFileName
+                       << " for reading." );
+  }
+
+  /** Read the file in one go. */
+  parameterFile.seekg( 0, std::ios::end );
+  const std::streamoff fileSize = parameterFile.tellg();
+  parameterFile.seekg( 0, std::ios::beg );
+
+  fileContent.clear();
+  if( fileSize > 0 )
+  {
+    fileContent.resize( static_cast< std::string::size_type >( fileSize ) );
+    parameterFile.read( &fileContent[ 0 ], fileSize );
+  }
+
+  if( fileSize < 0 || parameterFile.fail() )
+  {
+    itkExceptionMacro( << "ERROR: could not read "
+                       << this->m_ParameterFileName
+                       << "." );
+  }
+
+} // end ReadFileContent()
+
+
 /**
  * **************** CheckLine ***************
  */
@@ -187,65 +225,49 @@ ParameterFileParser
    * 4) Remove trailing spaces
    */
   lineOut = lineIn;
-  itksys::SystemTools::ReplaceString( lineOut, "\t", " " );
-
-  itksys::RegularExpression commentPart( "//" );
-  if( commentPart.find( lineOut ) )
-  {
-    lineOut = lineOut.substr( 0, commentPart.start() );
-  }
-
-  itksys::RegularExpression leadingSpaces( "^[ ]*(.*)" );
-  leadingSpaces.find( lineOut );
-  lineOut = leadingSpaces.match( 1 );
+  std::replace( lineOut.begin(), lineOut.end(), '\t', ' ' );
 
-  itksys::RegularExpression trailingSpaces( "[ \t]+$" );
-  if( trailingSpaces.find( lineOut ) )
+  const std::string::size_type commentStart = lineOut.find( "//" );
+  if( commentStart != std::string::npos )
   {
-    lineOut = lineOut.substr( 0, trailingSpaces.start() );
+    lineOut.erase( commentStart );
   }
 
   /**
    * Checks:
-   * 1. Empty line -> false
-   * 2. Comment (line starts with "//") -> false
-   * 3. Line is not between brackets (...) -> exception
-   * 4. Line contains less than two words -> exception
+   * 1. Empty line or comment -> false
+   * 2. Line is not between brackets (...) -> exception
+   * 3. Line contains less than two words -> exception
    *
    * Otherwise return true.
    */
 
-  /** 1. Check for non-empty lines. */
-  itksys::RegularExpression reNonEmptyLine( "[^ ]+" );
-  bool                      match1 = reNonEmptyLine.find( lineOut );
-  if( !match1 )
+  /** 1. Check for non-empty lines. Comments have been removed already. */
+  const std::string::size_type first = lineOut.find_first_not_of( ' ' );
+  if( first == std::string::npos )
   {
     return false;
   }
+  const std::string::size_type last = lineOut.find_last_not_of( ' ' );
+  lineOut.erase( last + 1 );
+  lineOut.erase( 0, first );
 
-  /** 2. Check for comments. */
-  itksys::RegularExpression reComment( "^//" );
-  bool                      match2 = reComment.find( lineOut );
-  if( match2 )
-  {
-    return false;
-  }
-
-  /** 3. Check if line is between brackets. */
-  if( !itksys::SystemTools::StringStartsWith( lineOut.c_str(), "(" )
-    || !itksys::SystemTools::StringEndsWith( lineOut.c_str(), ")" ) )
+  /** 2. Check if line is between brackets. */
+  if( lineOut.size() < 2
+    || lineOut[ 0 ] != '(' || lineOut[ lineOut.size() - 1 ] != ')' )
   {
     std::string hint = "Line is not between brackets: \"(...)\".";
     this->ThrowException( lineIn, hint );
   }
 
   /** Remove brackets. */
-  lineOut = lineOut.substr( 1, lineOut.size() - 2 );
+  lineOut.erase( lineOut.size() - 1 );
+  lineOut.erase( 0, 1 );
 
-  /** 4. Check: the line should contain at least two words. */
-  itksys::RegularExpression reTwoWords( "([ ]+)([^ ]+)" );
-  bool                      match4 = reTwoWords.find( lineOut );
-  if( !match4 )
+  /** 3. Check: the line should contain at least two words. */
+  const std::string::size_type space = lineOut.find( ' ' );
+  if( space == std::string::npos
+    || lineOut.find_first_not_of( ' ', space ) == std::string::npos )
   {
     std::string hint = "Line does not contain a parameter name and value.";
     this->ThrowException( lineIn, hint );
@@ -279,29 +301,13 @@ ParameterFileParser
    * 3) the other strings that are not a series of spaces, are parameter values
    */
 
-  /** 1) Split the line. */
-  std::vector< std::string > splittedLine;
-  this->SplitLine( fullLine, line, splittedLine );
-
-  /** 2) Get the parameter name. */
-  std::string parameterName = splittedLine[ 0 ];
-  itksys::SystemTools::ReplaceString( parameterName, " ", "" );
-  splittedLine.erase( splittedLine.begin() );
-
-  /** 3) Get the parameter values. */
-  std::vector< std::string > parameterValues;
-  for( unsigned int i = 0; i < splittedLine.size(); ++i )
-  {
-    if( splittedLine[ i ] != "" )
-    {
-      parameterValues.push_back( splittedLine[ i ] );
-    }
-  }
+  /** 1-3) Split the line in the parameter name and values. */
+  std::string         parameterName = "";
+  ParameterValuesType parameterValues;
+  this->SplitLine( fullLine, line, parameterName, parameterValues );
 
   /** 4) Perform some checks on the parameter name. */
-  itksys::RegularExpression reInvalidCharacters1( "[.,:;!@#$%^&-+|<>?]" );
-  bool                      match = reInvalidCharacters1.find( parameterName );
-  if( match )
+  if( parameterName.find_first_of( ".,:;!@#$%^&'()*+|<>?" ) != std::string::npos )
   {
     std::string hint = "The parameter \""
       + parameterName
@@ -310,11 +316,10 @@ ParameterFileParser
   }
 
   /** 5) Perform checks on the parameter values. */
-  itksys::RegularExpression reInvalidCharacters2( "[,;!@#$%&|<>?]" );
-  for( unsigned int i = 0; i < parameterValues.size(); ++i )
+  for( std::size_t i = 0; i < parameterValues.size(); ++i )
   {
     /** For all entries some characters are not allowed. */
-    if( reInvalidCharacters2.find( parameterValues[ i ] ) )
+    if( parameterValues[ i ].find_first_of( ",;!@#$%&|<>?" ) != std::string::npos )
     {
       std::string hint = "The parameter value \""
         + parameterValues[ i ]
@@ -323,18 +328,19 @@ ParameterFileParser
     }
   }
 
-  /** 6) Insert this combination in the parameter map. */
-  if( this->m_ParameterMap.count( parameterName ) )
+  /** 6) Insert this combination in the parameter map, without copying
+   * the values.
+   */
+  std::pair< ParameterMapType::iterator, bool > inserted
+    = this->m_ParameterMap.insert( std::make_pair( parameterName, ParameterValuesType() ) );
+  if( !inserted.second )
   {
     std::string hint = "The parameter \""
       + parameterName
       + "\" is specified more than once.";
     this->ThrowException( fullLine, hint );
   }
-  else
-  {
-    this->m_ParameterMap.insert( make_pair( parameterName, parameterValues ) );
-  }
+  inserted.first->second.swap( parameterValues );
 
 } // end GetParameterFromLine()
 
@@ -346,16 +352,16 @@ ParameterFileParser
 void
 ParameterFileParser
 ::SplitLine( const std::string & fullLine, const std::string & line,
-  std::vector< std::string > & splittedLine ) const
+  std::string & parameterName, ParameterValuesType & parameterValues ) const
 {
-  splittedLine.clear();
-  splittedLine.resize( 1 );
+  parameterName = "";
+  parameterValues.clear();
 
   /** Count the number of quotes in the line. If it is an odd value, the
    * line contains an error; strings should start and end with a quote, so
    * the total number of quotes is even.
    */
-  std::size_t numQuotes = itksys::SystemTools::CountChar( line.c_str(), '"' );
+  const std::size_t numQuotes = std::count( line.begin(), line.end(), '"' );
   if( numQuotes % 2 == 1 )
   {
     /** An invalid parameter line. */
@@ -363,38 +369,36 @@ ParameterFileParser
     this->ThrowException( fullLine, hint );
   }
 
-  /** Loop over the line. */
-  std::string::const_iterator it;
-  unsigned int                index = 0;
-  numQuotes = 0;
-  for( it = line.begin(); it < line.end(); ++it )
+  /** Loop over the line. An element ends at a quote, or at a space that is
+   * not quoted. The first element is the parameter name, the other
+   * non-empty elements are the values.
+   */
+  bool                   quoted       = false;
+  bool                   nameFound    = false;
+  std::string::size_type elementStart = 0;
+  for( std::string::size_type i = 0; i <= line.size(); ++i )
   {
-    if( *it == '"' )
+    const bool endOfLine = i == line.size();
+    if( !endOfLine && line[ i ] != '"' && ( line[ i ] != ' ' || quoted ) )
     {
-      /** Start a new element. */
-      splittedLine.push_back( "" );
-      index++;
-      numQuotes++;
+      continue;
     }
-    else if( *it == ' ' )
+
+    /** Store the element that ends here. */
+    if( !nameFound )
+    {
+      parameterName.assign( line, elementStart, i - elementStart );
+      nameFound = true;
+    }
+    else if( i > elementStart )
     {
-      /** Only start a new element if it is not a quote, otherwise just add
-       * the space to the string.
-       */
-      if( numQuotes % 2 == 0 )
-      {
-        splittedLine.push_back( "" );
-        index++;
-      }
-      else
-      {
-        splittedLine[ index ].push_back( *it );
-      }
+      parameterValues.push_back( line.substr( elementStart, i - elementStart ) );
     }
-    else
+    elementStart = i + 1;
+
+    if( !endOfLine && line[ i ] == '"' )
     {
-      /** Add this character to the element. */
-      splittedLine[ index ].push_back( *it );
+      quoted = !quoted;
     }
   }
 
@@ -431,40 +435,31 @@ std::string
 ParameterFileParser
 ::ReturnParameterFileAsString( void )
 {
-  /** Perform some basic checks. */
-  this->BasicFileChecking();
+  /** Read the complete parameter file in memory. */
+  std::string fileContent;
+  this->ReadFileContent( fileContent );
 
-  /** Open the parameter file for reading. */
-  if( this->m_ParameterFile.is_open() )
-  {
-    this->m_ParameterFile.clear();
-    this->m_ParameterFile.close();
-  }
-  this->m_ParameterFile.open( this->m_ParameterFileName.c_str(), std::fstream::in );
-
-  /** Check if it opened. */
-  if( !this->m_ParameterFile.is_open() )
-  {
-    itkExceptionMacro( << "ERROR: could not open "
-                       << this->m_ParameterFileName
-                       << " for reading." );
-  }
-
-  /** Loop over the parameter file, line by line. */
-  std::string line = "";
+  /** Copy it line by line, to normalize the end-of-line characters. */
   std::string output;
-  while( this->m_ParameterFile.good() )
+  output.reserve( fileContent.size() + 1 );
+  std::string::size_type lineStart = 0;
+  while( lineStart < fileContent.size() )
   {
-    /** Extract a line. */
-    itksys::SystemTools::GetLineFromStream( this->m_ParameterFile, line ); // \todo: returns bool
-
-    output += line + "\n";
+    std::string::size_type lineEnd = fileContent.find( '\n', lineStart );
+    if( lineEnd == std::string::npos )
+    {
+      lineEnd = fileContent.size();
+    }
+    std::string::size_type lineLength = lineEnd - lineStart;
+    if( lineLength > 0 && fileContent[ lineEnd - 1 ] == '\r' )
+    {
+      --lineLength;
+    }
+    output.append( fileContent, lineStart, lineLength );
+    output += "\n";
+    lineStart = lineEnd + 1;
   }
 
-  /** Close the parameter file. */
-  this->m_ParameterFile.clear();
-  this->m_ParameterFile.close();
-
   /** Return the string. */
   return output;
 
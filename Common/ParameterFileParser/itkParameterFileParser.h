@@ -48,6 +48,10 @@ namespace itk
  * (ParameterName2 3 5.8)\n
  * (ParameterName3 "true" "false" "true")\n
  *
+ * The complete file is read in memory and parsed in a single pass, in time
+ * linear in the file size, so that also huge parameter lines, such as the
+ * TransformParameters of a dense B-spline grid, are read quickly.
+ *
  * The parameter file is read, and parameter name-value combinations are
  * stored in an std::map< std::string, std::vector<std:string> >, where the
  * string is the parameter name, and the vector of strings are the values.
@@ -131,6 +135,9 @@ private:
    */
   void BasicFileChecking( void ) const;
 
+  /** Checks the file and reads its complete content in memory. */
+  void ReadFileContent( std::string & fileContent ) const;
+
   /** Checks a line.
    * - Returns  true if it is a valid line: containing a parameter.
    * - Returns false if it is a valid line: empty or comment.
@@ -144,7 +151,7 @@ private:
 
   /** Splits a line in parameter name and values. */
   void SplitLine( const std::string & fullLine, const std::string & line,
-    std::vector< std::string > & splittedLine ) const;
+    std::string & parameterName, ParameterValuesType & parameterValues ) const;
 
   /** Uniform way to throw exceptions when the parameter file appears to be
    * invalid.
@@ -153,7 +160,6 @@ private:
 
   /** Member variables. */
   std::string      m_ParameterFileName;
-  std::ifstream    m_ParameterFile;
   ParameterMapType m_ParameterMap;
 
 };
@@ -18,6 +18,8 @@
 
 #include "itkParameterMapInterface.h"
 
+#include <cstdlib>
+
 namespace itk
 {
 
@@ -29,6 +31,7 @@ ParameterMapInterface
 ::ParameterMapInterface()
 {
   this->m_ParameterMap.clear();
+  this->m_ParameterStore.clear();
   this->m_PrintErrorMessages = true;
 
 } // end Constructor()
@@ -53,14 +56,106 @@ void
 ParameterMapInterface
 ::SetParameterMap( const ParameterMapType & parMap )
 {
-  if( !parMap.empty() )
+  if( parMap.empty() )
+  {
+    return;
+  }
+
+  this->m_ParameterMap = parMap;
+
+  /** Parse all values once, and store them next to their strings.
+   * Parameters without values are left out, so that they do not exist.
+   */
+  this->m_ParameterStore.clear();
+  ParameterStoreType::iterator hint = this->m_ParameterStore.begin();
+  for( ParameterMapType::const_iterator it = this->m_ParameterMap.begin();
+    it != this->m_ParameterMap.end(); ++it )
   {
-    this->m_ParameterMap = parMap;
+    const ParameterValuesType & values = it->second;
+    if( values.empty() )
+    {
+      continue;
+    }
+
+    /** The map is sorted, so insert at the end. */
+    hint = this->m_ParameterStore.insert( hint,
+      std::make_pair( it->first, ParameterEntryType() ) );
+    ParameterEntryType & entry = hint->second;
+    entry.m_Values = &values;
+    entry.m_Numbers.resize( values.size() );
+    entry.m_NumberKinds.resize( values.size() );
+    for( std::size_t i = 0; i < values.size(); ++i )
+    {
+      entry.m_NumberKinds[ i ] = static_cast< unsigned char >(
+        ParseNumber( values[ i ], entry.m_Numbers[ i ] ) );
+    }
   }
 
 } // end SetParameterMap()
 
 
+/**
+ * **************** FindParameter ***************
+ */
+
+const ParameterMapInterface::ParameterEntryType *
+ParameterMapInterface
+::FindParameter( const std::string & parameterName ) const
+{
+  ParameterStoreType::const_iterator it = this->m_ParameterStore.find( parameterName );
+  if( it == this->m_ParameterStore.end() )
+  {
+    return 0;
+  }
+  return &it->second;
+
+} // end FindParameter()
+
+
+/**
+ * **************** ParseNumber ***************
+ */
+
+ParameterMapInterface::NumberKindType
+ParameterMapInterface
+::ParseNumber( const std::string & parameterValue, double & number )
+{
+  number = 0.0;
+
+  /** Only consider plain decimal numbers, so that words like "inf", "nan"
+   * or hexadecimal numbers are left to the string stream, like before.
+   */
+  if( parameterValue.empty()
+    || parameterValue.find_first_not_of( "0123456789+-.eE" ) != std::string::npos )
+  {
+    return NotANumber;
+  }
+
+  /** The complete string should be a number. This also rejects numbers
+   * in a locale with another decimal separator.
+   */
+  const char * begin = parameterValue.c_str();
+  char *       end   = 0;
+  number = std::strtod( begin, &end );
+  if( end != begin + parameterValue.size() )
+  {
+    number = 0.0;
+    return NotANumber;
+  }
+
+  /** Integers are exact up to 2^53. */
+  const std::string::size_type firstDigit
+    = ( parameterValue[ 0 ] == '+' || parameterValue[ 0 ] == '-' ) ? 1 : 0;
+  if( parameterValue.find_first_not_of( "0123456789", firstDigit ) == std::string::npos
+    && number <= 9007199254740992.0 && number >= -9007199254740992.0 )
+  {
+    return IntegerNumber;
+  }
+  return RealNumber;
+
+} // end ParseNumber()
+
+
 /**
  * **************** CountNumberOfParameterEntries ***************
  */
@@ -70,9 +165,10 @@ ParameterMapInterface
 ::CountNumberOfParameterEntries(
   const std::string & parameterName ) const
 {
-  if( this->m_ParameterMap.count( parameterName ) )
+  const ParameterEntryType * entry = this->FindParameter( parameterName );
+  if( entry )
   {
-    return this->m_ParameterMap.find( parameterName )->second.size();
+    return entry->m_Values->size();
   }
   return 0;
 
@@ -163,21 +259,21 @@ ParameterMapInterface
   /** Reset the error message. */
   errorMessage = "";
 
-  /** Get the number of entries. */
-  std::size_t numberOfEntries = this->CountNumberOfParameterEntries(
-    parameterName );
+  /** Look up the parameter and get the number of entries. */
+  const ParameterEntryType * entry = this->FindParameter( parameterName );
+  const std::size_t numberOfEntries = entry ? entry->m_Values->size() : 0;
 
   /** Check if the requested parameter exists. */
   if( numberOfEntries == 0 )
   {
-    std::stringstream ss;
-    ss << "WARNING: The parameter \"" << parameterName
-       << "\", requested between entry numbers " << entry_nr_start
-       << " and " << entry_nr_end
-       << ", does not exist at all.\n"
-       << "  The default values are used instead." << std::endl;
     if( printThisErrorMessage && this->m_PrintErrorMessages )
     {
+      std::stringstream ss;
+      ss << "WARNING: The parameter \"" << parameterName
+         << "\", requested between entry numbers " << entry_nr_start
+         << " and " << entry_nr_end
+         << ", does not exist at all.\n"
+         << "  The default values are used instead." << std::endl;
       errorMessage = ss.str();
     }
     return false;
@@ -207,7 +303,7 @@ ParameterMapInterface
   }
 
   /** Get the vector of parameters. */
-  const ParameterValuesType & vec = this->m_ParameterMap.find( parameterName )->second;
+  const ParameterValuesType & vec = *entry->m_Values;
 
   /** Copy all parameters at once. */
   std::vector< std::string >::const_iterator it = vec.begin();
@@ -27,6 +27,7 @@
 #include "itkParameterFileParser.h"
 
 #include <iostream>
+#include <limits>
 
 namespace itk
 {
@@ -64,6 +65,12 @@ namespace itk
  *   "ParameterName", index, printWarning, errorMessage );
  *
  *
+ * The parameter values are parsed once, when the parameter map is set:
+ * values that are numbers are stored next to their strings. Reading a
+ * numeric parameter then only takes a single look-up of the parameter name
+ * and a cast, instead of parsing the string again for every call. Values
+ * that are not plain numbers are still cast using a string stream.
+ *
  * Note that some of the templated functions are defined in the header to
  * get it compiling on some platforms.
  *
@@ -129,21 +136,20 @@ public:
     /** Reset the error message. */
     errorMessage = "";
 
-    /** Get the number of entries. */
-    std::size_t numberOfEntries = this->CountNumberOfParameterEntries(
-      parameterName );
+    /** Look up the parameter. */
+    const ParameterEntryType * entry = this->FindParameter( parameterName );
 
     /** Check if the requested parameter exists. */
-    if( numberOfEntries == 0 )
+    if( entry == 0 )
     {
-      std::stringstream ss;
-      ss << "WARNING: The parameter \"" << parameterName
-         << "\", requested at entry number " << entry_nr
-         << ", does not exist at all.\n"
-         << "  The default value \"" << parameterValue
-         << "\" is used instead." << std::endl;
       if( printThisErrorMessage && this->m_PrintErrorMessages )
       {
+        std::stringstream ss;
+        ss << "WARNING: The parameter \"" << parameterName
+           << "\", requested at entry number " << entry_nr
+           << ", does not exist at all.\n"
+           << "  The default value \"" << parameterValue
+           << "\" is used instead." << std::endl;
         errorMessage = ss.str();
       }
 
@@ -151,25 +157,26 @@ public:
     }
 
     /** Get the vector of parameters. */
-    const ParameterValuesType & vec = this->m_ParameterMap.find( parameterName )->second;
+    const ParameterValuesType & vec = *entry->m_Values;
 
     /** Check if it exists at the requested entry number. */
-    if( entry_nr >= numberOfEntries )
+    if( entry_nr >= vec.size() )
     {
-      std::stringstream ss;
-      ss << "WARNING: The parameter \"" << parameterName
-         << "\" does not exist at entry number " << entry_nr
-         << ".\n  The default value \"" << parameterValue
-         << "\" is used instead." << std::endl;
       if( printThisErrorMessage && this->m_PrintErrorMessages )
       {
+        std::stringstream ss;
+        ss << "WARNING: The parameter \"" << parameterName
+           << "\" does not exist at entry number " << entry_nr
+           << ".\n  The default value \"" << parameterValue
+           << "\" is used instead." << std::endl;
         errorMessage = ss.str();
       }
       return false;
     }
 
-    /** Cast the string to type T. */
-    bool castSuccesful = this->StringCast( vec[ entry_nr ], parameterValue );
+    /** Cast the string to type T, preferably using the parsed number. */
+    bool castSuccesful = this->NumberCast( *entry, entry_nr, parameterValue )
+      || this->StringCast( vec[ entry_nr ], parameterValue );
 
     /** Check if the cast was successful. */
     if( !castSuccesful )
@@ -295,21 +302,21 @@ public:
     /** Reset the error message. */
     errorMessage = "";
 
-    /** Get the number of entries. */
-    std::size_t numberOfEntries = this->CountNumberOfParameterEntries(
-      parameterName );
+    /** Look up the parameter and get the number of entries. */
+    const ParameterEntryType * entry = this->FindParameter( parameterName );
+    const std::size_t numberOfEntries = entry ? entry->m_Values->size() : 0;
 
     /** Check if the requested parameter exists. */
     if( numberOfEntries == 0 )
     {
-      std::stringstream ss;
-      ss << "WARNING: The parameter \"" << parameterName
-         << "\", requested between entry numbers " << entry_nr_start
-         << " and " << entry_nr_end
-         << ", does not exist at all.\n"
-         << "  The default values are used instead." << std::endl;
       if( printThisErrorMessage && this->m_PrintErrorMessages )
       {
+        std::stringstream ss;
+        ss << "WARNING: The parameter \"" << parameterName
+           << "\", requested between entry numbers " << entry_nr_start
+           << " and " << entry_nr_end
+           << ", does not exist at all.\n"
+           << "  The default values are used instead." << std::endl;
         errorMessage = ss.str();
       }
       return false;
@@ -340,7 +347,7 @@ public:
     }
 
     /** Get the vector of parameters. */
-    const ParameterValuesType & vec = this->m_ParameterMap.find( parameterName )->second;
+    const ParameterValuesType & vec = *entry->m_Values;
 
     /** The default is filled with zero's.
     parameterValues.clear();
@@ -352,8 +359,9 @@ public:
     unsigned int j = 0;
     for( unsigned int i = entry_nr_start; i < entry_nr_end + 1; ++i )
     {
-      /** Cast the string to type T. */
-      bool castSuccesful = this->StringCast( vec[ i ], parameterValues[ j ] );
+      /** Cast the string to type T, preferably using the parsed number. */
+      bool castSuccesful = this->NumberCast( *entry, i, parameterValues[ j ] )
+        || this->StringCast( vec[ i ], parameterValues[ j ] );
       j++;
 
       /** Check if the cast was successful. */
@@ -394,11 +402,88 @@ private:
   ParameterMapInterface( const Self & ); // purposely not implemented
   void operator=( const Self & );        // purposely not implemented
 
+  /** The kind of number that a parameter value represents. */
+  enum NumberKindType {
+    NotANumber     = 0,
+    IntegerNumber  = 1,
+    RealNumber     = 2
+  };
+
+  /** A parameter as stored in the parameter store: its values as strings,
+   * and the values that are numbers, parsed once.
+   */
+  struct ParameterEntryType
+  {
+    const ParameterValuesType *   m_Values;
+    std::vector< double >         m_Numbers;
+    std::vector< unsigned char >  m_NumberKinds;
+  };
+  typedef std::map< std::string, ParameterEntryType > ParameterStoreType;
+
+  /** Returns the entry of a parameter, or 0 if it does not exist. */
+  const ParameterEntryType * FindParameter( const std::string & parameterName ) const;
+
+  /** Parses a parameter value as a number, and returns its kind. */
+  static NumberKindType ParseNumber( const std::string & parameterValue, double & number );
+
   /** Member variable to store the parameters. */
   ParameterMapType m_ParameterMap;
 
+  /** The parsed parameters, which refer to the values in m_ParameterMap. */
+  ParameterStoreType m_ParameterStore;
+
   bool m_PrintErrorMessages;
 
+  /** Helper to cast a parsed number to type T. Only arithmetic types are
+   * supported; for other types the cast is left to StringCast().
+   */
+  template< class T, bool IsNumber = std::numeric_limits< T >::is_specialized >
+  struct NumberCaster
+  {
+    static bool Cast( const double, const unsigned char, T & )
+    {
+      return false;
+    }
+  };
+
+  template< class T >
+  struct NumberCaster< T, true >
+  {
+    static bool Cast( const double number, const unsigned char kind, T & casted )
+    {
+      if( std::numeric_limits< T >::is_integer )
+      {
+        /** Only plain integers that fit in T; StringCast() handles the rest,
+         * such as "2.5" or "-1" for an unsigned type.
+         */
+        if( kind != IntegerNumber
+          || number < static_cast< double >( std::numeric_limits< T >::min() )
+          || number > static_cast< double >( std::numeric_limits< T >::max() ) )
+        {
+          return false;
+        }
+      }
+      else if( kind == NotANumber )
+      {
+        return false;
+      }
+
+      casted = static_cast< T >( number );
+      return true;
+    }
+  };
+
+  /** Casts the parsed number of entry entry_nr to type T. Returns false
+   * when that is not possible, in which case StringCast() should be used.
+   */
+  template< class T >
+  bool NumberCast( const ParameterEntryType & entry,
+    const std::size_t entry_nr, T & casted ) const
+  {
+    return NumberCaster< T >::Cast( entry.m_Numbers[ entry_nr ],
+      entry.m_NumberKinds[ entry_nr ], casted );
+  }
+
   /** A templated function to cast strings to a type T.
    * Returns true when casting was successful and false otherwise.
    * We make use of the casting functionality of string streams.
@@ -49,6 +49,14 @@ namespace itk
  * Note: It is mandatory to set a current transform. An initial transform
  * is not mandatory.
  *
+ * The initial transform may itself be a chain of combination transforms,
+ * for example when several registrations are run one after the other. To
+ * avoid walking that chain for every point, a flattened initial transform
+ * can be set: a cheaper transform that is (nearly) equivalent to the
+ * initial transform, such as a single affine transform for a chain of
+ * linear transforms. It is then used instead of the initial transform to
+ * compute the combined transform and its derivatives.
+ *
  * \ingroup Transforms
  */
 
@@ -130,6 +138,17 @@ public:
 
   itkGetModifiableObjectMacro( InitialTransform, InitialTransformType );
 
+  /** Set/Get a transform that is used instead of the InitialTransform in
+   * all computations. Setting it to 0 restores the InitialTransform. The
+   * InitialTransform itself is not changed, so GetInitialTransform() still
+   * returns the original chain. Setting a new InitialTransform resets the
+   * flattened one. GetFlattenedInitialTransform() returns the transform that
+   * is actually used, i.e. the InitialTransform if none was set.
+   */
+  virtual void SetFlattenedInitialTransform( InitialTransformType * _arg );
+
+  itkGetModifiableObjectMacro( FlattenedInitialTransform, InitialTransformType );
+
   /** Set/Get a pointer to the CurrentTransform.
    * Make sure to set the CurrentTransform before calling functions like
    * TransformPoint(), GetJacobian(), SetParameters() etc.
@@ -337,6 +356,7 @@ protected:
 
   /** Declaration of members. */
   InitialTransformPointer m_InitialTransform;
+  InitialTransformPointer m_FlattenedInitialTransform;
   CurrentTransformPointer m_CurrentTransform;
 
   /** Set the SelectedTransformPointFunction and the
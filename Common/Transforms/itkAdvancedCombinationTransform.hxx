@@ -32,8 +32,9 @@ AdvancedCombinationTransform< TScalarType, NDimensions >
 ::AdvancedCombinationTransform() : Superclass( NDimensions )
 {
   /** Initialize. */
-  this->m_InitialTransform = 0;
-  this->m_CurrentTransform = 0;
+  this->m_InitialTransform          = 0;
+  this->m_FlattenedInitialTransform = 0;
+  this->m_CurrentTransform          = 0;
 
   /** Set composition by default. */
   this->m_UseAddition    = false;
@@ -547,7 +548,8 @@ AdvancedCombinationTransform< TScalarType, NDimensions >
   /** Set the the initial transform and call the UpdateCombinationMethod. */
   if( this->m_InitialTransform != _arg )
   {
-    this->m_InitialTransform = _arg;
+    this->m_InitialTransform          = _arg;
+    this->m_FlattenedInitialTransform = _arg;
     this->Modified();
     this->UpdateCombinationMethod();
   }
@@ -555,6 +557,31 @@ AdvancedCombinationTransform< TScalarType, NDimensions >
 } // end SetInitialTransform()
 
 
+/**
+ * ******************* SetFlattenedInitialTransform **********************
+ */
+
+template< typename TScalarType, unsigned int NDimensions >
+void
+AdvancedCombinationTransform< TScalarType, NDimensions >
+::SetFlattenedInitialTransform( InitialTransformType * _arg )
+{
+  /** Without an initial transform there is nothing to flatten. */
+  InitialTransformType * flattened = _arg;
+  if( flattened == 0 || this->m_InitialTransform.IsNull() )
+  {
+    flattened = this->m_InitialTransform.GetPointer();
+  }
+
+  if( this->m_FlattenedInitialTransform != flattened )
+  {
+    this->m_FlattenedInitialTransform = flattened;
+    this->Modified();
+  }
+
+} // end SetFlattenedInitialTransform()
+
+
 /**
  * ******************* SetCurrentTransform **********************
  */
@@ -771,7 +798,7 @@ AdvancedCombinationTransform< TScalarType, NDimensions >
 {
   /** The Initial transform. */
   OutputPointType out0
-    = this->m_InitialTransform->TransformPoint( point );
+    = this->m_FlattenedInitialTransform->TransformPoint( point );
 
   /** The Current transform. */
   OutputPointType out
@@ -798,7 +825,7 @@ AdvancedCombinationTransform< TScalarType, NDimensions >
 ::TransformPointUseComposition( const InputPointType & point ) const
 {
   return this->m_CurrentTransform->TransformPoint(
-    this->m_InitialTransform->TransformPoint( point ) );
+    this->m_FlattenedInitialTransform->TransformPoint( point ) );
 
 } // end TransformPointUseComposition()
 
@@ -865,7 +892,7 @@ AdvancedCombinationTransform< TScalarType, NDimensions >
   NonZeroJacobianIndicesType & nonZeroJacobianIndices ) const
 {
   this->m_CurrentTransform->GetJacobian(
-    this->m_InitialTransform->TransformPoint( ipp ),
+    this->m_FlattenedInitialTransform->TransformPoint( ipp ),
     j, nonZeroJacobianIndices );
 
 } // end GetJacobianUseComposition()
@@ -939,7 +966,7 @@ AdvancedCombinationTransform< TScalarType, NDimensions >
   NonZeroJacobianIndicesType & nonZeroJacobianIndices ) const
 {
   this->m_CurrentTransform->EvaluateJacobianWithImageGradientProduct(
-    this->m_InitialTransform->TransformPoint( ipp ),
+    this->m_FlattenedInitialTransform->TransformPoint( ipp ),
     movingImageGradient, imageJacobian, nonZeroJacobianIndices );
 
 } // end EvaluateJacobianWithImageGradientProductUseComposition()
@@ -995,7 +1022,7 @@ AdvancedCombinationTransform< TScalarType, NDimensions >
   SpatialJacobianType & sj ) const
 {
   SpatialJacobianType sj0, sj1, identity;
-  this->m_InitialTransform->GetSpatialJacobian( ipp, sj0 );
+  this->m_FlattenedInitialTransform->GetSpatialJacobian( ipp, sj0 );
   this->m_CurrentTransform->GetSpatialJacobian( ipp, sj1 );
   identity.SetIdentity();
   sj = sj0 + sj1 - identity;
@@ -1015,9 +1042,9 @@ AdvancedCombinationTransform< TScalarType, NDimensions >
   SpatialJacobianType & sj ) const
 {
   SpatialJacobianType sj0, sj1;
-  this->m_InitialTransform->GetSpatialJacobian( ipp, sj0 );
+  this->m_FlattenedInitialTransform->GetSpatialJacobian( ipp, sj0 );
   this->m_CurrentTransform->GetSpatialJacobian(
-    this->m_InitialTransform->TransformPoint( ipp ), sj1 );
+    this->m_FlattenedInitialTransform->TransformPoint( ipp ), sj1 );
 
   sj = sj1 * sj0;
 
@@ -1069,7 +1096,7 @@ AdvancedCombinationTransform< TScalarType, NDimensions >
   SpatialHessianType & sh ) const
 {
   SpatialHessianType sh0, sh1;
-  this->m_InitialTransform->GetSpatialHessian( ipp, sh0 );
+  this->m_FlattenedInitialTransform->GetSpatialHessian( ipp, sh0 );
   this->m_CurrentTransform->GetSpatialHessian( ipp, sh1 );
 
   for( unsigned int i = 0; i < SpaceDimension; ++i )
@@ -1098,14 +1125,14 @@ AdvancedCombinationTransform< TScalarType, NDimensions >
   /** Transform the input point. */
   // \todo this has already been computed and it is expensive.
   InputPointType transformedPoint
-    = this->m_InitialTransform->TransformPoint( ipp );
+    = this->m_FlattenedInitialTransform->TransformPoint( ipp );
 
   /** Compute the (Jacobian of the) spatial Jacobian / Hessian of the
    * internal transforms.
    */
-  this->m_InitialTransform->GetSpatialJacobian( ipp, sj0 );
+  this->m_FlattenedInitialTransform->GetSpatialJacobian( ipp, sj0 );
   this->m_CurrentTransform->GetSpatialJacobian( transformedPoint, sj1 );
-  this->m_InitialTransform->GetSpatialHessian( ipp, sh0 );
+  this->m_FlattenedInitialTransform->GetSpatialHessian( ipp, sh0 );
   this->m_CurrentTransform->GetSpatialHessian( transformedPoint, sh1 );
 
   typename SpatialJacobianType::InternalMatrixType sj0tvnl = sj0.GetTranspose();
@@ -1209,9 +1236,9 @@ AdvancedCombinationTransform< TScalarType, NDimensions >
 {
   SpatialJacobianType           sj0;
   JacobianOfSpatialJacobianType jsj1;
-  this->m_InitialTransform->GetSpatialJacobian( ipp, sj0 );
+  this->m_FlattenedInitialTransform->GetSpatialJacobian( ipp, sj0 );
   this->m_CurrentTransform->GetJacobianOfSpatialJacobian(
-    this->m_InitialTransform->TransformPoint( ipp ),
+    this->m_FlattenedInitialTransform->TransformPoint( ipp ),
     jsj1, nonZeroJacobianIndices );
 
   jsj.resize( nonZeroJacobianIndices.size() );
@@ -1238,9 +1265,9 @@ AdvancedCombinationTransform< TScalarType, NDimensions >
 {
   SpatialJacobianType           sj0, sj1;
   JacobianOfSpatialJacobianType jsj1;
-  this->m_InitialTransform->GetSpatialJacobian( ipp, sj0 );
+  this->m_FlattenedInitialTransform->GetSpatialJacobian( ipp, sj0 );
   this->m_CurrentTransform->GetJacobianOfSpatialJacobian(
-    this->m_InitialTransform->TransformPoint( ipp ),
+    this->m_FlattenedInitialTransform->TransformPoint( ipp ),
     sj1, jsj1, nonZeroJacobianIndices );
 
   sj = sj1 * sj0;
@@ -1385,12 +1412,12 @@ AdvancedCombinationTransform< TScalarType, NDimensions >
   /** Transform the input point. */
   // \todo: this has already been computed and it is expensive.
   InputPointType transformedPoint
-    = this->m_InitialTransform->TransformPoint( ipp );
+    = this->m_FlattenedInitialTransform->TransformPoint( ipp );
 
   /** Compute the (Jacobian of the) spatial Jacobian / Hessian of the
    * internal transforms. */
-  this->m_InitialTransform->GetSpatialJacobian( ipp, sj0 );
-  this->m_InitialTransform->GetSpatialHessian( ipp, sh0 );
+  this->m_FlattenedInitialTransform->GetSpatialJacobian( ipp, sj0 );
+  this->m_FlattenedInitialTransform->GetSpatialHessian( ipp, sh0 );
 
   /** Assume/demand that GetJacobianOfSpatialJacobian returns
    * the same nonZeroJacobianIndices as the GetJacobianOfSpatialHessian. */
@@ -1413,7 +1440,7 @@ AdvancedCombinationTransform< TScalarType, NDimensions >
     }
   }
 
-  if( this->m_InitialTransform->GetHasNonZeroSpatialHessian() )
+  if( this->m_FlattenedInitialTransform->GetHasNonZeroSpatialHessian() )
   {
     for( unsigned int mu = 0; mu < nonZeroJacobianIndices.size(); ++mu )
     {
@@ -1452,13 +1479,13 @@ AdvancedCombinationTransform< TScalarType, NDimensions >
   /** Transform the input point. */
   // \todo this has already been computed and it is expensive.
   InputPointType transformedPoint
-    = this->m_InitialTransform->TransformPoint( ipp );
+    = this->m_FlattenedInitialTransform->TransformPoint( ipp );
 
   /** Compute the (Jacobian of the) spatial Jacobian / Hessian of the
    * internal transforms.
    */
-  this->m_InitialTransform->GetSpatialJacobian( ipp, sj0 );
-  this->m_InitialTransform->GetSpatialHessian( ipp, sh0 );
+  this->m_FlattenedInitialTransform->GetSpatialJacobian( ipp, sj0 );
+  this->m_FlattenedInitialTransform->GetSpatialHessian( ipp, sh0 );
 
   /** Assume/demand that GetJacobianOfSpatialJacobian returns the same
    * nonZeroJacobianIndices as the GetJacobianOfSpatialHessian.
@@ -1481,7 +1508,7 @@ AdvancedCombinationTransform< TScalarType, NDimensions >
     }
   }
 
-  if( this->m_InitialTransform->GetHasNonZeroSpatialHessian() )
+  if( this->m_FlattenedInitialTransform->GetHasNonZeroSpatialHessian() )
   {
     for( unsigned int mu = 0; mu < nonZeroJacobianIndices.size(); ++mu )
     {
@@ -1501,7 +1528,7 @@ AdvancedCombinationTransform< TScalarType, NDimensions >
     sh[ dim ] = sj0t * ( sh1[ dim ] * sj0 );
   }
 
-  if( this->m_InitialTransform->GetHasNonZeroSpatialHessian() )
+  if( this->m_FlattenedInitialTransform->GetHasNonZeroSpatialHessian() )
   {
     for( unsigned int dim = 0; dim < SpaceDimension; ++dim )
     {
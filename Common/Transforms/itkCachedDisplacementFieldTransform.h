@@ -0,0 +1,231 @@
+/*=========================================================================
+ *
+ *  Copyright UMC Utrecht and contributors
+ *
+ *  Licensed under the Apache License, Version 2.0 (the "License");
+ *  you may not use this file except in compliance with the License.
+ *  You may obtain a copy of the License at
+ *
+ *        http://www.apache.org/licenses/LICENSE-2.0.txt
+ *
+ *  Unless required by applicable law or agreed to in writing, software
+ *  distributed under the License is distributed on an "AS IS" BASIS,
+ *  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *  See the License for the specific language governing permissions and
+ *  limitations under the License.
+ *
+ *=========================================================================*/
+#ifndef __itkCachedDisplacementFieldTransform_h
+#define __itkCachedDisplacementFieldTransform_h
+
+#include "itkAdvancedTransform.h"
+#include "itkImage.h"
+
+namespace itk
+{
+
+/** \class CachedDisplacementFieldTransform
+ * \brief Approximates a transform by a displacement field on a grid.
+ *
+ * This transform caches another (expensive) transform, such as a chain of
+ * initial transforms, as a displacement field on an image grid. Inside the
+ * grid, TransformPoint() linearly interpolates the displacement, which costs
+ * the same regardless of the cached transform. Outside the grid, and for
+ * all derivatives, the cached transform itself is evaluated, so that those
+ * remain exact.
+ *
+ * The transform has no parameters. It is meant to replace a fixed initial
+ * transform of an AdvancedCombinationTransform, see
+ * AdvancedCombinationTransform::SetFlattenedInitialTransform().
+ * The displacement field can be computed with for example the
+ * TransformToDisplacementFieldFilter.
+ *
+ * \ingroup Transforms
+ */
+
+template< class TScalarType, unsigned int NDimensions = 3 >
+class CachedDisplacementFieldTransform :
+  public AdvancedTransform< TScalarType, NDimensions, NDimensions >
+{
+public:
+
+  /** Standard class typedefs. */
+  typedef CachedDisplacementFieldTransform                           Self;
+  typedef AdvancedTransform< TScalarType, NDimensions, NDimensions > Superclass;
+  typedef SmartPointer< Self >                                       Pointer;
+  typedef SmartPointer< const Self >                                 ConstPointer;
+
+  /** New macro for creation of through the object factory. */
+  itkNewMacro( Self );
+
+  /** Run-time type information (and related methods). */
+  itkTypeMacro( CachedDisplacementFieldTransform, AdvancedTransform );
+
+  /** Dimension of the domain spaces. */
+  itkStaticConstMacro( SpaceDimension, unsigned int, NDimensions );
+
+  /** Superclass typedefs. */
+  typedef typename Superclass::ScalarType                    ScalarType;
+  typedef typename Superclass::ParametersType                ParametersType;
+  typedef typename Superclass::FixedParametersType           FixedParametersType;
+  typedef typename Superclass::NumberOfParametersType        NumberOfParametersType;
+  typedef typename Superclass::JacobianType                  JacobianType;
+  typedef typename Superclass::InputVectorType               InputVectorType;
+  typedef typename Superclass::OutputVectorType              OutputVectorType;
+  typedef typename Superclass::InputCovariantVectorType      InputCovariantVectorType;
+  typedef typename Superclass::OutputCovariantVectorType     OutputCovariantVectorType;
+  typedef typename Superclass::InputVnlVectorType            InputVnlVectorType;
+  typedef typename Superclass::OutputVnlVectorType           OutputVnlVectorType;
+  typedef typename Superclass::InputPointType                InputPointType;
+  typedef typename Superclass::OutputPointType               OutputPointType;
+  typedef typename Superclass::NonZeroJacobianIndicesType    NonZeroJacobianIndicesType;
+  typedef typename Superclass::SpatialJacobianType           SpatialJacobianType;
+  typedef typename Superclass::JacobianOfSpatialJacobianType JacobianOfSpatialJacobianType;
+  typedef typename Superclass::SpatialHessianType            SpatialHessianType;
+  typedef typename Superclass::JacobianOfSpatialHessianType  JacobianOfSpatialHessianType;
+
+  /** Typedefs for the cached transform. */
+  typedef Superclass                                 CachedTransformType;
+  typedef typename CachedTransformType::ConstPointer CachedTransformConstPointer;
+
+  /** Typedefs for the displacement field. Single precision suffices for
+   * displacements, and halves the memory use.
+   */
+  typedef Vector< float, NDimensions >               DisplacementType;
+  typedef Image< DisplacementType, NDimensions >     DisplacementFieldType;
+  typedef typename DisplacementFieldType::Pointer    DisplacementFieldPointer;
+  typedef typename DisplacementFieldType::IndexType  IndexType;
+  typedef typename DisplacementFieldType::SizeType   SizeType;
+  typedef ContinuousIndex< ScalarType, NDimensions > ContinuousIndexType;
+
+  /** Set/Get the transform that is approximated by the displacement field. */
+  itkSetConstObjectMacro( CachedTransform, CachedTransformType );
+  itkGetConstObjectMacro( CachedTransform, CachedTransformType );
+
+  /** Set/Get the displacement field. */
+  virtual void SetDisplacementField( DisplacementFieldType * _arg );
+
+  itkGetModifiableObjectMacro( DisplacementField, DisplacementFieldType );
+
+  /** Transform a point, by interpolating the displacement field. */
+  virtual OutputPointType TransformPoint( const InputPointType & point ) const;
+
+  /** These vector transforms are not implemented for this transform. */
+  virtual OutputVectorType TransformVector( const InputVectorType & ) const
+  {
+    itkExceptionMacro(
+        << "TransformVector(const InputVectorType &) is not implemented "
+        << "for CachedDisplacementFieldTransform" );
+  }
+
+
+  virtual OutputVnlVectorType TransformVector( const InputVnlVectorType & ) const
+  {
+    itkExceptionMacro(
+        << "TransformVector(const InputVnlVectorType &) is not implemented "
+        << "for CachedDisplacementFieldTransform" );
+  }
+
+
+  virtual OutputCovariantVectorType TransformCovariantVector( const InputCovariantVectorType & ) const
+  {
+    itkExceptionMacro(
+        << "TransformCovariantVector(const InputCovariantVectorType &) is not implemented "
+        << "for CachedDisplacementFieldTransform" );
+  }
+
+
+  /** This transform has no parameters. */
+  virtual void SetParameters( const ParametersType & )
+  {
+    itkExceptionMacro( << "ERROR: SetParameters() is not implemented "
+                       << "for CachedDisplacementFieldTransform." );
+  }
+
+
+  virtual void SetFixedParameters( const FixedParametersType & )
+  {
+    // This transform has no fixed parameters.
+  }
+
+
+  virtual const FixedParametersType & GetFixedParameters( void ) const
+  {
+    return this->m_FixedParameters;
+  }
+
+
+  virtual bool IsLinear( void ) const { return false; }
+
+  /** The derivatives are those of the cached transform. */
+  virtual bool GetHasNonZeroSpatialHessian( void ) const;
+
+  virtual bool GetHasNonZeroJacobianOfSpatialHessian( void ) const;
+
+  virtual void GetJacobian(
+    const InputPointType & ipp,
+    JacobianType & j,
+    NonZeroJacobianIndicesType & nonZeroJacobianIndices ) const;
+
+  virtual void GetSpatialJacobian(
+    const InputPointType & ipp,
+    SpatialJacobianType & sj ) const;
+
+  virtual void GetSpatialHessian(
+    const InputPointType & ipp,
+    SpatialHessianType & sh ) const;
+
+  virtual void GetJacobianOfSpatialJacobian(
+    const InputPointType & ipp,
+    JacobianOfSpatialJacobianType & jsj,
+    NonZeroJacobianIndicesType & nonZeroJacobianIndices ) const;
+
+  virtual void GetJacobianOfSpatialJacobian(
+    const InputPointType & ipp,
+    SpatialJacobianType & sj,
+    JacobianOfSpatialJacobianType & jsj,
+    NonZeroJacobianIndicesType & nonZeroJacobianIndices ) const;
+
+  virtual void GetJacobianOfSpatialHessian(
+    const InputPointType & ipp,
+    JacobianOfSpatialHessianType & jsh,
+    NonZeroJacobianIndicesType & nonZeroJacobianIndices ) const;
+
+  virtual void GetJacobianOfSpatialHessian(
+    const InputPointType & ipp,
+    SpatialHessianType & sh,
+    JacobianOfSpatialHessianType & jsh,
+    NonZeroJacobianIndicesType & nonZeroJacobianIndices ) const;
+
+protected:
+
+  CachedDisplacementFieldTransform();
+  virtual ~CachedDisplacementFieldTransform() {}
+
+  /** Print contents of a CachedDisplacementFieldTransform. */
+  void PrintSelf( std::ostream & os, Indent indent ) const;
+
+  /** Throws an exception if no cached transform was set. */
+  void CheckCachedTransform( void ) const;
+
+private:
+
+  CachedDisplacementFieldTransform( const Self & ); // purposely not implemented
+  void operator=( const Self & );                   // purposely not implemented
+
+  CachedTransformConstPointer m_CachedTransform;
+  DisplacementFieldPointer    m_DisplacementField;
+
+  /** The grid of the displacement field, in voxels. */
+  IndexType m_StartIndex;
+  SizeType  m_Size;
+
+};
+
+} // end namespace itk
+
+#ifndef ITK_MANUAL_INSTANTIATION
+#include "itkCachedDisplacementFieldTransform.hxx"
+#endif
+
+#endif // end #ifndef __itkCachedDisplacementFieldTransform_h
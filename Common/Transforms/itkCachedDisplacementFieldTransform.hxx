@@ -0,0 +1,341 @@
+/*=========================================================================
+ *
+ *  Copyright UMC Utrecht and contributors
+ *
+ *  Licensed under the Apache License, Version 2.0 (the "License");
+ *  you may not use this file except in compliance with the License.
+ *  You may obtain a copy of the License at
+ *
+ *        http://www.apache.org/licenses/LICENSE-2.0.txt
+ *
+ *  Unless required by applicable law or agreed to in writing, software
+ *  distributed under the License is distributed on an "AS IS" BASIS,
+ *  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *  See the License for the specific language governing permissions and
+ *  limitations under the License.
+ *
+ *=========================================================================*/
+#ifndef __itkCachedDisplacementFieldTransform_hxx
+#define __itkCachedDisplacementFieldTransform_hxx
+
+#include "itkCachedDisplacementFieldTransform.h"
+
+namespace itk
+{
+
+/**
+ * ********************* Constructor ****************************
+ */
+
+template< class TScalarType, unsigned int NDimensions >
+CachedDisplacementFieldTransform< TScalarType, NDimensions >
+::CachedDisplacementFieldTransform() : Superclass( 0 )
+{
+  this->m_CachedTransform   = 0;
+  this->m_DisplacementField = 0;
+  this->m_StartIndex.Fill( 0 );
+  this->m_Size.Fill( 0 );
+
+} // end Constructor
+
+
+/**
+ * ******************* SetDisplacementField *******************
+ */
+
+template< class TScalarType, unsigned int NDimensions >
+void
+CachedDisplacementFieldTransform< TScalarType, NDimensions >
+::SetDisplacementField( DisplacementFieldType * _arg )
+{
+  if( this->m_DisplacementField != _arg )
+  {
+    this->m_DisplacementField = _arg;
+    this->m_StartIndex.Fill( 0 );
+    this->m_Size.Fill( 0 );
+    if( _arg )
+    {
+      this->m_StartIndex = _arg->GetBufferedRegion().GetIndex();
+      this->m_Size       = _arg->GetBufferedRegion().GetSize();
+    }
+    this->Modified();
+  }
+
+} // end SetDisplacementField()
+
+
+/**
+ * ******************* TransformPoint *******************
+ */
+
+template< class TScalarType, unsigned int NDimensions >
+typename CachedDisplacementFieldTransform< TScalarType, NDimensions >::OutputPointType
+CachedDisplacementFieldTransform< TScalarType, NDimensions >
+::TransformPoint( const InputPointType & point ) const
+{
+  if( this->m_DisplacementField.IsNull() )
+  {
+    this->CheckCachedTransform();
+    return this->m_CachedTransform->TransformPoint( point );
+  }
+
+  /** Find the grid cell of the point, and the position inside it. */
+  ContinuousIndexType cindex;
+  this->m_DisplacementField->TransformPhysicalPointToContinuousIndex( point, cindex );
+
+  IndexType  baseIndex;
+  ScalarType fraction[ NDimensions ];
+  for( unsigned int d = 0; d < NDimensions; ++d )
+  {
+    const ScalarType position = cindex[ d ] - static_cast< ScalarType >( this->m_StartIndex[ d ] );
+    const ScalarType maximum  = static_cast< ScalarType >( this->m_Size[ d ] ) - 1.0;
+
+    /** Outside the grid the cached transform itself is used. */
+    if( !( position >= 0.0 && position <= maximum ) )
+    {
+      this->CheckCachedTransform();
+      return this->m_CachedTransform->TransformPoint( point );
+    }
+
+    /** On the last grid line, use the last cell. */
+    IndexValueType cell = static_cast< IndexValueType >( position );
+    if( cell > 0 && position == maximum )
+    {
+      --cell;
+    }
+    baseIndex[ d ] = this->m_StartIndex[ d ] + cell;
+    fraction[ d ]  = position - static_cast< ScalarType >( cell );
+  }
+
+  /** Linearly interpolate the displacement from the corners of the cell.
+   * Corners with a zero weight are skipped, which also avoids reading
+   * outside a grid with size 1.
+   */
+  OutputPointType transformedPoint = point;
+  const unsigned int numberOfCorners = 1u << NDimensions;
+  for( unsigned int corner = 0; corner < numberOfCorners; ++corner )
+  {
+    ScalarType weight      = 1.0;
+    IndexType  cornerIndex = baseIndex;
+    for( unsigned int d = 0; d < NDimensions; ++d )
+    {
+      if( corner & ( 1u << d ) )
+      {
+        weight *= fraction[ d ];
+        ++cornerIndex[ d ];
+      }
+      else
+      {
+        weight *= 1.0 - fraction[ d ];
+      }
+    }
+
+    if( weight != 0.0 )
+    {
+      const DisplacementType & displacement
+        = this->m_DisplacementField->GetPixel( cornerIndex );
+      for( unsigned int d = 0; d < NDimensions; ++d )
+      {
+        transformedPoint[ d ] += weight * displacement[ d ];
+      }
+    }
+  }
+
+  return transformedPoint;
+
+} // end TransformPoint()
+
+
+/**
+ * ******************* CheckCachedTransform *******************
+ */
+
+template< class TScalarType, unsigned int NDimensions >
+void
+CachedDisplacementFieldTransform< TScalarType, NDimensions >
+::CheckCachedTransform( void ) const
+{
+  if( this->m_CachedTransform.IsNull() )
+  {
+    itkExceptionMacro( << "No cached transform set in the CachedDisplacementFieldTransform" );
+  }
+
+} // end CheckCachedTransform()
+
+
+/**
+ * ******************* GetHasNonZeroSpatialHessian *******************
+ */
+
+template< class TScalarType, unsigned int NDimensions >
+bool
+CachedDisplacementFieldTransform< TScalarType, NDimensions >
+::GetHasNonZeroSpatialHessian( void ) const
+{
+  this->CheckCachedTransform();
+  return this->m_CachedTransform->GetHasNonZeroSpatialHessian();
+
+} // end GetHasNonZeroSpatialHessian()
+
+
+/**
+ * ******************* GetHasNonZeroJacobianOfSpatialHessian *******************
+ */
+
+template< class TScalarType, unsigned int NDimensions >
+bool
+CachedDisplacementFieldTransform< TScalarType, NDimensions >
+::GetHasNonZeroJacobianOfSpatialHessian( void ) const
+{
+  this->CheckCachedTransform();
+  return this->m_CachedTransform->GetHasNonZeroJacobianOfSpatialHessian();
+
+} // end GetHasNonZeroJacobianOfSpatialHessian()
+
+
+/**
+ * ******************* GetJacobian *******************
+ */
+
+template< class TScalarType, unsigned int NDimensions >
+void
+CachedDisplacementFieldTransform< TScalarType, NDimensions >
+::GetJacobian(
+  const InputPointType & ipp,
+  JacobianType & j,
+  NonZeroJacobianIndicesType & nonZeroJacobianIndices ) const
+{
+  this->CheckCachedTransform();
+  this->m_CachedTransform->GetJacobian( ipp, j, nonZeroJacobianIndices );
+
+} // end GetJacobian()
+
+
+/**
+ * ******************* GetSpatialJacobian *******************
+ */
+
+template< class TScalarType, unsigned int NDimensions >
+void
+CachedDisplacementFieldTransform< TScalarType, NDimensions >
+::GetSpatialJacobian(
+  const InputPointType & ipp,
+  SpatialJacobianType & sj ) const
+{
+  this->CheckCachedTransform();
+  this->m_CachedTransform->GetSpatialJacobian( ipp, sj );
+
+} // end GetSpatialJacobian()
+
+
+/**
+ * ******************* GetSpatialHessian *******************
+ */
+
+template< class TScalarType, unsigned int NDimensions >
+void
+CachedDisplacementFieldTransform< TScalarType, NDimensions >
+::GetSpatialHessian(
+  const InputPointType & ipp,
+  SpatialHessianType & sh ) const
+{
+  this->CheckCachedTransform();
+  this->m_CachedTransform->GetSpatialHessian( ipp, sh );
+
+} // end GetSpatialHessian()
+
+
+/**
+ * ******************* GetJacobianOfSpatialJacobian *******************
+ */
+
+template< class TScalarType, unsigned int NDimensions >
+void
+CachedDisplacementFieldTransform< TScalarType, NDimensions >
+::GetJacobianOfSpatialJacobian(
+  const InputPointType & ipp,
+  JacobianOfSpatialJacobianType & jsj,
+  NonZeroJacobianIndicesType & nonZeroJacobianIndices ) const
+{
+  this->CheckCachedTransform();
+  this->m_CachedTransform->GetJacobianOfSpatialJacobian( ipp, jsj, nonZeroJacobianIndices );
+
+} // end GetJacobianOfSpatialJacobian()
+
+
+/**
+ * ******************* GetJacobianOfSpatialJacobian *******************
+ */
+
+template< class TScalarType, unsigned int NDimensions >
+void
+CachedDisplacementFieldTransform< TScalarType, NDimensions >
+::GetJacobianOfSpatialJacobian(
+  const InputPointType & ipp,
+  SpatialJacobianType & sj,
+  JacobianOfSpatialJacobianType & jsj,
+  NonZeroJacobianIndicesType & nonZeroJacobianIndices ) const
+{
+  this->CheckCachedTransform();
+  this->m_CachedTransform->GetJacobianOfSpatialJacobian( ipp, sj, jsj, nonZeroJacobianIndices );
+
+} // end GetJacobianOfSpatialJacobian()
+
+
+/**
+ * ******************* GetJacobianOfSpatialHessian *******************
+ */
+
+template< class TScalarType, unsigned int NDimensions >
+void
+CachedDisplacementFieldTransform< TScalarType, NDimensions >
+::GetJacobianOfSpatialHessian(
+  const InputPointType & ipp,
+  JacobianOfSpatialHessianType & jsh,
+  NonZeroJacobianIndicesType & nonZeroJacobianIndices ) const
+{
+  this->CheckCachedTransform();
+  this->m_CachedTransform->GetJacobianOfSpatialHessian( ipp, jsh, nonZeroJacobianIndices );
+
+} // end GetJacobianOfSpatialHessian()
+
+
+/**
+ * ******************* GetJacobianOfSpatialHessian *******************
+ */
+
+template< class TScalarType, unsigned int NDimensions >
+void
+CachedDisplacementFieldTransform< TScalarType, NDimensions >
+::GetJacobianOfSpatialHessian(
+  const InputPointType & ipp,
+  SpatialHessianType & sh,
+  JacobianOfSpatialHessianType & jsh,
+  NonZeroJacobianIndicesType & nonZeroJacobianIndices ) const
+{
+  this->CheckCachedTransform();
+  this->m_CachedTransform->GetJacobianOfSpatialHessian( ipp, sh, jsh, nonZeroJacobianIndices );
+
+} // end GetJacobianOfSpatialHessian()
+
+
+/**
+ * ******************* PrintSelf *******************
+ */
+
+template< class TScalarType, unsigned int NDimensions >
+void
+CachedDisplacementFieldTransform< TScalarType, NDimensions >
+::PrintSelf( std::ostream & os, Indent indent ) const
+{
+  Superclass::PrintSelf( os, indent );
+
+  os << indent << "CachedTransform: " << this->m_CachedTransform.GetPointer() << std::endl;
+  os << indent << "DisplacementField: " << this->m_DisplacementField.GetPointer() << std::endl;
+
+} // end PrintSelf()
+
+
+} // end namespace itk
+
+#endif // end #ifndef __itkCachedDisplacementFieldTransform_hxx
@@ -20,6 +20,9 @@
 
 #include "itkAdvancedTransform.h"
 #include "itkIndex.h"
+#include "itkMultiThreader.h"
+
+#include <vector>
 
 namespace itk
 {
@@ -31,6 +34,13 @@ namespace itk
  * one for every last dimension index. This transform selects the right
  * transform based on the last dimension index of the input point.
  *
+ * Batches of points can be transformed with TransformPoints() and
+ * GetJacobians(). The points of a batch are grouped per sub transform, and
+ * the groups are evaluated by multiple threads. Each thread evaluates the
+ * points of a sub transform consecutively, so that the coefficients of that
+ * sub transform stay in its cache. The batch functions share one threader,
+ * so they should not be called simultaneously by multiple threads.
+ *
  * \ingroup Transforms
  *
  */
@@ -105,6 +115,12 @@ public:
   /** Array type for parameter vector instantiation. */
   typedef typename ParametersType::ArrayType ParametersArrayType;
 
+  /** Container types for the batch interface. */
+  typedef std::vector< InputPointType >             InputPointContainerType;
+  typedef std::vector< OutputPointType >            OutputPointContainerType;
+  typedef std::vector< JacobianType >               JacobianContainerType;
+  typedef std::vector< NonZeroJacobianIndicesType > NonZeroJacobianIndicesContainerType;
+
   /**  Method to transform a point. */
   virtual OutputPointType TransformPoint( const InputPointType & ipp ) const;
 
@@ -143,6 +159,31 @@ public:
     JacobianType & jac,
     NonZeroJacobianIndicesType & nzji ) const;
 
+  /** Return the index of the sub transform that is used for a point. */
+  unsigned int GetSubTransformIndex( const InputPointType & ipp ) const;
+
+  /** Transform a batch of points. The sub transforms are evaluated
+   * concurrently. The transformed points are returned in the order of
+   * the input points.
+   */
+  virtual void TransformPoints( const InputPointContainerType & points,
+    OutputPointContainerType & transformedPoints ) const;
+
+  /** Compute the sparse Jacobians of a batch of points, like GetJacobian().
+   * The sub transforms are evaluated concurrently. The results are returned
+   * in the order of the input points.
+   */
+  virtual void GetJacobians( const InputPointContainerType & points,
+    JacobianContainerType & jacobians,
+    NonZeroJacobianIndicesContainerType & nonZeroJacobianIndices ) const;
+
+  /** Set the number of threads that evaluate a batch of points. */
+  void SetNumberOfThreads( ThreadIdType numberOfThreads )
+  {
+    this->m_Threader->SetNumberOfThreads( numberOfThreads );
+  }
+
+
   /** Set the parameters. Checks if the number of parameters
    * is correct and sets parameters of sub transforms. */
   virtual void SetParameters( const ParametersType & param );
@@ -288,6 +329,48 @@ protected:
   StackTransform();
   virtual ~StackTransform() {}
 
+  /** Typedefs for multi-threading. */
+  typedef itk::MultiThreader             ThreaderType;
+  typedef ThreaderType::ThreadInfoStruct ThreaderInfoType;
+
+  /** The state of the evaluation of a batch of points, shared with the
+   * threads. Order contains the indices of the points, sorted by sub
+   * transform, and stably sorted within a sub transform.
+   */
+  struct BatchType
+  {
+    const Self *                          Transform;
+    const InputPointContainerType *       Points;
+    std::vector< unsigned int >           SubTransformIndices;
+    std::vector< SizeValueType >          Order;
+    OutputPointContainerType *            TransformedPoints;
+    JacobianContainerType *               Jacobians;
+    NonZeroJacobianIndicesContainerType * NonZeroJacobianIndices;
+  };
+
+  /** Group the points of a batch per sub transform, and evaluate them. */
+  void EvaluateBatch( BatchType & batch ) const;
+
+  /** Batch threader callback function. */
+  static ITK_THREAD_RETURN_TYPE BatchThreaderCallback( void * arg );
+
+  /** Evaluate the points [begin, end) of the sorted order of a batch. */
+  void ThreadedEvaluateBatch( const BatchType & batch,
+    const SizeValueType begin, const SizeValueType end ) const;
+
+  /** Transform a point with sub transform subt. */
+  OutputPointType TransformPointWithSubTransform(
+    const unsigned int subt, const InputPointType & ipp ) const;
+
+  /** Compute the Jacobian of a point with sub transform subt. The
+   * Jacobian of the sub transform is returned in subjac.
+   */
+  void GetJacobianWithSubTransform( const unsigned int subt,
+    const InputPointType & ipp,
+    SubTransformJacobianType & subjac,
+    JacobianType & jac,
+    NonZeroJacobianIndicesType & nzji ) const;
+
 private:
 
   StackTransform( const Self & );  // purposely not implemented
@@ -300,6 +383,9 @@ private:
   // Stack spacing and origin of last dimension
   TScalarType m_StackSpacing, m_StackOrigin;
 
+  // Threader for the evaluation of batches of points
+  ThreaderType::Pointer m_Threader;
+
 };
 
 } // end namespace itk
@@ -33,7 +33,12 @@ StackTransform< TScalarType, NInputDimensions, NOutputDimensions >
   m_NumberOfSubTransforms( 0 ),
   m_StackSpacing( 1.0 ),
   m_StackOrigin( 0.0 )
-{} // end Constructor
+{
+  this->m_Threader = ThreaderType::New();
+#if ITK_VERSION_MAJOR < 5
+  this->m_Threader->SetUseThreadPool( false );
+#endif
+} // end Constructor
 
 
 /**
@@ -95,6 +100,22 @@ const typename StackTransform< TScalarType, NInputDimensions, NOutputDimensions
 } // end GetParameters()
 
 
+/**
+ * ********************* GetSubTransformIndex ****************************
+ */
+
+template< class TScalarType, unsigned int NInputDimensions, unsigned int NOutputDimensions >
+unsigned int
+StackTransform< TScalarType, NInputDimensions, NOutputDimensions >
+::GetSubTransformIndex( const InputPointType & ipp ) const
+{
+  return vnl_math_min( this->m_NumberOfSubTransforms - 1, static_cast< unsigned int >(
+    vnl_math_max( 0,
+    vnl_math_rnd( ( ipp[ ReducedInputSpaceDimension ] - m_StackOrigin ) / m_StackSpacing ) ) ) );
+
+} // end GetSubTransformIndex()
+
+
 /**
  * ********************* TransformPoint ****************************
  */
@@ -104,6 +125,21 @@ typename StackTransform< TScalarType, NInputDimensions, NOutputDimensions >
 ::OutputPointType
 StackTransform< TScalarType, NInputDimensions, NOutputDimensions >
 ::TransformPoint( const InputPointType & ipp ) const
+{
+  return this->TransformPointWithSubTransform( this->GetSubTransformIndex( ipp ), ipp );
+
+} // end TransformPoint()
+
+
+/**
+ * ********************* TransformPointWithSubTransform ****************************
+ */
+
+template< class TScalarType, unsigned int NInputDimensions, unsigned int NOutputDimensions >
+typename StackTransform< TScalarType, NInputDimensions, NOutputDimensions >
+::OutputPointType
+StackTransform< TScalarType, NInputDimensions, NOutputDimensions >
+::TransformPointWithSubTransform( const unsigned int subt, const InputPointType & ipp ) const
 {
   /** Reduce dimension of input point. */
   SubTransformInputPointType ippr;
@@ -113,12 +149,8 @@ StackTransform< TScalarType, NInputDimensions, NOutputDimensions >
   }
 
   /** Transform point using right subtransform. */
-  SubTransformOutputPointType oppr;
-  const unsigned int          subt
-    = vnl_math_min( this->m_NumberOfSubTransforms - 1, static_cast< unsigned int >(
-      vnl_math_max( 0,
-      vnl_math_rnd( ( ipp[ ReducedInputSpaceDimension ] - m_StackOrigin ) / m_StackSpacing ) ) ) );
-  oppr = this->m_SubTransformContainer[ subt ]->TransformPoint( ippr );
+  const SubTransformOutputPointType oppr
+    = this->m_SubTransformContainer[ subt ]->TransformPoint( ippr );
 
   /** Increase dimension of input point. */
   OutputPointType opp;
@@ -130,7 +162,7 @@ StackTransform< TScalarType, NInputDimensions, NOutputDimensions >
 
   return opp;
 
-} // end TransformPoint()
+} // end TransformPointWithSubTransform()
 
 
 /**
@@ -144,6 +176,25 @@ StackTransform< TScalarType, NInputDimensions, NOutputDimensions >
   const InputPointType & ipp,
   JacobianType & jac,
   NonZeroJacobianIndicesType & nzji ) const
+{
+  SubTransformJacobianType subjac;
+  this->GetJacobianWithSubTransform( this->GetSubTransformIndex( ipp ), ipp, subjac, jac, nzji );
+
+} // end GetJacobian()
+
+
+/**
+ * ********************* GetJacobianWithSubTransform ****************************
+ */
+
+template< class TScalarType, unsigned int NInputDimensions, unsigned int NOutputDimensions >
+void
+StackTransform< TScalarType, NInputDimensions, NOutputDimensions >
+::GetJacobianWithSubTransform( const unsigned int subt,
+  const InputPointType & ipp,
+  SubTransformJacobianType & subjac,
+  JacobianType & jac,
+  NonZeroJacobianIndicesType & nzji ) const
 {
   /** Reduce dimension of input point. */
   SubTransformInputPointType ippr;
@@ -153,11 +204,6 @@ StackTransform< TScalarType, NInputDimensions, NOutputDimensions >
   }
 
   /** Get Jacobian from right subtransform. */
-  const unsigned int subt
-    = vnl_math_min( this->m_NumberOfSubTransforms - 1, static_cast< unsigned int >(
-      vnl_math_max( 0,
-      vnl_math_rnd( ( ipp[ ReducedInputSpaceDimension ] - m_StackOrigin ) / m_StackSpacing ) ) ) );
-  SubTransformJacobianType subjac;
   this->m_SubTransformContainer[ subt ]->GetJacobian( ippr, subjac, nzji );
 
   /** Fill output Jacobian. */
@@ -177,7 +223,167 @@ StackTransform< TScalarType, NInputDimensions, NOutputDimensions >
     nzji[ i ] += subt * this->m_SubTransformContainer[ 0 ]->GetNumberOfParameters();
   }
 
-} // end GetJacobian()
+} // end GetJacobianWithSubTransform()
+
+
+/**
+ * ********************* TransformPoints ****************************
+ */
+
+template< class TScalarType, unsigned int NInputDimensions, unsigned int NOutputDimensions >
+void
+StackTransform< TScalarType, NInputDimensions, NOutputDimensions >
+::TransformPoints( const InputPointContainerType & points,
+  OutputPointContainerType & transformedPoints ) const
+{
+  transformedPoints.resize( points.size() );
+
+  BatchType batch;
+  batch.Transform              = this;
+  batch.Points                 = &points;
+  batch.TransformedPoints      = &transformedPoints;
+  batch.Jacobians              = 0;
+  batch.NonZeroJacobianIndices = 0;
+  this->EvaluateBatch( batch );
+
+} // end TransformPoints()
+
+
+/**
+ * ********************* GetJacobians ****************************
+ */
+
+template< class TScalarType, unsigned int NInputDimensions, unsigned int NOutputDimensions >
+void
+StackTransform< TScalarType, NInputDimensions, NOutputDimensions >
+::GetJacobians( const InputPointContainerType & points,
+  JacobianContainerType & jacobians,
+  NonZeroJacobianIndicesContainerType & nonZeroJacobianIndices ) const
+{
+  jacobians.resize( points.size() );
+  nonZeroJacobianIndices.resize( points.size() );
+
+  BatchType batch;
+  batch.Transform              = this;
+  batch.Points                 = &points;
+  batch.TransformedPoints      = 0;
+  batch.Jacobians              = &jacobians;
+  batch.NonZeroJacobianIndices = &nonZeroJacobianIndices;
+  this->EvaluateBatch( batch );
+
+} // end GetJacobians()
+
+
+/**
+ * ********************* EvaluateBatch ****************************
+ */
+
+template< class TScalarType, unsigned int NInputDimensions, unsigned int NOutputDimensions >
+void
+StackTransform< TScalarType, NInputDimensions, NOutputDimensions >
+::EvaluateBatch( BatchType & batch ) const
+{
+  const SizeValueType numberOfPoints = batch.Points->size();
+  if( numberOfPoints == 0 )
+  {
+    return;
+  }
+  if( this->m_NumberOfSubTransforms == 0 )
+  {
+    itkExceptionMacro( << "No sub transforms have been set." );
+  }
+
+  /** Count the points per sub transform. */
+  std::vector< SizeValueType > offsets( this->m_NumberOfSubTransforms + 1, 0 );
+  batch.SubTransformIndices.resize( numberOfPoints );
+  for( SizeValueType i = 0; i < numberOfPoints; ++i )
+  {
+    const unsigned int subt = this->GetSubTransformIndex( ( *batch.Points )[ i ] );
+    batch.SubTransformIndices[ i ] = subt;
+    ++offsets[ subt + 1 ];
+  }
+  for( unsigned int t = 0; t < this->m_NumberOfSubTransforms; ++t )
+  {
+    offsets[ t + 1 ] += offsets[ t ];
+  }
+
+  /** Sort the points by sub transform. Within a sub transform the points
+   * keep their order, which is usually spatially coherent.
+   */
+  batch.Order.resize( numberOfPoints );
+  for( SizeValueType i = 0; i < numberOfPoints; ++i )
+  {
+    batch.Order[ offsets[ batch.SubTransformIndices[ i ] ]++ ] = i;
+  }
+
+  /** Evaluate the sorted points by multiple threads. */
+  this->m_Threader->SetSingleMethod( this->BatchThreaderCallback, &batch );
+  this->m_Threader->SingleMethodExecute();
+
+} // end EvaluateBatch()
+
+
+/**
+ * ********************* BatchThreaderCallback ****************************
+ */
+
+template< class TScalarType, unsigned int NInputDimensions, unsigned int NOutputDimensions >
+ITK_THREAD_RETURN_TYPE
+StackTransform< TScalarType, NInputDimensions, NOutputDimensions >
+::BatchThreaderCallback( void * arg )
+{
+  /** Get the current thread id and user data. */
+  ThreaderInfoType * infoStruct = static_cast< ThreaderInfoType * >( arg );
+  ThreadIdType       threadID   = infoStruct->ThreadID;
+  const BatchType *  batch      = static_cast< const BatchType * >( infoStruct->UserData );
+  const Self *       self       = batch->Transform;
+
+  /** Distribute the sorted points evenly over the threads. A thread thus
+   * gets one or a few consecutive sub transforms.
+   */
+  const SizeValueType numberOfThreads = self->m_Threader->GetNumberOfThreads();
+  const SizeValueType numberOfPoints  = batch->Order.size();
+  const SizeValueType pointsPerThread
+    = ( numberOfPoints + numberOfThreads - 1 ) / numberOfThreads;
+  const SizeValueType begin = vnl_math_min( threadID * pointsPerThread, numberOfPoints );
+  const SizeValueType end   = vnl_math_min( begin + pointsPerThread, numberOfPoints );
+
+  self->ThreadedEvaluateBatch( *batch, begin, end );
+
+  return ITK_THREAD_RETURN_VALUE;
+
+} // end BatchThreaderCallback()
+
+
+/**
+ * ********************* ThreadedEvaluateBatch ****************************
+ */
+
+template< class TScalarType, unsigned int NInputDimensions, unsigned int NOutputDimensions >
+void
+StackTransform< TScalarType, NInputDimensions, NOutputDimensions >
+::ThreadedEvaluateBatch( const BatchType & batch,
+  const SizeValueType begin, const SizeValueType end ) const
+{
+  SubTransformJacobianType subjac;
+  for( SizeValueType k = begin; k < end; ++k )
+  {
+    const SizeValueType    i    = batch.Order[ k ];
+    const unsigned int     subt = batch.SubTransformIndices[ i ];
+    const InputPointType & ipp  = ( *batch.Points )[ i ];
+
+    if( batch.TransformedPoints != 0 )
+    {
+      ( *batch.TransformedPoints )[ i ] = this->TransformPointWithSubTransform( subt, ipp );
+    }
+    if( batch.Jacobians != 0 )
+    {
+      this->GetJacobianWithSubTransform( subt, ipp, subjac,
+        ( *batch.Jacobians )[ i ], ( *batch.NonZeroJacobianIndices )[ i ] );
+    }
+  }
+
+} // end ThreadedEvaluateBatch()
 
 
 /**
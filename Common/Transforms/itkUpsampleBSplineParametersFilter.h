@@ -20,6 +20,9 @@
 
 #include "itkObject.h"
 #include "itkArray.h"
+#include "itkMultiThreader.h"
+
+#include <vector>
 
 namespace itk
 {
@@ -33,6 +36,21 @@ namespace itk
  * on a denser grid. Therefore, the user needs to supply the old B-spline grid
  * (region, spacing, origin, direction), and the required B-spline grid.
  *
+ * By default, the deformation is sampled at the new control points and the
+ * new coefficients are computed with a B-spline decomposition.
+ *
+ * Optionally, set UseDyadicRefinement to compute the new coefficients
+ * directly and exactly by dyadic subdivision, which is separable and
+ * multi-threaded. This is possible when the grid spacing halves, or stays
+ * the same, in every dimension, and the new control points coincide with the
+ * old control points or lie halfway between them, since the spline space of
+ * the required grid then contains the current spline. This is the common case
+ * between resolutions, but it requires an odd spline order and a required
+ * grid that lies within the support of the current one; otherwise the general
+ * method is used. The coefficients differ from those of the general method
+ * near the border of the grid, and for spline order 1, since the general
+ * method evaluates the current coefficients as a cubic spline.
+ *
  */
 
 template< class TArray, class TImage >
@@ -94,6 +112,18 @@ public:
   /** Set the B-spline order. */
   itkSetMacro( BSplineOrder, unsigned int );
 
+  /** Use dyadic subdivision when the grids allow it. Default: false. */
+  itkSetMacro( UseDyadicRefinement, bool );
+  itkGetConstMacro( UseDyadicRefinement, bool );
+  itkBooleanMacro( UseDyadicRefinement );
+
+  /** Set the number of threads. */
+  void SetNumberOfThreads( ThreadIdType numberOfThreads )
+  {
+    this->m_Threader->SetNumberOfThreads( numberOfThreads );
+  }
+
+
   /** Compute the output parameter array. */
   virtual void UpsampleParameters( const ArrayType & param_in,
     ArrayType & param_out );
@@ -112,6 +142,29 @@ protected:
   /** Function that checks if upsampling is required. */
   virtual bool DoUpsampling( void );
 
+  /** Function that checks if the required grid is a dyadic refinement of
+   * the current grid. If so, it sets up the subdivision weights.
+   */
+  virtual bool DoDyadicRefinement( void );
+
+  /** Compute the output parameters by dyadic subdivision. */
+  virtual void RefineParameters( const ArrayType & param_in,
+    ArrayType & param_out );
+
+  /** Compute the output parameters by sampling and decomposition. */
+  virtual void ResampleParameters( const ArrayType & param_in,
+    ArrayType & param_out );
+
+  /** Typedefs for multi-threading. */
+  typedef itk::MultiThreader             ThreaderType;
+  typedef ThreaderType::ThreadInfoStruct ThreaderInfoType;
+
+  /** Refinement threader callback function. */
+  static ITK_THREAD_RETURN_TYPE RefinementThreaderCallback( void * arg );
+
+  /** Refine the lines [begin, end) of the current subdivision pass. */
+  void ThreadedRefineLines( const SizeValueType begin, const SizeValueType end ) const;
+
 private:
 
   UpsampleBSplineParametersFilter( const Self & ); // purposely not implemented
@@ -127,6 +180,35 @@ private:
   DirectionType m_RequiredGridDirection;
   RegionType    m_RequiredGridRegion;
   unsigned int  m_BSplineOrder;
+  bool          m_UseDyadicRefinement;
+
+  ThreaderType::Pointer m_Threader;
+
+  /** The subdivision weights of one dimension. Fine node j is a weighted
+   * sum of the NumberOfTaps[ j ] current coefficients starting at
+   * FirstIndex[ j ], with weights Weights[ j * MaximumNumberOfTaps + t ].
+   */
+  struct RefinementKernelType
+  {
+    std::vector< SizeValueType > FirstIndex;
+    std::vector< unsigned int >  NumberOfTaps;
+    std::vector< ValueType >     Weights;
+    unsigned int                 MaximumNumberOfTaps;
+  };
+  RefinementKernelType m_RefinementKernels[ ImageType::ImageDimension ];
+
+  /** The state of the current subdivision pass, shared with the threads. */
+  struct RefinementPassType
+  {
+    const ValueType *            Input;
+    ValueType *                  Output;
+    const RefinementKernelType * Kernel;
+    SizeValueType                InputLength;
+    SizeValueType                OutputLength;
+    SizeValueType                Stride;
+    SizeValueType                NumberOfLines;
+  };
+  RefinementPassType m_RefinementPass;
 
 };
 
@@ -21,8 +21,11 @@
 #include "itkUpsampleBSplineParametersFilter.h"
 
 #include "itkBSplineResampleImageFunction.h"
-#include "itkBSplineDecompositionImageFilter.h"
+#include "itkMultiOrderBSplineDecompositionImageFilter.h"
 #include "itkResampleImageFilter.h"
+#include "vnl/vnl_math.h"
+
+#include <cmath>
 
 namespace itk
 {
@@ -35,7 +38,13 @@ template< class TArray, class TImage >
 UpsampleBSplineParametersFilter< TArray, TImage >
 ::UpsampleBSplineParametersFilter()
 {
-  this->m_BSplineOrder = 3;
+  this->m_BSplineOrder        = 3;
+  this->m_UseDyadicRefinement = false;
+
+  this->m_Threader = ThreaderType::New();
+#if ITK_VERSION_MAJOR < 5
+  this->m_Threader->SetUseThreadPool( false );
+#endif
 
   // Initialize grid settings.
   this->m_CurrentGridOrigin.Fill( 0.0 );
@@ -44,6 +53,11 @@ UpsampleBSplineParametersFilter< TArray, TImage >
   this->m_RequiredGridOrigin.Fill( 0.0 );
   this->m_RequiredGridSpacing.Fill( 0.0 );
   this->m_RequiredGridDirection.Fill( 0.0 );
+
+  for( unsigned int d = 0; d < Dimension; ++d )
+  {
+    this->m_RefinementKernels[ d ].MaximumNumberOfTaps = 0;
+  }
 } // end Constructor()
 
 
@@ -64,12 +78,35 @@ UpsampleBSplineParametersFilter< TArray, TImage >
     return;
   }
 
+  /** Use the exact and fast dyadic subdivision when possible. */
+  if( this->m_UseDyadicRefinement && this->DoDyadicRefinement() )
+  {
+    this->RefineParameters( parameters_in, parameters_out );
+  }
+  else
+  {
+    this->ResampleParameters( parameters_in, parameters_out );
+  }
+
+} // end UpsampleParameters()
+
+
+/**
+ * ******************* ResampleParameters *******************
+ */
+
+template< class TArray, class TImage >
+void
+UpsampleBSplineParametersFilter< TArray, TImage >
+::ResampleParameters( const ArrayType & parameters_in,
+  ArrayType & parameters_out )
+{
   /** Typedefs. */
   typedef itk::ResampleImageFilter<
     ImageType, ImageType >                        UpsampleFilterType;
   typedef itk::BSplineResampleImageFunction<
     ImageType, ValueType >                        CoefficientUpsampleFunctionType;
-  typedef itk::BSplineDecompositionImageFilter<
+  typedef itk::MultiOrderBSplineDecompositionImageFilter<
     ImageType, ImageType >                        DecompositionFilterType;
 
   /** Get the number of parameters. */
@@ -136,9 +173,6 @@ UpsampleBSplineParametersFilter< TArray, TImage >
     try
     {
       decompositionFilter->UpdateLargestPossibleRegion();
-      // \todo: the decomposition filter could be multi-threaded
-      // by deriving it from the RecursiveSeparableImageFilter,
-      // similar to the SmoothingRecursiveGaussianImageFilter.
     }
     catch( itk::ExceptionObject & excp )
     {
@@ -161,7 +195,280 @@ UpsampleBSplineParametersFilter< TArray, TImage >
 
   } // end for dimension loop
 
-} // end UpsampleParameters()
+} // end ResampleParameters()
+
+
+/**
+ * ******************* DoDyadicRefinement *******************
+ */
+
+template< class TArray, class TImage >
+bool
+UpsampleBSplineParametersFilter< TArray, TImage >
+::DoDyadicRefinement( void )
+{
+  const double tolerance = 1e-4;
+
+  /** The grids should have the same orientation. */
+  for( unsigned int i = 0; i < Dimension; ++i )
+  {
+    for( unsigned int j = 0; j < Dimension; ++j )
+    {
+      if( std::abs( this->m_CurrentGridDirection[ i ][ j ]
+        - this->m_RequiredGridDirection[ i ][ j ] ) > tolerance )
+      {
+        return false;
+      }
+    }
+  }
+
+  /** The origin of the required grid in continuous indices of the current grid. */
+  const typename DirectionType::InternalMatrixType inverseDirection
+    = this->m_CurrentGridDirection.GetInverse();
+  OriginType originShift;
+  for( unsigned int d = 0; d < Dimension; ++d )
+  {
+    originShift[ d ] = 0.0;
+    for( unsigned int e = 0; e < Dimension; ++e )
+    {
+      originShift[ d ] += inverseDirection[ d ][ e ]
+        * ( this->m_RequiredGridOrigin[ e ] - this->m_CurrentGridOrigin[ e ] );
+    }
+    originShift[ d ] /= this->m_CurrentGridSpacing[ d ];
+  }
+
+  /** The subdivision mask of a B-spline of odd order n is given by the
+   * binomial coefficients ( n + 1 over l ) / 2^n, l = 0, ..., n + 1.
+   */
+  const unsigned int n = this->m_BSplineOrder;
+  const long         h = ( n + 1 ) / 2;
+  std::vector< ValueType > mask( n + 2 );
+  mask[ 0 ] = 1.0 / std::pow( 2.0, static_cast< double >( n ) );
+  for( unsigned int l = 1; l < n + 2; ++l )
+  {
+    mask[ l ] = mask[ l - 1 ] * ( n + 2 - l ) / l;
+  }
+
+  for( unsigned int d = 0; d < Dimension; ++d )
+  {
+    /** The spacing should halve, or stay the same. */
+    const double ratio = this->m_CurrentGridSpacing[ d ] / this->m_RequiredGridSpacing[ d ];
+    long         factor = 0;
+    if( std::abs( ratio - 2.0 ) < tolerance )
+    {
+      factor = 2;
+      if( n % 2 == 0 || n > 5 )
+      {
+        return false;
+      }
+    }
+    else if( std::abs( ratio - 1.0 ) < tolerance )
+    {
+      factor = 1;
+    }
+    else
+    {
+      return false;
+    }
+
+    /** The required nodes should lie on the current nodes or halfway between them.
+     * Node j of the required region is then at half-index offset + j of the
+     * current region, in units of the required spacing.
+     */
+    const double shift        = factor * originShift[ d ];
+    const long   roundedShift = static_cast< long >( std::floor( shift + 0.5 ) );
+    if( std::abs( shift - roundedShift ) > tolerance )
+    {
+      return false;
+    }
+    const long offset = roundedShift
+      + static_cast< long >( this->m_RequiredGridRegion.GetIndex()[ d ] )
+      - factor * static_cast< long >( this->m_CurrentGridRegion.GetIndex()[ d ] );
+
+    /** Compute the weights of every required node. */
+    const long currentSize  = static_cast< long >( this->m_CurrentGridRegion.GetSize()[ d ] );
+    const long requiredSize = static_cast< long >( this->m_RequiredGridRegion.GetSize()[ d ] );
+    RefinementKernelType & kernel = this->m_RefinementKernels[ d ];
+    kernel.MaximumNumberOfTaps = factor == 2 ? ( n + 3 ) / 2 : 1;
+    kernel.FirstIndex.assign( requiredSize, 0 );
+    kernel.NumberOfTaps.assign( requiredSize, 0 );
+    kernel.Weights.assign( requiredSize * kernel.MaximumNumberOfTaps, 0.0 );
+    for( long j = 0; j < requiredSize; ++j )
+    {
+      const long m = offset + j;
+      long       first = m;
+      long       last  = m;
+      if( factor == 2 )
+      {
+        /** Floor and ceil of a division by two, also for negative numbers. */
+        const long low  = m + h - static_cast< long >( n ) - 1;
+        const long high = m + h;
+        first = low >= 0 ? ( low + 1 ) / 2 : -( ( -low ) / 2 );
+        last  = high >= 0 ? high / 2 : -( ( -high + 1 ) / 2 );
+      }
+
+      /** The required grid should lie within the support of the current grid. */
+      if( first < 0 || last >= currentSize )
+      {
+        return false;
+      }
+
+      kernel.FirstIndex[ j ]   = static_cast< SizeValueType >( first );
+      kernel.NumberOfTaps[ j ] = static_cast< unsigned int >( last - first + 1 );
+      for( long k = first; k <= last; ++k )
+      {
+        kernel.Weights[ j * kernel.MaximumNumberOfTaps + ( k - first ) ]
+          = factor == 2 ? mask[ m - 2 * k + h ] : 1.0;
+      }
+    }
+  }
+
+  return true;
+
+} // end DoDyadicRefinement()
+
+
+/**
+ * ******************* RefineParameters *******************
+ */
+
+template< class TArray, class TImage >
+void
+UpsampleBSplineParametersFilter< TArray, TImage >
+::RefineParameters( const ArrayType & parameters_in,
+  ArrayType & parameters_out )
+{
+  /** Get the number of parameters. */
+  const SizeValueType currentNumberOfPixels
+    = this->m_CurrentGridRegion.GetNumberOfPixels();
+  const SizeValueType requiredNumberOfPixels
+    = this->m_RequiredGridRegion.GetNumberOfPixels();
+  parameters_out.SetSize( requiredNumberOfPixels * Dimension );
+
+  /** Each pass refines one dimension, so the intermediate results have the
+   * required size in the dimensions before, and the current size in the
+   * dimensions after the one that is processed.
+   */
+  std::vector< ValueType > buffers[ 2 ];
+  this->m_Threader->SetSingleMethod( this->RefinementThreaderCallback, this );
+
+  for( unsigned int j = 0; j < Dimension; ++j )
+  {
+    const ValueType * input = parameters_in.data_block() + currentNumberOfPixels * j;
+
+    for( unsigned int d = 0; d < Dimension; ++d )
+    {
+      SizeValueType stride        = 1;
+      SizeValueType numberOfLines = this->m_RequiredGridRegion.GetSize()[ d ];
+      SizeValueType passSize      = 1;
+      for( unsigned int e = 0; e < Dimension; ++e )
+      {
+        if( e < d )
+        {
+          stride *= this->m_RequiredGridRegion.GetSize()[ e ];
+        }
+        else if( e > d )
+        {
+          numberOfLines *= this->m_CurrentGridRegion.GetSize()[ e ];
+        }
+        passSize *= e <= d
+          ? this->m_RequiredGridRegion.GetSize()[ e ]
+          : this->m_CurrentGridRegion.GetSize()[ e ];
+      }
+
+      ValueType * output = parameters_out.data_block() + requiredNumberOfPixels * j;
+      if( d + 1 < Dimension )
+      {
+        buffers[ d % 2 ].resize( passSize );
+        output = &buffers[ d % 2 ][ 0 ];
+      }
+
+      this->m_RefinementPass.Input         = input;
+      this->m_RefinementPass.Output        = output;
+      this->m_RefinementPass.Kernel        = &this->m_RefinementKernels[ d ];
+      this->m_RefinementPass.InputLength   = this->m_CurrentGridRegion.GetSize()[ d ];
+      this->m_RefinementPass.OutputLength  = this->m_RequiredGridRegion.GetSize()[ d ];
+      this->m_RefinementPass.Stride        = stride;
+      this->m_RefinementPass.NumberOfLines = numberOfLines;
+      this->m_Threader->SingleMethodExecute();
+
+      input = output;
+    }
+  }
+
+} // end RefineParameters()
+
+
+/**
+ * ******************* RefinementThreaderCallback *******************
+ */
+
+template< class TArray, class TImage >
+ITK_THREAD_RETURN_TYPE
+UpsampleBSplineParametersFilter< TArray, TImage >
+::RefinementThreaderCallback( void * arg )
+{
+  /** Get the current thread id and user data. */
+  ThreaderInfoType * infoStruct = static_cast< ThreaderInfoType * >( arg );
+  ThreadIdType       threadID   = infoStruct->ThreadID;
+  const Self *       self       = static_cast< const Self * >( infoStruct->UserData );
+
+  /** Distribute the lines evenly over the threads. */
+  const SizeValueType numberOfThreads = self->m_Threader->GetNumberOfThreads();
+  const SizeValueType numberOfLines   = self->m_RefinementPass.NumberOfLines;
+  const SizeValueType linesPerThread
+    = ( numberOfLines + numberOfThreads - 1 ) / numberOfThreads;
+  const SizeValueType begin = vnl_math_min( threadID * linesPerThread, numberOfLines );
+  const SizeValueType end   = vnl_math_min( begin + linesPerThread, numberOfLines );
+
+  self->ThreadedRefineLines( begin, end );
+
+  return ITK_THREAD_RETURN_VALUE;
+
+} // end RefinementThreaderCallback()
+
+
+/**
+ * ******************* ThreadedRefineLines *******************
+ */
+
+template< class TArray, class TImage >
+void
+UpsampleBSplineParametersFilter< TArray, TImage >
+::ThreadedRefineLines( const SizeValueType begin, const SizeValueType end ) const
+{
+  const RefinementPassType &   pass   = this->m_RefinementPass;
+  const RefinementKernelType & kernel = *pass.Kernel;
+  const SizeValueType          stride = pass.Stride;
+
+  /** Line q is required node q % OutputLength of the dimension that is
+   * processed, for all stride values of the dimensions before it.
+   */
+  for( SizeValueType q = begin; q < end; ++q )
+  {
+    const SizeValueType outer = q / pass.OutputLength;
+    const SizeValueType node  = q % pass.OutputLength;
+
+    ValueType *       out = pass.Output + q * stride;
+    const ValueType * in  = pass.Input
+      + ( outer * pass.InputLength + kernel.FirstIndex[ node ] ) * stride;
+    const ValueType * weights = &kernel.Weights[ node * kernel.MaximumNumberOfTaps ];
+
+    for( SizeValueType i = 0; i < stride; ++i )
+    {
+      out[ i ] = weights[ 0 ] * in[ i ];
+    }
+    for( unsigned int t = 1; t < kernel.NumberOfTaps[ node ]; ++t )
+    {
+      in += stride;
+      for( SizeValueType i = 0; i < stride; ++i )
+      {
+        out[ i ] += weights[ t ] * in[ i ];
+      }
+    }
+  }
+
+} // end ThreadedRefineLines()
 
 
 /**
@@ -205,6 +512,7 @@ UpsampleBSplineParametersFilter< TArray, TImage >
   os << indent << "RequiredGridRegion: "  << this->m_RequiredGridRegion << std::endl;
 
   os << indent << "BSplineOrder: " << this->m_BSplineOrder << std::endl;
+  os << indent << "UseDyadicRefinement: " << this->m_UseDyadicRefinement << std::endl;
 
 } // end PrintSelf()
 
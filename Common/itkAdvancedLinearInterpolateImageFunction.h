@@ -94,7 +94,8 @@ public:
   itkStaticConstMacro( ImageDimension, unsigned int, Superclass::ImageDimension );
 
   /** Index typedef support. */
-  typedef typename Superclass::IndexType IndexType;
+  typedef typename Superclass::IndexType       IndexType;
+  typedef typename InputImageType::OffsetValueType OffsetValueType;
 
   /** ContinuousIndex typedef support. */
   typedef typename Superclass::ContinuousIndexType ContinuousIndexType;
@@ -118,6 +119,26 @@ public:
       Dispatch< ImageDimension >(), x, value, deriv );
   }
 
+  /** Method to compute both the value and the derivative at many continuous
+   * indices at once, for 2D and 3D images with a scalar pixel type.
+   * The points are processed in blocks. For each block, the mirrored
+   * positions, the interpolation weights and the buffer offsets are first
+   * computed in branch-free loops over the points, which the compiler can
+   * vectorize. Then the corner values are read directly from the image
+   * buffer. Points outside the image are mirrored, like in
+   * EvaluateValueAndDerivativeAtContinuousIndex(), and then clamped to
+   * the image, so that no pixel outside the buffer is ever read.
+   */
+  void EvaluateValueAndDerivativeAtContinuousIndices(
+    const ContinuousIndexType * x,
+    OutputType * values,
+    CovariantVectorType * derivs,
+    const SizeValueType numberOfPoints ) const
+  {
+    return this->EvaluateValuesAndDerivativesOptimized(
+      Dispatch< ImageDimension >(), x, values, derivs, numberOfPoints );
+  }
+
 
 protected:
 
@@ -159,6 +180,51 @@ private:
   }
 
 
+  /** Method to compute the values and derivatives of a batch. 2D specialization. */
+  void EvaluateValuesAndDerivativesOptimized(
+    const Dispatch< 2 > &,
+    const ContinuousIndexType * x,
+    OutputType * values,
+    CovariantVectorType * derivs,
+    const SizeValueType numberOfPoints ) const;
+
+  /** Method to compute the values and derivatives of a batch. 3D specialization. */
+  void EvaluateValuesAndDerivativesOptimized(
+    const Dispatch< 3 > &,
+    const ContinuousIndexType * x,
+    OutputType * values,
+    CovariantVectorType * derivs,
+    const SizeValueType numberOfPoints ) const;
+
+  /** Method to compute the values and derivatives of a batch. Generic. */
+  void EvaluateValuesAndDerivativesOptimized(
+    const DispatchBase &,
+    const ContinuousIndexType * x,
+    OutputType * values,
+    CovariantVectorType * derivs,
+    const SizeValueType numberOfPoints ) const
+  {
+    for( SizeValueType i = 0; i < numberOfPoints; ++i )
+    {
+      this->EvaluateValueAndDerivativeUnOptimized( x[ i ], values[ i ], derivs[ i ] );
+    }
+  }
+
+
+  /** The number of points that is processed per block in the batch methods. */
+  itkStaticConstMacro( BatchBlockSize, unsigned int, 64 );
+
+  /** Compute the mirrored and clamped positions of a block of points, the
+   * interpolation weights, the derivative scales, and the buffer offsets of
+   * the base corners. Shared by the 2D and 3D batch methods.
+   */
+  void ComputeBatchWeights(
+    const ContinuousIndexType * x,
+    const unsigned int numberOfPoints,
+    double dist[][ BatchBlockSize ],
+    double scale[][ BatchBlockSize ],
+    OffsetValueType * offsets ) const;
+
   /** Method to compute both the value and the derivative. Generic. */
   inline void EvaluateValueAndDerivativeUnOptimized(
     const ContinuousIndexType & x,
@@ -22,6 +22,8 @@
 
 #include "vnl/vnl_math.h"
 
+#include <cmath>
+
 namespace itk
 {
 
@@ -269,6 +271,200 @@ AdvancedLinearInterpolateImageFunction< TInputImage, TCoordRep >
 } // end EvaluateValueAndDerivativeOptimized()
 
 
+/**
+ * ***************** ComputeBatchWeights ***********************
+ */
+
+template< class TInputImage, class TCoordRep >
+void
+AdvancedLinearInterpolateImageFunction< TInputImage, TCoordRep >
+::ComputeBatchWeights(
+  const ContinuousIndexType * x,
+  const unsigned int numberOfPoints,
+  double dist[][ BatchBlockSize ],
+  double scale[][ BatchBlockSize ],
+  OffsetValueType * offsets ) const
+{
+  const InputImageType *        inputImage  = this->GetInputImage();
+  const InputImageSpacingType & spacing     = inputImage->GetSpacing();
+  const OffsetValueType *       offsetTable = inputImage->GetOffsetTable();
+  const IndexType &             bufferStart = inputImage->GetBufferedRegion().GetIndex();
+
+  for( unsigned int p = 0; p < numberOfPoints; ++p )
+  {
+    offsets[ p ] = 0;
+  }
+
+  for( unsigned int dim = 0; dim < ImageDimension; ++dim )
+  {
+    const double start    = static_cast< double >( this->m_StartIndex[ dim ] );
+    const double end      = static_cast< double >( this->m_EndIndex[ dim ] );
+    const double last     = vnl_math_max( start, end - 0.000001 );
+    const double invSpace = 1.0 / spacing[ dim ];
+    const double stride   = static_cast< double >( offsetTable[ dim ] );
+    const double base0    = static_cast< double >( bufferStart[ dim ] );
+    double *     distDim  = dist[ dim ];
+    double *     scaleDim = scale[ dim ];
+
+    /** Mirror at the image edges, and clamp what is mirrored outside again. */
+    for( unsigned int p = 0; p < numberOfPoints; ++p )
+    {
+      const double xi     = x[ p ][ dim ];
+      const bool   below  = xi < start;
+      const bool   above  = xi > end;
+      double       xm     = below ? 2.0 * start - xi : ( above ? 2.0 * end - xi : xi );
+      xm                  = vnl_math_min( vnl_math_max( xm, start ), last );
+      const double lower  = std::floor( xm );
+      distDim[ p ]        = xm - lower;
+      scaleDim[ p ]       = ( below || above ) ? -invSpace : invSpace;
+      offsets[ p ]       += static_cast< OffsetValueType >( ( lower - base0 ) * stride );
+    }
+  }
+
+} // end ComputeBatchWeights()
+
+
+/**
+ * ***************** EvaluateValuesAndDerivativesOptimized ***********************
+ */
+
+template< class TInputImage, class TCoordRep >
+void
+AdvancedLinearInterpolateImageFunction< TInputImage, TCoordRep >
+::EvaluateValuesAndDerivativesOptimized(
+  const Dispatch< 2 > &,
+  const ContinuousIndexType * x,
+  OutputType * values,
+  CovariantVectorType * derivs,
+  const SizeValueType numberOfPoints ) const
+{
+  const InputImageType *          inputImage = this->GetInputImage();
+  const InputPixelType *          buffer     = inputImage->GetBufferPointer();
+  const typename InputImageType::DirectionType & direction = inputImage->GetDirection();
+
+  /** The offsets to the other corners. Images of size 1 do not step. */
+  const typename InputImageType::SizeType & size = inputImage->GetBufferedRegion().GetSize();
+  const OffsetValueType * offsetTable = inputImage->GetOffsetTable();
+  const OffsetValueType   s0 = size[ 0 ] > 1 ? offsetTable[ 0 ] : 0;
+  const OffsetValueType   s1 = size[ 1 ] > 1 ? offsetTable[ 1 ] : 0;
+
+  double          dist[ ImageDimension ][ BatchBlockSize ];
+  double          scale[ ImageDimension ][ BatchBlockSize ];
+  OffsetValueType offsets[ BatchBlockSize ];
+
+  for( SizeValueType first = 0; first < numberOfPoints; first += BatchBlockSize )
+  {
+    const unsigned int m = static_cast< unsigned int >(
+      vnl_math_min( static_cast< SizeValueType >( BatchBlockSize ), numberOfPoints - first ) );
+    this->ComputeBatchWeights( x + first, m, dist, scale, offsets );
+
+    for( unsigned int p = 0; p < m; ++p )
+    {
+      const InputPixelType * corner = buffer + offsets[ p ];
+      const double val00 = static_cast< double >( corner[ 0 ] );
+      const double val10 = static_cast< double >( corner[ s0 ] );
+      const double val01 = static_cast< double >( corner[ s1 ] );
+      const double val11 = static_cast< double >( corner[ s0 + s1 ] );
+
+      const double d0 = dist[ 0 ][ p ];
+      const double d1 = dist[ 1 ][ p ];
+      const double i0 = 1.0 - d0;
+      const double i1 = 1.0 - d1;
+
+      values[ first + p ] = static_cast< OutputType >(
+        i1 * ( i0 * val00 + d0 * val10 ) + d1 * ( i0 * val01 + d0 * val11 ) );
+
+      /** The derivative in index space, scaled to physical space and oriented. */
+      const double g0 = scale[ 0 ][ p ] * ( i1 * ( val10 - val00 ) + d1 * ( val11 - val01 ) );
+      const double g1 = scale[ 1 ][ p ] * ( i0 * ( val01 - val00 ) + d0 * ( val11 - val10 ) );
+      CovariantVectorType & deriv = derivs[ first + p ];
+      deriv[ 0 ] = direction[ 0 ][ 0 ] * g0 + direction[ 0 ][ 1 ] * g1;
+      deriv[ 1 ] = direction[ 1 ][ 0 ] * g0 + direction[ 1 ][ 1 ] * g1;
+    }
+  }
+
+} // end EvaluateValuesAndDerivativesOptimized()
+
+
+/**
+ * ***************** EvaluateValuesAndDerivativesOptimized ***********************
+ */
+
+template< class TInputImage, class TCoordRep >
+void
+AdvancedLinearInterpolateImageFunction< TInputImage, TCoordRep >
+::EvaluateValuesAndDerivativesOptimized(
+  const Dispatch< 3 > &,
+  const ContinuousIndexType * x,
+  OutputType * values,
+  CovariantVectorType * derivs,
+  const SizeValueType numberOfPoints ) const
+{
+  const InputImageType *          inputImage = this->GetInputImage();
+  const InputPixelType *          buffer     = inputImage->GetBufferPointer();
+  const typename InputImageType::DirectionType & direction = inputImage->GetDirection();
+
+  /** The offsets to the other corners. Images of size 1 do not step. */
+  const typename InputImageType::SizeType & size = inputImage->GetBufferedRegion().GetSize();
+  const OffsetValueType * offsetTable = inputImage->GetOffsetTable();
+  const OffsetValueType   s0 = size[ 0 ] > 1 ? offsetTable[ 0 ] : 0;
+  const OffsetValueType   s1 = size[ 1 ] > 1 ? offsetTable[ 1 ] : 0;
+  const OffsetValueType   s2 = size[ 2 ] > 1 ? offsetTable[ 2 ] : 0;
+
+  double          dist[ ImageDimension ][ BatchBlockSize ];
+  double          scale[ ImageDimension ][ BatchBlockSize ];
+  OffsetValueType offsets[ BatchBlockSize ];
+
+  for( SizeValueType first = 0; first < numberOfPoints; first += BatchBlockSize )
+  {
+    const unsigned int m = static_cast< unsigned int >(
+      vnl_math_min( static_cast< SizeValueType >( BatchBlockSize ), numberOfPoints - first ) );
+    this->ComputeBatchWeights( x + first, m, dist, scale, offsets );
+
+    for( unsigned int p = 0; p < m; ++p )
+    {
+      const InputPixelType * corner = buffer + offsets[ p ];
+      const double val000 = static_cast< double >( corner[ 0 ] );
+      const double val100 = static_cast< double >( corner[ s0 ] );
+      const double val010 = static_cast< double >( corner[ s1 ] );
+      const double val110 = static_cast< double >( corner[ s0 + s1 ] );
+      const double val001 = static_cast< double >( corner[ s2 ] );
+      const double val101 = static_cast< double >( corner[ s0 + s2 ] );
+      const double val011 = static_cast< double >( corner[ s1 + s2 ] );
+      const double val111 = static_cast< double >( corner[ s0 + s1 + s2 ] );
+
+      const double d0 = dist[ 0 ][ p ];
+      const double d1 = dist[ 1 ][ p ];
+      const double d2 = dist[ 2 ][ p ];
+      const double i0 = 1.0 - d0;
+      const double i1 = 1.0 - d1;
+      const double i2 = 1.0 - d2;
+
+      /** Interpolate along x first, and reuse the results. */
+      const double v00 = i0 * val000 + d0 * val100;
+      const double v10 = i0 * val010 + d0 * val110;
+      const double v01 = i0 * val001 + d0 * val101;
+      const double v11 = i0 * val011 + d0 * val111;
+      values[ first + p ] = static_cast< OutputType >(
+        i2 * ( i1 * v00 + d1 * v10 ) + d2 * ( i1 * v01 + d1 * v11 ) );
+
+      /** The derivative in index space, scaled to physical space and oriented. */
+      const double g0 = scale[ 0 ][ p ]
+        * ( i1 * i2 * ( val100 - val000 ) + d1 * i2 * ( val110 - val010 )
+        + i1 * d2 * ( val101 - val001 ) + d1 * d2 * ( val111 - val011 ) );
+      const double g1 = scale[ 1 ][ p ] * ( i2 * ( v10 - v00 ) + d2 * ( v11 - v01 ) );
+      const double g2 = scale[ 2 ][ p ] * ( i1 * ( v01 - v00 ) + d1 * ( v11 - v10 ) );
+      CovariantVectorType & deriv = derivs[ first + p ];
+      for( unsigned int i = 0; i < 3; ++i )
+      {
+        deriv[ i ] = direction[ i ][ 0 ] * g0 + direction[ i ][ 1 ] * g1 + direction[ i ][ 2 ] * g2;
+      }
+    }
+  }
+
+} // end EvaluateValuesAndDerivativesOptimized()
+
+
 } // end namespace itk
 
 #endif
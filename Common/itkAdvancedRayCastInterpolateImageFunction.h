@@ -144,6 +144,19 @@ public:
   virtual OutputType EvaluateAtContinuousIndex(
     const ContinuousIndexType & index ) const;
 
+  /** Integrate the image along the ray from a point towards an already
+   * transformed focal point.
+   *
+   * This is the thread-safe kernel of Evaluate(). Callers that cast many
+   * rays for the same transform, such as the RayCastProjectionImageFilter,
+   * compute the transformed focal point once and call this method per ray.
+   */
+  OutputType EvaluateRay( const PointType & point,
+    const OutputPointType & transformedFocalPoint ) const;
+
+  /** Get the focal point mapped by the current transform. */
+  OutputPointType GetTransformedFocalPoint( void ) const;
+
   /** Connect the Transform. */
   itkSetObjectMacro( Transform, TransformType );
   /** Get a pointer to the Transform.  */
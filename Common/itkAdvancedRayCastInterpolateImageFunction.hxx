@@ -1556,10 +1556,22 @@ typename AdvancedRayCastInterpolateImageFunction< TInputImage, TCoordRep >
 AdvancedRayCastInterpolateImageFunction< TInputImage, TCoordRep >
 ::Evaluate( const PointType & point ) const
 {
-  double integral = 0;
+  return this->EvaluateRay( point, this->GetTransformedFocalPoint() );
+}
+
+
+/* -----------------------------------------------------------------------
+   Evaluate along a ray towards a transformed focal point
+   ----------------------------------------------------------------------- */
 
-  OutputPointType transformedFocalPoint
-    = m_Transform->TransformPoint( m_FocalPoint );
+template< class TInputImage, class TCoordRep >
+typename AdvancedRayCastInterpolateImageFunction< TInputImage, TCoordRep >
+::OutputType
+AdvancedRayCastInterpolateImageFunction< TInputImage, TCoordRep >
+::EvaluateRay( const PointType & point,
+  const OutputPointType & transformedFocalPoint ) const
+{
+  double integral = 0;
 
   DirectionType direction = transformedFocalPoint - point;
 
@@ -1575,6 +1587,20 @@ AdvancedRayCastInterpolateImageFunction< TInputImage, TCoordRep >
 }
 
 
+/* -----------------------------------------------------------------------
+   GetTransformedFocalPoint
+   ----------------------------------------------------------------------- */
+
+template< class TInputImage, class TCoordRep >
+typename AdvancedRayCastInterpolateImageFunction< TInputImage, TCoordRep >
+::OutputPointType
+AdvancedRayCastInterpolateImageFunction< TInputImage, TCoordRep >
+::GetTransformedFocalPoint( void ) const
+{
+  return m_Transform->TransformPoint( m_FocalPoint );
+}
+
+
 template< class TInputImage, class TCoordRep >
 typename AdvancedRayCastInterpolateImageFunction< TInputImage, TCoordRep >
 ::OutputType
@@ -95,6 +95,14 @@ public:
   /** Set some parameters. */
   itkSetMacro( NumberOfJacobianMeasurements, SizeValueType );
 
+  /** Set/Get a diagonal preconditioner. If its size equals the number of
+   * parameters, the displacements are computed for the preconditioned
+   * gradient, so that the estimated step size matches a preconditioned
+   * optimizer.
+   */
+  itkSetMacro( Preconditioner, DerivativeType );
+  itkGetConstReferenceMacro( Preconditioner, DerivativeType );
+
   /** Set the region over which the metric will be computed. */
   void SetFixedImageRegion( const FixedImageRegionType & region )
   {
@@ -119,6 +127,15 @@ public:
   virtual void ComputeUsingSearchDirection( const ParametersType & mu,
     double & jacg, double & maxJJ, std::string methods );
 
+  /** Compute a diagonal preconditioner from the sampled Jacobians, following
+   * the Jacobi preconditioner of the Gauss-Newton Hessian:
+   * P_p = mean_q( H_q ) / H_p, with H_p = sum_x || dT/dmu_p (x) ||^2.
+   * H_p is bounded from below by max_q( H_q ) / conditionNumber, to limit
+   * the condition number of the preconditioner.
+   */
+  virtual void ComputePreconditioner( const double conditionNumber,
+    DerivativeType & preconditioner );
+
   /** Set the number of threads. */
   void SetNumberOfThreads( ThreadIdType numberOfThreads )
   {
@@ -146,6 +163,7 @@ protected:
   ScaledSingleValuedCostFunction::Pointer m_CostFunction;
   SizeValueType                           m_NumberOfJacobianMeasurements;
   DerivativeType                          m_ExactGradient;
+  DerivativeType                          m_Preconditioner;
   SizeValueType                           m_NumberOfParameters;
   ThreaderType::Pointer                   m_Threader;
 
@@ -181,6 +199,9 @@ protected:
   virtual void SampleFixedImageForJacobianTerms(
     ImageSampleContainerPointer & sampleContainer );
 
+  /** Multiply the exact gradient by the preconditioner, if any. */
+  virtual void PreconditionExactGradient( void );
+
   /** Launch MultiThread Compute. */
   void LaunchComputeThreaderCallback( void ) const;
 
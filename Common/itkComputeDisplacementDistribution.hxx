@@ -158,6 +158,7 @@ ComputeDisplacementDistribution< TFixedImage, TTransform >
   this->m_ExactGradient = DerivativeType( P );
   this->m_ExactGradient.Fill( 0.0 );
   this->GetScaledDerivative( mu, this->m_ExactGradient );
+  this->PreconditionExactGradient();
 
   /** Get transform and set current position. */
   const unsigned int outdim = this->m_Transform->GetOutputSpaceDimension();
@@ -308,6 +309,7 @@ ComputeDisplacementDistribution< TFixedImage, TTransform >
   this->m_ExactGradient = DerivativeType( this->m_NumberOfParameters );
   this->m_ExactGradient.Fill( 0.0 );
   this->GetScaledDerivative( mu, this->m_ExactGradient );
+  this->PreconditionExactGradient();
 
   /** Get samples. */
   this->SampleFixedImageForJacobianTerms( this->m_SampleContainer );
@@ -629,6 +631,114 @@ ComputeDisplacementDistribution< TFixedImage, TTransform >
 } // end ComputeUsingSearchDirection()
 
 
+/**
+ * ************************* ComputePreconditioner ************************
+ */
+
+template< class TFixedImage, class TTransform >
+void
+ComputeDisplacementDistribution< TFixedImage, TTransform >
+::ComputePreconditioner( const double conditionNumber,
+  DerivativeType & preconditioner )
+{
+  /** Get samples. */
+  ImageSampleContainerPointer sampleContainer; // default-constructed (null)
+  this->SampleFixedImageForJacobianTerms( sampleContainer );
+
+  /** Get the number of parameters and the output space dimension. */
+  const unsigned int P = static_cast< unsigned int >(
+    this->m_Transform->GetNumberOfParameters() );
+  const unsigned int outdim = this->m_Transform->GetOutputSpaceDimension();
+
+  /** Get scales vector */
+  const ScalesType & scales = this->GetScales();
+
+  /** Variables for nonzerojacobian indices and the Jacobian. */
+  const SizeValueType sizejacind
+    = this->m_Transform->GetNumberOfNonZeroJacobianIndices();
+  JacobianType jacj( outdim, sizejacind );
+  jacj.Fill( 0.0 );
+  NonZeroJacobianIndicesType jacind( sizejacind );
+  jacind[ 0 ] = 0;
+  if( sizejacind > 1 ) { jacind[ 1 ] = 0; }
+
+  /** Accumulate diag( J^T J ) over the samples. Only the nonzero
+   * columns of the Jacobian contribute.
+   */
+  DerivativeType divisor( P );
+  divisor.Fill( 0.0 );
+  typename ImageSampleContainerType::ConstIterator iter;
+  typename ImageSampleContainerType::ConstIterator begin = sampleContainer->Begin();
+  typename ImageSampleContainerType::ConstIterator end   = sampleContainer->End();
+  for( iter = begin; iter != end; ++iter )
+  {
+    /** Read fixed coordinates and get Jacobian. */
+    const FixedImagePointType & point = ( *iter ).Value().m_ImageCoordinates;
+    this->m_Transform->GetJacobian( point, jacj, jacind );
+
+    for( unsigned int pi = 0; pi < sizejacind; ++pi )
+    {
+      const unsigned int p = jacind[ pi ];
+      double sum = 0.0;
+      for( unsigned int i = 0; i < outdim; ++i )
+      {
+        sum += vnl_math_sqr( jacj( i, pi ) );
+      }
+
+      /** Apply scales, if necessary. */
+      if( this->GetUseScales() )
+      {
+        sum /= vnl_math_sqr( scales[ p ] );
+      }
+      divisor[ p ] += sum;
+    }
+  }
+
+  /** Bound the condition number, and normalize, as in the Jacobian
+   * preconditioning of the ParzenWindowMutualInformationImageToImageMetric.
+   */
+  preconditioner.SetSize( P );
+  const double maxDivisor = divisor.max_value();
+  if( maxDivisor < 1e-14 )
+  {
+    preconditioner.Fill( 1.0 );
+    return;
+  }
+  const double minDivisor = maxDivisor / vnl_math_max( 1.0, conditionNumber );
+  for( unsigned int p = 0; p < P; ++p )
+  {
+    divisor[ p ] = vnl_math_max( minDivisor, divisor[ p ] );
+  }
+  const double normalizationFactor = divisor.mean();
+  for( unsigned int p = 0; p < P; ++p )
+  {
+    preconditioner[ p ] = normalizationFactor / divisor[ p ];
+  }
+
+} // end ComputePreconditioner()
+
+
+/**
+ * ************************* PreconditionExactGradient ************************
+ */
+
+template< class TFixedImage, class TTransform >
+void
+ComputeDisplacementDistribution< TFixedImage, TTransform >
+::PreconditionExactGradient( void )
+{
+  const unsigned int P = this->m_ExactGradient.GetSize();
+  if( this->m_Preconditioner.GetSize() == P )
+  {
+    for( unsigned int p = 0; p < P; ++p )
+    {
+      this->m_ExactGradient[ p ] *= this->m_Preconditioner[ p ];
+    }
+  }
+
+} // end PreconditionExactGradient()
+
+
 /**
  * ************************* SampleFixedImageForJacobianTerms ************************
  */
@@ -20,6 +20,7 @@
 
 #include "itkImageToImageFilter.h"
 #include "itkMultiResolutionPyramidImageFilter.h"
+#include "itkParabolicErodeImageFilter.h"
 
 namespace itk
 {
@@ -48,6 +49,13 @@ namespace itk
  *   the derivative of the metric.\n
  *   --> <tt>radius = static_cast<unsigned long>( 2 * schedule + 1 );</tt>
  *
+ * If ComputeAllLevels == true:\n
+ *   The eroded masks of all resolution levels are computed in one run,
+ *   and output l contains the mask for resolution level l. For integer pixel
+ *   types the erosions are cascaded: the mask of a level is obtained by
+ *   eroding the mask of the next (finer) level by the difference in radius.
+ *   This gives the same masks, in the sense of which voxels are nonzero,
+ *   at a fraction of the cost.
  *
  * \sa ParabolicErodeImageFilter
  *
@@ -99,6 +107,7 @@ public:
   virtual void SetSchedule( const ScheduleType & schedule )
   {
     this->m_Schedule = schedule;
+    this->UpdateNumberOfOutputs();
     this->Modified();
   }
 
@@ -117,6 +126,14 @@ public:
   itkSetMacro( ResolutionLevel, unsigned int );
   itkGetConstMacro( ResolutionLevel, unsigned int );
 
+  /** Set/Get whether the masks of all resolution levels are computed at once.
+   * If true, the filter has one output per row of the schedule; the
+   * ResolutionLevel is then ignored. Default: false.
+   */
+  virtual void SetComputeAllLevels( bool _arg );
+  itkGetConstMacro( ComputeAllLevels, bool );
+  itkBooleanMacro( ComputeAllLevels );
+
 #ifdef ITK_USE_CONCEPT_CHECKING
   /** Begin concept checking */
   itkConceptMacro( SameDimensionCheck,
@@ -138,6 +155,21 @@ protected:
    */
   virtual void GenerateData( void );
 
+  /** Typedefs for the erosion. */
+  typedef ParabolicErodeImageFilter<
+    InputImageType, OutputImageType >               ErodeFilterType;
+  typedef typename ErodeFilterType::RadiusType     RadiusType;
+  typedef typename ErodeFilterType::ScalarRealType ScalarRealType;
+
+  /** Compute the radius of the erosion for a resolution level, in voxels. */
+  void ComputeRadius( unsigned int level, RadiusType & radius ) const;
+
+  /** Convert a radius to the scale of the parabolic erosion filter. */
+  static ScalarRealType RadiusToScale( ScalarRealType radius );
+
+  /** Create the outputs, one per level if ComputeAllLevels is true. */
+  void UpdateNumberOfOutputs( void );
+
 private:
 
   ErodeMaskImageFilter( const Self & );    // purposely not implemented
@@ -146,6 +178,7 @@ private:
   bool         m_IsMovingMask;
   unsigned int m_ResolutionLevel;
   ScheduleType m_Schedule;
+  bool         m_ComputeAllLevels;
 
 };
 
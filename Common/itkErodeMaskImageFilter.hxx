@@ -19,7 +19,6 @@
 #define _itkErodeMaskImageFilter_hxx
 
 #include "itkErodeMaskImageFilter.h"
-#include "itkParabolicErodeImageFilter.h"
 //#include "itkThresholdImageFilter.h"
 
 namespace itk
@@ -33,8 +32,9 @@ template< class TImage >
 ErodeMaskImageFilter< TImage >
 ::ErodeMaskImageFilter()
 {
-  this->m_IsMovingMask    = false;
-  this->m_ResolutionLevel = 0;
+  this->m_IsMovingMask     = false;
+  this->m_ResolutionLevel  = 0;
+  this->m_ComputeAllLevels = false;
 
   ScheduleType defaultSchedule( 1, InputImageDimension );
   defaultSchedule.Fill( NumericTraits< unsigned int >::OneValue() );
@@ -44,43 +44,104 @@ ErodeMaskImageFilter< TImage >
 
 
 /**
- * ************* GenerateData *******************
+ * ************* SetComputeAllLevels *******************
  */
 
 template< class TImage >
 void
 ErodeMaskImageFilter< TImage >
-::GenerateData( void )
+::SetComputeAllLevels( bool _arg )
+{
+  if( this->m_ComputeAllLevels != _arg )
+  {
+    this->m_ComputeAllLevels = _arg;
+    this->UpdateNumberOfOutputs();
+    this->Modified();
+  }
+
+} // end SetComputeAllLevels()
+
+
+/**
+ * ************* UpdateNumberOfOutputs *******************
+ */
+
+template< class TImage >
+void
+ErodeMaskImageFilter< TImage >
+::UpdateNumberOfOutputs( void )
+{
+  const unsigned int numberOfOutputs = this->m_ComputeAllLevels
+    ? std::max( this->m_Schedule.rows(), 1u ) : 1;
+
+  this->SetNumberOfRequiredOutputs( numberOfOutputs );
+  for( unsigned int i = 1; i < numberOfOutputs; ++i )
+  {
+    if( this->GetOutput( i ) == 0 )
+    {
+      this->SetNthOutput( i, this->MakeOutput( i ) );
+    }
+  }
+
+} // end UpdateNumberOfOutputs()
+
+
+/**
+ * ************* ComputeRadius *******************
+ */
+
+template< class TImage >
+void
+ErodeMaskImageFilter< TImage >
+::ComputeRadius( unsigned int level, RadiusType & radius ) const
 {
-  /** Typedefs. */
-  //typedef itk::ThresholdImageFilter<InputImageType> ThresholdFilterType;
-  typedef itk::ParabolicErodeImageFilter<
-    InputImageType, OutputImageType >               ErodeFilterType;
-  typedef typename ErodeFilterType::RadiusType     RadiusType;
-  typedef typename ErodeFilterType::ScalarRealType ScalarRealType;
-
-  /** Get the correct radius. */
-  RadiusType     radiusarray;
-  ScalarRealType radius   = 0.0;
-  ScalarRealType schedule = 0.0;
   for( unsigned int i = 0; i < InputImageDimension; ++i )
   {
-    schedule = static_cast< ScalarRealType >(
-      this->GetSchedule()[ this->GetResolutionLevel() ][ i ] );
-    if( !this->GetIsMovingMask() )
+    const ScalarRealType schedule
+      = static_cast< ScalarRealType >( this->m_Schedule[ level ][ i ] );
+    if( !this->m_IsMovingMask )
     {
-      radius = schedule + 1.0;
+      radius[ i ] = schedule + 1.0;
     }
     else
     {
-      radius = 2.0 * schedule + 1.0;
+      radius[ i ] = 2.0 * schedule + 1.0;
     }
-    // Very specific computation for the parabolic erosion filter:
-    radius = radius * radius / 2.0 + 1.0;
+  }
+
+} // end ComputeRadius()
+
+
+/**
+ * ************* RadiusToScale *******************
+ */
 
-    radiusarray.SetElement( i, radius );
+template< class TImage >
+typename ErodeMaskImageFilter< TImage >::ScalarRealType
+ErodeMaskImageFilter< TImage >
+::RadiusToScale( ScalarRealType radius )
+{
+  /** Very specific computation for the parabolic erosion filter. A scale
+   * of 0 means no erosion at all.
+   */
+  if( radius <= 0.0 )
+  {
+    return 0.0;
   }
+  return radius * radius / 2.0 + 1.0;
+
+} // end RadiusToScale()
+
+
+/**
+ * ************* GenerateData *******************
+ */
 
+template< class TImage >
+void
+ErodeMaskImageFilter< TImage >
+::GenerateData( void )
+{
   /** Threshold the data first. Every voxel with intensity >= 1 is used.
   // Not needed since IsInside of a mask checks for != 0.
   typename ThresholdFilterType::Pointer threshold = ThresholdFilterType::New();
@@ -88,18 +149,78 @@ ErodeMaskImageFilter< TImage >
   threshold->SetOutsideValue( itk::NumericTraits<InputPixelType>::OneValue() );
   threshold->SetInput( this->GetInput() ); */
 
-  /** Create and run the erosion filter. */
-  typename ErodeFilterType::Pointer erosion = ErodeFilterType::New();
-  erosion->SetUseImageSpacing( false );
-  erosion->SetScale( radiusarray );
-  //erosion->SetInput( threshold->GetOutput() );
-  erosion->SetInput( this->GetInput() );
-  erosion->Update();
+  RadiusType radius;
+  RadiusType scale;
 
-  /** Graft the output of the mini-pipeline back onto the filter's output.
-   * this copies back the region ivars and meta-data.
+  /** Only the mask of the requested resolution level. */
+  if( !this->m_ComputeAllLevels )
+  {
+    this->ComputeRadius( this->m_ResolutionLevel, radius );
+    for( unsigned int i = 0; i < InputImageDimension; ++i )
+    {
+      scale[ i ] = RadiusToScale( radius[ i ] );
+    }
+
+    /** Create and run the erosion filter. */
+    typename ErodeFilterType::Pointer erosion = ErodeFilterType::New();
+    erosion->SetUseImageSpacing( false );
+    erosion->SetScale( scale );
+    erosion->SetInput( this->GetInput() );
+    erosion->Update();
+
+    /** Graft the output of the mini-pipeline back onto the filter's output.
+     * this copies back the region ivars and meta-data.
+     */
+    this->GraftOutput( erosion->GetOutput() );
+    return;
+  }
+
+  /** The masks of all levels. Casting to an integer pixel type between the
+   * erosions makes each of them equivalent to an erosion with a box of
+   * the given radius, and those can be cascaded. For other pixel types
+   * each level is eroded from the input.
    */
-  this->GraftOutput( erosion->GetOutput() );
+  const bool   cascade        = NumericTraits< InputPixelType >::is_integer;
+  const int    numberOfLevels = static_cast< int >( this->m_Schedule.rows() );
+  RadiusType   previousRadius;
+  previousRadius.Fill( 0.0 );
+  typename InputImageType::ConstPointer previousMask = this->GetInput();
+
+  /** Start at the finest level, which has the smallest radius. */
+  for( int level = numberOfLevels - 1; level >= 0; --level )
+  {
+    this->ComputeRadius( level, radius );
+
+    /** Cascading only works if the radius did not decrease. */
+    bool useCascade = cascade;
+    for( unsigned int i = 0; i < InputImageDimension; ++i )
+    {
+      useCascade &= radius[ i ] >= previousRadius[ i ];
+    }
+    if( !useCascade )
+    {
+      previousRadius.Fill( 0.0 );
+      previousMask = this->GetInput();
+    }
+
+    for( unsigned int i = 0; i < InputImageDimension; ++i )
+    {
+      scale[ i ] = RadiusToScale( radius[ i ] - previousRadius[ i ] );
+    }
+
+    typename ErodeFilterType::Pointer erosion = ErodeFilterType::New();
+    erosion->SetUseImageSpacing( false );
+    erosion->SetScale( scale );
+    erosion->SetInput( previousMask );
+    erosion->Update();
+
+    OutputImagePointer erodedMask = erosion->GetOutput();
+    erodedMask->DisconnectPipeline();
+    this->GraftNthOutput( level, erodedMask );
+
+    previousMask   = erodedMask.GetPointer();
+    previousRadius = radius;
+  }
 
 } // end GenerateData()
 
@@ -40,6 +40,7 @@
 #include <vector>
 
 #include "itkImageLinearIteratorWithIndex.h"
+#include "itkImageLinearConstIteratorWithIndex.h"
 #include "vnl/vnl_matrix.h"
 
 #include "itkImageToImageFilter.h"
@@ -71,11 +72,15 @@ namespace itk
  *               Uses mirror boundary conditions.
  *               Can only process LargestPossibleRegion
  *
+ * The image is processed one dimension at a time. Within a dimension, the
+ * scanlines are independent, so they are distributed over the threads; the
+ * requested region is never split along the dimension that is processed.
+ *
  * \sa itkBSplineInterpolateImageFunction
  *
  *  ***TODO: Is this an ImageFilter?  or does it belong to another group?
  * \ingroup ImageFilters
- * \ingroup SingleThreaded
+ * \ingroup MultiThreaded
  * \ingroup CannotBeStreamed
  */
 template< class TInputImage, class TOutputImage >
@@ -101,6 +106,7 @@ public:
   typedef typename Superclass::InputImagePointer      InputImagePointer;
   typedef typename Superclass::InputImageConstPointer InputImageConstPointer;
   typedef typename Superclass::OutputImagePointer     OutputImagePointer;
+  typedef typename Superclass::OutputImageRegionType  OutputImageRegionType;
 
   typedef typename itk::NumericTraits< typename TOutputImage::PixelType >::RealType CoeffType;
 
@@ -110,7 +116,8 @@ public:
     TOutputImage::ImageDimension );
 
   /** Iterator typedef support */
-  typedef ImageLinearIteratorWithIndex< TOutputImage > OutputLinearIterator;
+  typedef ImageLinearIteratorWithIndex< TOutputImage >     OutputLinearIterator;
+  typedef ImageLinearConstIteratorWithIndex< TInputImage > InputLinearIterator;
 
   /** Get/Sets the Spline Order, supports 0th - 5th order splines. The default
    *  is a 3rd order spline. */
@@ -118,7 +125,7 @@ public:
 
   void SetSplineOrder( unsigned int dimension, unsigned int order );
 
-  void GetSplineOrder( unsigned int dimension )
+  unsigned int GetSplineOrder( unsigned int dimension ) const
   {
     return m_SplineOrder[ dimension ];
   }
@@ -144,8 +151,19 @@ protected:
   virtual ~MultiOrderBSplineDecompositionImageFilter() {}
   void PrintSelf( std::ostream & os, Indent indent ) const;
 
+  /** Process the image one dimension at a time, multi-threaded. */
   void GenerateData();
 
+  /** Split the requested region along any dimension but the one that is
+   * currently processed, so that every thread gets complete scanlines.
+   */
+  virtual unsigned int SplitRequestedRegion( unsigned int i, unsigned int num,
+    OutputImageRegionType & splitRegion );
+
+  /** Filter the scanlines along m_IteratorDirection within a region. */
+  void ThreadedGenerateData( const OutputImageRegionType & outputRegionForThread,
+    ThreadIdType threadId );
+
   /** This filter requires all of the input image. */
   void GenerateInputRequestedRegion();
 
@@ -153,14 +171,13 @@ protected:
   void EnlargeOutputRequestedRegion( DataObject * output );
 
   /** These are needed by the smoothing spline routine. */
-  std::vector< CoeffType > m_Scratch;             // temp storage for processing of Coefficients
   typename TInputImage::SizeType m_DataLength;    // Image size
 
   unsigned int m_SplineOrder[ ImageDimension ];            // User specified spline order per dimension (3rd or cubic is the default)
   double       m_SplinePoles[ 3 ];                         // Poles calculated for a given spline order
   int          m_NumberOfPoles;                            // number of poles
   double       m_Tolerance;                                // Tolerance used for determining initial causal coefficient
-  unsigned int m_IteratorDirection;                        // Direction for iterator incrementing
+  unsigned int m_IteratorDirection;                        // Direction that is currently processed
 
 private:
 
@@ -170,27 +187,25 @@ private:
   /** Determines the poles for dimension given the Spline Order. */
   virtual void SetPoles( unsigned int dimension );
 
-  /** Converts a vector of data to a vector of Spline coefficients. */
-  virtual bool DataToCoefficients1D();
-
-  /** Converts an N-dimension image of data to an equivalent sized image
-   *    of spline coefficients. */
-  void DataToCoefficientsND();
+  /** Converts a vector of data to a vector of Spline coefficients.
+   * The scratch buffer holds one line along m_IteratorDirection.
+   */
+  bool DataToCoefficients1D( CoeffType * scratch ) const;
 
   /** Determines the first coefficient for the causal filtering of the data. */
-  virtual void SetInitialCausalCoefficient( double z );
+  void SetInitialCausalCoefficient( CoeffType * scratch, double z ) const;
 
   /** Determines the first coefficient for the anti-causal filtering of the data. */
-  virtual void SetInitialAntiCausalCoefficient( double z );
+  void SetInitialAntiCausalCoefficient( CoeffType * scratch, double z ) const;
 
-  /** Used to initialize the Coefficients image before calculation. */
-  void CopyImageToImage();
+  /** Copies a line of the input image to a scratch buffer. */
+  void CopyInputToScratch( InputLinearIterator &, CoeffType * scratch ) const;
 
-  /** Copies a vector of data from the Coefficients image to the m_Scratch vector. */
-  void CopyCoefficientsToScratch( OutputLinearIterator & );
+  /** Copies a line of the Coefficients image to a scratch buffer. */
+  void CopyCoefficientsToScratch( OutputLinearIterator &, CoeffType * scratch ) const;
 
-  /** Copies a vector of data from m_Scratch to the Coefficients image. */
-  void CopyScratchToCoefficients( OutputLinearIterator & );
+  /** Copies a scratch buffer to a line of the Coefficients image. */
+  void CopyScratchToCoefficients( OutputLinearIterator &, const CoeffType * scratch ) const;
 
 };
 
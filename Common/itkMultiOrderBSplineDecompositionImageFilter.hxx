@@ -38,8 +38,6 @@
 #define __itkMultiOrderBSplineDecompositionImageFilter_hxx
 
 #include "itkMultiOrderBSplineDecompositionImageFilter.h"
-#include "itkImageRegionConstIteratorWithIndex.h"
-#include "itkImageRegionIterator.h"
 #include "itkProgressReporter.h"
 #include "itkVector.h"
 
@@ -56,7 +54,16 @@ MultiOrderBSplineDecompositionImageFilter< TInputImage, TOutputImage >
   int splineOrder = 3;
   m_Tolerance         = 1e-10; // Need some guidance on this one...what is reasonable?
   m_IteratorDirection = 0;
+  for( unsigned int d = 0; d < ImageDimension; ++d )
+  {
+    m_SplineOrder[ d ] = 0;
+  }
   this->SetSplineOrder( splineOrder );
+
+#if ITK_VERSION_MAJOR >= 5
+  // Use the classic (ITK4) threading model, to ensure ThreadedGenerateData is being called.
+  this->DynamicMultiThreadingOff();
+#endif
 }
 
 
@@ -87,7 +94,7 @@ MultiOrderBSplineDecompositionImageFilter< TInputImage, TOutputImage >
 template< class TInputImage, class TOutputImage >
 bool
 MultiOrderBSplineDecompositionImageFilter< TInputImage, TOutputImage >
-::DataToCoefficients1D()
+::DataToCoefficients1D( CoeffType * scratch ) const
 {
 
   // See Unser, 1993, Part II, Equation 2.5,
@@ -95,7 +102,8 @@ MultiOrderBSplineDecompositionImageFilter< TInputImage, TOutputImage >
 
   double c0 = 1.0;
 
-  if( m_DataLength[ m_IteratorDirection ] == 1 ) //Required by mirror boundaries
+  const unsigned long dataLength = m_DataLength[ m_IteratorDirection ];
+  if( dataLength == 1 ) //Required by mirror boundaries
   {
     return false;
   }
@@ -108,28 +116,28 @@ MultiOrderBSplineDecompositionImageFilter< TInputImage, TOutputImage >
   }
 
   // apply the gain
-  for( unsigned int n = 0; n < m_DataLength[ m_IteratorDirection ]; n++ )
+  for( unsigned int n = 0; n < dataLength; n++ )
   {
-    m_Scratch[ n ] *= c0;
+    scratch[ n ] *= c0;
   }
 
   // loop over all poles
   for( int k = 0; k < m_NumberOfPoles; k++ )
   {
     // causal initialization
-    this->SetInitialCausalCoefficient( m_SplinePoles[ k ] );
+    this->SetInitialCausalCoefficient( scratch, m_SplinePoles[ k ] );
     // causal recursion
-    for( unsigned int n = 1; n < m_DataLength[ m_IteratorDirection ]; n++ )
+    for( unsigned int n = 1; n < dataLength; n++ )
     {
-      m_Scratch[ n ] += m_SplinePoles[ k ] * m_Scratch[ n - 1 ];
+      scratch[ n ] += m_SplinePoles[ k ] * scratch[ n - 1 ];
     }
 
     // anticausal initialization
-    this->SetInitialAntiCausalCoefficient( m_SplinePoles[ k ] );
+    this->SetInitialAntiCausalCoefficient( scratch, m_SplinePoles[ k ] );
     // anticausal recursion
-    for( int n = m_DataLength[ m_IteratorDirection ] - 2; 0 <= n; n-- )
+    for( int n = dataLength - 2; 0 <= n; n-- )
     {
-      m_Scratch[ n ] = m_SplinePoles[ k ] * ( m_Scratch[ n + 1 ] - m_Scratch[ n ] );
+      scratch[ n ] = m_SplinePoles[ k ] * ( scratch[ n + 1 ] - scratch[ n ] );
     }
   }
   return true;
@@ -225,7 +233,7 @@ MultiOrderBSplineDecompositionImageFilter< TInputImage, TOutputImage >
 template< class TInputImage, class TOutputImage >
 void
 MultiOrderBSplineDecompositionImageFilter< TInputImage, TOutputImage >
-::SetInitialCausalCoefficient( double z )
+::SetInitialCausalCoefficient( CoeffType * scratch, double z ) const
 {
   /* begining InitialCausalCoefficient */
   /* See Unser, 1999, Box 2 for explaination */
@@ -234,37 +242,38 @@ MultiOrderBSplineDecompositionImageFilter< TInputImage, TOutputImage >
   unsigned long horizon;
 
   /* this initialization corresponds to mirror boundaries */
-  horizon = m_DataLength[ m_IteratorDirection ];
+  const unsigned long dataLength = m_DataLength[ m_IteratorDirection ];
+  horizon = dataLength;
   zn      = z;
   if( m_Tolerance > 0.0 )
   {
     horizon = (long)std::ceil( std::log( m_Tolerance ) / std::log( std::fabs( z ) ) );
   }
-  if( horizon < m_DataLength[ m_IteratorDirection ] )
+  if( horizon < dataLength )
   {
     /* accelerated loop */
-    sum = m_Scratch[ 0 ];   // verify this
+    sum = scratch[ 0 ];   // verify this
     for( unsigned int n = 1; n < horizon; n++ )
     {
-      sum += zn * m_Scratch[ n ];
+      sum += zn * scratch[ n ];
       zn  *= z;
     }
-    m_Scratch[ 0 ] = sum;
+    scratch[ 0 ] = sum;
   }
   else
   {
     /* full loop */
     iz   = 1.0 / z;
-    z2n  = std::pow( z, (double)( m_DataLength[ m_IteratorDirection ] - 1L ) );
-    sum  = m_Scratch[ 0 ] + z2n * m_Scratch[ m_DataLength[ m_IteratorDirection ] - 1L ];
+    z2n  = std::pow( z, (double)( dataLength - 1L ) );
+    sum  = scratch[ 0 ] + z2n * scratch[ dataLength - 1L ];
     z2n *= z2n * iz;
-    for( unsigned int n = 1; n <= ( m_DataLength[ m_IteratorDirection ] - 2 ); n++ )
+    for( unsigned int n = 1; n <= ( dataLength - 2 ); n++ )
     {
-      sum += ( zn + z2n ) * m_Scratch[ n ];
+      sum += ( zn + z2n ) * scratch[ n ];
       zn  *= z;
       z2n *= iz;
     }
-    m_Scratch[ 0 ] = sum / ( 1.0 - zn * zn );
+    scratch[ 0 ] = sum / ( 1.0 - zn * zn );
   }
 }
 
@@ -272,86 +281,32 @@ MultiOrderBSplineDecompositionImageFilter< TInputImage, TOutputImage >
 template< class TInputImage, class TOutputImage >
 void
 MultiOrderBSplineDecompositionImageFilter< TInputImage, TOutputImage >
-::SetInitialAntiCausalCoefficient( double z )
+::SetInitialAntiCausalCoefficient( CoeffType * scratch, double z ) const
 {
   // this initialization corresponds to mirror boundaries
   /* See Unser, 1999, Box 2 for explaination */
   //  Also see erratum at http://bigwww.epfl.ch/publications/unser9902.html
-  m_Scratch[ m_DataLength[ m_IteratorDirection ] - 1 ]
+  const unsigned long dataLength = m_DataLength[ m_IteratorDirection ];
+  scratch[ dataLength - 1 ]
     = ( z / ( z * z - 1.0 ) )
-    * ( z * m_Scratch[ m_DataLength[ m_IteratorDirection ] - 2 ] + m_Scratch[ m_DataLength[ m_IteratorDirection ] - 1 ] );
-}
-
-
-template< class TInputImage, class TOutputImage >
-void
-MultiOrderBSplineDecompositionImageFilter< TInputImage, TOutputImage >
-::DataToCoefficientsND()
-{
-  OutputImagePointer output = this->GetOutput();
-
-  Size< ImageDimension > size = output->GetBufferedRegion().GetSize();
-
-  unsigned int count = output->GetBufferedRegion().GetNumberOfPixels() / size[ 0 ] * ImageDimension;
-
-  ProgressReporter progress( this, 0, count, 10 );
-
-  // Initialize coeffient array
-  this->CopyImageToImage();   // Coefficients are initialized to the input data
-
-  for( unsigned int n = 0; n < ImageDimension; n++ )
-  {
-    m_IteratorDirection = n;
-    // Loop through each dimension
-
-    // Compute poles for this dimension
-    this->SetPoles( n );
-
-    // Initialize iterators
-    OutputLinearIterator CIterator( output, output->GetBufferedRegion() );
-    CIterator.SetDirection( m_IteratorDirection );
-    // For each data vector
-    while( !CIterator.IsAtEnd() )
-    {
-      // Copy coefficients to scratch
-      this->CopyCoefficientsToScratch( CIterator );
-
-      // Perform 1D BSpline calculations
-      this->DataToCoefficients1D();
-
-      // Copy scratch back to coefficients.
-      // Brings us back to the end of the line we were working on.
-      CIterator.GoToBeginOfLine();
-      this->CopyScratchToCoefficients( CIterator ); // m_Scratch = m_Image;
-      CIterator.NextLine();
-      progress.CompletedPixel();
-    }
-  }
+    * ( z * scratch[ dataLength - 2 ] + scratch[ dataLength - 1 ] );
 }
 
 
 /**
- * Copy the input image into the output image
+ * Copy one line of the input image to the scratch
  */
 template< class TInputImage, class TOutputImage >
 void
 MultiOrderBSplineDecompositionImageFilter< TInputImage, TOutputImage >
-::CopyImageToImage()
+::CopyInputToScratch( InputLinearIterator & Iter, CoeffType * scratch ) const
 {
-  typedef ImageRegionConstIteratorWithIndex< TInputImage > InputIterator;
-  typedef ImageRegionIterator< TOutputImage >              OutputIterator;
-  typedef typename TOutputImage::PixelType                 OutputPixelType;
-
-  InputIterator  inIt( this->GetInput(), this->GetInput()->GetBufferedRegion() );
-  OutputIterator outIt( this->GetOutput(), this->GetOutput()->GetBufferedRegion() );
-
-  inIt.GoToBegin();
-  outIt.GoToBegin();
-  while( !outIt.IsAtEnd() )
+  unsigned long j = 0;
+  while( !Iter.IsAtEndOfLine() )
   {
-    outIt.Set( static_cast< OutputPixelType >( inIt.Get() ) );
-    ++inIt;
-    ++outIt;
+    scratch[ j ] = static_cast< CoeffType >( Iter.Get() );
+    ++Iter;
+    ++j;
   }
 }
 
@@ -362,13 +317,13 @@ MultiOrderBSplineDecompositionImageFilter< TInputImage, TOutputImage >
 template< class TInputImage, class TOutputImage >
 void
 MultiOrderBSplineDecompositionImageFilter< TInputImage, TOutputImage >
-::CopyScratchToCoefficients( OutputLinearIterator & Iter )
+::CopyScratchToCoefficients( OutputLinearIterator & Iter, const CoeffType * scratch ) const
 {
   typedef typename TOutputImage::PixelType OutputPixelType;
   unsigned long j = 0;
   while( !Iter.IsAtEndOfLine() )
   {
-    Iter.Set( static_cast< OutputPixelType >( m_Scratch[ j ] ) );
+    Iter.Set( static_cast< OutputPixelType >( scratch[ j ] ) );
     ++Iter;
     ++j;
   }
@@ -382,12 +337,12 @@ MultiOrderBSplineDecompositionImageFilter< TInputImage, TOutputImage >
 template< class TInputImage, class TOutputImage >
 void
 MultiOrderBSplineDecompositionImageFilter< TInputImage, TOutputImage >
-::CopyCoefficientsToScratch( OutputLinearIterator & Iter )
+::CopyCoefficientsToScratch( OutputLinearIterator & Iter, CoeffType * scratch ) const
 {
   unsigned long j = 0;
   while( !Iter.IsAtEndOfLine() )
   {
-    m_Scratch[ j ] = static_cast< CoeffType >( Iter.Get() );
+    scratch[ j ] = static_cast< CoeffType >( Iter.Get() );
     ++Iter;
     ++j;
   }
@@ -434,6 +389,65 @@ MultiOrderBSplineDecompositionImageFilter< TInputImage, TOutputImage >
 }
 
 
+/**
+ * Split the requested region, avoiding the current dimension
+ */
+template< class TInputImage, class TOutputImage >
+unsigned int
+MultiOrderBSplineDecompositionImageFilter< TInputImage, TOutputImage >
+::SplitRequestedRegion( unsigned int i, unsigned int num, OutputImageRegionType & splitRegion )
+{
+  // Get the output pointer
+  TOutputImage * outputPtr = this->GetOutput();
+  const typename TOutputImage::SizeType & requestedRegionSize
+    = outputPtr->GetRequestedRegion().GetSize();
+
+  // Initialize the splitRegion to the output requested region
+  splitRegion = outputPtr->GetRequestedRegion();
+  typename TOutputImage::IndexType splitIndex = splitRegion.GetIndex();
+  typename TOutputImage::SizeType splitSize   = splitRegion.GetSize();
+
+  // split on the outermost dimension available
+  // and avoid the current dimension
+  int splitAxis = ImageDimension - 1;
+  while( requestedRegionSize[ splitAxis ] == 1 || splitAxis == (int)m_IteratorDirection )
+  {
+    --splitAxis;
+    if( splitAxis < 0 )
+    {   // cannot split
+      itkDebugMacro( "  Cannot Split" );
+      return 1;
+    }
+  }
+
+  // determine the actual number of pieces that will be generated
+  const typename TOutputImage::SizeType::SizeValueType range = requestedRegionSize[ splitAxis ];
+  const unsigned int valuesPerThread = (unsigned int)std::ceil( range / (double)num );
+  const unsigned int maxThreadIdUsed = (unsigned int)std::ceil( range / (double)valuesPerThread ) - 1;
+
+  // Split the region
+  if( i < maxThreadIdUsed )
+  {
+    splitIndex[ splitAxis ] += i * valuesPerThread;
+    splitSize[ splitAxis ]   = valuesPerThread;
+  }
+  if( i == maxThreadIdUsed )
+  {
+    splitIndex[ splitAxis ] += i * valuesPerThread;
+    // last thread needs to process the "rest" dimension being split
+    splitSize[ splitAxis ] = splitSize[ splitAxis ] - i * valuesPerThread;
+  }
+
+  // set the split region ivars
+  splitRegion.SetIndex( splitIndex );
+  splitRegion.SetSize( splitSize );
+
+  itkDebugMacro( "  Split Piece: " << splitRegion );
+
+  return maxThreadIdUsed + 1;
+}
+
+
 /**
  * Generate data
  */
@@ -442,32 +456,88 @@ void
 MultiOrderBSplineDecompositionImageFilter< TInputImage, TOutputImage >
 ::GenerateData()
 {
-
-  // Allocate scratch memory
   InputImageConstPointer inputPtr = this->GetInput();
   m_DataLength = inputPtr->GetBufferedRegion().GetSize();
 
-  unsigned long maxLength = 0;
-  for( unsigned int n = 0; n < ImageDimension; n++ )
-  {
-    if( m_DataLength[ n ] > maxLength )
-    {
-      maxLength = m_DataLength[ n ];
-    }
-  }
-  m_Scratch.resize( maxLength );
-
   // Allocate memory for output image
   OutputImagePointer outputPtr = this->GetOutput();
   outputPtr->SetBufferedRegion( outputPtr->GetRequestedRegion() );
   outputPtr->Allocate();
 
-  // Calculate actual output
-  this->DataToCoefficientsND();
+  // Set up the multithreaded processing
+  typename ImageSource< TOutputImage >::ThreadStruct str;
+  str.Filter = this;
+  this->GetMultiThreader()->SetNumberOfThreads( this->GetNumberOfThreads() );
+  this->GetMultiThreader()->SetSingleMethod( this->ThreaderCallback, &str );
+
+  // Loop through each dimension. The first pass reads the input,
+  // the others work in place on the coefficients.
+  for( unsigned int n = 0; n < ImageDimension; n++ )
+  {
+    m_IteratorDirection = n;
+
+    // Compute poles for this dimension
+    this->SetPoles( n );
+
+    this->GetMultiThreader()->SingleMethodExecute();
+  }
+
+}
+
+
+/**
+ * Threaded generate data
+ */
+template< class TInputImage, class TOutputImage >
+void
+MultiOrderBSplineDecompositionImageFilter< TInputImage, TOutputImage >
+::ThreadedGenerateData( const OutputImageRegionType & outputRegionForThread,
+  ThreadIdType threadId )
+{
+  const unsigned int direction  = m_IteratorDirection;
+  const unsigned long lineLength = outputRegionForThread.GetSize()[ direction ];
+  if( lineLength == 0 )
+  {
+    return;
+  }
 
-  // Clean up
-  m_Scratch.clear();
+  // Each thread has its own scratch memory
+  std::vector< CoeffType > scratch( lineLength );
 
+  const float progressPerDimension = 1.0 / ImageDimension;
+  ProgressReporter progress( this, threadId,
+    outputRegionForThread.GetNumberOfPixels() / lineLength, 10,
+    direction * progressPerDimension, progressPerDimension );
+
+  OutputLinearIterator CIterator( this->GetOutput(), outputRegionForThread );
+  CIterator.SetDirection( direction );
+
+  // Coefficients are initialized to the input data
+  InputLinearIterator inIterator( this->GetInput(), outputRegionForThread );
+  inIterator.SetDirection( direction );
+
+  // For each data vector
+  while( !CIterator.IsAtEnd() )
+  {
+    if( direction == 0 )
+    {
+      this->CopyInputToScratch( inIterator, &scratch[ 0 ] );
+      inIterator.NextLine();
+    }
+    else
+    {
+      this->CopyCoefficientsToScratch( CIterator, &scratch[ 0 ] );
+      CIterator.GoToBeginOfLine();
+    }
+
+    // Perform 1D BSpline calculations
+    this->DataToCoefficients1D( &scratch[ 0 ] );
+
+    // Copy scratch back to coefficients.
+    this->CopyScratchToCoefficients( CIterator, &scratch[ 0 ] );
+    CIterator.NextLine();
+    progress.CompletedPixel();
+  }
 }
 
 
@@ -0,0 +1,102 @@
+/*=========================================================================
+ *
+ *  Copyright UMC Utrecht and contributors
+ *
+ *  Licensed under the Apache License, Version 2.0 (the "License");
+ *  you may not use this file except in compliance with the License.
+ *  You may obtain a copy of the License at
+ *
+ *        http://www.apache.org/licenses/LICENSE-2.0.txt
+ *
+ *  Unless required by applicable law or agreed to in writing, software
+ *  distributed under the License is distributed on an "AS IS" BASIS,
+ *  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *  See the License for the specific language governing permissions and
+ *  limitations under the License.
+ *
+ *=========================================================================*/
+#ifndef __itkMultiResolutionCachedPyramidImageFilter_h
+#define __itkMultiResolutionCachedPyramidImageFilter_h
+
+#include "itkMultiResolutionPyramidImageFilter.h"
+#include <vector>
+
+namespace itk
+{
+
+/** \class MultiResolutionCachedPyramidImageFilter
+ * \brief A pyramid that outputs the images of another pyramid, which
+ * computed them earlier.
+ *
+ * The output images of a pyramid are stored with SetCachedPyramid(). This
+ * filter does not keep a reference to that pyramid; its outputs share the
+ * pixel data of the stored images. So, the images can be reused after the
+ * original pyramid has been destroyed, by registrations of the same input
+ * image with the same schedule. The input should be the input of the
+ * original pyramid.
+ *
+ * \ingroup PyramidImageFilter
+ */
+template<
+class TInputImage,
+class TOutputImage
+>
+class MultiResolutionCachedPyramidImageFilter :
+  public MultiResolutionPyramidImageFilter< TInputImage, TOutputImage >
+{
+public:
+
+  /** Standard class typedefs. */
+  typedef MultiResolutionCachedPyramidImageFilter                        Self;
+  typedef MultiResolutionPyramidImageFilter< TInputImage, TOutputImage > Superclass;
+  typedef SmartPointer< Self >                                           Pointer;
+  typedef SmartPointer< const Self >                                     ConstPointer;
+
+  /** Method for creation through the object factory. */
+  itkNewMacro( Self );
+
+  /** Run-time type information (and related methods). */
+  itkTypeMacro( MultiResolutionCachedPyramidImageFilter,
+    MultiResolutionPyramidImageFilter );
+
+  /** Inherit types from Superclass. */
+  typedef typename Superclass::ScheduleType       ScheduleType;
+  typedef typename Superclass::InputImageType     InputImageType;
+  typedef typename Superclass::OutputImageType    OutputImageType;
+  typedef typename Superclass::OutputImagePointer OutputImagePointer;
+
+  /** Store the output images of an updated pyramid, and copy its number
+   * of levels and schedule.
+   */
+  void SetCachedPyramid( Superclass * pyramid );
+
+protected:
+
+  MultiResolutionCachedPyramidImageFilter() {}
+  ~MultiResolutionCachedPyramidImageFilter() {}
+
+  /** Copy the information of the stored images to the outputs. */
+  virtual void GenerateOutputInformation( void );
+
+  /** The input is not used, so no padding is requested. */
+  virtual void GenerateInputRequestedRegion( void );
+
+  /** Graft the stored images onto the outputs. */
+  virtual void GenerateData( void );
+
+private:
+
+  MultiResolutionCachedPyramidImageFilter( const Self & ); // purposely not implemented
+  void operator=( const Self & );                          // purposely not implemented
+
+  std::vector< OutputImagePointer > m_CachedOutputs;
+
+};
+
+} // namespace itk
+
+#ifndef ITK_MANUAL_INSTANTIATION
+#include "itkMultiResolutionCachedPyramidImageFilter.hxx"
+#endif
+
+#endif
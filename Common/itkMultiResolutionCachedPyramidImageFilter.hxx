@@ -0,0 +1,104 @@
+/*=========================================================================
+ *
+ *  Copyright UMC Utrecht and contributors
+ *
+ *  Licensed under the Apache License, Version 2.0 (the "License");
+ *  you may not use this file except in compliance with the License.
+ *  You may obtain a copy of the License at
+ *
+ *        http://www.apache.org/licenses/LICENSE-2.0.txt
+ *
+ *  Unless required by applicable law or agreed to in writing, software
+ *  distributed under the License is distributed on an "AS IS" BASIS,
+ *  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *  See the License for the specific language governing permissions and
+ *  limitations under the License.
+ *
+ *=========================================================================*/
+#ifndef __itkMultiResolutionCachedPyramidImageFilter_hxx
+#define __itkMultiResolutionCachedPyramidImageFilter_hxx
+
+#include "itkMultiResolutionCachedPyramidImageFilter.h"
+
+namespace itk
+{
+
+/**
+ * SetCachedPyramid
+ */
+template< class TInputImage, class TOutputImage >
+void
+MultiResolutionCachedPyramidImageFilter< TInputImage, TOutputImage >
+::SetCachedPyramid( Superclass * pyramid )
+{
+  this->SetNumberOfLevels( pyramid->GetNumberOfLevels() );
+  this->SetSchedule( pyramid->GetSchedule() );
+
+  /** The stored images share the pixel data of the outputs of the pyramid,
+   * but are not connected to the pyramid.
+   */
+  this->m_CachedOutputs.resize( this->m_NumberOfLevels );
+  for( unsigned int ilevel = 0; ilevel < this->m_NumberOfLevels; ilevel++ )
+  {
+    this->m_CachedOutputs[ ilevel ] = OutputImageType::New();
+    this->m_CachedOutputs[ ilevel ]->Graft( pyramid->GetOutput( ilevel ) );
+  }
+  this->Modified();
+
+} // end SetCachedPyramid()
+
+
+/**
+ * GenerateOutputInformation
+ */
+template< class TInputImage, class TOutputImage >
+void
+MultiResolutionCachedPyramidImageFilter< TInputImage, TOutputImage >
+::GenerateOutputInformation( void )
+{
+  if( this->m_CachedOutputs.size() != this->m_NumberOfLevels )
+  {
+    itkExceptionMacro( << "The number of levels differs from the cached pyramid." );
+  }
+
+  for( unsigned int ilevel = 0; ilevel < this->m_NumberOfLevels; ilevel++ )
+  {
+    this->GetOutput( ilevel )->CopyInformation( this->m_CachedOutputs[ ilevel ] );
+  }
+
+} // end GenerateOutputInformation()
+
+
+/**
+ * GenerateInputRequestedRegion
+ */
+template< class TInputImage, class TOutputImage >
+void
+MultiResolutionCachedPyramidImageFilter< TInputImage, TOutputImage >
+::GenerateInputRequestedRegion( void )
+{
+  // call the superclass' implementation of this method
+  Superclass::Superclass::GenerateInputRequestedRegion();
+
+} // end GenerateInputRequestedRegion()
+
+
+/**
+ * GenerateData
+ */
+template< class TInputImage, class TOutputImage >
+void
+MultiResolutionCachedPyramidImageFilter< TInputImage, TOutputImage >
+::GenerateData( void )
+{
+  for( unsigned int ilevel = 0; ilevel < this->m_NumberOfLevels; ilevel++ )
+  {
+    this->GraftNthOutput( ilevel, this->m_CachedOutputs[ ilevel ] );
+  }
+
+} // end GenerateData()
+
+
+} // end namespace itk
+
+#endif
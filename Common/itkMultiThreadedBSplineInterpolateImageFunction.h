@@ -0,0 +1,103 @@
+/*=========================================================================
+ *
+ *  Copyright UMC Utrecht and contributors
+ *
+ *  Licensed under the Apache License, Version 2.0 (the "License");
+ *  you may not use this file except in compliance with the License.
+ *  You may obtain a copy of the License at
+ *
+ *        http://www.apache.org/licenses/LICENSE-2.0.txt
+ *
+ *  Unless required by applicable law or agreed to in writing, software
+ *  distributed under the License is distributed on an "AS IS" BASIS,
+ *  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *  See the License for the specific language governing permissions and
+ *  limitations under the License.
+ *
+ *=========================================================================*/
+#ifndef __itkMultiThreadedBSplineInterpolateImageFunction_h
+#define __itkMultiThreadedBSplineInterpolateImageFunction_h
+
+#include "itkBSplineInterpolateImageFunction.h"
+#include "itkMultiOrderBSplineDecompositionImageFilter.h"
+
+namespace itk
+{
+/** \class MultiThreadedBSplineInterpolateImageFunction
+ * \brief B-spline interpolation with a multi-threaded coefficient prefilter.
+ *
+ * This class evaluates the image exactly like the BSplineInterpolateImageFunction,
+ * but computes the B-spline coefficients of a new input image with the
+ * MultiOrderBSplineDecompositionImageFilter, which distributes the scanlines
+ * of each dimension over the threads. The itk::BSplineDecompositionImageFilter
+ * that is used by the superclass runs single-threaded, which dominates the
+ * time needed to set a large input image.
+ *
+ * \sa BSplineInterpolateImageFunction, MultiOrderBSplineDecompositionImageFilter
+ * \ingroup ImageFunctions ImageInterpolators
+ */
+template< class TImageType, class TCoordRep = double, class TCoefficientType = double >
+class MultiThreadedBSplineInterpolateImageFunction :
+  public BSplineInterpolateImageFunction< TImageType, TCoordRep, TCoefficientType >
+{
+public:
+
+  /** Standard class typedefs. */
+  typedef MultiThreadedBSplineInterpolateImageFunction Self;
+  typedef BSplineInterpolateImageFunction<
+    TImageType, TCoordRep, TCoefficientType >          Superclass;
+  typedef SmartPointer< Self >                         Pointer;
+  typedef SmartPointer< const Self >                   ConstPointer;
+
+  /** Run-time type information (and related methods). */
+  itkTypeMacro( MultiThreadedBSplineInterpolateImageFunction, BSplineInterpolateImageFunction );
+
+  /** New macro for creation of through a Smart Pointer. */
+  itkNewMacro( Self );
+
+  /** Typedefs inherited from the superclass. */
+  typedef typename Superclass::InputImageType       InputImageType;
+  typedef typename Superclass::CoefficientImageType CoefficientImageType;
+
+  /** The multi-threaded coefficient prefilter. */
+  typedef MultiOrderBSplineDecompositionImageFilter<
+    TImageType, CoefficientImageType >              ThreadedCoefficientFilter;
+  typedef typename ThreadedCoefficientFilter::Pointer ThreadedCoefficientFilterPointer;
+
+  /** Set the input image, and compute its B-spline coefficients. */
+  virtual void SetInputImage( const TImageType * inputData );
+
+  /** Set the number of threads of the coefficient prefilter. This is not
+   * called SetNumberOfThreads(), to leave that method of the superclass,
+   * which sizes the buffers of the threaded evaluation, visible.
+   */
+  void SetNumberOfPrefilterThreads( ThreadIdType numberOfThreads )
+  {
+#if ITK_VERSION_MAJOR >= 5
+    this->m_ThreadedCoefficientFilter->SetNumberOfWorkUnits( numberOfThreads );
+#else
+    this->m_ThreadedCoefficientFilter->SetNumberOfThreads( numberOfThreads );
+#endif
+  }
+
+protected:
+
+  MultiThreadedBSplineInterpolateImageFunction();
+  virtual ~MultiThreadedBSplineInterpolateImageFunction() {}
+
+private:
+
+  MultiThreadedBSplineInterpolateImageFunction( const Self & ); // purposely not implemented
+  void operator=( const Self & );                               // purposely not implemented
+
+  ThreadedCoefficientFilterPointer m_ThreadedCoefficientFilter;
+
+};
+
+} // end namespace itk
+
+#ifndef ITK_MANUAL_INSTANTIATION
+#include "itkMultiThreadedBSplineInterpolateImageFunction.hxx"
+#endif
+
+#endif // end #ifndef __itkMultiThreadedBSplineInterpolateImageFunction_h
@@ -0,0 +1,75 @@
+/*=========================================================================
+ *
+ *  Copyright UMC Utrecht and contributors
+ *
+ *  Licensed under the Apache License, Version 2.0 (the "License");
+ *  you may not use this file except in compliance with the License.
+ *  You may obtain a copy of the License at
+ *
+ *        http://www.apache.org/licenses/LICENSE-2.0.txt
+ *
+ *  Unless required by applicable law or agreed to in writing, software
+ *  distributed under the License is distributed on an "AS IS" BASIS,
+ *  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *  See the License for the specific language governing permissions and
+ *  limitations under the License.
+ *
+ *=========================================================================*/
+#ifndef __itkMultiThreadedBSplineInterpolateImageFunction_hxx
+#define __itkMultiThreadedBSplineInterpolateImageFunction_hxx
+
+#include "itkMultiThreadedBSplineInterpolateImageFunction.h"
+
+namespace itk
+{
+
+/**
+ * ******************* Constructor *******************
+ */
+
+template< class TImageType, class TCoordRep, class TCoefficientType >
+MultiThreadedBSplineInterpolateImageFunction< TImageType, TCoordRep, TCoefficientType >
+::MultiThreadedBSplineInterpolateImageFunction()
+{
+  this->m_ThreadedCoefficientFilter = ThreadedCoefficientFilter::New();
+
+} // end Constructor
+
+
+/**
+ * ******************* SetInputImage *******************
+ */
+
+template< class TImageType, class TCoordRep, class TCoefficientType >
+void
+MultiThreadedBSplineInterpolateImageFunction< TImageType, TCoordRep, TCoefficientType >
+::SetInputImage( const TImageType * inputData )
+{
+  if( !inputData )
+  {
+    Superclass::SetInputImage( inputData );
+    return;
+  }
+
+  /** Compute the coefficients with the threaded prefilter. The spline order
+   * may have changed since the last call, so it is set every time.
+   */
+  this->m_ThreadedCoefficientFilter->SetSplineOrder( this->GetSplineOrder() );
+  this->m_ThreadedCoefficientFilter->SetInput( inputData );
+  this->m_ThreadedCoefficientFilter->Update();
+  this->m_Coefficients = this->m_ThreadedCoefficientFilter->GetOutput();
+
+  /** Skip the single-threaded prefilter of the superclass, but do what the
+   * ImageFunction does. Call it after the filter, in case the filter pulls
+   * in more of the input image.
+   */
+  this->InterpolateImageFunction< TImageType, TCoordRep >::SetInputImage( inputData );
+
+  this->m_DataLength = inputData->GetBufferedRegion().GetSize();
+
+} // end SetInputImage()
+
+
+} // end namespace itk
+
+#endif // end #ifndef __itkMultiThreadedBSplineInterpolateImageFunction_hxx
@@ -147,7 +147,11 @@ protected:
   /** Generate Data */
   void GenerateData( void );
 
-  int SplitRequestedRegion( int i, int num, OutputImageRegionType & splitRegion );
+  /** Split the requested region along any dimension but the one that is
+   * currently processed, so that every thread gets complete scanlines.
+   */
+  virtual unsigned int SplitRequestedRegion( unsigned int i, unsigned int num,
+    OutputImageRegionType & splitRegion );
 
   void ThreadedGenerateData( const OutputImageRegionType & outputRegionForThread, ThreadIdType threadId );
 
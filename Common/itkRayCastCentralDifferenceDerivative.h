@@ -0,0 +1,108 @@
+/*=========================================================================
+ *
+ *  Copyright UMC Utrecht and contributors
+ *
+ *  Licensed under the Apache License, Version 2.0 (the "License");
+ *  you may not use this file except in compliance with the License.
+ *  You may obtain a copy of the License at
+ *
+ *        http://www.apache.org/licenses/LICENSE-2.0.txt
+ *
+ *  Unless required by applicable law or agreed to in writing, software
+ *  distributed under the License is distributed on an "AS IS" BASIS,
+ *  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *  See the License for the specific language governing permissions and
+ *  limitations under the License.
+ *
+ *=========================================================================*/
+#ifndef __itkRayCastCentralDifferenceDerivative_h
+#define __itkRayCastCentralDifferenceDerivative_h
+
+#include "itkMultiThreader.h"
+
+#include <string>
+#include <vector>
+
+namespace itk
+{
+
+/** \class RayCastCentralDifferenceDerivative
+ * \brief Computes the central difference derivative of a 2D-3D metric,
+ * with the perturbed values computed simultaneously.
+ *
+ * The 2D-3D metrics copy their moved image pipeline a number of times, see
+ * RayCastProjectionSet. This class distributes the 2N perturbed parameter
+ * vectors of the central differences over these copies, one thread per copy.
+ * The metric supplies the value functions:
+ * \li GetValue( parameters ), used without copies of the pipeline;
+ * \li BeforeComputePerturbedValues( parameters ), called once before the
+ *   threads start, e.g. to select the samples;
+ * \li ComputePerturbedValue( i, parameters ), which computes the value with
+ *   copy i of the pipeline, and can be called simultaneously for different i.
+ *
+ * The metric should declare this class a friend if these functions are not
+ * public.
+ *
+ * \ingroup Metrics
+ */
+
+template< class TMetric >
+class RayCastCentralDifferenceDerivative
+{
+public:
+
+  /** Typedefs from the metric. */
+  typedef TMetric                                    MetricType;
+  typedef typename MetricType::MeasureType           MeasureType;
+  typedef typename MetricType::DerivativeType        DerivativeType;
+  typedef typename MetricType::TransformParametersType ParametersType;
+  typedef typename MetricType::ScalesType            ScalesType;
+  typedef MultiThreader                              ThreaderType;
+  typedef ThreaderType::ThreadInfoStruct             ThreadInfoType;
+
+  /** Get the number of copies of the pipeline: one per thread, but not more
+   * than there are perturbed parameter vectors. Returns 0 if the copies
+   * would not be used.
+   */
+  static unsigned int GetNumberOfPipelines( const unsigned int numberOfParameters,
+    const ThreadIdType numberOfThreads, const bool useMultiThread );
+
+  /** Get the number of threads of the filters of each copy of the pipeline. */
+  static ThreadIdType GetNumberOfThreadsPerPipeline( const ThreadIdType numberOfThreads,
+    const unsigned int numberOfPipelines );
+
+  /** Compute the derivative by central differences, with a step of
+   * derivativeDelta / sqrt( scales[ k ] ) for parameter k. With less than two
+   * copies of the pipeline, the metric's GetValue() is called for each
+   * perturbed parameter vector.
+   */
+  static void Compute( const MetricType * metric, ThreaderType * threader,
+    const ThreadIdType numberOfThreads, const unsigned int numberOfPipelines,
+    const ParametersType & parameters, const ScalesType & scales,
+    const double derivativeDelta, DerivativeType & derivative );
+
+private:
+
+  /** Threader callback function, computing the values of one copy. */
+  static ITK_THREAD_RETURN_TYPE ThreaderCallback( void * arg );
+
+  struct ThreaderParameterType
+  {
+    const MetricType *           st_Metric;
+    const ParametersType *       st_Parameters;
+    const ScalesType *           st_Scales;
+    double                       st_DerivativeDelta;
+    std::vector< MeasureType > * st_Values;
+    std::vector< std::string > * st_Errors;
+    unsigned int                 st_NumberOfPipelines;
+  };
+
+};
+
+} // end namespace itk
+
+#ifndef ITK_MANUAL_INSTANTIATION
+#include "itkRayCastCentralDifferenceDerivative.hxx"
+#endif
+
+#endif
@@ -0,0 +1,192 @@
+/*=========================================================================
+ *
+ *  Copyright UMC Utrecht and contributors
+ *
+ *  Licensed under the Apache License, Version 2.0 (the "License");
+ *  you may not use this file except in compliance with the License.
+ *  You may obtain a copy of the License at
+ *
+ *        http://www.apache.org/licenses/LICENSE-2.0.txt
+ *
+ *  Unless required by applicable law or agreed to in writing, software
+ *  distributed under the License is distributed on an "AS IS" BASIS,
+ *  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *  See the License for the specific language governing permissions and
+ *  limitations under the License.
+ *
+ *=========================================================================*/
+#ifndef __itkRayCastCentralDifferenceDerivative_hxx
+#define __itkRayCastCentralDifferenceDerivative_hxx
+
+#include "itkRayCastCentralDifferenceDerivative.h"
+
+#include <algorithm>
+#include <cmath>
+
+namespace itk
+{
+
+/**
+ * ******************* GetNumberOfPipelines *******************
+ */
+
+template< class TMetric >
+unsigned int
+RayCastCentralDifferenceDerivative< TMetric >
+::GetNumberOfPipelines( const unsigned int numberOfParameters,
+  const ThreadIdType numberOfThreads, const bool useMultiThread )
+{
+  const unsigned int numberOfPipelines = std::min( 2 * numberOfParameters,
+    static_cast< unsigned int >( numberOfThreads ) );
+  if( !useMultiThread || numberOfPipelines < 2 )
+  {
+    return 0;
+  }
+  return numberOfPipelines;
+
+} // end GetNumberOfPipelines()
+
+
+/**
+ * ******************* GetNumberOfThreadsPerPipeline *******************
+ */
+
+template< class TMetric >
+ThreadIdType
+RayCastCentralDifferenceDerivative< TMetric >
+::GetNumberOfThreadsPerPipeline( const ThreadIdType numberOfThreads,
+  const unsigned int numberOfPipelines )
+{
+  if( numberOfPipelines == 0 )
+  {
+    return numberOfThreads;
+  }
+  return std::max( numberOfThreads / numberOfPipelines, static_cast< ThreadIdType >( 1 ) );
+
+} // end GetNumberOfThreadsPerPipeline()
+
+
+/**
+ * ******************* ThreaderCallback *******************
+ */
+
+template< class TMetric >
+ITK_THREAD_RETURN_TYPE
+RayCastCentralDifferenceDerivative< TMetric >
+::ThreaderCallback( void * arg )
+{
+  ThreadInfoType * infoStruct = static_cast< ThreadInfoType * >( arg );
+  ThreadIdType     threadID   = infoStruct->ThreadID;
+
+  ThreaderParameterType * temp
+    = static_cast< ThreaderParameterType * >( infoStruct->UserData );
+
+  if( threadID >= temp->st_NumberOfPipelines )
+  {
+    return ITK_THREAD_RETURN_VALUE;
+  }
+
+  /** Thread i computes the values i, i + N, i + 2N, ..., where value 2k is
+   * for parameter k decreased by delta, and value 2k + 1 for parameter k
+   * increased by delta.
+   */
+  const ParametersType & parameters = *temp->st_Parameters;
+  const ScalesType &     scales     = *temp->st_Scales;
+  ParametersType         testPoint  = parameters;
+  try
+  {
+    for( unsigned int j = threadID; j < temp->st_Values->size(); j += temp->st_NumberOfPipelines )
+    {
+      const unsigned int k     = j / 2;
+      const double       delta = temp->st_DerivativeDelta / std::sqrt( scales[ k ] );
+      testPoint[ k ]            = parameters[ k ] + ( j % 2 == 0 ? -delta : delta );
+      ( *temp->st_Values )[ j ] = temp->st_Metric->ComputePerturbedValue( threadID, testPoint );
+      testPoint[ k ]            = parameters[ k ];
+    }
+  }
+  catch( ExceptionObject & err )
+  {
+    ( *temp->st_Errors )[ threadID ] = err.what();
+  }
+
+  return ITK_THREAD_RETURN_VALUE;
+
+} // end ThreaderCallback()
+
+
+/**
+ * ******************* Compute *******************
+ */
+
+template< class TMetric >
+void
+RayCastCentralDifferenceDerivative< TMetric >
+::Compute( const MetricType * metric, ThreaderType * threader,
+  const ThreadIdType numberOfThreads, const unsigned int numberOfPipelines,
+  const ParametersType & parameters, const ScalesType & scales,
+  const double derivativeDelta, DerivativeType & derivative )
+{
+  const unsigned int numberOfParameters = parameters.GetSize();
+  derivative = DerivativeType( numberOfParameters );
+
+  /** Without copies of the pipeline, the values are computed one by one. */
+  if( numberOfPipelines < 2 )
+  {
+    ParametersType testPoint = parameters;
+    for( unsigned int i = 0; i < numberOfParameters; i++ )
+    {
+      const double delta = derivativeDelta / std::sqrt( scales[ i ] );
+      testPoint[ i ] -= delta;
+      const MeasureType valuep0 = metric->GetValue( testPoint );
+      testPoint[ i ] += 2 * delta;
+      const MeasureType valuep1 = metric->GetValue( testPoint );
+      derivative[ i ] = ( valuep1 - valuep0 ) / ( 2 * delta );
+      testPoint[ i ]  = parameters[ i ];
+    }
+    return;
+  }
+
+  /** For example, the samples are selected before the threads start. */
+  metric->BeforeComputePerturbedValues( parameters );
+
+  /** Setup threader. */
+  std::vector< MeasureType > values( 2 * numberOfParameters );
+  std::vector< std::string > errors( numberOfThreads );
+  ThreaderParameterType      userData;
+  userData.st_Metric            = metric;
+  userData.st_Parameters        = &parameters;
+  userData.st_Scales            = &scales;
+  userData.st_DerivativeDelta   = derivativeDelta;
+  userData.st_Values            = &values;
+  userData.st_Errors            = &errors;
+  userData.st_NumberOfPipelines = std::min( numberOfPipelines,
+    static_cast< unsigned int >( numberOfThreads ) );
+  threader->SetSingleMethod( ThreaderCallback, &userData );
+
+  /** Launch. */
+  threader->SingleMethodExecute();
+
+  /** Pass on the errors of the threads. */
+  for( ThreadIdType i = 0; i < numberOfThreads; i++ )
+  {
+    if( !errors[ i ].empty() )
+    {
+      ExceptionObject err( __FILE__, __LINE__ );
+      err.SetLocation( "RayCastCentralDifferenceDerivative::Compute()" );
+      err.SetDescription( errors[ i ] );
+      throw err;
+    }
+  }
+
+  for( unsigned int i = 0; i < numberOfParameters; i++ )
+  {
+    derivative[ i ] = ( values[ 2 * i + 1 ] - values[ 2 * i ] )
+      / ( 2 * derivativeDelta / std::sqrt( scales[ i ] ) );
+  }
+
+} // end Compute()
+
+
+} // end namespace itk
+
+#endif
@@ -0,0 +1,185 @@
+/*=========================================================================
+ *
+ *  Copyright UMC Utrecht and contributors
+ *
+ *  Licensed under the Apache License, Version 2.0 (the "License");
+ *  you may not use this file except in compliance with the License.
+ *  You may obtain a copy of the License at
+ *
+ *        http://www.apache.org/licenses/LICENSE-2.0.txt
+ *
+ *  Unless required by applicable law or agreed to in writing, software
+ *  distributed under the License is distributed on an "AS IS" BASIS,
+ *  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *  See the License for the specific language governing permissions and
+ *  limitations under the License.
+ *
+ *=========================================================================*/
+#ifndef __itkRayCastProjectionImageFilter_h
+#define __itkRayCastProjectionImageFilter_h
+
+#include "itkImageToImageFilter.h"
+#include "itkAdvancedRayCastInterpolateImageFunction.h"
+
+#include <vector>
+
+namespace itk
+{
+
+/** \class RayCastProjectionImageFilter
+ * \brief Generates a digitally reconstructed radiograph (DRR) in one pass.
+ *
+ * This filter computes a complete projection image of a 3D volume, using
+ * the ray integration of an AdvancedRayCastInterpolateImageFunction. It
+ * replaces the combination of a ResampleImageFilter and the ray cast
+ * interpolator, which evaluates the transform of the focal point for every
+ * single ray.
+ *
+ * The work that is the same for all rays, i.e. mapping the focal point
+ * with the ray caster's transform, is done once in
+ * BeforeThreadedGenerateData(). The rays are then integrated multi-threaded,
+ * where each thread traverses its part of the detector in square tiles
+ * of TileSize x TileSize rays. Neighbouring rays pass through neighbouring
+ * voxels, so this keeps the volume data they touch in cache.
+ *
+ * The detector grid is specified like in the ResampleImageFilter. Each
+ * detector point is mapped by the Transform, and the ray is cast from the
+ * mapped point towards the transformed focal point of the ray caster.
+ *
+ * EvaluateAtIndices() casts the rays of a set of detector pixels only,
+ * without updating the output image, for metrics that only need the
+ * projection at a limited number of samples.
+ *
+ * \ingroup ImageFilters
+ */
+
+template< class TInputImage, class TOutputImage, class TCoordRep = double >
+class RayCastProjectionImageFilter :
+  public ImageToImageFilter< TInputImage, TOutputImage >
+{
+public:
+
+  /** Standard ITK-stuff. */
+  typedef RayCastProjectionImageFilter                    Self;
+  typedef ImageToImageFilter< TInputImage, TOutputImage > Superclass;
+  typedef SmartPointer< Self >                            Pointer;
+  typedef SmartPointer< const Self >                      ConstPointer;
+
+  /** Method for creation through the object factory. */
+  itkNewMacro( Self );
+
+  /** Run-time type information (and related methods). */
+  itkTypeMacro( RayCastProjectionImageFilter, ImageToImageFilter );
+
+  /** Number of dimensions. */
+  itkStaticConstMacro( ImageDimension, unsigned int,
+    TOutputImage::ImageDimension );
+
+  /** Typedefs for the images. */
+  typedef TInputImage                              InputImageType;
+  typedef typename InputImageType::ConstPointer    InputImageConstPointer;
+  typedef TOutputImage                             OutputImageType;
+  typedef typename OutputImageType::Pointer        OutputImagePointer;
+  typedef typename OutputImageType::RegionType     OutputImageRegionType;
+  typedef typename OutputImageType::PixelType      OutputPixelType;
+  typedef typename OutputImageType::SizeType       SizeType;
+  typedef typename OutputImageType::IndexType      IndexType;
+  typedef typename OutputImageType::SpacingType    SpacingType;
+  typedef typename OutputImageType::PointType      OriginPointType;
+  typedef typename OutputImageType::DirectionType  DirectionType;
+  typedef ImageBase< itkGetStaticConstMacro( ImageDimension ) > ImageBaseType;
+
+  /** Typedefs for the ray caster. */
+  typedef AdvancedRayCastInterpolateImageFunction<
+    InputImageType, TCoordRep >                     RayCasterType;
+  typedef typename RayCasterType::Pointer           RayCasterPointer;
+  typedef typename RayCasterType::PointType         PointType;
+  typedef typename RayCasterType::OutputPointType   OutputPointType;
+  typedef typename RayCasterType::TransformType     TransformType;
+  typedef typename TransformType::ConstPointer      TransformConstPointer;
+
+  /** Set/Get the ray caster, which holds the focal point, the threshold
+   * and the transform that moves the focal point.
+   */
+  itkSetObjectMacro( RayCaster, RayCasterType );
+  itkGetModifiableObjectMacro( RayCaster, RayCasterType );
+
+  /** Set/Get the transform that maps the detector points. */
+  itkSetConstObjectMacro( Transform, TransformType );
+  itkGetConstObjectMacro( Transform, TransformType );
+
+  /** Set/Get the output image (detector) information. */
+  itkSetMacro( Size, SizeType );
+  itkGetConstReferenceMacro( Size, SizeType );
+  itkSetMacro( OutputStartIndex, IndexType );
+  itkGetConstReferenceMacro( OutputStartIndex, IndexType );
+  itkSetMacro( OutputSpacing, SpacingType );
+  itkGetConstReferenceMacro( OutputSpacing, SpacingType );
+  itkSetMacro( OutputOrigin, OriginPointType );
+  itkGetConstReferenceMacro( OutputOrigin, OriginPointType );
+  itkSetMacro( OutputDirection, DirectionType );
+  itkGetConstReferenceMacro( OutputDirection, DirectionType );
+
+  /** Helper method to set the output parameters based on an image. */
+  void SetOutputParametersFromImage( const ImageBaseType * image );
+
+  /** Set/Get the number of rays along each side of a tile. Default: 16. */
+  itkSetClampMacro( TileSize, unsigned int, 1, NumericTraits< unsigned int >::max() );
+  itkGetConstMacro( TileSize, unsigned int );
+
+  /** The output image has a different size than the input image. */
+  virtual void GenerateOutputInformation( void );
+
+  /** Every ray may pass through the entire volume. */
+  virtual void GenerateInputRequestedRegion( void );
+
+  /** Compute the projection at the given detector pixels only, for the
+   * current transform. The values equal those of the output image after
+   * an update, but the output image itself is not touched. The input, the
+   * ray caster and the transform should be set.
+   */
+  void EvaluateAtIndices( const std::vector< IndexType > & indices,
+    std::vector< OutputPixelType > & values );
+
+protected:
+
+  RayCastProjectionImageFilter();
+  virtual ~RayCastProjectionImageFilter() {}
+
+  void PrintSelf( std::ostream & os, Indent indent ) const;
+
+  /** Check the inputs, connect the volume to the ray caster and
+   * transform the focal point.
+   */
+  virtual void BeforeThreadedGenerateData( void );
+
+  /** Cast the rays through the tiles of the region of this thread. */
+  virtual void ThreadedGenerateData(
+    const OutputImageRegionType & outputRegionForThread,
+    ThreadIdType threadId );
+
+private:
+
+  RayCastProjectionImageFilter( const Self & ); // purposely not implemented
+  void operator=( const Self & );               // purposely not implemented
+
+  RayCasterPointer      m_RayCaster;
+  TransformConstPointer m_Transform;
+  OutputPointType       m_TransformedFocalPoint;
+  unsigned int          m_TileSize;
+
+  SizeType        m_Size;
+  IndexType       m_OutputStartIndex;
+  SpacingType     m_OutputSpacing;
+  OriginPointType m_OutputOrigin;
+  DirectionType   m_OutputDirection;
+
+};
+
+} // end namespace itk
+
+#ifndef ITK_MANUAL_INSTANTIATION
+#include "itkRayCastProjectionImageFilter.hxx"
+#endif
+
+#endif // end #ifndef __itkRayCastProjectionImageFilter_h
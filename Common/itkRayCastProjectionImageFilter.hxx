@@ -0,0 +1,311 @@
+/*=========================================================================
+ *
+ *  Copyright UMC Utrecht and contributors
+ *
+ *  Licensed under the Apache License, Version 2.0 (the "License");
+ *  you may not use this file except in compliance with the License.
+ *  You may obtain a copy of the License at
+ *
+ *        http://www.apache.org/licenses/LICENSE-2.0.txt
+ *
+ *  Unless required by applicable law or agreed to in writing, software
+ *  distributed under the License is distributed on an "AS IS" BASIS,
+ *  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *  See the License for the specific language governing permissions and
+ *  limitations under the License.
+ *
+ *=========================================================================*/
+#ifndef __itkRayCastProjectionImageFilter_hxx
+#define __itkRayCastProjectionImageFilter_hxx
+
+#include "itkRayCastProjectionImageFilter.h"
+#include "itkImageRegionIteratorWithIndex.h"
+#include "itkProgressReporter.h"
+
+#include <algorithm>
+
+namespace itk
+{
+
+/**
+ * ******************* Constructor *******************
+ */
+
+template< class TInputImage, class TOutputImage, class TCoordRep >
+RayCastProjectionImageFilter< TInputImage, TOutputImage, TCoordRep >
+::RayCastProjectionImageFilter()
+{
+  this->m_TileSize = 16;
+  this->m_TransformedFocalPoint.Fill( 0.0 );
+
+  this->m_Size.Fill( 0 );
+  this->m_OutputStartIndex.Fill( 0 );
+  this->m_OutputSpacing.Fill( 1.0 );
+  this->m_OutputOrigin.Fill( 0.0 );
+  this->m_OutputDirection.SetIdentity();
+
+#if ITK_VERSION_MAJOR >= 5
+  // Use the classic (ITK4) threading model, to ensure ThreadedGenerateData is being called.
+  this->DynamicMultiThreadingOff();
+#endif
+
+} // end Constructor
+
+
+/**
+ * ******************* SetOutputParametersFromImage *******************
+ */
+
+template< class TInputImage, class TOutputImage, class TCoordRep >
+void
+RayCastProjectionImageFilter< TInputImage, TOutputImage, TCoordRep >
+::SetOutputParametersFromImage( const ImageBaseType * image )
+{
+  if( !image )
+  {
+    itkExceptionMacro( << "Cannot use a null image reference" );
+  }
+
+  this->SetOutputOrigin( image->GetOrigin() );
+  this->SetOutputSpacing( image->GetSpacing() );
+  this->SetOutputDirection( image->GetDirection() );
+  this->SetOutputStartIndex( image->GetLargestPossibleRegion().GetIndex() );
+  this->SetSize( image->GetLargestPossibleRegion().GetSize() );
+
+} // end SetOutputParametersFromImage()
+
+
+/**
+ * ******************* GenerateOutputInformation *******************
+ */
+
+template< class TInputImage, class TOutputImage, class TCoordRep >
+void
+RayCastProjectionImageFilter< TInputImage, TOutputImage, TCoordRep >
+::GenerateOutputInformation( void )
+{
+  /** Call the superclass' implementation of this method. */
+  Superclass::GenerateOutputInformation();
+
+  OutputImagePointer outputPtr = this->GetOutput();
+  if( !outputPtr )
+  {
+    return;
+  }
+
+  OutputImageRegionType outputLargestPossibleRegion;
+  outputLargestPossibleRegion.SetSize( this->m_Size );
+  outputLargestPossibleRegion.SetIndex( this->m_OutputStartIndex );
+
+  outputPtr->SetLargestPossibleRegion( outputLargestPossibleRegion );
+  outputPtr->SetSpacing( this->m_OutputSpacing );
+  outputPtr->SetOrigin( this->m_OutputOrigin );
+  outputPtr->SetDirection( this->m_OutputDirection );
+
+} // end GenerateOutputInformation()
+
+
+/**
+ * ******************* GenerateInputRequestedRegion *******************
+ */
+
+template< class TInputImage, class TOutputImage, class TCoordRep >
+void
+RayCastProjectionImageFilter< TInputImage, TOutputImage, TCoordRep >
+::GenerateInputRequestedRegion( void )
+{
+  /** Call the superclass' implementation of this method. */
+  Superclass::GenerateInputRequestedRegion();
+
+  InputImageType * inputPtr = const_cast< InputImageType * >( this->GetInput() );
+  if( inputPtr )
+  {
+    inputPtr->SetRequestedRegionToLargestPossibleRegion();
+  }
+
+} // end GenerateInputRequestedRegion()
+
+
+/**
+ * ******************* BeforeThreadedGenerateData *******************
+ */
+
+template< class TInputImage, class TOutputImage, class TCoordRep >
+void
+RayCastProjectionImageFilter< TInputImage, TOutputImage, TCoordRep >
+::BeforeThreadedGenerateData( void )
+{
+  if( this->m_RayCaster.IsNull() )
+  {
+    itkExceptionMacro( << "RayCaster not set" );
+  }
+  if( this->m_RayCaster->GetTransform() == 0 )
+  {
+    itkExceptionMacro( << "The RayCaster has no transform" );
+  }
+  if( this->m_Transform.IsNull() )
+  {
+    itkExceptionMacro( << "Transform not set" );
+  }
+
+  /** SetInputImage is not thread-safe, so connect the volume here. */
+  if( this->m_RayCaster->GetInputImage() != this->GetInput() )
+  {
+    this->m_RayCaster->SetInputImage( this->GetInput() );
+  }
+
+  /** The focal point is the same for all rays. */
+  this->m_TransformedFocalPoint = this->m_RayCaster->GetTransformedFocalPoint();
+
+} // end BeforeThreadedGenerateData()
+
+
+/**
+ * ******************* ThreadedGenerateData *******************
+ */
+
+template< class TInputImage, class TOutputImage, class TCoordRep >
+void
+RayCastProjectionImageFilter< TInputImage, TOutputImage, TCoordRep >
+::ThreadedGenerateData(
+  const OutputImageRegionType & outputRegionForThread,
+  ThreadIdType threadId )
+{
+  OutputImageType *     outputPtr = this->GetOutput();
+  const RayCasterType * rayCaster = this->m_RayCaster.GetPointer();
+  const TransformType * transform = this->m_Transform.GetPointer();
+
+  ProgressReporter progress( this, threadId, outputRegionForThread.GetNumberOfPixels() );
+
+  /** Tiles span the first two dimensions of the detector,
+   * and have unit size in all other dimensions.
+   */
+  const IndexType & regionIndex = outputRegionForThread.GetIndex();
+  const SizeType &  regionSize  = outputRegionForThread.GetSize();
+  SizeType          tileSize;
+  SizeType          numberOfTiles;
+  for( unsigned int d = 0; d < ImageDimension; ++d )
+  {
+    tileSize[ d ]      = d < 2 ? this->m_TileSize : 1;
+    numberOfTiles[ d ] = ( regionSize[ d ] + tileSize[ d ] - 1 ) / tileSize[ d ];
+  }
+
+  /** Visit the tiles in order, by counting through their indices. */
+  SizeType tileNumber;
+  tileNumber.Fill( 0 );
+  bool moreTiles = outputRegionForThread.GetNumberOfPixels() > 0;
+
+  typedef ImageRegionIteratorWithIndex< OutputImageType > OutputIteratorType;
+  PointType point;
+  while( moreTiles )
+  {
+    /** Compute the region of the current tile. */
+    OutputImageRegionType tile;
+    for( unsigned int d = 0; d < ImageDimension; ++d )
+    {
+      const SizeValueType offset = tileNumber[ d ] * tileSize[ d ];
+      tile.SetIndex( d, regionIndex[ d ] + static_cast< IndexValueType >( offset ) );
+      tile.SetSize( d, std::min( tileSize[ d ], regionSize[ d ] - offset ) );
+    }
+
+    /** Cast the rays of this tile. */
+    OutputIteratorType it( outputPtr, tile );
+    for( it.GoToBegin(); !it.IsAtEnd(); ++it )
+    {
+      outputPtr->TransformIndexToPhysicalPoint( it.GetIndex(), point );
+      const OutputPointType rayPoint = transform->TransformPoint( point );
+      it.Set( static_cast< OutputPixelType >(
+          rayCaster->EvaluateRay( rayPoint, this->m_TransformedFocalPoint ) ) );
+      progress.CompletedPixel();
+    }
+
+    /** Go to the next tile. */
+    moreTiles = false;
+    for( unsigned int d = 0; d < ImageDimension; ++d )
+    {
+      ++tileNumber[ d ];
+      if( tileNumber[ d ] < numberOfTiles[ d ] )
+      {
+        moreTiles = true;
+        break;
+      }
+      tileNumber[ d ] = 0;
+    }
+  }
+
+} // end ThreadedGenerateData()
+
+
+/**
+ * ******************* EvaluateAtIndices *******************
+ */
+
+template< class TInputImage, class TOutputImage, class TCoordRep >
+void
+RayCastProjectionImageFilter< TInputImage, TOutputImage, TCoordRep >
+::EvaluateAtIndices( const std::vector< IndexType > & indices,
+  std::vector< OutputPixelType > & values )
+{
+  /** Check the inputs and transform the focal point, like for an update. */
+  this->BeforeThreadedGenerateData();
+
+  const RayCasterType * rayCaster = this->m_RayCaster.GetPointer();
+  const TransformType * transform = this->m_Transform.GetPointer();
+
+  /** The detector geometry, as in TransformIndexToPhysicalPoint(). */
+  double indexToPoint[ ImageDimension ][ ImageDimension ];
+  for( unsigned int i = 0; i < ImageDimension; ++i )
+  {
+    for( unsigned int j = 0; j < ImageDimension; ++j )
+    {
+      indexToPoint[ i ][ j ] = this->m_OutputDirection[ i ][ j ] * this->m_OutputSpacing[ j ];
+    }
+  }
+
+  values.resize( indices.size() );
+  PointType point;
+  for( std::size_t n = 0; n < indices.size(); ++n )
+  {
+    const IndexType & index = indices[ n ];
+    for( unsigned int i = 0; i < ImageDimension; ++i )
+    {
+      point[ i ] = this->m_OutputOrigin[ i ];
+      for( unsigned int j = 0; j < ImageDimension; ++j )
+      {
+        point[ i ] += indexToPoint[ i ][ j ] * index[ j ];
+      }
+    }
+    const OutputPointType rayPoint = transform->TransformPoint( point );
+    values[ n ] = static_cast< OutputPixelType >(
+      rayCaster->EvaluateRay( rayPoint, this->m_TransformedFocalPoint ) );
+  }
+
+} // end EvaluateAtIndices()
+
+
+/**
+ * ******************* PrintSelf *******************
+ */
+
+template< class TInputImage, class TOutputImage, class TCoordRep >
+void
+RayCastProjectionImageFilter< TInputImage, TOutputImage, TCoordRep >
+::PrintSelf( std::ostream & os, Indent indent ) const
+{
+  Superclass::PrintSelf( os, indent );
+
+  os << indent << "RayCaster: " << this->m_RayCaster.GetPointer() << std::endl;
+  os << indent << "Transform: " << this->m_Transform.GetPointer() << std::endl;
+  os << indent << "TileSize: " << this->m_TileSize << std::endl;
+  os << indent << "Size: " << this->m_Size << std::endl;
+  os << indent << "OutputStartIndex: " << this->m_OutputStartIndex << std::endl;
+  os << indent << "OutputSpacing: " << this->m_OutputSpacing << std::endl;
+  os << indent << "OutputOrigin: " << this->m_OutputOrigin << std::endl;
+  os << indent << "OutputDirection: " << this->m_OutputDirection << std::endl;
+
+} // end PrintSelf()
+
+
+} // end namespace itk
+
+#endif // end #ifndef __itkRayCastProjectionImageFilter_hxx
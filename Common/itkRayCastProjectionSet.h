@@ -0,0 +1,167 @@
+/*=========================================================================
+ *
+ *  Copyright UMC Utrecht and contributors
+ *
+ *  Licensed under the Apache License, Version 2.0 (the "License");
+ *  you may not use this file except in compliance with the License.
+ *  You may obtain a copy of the License at
+ *
+ *        http://www.apache.org/licenses/LICENSE-2.0.txt
+ *
+ *  Unless required by applicable law or agreed to in writing, software
+ *  distributed under the License is distributed on an "AS IS" BASIS,
+ *  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *  See the License for the specific language governing permissions and
+ *  limitations under the License.
+ *
+ *=========================================================================*/
+#ifndef __itkRayCastProjectionSet_h
+#define __itkRayCastProjectionSet_h
+
+#include "itkObject.h"
+#include "itkRayCastProjectionImageFilter.h"
+#include "itkAdvancedCombinationTransform.h"
+
+#include <vector>
+
+namespace itk
+{
+
+/** \class RayCastProjectionSet
+ * \brief A set of independent copies of a ray cast projection pipeline.
+ *
+ * The finite difference derivatives of the 2D-3D metrics need projections
+ * of the moving image for many parameter vectors. This class copies the
+ * pipeline of a RayCastProjectionImageFilter a number of times, such that
+ * different projections can be computed simultaneously by different threads.
+ *
+ * Each copy has its own copy of the registration transform, its own ray
+ * caster and its own projection filter. The initial transforms and the
+ * pixel data of the moving image are shared, and only read. The moving
+ * image is connected through a graft, so updating a copy never touches
+ * the pipeline upstream of the moving image.
+ *
+ * The ray caster transform of the filter should either be the registration
+ * transform itself, or an AdvancedCombinationTransform with the
+ * registration transform as current transform, as set up by the
+ * RayCastInterpolator. Initialize() checks that the copies map points like
+ * the original, and returns false otherwise, for example for a transform
+ * that has more state than its parameters and fixed parameters.
+ *
+ * \ingroup ImageFilters
+ */
+
+template< class TInputImage, class TOutputImage, class TCoordRep = double >
+class RayCastProjectionSet : public Object
+{
+public:
+
+  /** Standard ITK-stuff. */
+  typedef RayCastProjectionSet       Self;
+  typedef Object                     Superclass;
+  typedef SmartPointer< Self >       Pointer;
+  typedef SmartPointer< const Self > ConstPointer;
+
+  /** Method for creation through the object factory. */
+  itkNewMacro( Self );
+
+  /** Run-time type information (and related methods). */
+  itkTypeMacro( RayCastProjectionSet, Object );
+
+  /** Number of dimensions. */
+  itkStaticConstMacro( ImageDimension, unsigned int,
+    TInputImage::ImageDimension );
+
+  /** Typedefs for the images. */
+  typedef TInputImage                           InputImageType;
+  typedef typename InputImageType::Pointer      InputImagePointer;
+  typedef TOutputImage                          OutputImageType;
+
+  /** Typedefs for the projection pipeline. */
+  typedef RayCastProjectionImageFilter<
+    InputImageType, OutputImageType, TCoordRep >    ProjectionFilterType;
+  typedef typename ProjectionFilterType::Pointer    ProjectionFilterPointer;
+  typedef typename ProjectionFilterType::RayCasterType RayCasterType;
+  typedef typename RayCasterType::Pointer           RayCasterPointer;
+  typedef typename RayCasterType::TransformType     RayCasterTransformType;
+  typedef typename RayCasterTransformType::Pointer  RayCasterTransformPointer;
+
+  /** Typedefs for the registration transform. */
+  typedef AdvancedCombinationTransform<
+    TCoordRep, itkGetStaticConstMacro( ImageDimension ) > CombinationTransformType;
+  typedef typename CombinationTransformType::Pointer    CombinationTransformPointer;
+  typedef typename CombinationTransformType::CurrentTransformType CurrentTransformType;
+  typedef typename CombinationTransformType::InitialTransformType InitialTransformType;
+  typedef typename CombinationTransformType::ParametersType       ParametersType;
+  typedef typename CombinationTransformType::InputPointType       PointType;
+
+  /** Copy the pipeline of the filter numberOfProjections times, where the
+   * copies vary the parameters of the registration transform. Returns false,
+   * and leaves the set empty, if the pipeline cannot be copied.
+   */
+  bool Initialize( const ProjectionFilterType * filter,
+    const CombinationTransformType * transform,
+    const unsigned int numberOfProjections );
+
+  /** Get the number of projection pipelines. */
+  unsigned int GetNumberOfProjections( void ) const
+  {
+    return static_cast< unsigned int >( this->m_Projections.size() );
+  }
+
+
+  /** Set the parameters of the transform of projection i. Different
+   * projections can be changed simultaneously.
+   */
+  void SetParameters( const unsigned int i, const ParametersType & parameters );
+
+  /** Get the output of projection i. Updating a filter connected to it,
+   * computes the projection for the last parameters that were set.
+   */
+  OutputImageType * GetOutput( const unsigned int i );
+
+  /** Get the projection filter of copy i, for example to evaluate the
+   * projection at a few pixels only.
+   */
+  ProjectionFilterType * GetFilter( const unsigned int i );
+
+  /** Set the number of threads of each projection filter. */
+  void SetNumberOfThreads( const ThreadIdType numberOfThreads );
+
+protected:
+
+  RayCastProjectionSet() {}
+  virtual ~RayCastProjectionSet() {}
+
+  void PrintSelf( std::ostream & os, Indent indent ) const;
+
+  /** The objects of one copy of the pipeline. */
+  struct ProjectionType
+  {
+    CombinationTransformPointer Transform;
+    RayCasterTransformPointer   RayCasterTransform;
+    RayCasterPointer            RayCaster;
+    InputImagePointer           Volume;
+    ProjectionFilterPointer     Filter;
+  };
+
+  /** Copy the registration transform. Returns 0 if that is not possible. */
+  CombinationTransformPointer CopyTransform(
+    const CombinationTransformType * transform ) const;
+
+private:
+
+  RayCastProjectionSet( const Self & ); // purposely not implemented
+  void operator=( const Self & );       // purposely not implemented
+
+  std::vector< ProjectionType > m_Projections;
+
+};
+
+} // end namespace itk
+
+#ifndef ITK_MANUAL_INSTANTIATION
+#include "itkRayCastProjectionSet.hxx"
+#endif
+
+#endif // end #ifndef __itkRayCastProjectionSet_h
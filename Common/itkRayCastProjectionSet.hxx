@@ -0,0 +1,278 @@
+/*=========================================================================
+ *
+ *  Copyright UMC Utrecht and contributors
+ *
+ *  Licensed under the Apache License, Version 2.0 (the "License");
+ *  you may not use this file except in compliance with the License.
+ *  You may obtain a copy of the License at
+ *
+ *        http://www.apache.org/licenses/LICENSE-2.0.txt
+ *
+ *  Unless required by applicable law or agreed to in writing, software
+ *  distributed under the License is distributed on an "AS IS" BASIS,
+ *  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *  See the License for the specific language governing permissions and
+ *  limitations under the License.
+ *
+ *=========================================================================*/
+#ifndef __itkRayCastProjectionSet_hxx
+#define __itkRayCastProjectionSet_hxx
+
+#include "itkRayCastProjectionSet.h"
+
+namespace itk
+{
+
+/**
+ * ******************* CopyTransform *******************
+ */
+
+template< class TInputImage, class TOutputImage, class TCoordRep >
+typename RayCastProjectionSet< TInputImage, TOutputImage, TCoordRep >::CombinationTransformPointer
+RayCastProjectionSet< TInputImage, TOutputImage, TCoordRep >
+::CopyTransform( const CombinationTransformType * transform ) const
+{
+  /** The current transform is copied through its parameters and fixed
+   * parameters. The initial transform is not changed during the
+   * registration, so it is shared.
+   */
+  const CurrentTransformType * current = transform->GetCurrentTransform();
+  if( current == 0 )
+  {
+    return 0;
+  }
+  typename LightObject::Pointer another = current->CreateAnother();
+  CurrentTransformType *        currentCopy
+    = dynamic_cast< CurrentTransformType * >( another.GetPointer() );
+  if( currentCopy == 0 )
+  {
+    return 0;
+  }
+  currentCopy->SetFixedParameters( current->GetFixedParameters() );
+
+  CombinationTransformPointer copy = CombinationTransformType::New();
+  copy->SetUseComposition( transform->GetUseComposition() );
+  copy->SetUseAddition( transform->GetUseAddition() );
+  copy->SetInitialTransform(
+    const_cast< InitialTransformType * >( transform->GetInitialTransform() ) );
+  copy->SetFlattenedInitialTransform(
+    const_cast< InitialTransformType * >( transform->GetFlattenedInitialTransform() ) );
+  copy->SetCurrentTransform( currentCopy );
+
+  return copy;
+
+} // end CopyTransform()
+
+
+/**
+ * ******************* Initialize *******************
+ */
+
+template< class TInputImage, class TOutputImage, class TCoordRep >
+bool
+RayCastProjectionSet< TInputImage, TOutputImage, TCoordRep >
+::Initialize( const ProjectionFilterType * filter,
+  const CombinationTransformType * transform,
+  const unsigned int numberOfProjections )
+{
+  this->m_Projections.clear();
+  if( filter == 0 || transform == 0 || filter->GetInput() == 0
+    || filter->GetRayCaster() == 0 || numberOfProjections == 0 )
+  {
+    return false;
+  }
+
+  /** Find out how the registration transform is used by the ray caster. */
+  const RayCasterType *          rayCaster          = filter->GetRayCaster();
+  const RayCasterTransformType * rayCasterTransform = rayCaster->GetTransform();
+  if( rayCasterTransform == 0 || filter->GetTransform() != rayCasterTransform )
+  {
+    return false;
+  }
+  const CombinationTransformType * rayCasterCombination
+    = dynamic_cast< const CombinationTransformType * >( rayCasterTransform );
+  const bool composed = rayCasterTransform != transform
+    && rayCasterCombination != 0
+    && rayCasterCombination->GetCurrentTransform() == transform;
+  if( rayCasterTransform != transform && !composed )
+  {
+    return false;
+  }
+
+  /** Build the copies of the pipeline. */
+  this->m_Projections.resize( numberOfProjections );
+  for( unsigned int i = 0; i < numberOfProjections; ++i )
+  {
+    ProjectionType & projection = this->m_Projections[ i ];
+
+    projection.Transform = this->CopyTransform( transform );
+    if( projection.Transform.IsNull() )
+    {
+      this->m_Projections.clear();
+      return false;
+    }
+
+    if( composed )
+    {
+      CombinationTransformPointer combination = CombinationTransformType::New();
+      combination->SetUseComposition( rayCasterCombination->GetUseComposition() );
+      combination->SetUseAddition( rayCasterCombination->GetUseAddition() );
+      combination->SetInitialTransform( const_cast< InitialTransformType * >(
+          rayCasterCombination->GetInitialTransform() ) );
+      combination->SetFlattenedInitialTransform( const_cast< InitialTransformType * >(
+          rayCasterCombination->GetFlattenedInitialTransform() ) );
+      combination->SetCurrentTransform( projection.Transform );
+      projection.RayCasterTransform = combination.GetPointer();
+    }
+    else
+    {
+      projection.RayCasterTransform = projection.Transform.GetPointer();
+    }
+
+    projection.RayCaster = RayCasterType::New();
+    projection.RayCaster->SetTransform( projection.RayCasterTransform );
+    projection.RayCaster->SetFocalPoint( rayCaster->GetFocalPoint() );
+    projection.RayCaster->SetThreshold( rayCaster->GetThreshold() );
+
+    projection.Volume = InputImageType::New();
+    projection.Volume->Graft( filter->GetInput() );
+
+    projection.Filter = ProjectionFilterType::New();
+    projection.Filter->SetRayCaster( projection.RayCaster );
+    projection.Filter->SetTransform( projection.RayCasterTransform );
+    projection.Filter->SetInput( projection.Volume );
+    projection.Filter->SetSize( filter->GetSize() );
+    projection.Filter->SetOutputStartIndex( filter->GetOutputStartIndex() );
+    projection.Filter->SetOutputSpacing( filter->GetOutputSpacing() );
+    projection.Filter->SetOutputOrigin( filter->GetOutputOrigin() );
+    projection.Filter->SetOutputDirection( filter->GetOutputDirection() );
+    projection.Filter->SetTileSize( filter->GetTileSize() );
+  }
+
+  /** Check that a copy maps the corners of the detector and the focal
+   * point like the original, for the current parameters.
+   */
+  this->SetParameters( 0, transform->GetParameters() );
+  const RayCasterTransformType * copy = this->m_Projections[ 0 ].RayCasterTransform;
+
+  std::vector< PointType > points( 1, rayCaster->GetFocalPoint() );
+  for( unsigned int corner = 0; corner < ( 1u << ImageDimension ); ++corner )
+  {
+    PointType point = filter->GetOutputOrigin();
+    for( unsigned int d = 0; d < ImageDimension; ++d )
+    {
+      if( ( corner >> d ) & 1u )
+      {
+        const double length = filter->GetOutputSpacing()[ d ]
+          * ( static_cast< double >( filter->GetSize()[ d ] ) - 1.0 );
+        for( unsigned int e = 0; e < ImageDimension; ++e )
+        {
+          point[ e ] += filter->GetOutputDirection()[ e ][ d ] * length;
+        }
+      }
+    }
+    points.push_back( point );
+  }
+
+  for( unsigned int p = 0; p < points.size(); ++p )
+  {
+    const PointType original = rayCasterTransform->TransformPoint( points[ p ] );
+    const PointType copied   = copy->TransformPoint( points[ p ] );
+    if( original.EuclideanDistanceTo( copied )
+      > 1e-6 * ( 1.0 + original.GetVectorFromOrigin().GetNorm() ) )
+    {
+      this->m_Projections.clear();
+      return false;
+    }
+  }
+
+  return true;
+
+} // end Initialize()
+
+
+/**
+ * ******************* SetParameters *******************
+ */
+
+template< class TInputImage, class TOutputImage, class TCoordRep >
+void
+RayCastProjectionSet< TInputImage, TOutputImage, TCoordRep >
+::SetParameters( const unsigned int i, const ParametersType & parameters )
+{
+  this->m_Projections[ i ].Transform->SetParametersByValue( parameters );
+
+  /** The pipeline does not see changes of the transform. */
+  this->m_Projections[ i ].Filter->Modified();
+
+} // end SetParameters()
+
+
+/**
+ * ******************* GetOutput *******************
+ */
+
+template< class TInputImage, class TOutputImage, class TCoordRep >
+typename RayCastProjectionSet< TInputImage, TOutputImage, TCoordRep >::OutputImageType *
+RayCastProjectionSet< TInputImage, TOutputImage, TCoordRep >
+::GetOutput( const unsigned int i )
+{
+  return this->m_Projections[ i ].Filter->GetOutput();
+
+} // end GetOutput()
+
+
+/**
+ * ******************* GetFilter *******************
+ */
+
+template< class TInputImage, class TOutputImage, class TCoordRep >
+typename RayCastProjectionSet< TInputImage, TOutputImage, TCoordRep >::ProjectionFilterType *
+RayCastProjectionSet< TInputImage, TOutputImage, TCoordRep >
+::GetFilter( const unsigned int i )
+{
+  return this->m_Projections[ i ].Filter;
+
+} // end GetFilter()
+
+
+/**
+ * ******************* SetNumberOfThreads *******************
+ */
+
+template< class TInputImage, class TOutputImage, class TCoordRep >
+void
+RayCastProjectionSet< TInputImage, TOutputImage, TCoordRep >
+::SetNumberOfThreads( const ThreadIdType numberOfThreads )
+{
+  for( unsigned int i = 0; i < this->m_Projections.size(); ++i )
+  {
+#if ITK_VERSION_MAJOR >= 5
+    this->m_Projections[ i ].Filter->SetNumberOfWorkUnits( numberOfThreads );
+#else
+    this->m_Projections[ i ].Filter->SetNumberOfThreads( numberOfThreads );
+#endif
+  }
+
+} // end SetNumberOfThreads()
+
+
+/**
+ * ******************* PrintSelf *******************
+ */
+
+template< class TInputImage, class TOutputImage, class TCoordRep >
+void
+RayCastProjectionSet< TInputImage, TOutputImage, TCoordRep >
+::PrintSelf( std::ostream & os, Indent indent ) const
+{
+  Superclass::PrintSelf( os, indent );
+
+  os << indent << "NumberOfProjections: " << this->m_Projections.size() << std::endl;
+
+} // end PrintSelf()
+
+
+} // end namespace itk
+
+#endif // end #ifndef __itkRayCastProjectionSet_hxx
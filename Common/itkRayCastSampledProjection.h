@@ -0,0 +1,171 @@
+/*=========================================================================
+ *
+ *  Copyright UMC Utrecht and contributors
+ *
+ *  Licensed under the Apache License, Version 2.0 (the "License");
+ *  you may not use this file except in compliance with the License.
+ *  You may obtain a copy of the License at
+ *
+ *        http://www.apache.org/licenses/LICENSE-2.0.txt
+ *
+ *  Unless required by applicable law or agreed to in writing, software
+ *  distributed under the License is distributed on an "AS IS" BASIS,
+ *  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *  See the License for the specific language governing permissions and
+ *  limitations under the License.
+ *
+ *=========================================================================*/
+#ifndef __itkRayCastSampledProjection_h
+#define __itkRayCastSampledProjection_h
+
+#include "itkObject.h"
+#include "itkImageBase.h"
+#include "itkRayCastProjectionImageFilter.h"
+
+#include <vector>
+
+namespace itk
+{
+
+/** \class RayCastSampledProjection
+ * \brief The detector pixels of a projection that are needed at a set of samples.
+ *
+ * The 2D-3D metrics can be evaluated at the samples of an image sampler
+ * only, instead of at all pixels of the fixed image (UseSampledEvaluation).
+ * They then need the projection of the moving image at the samples and at
+ * some neighbours of each sample, for example to compute a gradient. This
+ * class collects these pixels, such that each pixel is cast only once, also
+ * when it is a neighbour of several samples. The cost of the metric then
+ * scales with the number of samples, instead of with the detector size.
+ *
+ * The neighbours are given as a stencil of offsets, which is the same for
+ * all samples. Neighbours outside the detector region are replaced by the
+ * nearest pixel inside the region, like the ZeroFluxNeumannBoundaryCondition
+ * does. UpdateSamples() maps the samples of an image sampler to detector
+ * pixels, and only collects the pixels again when the sampler selected new
+ * samples. Evaluate() casts the rays through all collected pixels with a
+ * RayCastProjectionImageFilter, which can be the filter of the metric, or
+ * one of the copies of a RayCastProjectionSet.
+ *
+ * \ingroup ImageFilters
+ */
+
+template< class TInputImage, class TOutputImage, class TCoordRep = double >
+class RayCastSampledProjection : public Object
+{
+public:
+
+  /** Standard ITK-stuff. */
+  typedef RayCastSampledProjection   Self;
+  typedef Object                     Superclass;
+  typedef SmartPointer< Self >       Pointer;
+  typedef SmartPointer< const Self > ConstPointer;
+
+  /** Method for creation through the object factory. */
+  itkNewMacro( Self );
+
+  /** Run-time type information (and related methods). */
+  itkTypeMacro( RayCastSampledProjection, Object );
+
+  /** Number of dimensions. */
+  itkStaticConstMacro( ImageDimension, unsigned int,
+    TOutputImage::ImageDimension );
+
+  /** Typedefs. */
+  typedef RayCastProjectionImageFilter<
+    TInputImage, TOutputImage, TCoordRep >         ProjectionFilterType;
+  typedef typename ProjectionFilterType::OutputPixelType OutputPixelType;
+  typedef typename TOutputImage::IndexType         IndexType;
+  typedef typename TOutputImage::OffsetType        OffsetType;
+  typedef typename TOutputImage::RegionType        RegionType;
+  typedef std::vector< OffsetType >                StencilType;
+  typedef ImageBase<
+    itkGetStaticConstMacro( ImageDimension ) >     DetectorType;
+
+  /** Set the detector, the region of the detector in which samples are used,
+   * and the stencil of the neighbours. This forgets the current samples.
+   */
+  void Initialize( const DetectorType * detector,
+    const RegionType & sampleRegion, const StencilType & stencil );
+
+  /** Set the samples from the sample container of an image sampler, if the
+   * container was updated since the last call. The samples that do not map
+   * to a pixel of the sample region are skipped. Returns true if the
+   * samples were set.
+   */
+  template< class TSampleContainer >
+  bool UpdateSamples( const TSampleContainer * sampleContainer );
+
+  /** Set the detector pixels of the samples. */
+  void SetSamples( const std::vector< IndexType > & samples );
+
+  /** Get the number of samples. */
+  unsigned int GetNumberOfSamples( void ) const
+  {
+    return static_cast< unsigned int >( this->m_Samples.size() );
+  }
+
+
+  /** Get the detector pixel of sample s. */
+  const IndexType & GetSample( const unsigned int s ) const
+  {
+    return this->m_Samples[ s ];
+  }
+
+
+  /** Get the number of neighbours of each sample. */
+  unsigned int GetStencilSize( void ) const
+  {
+    return static_cast< unsigned int >( this->m_Stencil.size() );
+  }
+
+
+  /** Get the position of neighbour k of sample s in the values computed
+   * by Evaluate().
+   */
+  unsigned int GetPixelNumber( const unsigned int s, const unsigned int k ) const
+  {
+    return this->m_PixelNumbers[ s * this->m_Stencil.size() + k ];
+  }
+
+
+  /** Get all pixels at which the projection is needed. */
+  const std::vector< IndexType > & GetPixels( void ) const
+  {
+    return this->m_Pixels;
+  }
+
+
+  /** Compute the projection at all needed pixels with the given filter. */
+  void Evaluate( ProjectionFilterType * filter,
+    std::vector< OutputPixelType > & values ) const;
+
+protected:
+
+  RayCastSampledProjection();
+  virtual ~RayCastSampledProjection() {}
+
+  void PrintSelf( std::ostream & os, Indent indent ) const;
+
+private:
+
+  RayCastSampledProjection( const Self & ); // purposely not implemented
+  void operator=( const Self & );           // purposely not implemented
+
+  typename DetectorType::ConstPointer m_Detector;
+  RegionType                          m_SampleRegion;
+  StencilType                         m_Stencil;
+  ModifiedTimeType                    m_SamplesUpdateTime;
+  std::vector< IndexType >            m_Samples;
+  std::vector< IndexType >            m_Pixels;
+  std::vector< unsigned int >         m_PixelNumbers;
+
+};
+
+} // end namespace itk
+
+#ifndef ITK_MANUAL_INSTANTIATION
+#include "itkRayCastSampledProjection.hxx"
+#endif
+
+#endif // end #ifndef __itkRayCastSampledProjection_h
@@ -0,0 +1,187 @@
+/*=========================================================================
+ *
+ *  Copyright UMC Utrecht and contributors
+ *
+ *  Licensed under the Apache License, Version 2.0 (the "License");
+ *  you may not use this file except in compliance with the License.
+ *  You may obtain a copy of the License at
+ *
+ *        http://www.apache.org/licenses/LICENSE-2.0.txt
+ *
+ *  Unless required by applicable law or agreed to in writing, software
+ *  distributed under the License is distributed on an "AS IS" BASIS,
+ *  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *  See the License for the specific language governing permissions and
+ *  limitations under the License.
+ *
+ *=========================================================================*/
+#ifndef __itkRayCastSampledProjection_hxx
+#define __itkRayCastSampledProjection_hxx
+
+#include "itkRayCastSampledProjection.h"
+
+#include <algorithm>
+#include <map>
+
+namespace itk
+{
+
+/**
+ * ******************* Constructor *******************
+ */
+
+template< class TInputImage, class TOutputImage, class TCoordRep >
+RayCastSampledProjection< TInputImage, TOutputImage, TCoordRep >
+::RayCastSampledProjection()
+{
+  this->m_SamplesUpdateTime = 0;
+
+} // end Constructor
+
+
+/**
+ * ******************* Initialize *******************
+ */
+
+template< class TInputImage, class TOutputImage, class TCoordRep >
+void
+RayCastSampledProjection< TInputImage, TOutputImage, TCoordRep >
+::Initialize( const DetectorType * detector,
+  const RegionType & sampleRegion, const StencilType & stencil )
+{
+  this->m_Detector          = detector;
+  this->m_SampleRegion      = sampleRegion;
+  this->m_Stencil           = stencil;
+  this->m_SamplesUpdateTime = 0;
+  this->m_Samples.clear();
+  this->m_Pixels.clear();
+  this->m_PixelNumbers.clear();
+
+  this->Modified();
+
+} // end Initialize()
+
+
+/**
+ * ******************* UpdateSamples *******************
+ */
+
+template< class TInputImage, class TOutputImage, class TCoordRep >
+template< class TSampleContainer >
+bool
+RayCastSampledProjection< TInputImage, TOutputImage, TCoordRep >
+::UpdateSamples( const TSampleContainer * sampleContainer )
+{
+  /** Only redo this when the image sampler generated new samples. */
+  if( sampleContainer->GetUpdateMTime() == this->m_SamplesUpdateTime )
+  {
+    return false;
+  }
+  this->m_SamplesUpdateTime = sampleContainer->GetUpdateMTime();
+
+  /** The detector pixels of the samples. */
+  std::vector< IndexType > samples;
+  samples.reserve( sampleContainer->Size() );
+  typename TSampleContainer::ConstIterator fiter;
+  typename TSampleContainer::ConstIterator fbegin = sampleContainer->Begin();
+  typename TSampleContainer::ConstIterator fend   = sampleContainer->End();
+  IndexType index;
+  for( fiter = fbegin; fiter != fend; ++fiter )
+  {
+    if( this->m_Detector->TransformPhysicalPointToIndex(
+      ( *fiter ).Value().m_ImageCoordinates, index )
+      && this->m_SampleRegion.IsInside( index ) )
+    {
+      samples.push_back( index );
+    }
+  }
+
+  this->SetSamples( samples );
+  return true;
+
+} // end UpdateSamples()
+
+
+/**
+ * ******************* SetSamples *******************
+ */
+
+template< class TInputImage, class TOutputImage, class TCoordRep >
+void
+RayCastSampledProjection< TInputImage, TOutputImage, TCoordRep >
+::SetSamples( const std::vector< IndexType > & samples )
+{
+  this->m_Samples = samples;
+  this->m_Pixels.clear();
+  this->m_PixelNumbers.resize( samples.size() * this->m_Stencil.size() );
+
+  /** Number the distinct pixels in the order in which they are found. */
+  typedef std::map< IndexType, unsigned int,
+    Functor::IndexLexicographicCompare< ImageDimension > > PixelMapType;
+  PixelMapType pixelMap;
+
+  const RegionType  region = this->m_Detector->GetLargestPossibleRegion();
+  const IndexType & start  = region.GetIndex();
+  const IndexType   last   = region.GetUpperIndex();
+  for( std::size_t s = 0; s < samples.size(); ++s )
+  {
+    for( std::size_t k = 0; k < this->m_Stencil.size(); ++k )
+    {
+      IndexType pixel = samples[ s ] + this->m_Stencil[ k ];
+      for( unsigned int d = 0; d < ImageDimension; ++d )
+      {
+        pixel[ d ] = std::max( start[ d ], std::min( last[ d ], pixel[ d ] ) );
+      }
+
+      std::pair< typename PixelMapType::iterator, bool > inserted
+        = pixelMap.insert( std::make_pair( pixel,
+        static_cast< unsigned int >( this->m_Pixels.size() ) ) );
+      if( inserted.second )
+      {
+        this->m_Pixels.push_back( pixel );
+      }
+      this->m_PixelNumbers[ s * this->m_Stencil.size() + k ] = inserted.first->second;
+    }
+  }
+
+  this->Modified();
+
+} // end SetSamples()
+
+
+/**
+ * ******************* Evaluate *******************
+ */
+
+template< class TInputImage, class TOutputImage, class TCoordRep >
+void
+RayCastSampledProjection< TInputImage, TOutputImage, TCoordRep >
+::Evaluate( ProjectionFilterType * filter,
+  std::vector< OutputPixelType > & values ) const
+{
+  filter->EvaluateAtIndices( this->m_Pixels, values );
+
+} // end Evaluate()
+
+
+/**
+ * ******************* PrintSelf *******************
+ */
+
+template< class TInputImage, class TOutputImage, class TCoordRep >
+void
+RayCastSampledProjection< TInputImage, TOutputImage, TCoordRep >
+::PrintSelf( std::ostream & os, Indent indent ) const
+{
+  Superclass::PrintSelf( os, indent );
+
+  os << indent << "NumberOfSamples: " << this->m_Samples.size() << std::endl;
+  os << indent << "StencilSize: " << this->m_Stencil.size() << std::endl;
+  os << indent << "NumberOfPixels: " << this->m_Pixels.size() << std::endl;
+
+} // end PrintSelf()
+
+
+} // end namespace itk
+
+#endif // end #ifndef __itkRayCastSampledProjection_hxx
@@ -65,11 +65,13 @@ xoutcell< charT, traits >::WriteBufferedData( void )
 
   const char * charbuf = strbuf.c_str();
 
-  /** Send the string to the outputs */
+  /** Send the string to the outputs. They are not flushed here, but by
+   * the row that owns this cell, once per row or less often.
+   */
   for( CStreamMapIteratorType cit = this->m_COutputs.begin();
     cit != this->m_COutputs.end(); ++cit )
   {
-    *( cit->second ) << charbuf << flush;
+    *( cit->second ) << charbuf;
   }
 
   /** Send the string to the outputs */
@@ -35,6 +35,11 @@ using namespace std;
  * can fill in all this information, and only after calling
  * WriteBufferedData() the entire row is printed to the desired outputs.
  *
+ * The outputs are flushed once every FlushInterval rows, instead of after
+ * every cell, since flushing a file on a network file system for every
+ * iteration may take a considerable part of the registration time.
+ * The default FlushInterval of 1 flushes after every row.
+ *
  * \ingroup xout
  */
 
@@ -76,6 +81,16 @@ public:
    */
   virtual void WriteBufferedData( void );
 
+  /** Set/Get the number of rows after which the outputs are flushed.
+   * A value of 0 means that the outputs are only flushed by Flush().
+   */
+  virtual void SetFlushInterval( unsigned int interval );
+
+  virtual unsigned int GetFlushInterval( void ) const;
+
+  /** Flush the outputs, to write the rows that are still buffered. */
+  virtual void Flush( void );
+
   /** Writes the names of the target cells to the outputs;
    * This method can also be executed by selecting the
    * "WriteHeaders" target: xout["WriteHeaders"]
@@ -117,6 +132,10 @@ protected:
 
   XStreamMapType m_CellMap;
 
+  /** The flush policy. */
+  unsigned int m_FlushInterval;
+  unsigned int m_NumberOfUnflushedRows;
+
 };
 
 } // end namespace xoutlibrary
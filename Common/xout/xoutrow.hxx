@@ -32,7 +32,9 @@ template< class charT, class traits >
 xoutrow< charT, traits >
 ::xoutrow()
 {
-  //nothing
+  this->m_FlushInterval         = 1;
+  this->m_NumberOfUnflushedRows = 0;
+
 } // end Constructor
 
 
@@ -87,9 +89,65 @@ xoutrow< charT, traits >
   *( xit->second ) << "\n";
   xit->second->WriteBufferedData();
 
+  /** Flush the outputs, according to the flush policy. */
+  ++this->m_NumberOfUnflushedRows;
+  if( this->m_FlushInterval > 0
+    && this->m_NumberOfUnflushedRows >= this->m_FlushInterval )
+  {
+    this->Flush();
+  }
+
 } // end WriteBufferedData()
 
 
+/**
+ * ********************* SetFlushInterval ***********************
+ */
+
+template< class charT, class traits >
+void
+xoutrow< charT, traits >
+::SetFlushInterval( unsigned int interval )
+{
+  this->m_FlushInterval = interval;
+
+} // end SetFlushInterval()
+
+
+/**
+ * ********************* GetFlushInterval ***********************
+ */
+
+template< class charT, class traits >
+unsigned int
+xoutrow< charT, traits >
+::GetFlushInterval( void ) const
+{
+  return this->m_FlushInterval;
+
+} // end GetFlushInterval()
+
+
+/**
+ * ************************* Flush ******************************
+ */
+
+template< class charT, class traits >
+void
+xoutrow< charT, traits >
+::Flush( void )
+{
+  for( CStreamMapIteratorType cit = this->m_COutputs.begin();
+    cit != this->m_COutputs.end(); ++cit )
+  {
+    cit->second->flush();
+  }
+
+  this->m_NumberOfUnflushedRows = 0;
+
+} // end Flush()
+
+
 /**
  * ******************** AddTargetCell ***************************
  */
@@ -246,6 +304,13 @@ xoutrow< charT, traits >
   int                    returndummy = 0;
   XStreamMapIteratorType xit;
 
+  /** Write the rows that are still buffered for this output. */
+  CStreamMapIteratorType cit = this->m_COutputs.find( name );
+  if( cit != this->m_COutputs.end() )
+  {
+    cit->second->flush();
+  }
+
   /** Set the output in all cells. */
   for( xit = this->m_XTargetCells.begin(); xit != this->m_XTargetCells.end(); ++xit )
   {
@@ -129,6 +129,9 @@ public:
   /** Update the current resolution level. */
   virtual void BeforeEachResolution( void );
 
+  /** This pyramid may compute only the current level, so it cannot be cached. */
+  virtual bool GetPyramidCanBeCached( void ) const { return false; }
+
 protected:
 
   /** The constructor. */
@@ -19,7 +19,7 @@
 #define __elxBSplineInterpolatorFloat_h
 
 #include "elxIncludes.h" // include first to avoid MSVS warning
-#include "itkBSplineInterpolateImageFunction.h"
+#include "itkMultiThreadedBSplineInterpolateImageFunction.h"
 
 namespace elastix
 {
@@ -49,7 +49,7 @@ namespace elastix
 template< class TElastix >
 class BSplineInterpolatorFloat :
   public
-  itk::BSplineInterpolateImageFunction<
+  itk::MultiThreadedBSplineInterpolateImageFunction<
   typename InterpolatorBase< TElastix >::InputImageType,
   typename InterpolatorBase< TElastix >::CoordRepType,
   float >,        //CoefficientType
@@ -60,7 +60,7 @@ public:
 
   /** Standard ITK-stuff. */
   typedef BSplineInterpolatorFloat Self;
-  typedef itk::BSplineInterpolateImageFunction<
+  typedef itk::MultiThreadedBSplineInterpolateImageFunction<
     typename InterpolatorBase< TElastix >::InputImageType,
     typename InterpolatorBase< TElastix >::CoordRepType,
     float >                                   Superclass1;
@@ -72,7 +72,7 @@ public:
   itkNewMacro( Self );
 
   /** Run-time type information (and related methods). */
-  itkTypeMacro( BSplineInterpolatorFloat, BSplineInterpolateImageFunction );
+  itkTypeMacro( BSplineInterpolatorFloat, MultiThreadedBSplineInterpolateImageFunction );
 
   /** Name of this class.
    * Use this name in the parameter file to select this specific interpolator. \n
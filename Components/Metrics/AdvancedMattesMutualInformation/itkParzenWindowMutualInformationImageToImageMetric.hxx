@@ -425,6 +425,9 @@ ParzenWindowMutualInformationImageToImageMetric< TFixedImage, TMovingImage >
     return this->ComputeDerivativeLowMemorySingleThreaded( derivative );
   }
 
+  /** Decide whether the threads record the parameters they touch. */
+  this->InitializeSparseDerivativeAccumulation();
+
   /** Launch multi-threading derivative computation. */
   this->LaunchComputeDerivativeLowMemoryThreaderCallback();
 
@@ -560,6 +563,7 @@ ParzenWindowMutualInformationImageToImageMetric< TFixedImage, TMovingImage >
       this->UpdateDerivativeLowMemory(
         fixedImageValue, movingImageValue, imageJacobian, nzji,
         derivative );
+      this->RecordTouchedParameters( threadId, nzji );
 
     } // end sampleOk
   } // end loop over sample container
@@ -624,6 +628,11 @@ ParzenWindowMutualInformationImageToImageMetric< TFixedImage, TMovingImage >
     }
   }
 #endif
+  // accumulate only the parameters touched by the samples
+  else if( this->m_UseSparseDerivativeAccumulation )
+  {
+    this->AccumulateSparseDerivatives( derivative, 1.0 );
+  }
   // compute multi-threadedly with itk threads
   else
   {
@@ -620,6 +620,9 @@ AdvancedMeanSquaresImageToImageMetric< TFixedImage, TMovingImage >
    */
   this->BeforeThreadedGetValueAndDerivative( parameters );
 
+  /** Decide whether the threads record the parameters they touch. */
+  this->InitializeSparseDerivativeAccumulation();
+
   /** Launch multi-threading metric */
   this->LaunchGetValueAndDerivativeThreaderCallback();
 
@@ -676,63 +679,70 @@ AdvancedMeanSquaresImageToImageMetric< TFixedImage, TMovingImage >
   unsigned long numberOfPixelsCounted = 0;
   MeasureType   measure               = NumericTraits< MeasureType >::Zero;
 
-  /** Loop over the fixed image to calculate the mean squares. */
-  for( threader_fiter = threader_fbegin; threader_fiter != threader_fend; ++threader_fiter )
+  /** Variables for a block of samples, of which the moving image values and
+   * derivatives are evaluated at once.
+   */
+  const unsigned int        batchSize = Superclass::MovingImageBatchSize;
+  MovingImagePointType      mappedPoints[ Superclass::MovingImageBatchSize ];
+  RealType                  movingImageValues[ Superclass::MovingImageBatchSize ];
+  MovingImageDerivativeType movingImageDerivatives[ Superclass::MovingImageBatchSize ];
+  bool                      samplesOk[ Superclass::MovingImageBatchSize ];
+
+  /** Loop over the fixed image to calculate the mean squares, per block of samples. */
+  threader_fiter = threader_fbegin;
+  while( threader_fiter != threader_fend )
   {
-    /** Read fixed coordinates and initialize some variables. */
-    const FixedImagePointType & fixedPoint = ( *threader_fiter ).Value().m_ImageCoordinates;
-    RealType                    movingImageValue;
-    MovingImagePointType        mappedPoint;
-    MovingImageDerivativeType   movingImageDerivative;
-
-    /** Transform point and check if it is inside the B-spline support region. */
-    bool sampleOk = this->TransformPoint( fixedPoint, mappedPoint );
-
-    /** Check if point is inside mask. */
-    if( sampleOk )
+    /** Transform the points of the block and check if they are inside the
+     * B-spline support region and the moving mask.
+     */
+    const typename ImageSampleContainerType::ConstIterator block_fbegin = threader_fiter;
+    unsigned int numberOfBlockSamples = 0;
+    for( ; threader_fiter != threader_fend && numberOfBlockSamples < batchSize;
+      ++threader_fiter, ++numberOfBlockSamples )
     {
-      sampleOk = this->IsInsideMovingMask( mappedPoint ); // thread-safe?
+      const FixedImagePointType & fixedPoint = ( *threader_fiter ).Value().m_ImageCoordinates;
+      bool &                      sampleOk   = samplesOk[ numberOfBlockSamples ];
+      sampleOk = this->TransformPoint( fixedPoint, mappedPoints[ numberOfBlockSamples ] );
+      if( sampleOk )
+      {
+        sampleOk = this->IsInsideMovingMask( mappedPoints[ numberOfBlockSamples ] );
+      }
     }
 
-    /** Compute the moving image value M(T(x)) and derivative dM/dx and check if
-     * the point is inside the moving image buffer.
+    /** Compute the moving image values M(T(x)) and derivatives dM/dx of the
+     * block and check if the points are inside the moving image buffer.
      */
-    if( sampleOk )
-    {
-      sampleOk = this->EvaluateMovingImageValueAndDerivative(
-        mappedPoint, movingImageValue, &movingImageDerivative );
-    }
+    this->EvaluateMovingImageValuesAndDerivatives( mappedPoints,
+      movingImageValues, movingImageDerivatives, samplesOk, numberOfBlockSamples );
 
-    if( sampleOk )
+    typename ImageSampleContainerType::ConstIterator block_fiter = block_fbegin;
+    for( unsigned int i = 0; i < numberOfBlockSamples; ++i, ++block_fiter )
     {
+      if( !samplesOk[ i ] )
+      {
+        continue;
+      }
       numberOfPixelsCounted++;
 
       /** Get the fixed image value. */
-      const RealType & fixedImageValue
-        = static_cast< RealType >( ( *threader_fiter ).Value().m_ImageValue );
+      const FixedImagePointType & fixedPoint = ( *block_fiter ).Value().m_ImageCoordinates;
+      const RealType &            fixedImageValue
+        = static_cast< RealType >( ( *block_fiter ).Value().m_ImageValue );
 
-#if 0
-      /** Get the TransformJacobian dT/dmu. */
-      this->EvaluateTransformJacobian( fixedPoint, jacobian, nzji );
-
-      /** Compute the inner products (dM/dx)^T (dT/dmu). */
-      this->EvaluateTransformJacobianInnerProduct(
-        jacobian, movingImageDerivative, imageJacobian );
-#else
       /** Compute the inner product of the transform Jacobian dT/dmu and the moving image gradient dM/dx. */
       this->m_AdvancedTransform->EvaluateJacobianWithImageGradientProduct(
-        fixedPoint, movingImageDerivative, imageJacobian, nzji );
-#endif
+        fixedPoint, movingImageDerivatives[ i ], imageJacobian, nzji );
 
       /** Compute this pixel's contribution to the measure and derivatives. */
       this->UpdateValueAndDerivativeTerms(
-        fixedImageValue, movingImageValue,
+        fixedImageValue, movingImageValues[ i ],
         imageJacobian, nzji,
         measure, derivative );
+      this->RecordTouchedParameters( threadId, nzji );
 
-    } // end if sampleOk
+    } // end for loop over the block
 
-  } // end for loop over the image sample container
+  } // end while loop over the image sample container
 
   /** Only update these variables at the end to prevent unnecessary "false sharing". */
   this->m_GetValueAndDerivativePerThreadVariables[ threadId ].st_NumberOfPixelsCounted = numberOfPixelsCounted;
@@ -793,6 +803,11 @@ AdvancedMeanSquaresImageToImageMetric< TFixedImage, TMovingImage >
       derivative += this->m_GetValueAndDerivativePerThreadVariables[ i ].st_Derivative * normal_sum;
     }
   }
+  // accumulate only the parameters touched by the samples
+  else if( this->m_UseSparseDerivativeAccumulation )
+  {
+    this->AccumulateSparseDerivatives( derivative, normal_sum );
+  }
   // compute multi-threadedly with itk threads
   else if( true ) // force ITK threads !this->m_UseOpenMP )
   {
@@ -125,6 +125,9 @@ public:
   typedef typename Superclass::HessianValueType   HessianValueType;
   typedef typename Superclass::HessianType        HessianType;
 
+  /** Typedefs for the shared evaluation of the transform. */
+  typedef typename Superclass::SampleType SampleType;
+
   /** Define the dimension. */
   itkStaticConstMacro( FixedImageDimension, unsigned int, FixedImageType::ImageDimension );
 
@@ -153,6 +156,15 @@ public:
   inline void AfterThreadedGetValueAndDerivative(
     MeasureType & value, DerivativeType & derivative ) const;
 
+  /** The bending energy needs the spatial Hessian and its derivative to mu,
+   * or nothing when the spatial Hessian of the transform is zero.
+   */
+  virtual unsigned int GetSampleRequirements( void ) const;
+
+  /** Add the bending energy of a sample to the variables of a thread. */
+  virtual void AccumulateSample( const ThreadIdType threadId,
+    const SampleType & sample ) const;
+
   /** Experimental feature: compute SelfHessian */
   virtual void GetSelfHessian( const TransformParametersType & parameters, HessianType & H ) const;
 
@@ -408,33 +408,12 @@ void
 TransformBendingEnergyPenaltyTerm< TFixedImage, TScalarType >
 ::ThreadedGetValueAndDerivative( ThreadIdType threadId )
 {
-  /** Create and initialize some variables. */
-  SpatialHessianType           spatialHessian;
-  JacobianOfSpatialHessianType jacobianOfSpatialHessian;
-  NonZeroJacobianIndicesType   nonZeroJacobianIndices;
-  const NumberOfParametersType numberOfNonZeroJacobianIndices
-    = this->m_AdvancedTransform->GetNumberOfNonZeroJacobianIndices();
-  jacobianOfSpatialHessian.resize( numberOfNonZeroJacobianIndices );
-  nonZeroJacobianIndices.resize( numberOfNonZeroJacobianIndices );
-
   /** Check if the SpatialHessian is nonzero. */
-  if( !this->m_AdvancedTransform->GetHasNonZeroSpatialHessian()
-    && !this->m_AdvancedTransform->GetHasNonZeroJacobianOfSpatialHessian() )
+  const unsigned int requirements = this->GetSampleRequirements();
+  if( requirements == 0 )
   {
     return;
   }
-  // TODO: This is only required once! and not every iteration.
-
-  /** Check if this transform is a B-spline transform. */
-  typename BSplineOrder3TransformType::Pointer dummy; // default-constructed (null)
-  bool transformIsBSpline = this->CheckForBSplineTransform2( dummy );
-
-  /** Get a handle to the pre-allocated derivative for the current thread.
-   * The initialization is performed at the beginning of each resolution in
-   * InitializeThreadingParameters(), and at the end of each iteration in
-   * AfterThreadedGetValueAndDerivative() and the accumulate functions.
-   */
-  DerivativeType & derivative = this->m_GetValueAndDerivativePerThreadVariables[ threadId ].st_Derivative;
 
   /** Get a handle to the sample container. */
   ImageSampleContainerPointer sampleContainer     = this->GetImageSampler()->GetOutput();
@@ -457,129 +436,149 @@ TransformBendingEnergyPenaltyTerm< TFixedImage, TScalarType >
   fbegin                                                 += (int)pos_begin;
   fend                                                   += (int)pos_end;
 
-  /** Create variables to store intermediate results. circumvent false sharing */
-  unsigned long numberOfPixelsCounted = 0;
-  MeasureType   measure               = NumericTraits< MeasureType >::Zero;
-
-  /** Loop over the fixed image to calculate the penalty term and its derivative. */
+  /** Loop over the fixed image to calculate the penalty term and its derivative.
+   * Although the mapped point is not needed to compute the penalty term,
+   * EvaluateSample() computes it in order to check if it maps inside the
+   * support region of the B-spline and if it maps inside the moving image mask.
+   */
+  SampleType sample;
   for( fiter = fbegin; fiter != fend; ++fiter )
   {
-    /** Read fixed coordinates and initialize some variables. */
     const FixedImagePointType & fixedPoint = ( *fiter ).Value().m_ImageCoordinates;
-    MovingImagePointType        mappedPoint;
+    if( this->EvaluateSample( fixedPoint, requirements, sample ) )
+    {
+      this->AccumulateSample( threadId, sample );
+    }
+  }
 
-    /** Although the mapped point is not needed to compute the penalty term,
-     * we compute in order to check if it maps inside the support region of
-     * the B-spline and if it maps inside the moving image mask.
-     */
+} // end ThreadedGetValueAndDerivative()
 
-    /** Transform point and check if it is inside the B-spline support region. */
-    bool sampleOk = this->TransformPoint( fixedPoint, mappedPoint );
 
-    /** Check if point is inside mask. */
-    if( sampleOk )
-    {
-      sampleOk = this->IsInsideMovingMask( mappedPoint );
-    }
+/**
+ * ******************* GetSampleRequirements *******************
+ */
 
-    if( sampleOk )
-    {
-      numberOfPixelsCounted++;
+template< class TFixedImage, class TScalarType >
+unsigned int
+TransformBendingEnergyPenaltyTerm< TFixedImage, TScalarType >
+::GetSampleRequirements( void ) const
+{
+  if( !this->m_AdvancedTransform->GetHasNonZeroSpatialHessian()
+    && !this->m_AdvancedTransform->GetHasNonZeroJacobianOfSpatialHessian() )
+  {
+    return 0;
+  }
+  return Superclass::SampleRequiresJacobianOfSpatialHessian;
 
-      /** Get the spatial Hessian of the transformation at the current point.
-       * This is needed to compute the bending energy.
-       */
-      this->m_AdvancedTransform->GetJacobianOfSpatialHessian( fixedPoint,
-        spatialHessian, jacobianOfSpatialHessian, nonZeroJacobianIndices );
+} // end GetSampleRequirements()
 
-      /** Prepare some stuff for the computation of the metric (derivative). */
-      FixedArray< InternalMatrixType, FixedImageDimension > A;
-      for( unsigned int k = 0; k < FixedImageDimension; ++k )
-      {
-        A[ k ] = spatialHessian[ k ].GetVnlMatrix();
-      }
 
-      /** Compute the contribution to the metric value of this point. */
-      for( unsigned int k = 0; k < FixedImageDimension; ++k )
-      {
-        measure += vnl_math_sqr( A[ k ].frobenius_norm() );
-      }
+/**
+ * ******************* AccumulateSample *******************
+ */
 
-      /** Make a distinction between a B-spline transform and other transforms. */
-      if( !transformIsBSpline )
-      {
-        /** Compute the contribution to the metric derivative of this point. */
-        for( unsigned int mu = 0; mu < nonZeroJacobianIndices.size(); ++mu )
-        {
-          for( unsigned int k = 0; k < FixedImageDimension; ++k )
-          {
-            /** This computes:
-             * \sum_i \sum_j A_ij B_ij = element_product(A,B).mean()*B.size()
-             */
-            const InternalMatrixType & B
-              = jacobianOfSpatialHessian[ mu ][ k ].GetVnlMatrix();
+template< class TFixedImage, class TScalarType >
+void
+TransformBendingEnergyPenaltyTerm< TFixedImage, TScalarType >
+::AccumulateSample( const ThreadIdType threadId, const SampleType & sample ) const
+{
+  /** Get a handle to the pre-allocated derivative for the current thread.
+   * The initialization is performed at the beginning of each resolution in
+   * InitializeThreadingParameters(), and at the end of each iteration in
+   * AfterThreadedGetValueAndDerivative() and the accumulate functions.
+   */
+  DerivativeType & derivative = this->m_GetValueAndDerivativePerThreadVariables[ threadId ].st_Derivative;
 
-            RealType matrixElementProduct = 0.0;
-            typename InternalMatrixType::const_iterator itA    = A[ k ].begin();
-            typename InternalMatrixType::const_iterator itB    = B.begin();
-            typename InternalMatrixType::const_iterator itAend = A[ k ].end();
-            while( itA != itAend )
-            {
-              matrixElementProduct += ( *itA ) * ( *itB );
-              ++itA;
-              ++itB;
-            }
+  const JacobianOfSpatialHessianType & jacobianOfSpatialHessian = sample.JacobianOfSpatialHessian;
+  const NonZeroJacobianIndicesType &   nonZeroJacobianIndices   = sample.HessianIndices;
 
-            derivative[ nonZeroJacobianIndices[ mu ] ]
-              += 2.0 * matrixElementProduct;
-          }
-        }
-      }
-      else
+  /** Prepare some stuff for the computation of the metric (derivative). */
+  FixedArray< InternalMatrixType, FixedImageDimension > A;
+  for( unsigned int k = 0; k < FixedImageDimension; ++k )
+  {
+    A[ k ] = sample.SpatialHessian[ k ].GetVnlMatrix();
+  }
+
+  /** Compute the contribution to the metric value of this point. */
+  RealType measure = NumericTraits< RealType >::Zero;
+  for( unsigned int k = 0; k < FixedImageDimension; ++k )
+  {
+    measure += vnl_math_sqr( A[ k ].frobenius_norm() );
+  }
+
+  /** Make a distinction between a B-spline transform and other transforms. */
+  if( !this->m_TransformIsBSpline )
+  {
+    /** Compute the contribution to the metric derivative of this point. */
+    for( unsigned int mu = 0; mu < nonZeroJacobianIndices.size(); ++mu )
+    {
+      for( unsigned int k = 0; k < FixedImageDimension; ++k )
       {
-        /** For the B-spline transform we know that only 1/FixedImageDimension
-         * part of the JacobianOfSpatialHessian is non-zero.
-         *
-         * In addition we know that jsh[ mu + numParPerDim * k ][ k ] is the same for all k.
+        /** This computes:
+         * \sum_i \sum_j A_ij B_ij = element_product(A,B).mean()*B.size()
          */
-
-        /** Compute the contribution to the metric derivative of this point. */
-        const unsigned int numParPerDim
-          = nonZeroJacobianIndices.size() / FixedImageDimension;
-        for( unsigned int mu = 0; mu < numParPerDim; ++mu )
+        const InternalMatrixType & B
+          = jacobianOfSpatialHessian[ mu ][ k ].GetVnlMatrix();
+
+        RealType matrixElementProduct = 0.0;
+        typename InternalMatrixType::const_iterator itA    = A[ k ].begin();
+        typename InternalMatrixType::const_iterator itB    = B.begin();
+        typename InternalMatrixType::const_iterator itAend = A[ k ].end();
+        while( itA != itAend )
         {
-          const InternalMatrixType & B
-            = jacobianOfSpatialHessian[ mu + numParPerDim * 0 ][ 0 ].GetVnlMatrix();
+          matrixElementProduct += ( *itA ) * ( *itB );
+          ++itA;
+          ++itB;
+        }
 
-          for( unsigned int k = 0; k < FixedImageDimension; ++k )
-          {
-            /** This computes:
-             * \sum_i \sum_j A_ij B_ij = element_product(A,B).mean()*B.size()
-             */
-            RealType matrixElementProduct = 0.0;
-            typename InternalMatrixType::const_iterator itA    = A[ k ].begin();
-            typename InternalMatrixType::const_iterator itB    = B.begin();
-            typename InternalMatrixType::const_iterator itAend = A[ k ].end();
-            while( itA != itAend )
-            {
-              matrixElementProduct += ( *itA ) * ( *itB );
-              ++itA;
-              ++itB;
-            }
+        derivative[ nonZeroJacobianIndices[ mu ] ]
+          += 2.0 * matrixElementProduct;
+      }
+    }
+  }
+  else
+  {
+    /** For the B-spline transform we know that only 1/FixedImageDimension
+     * part of the JacobianOfSpatialHessian is non-zero.
+     *
+     * In addition we know that jsh[ mu + numParPerDim * k ][ k ] is the same for all k.
+     */
 
-            derivative[ nonZeroJacobianIndices[ mu + numParPerDim * k ] ]
-              += 2.0 * matrixElementProduct;
-          }
+    /** Compute the contribution to the metric derivative of this point. */
+    const unsigned int numParPerDim
+      = nonZeroJacobianIndices.size() / FixedImageDimension;
+    for( unsigned int mu = 0; mu < numParPerDim; ++mu )
+    {
+      const InternalMatrixType & B
+        = jacobianOfSpatialHessian[ mu + numParPerDim * 0 ][ 0 ].GetVnlMatrix();
+
+      for( unsigned int k = 0; k < FixedImageDimension; ++k )
+      {
+        /** This computes:
+         * \sum_i \sum_j A_ij B_ij = element_product(A,B).mean()*B.size()
+         */
+        RealType matrixElementProduct = 0.0;
+        typename InternalMatrixType::const_iterator itA    = A[ k ].begin();
+        typename InternalMatrixType::const_iterator itB    = B.begin();
+        typename InternalMatrixType::const_iterator itAend = A[ k ].end();
+        while( itA != itAend )
+        {
+          matrixElementProduct += ( *itA ) * ( *itB );
+          ++itA;
+          ++itB;
         }
-      } // end if B-spline
-    } // end if sampleOk
-  }     // end for loop over the image sample container
 
-  /** Only update these variables at the end to prevent unnecessary "false sharing". */
-  this->m_GetValueAndDerivativePerThreadVariables[ threadId ].st_NumberOfPixelsCounted = numberOfPixelsCounted;
-  this->m_GetValueAndDerivativePerThreadVariables[ threadId ].st_Value                 = measure;
+        derivative[ nonZeroJacobianIndices[ mu + numParPerDim * k ] ]
+          += 2.0 * matrixElementProduct;
+      }
+    }
+  } // end if B-spline
 
-} // end ThreadedGetValueAndDerivative()
+  /** The variables of the threads are padded, to prevent false sharing. */
+  this->m_GetValueAndDerivativePerThreadVariables[ threadId ].st_NumberOfPixelsCounted++;
+  this->m_GetValueAndDerivativePerThreadVariables[ threadId ].st_Value += measure;
+
+} // end AccumulateSample()
 
 
 /**
@@ -95,6 +95,9 @@ public:
     ::JacobianOfSpatialHessianType JacobianOfSpatialHessianType;
   typedef typename Superclass::InternalMatrixType InternalMatrixType;
 
+  /** Typedefs for the shared evaluation of the transform. */
+  typedef typename Superclass::SampleType SampleType;
+
   /** Define the dimension. */
   itkStaticConstMacro( FixedImageDimension, unsigned int, FixedImageType::ImageDimension );
 
@@ -117,6 +120,19 @@ public:
     MeasureType & value,
     DerivativeType & derivative ) const;
 
+  /** The displacement magnitude needs the mapped point and the
+   * TransformJacobian.
+   */
+  virtual unsigned int GetSampleRequirements( void ) const
+  {
+    return Superclass::SampleRequiresJacobian;
+  }
+
+
+  /** Add the displacement magnitude of a sample to the variables of a thread. */
+  virtual void AccumulateSample( const ThreadIdType threadId,
+    const SampleType & sample ) const;
+
 protected:
 
   /** Typedefs for indices and points. */
@@ -256,6 +256,46 @@ DisplacementMagnitudePenaltyTerm< TFixedImage, TScalarType >
 } // end GetValueAndDerivative()
 
 
+/**
+ * ******************* AccumulateSample *******************
+ */
+
+template< class TFixedImage, class TScalarType >
+void
+DisplacementMagnitudePenaltyTerm< TFixedImage, TScalarType >
+::AccumulateSample( const ThreadIdType threadId, const SampleType & sample ) const
+{
+  typedef typename MovingImagePointType::VectorType VectorType;
+
+  /** Get a handle to the pre-allocated derivative for the current thread. */
+  DerivativeType & derivative = this->m_GetValueAndDerivativePerThreadVariables[ threadId ].st_Derivative;
+
+  /** Compute displacement */
+  const VectorType vec = sample.MappedPoint - sample.FixedPoint;
+
+  /** Compute the contribution to the derivative; 2 (T(x)-x)' dT/dmu.
+   * The factor 2 originates from the square in ||T(x)-x||^2, and is
+   * applied here, since AfterAccumulateSamples() only divides by the
+   * number of valid samples.
+   */
+  const unsigned long nrNonZeroJacobianIndices = sample.JacobianIndices.size();
+  for( unsigned int d = 0; d < FixedImageDimension; ++d )
+  {
+    const double vecd = 2.0 * vec[ d ];
+    for( unsigned int i = 0; i < nrNonZeroJacobianIndices; ++i )
+    {
+      const unsigned int mu = sample.JacobianIndices[ i ];
+      derivative[ mu ] += vecd * sample.Jacobian( d, i );
+    }
+  }
+
+  /** Compute the contribution to the metric value of this point. */
+  this->m_GetValueAndDerivativePerThreadVariables[ threadId ].st_NumberOfPixelsCounted++;
+  this->m_GetValueAndDerivativePerThreadVariables[ threadId ].st_Value += vec.GetSquaredNorm();
+
+} // end AccumulateSample()
+
+
 } // end namespace itk
 
 #endif // #ifndef __itkDisplacementMagnitudePenaltyTerm_hxx
@@ -28,6 +28,13 @@ namespace elastix
  * \class GradientDifferenceMetric
  * \brief An metric based on the itk::GradientDifferenceImageToImageMetric.
  *
+ * The parameters used in this class are:
+ * \parameter Metric: Select this metric as follows:\n
+ *    <tt>(Metric "GradientDifference")</tt>
+ * \parameter UseSampledEvaluation: Whether the metric is only evaluated at the
+ *    samples of the ImageSampler, see itk::RayCastSampledProjection.\n
+ *    example: <tt>(UseSampledEvaluation "true")</tt>\n
+ *    The default is "false". It can be set per metric, but not per resolution.
  *
  * \ingroup Metrics
  *
@@ -137,6 +144,11 @@ public:
    * \li Set UseNormalization setting
    */
 
+  /** Read UseSampledEvaluation. This is done before the registration
+   * connects the image sampler to the metric.
+   */
+  virtual int BeforeAll( void );
+
   virtual void BeforeRegistration( void );
 
   virtual void BeforeEachResolution( void );
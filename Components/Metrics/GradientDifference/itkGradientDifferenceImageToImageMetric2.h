@@ -40,11 +40,17 @@
 #include "itkNeighborhoodOperatorImageFilter.h"
 #include "itkPoint.h"
 #include "itkCastImageFilter.h"
-#include "itkResampleImageFilter.h"
+#include "itkRayCastProjectionImageFilter.h"
+#include "itkRayCastCentralDifferenceDerivative.h"
+#include "itkRayCastProjectionSet.h"
+#include "itkRayCastSampledProjection.h"
 #include "itkOptimizer.h"
 #include "itkAdvancedCombinationTransform.h"
 #include "itkAdvancedRayCastInterpolateImageFunction.h"
 
+#include <string>
+#include <vector>
+
 namespace itk
 {
 /** \class GradientDifferenceImageToImageMetric
@@ -64,6 +70,16 @@ namespace itk
  * on it. Values at these non-grid position of the Fixed image are
  * interpolated using a user-selected Interpolator.
  *
+ * The derivative is computed by central finite differences. If the
+ * metric is multi-threaded, the 2P perturbed values are computed
+ * simultaneously, where each thread uses its own copy of the moved image
+ * pipeline (projection, cast and Sobel filters), and the gradients of the
+ * fixed image are shared.
+ *
+ * If UseSampledEvaluation is set, the metric is only evaluated at the
+ * samples of the image sampler, see RayCastSampledProjection. The Sobel
+ * operators are then applied to the ray-cast neighbours of the samples.
+ *
  * Implementation of this class is based on:
  * Hipwell, J. H., et. al. (2003), "Intensity-Based 2-D-3D Registration of
  * Cerebral Angiograms,", IEEE Transactions on Medical Imaging,
@@ -100,6 +116,8 @@ public:
 
   typedef typename Superclass::TransformType           TransformType;
   typedef typename TransformType::ScalarType           ScalarType;
+  typedef typename Superclass::ThreaderType            ThreaderType;
+  typedef typename Superclass::ThreadInfoType          ThreadInfoType;
   typedef typename Superclass::TransformPointer        TransformPointer;
   typedef typename Superclass::TransformParametersType TransformParametersType;
   typedef typename Superclass::TransformJacobianType   TransformJacobianType;
@@ -127,8 +145,13 @@ public:
   typedef typename CombinationTransformType::Pointer CombinationTransformPointer;
   typedef itk::Image< FixedImagePixelType, itkGetStaticConstMacro( FixedImageDimension ) >
     TransformedMovingImageType;
-  typedef itk::ResampleImageFilter< MovingImageType, TransformedMovingImageType >
+  typedef itk::RayCastProjectionImageFilter< MovingImageType, TransformedMovingImageType, ScalarType >
     TransformMovingImageFilterType;
+  typedef itk::RayCastProjectionSet< MovingImageType, TransformedMovingImageType, ScalarType >
+    ProjectionSetType;
+  typedef itk::RayCastSampledProjection< MovingImageType, TransformedMovingImageType, ScalarType >
+    SampledProjectionType;
+  typedef typename SampledProjectionType::OutputPixelType SampledPixelType;
   typedef typename itk::AdvancedRayCastInterpolateImageFunction<
     MovingImageType, ScalarType >             RayCastInterpolatorType;
   typedef typename RayCastInterpolatorType::Pointer RayCastInterpolatorPointer;
@@ -170,6 +193,21 @@ public:
   itkSetMacro( DerivativeDelta, double );
   itkGetConstReferenceMacro( DerivativeDelta, double );
 
+  /** Set/Get whether the metric is only evaluated at the samples of the
+   * image sampler. This is the same as UseImageSampler. Default: false.
+   */
+  virtual void SetUseSampledEvaluation( const bool _arg )
+  {
+    this->SetUseImageSampler( _arg );
+  }
+
+
+  virtual bool GetUseSampledEvaluation( void ) const
+  {
+    return this->GetUseImageSampler();
+  }
+
+
 protected:
 
   GradientDifferenceImageToImageMetric();
@@ -177,7 +215,8 @@ protected:
   void PrintSelf( std::ostream & os, Indent indent ) const;
 
   /** Compute the range of the moved image gradients. */
-  void ComputeMovedGradientRange( void ) const;
+  void ComputeMovedGradientRange( const MovedGradientImageType * const * movedGradients,
+    MovedGradientPixelType * minGradient, MovedGradientPixelType * maxGradient ) const;
 
   /** Compute the variance and range of the moving image gradients. */
   void ComputeVariance( void ) const;
@@ -186,6 +225,33 @@ protected:
   MeasureType ComputeMeasure( const TransformParametersType & parameters,
     const double * subtractionFactor ) const;
 
+  /** Compute the similarity measure from the gradients of a moved image. */
+  MeasureType ComputeMeasureFromGradients( const MovedGradientImageType * const * movedGradients,
+    const double * subtractionFactor ) const;
+
+  /** Compute the factor that scales the moved gradients to the range of
+   * the fixed gradients. It is one if no moved gradient is positive.
+   */
+  MovedGradientPixelType ComputeSubtractionFactor( const unsigned int iDimension,
+    const MovedGradientPixelType maxMovedGradient ) const;
+
+  /** Compute the similarity measure at the samples, from the projection at
+   * the pixels of the sampled projection.
+   */
+  MeasureType ComputeSampledMeasure( const std::vector< SampledPixelType > & movedValues ) const;
+
+  /** Copy the moved image pipeline for each thread of GetDerivative(). */
+  void InitializePerturbedProjections( void );
+
+  /** Compute the value for the parameters with copy i of the moved image
+   * pipeline. Different copies can be used simultaneously.
+   */
+  MeasureType ComputePerturbedValue( const unsigned int i,
+    const TransformParametersType & parameters ) const;
+
+  /** Select the samples before the perturbed values are computed. */
+  void BeforeComputePerturbedValues( const TransformParametersType & parameters ) const;
+
   typedef NeighborhoodOperatorImageFilter<
     FixedGradientImageType, FixedGradientImageType > FixedSobelFilter;
 
@@ -197,6 +263,10 @@ private:
   GradientDifferenceImageToImageMetric( const Self & ); // purposely not implemented
   void operator=( const Self & );                       // purposely not implemented
 
+  /** Computes the perturbed values of GetDerivative(). */
+  typedef RayCastCentralDifferenceDerivative< Self > CentralDifferenceDerivativeType;
+  friend class RayCastCentralDifferenceDerivative< Self >;
+
   /** The variance of the moving image gradients. */
   mutable MovedGradientPixelType m_Variance[ FixedImageDimension ];
 
@@ -234,6 +304,14 @@ private:
   typename MovedSobelFilter::Pointer m_MovedSobelFilters[ itkGetStaticConstMacro
     ( MovedImageDimension ) ];
 
+  /** The pixels of the projection needed for sampled evaluation. */
+  typename SampledProjectionType::Pointer m_SampledProjection;
+
+  /** The copies of the moved image pipeline used by GetDerivative(). */
+  typename ProjectionSetType::Pointer               m_PerturbedProjections;
+  std::vector< CastMovedImageFilterPointer >        m_PerturbedCastFilters;
+  std::vector< typename MovedSobelFilter::Pointer > m_PerturbedMovedSobelFilters;
+
   ScalesType                  m_Scales;
   double                      m_DerivativeDelta;
   double                      m_Rescalingfactor;
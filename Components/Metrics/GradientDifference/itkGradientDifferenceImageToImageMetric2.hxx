@@ -40,6 +40,7 @@
 #include "itkRescaleIntensityImageFilter.h"
 #include "itkImageFileWriter.h"
 
+#include <algorithm>
 #include <iostream>
 #include <iomanip>
 #include <stdio.h>
@@ -62,6 +63,8 @@ GradientDifferenceImageToImageMetric< TFixedImage, TMovingImage >
   this->m_CastFixedImageFilter       = CastFixedImageFilterType::New();
   this->m_CombinationTransform       = CombinationTransformType::New();
   this->m_TransformMovingImageFilter = TransformMovingImageFilterType::New();
+  this->m_PerturbedProjections       = ProjectionSetType::New();
+  this->m_SampledProjection          = SampledProjectionType::New();
 
   for( iDimension = 0; iDimension < FixedImageDimension; iDimension++ )
   {
@@ -123,9 +126,8 @@ GradientDifferenceImageToImageMetric< TFixedImage, TMovingImage >
                        << "only suitable for 2D-3D registration.\n"
                        << "  Therefore it expects an interpolator of type RayCastInterpolator." );
   }
-  this->m_TransformMovingImageFilter->SetInterpolator( this->m_Interpolator );
+  this->m_TransformMovingImageFilter->SetRayCaster( rayCaster );
   this->m_TransformMovingImageFilter->SetInput( this->m_MovingImage );
-  this->m_TransformMovingImageFilter->SetDefaultPixelValue( 0 );
   this->m_TransformMovingImageFilter->SetSize( this->m_FixedImage->GetLargestPossibleRegion().GetSize() );
   this->m_TransformMovingImageFilter->SetOutputOrigin( this->m_FixedImage->GetOrigin() );
   this->m_TransformMovingImageFilter->SetOutputSpacing( this->m_FixedImage->GetSpacing() );
@@ -149,6 +151,21 @@ GradientDifferenceImageToImageMetric< TFixedImage, TMovingImage >
   /** Compute the variance */
   ComputeVariance();
 
+  /** The neighbours of the samples are those of the Sobel operators, which
+   * all have the same size. The pixels are collected again for the samples
+   * of this resolution.
+   */
+  typename SampledProjectionType::StencilType stencil;
+  for( unsigned int k = 0; k < this->m_MovedSobelOperators[ 0 ].Size(); k++ )
+  {
+    stencil.push_back( this->m_MovedSobelOperators[ 0 ].GetOffset( k ) );
+  }
+  this->m_SampledProjection->Initialize( this->m_FixedImage,
+    this->GetFixedImageRegion(), stencil );
+
+  /** Copy the moved image pipeline for GetDerivative(). */
+  this->InitializePerturbedProjections();
+
   /* Rescale the similarity measure between 0-1; */
   MeasureType tmpmeasure = this->GetValue( this->m_Transform->GetParameters() );
 
@@ -182,7 +199,8 @@ GradientDifferenceImageToImageMetric< TFixedImage, TMovingImage >
 template< class TFixedImage, class TMovingImage >
 void
 GradientDifferenceImageToImageMetric< TFixedImage, TMovingImage >
-::ComputeMovedGradientRange( void ) const
+::ComputeMovedGradientRange( const MovedGradientImageType * const * movedGradients,
+  MovedGradientPixelType * minGradient, MovedGradientPixelType * maxGradient ) const
 {
   unsigned int           iDimension;
   MovedGradientPixelType gradient;
@@ -192,26 +210,26 @@ GradientDifferenceImageToImageMetric< TFixedImage, TMovingImage >
     typedef itk::ImageRegionConstIteratorWithIndex<
       MovedGradientImageType > IteratorType;
 
-    IteratorType iterate( m_MovedSobelFilters[ iDimension ]->GetOutput(),
+    IteratorType iterate( movedGradients[ iDimension ],
     this->GetFixedImageRegion() );
 
     gradient = iterate.Get();
 
-    m_MinMovedGradient[ iDimension ] = gradient;
-    m_MaxMovedGradient[ iDimension ] = gradient;
+    minGradient[ iDimension ] = gradient;
+    maxGradient[ iDimension ] = gradient;
 
     while( !iterate.IsAtEnd() )
     {
       gradient = iterate.Get();
 
-      if( gradient > m_MaxMovedGradient[ iDimension ] )
+      if( gradient > maxGradient[ iDimension ] )
       {
-        m_MaxMovedGradient[ iDimension ] = gradient;
+        maxGradient[ iDimension ] = gradient;
       }
 
-      if( gradient < m_MinMovedGradient[ iDimension ] )
+      if( gradient < minGradient[ iDimension ] )
       {
-        m_MinMovedGradient[ iDimension ] = gradient;
+        minGradient[ iDimension ] = gradient;
       }
 
       ++iterate;
@@ -369,10 +387,36 @@ GradientDifferenceImageToImageMetric< TFixedImage, TMovingImage >
   this->BeforeThreadedGetValueAndDerivative( parameters );
   //this->SetTransformParameters( parameters );
 
-  unsigned int iDimension;
   this->m_TransformMovingImageFilter->Modified();
   this->m_TransformMovingImageFilter->UpdateLargestPossibleRegion();
-  MeasureType measure = NumericTraits< MeasureType >::Zero;
+
+  const MovedGradientImageType * movedGradients[ MovedImageDimension ];
+  for( unsigned int iFilter = 0; iFilter < MovedImageDimension; iFilter++ )
+  {
+    this->m_MovedSobelFilters[ iFilter ]->UpdateLargestPossibleRegion();
+    movedGradients[ iFilter ] = this->m_MovedSobelFilters[ iFilter ]->GetOutput();
+  }
+
+  return this->ComputeMeasureFromGradients( movedGradients, subtractionFactor );
+
+} // end ComputeMeasure()
+
+
+/**
+ * ******************** ComputeMeasureFromGradients ******************************
+ */
+
+template< class TFixedImage, class TMovingImage >
+typename GradientDifferenceImageToImageMetric< TFixedImage, TMovingImage >::MeasureType
+GradientDifferenceImageToImageMetric< TFixedImage, TMovingImage >
+::ComputeMeasureFromGradients( const MovedGradientImageType * const * movedGradients,
+  const double * subtractionFactor ) const
+{
+  /** The gradients of the fixed image are computed once, in Initialize(),
+   * and are only read here.
+   */
+  unsigned int iDimension;
+  MeasureType  measure = NumericTraits< MeasureType >::Zero;
 
   typename FixedImageType::IndexType currentIndex;
   typename FixedImageType::PointType point;
@@ -402,12 +446,9 @@ GradientDifferenceImageToImageMetric< TFixedImage, TMovingImage >
     typedef  itk::ImageRegionConstIteratorWithIndex< MovedGradientImageType >
       MovedIteratorType;
 
-    MovedIteratorType movedIterator( this->m_MovedSobelFilters[ iDimension ]->GetOutput(),
+    MovedIteratorType movedIterator( movedGradients[ iDimension ],
     this->GetFixedImageRegion() );
 
-    this->m_FixedSobelFilters[ iDimension ]->UpdateLargestPossibleRegion();
-    this->m_MovedSobelFilters[ iDimension ]->UpdateLargestPossibleRegion();
-
     bool sampleOK = false;
 
     if( this->m_FixedImageMask.IsNull() )
@@ -452,7 +493,92 @@ GradientDifferenceImageToImageMetric< TFixedImage, TMovingImage >
 
   return measure /= -this->m_Rescalingfactor; //negative for minimization
 
-} // end ComputeMeasure()
+} // end ComputeMeasureFromGradients()
+
+
+/**
+ * ******************** ComputeSubtractionFactor ******************************
+ */
+
+template< class TFixedImage, class TMovingImage >
+typename GradientDifferenceImageToImageMetric< TFixedImage, TMovingImage >::MovedGradientPixelType
+GradientDifferenceImageToImageMetric< TFixedImage, TMovingImage >
+::ComputeSubtractionFactor( const unsigned int iDimension,
+  const MovedGradientPixelType maxMovedGradient ) const
+{
+  /** Avoid a division by zero, or a change of sign of the moved gradients,
+   * for example for a moved image without structure.
+   */
+  if( maxMovedGradient <= NumericTraits< MovedGradientPixelType >::Zero )
+  {
+    return NumericTraits< MovedGradientPixelType >::One;
+  }
+
+  return this->m_MaxFixedGradient[ iDimension ] / maxMovedGradient;
+
+} // end ComputeSubtractionFactor()
+
+
+/**
+ * ******************** ComputeSampledMeasure ******************************
+ */
+
+template< class TFixedImage, class TMovingImage >
+typename GradientDifferenceImageToImageMetric< TFixedImage, TMovingImage >::MeasureType
+GradientDifferenceImageToImageMetric< TFixedImage, TMovingImage >
+::ComputeSampledMeasure( const std::vector< SampledPixelType > & movedValues ) const
+{
+  /** Apply the Sobel operators to the projection at the neighbours of the
+   * samples, as the Sobel filters would do at the samples.
+   */
+  const SampledProjectionType * sampled         = this->m_SampledProjection;
+  const unsigned int            numberOfSamples = sampled->GetNumberOfSamples();
+  const unsigned int            stencilSize     = sampled->GetStencilSize();
+  std::vector< MovedGradientPixelType > movedGradients( numberOfSamples * MovedImageDimension );
+
+  MovedGradientPixelType maxMovedGradient[ MovedImageDimension ];
+  for( unsigned int iDimension = 0; iDimension < MovedImageDimension; iDimension++ )
+  {
+    maxMovedGradient[ iDimension ] = NumericTraits< MovedGradientPixelType >::NonpositiveMin();
+    for( unsigned int s = 0; s < numberOfSamples; s++ )
+    {
+      MovedGradientPixelType gradient = NumericTraits< MovedGradientPixelType >::Zero;
+      for( unsigned int k = 0; k < stencilSize; k++ )
+      {
+        gradient += this->m_MovedSobelOperators[ iDimension ][ k ]
+          * static_cast< MovedGradientPixelType >( movedValues[ sampled->GetPixelNumber( s, k ) ] );
+      }
+      movedGradients[ s * MovedImageDimension + iDimension ] = gradient;
+      maxMovedGradient[ iDimension ] = std::max( maxMovedGradient[ iDimension ], gradient );
+    }
+  }
+
+  /** Compare with the gradients of the fixed image at the samples. */
+  MeasureType measure = NumericTraits< MeasureType >::Zero;
+  for( unsigned int iDimension = 0; iDimension < FixedImageDimension; iDimension++ )
+  {
+    if( this->m_Variance[ iDimension ] == NumericTraits< MovedGradientPixelType >::ZeroValue() )
+    {
+      continue;
+    }
+
+    const MovedGradientPixelType subtractionFactor
+      = this->ComputeSubtractionFactor( iDimension, maxMovedGradient[ iDimension ] );
+    const FixedGradientImageType * fixedGradients
+      = this->m_FixedSobelFilters[ iDimension ]->GetOutput();
+
+    for( unsigned int s = 0; s < numberOfSamples; s++ )
+    {
+      const FixedGradientPixelType fixedGradient = fixedGradients->GetPixel( sampled->GetSample( s ) );
+      const MovedGradientPixelType diff          = fixedGradient
+        - subtractionFactor * movedGradients[ s * MovedImageDimension + iDimension ];
+      measure += this->m_Variance[ iDimension ] / ( this->m_Variance[ iDimension ] + diff * diff );
+    }
+  }
+
+  return measure /= -this->m_Rescalingfactor; //negative for minimization
+
+} // end ComputeSampledMeasure()
 
 
 /**
@@ -464,6 +590,17 @@ typename GradientDifferenceImageToImageMetric< TFixedImage, TMovingImage >::Meas
 GradientDifferenceImageToImageMetric< TFixedImage, TMovingImage >
 ::GetValue( const TransformParametersType & parameters ) const
 {
+  /** Only cast the rays that are needed at the samples. */
+  if( this->GetUseSampledEvaluation() )
+  {
+    this->BeforeThreadedGetValueAndDerivative( parameters );
+    this->m_SampledProjection->UpdateSamples( this->GetImageSampler()->GetOutput() );
+    std::vector< SampledPixelType > movedValues;
+    this->m_SampledProjection->Evaluate( this->m_TransformMovingImageFilter, movedValues );
+    this->m_NumberOfPixelsCounted = this->m_SampledProjection->GetNumberOfSamples();
+    return this->ComputeSampledMeasure( movedValues );
+  }
+
   unsigned int iFilter;
   unsigned int iDimension;
   this->SetTransformParameters( parameters );
@@ -471,21 +608,24 @@ GradientDifferenceImageToImageMetric< TFixedImage, TMovingImage >
   this->m_TransformMovingImageFilter->UpdateLargestPossibleRegion();
 
   /** Update the gradient images */
+  const MovedGradientImageType * movedGradients[ MovedImageDimension ];
   for( iFilter = 0; iFilter < MovedImageDimension; iFilter++ )
   {
     this->m_MovedSobelFilters[ iFilter ]->UpdateLargestPossibleRegion();
+    movedGradients[ iFilter ] = this->m_MovedSobelFilters[ iFilter ]->GetOutput();
   }
 
   /** Compute the range of the moved image gradients */
-  this->ComputeMovedGradientRange();
+  this->ComputeMovedGradientRange( movedGradients,
+    this->m_MinMovedGradient, this->m_MaxMovedGradient );
 
   MovedGradientPixelType subtractionFactor[ FixedImageDimension ];
   MeasureType            currentMeasure;
 
   for( iDimension = 0; iDimension < FixedImageDimension; iDimension++ )
   {
-    subtractionFactor[ iDimension ] = this->m_MaxFixedGradient[ iDimension ]
-      / this->m_MaxMovedGradient[ iDimension ];
+    subtractionFactor[ iDimension ] = this->ComputeSubtractionFactor(
+      iDimension, this->m_MaxMovedGradient[ iDimension ] );
   }
 
   currentMeasure = this->ComputeMeasure( parameters, subtractionFactor );
@@ -496,30 +636,142 @@ GradientDifferenceImageToImageMetric< TFixedImage, TMovingImage >
 
 
 /**
- * ******************** GetDerivative ******************************
+ * ******************** InitializePerturbedProjections ******************************
  */
 
 template< class TFixedImage, class TMovingImage >
 void
 GradientDifferenceImageToImageMetric< TFixedImage, TMovingImage >
-::GetDerivative( const TransformParametersType & parameters,
-  DerivativeType & derivative ) const
+::InitializePerturbedProjections( void )
 {
-  TransformParametersType testPoint;
-  testPoint = parameters;
-  const unsigned int numberOfParameters = this->GetNumberOfParameters();
-  derivative = DerivativeType( numberOfParameters );
+  this->m_PerturbedCastFilters.clear();
+  this->m_PerturbedMovedSobelFilters.clear();
+
+  /** Without copies, GetDerivative() falls back to calling GetValue(). */
+  const unsigned int numberOfPipelines = CentralDifferenceDerivativeType::GetNumberOfPipelines(
+    this->GetNumberOfParameters(), this->GetNumberOfThreads(), this->m_UseMultiThread );
+  const CombinationTransformType * transform
+    = dynamic_cast< const CombinationTransformType * >( this->m_Transform.GetPointer() );
+  if( !this->m_PerturbedProjections->Initialize(
+    this->m_TransformMovingImageFilter, transform, numberOfPipelines ) )
+  {
+    return;
+  }
 
-  for( unsigned int i = 0; i < numberOfParameters; i++ )
+  /** Divide the threads over the copies of the pipeline. */
+  const ThreadIdType numberOfFilterThreads = CentralDifferenceDerivativeType::GetNumberOfThreadsPerPipeline(
+    this->GetNumberOfThreads(), numberOfPipelines );
+  this->m_PerturbedProjections->SetNumberOfThreads( numberOfFilterThreads );
+
+  for( unsigned int i = 0; i < numberOfPipelines; i++ )
   {
-    testPoint[ i ] -= this->m_DerivativeDelta / std::sqrt( this->m_Scales[ i ] );
-    const MeasureType valuep0 = this->GetValue( testPoint );
-    testPoint[ i ] += 2 * this->m_DerivativeDelta / std::sqrt( this->m_Scales[ i ] );
-    const MeasureType valuep1 = this->GetValue( testPoint );
-    derivative[ i ] = ( valuep1 - valuep0 ) / ( 2 * this->m_DerivativeDelta / std::sqrt( this->m_Scales[ i ] ) );
-    testPoint[ i ]  = parameters[ i ];
+    CastMovedImageFilterPointer castFilter = CastMovedImageFilterType::New();
+    castFilter->SetInput( this->m_PerturbedProjections->GetOutput( i ) );
+#if ITK_VERSION_MAJOR >= 5
+    castFilter->SetNumberOfWorkUnits( numberOfFilterThreads );
+#else
+    castFilter->SetNumberOfThreads( numberOfFilterThreads );
+#endif
+    this->m_PerturbedCastFilters.push_back( castFilter );
+
+    for( unsigned int iFilter = 0; iFilter < MovedImageDimension; iFilter++ )
+    {
+      typename MovedSobelFilter::Pointer sobelFilter = MovedSobelFilter::New();
+      sobelFilter->OverrideBoundaryCondition( &this->m_MovedBoundCond );
+      sobelFilter->SetOperator( this->m_MovedSobelOperators[ iFilter ] );
+      sobelFilter->SetInput( castFilter->GetOutput() );
+#if ITK_VERSION_MAJOR >= 5
+      sobelFilter->SetNumberOfWorkUnits( numberOfFilterThreads );
+#else
+      sobelFilter->SetNumberOfThreads( numberOfFilterThreads );
+#endif
+      this->m_PerturbedMovedSobelFilters.push_back( sobelFilter );
+    }
+  }
+
+} // end InitializePerturbedProjections()
+
+
+/**
+ * ******************** ComputePerturbedValue ******************************
+ */
+
+template< class TFixedImage, class TMovingImage >
+typename GradientDifferenceImageToImageMetric< TFixedImage, TMovingImage >::MeasureType
+GradientDifferenceImageToImageMetric< TFixedImage, TMovingImage >
+::ComputePerturbedValue( const unsigned int i,
+  const TransformParametersType & parameters ) const
+{
+  /** Same as GetValue(), but with copy i of the moved image pipeline. */
+  this->m_PerturbedProjections->SetParameters( i, parameters );
+
+  if( this->GetUseSampledEvaluation() )
+  {
+    std::vector< SampledPixelType > movedValues;
+    this->m_SampledProjection->Evaluate( this->m_PerturbedProjections->GetFilter( i ), movedValues );
+    return this->ComputeSampledMeasure( movedValues );
   }
 
+  const MovedGradientImageType * movedGradients[ MovedImageDimension ];
+  for( unsigned int iFilter = 0; iFilter < MovedImageDimension; iFilter++ )
+  {
+    MovedSobelFilter * sobelFilter
+      = this->m_PerturbedMovedSobelFilters[ i * MovedImageDimension + iFilter ];
+    sobelFilter->UpdateLargestPossibleRegion();
+    movedGradients[ iFilter ] = sobelFilter->GetOutput();
+  }
+
+  MovedGradientPixelType minMovedGradient[ MovedImageDimension ];
+  MovedGradientPixelType maxMovedGradient[ MovedImageDimension ];
+  this->ComputeMovedGradientRange( movedGradients, minMovedGradient, maxMovedGradient );
+
+  MovedGradientPixelType subtractionFactor[ FixedImageDimension ];
+  for( unsigned int iDimension = 0; iDimension < FixedImageDimension; iDimension++ )
+  {
+    subtractionFactor[ iDimension ] = this->ComputeSubtractionFactor(
+      iDimension, maxMovedGradient[ iDimension ] );
+  }
+
+  return this->ComputeMeasureFromGradients( movedGradients, subtractionFactor );
+
+} // end ComputePerturbedValue()
+
+
+/**
+ * ******************** BeforeComputePerturbedValues ******************************
+ */
+
+template< class TFixedImage, class TMovingImage >
+void
+GradientDifferenceImageToImageMetric< TFixedImage, TMovingImage >
+::BeforeComputePerturbedValues( const TransformParametersType & parameters ) const
+{
+  if( this->GetUseSampledEvaluation() )
+  {
+    this->BeforeThreadedGetValueAndDerivative( parameters );
+    this->m_SampledProjection->UpdateSamples( this->GetImageSampler()->GetOutput() );
+  }
+
+} // end BeforeComputePerturbedValues()
+
+
+/**
+ * ******************** GetDerivative ******************************
+ */
+
+template< class TFixedImage, class TMovingImage >
+void
+GradientDifferenceImageToImageMetric< TFixedImage, TMovingImage >
+::GetDerivative( const TransformParametersType & parameters,
+  DerivativeType & derivative ) const
+{
+  /** Compute the perturbed values simultaneously, if the pipeline is copied. */
+  const unsigned int numberOfPipelines = this->m_UseMultiThread
+    ? this->m_PerturbedProjections->GetNumberOfProjections() : 0;
+  CentralDifferenceDerivativeType::Compute( this, this->m_Threader,
+    this->GetNumberOfThreads(), numberOfPipelines, parameters,
+    this->m_Scales, this->m_DerivativeDelta, derivative );
+
 } // end GetDerivative()
 
 
@@ -43,6 +43,23 @@ NormalizedGradientCorrelationMetric< TElastix >
 } // end Initialize()
 
 
+/**
+ * ***************** BeforeAll ***********************
+ */
+
+template< class TElastix >
+int
+NormalizedGradientCorrelationMetric< TElastix >
+::BeforeAll( void )
+{
+  /** The image sampler is only connected if the metric uses it. */
+  this->SetUseSampledEvaluation( this->ReadUseSampledEvaluation() );
+
+  return 0;
+
+} // end BeforeAll()
+
+
 /**
  * ***************** BeforeRegistration ***********************
  */
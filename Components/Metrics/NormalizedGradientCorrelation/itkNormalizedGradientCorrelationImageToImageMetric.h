@@ -23,11 +23,17 @@
 #include "itkNeighborhoodOperatorImageFilter.h"
 #include "itkPoint.h"
 #include "itkCastImageFilter.h"
-#include "itkResampleImageFilter.h"
+#include "itkRayCastProjectionImageFilter.h"
+#include "itkRayCastCentralDifferenceDerivative.h"
+#include "itkRayCastProjectionSet.h"
+#include "itkRayCastSampledProjection.h"
 #include "itkOptimizer.h"
 #include "itkAdvancedCombinationTransform.h"
 #include "itkAdvancedRayCastInterpolateImageFunction.h"
 
+#include <string>
+#include <vector>
+
 namespace itk
 {
 
@@ -35,6 +41,14 @@ namespace itk
  * \class NormalizedGradientCorrelationImageToImageMetric
  * \brief An metric based on the itk::NormalizedGradientCorrelationImageToImageMetric.
  *
+ * The derivative is computed by central finite differences. If the
+ * metric is multi-threaded, the 2P perturbed values are computed
+ * simultaneously, where each thread uses its own copy of the moved image
+ * pipeline, and the gradients of the fixed image are shared.
+ *
+ * If UseSampledEvaluation is set, the metric is only evaluated at the
+ * samples of the image sampler, see RayCastSampledProjection. The means of
+ * the gradients are then also taken over the samples.
  *
  * \ingroup Metrics
  *
@@ -68,6 +82,8 @@ public:
 
   typedef typename Superclass::TransformType           TransformType;
   typedef typename TransformType::ScalarType           ScalarType;
+  typedef typename Superclass::ThreaderType            ThreaderType;
+  typedef typename Superclass::ThreadInfoType          ThreadInfoType;
   typedef typename Superclass::TransformPointer        TransformPointer;
   typedef typename TransformType::ConstPointer         TransformConstPointer;
   typedef typename Superclass::TransformParametersType TransformParametersType;
@@ -99,9 +115,14 @@ public:
   typedef itk::Image< unsigned char,
     itkGetStaticConstMacro( FixedImageDimension ) >   MaskImageType;
   typedef typename MaskImageType::Pointer MaskImageTypePointer;
-  typedef itk::ResampleImageFilter<
-    MovingImageType, TransformedMovingImageType >       TransformMovingImageFilterType;
+  typedef itk::RayCastProjectionImageFilter<
+    MovingImageType, TransformedMovingImageType, ScalarType > TransformMovingImageFilterType;
   typedef typename TransformMovingImageFilterType::Pointer TransformMovingImageFilterPointer;
+  typedef itk::RayCastProjectionSet<
+    MovingImageType, TransformedMovingImageType, ScalarType > ProjectionSetType;
+  typedef itk::RayCastSampledProjection<
+    MovingImageType, TransformedMovingImageType, ScalarType > SampledProjectionType;
+  typedef typename SampledProjectionType::OutputPixelType SampledPixelType;
   typedef typename itk::AdvancedRayCastInterpolateImageFunction
     < MovingImageType, ScalarType >                     RayCastInterpolatorType;
   typedef typename RayCastInterpolatorType::Pointer RayCastInterpolatorPointer;
@@ -152,6 +173,21 @@ public:
   itkSetMacro( DerivativeDelta, double );
   itkGetConstReferenceMacro( DerivativeDelta, double );
 
+  /** Set/Get whether the metric is only evaluated at the samples of the
+   * image sampler. This is the same as UseImageSampler. Default: false.
+   */
+  virtual void SetUseSampledEvaluation( const bool _arg )
+  {
+    this->SetUseImageSampler( _arg );
+  }
+
+
+  virtual bool GetUseSampledEvaluation( void ) const
+  {
+    return this->GetUseImageSampler();
+  }
+
+
   /** Set the parameters defining the Transform. */
   void SetTransformParameters( const TransformParametersType & parameters ) const;
 
@@ -162,13 +198,35 @@ protected:
   virtual void PrintSelf( std::ostream & os, Indent indent ) const;
 
   /** Compute the mean of the fixed and moved image gradients. */
-  void ComputeMeanMovedGradient( void ) const;
+  void ComputeMeanMovedGradient( const MovedGradientImageType * const * movedGradients,
+    MovedGradientPixelType * meanMovedGradient ) const;
 
   void ComputeMeanFixedGradient( void ) const;
 
   /** Compute the similarity measure  */
   MeasureType ComputeMeasure( const TransformParametersType & parameters ) const;
 
+  /** Compute the similarity measure from the gradients of a moved image. */
+  MeasureType ComputeMeasureFromGradients( const MovedGradientImageType * const * movedGradients,
+    const MovedGradientPixelType * meanMovedGradient ) const;
+
+  /** Compute the similarity measure at the samples, from the projection at
+   * the pixels of the sampled projection.
+   */
+  MeasureType ComputeSampledMeasure( const std::vector< SampledPixelType > & movedValues ) const;
+
+  /** Copy the moved image pipeline for each thread of GetDerivative(). */
+  void InitializePerturbedProjections( void );
+
+  /** Compute the value for the parameters with copy i of the moved image
+   * pipeline. Different copies can be used simultaneously.
+   */
+  MeasureType ComputePerturbedValue( const unsigned int i,
+    const TransformParametersType & parameters ) const;
+
+  /** Select the samples before the perturbed values are computed. */
+  void BeforeComputePerturbedValues( const TransformParametersType & parameters ) const;
+
   typedef NeighborhoodOperatorImageFilter<
     FixedGradientImageType, FixedGradientImageType >        FixedSobelFilter;
   typedef NeighborhoodOperatorImageFilter<
@@ -179,6 +237,10 @@ private:
   NormalizedGradientCorrelationImageToImageMetric( const Self & ); // purposely not implemented
   void operator=( const Self & );                                  // purposely not implemented
 
+  /** Computes the perturbed values of GetDerivative(). */
+  typedef RayCastCentralDifferenceDerivative< Self > CentralDifferenceDerivativeType;
+  friend class RayCastCentralDifferenceDerivative< Self >;
+
   ScalesType                  m_Scales;
   double                      m_DerivativeDelta;
   CombinationTransformPointer m_CombinationTransform;
@@ -214,6 +276,14 @@ private:
   typename MovedSobelFilter::Pointer m_MovedSobelFilters[
     itkGetStaticConstMacro( MovedImageDimension ) ];
 
+  /** The pixels of the projection needed for sampled evaluation. */
+  typename SampledProjectionType::Pointer m_SampledProjection;
+
+  /** The copies of the moved image pipeline used by GetDerivative(). */
+  typename ProjectionSetType::Pointer               m_PerturbedProjections;
+  std::vector< CastMovedImageFilterPointer >        m_PerturbedCastFilters;
+  std::vector< typename MovedSobelFilter::Pointer > m_PerturbedMovedSobelFilters;
+
 };
 
 } // end namespace itk
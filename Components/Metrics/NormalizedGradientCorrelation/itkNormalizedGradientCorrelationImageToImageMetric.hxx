@@ -23,6 +23,7 @@
 #include "itkNumericTraits.h"
 #include "itkSimpleFilterWatcher.h"
 
+#include <algorithm>
 #include <iostream>
 #include <iomanip>
 #include <stdio.h>
@@ -42,6 +43,8 @@ NormalizedGradientCorrelationImageToImageMetric< TFixedImage, TMovingImage >
   this->m_CastMovedImageFilter       = CastMovedImageFilterType::New();
   this->m_CombinationTransform       = CombinationTransformType::New();
   this->m_TransformMovingImageFilter = TransformMovingImageFilterType::New();
+  this->m_PerturbedProjections       = ProjectionSetType::New();
+  this->m_SampledProjection          = SampledProjectionType::New();
   this->m_DerivativeDelta            = 0.001;
 
   for( unsigned int iDimension = 0; iDimension < MovedImageDimension; iDimension++ )
@@ -97,9 +100,8 @@ NormalizedGradientCorrelationImageToImageMetric< TFixedImage, TMovingImage >
                        << "only suitable for 2D-3D registration.\n"
                        << "  Therefore it expects an interpolator of type RayCastInterpolator." );
   }
-  this->m_TransformMovingImageFilter->SetInterpolator( this->m_Interpolator );
+  this->m_TransformMovingImageFilter->SetRayCaster( rayCaster );
   this->m_TransformMovingImageFilter->SetInput( this->m_MovingImage );
-  this->m_TransformMovingImageFilter->SetDefaultPixelValue( 0 );
   this->m_TransformMovingImageFilter->SetSize( this->m_FixedImage->GetLargestPossibleRegion().GetSize() );
   this->m_TransformMovingImageFilter->SetOutputOrigin( this->m_FixedImage->GetOrigin() );
   this->m_TransformMovingImageFilter->SetOutputSpacing( this->m_FixedImage->GetSpacing() );
@@ -120,6 +122,21 @@ NormalizedGradientCorrelationImageToImageMetric< TFixedImage, TMovingImage >
     this->m_MovedSobelFilters[ iFilter ]->UpdateLargestPossibleRegion();
   }
 
+  /** Copy the moved image pipeline for GetDerivative(). */
+  this->InitializePerturbedProjections();
+
+  /** The neighbours of the samples are those of the Sobel operators, which
+   * all have the same size. The pixels are collected again for the samples
+   * of this resolution.
+   */
+  typename SampledProjectionType::StencilType stencil;
+  for( unsigned int k = 0; k < this->m_MovedSobelOperators[ 0 ].Size(); k++ )
+  {
+    stencil.push_back( this->m_MovedSobelOperators[ 0 ].GetOffset( k ) );
+  }
+  this->m_SampledProjection->Initialize( this->m_FixedImage,
+    this->GetFixedImageRegion(), stencil );
+
 } // end Initialize()
 
 
@@ -221,22 +238,18 @@ NormalizedGradientCorrelationImageToImageMetric< TFixedImage, TMovingImage >
 template< class TFixedImage, class TMovingImage >
 void
 NormalizedGradientCorrelationImageToImageMetric< TFixedImage, TMovingImage >
-::ComputeMeanMovedGradient( void ) const
+::ComputeMeanMovedGradient( const MovedGradientImageType * const * movedGradients,
+  MovedGradientPixelType * meanMovedGradient ) const
 {
   typename MovedGradientImageType::IndexType currentIndex;
   typename MovedGradientImageType::PointType point;
 
-  for( int iDimension = 0; iDimension < MovedImageDimension; iDimension++ )
-  {
-    this->m_MovedSobelFilters[ iDimension ]->UpdateLargestPossibleRegion();
-  }
-
   typedef  itk::ImageRegionConstIteratorWithIndex< MovedGradientImageType >
     MovedIteratorType;
 
-  MovedIteratorType movedIteratorx( this->m_MovedSobelFilters[ 0 ]->GetOutput(),
+  MovedIteratorType movedIteratorx( movedGradients[ 0 ],
   this->GetFixedImageRegion() );
-  MovedIteratorType movedIteratory( this->m_MovedSobelFilters[ 1 ]->GetOutput(),
+  MovedIteratorType movedIteratory( movedGradients[ 1 ],
   this->GetFixedImageRegion() );
 
   movedIteratorx.GoToBegin();
@@ -288,8 +301,8 @@ NormalizedGradientCorrelationImageToImageMetric< TFixedImage, TMovingImage >
     ++movedIteratory;
   } // end while
 
-  this->m_MeanMovedGradient[ 0 ] = movedGradient[ 0 ] / nPixels;
-  this->m_MeanMovedGradient[ 1 ] = movedGradient[ 1 ] / nPixels;
+  meanMovedGradient[ 0 ] = movedGradient[ 0 ] / nPixels;
+  meanMovedGradient[ 1 ] = movedGradient[ 1 ] / nPixels;
 
 } // end ComputeMeanMovedGradient()
 
@@ -307,6 +320,32 @@ NormalizedGradientCorrelationImageToImageMetric< TFixedImage, TMovingImage >
   this->m_TransformMovingImageFilter->Modified();
   this->m_TransformMovingImageFilter->UpdateLargestPossibleRegion();
 
+  const MovedGradientImageType * movedGradients[ MovedImageDimension ];
+  for( int iDimension = 0; iDimension < MovedImageDimension; iDimension++ )
+  {
+    this->m_MovedSobelFilters[ iDimension ]->UpdateLargestPossibleRegion();
+    movedGradients[ iDimension ] = this->m_MovedSobelFilters[ iDimension ]->GetOutput();
+  }
+
+  this->m_NumberOfPixelsCounted = 0;
+  return this->ComputeMeasureFromGradients( movedGradients, this->m_MeanMovedGradient );
+
+} // end ComputeMeasure()
+
+
+/**
+ * ***************** ComputeMeasureFromGradients *****************
+ */
+
+template< class TFixedImage, class TMovingImage >
+typename NormalizedGradientCorrelationImageToImageMetric< TFixedImage, TMovingImage >::MeasureType
+NormalizedGradientCorrelationImageToImageMetric< TFixedImage, TMovingImage >
+::ComputeMeasureFromGradients( const MovedGradientImageType * const * movedGradients,
+  const MovedGradientPixelType * meanMovedGradient ) const
+{
+  /** The gradients of the fixed image are computed once, in Initialize(),
+   * and are only read here.
+   */
   typename FixedImageType::IndexType currentIndex;
   typename FixedImageType::PointType point;
 
@@ -319,13 +358,6 @@ NormalizedGradientCorrelationImageToImageMetric< TFixedImage, TMovingImage >
   MeasureType NGautocorrelationfixed  = NumericTraits< MeasureType >::Zero;
   MeasureType NGautocorrelationmoving = NumericTraits< MeasureType >::Zero;
 
-  /** Make sure all is updated */
-  for( int iDimension = 0; iDimension < FixedImageDimension; iDimension++ )
-  {
-    this->m_FixedSobelFilters[ iDimension ]->UpdateLargestPossibleRegion();
-    this->m_MovedSobelFilters[ iDimension ]->UpdateLargestPossibleRegion();
-  }
-
   typedef  itk::ImageRegionConstIteratorWithIndex< FixedGradientImageType >
     FixedIteratorType;
 
@@ -340,15 +372,14 @@ NormalizedGradientCorrelationImageToImageMetric< TFixedImage, TMovingImage >
   typedef  itk::ImageRegionConstIteratorWithIndex< MovedGradientImageType >
     MovedIteratorType;
 
-  MovedIteratorType movedIteratorx( this->m_MovedSobelFilters[ 0 ]->GetOutput(),
+  MovedIteratorType movedIteratorx( movedGradients[ 0 ],
   this->GetFixedImageRegion() );
-  MovedIteratorType movedIteratory( this->m_MovedSobelFilters[ 1 ]->GetOutput(),
+  MovedIteratorType movedIteratory( movedGradients[ 1 ],
   this->GetFixedImageRegion() );
 
   movedIteratorx.GoToBegin();
   movedIteratory.GoToBegin();
 
-  this->m_NumberOfPixelsCounted = 0;
   bool sampleOK = false;
 
   if( this->m_FixedImageMask.IsNull() )
@@ -376,9 +407,9 @@ NormalizedGradientCorrelationImageToImageMetric< TFixedImage, TMovingImage >
 
     if( sampleOK )
     {
-      NmovedGradient[ 0 ]      = movedIteratorx.Get() - this->m_MeanMovedGradient[ 0 ];
+      NmovedGradient[ 0 ]      = movedIteratorx.Get() - meanMovedGradient[ 0 ];
       NfixedGradient[ 0 ]      = fixedIteratorx.Get() - this->m_MeanFixedGradient[ 0 ];
-      NmovedGradient[ 1 ]      = movedIteratory.Get() - this->m_MeanMovedGradient[ 1 ];
+      NmovedGradient[ 1 ]      = movedIteratory.Get() - meanMovedGradient[ 1 ];
       NfixedGradient[ 1 ]      = fixedIteratory.Get() - this->m_MeanFixedGradient[ 1 ];
       NGcrosscorrelation      += NmovedGradient[ 0 ] * NfixedGradient[ 0 ] + NmovedGradient[ 1 ] * NfixedGradient[ 1 ];
       NGautocorrelationmoving += NmovedGradient[ 0 ] * NmovedGradient[ 0 ] + NmovedGradient[ 1 ] * NmovedGradient[ 1 ];
@@ -397,7 +428,78 @@ NormalizedGradientCorrelationImageToImageMetric< TFixedImage, TMovingImage >
     / ( std::sqrt( NGautocorrelationfixed ) * std::sqrt( NGautocorrelationmoving ) ) );
   return measure;
 
-} // end ComputeMeasure()
+} // end ComputeMeasureFromGradients()
+
+
+/**
+ * ***************** ComputeSampledMeasure *****************
+ */
+
+template< class TFixedImage, class TMovingImage >
+typename NormalizedGradientCorrelationImageToImageMetric< TFixedImage, TMovingImage >::MeasureType
+NormalizedGradientCorrelationImageToImageMetric< TFixedImage, TMovingImage >
+::ComputeSampledMeasure( const std::vector< SampledPixelType > & movedValues ) const
+{
+  /** Apply the Sobel operators to the projection at the neighbours of the
+   * samples, as the Sobel filters would do at the samples. Like in
+   * ComputeMeasureFromGradients(), only the first two directions are used.
+   */
+  const SampledProjectionType * sampled         = this->m_SampledProjection;
+  const unsigned int            numberOfSamples = sampled->GetNumberOfSamples();
+  const unsigned int            stencilSize     = sampled->GetStencilSize();
+  std::vector< MovedGradientPixelType > movedGradients( numberOfSamples * 2 );
+  std::vector< FixedGradientPixelType > fixedGradients( numberOfSamples * 2 );
+
+  MovedGradientPixelType meanMovedGradient[ 2 ];
+  FixedGradientPixelType meanFixedGradient[ 2 ];
+  for( unsigned int iDimension = 0; iDimension < 2; iDimension++ )
+  {
+    meanMovedGradient[ iDimension ] = NumericTraits< MovedGradientPixelType >::Zero;
+    meanFixedGradient[ iDimension ] = NumericTraits< FixedGradientPixelType >::Zero;
+    const FixedGradientImageType * fixedGradientImage
+      = this->m_FixedSobelFilters[ iDimension ]->GetOutput();
+
+    for( unsigned int s = 0; s < numberOfSamples; s++ )
+    {
+      MovedGradientPixelType gradient = NumericTraits< MovedGradientPixelType >::Zero;
+      for( unsigned int k = 0; k < stencilSize; k++ )
+      {
+        gradient += this->m_MovedSobelOperators[ iDimension ][ k ]
+          * static_cast< MovedGradientPixelType >( movedValues[ sampled->GetPixelNumber( s, k ) ] );
+      }
+      movedGradients[ 2 * s + iDimension ] = gradient;
+      fixedGradients[ 2 * s + iDimension ] = fixedGradientImage->GetPixel( sampled->GetSample( s ) );
+      meanMovedGradient[ iDimension ]     += movedGradients[ 2 * s + iDimension ];
+      meanFixedGradient[ iDimension ]     += fixedGradients[ 2 * s + iDimension ];
+    }
+
+    if( numberOfSamples > 0 )
+    {
+      meanMovedGradient[ iDimension ] /= numberOfSamples;
+      meanFixedGradient[ iDimension ] /= numberOfSamples;
+    }
+  }
+
+  /** Correlate the normalized gradients. */
+  MeasureType NGcrosscorrelation      = NumericTraits< MeasureType >::Zero;
+  MeasureType NGautocorrelationfixed  = NumericTraits< MeasureType >::Zero;
+  MeasureType NGautocorrelationmoving = NumericTraits< MeasureType >::Zero;
+  for( unsigned int s = 0; s < numberOfSamples; s++ )
+  {
+    for( unsigned int iDimension = 0; iDimension < 2; iDimension++ )
+    {
+      const MeasureType NmovedGradient = movedGradients[ 2 * s + iDimension ] - meanMovedGradient[ iDimension ];
+      const MeasureType NfixedGradient = fixedGradients[ 2 * s + iDimension ] - meanFixedGradient[ iDimension ];
+      NGcrosscorrelation      += NmovedGradient * NfixedGradient;
+      NGautocorrelationmoving += NmovedGradient * NmovedGradient;
+      NGautocorrelationfixed  += NfixedGradient * NfixedGradient;
+    }
+  }
+
+  return -1.0 * ( NGcrosscorrelation
+         / ( std::sqrt( NGautocorrelationfixed ) * std::sqrt( NGautocorrelationmoving ) ) );
+
+} // end ComputeSampledMeasure()
 
 
 /**
@@ -425,16 +527,28 @@ NormalizedGradientCorrelationImageToImageMetric< TFixedImage, TMovingImage >
   this->BeforeThreadedGetValueAndDerivative( parameters );
   //this->SetTransformParameters( parameters );
 
+  /** Only cast the rays that are needed at the samples. */
+  if( this->GetUseSampledEvaluation() )
+  {
+    this->m_SampledProjection->UpdateSamples( this->GetImageSampler()->GetOutput() );
+    std::vector< SampledPixelType > movedValues;
+    this->m_SampledProjection->Evaluate( this->m_TransformMovingImageFilter, movedValues );
+    this->m_NumberOfPixelsCounted = this->m_SampledProjection->GetNumberOfSamples();
+    return this->ComputeSampledMeasure( movedValues );
+  }
+
   unsigned int iFilter;
   this->m_TransformMovingImageFilter->Modified();
   this->m_TransformMovingImageFilter->UpdateLargestPossibleRegion();
 
+  const MovedGradientImageType * movedGradients[ MovedImageDimension ];
   for( iFilter = 0; iFilter < MovedImageDimension; iFilter++ )
   {
     this->m_MovedSobelFilters[ iFilter ]->UpdateLargestPossibleRegion();
+    movedGradients[ iFilter ] = this->m_MovedSobelFilters[ iFilter ]->GetOutput();
   }
 
-  this->ComputeMeanMovedGradient();
+  this->ComputeMeanMovedGradient( movedGradients, this->m_MeanMovedGradient );
   MeasureType currentMeasure = this->ComputeMeasure( parameters );
 
   return currentMeasure;
@@ -461,30 +575,134 @@ NormalizedGradientCorrelationImageToImageMetric< TFixedImage, TMovingImage >
 
 
 /**
- * ***************** GetDerivative *****************
+ * ***************** InitializePerturbedProjections *****************
  */
 
 template< class TFixedImage, class TMovingImage >
 void
 NormalizedGradientCorrelationImageToImageMetric< TFixedImage, TMovingImage >
-::GetDerivative( const TransformParametersType & parameters,
-  DerivativeType & derivative ) const
+::InitializePerturbedProjections( void )
+{
+  this->m_PerturbedCastFilters.clear();
+  this->m_PerturbedMovedSobelFilters.clear();
+
+  /** Without copies, GetDerivative() falls back to calling GetValue(). */
+  const unsigned int numberOfPipelines = CentralDifferenceDerivativeType::GetNumberOfPipelines(
+    this->GetNumberOfParameters(), this->GetNumberOfThreads(), this->m_UseMultiThread );
+  const CombinationTransformType * transform
+    = dynamic_cast< const CombinationTransformType * >( this->m_Transform.GetPointer() );
+  if( !this->m_PerturbedProjections->Initialize(
+    this->m_TransformMovingImageFilter, transform, numberOfPipelines ) )
+  {
+    return;
+  }
+
+  /** Divide the threads over the copies of the pipeline. */
+  const ThreadIdType numberOfFilterThreads = CentralDifferenceDerivativeType::GetNumberOfThreadsPerPipeline(
+    this->GetNumberOfThreads(), numberOfPipelines );
+  this->m_PerturbedProjections->SetNumberOfThreads( numberOfFilterThreads );
+
+  for( unsigned int i = 0; i < numberOfPipelines; i++ )
+  {
+    CastMovedImageFilterPointer castFilter = CastMovedImageFilterType::New();
+    castFilter->SetInput( this->m_PerturbedProjections->GetOutput( i ) );
+#if ITK_VERSION_MAJOR >= 5
+    castFilter->SetNumberOfWorkUnits( numberOfFilterThreads );
+#else
+    castFilter->SetNumberOfThreads( numberOfFilterThreads );
+#endif
+    this->m_PerturbedCastFilters.push_back( castFilter );
+
+    for( unsigned int iFilter = 0; iFilter < MovedImageDimension; iFilter++ )
+    {
+      typename MovedSobelFilter::Pointer sobelFilter = MovedSobelFilter::New();
+      sobelFilter->OverrideBoundaryCondition( &this->m_MovedBoundCond );
+      sobelFilter->SetOperator( this->m_MovedSobelOperators[ iFilter ] );
+      sobelFilter->SetInput( castFilter->GetOutput() );
+#if ITK_VERSION_MAJOR >= 5
+      sobelFilter->SetNumberOfWorkUnits( numberOfFilterThreads );
+#else
+      sobelFilter->SetNumberOfThreads( numberOfFilterThreads );
+#endif
+      this->m_PerturbedMovedSobelFilters.push_back( sobelFilter );
+    }
+  }
+
+} // end InitializePerturbedProjections()
+
+
+/**
+ * ***************** ComputePerturbedValue *****************
+ */
+
+template< class TFixedImage, class TMovingImage >
+typename NormalizedGradientCorrelationImageToImageMetric< TFixedImage, TMovingImage >::MeasureType
+NormalizedGradientCorrelationImageToImageMetric< TFixedImage, TMovingImage >
+::ComputePerturbedValue( const unsigned int i,
+  const TransformParametersType & parameters ) const
 {
-  TransformParametersType testPoint;
-  testPoint = parameters;
-  const unsigned int numberOfParameters = this->GetNumberOfParameters();
-  derivative = DerivativeType( numberOfParameters );
+  /** Same as GetValue(), but with copy i of the moved image pipeline. */
+  this->m_PerturbedProjections->SetParameters( i, parameters );
 
-  for( unsigned int i = 0; i < numberOfParameters; i++ )
+  if( this->GetUseSampledEvaluation() )
   {
-    testPoint[ i ] -= this->m_DerivativeDelta / std::sqrt( this->m_Scales[ i ] );
-    const MeasureType valuep0 = this->GetValue( testPoint );
-    testPoint[ i ] += 2 * this->m_DerivativeDelta / std::sqrt( this->m_Scales[ i ] );
-    const MeasureType valuep1 = this->GetValue( testPoint );
-    derivative[ i ] = ( valuep1 - valuep0 ) / ( 2 * this->m_DerivativeDelta / std::sqrt( this->m_Scales[ i ] ) );
-    testPoint[ i ]  = parameters[ i ];
+    std::vector< SampledPixelType > movedValues;
+    this->m_SampledProjection->Evaluate( this->m_PerturbedProjections->GetFilter( i ), movedValues );
+    return this->ComputeSampledMeasure( movedValues );
   }
 
+  const MovedGradientImageType * movedGradients[ MovedImageDimension ];
+  for( unsigned int iFilter = 0; iFilter < MovedImageDimension; iFilter++ )
+  {
+    MovedSobelFilter * sobelFilter
+      = this->m_PerturbedMovedSobelFilters[ i * MovedImageDimension + iFilter ];
+    sobelFilter->UpdateLargestPossibleRegion();
+    movedGradients[ iFilter ] = sobelFilter->GetOutput();
+  }
+
+  MovedGradientPixelType meanMovedGradient[ MovedImageDimension ];
+  this->ComputeMeanMovedGradient( movedGradients, meanMovedGradient );
+
+  return this->ComputeMeasureFromGradients( movedGradients, meanMovedGradient );
+
+} // end ComputePerturbedValue()
+
+
+/**
+ * ***************** BeforeComputePerturbedValues *****************
+ */
+
+template< class TFixedImage, class TMovingImage >
+void
+NormalizedGradientCorrelationImageToImageMetric< TFixedImage, TMovingImage >
+::BeforeComputePerturbedValues( const TransformParametersType & parameters ) const
+{
+  if( this->GetUseSampledEvaluation() )
+  {
+    this->BeforeThreadedGetValueAndDerivative( parameters );
+    this->m_SampledProjection->UpdateSamples( this->GetImageSampler()->GetOutput() );
+  }
+
+} // end BeforeComputePerturbedValues()
+
+
+/**
+ * ***************** GetDerivative *****************
+ */
+
+template< class TFixedImage, class TMovingImage >
+void
+NormalizedGradientCorrelationImageToImageMetric< TFixedImage, TMovingImage >
+::GetDerivative( const TransformParametersType & parameters,
+  DerivativeType & derivative ) const
+{
+  /** Compute the perturbed values simultaneously, if the pipeline is copied. */
+  const unsigned int numberOfPipelines = this->m_UseMultiThread
+    ? this->m_PerturbedProjections->GetNumberOfProjections() : 0;
+  CentralDifferenceDerivativeType::Compute( this, this->m_Threader,
+    this->GetNumberOfThreads(), numberOfPipelines, parameters,
+    this->m_Scales, this->m_DerivativeDelta, derivative );
+
 } // end GetDerivative()
 
 
@@ -22,7 +22,10 @@
 
 #include "itkPoint.h"
 #include "itkCastImageFilter.h"
-#include "itkResampleImageFilter.h"
+#include "itkRayCastProjectionImageFilter.h"
+#include "itkRayCastCentralDifferenceDerivative.h"
+#include "itkRayCastProjectionSet.h"
+#include "itkRayCastSampledProjection.h"
 #include "itkMultiplyImageFilter.h"
 #include "itkSubtractImageFilter.h"
 #include "itkOptimizer.h"
@@ -30,13 +33,24 @@
 #include "itkAdvancedCombinationTransform.h"
 #include "itkAdvancedRayCastInterpolateImageFunction.h"
 
+#include <string>
+#include <vector>
+
 namespace itk
 {
 
 /** \class PatternIntensityImageToImageMetric
  * \brief Computes similarity between two objects to be registered
  *
+ * The derivative is computed by central finite differences. If the
+ * metric is multi-threaded, the 2P perturbed values are computed
+ * simultaneously, where each thread uses its own copy of the pipeline
+ * that projects the moving image and subtracts it from the fixed image.
  *
+ * If UseSampledEvaluation is set, the metric is only evaluated at the
+ * samples of the image sampler, see RayCastSampledProjection. Samples closer
+ * to the border of the fixed image than the neighbourhood radius are skipped,
+ * like the pixels of the full image.
  *
  * \ingroup RegistrationMetrics
  */
@@ -72,6 +86,8 @@ public:
   typedef typename Superclass::FixedImageRegionType       FixedImageRegionType;
   typedef typename Superclass::TransformType              TransformType;
   typedef typename TransformType::ScalarType              ScalarType;
+  typedef typename Superclass::ThreaderType               ThreaderType;
+  typedef typename Superclass::ThreadInfoType             ThreadInfoType;
   typedef typename Superclass::TransformPointer           TransformPointer;
   typedef typename Superclass::InputPointType             InputPointType;
   typedef typename Superclass::OutputPointType            OutputPointType;
@@ -122,9 +138,14 @@ public:
   typedef typename itk::AdvancedRayCastInterpolateImageFunction<
     MovingImageType, ScalarType >                         RayCastInterpolatorType;
   typedef typename RayCastInterpolatorType::Pointer RayCastInterpolatorPointer;
-  typedef itk::ResampleImageFilter<
-    MovingImageType, TransformedMovingImageType >         TransformMovingImageFilterType;
+  typedef itk::RayCastProjectionImageFilter<
+    MovingImageType, TransformedMovingImageType, ScalarType > TransformMovingImageFilterType;
   typedef typename TransformMovingImageFilterType::Pointer TransformMovingImageFilterPointer;
+  typedef itk::RayCastProjectionSet<
+    MovingImageType, TransformedMovingImageType, ScalarType > ProjectionSetType;
+  typedef itk::RayCastSampledProjection<
+    MovingImageType, TransformedMovingImageType, ScalarType > SampledProjectionType;
+  typedef typename SampledProjectionType::OutputPixelType SampledPixelType;
   typedef itk::RescaleIntensityImageFilter<
     TransformedMovingImageType, TransformedMovingImageType > RescaleIntensityImageFilterType;
   typedef typename RescaleIntensityImageFilterType::Pointer RescaleIntensityImageFilterPointer;
@@ -174,6 +195,21 @@ public:
   itkSetMacro( OptimizeNormalizationFactor, bool );
   itkGetConstReferenceMacro( OptimizeNormalizationFactor, bool );
 
+  /** Set/Get whether the metric is only evaluated at the samples of the
+   * image sampler. This is the same as UseImageSampler. Default: false.
+   */
+  virtual void SetUseSampledEvaluation( const bool _arg )
+  {
+    this->SetUseImageSampler( _arg );
+  }
+
+
+  virtual bool GetUseSampledEvaluation( void ) const
+  {
+    return this->GetUseImageSampler();
+  }
+
+
 protected:
 
   PatternIntensityImageToImageMetric();
@@ -186,11 +222,56 @@ protected:
   /** Compute the pattern intensity difference image. */
   MeasureType ComputePIDiff( const TransformParametersType & parameters, float scalingfactor ) const;
 
+  /** Compute the pattern intensity difference image, with the given filters
+   * for the moved image, which should already be up to date.
+   */
+  MeasureType ComputePIDiff( MultiplyImageFilterType * multiplyFilter,
+    DifferenceImageFilterType * differenceFilter, float scalingfactor ) const;
+
+  /** Compute the value from the given filters for the moved image,
+   * optimizing the normalization factor if asked for.
+   */
+  MeasureType ComputeValue( MultiplyImageFilterType * multiplyFilter,
+    DifferenceImageFilterType * differenceFilter ) const;
+
+  /** Collect the detector pixels that are needed for the current samples
+   * of the image sampler, if the sampler selected new samples. The pattern
+   * intensity of the fixed image at the samples is then computed again.
+   */
+  void UpdateSampledPIFixed( void ) const;
+
+  /** Compute the pattern intensity of the difference image at the samples,
+   * from the projection at the pixels of the sampled projection.
+   */
+  MeasureType ComputeSampledPIDiff( const std::vector< SampledPixelType > & movedValues,
+    float scalingfactor ) const;
+
+  /** Compute the value at the samples, optimizing the normalization factor
+   * if asked for.
+   */
+  MeasureType ComputeSampledValue( const std::vector< SampledPixelType > & movedValues ) const;
+
+  /** Copy the moved image pipeline for each thread of GetDerivative(). */
+  void InitializePerturbedProjections( void );
+
+  /** Compute the value for the parameters with copy i of the moved image
+   * pipeline. Different copies can be used simultaneously.
+   */
+  MeasureType ComputePerturbedValue( const unsigned int i,
+    const TransformParametersType & parameters ) const;
+
+  /** Select the samples before the perturbed values are computed. */
+  void BeforeComputePerturbedValues( const TransformParametersType & parameters ) const;
+
 private:
 
   PatternIntensityImageToImageMetric( const Self & ); // purposely not implemented
   void operator=( const Self & );                     // purposely not implemented
 
+  /** Computes the perturbed values of GetDerivative(). */
+  typedef RayCastCentralDifferenceDerivative< Self > CentralDifferenceDerivativeType;
+  friend class RayCastCentralDifferenceDerivative< Self >;
+
   TransformMovingImageFilterPointer  m_TransformMovingImageFilter;
   DifferenceImageFilterPointer       m_DifferenceImageFilter;
   RescaleIntensityImageFilterPointer m_RescaleImageFilter;
@@ -205,6 +286,19 @@ private:
   MeasureType                        m_FixedMeasure;
   CombinationTransformPointer        m_CombinationTransform;
 
+  /** The pixels of the projection needed for sampled evaluation, the
+   * fixed image at these pixels, and its pattern intensity at the samples.
+   */
+  typename SampledProjectionType::Pointer m_SampledProjection;
+  mutable std::vector< MeasureType >      m_SampledFixedValues;
+  mutable MeasureType                     m_SampledFixedMeasure;
+  unsigned int                            m_SampledCenter;
+
+  /** The copies of the moved image pipeline used by GetDerivative(). */
+  typename ProjectionSetType::Pointer         m_PerturbedProjections;
+  std::vector< MultiplyImageFilterPointer >   m_PerturbedMultiplyFilters;
+  std::vector< DifferenceImageFilterPointer > m_PerturbedDifferenceFilters;
+
 };
 
 } // end namespace itk
@@ -22,6 +22,7 @@
 #include "itkImageRegionConstIteratorWithIndex.h"
 #include "itkNumericTraits.h"
 
+#include <algorithm>
 #include <cmath>
 #include <iostream>
 #include <iomanip>
@@ -51,6 +52,10 @@ PatternIntensityImageToImageMetric< TFixedImage, TMovingImage >
   this->m_RescaleImageFilter          = RescaleIntensityImageFilterType::New();
   this->m_DifferenceImageFilter       = DifferenceImageFilterType::New();
   this->m_MultiplyImageFilter         = MultiplyImageFilterType::New();
+  this->m_PerturbedProjections        = ProjectionSetType::New();
+  this->m_SampledProjection           = SampledProjectionType::New();
+  this->m_SampledFixedMeasure         = 0;
+  this->m_SampledCenter               = 0;
 
 } // end Constructor
 
@@ -79,9 +84,8 @@ PatternIntensityImageToImageMetric< TFixedImage, TMovingImage >
                        << "only suitable for 2D-3D registration.\n"
                        << "  Therefore it expects an interpolator of type RayCastInterpolator." );
   }
-  this->m_TransformMovingImageFilter->SetInterpolator( this->m_Interpolator );
+  this->m_TransformMovingImageFilter->SetRayCaster( rayCaster );
   this->m_TransformMovingImageFilter->SetInput( this->m_MovingImage );
-  this->m_TransformMovingImageFilter->SetDefaultPixelValue( 0 );
 
   this->m_TransformMovingImageFilter->SetSize(
     this->m_FixedImage->GetLargestPossibleRegion().GetSize() );
@@ -105,6 +109,38 @@ PatternIntensityImageToImageMetric< TFixedImage, TMovingImage >
   this->m_DifferenceImageFilter->UpdateLargestPossibleRegion();
   this->m_FixedMeasure = this->ComputePIFixed();
 
+  /** The samples need a complete neighbourhood, as in ComputePIFixed(). The
+   * pixels are collected again for the samples of this resolution.
+   */
+  const FixedImageRegionType & region = this->m_FixedImage->GetLargestPossibleRegion();
+  FixedImageRegionType sampleRegion = region;
+  for( unsigned int i = 0; i < 2; ++i ) // Only 2D
+  {
+    sampleRegion.SetIndex( i, region.GetIndex()[ i ] + static_cast< int >( this->m_NeighborhoodRadius ) );
+    sampleRegion.SetSize( i, region.GetSize()[ i ] - 2 * this->m_NeighborhoodRadius );
+  }
+
+  /** The neighbourhood of a sample, in the first two dimensions. */
+  typename SampledProjectionType::StencilType stencil;
+  typename FixedImageType::OffsetType offset;
+  offset.Fill( 0 );
+  const int radius = static_cast< int >( this->m_NeighborhoodRadius );
+  for( offset[ 1 ] = -radius; offset[ 1 ] <= radius; ++offset[ 1 ] )
+  {
+    for( offset[ 0 ] = -radius; offset[ 0 ] <= radius; ++offset[ 0 ] )
+    {
+      if( offset[ 0 ] == 0 && offset[ 1 ] == 0 )
+      {
+        this->m_SampledCenter = static_cast< unsigned int >( stencil.size() );
+      }
+      stencil.push_back( offset );
+    }
+  }
+  this->m_SampledProjection->Initialize( this->m_FixedImage, sampleRegion, stencil );
+
+  /** Copy the moved image pipeline for GetDerivative(). */
+  this->InitializePerturbedProjections();
+
   /* to rescale the similarity measure between 0-1;*/
   MeasureType tmpmeasure = this->GetValue( this->m_Transform->GetParameters() );
 
@@ -250,8 +286,24 @@ PatternIntensityImageToImageMetric< TFixedImage, TMovingImage >
   //this->SetTransformParameters( parameters );
 
   this->m_TransformMovingImageFilter->Modified();
-  this->m_MultiplyImageFilter->SetConstant( scalingfactor );
-  this->m_DifferenceImageFilter->UpdateLargestPossibleRegion();
+  return this->ComputePIDiff( this->m_MultiplyImageFilter,
+    this->m_DifferenceImageFilter, scalingfactor );
+
+} // end ComputePIDiff()
+
+
+/**
+ * ********************* ComputePIDiff ******************************
+ */
+
+template< class TFixedImage, class TMovingImage >
+typename PatternIntensityImageToImageMetric< TFixedImage, TMovingImage >::MeasureType
+PatternIntensityImageToImageMetric< TFixedImage, TMovingImage >
+::ComputePIDiff( MultiplyImageFilterType * multiplyFilter,
+  DifferenceImageFilterType * differenceFilter, float scalingfactor ) const
+{
+  multiplyFilter->SetConstant( scalingfactor );
+  differenceFilter->UpdateLargestPossibleRegion();
   MeasureType measure = NumericTraits< MeasureType >::Zero;
   MeasureType diff    = NumericTraits< MeasureType >::Zero;
 
@@ -276,7 +328,7 @@ PatternIntensityImageToImageMetric< TFixedImage, TMovingImage >
   typedef itk::ImageRegionConstIteratorWithIndex< TransformedMovingImageType >
     DifferenceImageIteratorType;
   DifferenceImageIteratorType differenceImageIt(
-  this->m_DifferenceImageFilter->GetOutput(), iterationRegion );
+  differenceFilter->GetOutput(), iterationRegion );
   differenceImageIt.GoToBegin();
 
   neighboriterationRegion.SetSize( neighborIterationSize );
@@ -317,7 +369,7 @@ PatternIntensityImageToImageMetric< TFixedImage, TMovingImage >
 
       neighboriterationRegion.SetIndex( neighborIndex );
       DifferenceImageIteratorType neighborIt(
-      this->m_DifferenceImageFilter->GetOutput(), neighboriterationRegion );
+      differenceFilter->GetOutput(), neighboriterationRegion );
       neighborIt.GoToBegin();
 
       while( !neighborIt.IsAtEnd() )
@@ -362,8 +414,35 @@ PatternIntensityImageToImageMetric< TFixedImage, TMovingImage >
   this->BeforeThreadedGetValueAndDerivative( parameters );
   //this->SetTransformParameters( parameters );
 
+  /** Only cast the rays that are needed at the samples. */
+  if( this->GetUseSampledEvaluation() )
+  {
+    this->UpdateSampledPIFixed();
+    std::vector< SampledPixelType > movedValues;
+    this->m_SampledProjection->Evaluate( this->m_TransformMovingImageFilter, movedValues );
+    this->m_NumberOfPixelsCounted = this->m_SampledProjection->GetNumberOfSamples();
+    return this->ComputeSampledValue( movedValues );
+  }
+
   this->m_TransformMovingImageFilter->Modified();
-  this->m_DifferenceImageFilter->UpdateLargestPossibleRegion();
+  return this->ComputeValue( this->m_MultiplyImageFilter, this->m_DifferenceImageFilter );
+
+} // end GetValue()
+
+
+/**
+ * ********************* ComputeValue ******************************
+ */
+
+template< class TFixedImage, class TMovingImage >
+typename PatternIntensityImageToImageMetric< TFixedImage, TMovingImage >::MeasureType
+PatternIntensityImageToImageMetric< TFixedImage, TMovingImage >
+::ComputeValue( MultiplyImageFilterType * multiplyFilter,
+  DifferenceImageFilterType * differenceFilter ) const
+{
+  /** Only the multiplication and subtraction depend on the normalization
+   * factor, so the projection is computed once.
+   */
   MeasureType measure        = 1e10;
   MeasureType currentMeasure = 1e10;
 
@@ -376,7 +455,7 @@ PatternIntensityImageToImageMetric< TFixedImage, TMovingImage >
 
     while( tmpfactor <=  this->m_NormalizationFactor * 1.0 )
     {
-      measure    = this->ComputePIDiff( parameters, tmpfactor );
+      measure    = this->ComputePIDiff( multiplyFilter, differenceFilter, tmpfactor );
       tmpMeasure = ( measure - this->m_FixedMeasure ) / -this->m_Rescalingfactor;
 
       if( tmpMeasure < currentMeasure )
@@ -390,40 +469,251 @@ PatternIntensityImageToImageMetric< TFixedImage, TMovingImage >
   }
   else
   {
-    measure        = this->ComputePIDiff( parameters, this->m_NormalizationFactor );
+    measure        = this->ComputePIDiff( multiplyFilter, differenceFilter, this->m_NormalizationFactor );
     currentMeasure = -( measure - this->m_FixedMeasure ) / this->m_Rescalingfactor;
   }
 
   return currentMeasure;
 
-} // end GetValue()
+} // end ComputeValue()
 
 
 /**
- * ********************* GetDerivative ******************************
+ * ********************* UpdateSampledPIFixed ******************************
  */
 
 template< class TFixedImage, class TMovingImage >
 void
 PatternIntensityImageToImageMetric< TFixedImage, TMovingImage >
-::GetDerivative( const TransformParametersType & parameters,
-  DerivativeType & derivative ) const
+::UpdateSampledPIFixed( void ) const
 {
-  TransformParametersType testPoint;
-  testPoint = parameters;
-  const unsigned int numberOfParameters = this->GetNumberOfParameters();
-  derivative = DerivativeType( numberOfParameters );
+  /** Only redo this when the image sampler generated new samples. */
+  if( !this->m_SampledProjection->UpdateSamples( this->GetImageSampler()->GetOutput() ) )
+  {
+    return;
+  }
+
+  /** The fixed image at the pixels, and its pattern intensity at the samples. */
+  const SampledProjectionType * sampled = this->m_SampledProjection;
+  const std::vector< typename FixedImageType::IndexType > & pixels = sampled->GetPixels();
+  this->m_SampledFixedValues.resize( pixels.size() );
+  for( std::size_t p = 0; p < pixels.size(); ++p )
+  {
+    this->m_SampledFixedValues[ p ] = this->m_FixedImage->GetPixel( pixels[ p ] );
+  }
 
-  for( unsigned int i = 0; i < numberOfParameters; i++ )
+  this->m_SampledFixedMeasure = NumericTraits< MeasureType >::Zero;
+  for( unsigned int s = 0; s < sampled->GetNumberOfSamples(); ++s )
   {
-    testPoint[ i ] -= this->m_DerivativeDelta / std::sqrt( this->m_Scales[ i ] );
-    const MeasureType valuep0 = this->GetValue( testPoint );
-    testPoint[ i ] += 2 * this->m_DerivativeDelta / std::sqrt( this->m_Scales[ i ] );
-    const MeasureType valuep1 = this->GetValue( testPoint );
-    derivative[ i ] = ( valuep1 - valuep0 ) / ( 2 * this->m_DerivativeDelta / std::sqrt( this->m_Scales[ i ] ) );
-    testPoint[ i ]  = parameters[ i ];
+    const MeasureType center
+      = this->m_SampledFixedValues[ sampled->GetPixelNumber( s, this->m_SampledCenter ) ];
+    for( unsigned int k = 0; k < sampled->GetStencilSize(); ++k )
+    {
+      const MeasureType diff
+        = center - this->m_SampledFixedValues[ sampled->GetPixelNumber( s, k ) ];
+      this->m_SampledFixedMeasure += this->m_NoiseConstant / ( this->m_NoiseConstant + ( diff * diff ) );
+    }
   }
 
+} // end UpdateSampledPIFixed()
+
+
+/**
+ * ********************* ComputeSampledPIDiff ******************************
+ */
+
+template< class TFixedImage, class TMovingImage >
+typename PatternIntensityImageToImageMetric< TFixedImage, TMovingImage >::MeasureType
+PatternIntensityImageToImageMetric< TFixedImage, TMovingImage >
+::ComputeSampledPIDiff( const std::vector< SampledPixelType > & movedValues,
+  float scalingfactor ) const
+{
+  const SampledProjectionType * sampled = this->m_SampledProjection;
+  MeasureType                   measure = NumericTraits< MeasureType >::Zero;
+
+  for( unsigned int s = 0; s < sampled->GetNumberOfSamples(); ++s )
+  {
+    const unsigned int center           = sampled->GetPixelNumber( s, this->m_SampledCenter );
+    const MeasureType  centerDifference = this->m_SampledFixedValues[ center ]
+      - scalingfactor * static_cast< MeasureType >( movedValues[ center ] );
+    for( unsigned int k = 0; k < sampled->GetStencilSize(); ++k )
+    {
+      const unsigned int p    = sampled->GetPixelNumber( s, k );
+      const MeasureType  diff = centerDifference - ( this->m_SampledFixedValues[ p ]
+        - scalingfactor * static_cast< MeasureType >( movedValues[ p ] ) );
+      measure += this->m_NoiseConstant / ( this->m_NoiseConstant + ( diff * diff ) );
+    }
+  }
+
+  return measure;
+
+} // end ComputeSampledPIDiff()
+
+
+/**
+ * ********************* ComputeSampledValue ******************************
+ */
+
+template< class TFixedImage, class TMovingImage >
+typename PatternIntensityImageToImageMetric< TFixedImage, TMovingImage >::MeasureType
+PatternIntensityImageToImageMetric< TFixedImage, TMovingImage >
+::ComputeSampledValue( const std::vector< SampledPixelType > & movedValues ) const
+{
+  /** As ComputeValue(), but at the samples only. */
+  MeasureType measure        = 1e10;
+  MeasureType currentMeasure = 1e10;
+
+  if( this->m_OptimizeNormalizationFactor )
+  {
+    float       tmpfactor  = 0.0;
+    float       factorstep = ( this->m_NormalizationFactor * 10 - tmpfactor ) / 100;
+    MeasureType tmpMeasure = 1e10;
+
+    while( tmpfactor <= this->m_NormalizationFactor * 1.0 )
+    {
+      measure    = this->ComputeSampledPIDiff( movedValues, tmpfactor );
+      tmpMeasure = ( measure - this->m_SampledFixedMeasure ) / -this->m_Rescalingfactor;
+
+      if( tmpMeasure < currentMeasure )
+      {
+        currentMeasure = tmpMeasure;
+      }
+
+      tmpfactor += factorstep;
+    }
+  }
+  else
+  {
+    measure        = this->ComputeSampledPIDiff( movedValues, this->m_NormalizationFactor );
+    currentMeasure = -( measure - this->m_SampledFixedMeasure ) / this->m_Rescalingfactor;
+  }
+
+  return currentMeasure;
+
+} // end ComputeSampledValue()
+
+
+/**
+ * ********************* InitializePerturbedProjections ******************************
+ */
+
+template< class TFixedImage, class TMovingImage >
+void
+PatternIntensityImageToImageMetric< TFixedImage, TMovingImage >
+::InitializePerturbedProjections( void )
+{
+  this->m_PerturbedMultiplyFilters.clear();
+  this->m_PerturbedDifferenceFilters.clear();
+
+  /** Without copies, GetDerivative() falls back to calling GetValue(). */
+  const unsigned int numberOfPipelines = CentralDifferenceDerivativeType::GetNumberOfPipelines(
+    this->GetNumberOfParameters(), this->GetNumberOfThreads(), this->m_UseMultiThread );
+  const CombinationTransformType * transform
+    = dynamic_cast< const CombinationTransformType * >( this->m_Transform.GetPointer() );
+  if( !this->m_PerturbedProjections->Initialize(
+    this->m_TransformMovingImageFilter, transform, numberOfPipelines ) )
+  {
+    return;
+  }
+
+  /** Divide the threads over the copies of the pipeline. */
+  const ThreadIdType numberOfFilterThreads = CentralDifferenceDerivativeType::GetNumberOfThreadsPerPipeline(
+    this->GetNumberOfThreads(), numberOfPipelines );
+  this->m_PerturbedProjections->SetNumberOfThreads( numberOfFilterThreads );
+
+  for( unsigned int i = 0; i < numberOfPipelines; i++ )
+  {
+    /** The fixed image is connected through a graft, so that updating the
+     * copies does not touch the pipeline of the fixed image.
+     */
+    typename FixedImageType::Pointer fixedImage = FixedImageType::New();
+    fixedImage->Graft( this->m_FixedImage.GetPointer() );
+
+    MultiplyImageFilterPointer multiplyFilter = MultiplyImageFilterType::New();
+    multiplyFilter->SetInput( this->m_PerturbedProjections->GetOutput( i ) );
+    multiplyFilter->SetConstant( this->m_NormalizationFactor );
+#if ITK_VERSION_MAJOR >= 5
+    multiplyFilter->SetNumberOfWorkUnits( numberOfFilterThreads );
+#else
+    multiplyFilter->SetNumberOfThreads( numberOfFilterThreads );
+#endif
+    this->m_PerturbedMultiplyFilters.push_back( multiplyFilter );
+
+    DifferenceImageFilterPointer differenceFilter = DifferenceImageFilterType::New();
+    differenceFilter->SetInput1( fixedImage );
+    differenceFilter->SetInput2( multiplyFilter->GetOutput() );
+#if ITK_VERSION_MAJOR >= 5
+    differenceFilter->SetNumberOfWorkUnits( numberOfFilterThreads );
+#else
+    differenceFilter->SetNumberOfThreads( numberOfFilterThreads );
+#endif
+    this->m_PerturbedDifferenceFilters.push_back( differenceFilter );
+  }
+
+} // end InitializePerturbedProjections()
+
+
+/**
+ * ********************* ComputePerturbedValue ******************************
+ */
+
+template< class TFixedImage, class TMovingImage >
+typename PatternIntensityImageToImageMetric< TFixedImage, TMovingImage >::MeasureType
+PatternIntensityImageToImageMetric< TFixedImage, TMovingImage >
+::ComputePerturbedValue( const unsigned int i,
+  const TransformParametersType & parameters ) const
+{
+  /** Same as GetValue(), but with copy i of the moved image pipeline. */
+  this->m_PerturbedProjections->SetParameters( i, parameters );
+
+  if( this->GetUseSampledEvaluation() )
+  {
+    std::vector< SampledPixelType > movedValues;
+    this->m_SampledProjection->Evaluate( this->m_PerturbedProjections->GetFilter( i ), movedValues );
+    return this->ComputeSampledValue( movedValues );
+  }
+
+  return this->ComputeValue( this->m_PerturbedMultiplyFilters[ i ],
+    this->m_PerturbedDifferenceFilters[ i ] );
+
+} // end ComputePerturbedValue()
+
+
+/**
+ * ********************* BeforeComputePerturbedValues ******************************
+ */
+
+template< class TFixedImage, class TMovingImage >
+void
+PatternIntensityImageToImageMetric< TFixedImage, TMovingImage >
+::BeforeComputePerturbedValues( const TransformParametersType & parameters ) const
+{
+  if( this->GetUseSampledEvaluation() )
+  {
+    this->BeforeThreadedGetValueAndDerivative( parameters );
+    this->UpdateSampledPIFixed();
+  }
+
+} // end BeforeComputePerturbedValues()
+
+
+/**
+ * ********************* GetDerivative ******************************
+ */
+
+template< class TFixedImage, class TMovingImage >
+void
+PatternIntensityImageToImageMetric< TFixedImage, TMovingImage >
+::GetDerivative( const TransformParametersType & parameters,
+  DerivativeType & derivative ) const
+{
+  /** Compute the perturbed values simultaneously, if the pipeline is copied. */
+  const unsigned int numberOfPipelines = this->m_UseMultiThread
+    ? this->m_PerturbedProjections->GetNumberOfProjections() : 0;
+  CentralDifferenceDerivativeType::Compute( this, this->m_Threader,
+    this->GetNumberOfThreads(), numberOfPipelines, parameters,
+    this->m_Scales, this->m_DerivativeDelta, derivative );
+
 } // end GetDerivative()
 
 
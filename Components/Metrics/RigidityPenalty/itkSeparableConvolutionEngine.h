@@ -0,0 +1,196 @@
+/*=========================================================================
+ *
+ *  Copyright UMC Utrecht and contributors
+ *
+ *  Licensed under the Apache License, Version 2.0 (the "License");
+ *  you may not use this file except in compliance with the License.
+ *  You may obtain a copy of the License at
+ *
+ *        http://www.apache.org/licenses/LICENSE-2.0.txt
+ *
+ *  Unless required by applicable law or agreed to in writing, software
+ *  distributed under the License is distributed on an "AS IS" BASIS,
+ *  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *  See the License for the specific language governing permissions and
+ *  limitations under the License.
+ *
+ *=========================================================================*/
+#ifndef __itkSeparableConvolutionEngine_h
+#define __itkSeparableConvolutionEngine_h
+
+#include "itkObject.h"
+#include "itkObjectFactory.h"
+#include "itkNeighborhood.h"
+#include "itkMultiThreader.h"
+
+#include <vector>
+
+namespace itk
+{
+
+/** \class SeparableConvolutionEngine
+ * \brief Applies a set of separable 3-tap operators to images, multi-threaded.
+ *
+ * Each operator is given as one 1D neighborhood operator per dimension, as
+ * created by TransformRigidityPenaltyTerm::Create1DOperator(), and is
+ * applied like a chain of NeighborhoodOperatorImageFilters with the
+ * (default) zero flux Neumann boundary condition.
+ *
+ * All operators are applied together. Operators that have the same kernels
+ * in the first dimensions share the passes over those dimensions, so that
+ * every distinct partial product is computed only once. Each pass over a
+ * dimension distributes the lines along that dimension over the threads.
+ *
+ * The results are only computed in a region of interest. Intermediate
+ * results are computed on that region, padded with the kernel radius in
+ * the dimensions that are processed later, so that the results in the
+ * region of interest are exactly those of filtering the complete image.
+ * Outside the region of interest the outputs are zero.
+ *
+ * The outputs and the intermediate buffers are kept, and only reallocated
+ * when the image region, the number of inputs or the operators change.
+ *
+ * \ingroup ImageFilters
+ */
+
+template< class TImage >
+class SeparableConvolutionEngine : public Object
+{
+public:
+
+  /** Standard ITK-stuff. */
+  typedef SeparableConvolutionEngine Self;
+  typedef Object                     Superclass;
+  typedef SmartPointer< Self >       Pointer;
+  typedef SmartPointer< const Self > ConstPointer;
+
+  /** Method for creation through the object factory. */
+  itkNewMacro( Self );
+
+  /** Run-time type information (and related methods). */
+  itkTypeMacro( SeparableConvolutionEngine, Object );
+
+  /** Dimension of the images. */
+  itkStaticConstMacro( ImageDimension, unsigned int, TImage::ImageDimension );
+
+  /** Typedefs for the images. */
+  typedef TImage                           ImageType;
+  typedef typename ImageType::Pointer      ImagePointer;
+  typedef typename ImageType::PixelType    PixelType;
+  typedef typename ImageType::RegionType   RegionType;
+  typedef typename ImageType::IndexType    IndexType;
+  typedef typename ImageType::SizeType     SizeType;
+  typedef Neighborhood< PixelType,
+    itkGetStaticConstMacro( ImageDimension ) > NeighborhoodType;
+
+  /** A separable operator: a 1D operator for every dimension. */
+  typedef std::vector< NeighborhoodType > SeparableOperatorType;
+
+  /** Set the operators. Throws an exception if an operator is not
+   * separable with 3 taps.
+   */
+  void SetOperators( const std::vector< SeparableOperatorType > & operators );
+
+  /** Get the number of operators. */
+  unsigned int GetNumberOfOperators( void ) const
+  {
+    return static_cast< unsigned int >( this->m_OperatorLeaf.size() );
+  }
+
+
+  /** Set the region in which the outputs are required. It is cropped by the
+   * region of the inputs.
+   */
+  void SetRegionOfInterest( const RegionType & region );
+
+  itkGetConstReferenceMacro( RegionOfInterest, RegionType );
+
+  /** Set the number of threads. */
+  void SetNumberOfThreads( ThreadIdType numberOfThreads )
+  {
+    this->m_Threader->SetNumberOfThreads( numberOfThreads );
+  }
+
+
+  /** Apply all operators to all inputs. The inputs should have the same
+   * region, and should be fully buffered.
+   */
+  void Filter( const std::vector< ImagePointer > & inputs );
+
+  /** Get the result of an operator applied to an input. */
+  ImageType * GetOutput( const unsigned int input, const unsigned int op ) const;
+
+protected:
+
+  SeparableConvolutionEngine();
+  virtual ~SeparableConvolutionEngine() {}
+
+  void PrintSelf( std::ostream & os, Indent indent ) const;
+
+  /** Typedefs for multi-threading. */
+  typedef itk::MultiThreader             ThreaderType;
+  typedef ThreaderType::ThreadInfoStruct ThreaderInfoType;
+
+  /** Pass threader callback function. */
+  static ITK_THREAD_RETURN_TYPE PassThreaderCallback( void * arg );
+
+  /** Filter the lines [begin, end) of the current pass. */
+  void ThreadedFilterLines( const SizeValueType begin, const SizeValueType end ) const;
+
+  /** Allocate the outputs and buffers for the current inputs. */
+  void AllocateOutputs( const ImageType * input, const unsigned int numberOfInputs );
+
+private:
+
+  SeparableConvolutionEngine( const Self & ); // purposely not implemented
+  void operator=( const Self & );             // purposely not implemented
+
+  /** A node of the tree of partial products. A node of level d is the
+   * result of filtering with the kernels of its ancestors in dimensions
+   * 0, ..., d - 1, and with its own kernel in dimension d.
+   */
+  struct NodeType
+  {
+    unsigned int Parent;
+    PixelType    Kernel[ 3 ];
+  };
+
+  /** The nodes per level, and the leaf of every operator. */
+  std::vector< NodeType >     m_Nodes[ ImageDimension ];
+  std::vector< unsigned int > m_OperatorLeaf;
+
+  /** The intermediate results of levels 0, ..., ImageDimension - 2. */
+  std::vector< std::vector< PixelType > > m_Buffers[ ImageDimension ];
+
+  /** The outputs, per input and leaf. */
+  std::vector< std::vector< ImagePointer > > m_Outputs;
+
+  /** The region of the inputs, the region of interest, and the region in
+   * which the outputs were last computed.
+   */
+  RegionType            m_ImageRegion;
+  RegionType            m_RegionOfInterest;
+  RegionType            m_ComputedRegion;
+  ThreaderType::Pointer m_Threader;
+
+  /** The state of the current pass, shared with the threads. */
+  struct PassType
+  {
+    unsigned int                     Dimension;
+    std::vector< const PixelType * > NodeInputs;
+    std::vector< PixelType * >       NodeOutputs;
+    RegionType                       Region;
+    SizeValueType                    NumberOfLines;
+    OffsetValueType                  Strides[ ImageDimension ];
+  };
+  PassType m_Pass;
+
+};
+
+} // end namespace itk
+
+#ifndef ITK_MANUAL_INSTANTIATION
+#include "itkSeparableConvolutionEngine.hxx"
+#endif
+
+#endif // end #ifndef __itkSeparableConvolutionEngine_h
@@ -0,0 +1,452 @@
+/*=========================================================================
+ *
+ *  Copyright UMC Utrecht and contributors
+ *
+ *  Licensed under the Apache License, Version 2.0 (the "License");
+ *  you may not use this file except in compliance with the License.
+ *  You may obtain a copy of the License at
+ *
+ *        http://www.apache.org/licenses/LICENSE-2.0.txt
+ *
+ *  Unless required by applicable law or agreed to in writing, software
+ *  distributed under the License is distributed on an "AS IS" BASIS,
+ *  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *  See the License for the specific language governing permissions and
+ *  limitations under the License.
+ *
+ *=========================================================================*/
+#ifndef __itkSeparableConvolutionEngine_hxx
+#define __itkSeparableConvolutionEngine_hxx
+
+#include "itkSeparableConvolutionEngine.h"
+#include "itkNumericTraits.h"
+#include "vnl/vnl_math.h"
+
+namespace itk
+{
+
+/**
+ * ******************* Constructor *******************
+ */
+
+template< class TImage >
+SeparableConvolutionEngine< TImage >
+::SeparableConvolutionEngine()
+{
+  this->m_Threader = ThreaderType::New();
+#if ITK_VERSION_MAJOR < 5
+  this->m_Threader->SetUseThreadPool( false );
+#endif
+
+  this->m_Pass.Dimension     = 0;
+  this->m_Pass.NumberOfLines = 0;
+  for( unsigned int d = 0; d < ImageDimension; ++d )
+  {
+    this->m_Pass.Strides[ d ] = 0;
+  }
+
+} // end Constructor
+
+
+/**
+ * ******************* SetOperators *******************
+ */
+
+template< class TImage >
+void
+SeparableConvolutionEngine< TImage >
+::SetOperators( const std::vector< SeparableOperatorType > & operators )
+{
+  /** Build the tree of partial products. */
+  std::vector< NodeType >     nodes[ ImageDimension ];
+  std::vector< unsigned int > operatorLeaf( operators.size() );
+  for( unsigned int o = 0; o < operators.size(); ++o )
+  {
+    if( operators[ o ].size() != ImageDimension )
+    {
+      itkExceptionMacro( << "Operator " << o << " does not have an operator for every dimension." );
+    }
+
+    unsigned int parent = 0;
+    for( unsigned int d = 0; d < ImageDimension; ++d )
+    {
+      /** Get the 3 taps of the 1D operator of this dimension. */
+      const NeighborhoodType & op = operators[ o ][ d ];
+      NodeType                 node;
+      node.Parent = parent;
+      for( unsigned int e = 0; e < ImageDimension; ++e )
+      {
+        if( op.GetRadius( e ) > ( e == d ? 1u : 0u ) )
+        {
+          itkExceptionMacro( << "Operator " << o << " is not a 3-tap operator in dimension " << d << "." );
+        }
+      }
+      if( op.GetRadius( d ) == 1 )
+      {
+        node.Kernel[ 0 ] = op[ 0 ]; node.Kernel[ 1 ] = op[ 1 ]; node.Kernel[ 2 ] = op[ 2 ];
+      }
+      else
+      {
+        node.Kernel[ 0 ] = 0.0; node.Kernel[ 1 ] = op[ 0 ]; node.Kernel[ 2 ] = 0.0;
+      }
+
+      /** Share the node with a previous operator, if possible. */
+      unsigned int n = 0;
+      for( ; n < nodes[ d ].size(); ++n )
+      {
+        const NodeType & other = nodes[ d ][ n ];
+        if( other.Parent == node.Parent && other.Kernel[ 0 ] == node.Kernel[ 0 ]
+          && other.Kernel[ 1 ] == node.Kernel[ 1 ] && other.Kernel[ 2 ] == node.Kernel[ 2 ] )
+        {
+          break;
+        }
+      }
+      if( n == nodes[ d ].size() )
+      {
+        nodes[ d ].push_back( node );
+      }
+      parent = n;
+    }
+    operatorLeaf[ o ] = parent;
+  }
+
+  /** Keep the outputs if nothing changed. */
+  bool changed = operatorLeaf != this->m_OperatorLeaf;
+  for( unsigned int d = 0; d < ImageDimension && !changed; ++d )
+  {
+    changed = nodes[ d ].size() != this->m_Nodes[ d ].size();
+    for( unsigned int n = 0; n < nodes[ d ].size() && !changed; ++n )
+    {
+      const NodeType & node  = nodes[ d ][ n ];
+      const NodeType & other = this->m_Nodes[ d ][ n ];
+      changed = other.Parent != node.Parent || other.Kernel[ 0 ] != node.Kernel[ 0 ]
+        || other.Kernel[ 1 ] != node.Kernel[ 1 ] || other.Kernel[ 2 ] != node.Kernel[ 2 ];
+    }
+  }
+  if( !changed )
+  {
+    return;
+  }
+
+  for( unsigned int d = 0; d < ImageDimension; ++d )
+  {
+    this->m_Nodes[ d ] = nodes[ d ];
+  }
+  this->m_OperatorLeaf = operatorLeaf;
+  this->m_Outputs.clear();
+  this->Modified();
+
+} // end SetOperators()
+
+
+/**
+ * ******************* SetRegionOfInterest *******************
+ */
+
+template< class TImage >
+void
+SeparableConvolutionEngine< TImage >
+::SetRegionOfInterest( const RegionType & region )
+{
+  if( this->m_RegionOfInterest != region )
+  {
+    this->m_RegionOfInterest = region;
+    this->Modified();
+  }
+
+} // end SetRegionOfInterest()
+
+
+/**
+ * ******************* AllocateOutputs *******************
+ */
+
+template< class TImage >
+void
+SeparableConvolutionEngine< TImage >
+::AllocateOutputs( const ImageType * input, const unsigned int numberOfInputs )
+{
+  const unsigned int numberOfLeaves
+    = static_cast< unsigned int >( this->m_Nodes[ ImageDimension - 1 ].size() );
+  const RegionType & region = input->GetLargestPossibleRegion();
+
+  bool allocate = region != this->m_ImageRegion
+    || this->m_Outputs.size() != numberOfInputs;
+  for( unsigned int i = 0; i < this->m_Outputs.size() && !allocate; ++i )
+  {
+    allocate = this->m_Outputs[ i ].size() != numberOfLeaves;
+  }
+
+  if( allocate )
+  {
+    this->m_ImageRegion = region;
+
+    /** The outputs start as zero, everywhere. */
+    this->m_Outputs.resize( numberOfInputs );
+    for( unsigned int i = 0; i < numberOfInputs; ++i )
+    {
+      this->m_Outputs[ i ].resize( numberOfLeaves );
+      for( unsigned int n = 0; n < numberOfLeaves; ++n )
+      {
+        this->m_Outputs[ i ][ n ] = ImageType::New();
+        this->m_Outputs[ i ][ n ]->SetRegions( region );
+        this->m_Outputs[ i ][ n ]->Allocate();
+        this->m_Outputs[ i ][ n ]->FillBuffer( NumericTraits< PixelType >::ZeroValue() );
+      }
+    }
+    this->m_ComputedRegion = RegionType();
+
+    /** The intermediate results are only read where they were computed. */
+    for( unsigned int d = 0; d + 1 < ImageDimension; ++d )
+    {
+      this->m_Buffers[ d ].resize( this->m_Nodes[ d ].size() );
+      for( unsigned int n = 0; n < this->m_Nodes[ d ].size(); ++n )
+      {
+        this->m_Buffers[ d ][ n ].resize( region.GetNumberOfPixels() );
+      }
+    }
+  }
+
+  /** The grid may have moved, without changing its region. */
+  for( unsigned int i = 0; i < numberOfInputs; ++i )
+  {
+    for( unsigned int n = 0; n < numberOfLeaves; ++n )
+    {
+      this->m_Outputs[ i ][ n ]->CopyInformation( input );
+    }
+  }
+
+} // end AllocateOutputs()
+
+
+/**
+ * ******************* Filter *******************
+ */
+
+template< class TImage >
+void
+SeparableConvolutionEngine< TImage >
+::Filter( const std::vector< ImagePointer > & inputs )
+{
+  if( inputs.empty() || this->m_OperatorLeaf.empty() )
+  {
+    return;
+  }
+
+  /** Check the inputs. */
+  const RegionType & imageRegion = inputs[ 0 ]->GetLargestPossibleRegion();
+  for( unsigned int i = 0; i < inputs.size(); ++i )
+  {
+    if( inputs[ i ]->GetLargestPossibleRegion() != imageRegion
+      || inputs[ i ]->GetBufferedRegion() != imageRegion )
+    {
+      itkExceptionMacro( << "The inputs should be fully buffered, and have the same region." );
+    }
+  }
+
+  this->AllocateOutputs( inputs[ 0 ], static_cast< unsigned int >( inputs.size() ) );
+
+  /** Crop the region of interest. */
+  RegionType regionOfInterest = this->m_RegionOfInterest;
+  if( !regionOfInterest.Crop( imageRegion ) )
+  {
+    regionOfInterest = RegionType();
+  }
+
+  /** Clear the old results that are not overwritten. */
+  if( this->m_ComputedRegion.GetNumberOfPixels() > 0
+    && !regionOfInterest.IsInside( this->m_ComputedRegion ) )
+  {
+    for( unsigned int i = 0; i < this->m_Outputs.size(); ++i )
+    {
+      for( unsigned int n = 0; n < this->m_Outputs[ i ].size(); ++n )
+      {
+        this->m_Outputs[ i ][ n ]->FillBuffer( NumericTraits< PixelType >::ZeroValue() );
+      }
+    }
+  }
+  this->m_ComputedRegion = regionOfInterest;
+  if( regionOfInterest.GetNumberOfPixels() == 0 )
+  {
+    return;
+  }
+
+  /** The strides of the grid. */
+  OffsetValueType stride = 1;
+  for( unsigned int d = 0; d < ImageDimension; ++d )
+  {
+    this->m_Pass.Strides[ d ] = stride;
+    stride *= static_cast< OffsetValueType >( imageRegion.GetSize()[ d ] );
+  }
+
+  this->m_Threader->SetSingleMethod( this->PassThreaderCallback, this );
+
+  for( unsigned int i = 0; i < inputs.size(); ++i )
+  {
+    for( unsigned int d = 0; d < ImageDimension; ++d )
+    {
+      /** The region of this pass is padded in the dimensions that follow. */
+      IndexType index = regionOfInterest.GetIndex();
+      SizeType  size  = regionOfInterest.GetSize();
+      for( unsigned int e = d + 1; e < ImageDimension; ++e )
+      {
+        index[ e ] -= 1;
+        size[ e ]  += 2;
+      }
+      RegionType region( index, size );
+      region.Crop( imageRegion );
+
+      /** All nodes of this level are filtered in the same pass. */
+      const unsigned int numberOfNodes = static_cast< unsigned int >( this->m_Nodes[ d ].size() );
+      this->m_Pass.NodeInputs.resize( numberOfNodes );
+      this->m_Pass.NodeOutputs.resize( numberOfNodes );
+      for( unsigned int n = 0; n < numberOfNodes; ++n )
+      {
+        this->m_Pass.NodeInputs[ n ] = d == 0
+          ? inputs[ i ]->GetBufferPointer()
+          : &this->m_Buffers[ d - 1 ][ this->m_Nodes[ d ][ n ].Parent ][ 0 ];
+        this->m_Pass.NodeOutputs[ n ] = d + 1 == ImageDimension
+          ? this->m_Outputs[ i ][ n ]->GetBufferPointer()
+          : &this->m_Buffers[ d ][ n ][ 0 ];
+      }
+
+      this->m_Pass.Dimension     = d;
+      this->m_Pass.Region        = region;
+      this->m_Pass.NumberOfLines = region.GetNumberOfPixels() / region.GetSize()[ d ];
+      this->m_Threader->SingleMethodExecute();
+    }
+  }
+
+} // end Filter()
+
+
+/**
+ * ******************* PassThreaderCallback *******************
+ */
+
+template< class TImage >
+ITK_THREAD_RETURN_TYPE
+SeparableConvolutionEngine< TImage >
+::PassThreaderCallback( void * arg )
+{
+  /** Get the current thread id and user data. */
+  ThreaderInfoType * infoStruct = static_cast< ThreaderInfoType * >( arg );
+  ThreadIdType       threadID   = infoStruct->ThreadID;
+  const Self *       self       = static_cast< const Self * >( infoStruct->UserData );
+
+  /** Distribute the lines evenly over the threads. */
+  const SizeValueType numberOfThreads = self->m_Threader->GetNumberOfThreads();
+  const SizeValueType numberOfLines   = self->m_Pass.NumberOfLines;
+  const SizeValueType linesPerThread
+    = ( numberOfLines + numberOfThreads - 1 ) / numberOfThreads;
+  const SizeValueType begin = vnl_math_min( threadID * linesPerThread, numberOfLines );
+  const SizeValueType end   = vnl_math_min( begin + linesPerThread, numberOfLines );
+
+  self->ThreadedFilterLines( begin, end );
+
+  return ITK_THREAD_RETURN_VALUE;
+
+} // end PassThreaderCallback()
+
+
+/**
+ * ******************* ThreadedFilterLines *******************
+ */
+
+template< class TImage >
+void
+SeparableConvolutionEngine< TImage >
+::ThreadedFilterLines( const SizeValueType begin, const SizeValueType end ) const
+{
+  typedef typename NumericTraits< PixelType >::RealType RealType;
+
+  const PassType &      pass      = this->m_Pass;
+  const unsigned int    d         = pass.Dimension;
+  const IndexType &     gridIndex = this->m_ImageRegion.GetIndex();
+  const IndexType &     index     = pass.Region.GetIndex();
+  const SizeType &      size      = pass.Region.GetSize();
+  const OffsetValueType stride    = pass.Strides[ d ];
+
+  /** The position of the lines within the grid, along dimension d. */
+  const OffsetValueType first      = index[ d ] - gridIndex[ d ];
+  const OffsetValueType length     = static_cast< OffsetValueType >( size[ d ] );
+  const OffsetValueType gridLength
+    = static_cast< OffsetValueType >( this->m_ImageRegion.GetSize()[ d ] );
+
+  for( SizeValueType q = begin; q < end; ++q )
+  {
+    /** The offset of the first pixel of line q. */
+    OffsetValueType offset = first * stride;
+    SizeValueType   rest   = q;
+    for( unsigned int e = 0; e < ImageDimension; ++e )
+    {
+      if( e != d )
+      {
+        offset += ( index[ e ] - gridIndex[ e ]
+          + static_cast< OffsetValueType >( rest % size[ e ] ) ) * pass.Strides[ e ];
+        rest /= size[ e ];
+      }
+    }
+
+    for( unsigned int n = 0; n < pass.NodeInputs.size(); ++n )
+    {
+      const PixelType * kernel = this->m_Nodes[ d ][ n ].Kernel;
+      const PixelType * in     = pass.NodeInputs[ n ] + offset;
+      PixelType *       out    = pass.NodeOutputs[ n ] + offset;
+
+      /** The zero flux Neumann condition repeats the pixels at the border. */
+      for( OffsetValueType x = 0; x < length; ++x, in += stride, out += stride )
+      {
+        const OffsetValueType previous = first + x > 0 ? -stride : 0;
+        const OffsetValueType next     = first + x + 1 < gridLength ? stride : 0;
+
+        RealType sum = NumericTraits< RealType >::ZeroValue();
+        sum += kernel[ 0 ] * in[ previous ];
+        sum += kernel[ 1 ] * in[ 0 ];
+        sum += kernel[ 2 ] * in[ next ];
+        *out = static_cast< PixelType >( sum );
+      }
+    }
+  }
+
+} // end ThreadedFilterLines()
+
+
+/**
+ * ******************* GetOutput *******************
+ */
+
+template< class TImage >
+typename SeparableConvolutionEngine< TImage >::ImageType *
+SeparableConvolutionEngine< TImage >
+::GetOutput( const unsigned int input, const unsigned int op ) const
+{
+  return this->m_Outputs[ input ][ this->m_OperatorLeaf[ op ] ];
+
+} // end GetOutput()
+
+
+/**
+ * ******************* PrintSelf *******************
+ */
+
+template< class TImage >
+void
+SeparableConvolutionEngine< TImage >
+::PrintSelf( std::ostream & os, Indent indent ) const
+{
+  Superclass::PrintSelf( os, indent );
+
+  os << indent << "NumberOfOperators: " << this->m_OperatorLeaf.size() << std::endl;
+  for( unsigned int d = 0; d < ImageDimension; ++d )
+  {
+    os << indent << "NumberOfPasses[" << d << "]: " << this->m_Nodes[ d ].size() << std::endl;
+  }
+  os << indent << "RegionOfInterest: " << this->m_RegionOfInterest << std::endl;
+
+} // end PrintSelf()
+
+
+} // end namespace itk
+
+#endif // end #ifndef __itkSeparableConvolutionEngine_hxx
@@ -29,6 +29,7 @@
 #include "itkImageRegionIterator.h"
 #include "itkNeighborhoodOperatorImageFilter.h"
 #include "itkNeighborhoodIterator.h"
+#include "itkSeparableConvolutionEngine.h"
 
 /** Include stuff needed for the construction of the rigidity coefficient image. */
 #include "itkGrayscaleDilateImageFilter.h"
@@ -52,6 +53,12 @@ namespace itk
  * The RigidityPenaltyTermValueImageFilter at each pixel location is computed by
  * convolution with some separable 1D kernels.
  *
+ * All separable convolutions are done together by a SeparableConvolutionEngine,
+ * which shares the common passes, is multi-threaded, and keeps its buffers
+ * between iterations. Only the bounding box of the nonzero rigidity
+ * coefficients, the dilated rigid region, is filtered and accumulated,
+ * since the penalty term and its derivative vanish elsewhere.
+ *
  * The rigid penalty term penalizes deviations from a rigid
  * transformation at regions specified by the so-called rigidity images.
  *
@@ -164,6 +171,11 @@ public:
     CoefficientImageType, CoefficientImageType >        NOIFType;
   typedef NeighborhoodIterator< CoefficientImageType >  NeighborhoodIteratorType;
   typedef typename NeighborhoodIteratorType::RadiusType RadiusType;
+  typedef SeparableConvolutionEngine<
+    CoefficientImageType >                              SeparableConvolutionEngineType;
+  typedef typename SeparableConvolutionEngineType::Pointer SeparableConvolutionEnginePointer;
+  typedef typename SeparableConvolutionEngineType
+    ::SeparableOperatorType                             SeparableOperatorType;
 
   /** Typedef's for the construction of the rigidity image. */
   typedef CoefficientImageType                     RigidityImageType;
@@ -322,9 +334,17 @@ private:
   void CreateNDOperator( NeighborhoodType & F, const std::string & whichF,
     const CoefficientImageSpacingType & spacing ) const;
 
-  /** Private function used for the filtering. It performs 1D separable filtering. */
-  CoefficientImagePointer FilterSeparable( const CoefficientImageType *,
-    const std::vector< NeighborhoodType > & Operators ) const;
+  /** Private function that sums the rigidity coefficients, and computes
+   * the bounding box of the nonzero coefficients.
+   */
+  ScalarType ComputeRigidityCoefficientSum( RigidityImageRegionType & rigidRegion ) const;
+
+  /** Private function that returns image number of the cache of temporary
+   * images, allocated like the grid. New images are filled with zeros;
+   * afterwards the contents are left as they are.
+   */
+  CoefficientImageType * GetTemporaryImage( const unsigned int number,
+    const CoefficientImageType * grid ) const;
 
   /** Member variables. */
   BSplineTransformPointer m_BSplineTransform;
@@ -361,6 +381,10 @@ private:
   bool                               m_UseFixedRigidityImage;
   bool                               m_UseMovingRigidityImage;
 
+  /** Filtering variables. */
+  SeparableConvolutionEnginePointer              m_SeparableConvolutionEngine;
+  mutable std::vector< CoefficientImagePointer > m_TemporaryImages;
+
 };
 
 } // end namespace itk
@@ -21,6 +21,8 @@
 #include "itkTransformRigidityPenaltyTerm.h"
 
 #include "itkZeroFluxNeumannBoundaryCondition.h"
+#include "itkImageRegionConstIteratorWithIndex.h"
+#include "vnl/vnl_math.h"
 
 namespace itk
 {
@@ -87,6 +89,9 @@ TransformRigidityPenaltyTerm< TFixedImage, TScalarType >
 
   this->m_BSplineTransform = NULL;
 
+  /** The engine for the separable filtering of the B-spline coefficients. */
+  this->m_SeparableConvolutionEngine = SeparableConvolutionEngineType::New();
+
 } // end Constructor
 
 
@@ -167,6 +172,10 @@ TransformRigidityPenaltyTerm< TFixedImage, TScalarType >
   /** Reset the filling bool. */
   this->m_RigidityCoefficientImageIsFilled = false;
 
+  /** Filter with the threads of this metric, and start with new buffers. */
+  this->m_SeparableConvolutionEngine->SetNumberOfThreads( this->GetNumberOfThreads() );
+  this->m_TemporaryImages.clear();
+
 } // end Initialize()
 
 
@@ -510,18 +519,10 @@ TransformRigidityPenaltyTerm< TFixedImage, TScalarType >
    *
    ************************************************************************* */
 
-  /** Create iterator over the rigidity coeficient image. */
-  CoefficientImageIteratorType it_RCI( this->m_RigidityCoefficientImage,
-  this->m_RigidityCoefficientImage->GetLargestPossibleRegion() );
-  it_RCI.GoToBegin();
-  ScalarType rigidityCoefficientSum = NumericTraits< ScalarType >::Zero;
-
-  /** Add the rigidity coefficients together. */
-  while( !it_RCI.IsAtEnd() )
-  {
-    rigidityCoefficientSum += it_RCI.Get();
-    ++it_RCI;
-  }
+  /** Add the rigidity coefficients together, and find the rigid region. */
+  RigidityImageRegionType rigidRegion;
+  ScalarType              rigidityCoefficientSum
+    = this->ComputeRigidityCoefficientSum( rigidRegion );
 
   /** Check for early termination. */
   if( rigidityCoefficientSum < 1e-14 )
@@ -552,20 +553,7 @@ TransformRigidityPenaltyTerm< TFixedImage, TScalarType >
   /** For all dimensions ... */
   for( unsigned int i = 0; i < ImageDimension; i++ )
   {
-    /** ... create the filtered images ... */
-    ui_FA[ i ] = CoefficientImageType::New();
-    ui_FB[ i ] = CoefficientImageType::New();
-    ui_FD[ i ] = CoefficientImageType::New();
-    ui_FE[ i ] = CoefficientImageType::New();
-    ui_FG[ i ] = CoefficientImageType::New();
-    if( ImageDimension == 3 )
-    {
-      ui_FC[ i ] = CoefficientImageType::New();
-      ui_FF[ i ] = CoefficientImageType::New();
-      ui_FH[ i ] = CoefficientImageType::New();
-      ui_FI[ i ] = CoefficientImageType::New();
-    }
-    /** ... and the apropiate operators.
+    /** ... create the apropiate operators.
      * The operators C, D and E from the paper are here created
      * by Create1DOperator D, E and G, because of the 3D case and history.
      */
@@ -588,20 +576,35 @@ TransformRigidityPenaltyTerm< TFixedImage, TScalarType >
    *
    ************************************************************************* */
 
-  /** Filter the inputImages. */
+  /** Filter the inputImages with all operators at once, in the rigid region.
+   * Outside that region the filtered images are zero.
+   */
+  std::vector< SeparableOperatorType > operators;
+  operators.push_back( Operators_A ); operators.push_back( Operators_B );
+  operators.push_back( Operators_D ); operators.push_back( Operators_E );
+  operators.push_back( Operators_G );
+  if( ImageDimension == 3 )
+  {
+    operators.push_back( Operators_C ); operators.push_back( Operators_F );
+    operators.push_back( Operators_H ); operators.push_back( Operators_I );
+  }
+  this->m_SeparableConvolutionEngine->SetOperators( operators );
+  this->m_SeparableConvolutionEngine->SetRegionOfInterest( rigidRegion );
+  this->m_SeparableConvolutionEngine->Filter( inputImages );
+
   for( unsigned int i = 0; i < ImageDimension; i++ )
   {
-    ui_FA[ i ] = this->FilterSeparable( inputImages[ i ], Operators_A );
-    ui_FB[ i ] = this->FilterSeparable( inputImages[ i ], Operators_B );
-    ui_FD[ i ] = this->FilterSeparable( inputImages[ i ], Operators_D );
-    ui_FE[ i ] = this->FilterSeparable( inputImages[ i ], Operators_E );
-    ui_FG[ i ] = this->FilterSeparable( inputImages[ i ], Operators_G );
+    ui_FA[ i ] = this->m_SeparableConvolutionEngine->GetOutput( i, 0 );
+    ui_FB[ i ] = this->m_SeparableConvolutionEngine->GetOutput( i, 1 );
+    ui_FD[ i ] = this->m_SeparableConvolutionEngine->GetOutput( i, 2 );
+    ui_FE[ i ] = this->m_SeparableConvolutionEngine->GetOutput( i, 3 );
+    ui_FG[ i ] = this->m_SeparableConvolutionEngine->GetOutput( i, 4 );
     if( ImageDimension == 3 )
     {
-      ui_FC[ i ] = this->FilterSeparable( inputImages[ i ], Operators_C );
-      ui_FF[ i ] = this->FilterSeparable( inputImages[ i ], Operators_F );
-      ui_FH[ i ] = this->FilterSeparable( inputImages[ i ], Operators_H );
-      ui_FI[ i ] = this->FilterSeparable( inputImages[ i ], Operators_I );
+      ui_FC[ i ] = this->m_SeparableConvolutionEngine->GetOutput( i, 5 );
+      ui_FF[ i ] = this->m_SeparableConvolutionEngine->GetOutput( i, 6 );
+      ui_FH[ i ] = this->m_SeparableConvolutionEngine->GetOutput( i, 7 );
+      ui_FI[ i ] = this->m_SeparableConvolutionEngine->GetOutput( i, 8 );
     }
   }
 
@@ -617,21 +620,22 @@ TransformRigidityPenaltyTerm< TFixedImage, TScalarType >
   itF( ImageDimension ), itG( ImageDimension ),
   itH( ImageDimension ), itI( ImageDimension );
 
-  /** Create iterators. */
+  /** Create iterators over the rigid region, where the penalty is nonzero. */
+  CoefficientImageIteratorType it_RCI( this->m_RigidityCoefficientImage, rigidRegion );
   for( unsigned int i = 0; i < ImageDimension; i++ )
   {
     /** Create iterators. */
-    itA[ i ] = CoefficientImageIteratorType( ui_FA[ i ], ui_FA[ i ]->GetLargestPossibleRegion() );
-    itB[ i ] = CoefficientImageIteratorType( ui_FB[ i ], ui_FB[ i ]->GetLargestPossibleRegion() );
-    itD[ i ] = CoefficientImageIteratorType( ui_FD[ i ], ui_FD[ i ]->GetLargestPossibleRegion() );
-    itE[ i ] = CoefficientImageIteratorType( ui_FE[ i ], ui_FE[ i ]->GetLargestPossibleRegion() );
-    itG[ i ] = CoefficientImageIteratorType( ui_FG[ i ], ui_FG[ i ]->GetLargestPossibleRegion() );
+    itA[ i ] = CoefficientImageIteratorType( ui_FA[ i ], rigidRegion );
+    itB[ i ] = CoefficientImageIteratorType( ui_FB[ i ], rigidRegion );
+    itD[ i ] = CoefficientImageIteratorType( ui_FD[ i ], rigidRegion );
+    itE[ i ] = CoefficientImageIteratorType( ui_FE[ i ], rigidRegion );
+    itG[ i ] = CoefficientImageIteratorType( ui_FG[ i ], rigidRegion );
     if( ImageDimension == 3 )
     {
-      itC[ i ] = CoefficientImageIteratorType( ui_FC[ i ], ui_FC[ i ]->GetLargestPossibleRegion() );
-      itF[ i ] = CoefficientImageIteratorType( ui_FF[ i ], ui_FF[ i ]->GetLargestPossibleRegion() );
-      itH[ i ] = CoefficientImageIteratorType( ui_FH[ i ], ui_FH[ i ]->GetLargestPossibleRegion() );
-      itI[ i ] = CoefficientImageIteratorType( ui_FI[ i ], ui_FI[ i ]->GetLargestPossibleRegion() );
+      itC[ i ] = CoefficientImageIteratorType( ui_FC[ i ], rigidRegion );
+      itF[ i ] = CoefficientImageIteratorType( ui_FF[ i ], rigidRegion );
+      itH[ i ] = CoefficientImageIteratorType( ui_FH[ i ], rigidRegion );
+      itI[ i ] = CoefficientImageIteratorType( ui_FI[ i ], rigidRegion );
     }
     /** Reset iterators. */
     itA[ i ].GoToBegin(); itB[ i ].GoToBegin();
@@ -994,18 +998,10 @@ TransformRigidityPenaltyTerm< TFixedImage, TScalarType >
    *
    ************************************************************************* */
 
-  /** Create iterator over the rigidity coeficient image. */
-  CoefficientImageIteratorType it_RCI( this->m_RigidityCoefficientImage,
-  this->m_RigidityCoefficientImage->GetLargestPossibleRegion() );
-  it_RCI.GoToBegin();
-  ScalarType rigidityCoefficientSum = NumericTraits< ScalarType >::Zero;
-
-  /** Add the rigidity coefficients together. */
-  while( !it_RCI.IsAtEnd() )
-  {
-    rigidityCoefficientSum += it_RCI.Get();
-    ++it_RCI;
-  }
+  /** Add the rigidity coefficients together, and find the rigid region. */
+  RigidityImageRegionType rigidRegion;
+  ScalarType              rigidityCoefficientSum
+    = this->ComputeRigidityCoefficientSum( rigidRegion );
 
   /** Check for early termination. */
   if( rigidityCoefficientSum < 1e-14 )
@@ -1036,20 +1032,7 @@ TransformRigidityPenaltyTerm< TFixedImage, TScalarType >
   /** For all dimensions ... */
   for( unsigned int i = 0; i < ImageDimension; i++ )
   {
-    /** ... create the filtered images ... */
-    ui_FA[ i ] = CoefficientImageType::New();
-    ui_FB[ i ] = CoefficientImageType::New();
-    ui_FD[ i ] = CoefficientImageType::New();
-    ui_FE[ i ] = CoefficientImageType::New();
-    ui_FG[ i ] = CoefficientImageType::New();
-    if( ImageDimension == 3 )
-    {
-      ui_FC[ i ] = CoefficientImageType::New();
-      ui_FF[ i ] = CoefficientImageType::New();
-      ui_FH[ i ] = CoefficientImageType::New();
-      ui_FI[ i ] = CoefficientImageType::New();
-    }
-    /** ... and the apropiate operators.
+    /** ... create the apropiate operators.
      * The operators C, D and E from the paper are here created
      * by Create1DOperator D, E and G, because of the 3D case and history.
      */
@@ -1072,20 +1055,35 @@ TransformRigidityPenaltyTerm< TFixedImage, TScalarType >
    *
    ************************************************************************* */
 
-  /** Filter the inputImages. */
+  /** Filter the inputImages with all operators at once, in the rigid region.
+   * Outside that region the filtered images are zero.
+   */
+  std::vector< SeparableOperatorType > operators;
+  operators.push_back( Operators_A ); operators.push_back( Operators_B );
+  operators.push_back( Operators_D ); operators.push_back( Operators_E );
+  operators.push_back( Operators_G );
+  if( ImageDimension == 3 )
+  {
+    operators.push_back( Operators_C ); operators.push_back( Operators_F );
+    operators.push_back( Operators_H ); operators.push_back( Operators_I );
+  }
+  this->m_SeparableConvolutionEngine->SetOperators( operators );
+  this->m_SeparableConvolutionEngine->SetRegionOfInterest( rigidRegion );
+  this->m_SeparableConvolutionEngine->Filter( inputImages );
+
   for( unsigned int i = 0; i < ImageDimension; i++ )
   {
-    ui_FA[ i ] = this->FilterSeparable( inputImages[ i ], Operators_A );
-    ui_FB[ i ] = this->FilterSeparable( inputImages[ i ], Operators_B );
-    ui_FD[ i ] = this->FilterSeparable( inputImages[ i ], Operators_D );
-    ui_FE[ i ] = this->FilterSeparable( inputImages[ i ], Operators_E );
-    ui_FG[ i ] = this->FilterSeparable( inputImages[ i ], Operators_G );
+    ui_FA[ i ] = this->m_SeparableConvolutionEngine->GetOutput( i, 0 );
+    ui_FB[ i ] = this->m_SeparableConvolutionEngine->GetOutput( i, 1 );
+    ui_FD[ i ] = this->m_SeparableConvolutionEngine->GetOutput( i, 2 );
+    ui_FE[ i ] = this->m_SeparableConvolutionEngine->GetOutput( i, 3 );
+    ui_FG[ i ] = this->m_SeparableConvolutionEngine->GetOutput( i, 4 );
     if( ImageDimension == 3 )
     {
-      ui_FC[ i ] = this->FilterSeparable( inputImages[ i ], Operators_C );
-      ui_FF[ i ] = this->FilterSeparable( inputImages[ i ], Operators_F );
-      ui_FH[ i ] = this->FilterSeparable( inputImages[ i ], Operators_H );
-      ui_FI[ i ] = this->FilterSeparable( inputImages[ i ], Operators_I );
+      ui_FC[ i ] = this->m_SeparableConvolutionEngine->GetOutput( i, 5 );
+      ui_FF[ i ] = this->m_SeparableConvolutionEngine->GetOutput( i, 6 );
+      ui_FH[ i ] = this->m_SeparableConvolutionEngine->GetOutput( i, 7 );
+      ui_FI[ i ] = this->m_SeparableConvolutionEngine->GetOutput( i, 8 );
     }
   }
 
@@ -1101,21 +1099,22 @@ TransformRigidityPenaltyTerm< TFixedImage, TScalarType >
   itF( ImageDimension ), itG( ImageDimension ),
   itH( ImageDimension ), itI( ImageDimension );
 
-  /** Create iterators. */
+  /** Create iterators over the rigid region, where the penalty is nonzero. */
+  CoefficientImageIteratorType it_RCI( this->m_RigidityCoefficientImage, rigidRegion );
   for( unsigned int i = 0; i < ImageDimension; i++ )
   {
     /** Create iterators. */
-    itA[ i ] = CoefficientImageIteratorType( ui_FA[ i ], ui_FA[ i ]->GetLargestPossibleRegion() );
-    itB[ i ] = CoefficientImageIteratorType( ui_FB[ i ], ui_FB[ i ]->GetLargestPossibleRegion() );
-    itD[ i ] = CoefficientImageIteratorType( ui_FD[ i ], ui_FD[ i ]->GetLargestPossibleRegion() );
-    itE[ i ] = CoefficientImageIteratorType( ui_FE[ i ], ui_FE[ i ]->GetLargestPossibleRegion() );
-    itG[ i ] = CoefficientImageIteratorType( ui_FG[ i ], ui_FG[ i ]->GetLargestPossibleRegion() );
+    itA[ i ] = CoefficientImageIteratorType( ui_FA[ i ], rigidRegion );
+    itB[ i ] = CoefficientImageIteratorType( ui_FB[ i ], rigidRegion );
+    itD[ i ] = CoefficientImageIteratorType( ui_FD[ i ], rigidRegion );
+    itE[ i ] = CoefficientImageIteratorType( ui_FE[ i ], rigidRegion );
+    itG[ i ] = CoefficientImageIteratorType( ui_FG[ i ], rigidRegion );
     if( ImageDimension == 3 )
     {
-      itC[ i ] = CoefficientImageIteratorType( ui_FC[ i ], ui_FC[ i ]->GetLargestPossibleRegion() );
-      itF[ i ] = CoefficientImageIteratorType( ui_FF[ i ], ui_FF[ i ]->GetLargestPossibleRegion() );
-      itH[ i ] = CoefficientImageIteratorType( ui_FH[ i ], ui_FH[ i ]->GetLargestPossibleRegion() );
-      itI[ i ] = CoefficientImageIteratorType( ui_FI[ i ], ui_FI[ i ]->GetLargestPossibleRegion() );
+      itC[ i ] = CoefficientImageIteratorType( ui_FC[ i ], rigidRegion );
+      itF[ i ] = CoefficientImageIteratorType( ui_FF[ i ], rigidRegion );
+      itH[ i ] = CoefficientImageIteratorType( ui_FH[ i ], rigidRegion );
+      itI[ i ] = CoefficientImageIteratorType( ui_FI[ i ], rigidRegion );
     }
     /** Reset iterators. */
     itA[ i ].GoToBegin(); itB[ i ].GoToBegin();
@@ -1127,7 +1126,11 @@ TransformRigidityPenaltyTerm< TFixedImage, TScalarType >
     }
   }
 
-  /** Create orthonormality and properness parts. */
+  /** Create orthonormality and properness parts. They are only computed in
+   * the rigid region; outside it they are multiplied by zero coefficients.
+   * The images are kept between iterations.
+   */
+  unsigned int                                          temporaryImage = 0;
   std::vector< std::vector< CoefficientImagePointer > > OCparts( ImageDimension );
   std::vector< std::vector< CoefficientImagePointer > > PCparts( ImageDimension );
   for( unsigned int i = 0; i < ImageDimension; i++ )
@@ -1136,12 +1139,8 @@ TransformRigidityPenaltyTerm< TFixedImage, TScalarType >
     PCparts[ i ].resize( ImageDimension );
     for( unsigned int j = 0; j < ImageDimension; j++ )
     {
-      OCparts[ i ][ j ] = CoefficientImageType::New();
-      OCparts[ i ][ j ]->SetRegions( inputImages[ 0 ]->GetLargestPossibleRegion() );
-      OCparts[ i ][ j ]->Allocate();
-      PCparts[ i ][ j ] = CoefficientImageType::New();
-      PCparts[ i ][ j ]->SetRegions( inputImages[ 0 ]->GetLargestPossibleRegion() );
-      PCparts[ i ][ j ]->Allocate();
+      OCparts[ i ][ j ] = this->GetTemporaryImage( temporaryImage++, inputImages[ 0 ] );
+      PCparts[ i ][ j ] = this->GetTemporaryImage( temporaryImage++, inputImages[ 0 ] );
     }
   }
 
@@ -1153,9 +1152,7 @@ TransformRigidityPenaltyTerm< TFixedImage, TScalarType >
     LCparts[ i ].resize( NofLParts );
     for( unsigned int j = 0; j < NofLParts; j++ )
     {
-      LCparts[ i ][ j ] = CoefficientImageType::New();
-      LCparts[ i ][ j ]->SetRegions( inputImages[ 0 ]->GetLargestPossibleRegion() );
-      LCparts[ i ][ j ]->Allocate();
+      LCparts[ i ][ j ] = this->GetTemporaryImage( temporaryImage++, inputImages[ 0 ] );
     }
   }
 
@@ -1170,17 +1167,14 @@ TransformRigidityPenaltyTerm< TFixedImage, TScalarType >
     itLCp[ i ].resize( NofLParts );
     for( unsigned int j = 0; j < ImageDimension; j++ )
     {
-      itOCp[ i ][ j ] = CoefficientImageIteratorType( OCparts[ i ][ j ],
-        OCparts[ i ][ j ]->GetLargestPossibleRegion() );
+      itOCp[ i ][ j ] = CoefficientImageIteratorType( OCparts[ i ][ j ], rigidRegion );
       itOCp[ i ][ j ].GoToBegin();
-      itPCp[ i ][ j ] = CoefficientImageIteratorType( PCparts[ i ][ j ],
-        PCparts[ i ][ j ]->GetLargestPossibleRegion() );
+      itPCp[ i ][ j ] = CoefficientImageIteratorType( PCparts[ i ][ j ], rigidRegion );
       itPCp[ i ][ j ].GoToBegin();
     }
     for( unsigned int j = 0; j < NofLParts; j++ )
     {
-      itLCp[ i ][ j ] = CoefficientImageIteratorType( LCparts[ i ][ j ],
-        LCparts[ i ][ j ]->GetLargestPossibleRegion() );
+      itLCp[ i ][ j ] = CoefficientImageIteratorType( LCparts[ i ][ j ], rigidRegion );
       itLCp[ i ][ j ].GoToBegin();
     }
   }
@@ -1803,21 +1797,22 @@ TransformRigidityPenaltyTerm< TFixedImage, TScalarType >
    * Create all necessary iterators and operators.
    ************************************************************************* */
 
+  /** The filtered parts are nonzero in the rigid region, padded by the
+   * radius of the ND operators.
+   */
+  RigidityImageRegionType derivativeRegion = rigidRegion;
+  derivativeRegion.PadByRadius( 1 );
+  derivativeRegion.Crop( inputImages[ 0 ]->GetLargestPossibleRegion() );
+
   /** Create filtered orthonormality, properness and linearity parts. */
   std::vector< CoefficientImagePointer > OCpartsF( ImageDimension );
   std::vector< CoefficientImagePointer > PCpartsF( ImageDimension );
   std::vector< CoefficientImagePointer > LCpartsF( ImageDimension );
   for( unsigned int i = 0; i < ImageDimension; i++ )
   {
-    OCpartsF[ i ] = CoefficientImageType::New();
-    OCpartsF[ i ]->SetRegions( inputImages[ 0 ]->GetLargestPossibleRegion() );
-    OCpartsF[ i ]->Allocate();
-    PCpartsF[ i ] = CoefficientImageType::New();
-    PCpartsF[ i ]->SetRegions( inputImages[ 0 ]->GetLargestPossibleRegion() );
-    PCpartsF[ i ]->Allocate();
-    LCpartsF[ i ] = CoefficientImageType::New();
-    LCpartsF[ i ]->SetRegions( inputImages[ 0 ]->GetLargestPossibleRegion() );
-    LCpartsF[ i ]->Allocate();
+    OCpartsF[ i ] = this->GetTemporaryImage( temporaryImage++, inputImages[ 0 ] );
+    PCpartsF[ i ] = this->GetTemporaryImage( temporaryImage++, inputImages[ 0 ] );
+    LCpartsF[ i ] = this->GetTemporaryImage( temporaryImage++, inputImages[ 0 ] );
   }
 
   /** Create neighborhood iterators over the subparts. */
@@ -1834,16 +1829,16 @@ TransformRigidityPenaltyTerm< TFixedImage, TScalarType >
     for( unsigned int j = 0; j < ImageDimension; j++ )
     {
       nitOCp[ i ][ j ] = NeighborhoodIteratorType( radius,
-        OCparts[ i ][ j ], OCparts[ i ][ j ]->GetLargestPossibleRegion() );
+        OCparts[ i ][ j ], derivativeRegion );
       nitOCp[ i ][ j ].GoToBegin();
       nitPCp[ i ][ j ] = NeighborhoodIteratorType( radius,
-        PCparts[ i ][ j ], PCparts[ i ][ j ]->GetLargestPossibleRegion() );
+        PCparts[ i ][ j ], derivativeRegion );
       nitPCp[ i ][ j ].GoToBegin();
     }
     for( unsigned int j = 0; j < NofLParts; j++ )
     {
       nitLCp[ i ][ j ] = NeighborhoodIteratorType( radius,
-        LCparts[ i ][ j ], LCparts[ i ][ j ]->GetLargestPossibleRegion() );
+        LCparts[ i ][ j ], derivativeRegion );
       nitLCp[ i ][ j ].GoToBegin();
     }
   }
@@ -1854,20 +1849,17 @@ TransformRigidityPenaltyTerm< TFixedImage, TScalarType >
   std::vector< CoefficientImageIteratorType > itLCpf( ImageDimension );
   for( unsigned int i = 0; i < ImageDimension; i++ )
   {
-    itOCpf[ i ] = CoefficientImageIteratorType( OCpartsF[ i ],
-      OCpartsF[ i ]->GetLargestPossibleRegion() );
+    itOCpf[ i ] = CoefficientImageIteratorType( OCpartsF[ i ], derivativeRegion );
     itOCpf[ i ].GoToBegin();
-    itPCpf[ i ] = CoefficientImageIteratorType( PCpartsF[ i ],
-      PCpartsF[ i ]->GetLargestPossibleRegion() );
+    itPCpf[ i ] = CoefficientImageIteratorType( PCpartsF[ i ], derivativeRegion );
     itPCpf[ i ].GoToBegin();
-    itLCpf[ i ] = CoefficientImageIteratorType( LCpartsF[ i ],
-      LCpartsF[ i ]->GetLargestPossibleRegion() );
+    itLCpf[ i ] = CoefficientImageIteratorType( LCpartsF[ i ], derivativeRegion );
     itLCpf[ i ].GoToBegin();
   }
 
   /** Create a neigborhood iterator over the rigidity image. */
   NeighborhoodIteratorType nit_RCI( radius, this->m_RigidityCoefficientImage,
-  this->m_RigidityCoefficientImage->GetLargestPossibleRegion() );
+  derivativeRegion );
   nit_RCI.GoToBegin();
   unsigned int neighborhoodSize = nit_RCI.Size();
 
@@ -2065,35 +2057,29 @@ TransformRigidityPenaltyTerm< TFixedImage, TScalarType >
    * Add it all to create the final derivative images.
    ************************************************************************* */
 
-  /** Create derivative images, each holding a component of the vector field. */
-  std::vector< CoefficientImagePointer > derivativeImages( ImageDimension );
+  /** Reset the iterators over the filtered parts. */
   for( unsigned int i = 0; i < ImageDimension; i++ )
   {
-    derivativeImages[ i ] = CoefficientImageType::New();
-    derivativeImages[ i ]->SetRegions( inputImages[ i ]->GetLargestPossibleRegion() );
-    derivativeImages[ i ]->Allocate();
-  }
-
-  /** Create iterators over the derivative images. */
-  std::vector< CoefficientImageIteratorType > itDIs( ImageDimension );
-  for( unsigned int i = 0; i < ImageDimension; i++ )
-  {
-    itDIs[ i ] = CoefficientImageIteratorType( derivativeImages[ i ],
-      derivativeImages[ i ]->GetLargestPossibleRegion() );
-    itDIs[ i ].GoToBegin();
     itOCpf[ i ].GoToBegin();
     itPCpf[ i ].GoToBegin();
     itLCpf[ i ].GoToBegin();
   }
 
-  /** Do the addition. */
+  /** Do the addition, and rearrange to create a derivative. Component i of
+   * the grid point with offset o is derivative element i * N + o, where N is
+   * the number of grid points. The derivative is zero outside the region of
+   * the filtered parts.
+   */
   // NOTE: unlike the values, for the derivatives weight * derivative is returned.
-  MeasureType gradMagLC                 = NumericTraits< MeasureType >::Zero;
-  MeasureType gradMagOC                 = NumericTraits< MeasureType >::Zero;
-  MeasureType gradMagPC                 = NumericTraits< MeasureType >::Zero;
-  double      rigidityCoefficientSumSqr = rigidityCoefficientSum * rigidityCoefficientSum;
-  while( !itDIs[ 0 ].IsAtEnd() )
-  {
+  MeasureType           gradMagLC                 = NumericTraits< MeasureType >::Zero;
+  MeasureType           gradMagOC                 = NumericTraits< MeasureType >::Zero;
+  MeasureType           gradMagPC                 = NumericTraits< MeasureType >::Zero;
+  double                rigidityCoefficientSumSqr = rigidityCoefficientSum * rigidityCoefficientSum;
+  const OffsetValueType numberOfGridPoints
+    = static_cast< OffsetValueType >( inputImages[ 0 ]->GetLargestPossibleRegion().GetNumberOfPixels() );
+  while( !itOCpf[ 0 ].IsAtEnd() )
+  {
+    const OffsetValueType offset = inputImages[ 0 ]->ComputeOffset( itOCpf[ 0 ].GetIndex() );
     for( unsigned int i = 0; i < ImageDimension; i++ )
     {
       ScalarType tmpDIs = NumericTraits< ScalarType >::Zero;
@@ -2123,10 +2109,10 @@ TransformRigidityPenaltyTerm< TFixedImage, TScalarType >
       {
         tmpDIs += tmpPC;
       }
-      itDIs[ i ].Set( tmpDIs );
+      derivative[ i * numberOfGridPoints + offset ] = tmpDIs / rigidityCoefficientSum;
 
       /** Update iterators. */
-      ++itDIs[ i ]; ++itOCpf[ i ]; ++itPCpf[ i ]; ++itLCpf[ i ];
+      ++itOCpf[ i ]; ++itPCpf[ i ]; ++itLCpf[ i ];
     }
   } // end while
 
@@ -2135,19 +2121,6 @@ TransformRigidityPenaltyTerm< TFixedImage, TScalarType >
   this->m_OrthonormalityConditionGradientMagnitude = std::sqrt( gradMagOC );
   this->m_PropernessConditionGradientMagnitude     = std::sqrt( gradMagPC );
 
-  /** Rearrange to create a derivative. */
-  unsigned int j = 0;
-  for( unsigned int i = 0; i < ImageDimension; i++ )
-  {
-    itDIs[ i ].GoToBegin();
-    while( !itDIs[ i ].IsAtEnd() )
-    {
-      derivative[ j ] = itDIs[ i ].Get() / rigidityCoefficientSum;
-      ++itDIs[ i ];
-      j++;
-    } // end while
-  } // end for
-
 } // end GetValueAndDerivative()
 
 
@@ -2382,38 +2355,94 @@ TransformRigidityPenaltyTerm< TFixedImage, TScalarType >
 
 
 /**
- * ************************** FilterSeparable ********************
+ * ******************* ComputeRigidityCoefficientSum *****************
  */
 
 template< class TFixedImage, class TScalarType >
-typename TransformRigidityPenaltyTerm< TFixedImage, TScalarType >::CoefficientImagePointer
+typename TransformRigidityPenaltyTerm< TFixedImage, TScalarType >::ScalarType
 TransformRigidityPenaltyTerm< TFixedImage, TScalarType >
-::FilterSeparable(
-  const CoefficientImageType * image,
-  const std::vector< NeighborhoodType > & Operators ) const
+::ComputeRigidityCoefficientSum( RigidityImageRegionType & rigidRegion ) const
 {
-  /** Create filters, supply them with boundary conditions and operators. */
-  std::vector< typename NOIFType::Pointer > filters( ImageDimension );
-  for( unsigned int i = 0; i < ImageDimension; i++ )
+  /** Create iterator over the rigidity coeficient image. */
+  typedef ImageRegionConstIteratorWithIndex< RigidityImageType > IteratorType;
+  IteratorType it( this->m_RigidityCoefficientImage,
+    this->m_RigidityCoefficientImage->GetLargestPossibleRegion() );
+  it.GoToBegin();
+
+  /** Add the rigidity coefficients together, and keep track of the
+   * bounding box of the nonzero coefficients.
+   */
+  ScalarType             rigidityCoefficientSum = NumericTraits< ScalarType >::Zero;
+  RigidityImageIndexType first, last;
+  first.Fill( NumericTraits< IndexValueType >::max() );
+  last.Fill( NumericTraits< IndexValueType >::NonpositiveMin() );
+  while( !it.IsAtEnd() )
+  {
+    const RigidityPixelType coefficient = it.Get();
+    rigidityCoefficientSum += coefficient;
+    if( coefficient != NumericTraits< RigidityPixelType >::Zero )
+    {
+      const RigidityImageIndexType & index = it.GetIndex();
+      for( unsigned int i = 0; i < ImageDimension; i++ )
+      {
+        first[ i ] = vnl_math_min( first[ i ], index[ i ] );
+        last[ i ]  = vnl_math_max( last[ i ], index[ i ] );
+      }
+    }
+    ++it;
+  }
+
+  /** An empty region if all coefficients are zero. */
+  typename RigidityImageRegionType::SizeType size;
+  size.Fill( 0 );
+  if( first[ 0 ] <= last[ 0 ] )
+  {
+    for( unsigned int i = 0; i < ImageDimension; i++ )
+    {
+      size[ i ] = static_cast< SizeValueType >( last[ i ] - first[ i ] + 1 );
+    }
+  }
+  else
   {
-    filters[ i ] = NOIFType::New();
-    filters[ i ]->SetOperator( Operators[ i ] );
+    first = this->m_RigidityCoefficientImage->GetLargestPossibleRegion().GetIndex();
   }
+  rigidRegion.SetIndex( first );
+  rigidRegion.SetSize( size );
+
+  return rigidityCoefficientSum;
+
+} // end ComputeRigidityCoefficientSum()
 
-  /** Set up the mini-pipline. */
-  filters[ 0 ]->SetInput( image );
-  for( unsigned int i = 1; i < ImageDimension; i++ )
+
+/**
+ * ************************** GetTemporaryImage ********************
+ */
+
+template< class TFixedImage, class TScalarType >
+typename TransformRigidityPenaltyTerm< TFixedImage, TScalarType >::CoefficientImageType *
+TransformRigidityPenaltyTerm< TFixedImage, TScalarType >
+::GetTemporaryImage( const unsigned int number, const CoefficientImageType * grid ) const
+{
+  if( number >= this->m_TemporaryImages.size() )
   {
-    filters[ i ]->SetInput( filters[ i - 1 ]->GetOutput() );
+    this->m_TemporaryImages.resize( number + 1 );
   }
 
-  /** Execute the mini-pipeline. */
-  filters[ ImageDimension - 1 ]->Update();
+  /** (Re)allocate the image only when the grid changed. */
+  CoefficientImagePointer & image = this->m_TemporaryImages[ number ];
+  if( image.IsNull()
+    || image->GetLargestPossibleRegion() != grid->GetLargestPossibleRegion() )
+  {
+    image = CoefficientImageType::New();
+    image->SetRegions( grid->GetLargestPossibleRegion() );
+    image->Allocate();
+    image->FillBuffer( NumericTraits< ScalarType >::Zero );
+  }
+  image->CopyInformation( grid );
 
-  /** Return the filtered image. */
-  return filters[ ImageDimension - 1 ]->GetOutput();
+  return image;
 
-} // end FilterSeparable()
+} // end GetTemporaryImage()
 
 
 /**
@@ -182,6 +182,23 @@ namespace elastix
  *   The parameter can be specified for each resolution, or for all resolutions at once.\n
  *   example: <tt>(NoiseCompensation "true")</tt>\n
  *   Default/recommended: true.
+ * \parameter UsePreconditioning: Selects whether or not to precondition the gradient
+ *   with a diagonal preconditioner, which is estimated at the start of each resolution
+ *   from the Jacobians of the transform at NumberOfJacobianMeasurements voxels. This
+ *   speeds up convergence when the parameters have a very different influence on the
+ *   transformation, like B-spline coefficients near the border of a mask. When
+ *   AutomaticParameterEstimation is used, the step size is always estimated with the
+ *   "DisplacementDistribution" method, for the preconditioned gradient.
+ *   The parameter can be specified for each resolution, or for all resolutions at once.\n
+ *   example: <tt>(UsePreconditioning "true")</tt>\n
+ *   Default: false.
+ * \parameter PreconditionerConditionNumber: The maximum ratio between the largest and
+ *   the smallest element of the preconditioner. Larger values correct for larger
+ *   differences between the parameters, but amplify the noise in parameters that
+ *   have little influence.
+ *   The parameter can be specified for each resolution, or for all resolutions at once.\n
+ *   example: <tt>(PreconditionerConditionNumber 10.0)</tt>\n
+ *   Default: 10.0.
  *
  * \todo: this class contains a lot of functional code, which actually does not belong here.
  *
@@ -261,6 +278,9 @@ public:
   /** Stop optimization and pass on exception. */
   virtual void MetricErrorResponse( itk::ExceptionObject & err );
 
+  /** Stop optimization, because the convergence monitor detected convergence. */
+  virtual void StopOptimizationAtConvergence( void );
+
   /** Set/Get whether automatic parameter estimation is desired.
    * If true, make sure to set the maximum step length.
    *
@@ -402,6 +422,9 @@ protected:
    */
   virtual void AddRandomPerturbation( ParametersType & parameters, double sigma );
 
+  /** Estimate the diagonal preconditioner for the current resolution. */
+  virtual void ComputePreconditioner( void );
+
 private:
 
   AdaptiveStochasticGradientDescent( const Self & );  // purposely not implemented
@@ -425,6 +448,10 @@ private:
   bool m_UseNoiseCompensation;
   bool m_OriginalButSigmoidToDefault;
 
+  /** Settings of the preconditioner. */
+  bool   m_UsePreconditioning;
+  double m_PreconditionerConditionNumber;
+
 };
 
 } // end namespace elastix
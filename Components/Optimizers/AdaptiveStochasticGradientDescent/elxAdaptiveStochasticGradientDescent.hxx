@@ -60,6 +60,9 @@ AdaptiveStochasticGradientDescent< TElastix >
   this->m_UseNoiseCompensation        = true;
   this->m_OriginalButSigmoidToDefault = false;
 
+  this->m_UsePreconditioning            = false;
+  this->m_PreconditionerConditionNumber = 10.0;
+
 } // Constructor
 
 
@@ -160,6 +163,17 @@ AdaptiveStochasticGradientDescent< TElastix >
     "UseAdaptiveStepSizes", this->GetComponentLabel(), level, 0 );
   this->SetUseAdaptiveStepSizes( useAdaptiveStepSizes );
 
+  /** Set whether the gradient is preconditioned; default: false.
+   * The preconditioner itself is estimated in ResumeOptimization.
+   */
+  this->m_UsePreconditioning = false;
+  this->GetConfiguration()->ReadParameter( this->m_UsePreconditioning,
+    "UsePreconditioning", this->GetComponentLabel(), level, 0 );
+  this->m_PreconditionerConditionNumber = 10.0;
+  this->GetConfiguration()->ReadParameter( this->m_PreconditionerConditionNumber,
+    "PreconditionerConditionNumber", this->GetComponentLabel(), level, 0 );
+  this->SetPreconditioner( DerivativeType() );
+
   /** Set whether automatic gain estimation is required; default: true. */
   this->m_AutomaticParameterEstimation = true;
   this->GetConfiguration()->ReadParameter( this->m_AutomaticParameterEstimation,
@@ -304,6 +318,12 @@ AdaptiveStochasticGradientDescent< TElastix >
     this->SelectNewSamples();
   }
 
+  /** Check for convergence, if desired. */
+  if( this->GetUseConvergenceMonitor() )
+  {
+    this->CheckForConvergence( this->GetValue(), this->GetGradient().magnitude() );
+  }
+
 } // end AfterEachIteration()
 
 
@@ -324,7 +344,8 @@ AdaptiveStochasticGradientDescent< TElastix >
    * typedef enum {
    *   MaximumNumberOfIterations,
    *   MetricError,
-   *   MinimumStepSize } StopConditionType;
+   *   MinimumStepSize,
+   *   ConvergenceDetected } StopConditionType;
    */
   std::string stopcondition;
 
@@ -338,6 +359,10 @@ AdaptiveStochasticGradientDescent< TElastix >
       stopcondition = "Error in metric";
       break;
 
+    case ConvergenceDetected:
+      stopcondition = "Convergence was detected";
+      break;
+
     case MinimumStepSize:
       stopcondition = "The minimum step length has been reached";
       break;
@@ -439,10 +464,17 @@ AdaptiveStochasticGradientDescent< TElastix >
    * position has been set, so must be called in this
    * function. */
 
-  if( this->GetAutomaticParameterEstimation()
-    && !this->m_AutomaticParameterEstimationDone )
+  if( !this->m_AutomaticParameterEstimationDone )
   {
-    this->AutomaticParameterEstimation();
+    /** The step size estimation depends on the preconditioner. */
+    if( this->m_UsePreconditioning )
+    {
+      this->ComputePreconditioner();
+    }
+    if( this->GetAutomaticParameterEstimation() )
+    {
+      this->AutomaticParameterEstimation();
+    }
     // hack
     this->m_AutomaticParameterEstimationDone = true;
   }
@@ -485,6 +517,21 @@ AdaptiveStochasticGradientDescent< TElastix >
 } // end MetricErrorResponse()
 
 
+/**
+ * ****************** StopOptimizationAtConvergence *************************
+ */
+
+template< class TElastix >
+void
+AdaptiveStochasticGradientDescent< TElastix >
+::StopOptimizationAtConvergence( void )
+{
+  this->m_StopCondition = ConvergenceDetected;
+  this->StopOptimization();
+
+} // end StopOptimizationAtConvergence()
+
+
 /**
  * ******************* AutomaticParameterEstimation **********************
  */
@@ -506,6 +553,15 @@ AdaptiveStochasticGradientDescent< TElastix >
   this->GetConfiguration()->ReadParameter( asgdParameterEstimationMethod,
     "ASGDParameterEstimationMethod", this->GetComponentLabel(), 0, 0 );
 
+  /** Only the displacement distribution accounts for the preconditioner. */
+  if( this->m_UsePreconditioning
+    && asgdParameterEstimationMethod != "DisplacementDistribution" )
+  {
+    elxout << "  Using the DisplacementDistribution method, because "
+           << "UsePreconditioning is set to \"true\"." << std::endl;
+    asgdParameterEstimationMethod = "DisplacementDistribution";
+  }
+
   /** Perform automatic optimizer parameter estimation by the desired method. */
   if( asgdParameterEstimationMethod == "Original" )
   {
@@ -729,6 +785,7 @@ AdaptiveStochasticGradientDescent< TElastix >
   computeDisplacementDistribution->SetCostFunction( this->m_CostFunction );
   computeDisplacementDistribution->SetNumberOfJacobianMeasurements(
     this->m_NumberOfJacobianMeasurements );
+  computeDisplacementDistribution->SetPreconditioner( this->GetPreconditioner() );
 
   /** Check if use scales. */
   if( this->GetUseScales() )
@@ -808,6 +865,74 @@ AdaptiveStochasticGradientDescent< TElastix >
 } // end AutomaticParameterEstimationUsingDisplacementDistribution()
 
 
+/**
+ * *************** ComputePreconditioner *****
+ */
+
+template< class TElastix >
+void
+AdaptiveStochasticGradientDescent< TElastix >
+::ComputePreconditioner( void )
+{
+  itk::TimeProbe timer;
+  timer.Start();
+  elxout << "Computing the preconditioner for "
+         << this->elxGetClassName() << " ..." << std::endl;
+
+  /** The Jacobians are computed at the current position. */
+  this->GetRegistration()->GetAsITKBaseType()->GetModifiableTransform()->SetParameters(
+    this->GetCurrentPosition() );
+
+  /** Cast to advanced metric type. */
+  typedef typename ElastixType::MetricBaseType::AdvancedMetricType MetricType;
+  MetricType * testPtr = dynamic_cast< MetricType * >(
+    this->GetElastix()->GetElxMetricBase()->GetAsITKBaseType() );
+  if( !testPtr )
+  {
+    itkExceptionMacro( << "ERROR: AdaptiveStochasticGradientDescent expects "
+                       << "the metric to be of type AdvancedImageToImageMetric!" );
+  }
+
+  /** The number of Jacobian measurements is only set with automatic
+   * parameter estimation, so use the same default otherwise.
+   */
+  const unsigned int level = static_cast< unsigned int >(
+    this->m_Registration->GetAsITKBaseType()->GetCurrentLevel() );
+  const SizeValueType P = this->GetScaledCurrentPosition().GetSize();
+  SizeValueType numberOfJacobianMeasurements = vnl_math_max(
+    static_cast< SizeValueType >( 1000 ), P );
+  this->GetConfiguration()->ReadParameter( numberOfJacobianMeasurements,
+    "NumberOfJacobianMeasurements", this->GetComponentLabel(), level, 0 );
+
+  typename ComputeDisplacementDistributionType::Pointer
+  computeDisplacementDistribution = ComputeDisplacementDistributionType::New();
+  computeDisplacementDistribution->SetFixedImage( testPtr->GetFixedImage() );
+  computeDisplacementDistribution->SetFixedImageRegion( testPtr->GetFixedImageRegion() );
+  computeDisplacementDistribution->SetFixedImageMask( testPtr->GetFixedImageMask() );
+  computeDisplacementDistribution->SetTransform(
+    this->GetRegistration()->GetAsITKBaseType()->GetModifiableTransform() );
+  computeDisplacementDistribution->SetNumberOfJacobianMeasurements(
+    numberOfJacobianMeasurements );
+  computeDisplacementDistribution->SetUseScales( this->GetUseScales() );
+  if( this->GetUseScales() )
+  {
+    computeDisplacementDistribution->SetScales( this->m_ScaledCostFunction->GetScales() );
+  }
+
+  DerivativeType preconditioner;
+  computeDisplacementDistribution->ComputePreconditioner(
+    this->m_PreconditionerConditionNumber, preconditioner );
+  this->SetPreconditioner( preconditioner );
+
+  timer.Stop();
+  elxout << "  The preconditioner ranges from " << preconditioner.min_value()
+         << " to " << preconditioner.max_value() << ".\n"
+         << "Computing the preconditioner took "
+         << this->ConvertSecondsToDHMS( timer.GetMean(), 2 ) << std::endl;
+
+} // end ComputePreconditioner()
+
+
 /**
  * ******************** SampleGradients **********************
  */
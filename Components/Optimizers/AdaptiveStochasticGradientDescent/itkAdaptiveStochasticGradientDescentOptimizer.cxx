@@ -39,6 +39,29 @@ AdaptiveStochasticGradientDescentOptimizer
 } // end Constructor
 
 
+/**
+ * ************************** AdvanceOneStep ********************
+ */
+
+void
+AdaptiveStochasticGradientDescentOptimizer
+::AdvanceOneStep( void )
+{
+  /** Precondition the gradient. */
+  const unsigned int spaceDimension = this->m_Gradient.GetSize();
+  if( this->m_Preconditioner.GetSize() == spaceDimension )
+  {
+    for( unsigned int j = 0; j < spaceDimension; ++j )
+    {
+      this->m_Gradient[ j ] *= this->m_Preconditioner[ j ];
+    }
+  }
+
+  this->Superclass::AdvanceOneStep();
+
+} // end AdvanceOneStep()
+
+
 /**
  * ************************** UpdateCurrentTime ********************
  */
@@ -58,6 +58,15 @@ namespace itk
 * International Journal of Computer Vision, vol. 81, no. 3, pp. 227-239, 2009.
 * http://dx.doi.org/10.1007/s11263-008-0168-y
 
+* Optionally, a diagonal preconditioner \f$P\f$ may be set. The update then reads:
+*
+*     \f[ x(k+1) = x(k) - a(t_k) P dC/dx \f]
+*
+* and \f$g_k\f$ in the time update equals the preconditioned gradient
+* \f$P dC/dx\f$. This compensates for parameters that have a very different
+* influence on the transformation, like B-spline coefficients that are only
+* partly supported by a mask.
+*
 * It is very suitable to be used in combination with a stochastic estimate
 * of the gradient \f$dC/dx\f$. For example, in image registration problems it is
 * often advantageous to compute the metric derivative (\f$dC/dx\f$) on a new set
@@ -117,6 +126,15 @@ public:
   itkSetMacro( SigmoidScale, double );
   itkGetConstMacro( SigmoidScale, double );
 
+  /** Set/Get the diagonal preconditioner. The preconditioner is only used
+  * when its size equals the number of parameters. Default: empty. */
+  itkSetMacro( Preconditioner, DerivativeType );
+  itkGetConstReferenceMacro( Preconditioner, DerivativeType );
+
+  /** Multiply the gradient by the preconditioner, if any, and call the
+  * superclass' implementation. */
+  virtual void AdvanceOneStep( void );
+
 protected:
 
   AdaptiveStochasticGradientDescentOptimizer();
@@ -145,6 +163,8 @@ private:
   double m_SigmoidMin;
   double m_SigmoidScale;
 
+  DerivativeType m_Preconditioner;
+
 };
 
 } // end namespace itk
@@ -128,6 +128,9 @@ public:
   /** Stop optimisation and pass on exception. */
   virtual void MetricErrorResponse( itk::ExceptionObject & err );
 
+  /** Stop optimization, because the convergence monitor detected convergence. */
+  virtual void StopOptimizationAtConvergence( void );
+
   /** Add SetCurrentPositionPublic, which calls the protected
   * SetCurrentPosition of the itkStandardGradientDescentOptimizer class.
   */
@@ -131,6 +131,12 @@ StandardGradientDescent< TElastix >
     this->SelectNewSamples();
   }
 
+  /** Check for convergence, if desired. */
+  if( this->GetUseConvergenceMonitor() )
+  {
+    this->CheckForConvergence( this->GetValue(), this->GetGradient().magnitude() );
+  }
+
 } // end AfterEachIteration()
 
 
@@ -144,7 +150,8 @@ StandardGradientDescent< TElastix >
 ::AfterEachResolution( void )
 {
   /**
-   * enum   StopConditionType {  MaximumNumberOfIterations, MetricError }
+   * enum   StopConditionType {  MaximumNumberOfIterations, MetricError,
+   *   MinimumStepSize, ConvergenceDetected }
    */
   std::string stopcondition;
   switch( this->GetStopCondition() )
@@ -158,6 +165,10 @@ StandardGradientDescent< TElastix >
       stopcondition = "Error in metric";
       break;
 
+    case ConvergenceDetected:
+      stopcondition = "Convergence was detected";
+      break;
+
     default:
       stopcondition = "Unknown";
       break;
@@ -256,6 +267,21 @@ StandardGradientDescent< TElastix >
 } // end MetricErrorResponse()
 
 
+/**
+ * ****************** StopOptimizationAtConvergence *************************
+ */
+
+template< class TElastix >
+void
+StandardGradientDescent< TElastix >
+::StopOptimizationAtConvergence( void )
+{
+  this->m_StopCondition = ConvergenceDetected;
+  this->StopOptimization();
+
+} // end StopOptimizationAtConvergence()
+
+
 } // end namespace elastix
 
 #endif // end #ifndef __elxStandardGradientDescent_hxx
@@ -88,6 +88,12 @@ namespace elastix
  *    example: <tt>(Metric0Use "false" "true")</tt> \n
  *    example: <tt>(Metric1Use "true" "false")</tt> \n
  *    The default is "true".
+ * \parameter UseSharedTransformEvaluation: Whether penalty terms that use
+ *    the same image sampler, such as the TransformBendingEnergyPenalty and
+ *    the DisplacementMagnitudePenalty, evaluate the transform only once per
+ *    sample, instead of once per sample for each penalty term. \n
+ *    example: <tt>(UseSharedTransformEvaluation "false")</tt> \n
+ *    The default is "true".
  *
  * \ingroup Registrations
  */
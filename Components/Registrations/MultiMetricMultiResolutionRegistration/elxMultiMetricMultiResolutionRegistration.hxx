@@ -113,6 +113,12 @@ MultiMetricMultiResolutionRegistration< TElastix >
   }
   else { this->GetCombinationMetric()->SetUseMultiThread( false ); }
 
+  /** Let penalty terms with the same sampler share the transform evaluation. */
+  bool useSharedTransformEvaluation = true;
+  this->m_Configuration->ReadParameter( useSharedTransformEvaluation,
+    "UseSharedTransformEvaluation", 0, false );
+  this->GetCombinationMetric()->SetUseSharedTransformEvaluation( useSharedTransformEvaluation );
+
 } // end BeforeRegistration()
 
 
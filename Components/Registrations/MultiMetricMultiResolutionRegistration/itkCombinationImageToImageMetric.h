@@ -20,6 +20,7 @@
 
 #include "itkAdvancedImageToImageMetric.h"
 #include "itkSingleValuedPointSetToPointSetMetric.h"
+#include "itkTransformPenaltyTerm.h"
 
 namespace itk
 {
@@ -50,6 +51,14 @@ namespace itk
  * why we chose to reimplement the Get{Transform,Interpolator}()
  * methods.
  *
+ * Penalty terms, such as the bending energy and the displacement magnitude,
+ * that use the same image sampler, transform and moving image mask all
+ * evaluate the transform at the same samples. In GetValueAndDerivative()
+ * these penalty terms share the evaluation of the transform: it is done
+ * once per sample, after which every penalty term adds its own contribution,
+ * see TransformPenaltyTerm. This can be switched off with
+ * SetUseSharedTransformEvaluation( false ).
+ *
  *
  * \ingroup RegistrationMetrics
  *
@@ -165,6 +174,14 @@ public:
   typedef typename Superclass::ThreaderType   ThreaderType;
   typedef typename Superclass::ThreadInfoType ThreadInfoType;
 
+  /** Typedefs for the penalty terms that share the evaluation of the transform. */
+  typedef TransformPenaltyTerm< FixedImageType, double >     TransformPenaltyTermType;
+  typedef typename TransformPenaltyTermType::SampleType      PenaltySampleType;
+  typedef typename TransformPenaltyTermType
+    ::ImageSampleContainerType                               PenaltySampleContainerType;
+  typedef typename TransformPenaltyTermType
+    ::ImageSampleContainerPointer                            PenaltySampleContainerPointer;
+
   /**
    * Get and set the metrics and their weights.
    **/
@@ -203,6 +220,13 @@ public:
   /** \todo: Temporary, should think about interface. */
   itkSetMacro( UseMultiThread, bool );
 
+  /** Set and Get whether penalty terms share the evaluation of the
+   * transform at their samples. Default: true.
+   */
+  itkSetMacro( UseSharedTransformEvaluation, bool );
+  itkGetConstMacro( UseSharedTransformEvaluation, bool );
+  itkBooleanMacro( UseSharedTransformEvaluation );
+
   /** Select which metrics are used.
    * This is useful in case you want to compute a certain measure, but not
    * actually use it during the registration.
@@ -441,6 +465,45 @@ private:
    */
   double GetFinalMetricWeight( unsigned int pos ) const;
 
+  /** A group of penalty terms that share the evaluation of the transform,
+   * and the transform quantities that they need together.
+   */
+  struct SharedTransformEvaluationGroupType
+  {
+    std::vector< unsigned int >                     Metrics;
+    std::vector< const TransformPenaltyTermType * > Penalties;
+    unsigned int                                    Requirements;
+  };
+
+  /** Find the groups of at least two penalty terms that use the same image
+   * sampler, transform and moving image mask. To be called after
+   * BeforeThreadedGetValueAndDerivative() of all metrics.
+   */
+  void InitializeSharedTransformEvaluationGroups( void ) const;
+
+  /** Evaluate the transform once per sample for all penalty terms of a
+   * group, and let them accumulate their value and derivative.
+   */
+  void EvaluateSharedTransformGroup( const unsigned int group ) const;
+
+  /** Evaluate the samples of a thread for a group. */
+  void ThreadedEvaluateSharedTransformGroup(
+    const ThreadIdType threadId, const unsigned int group ) const;
+
+  /** Shared transform evaluation threader callback function. */
+  static ITK_THREAD_RETURN_TYPE SharedTransformEvaluationThreaderCallback( void * arg );
+
+  /** The parameters given to the threads. */
+  struct SharedTransformEvaluationThreaderParameterType
+  {
+    const Self * st_Metric;
+    unsigned int st_Group;
+  };
+
+  bool                                                      m_UseSharedTransformEvaluation;
+  mutable std::vector< SharedTransformEvaluationGroupType > m_SharedTransformEvaluationGroups;
+  mutable SharedTransformEvaluationThreaderParameterType    m_SharedTransformEvaluationThreaderParameters;
+
 };
 
 } // end namespace itk
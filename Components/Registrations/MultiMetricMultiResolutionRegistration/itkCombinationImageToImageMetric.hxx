@@ -161,10 +161,14 @@ template< class TFixedImage, class TMovingImage >
 CombinationImageToImageMetric< TFixedImage, TMovingImage >
 ::CombinationImageToImageMetric()
 {
-  this->m_NumberOfMetrics    = 0;
-  this->m_UseRelativeWeights = false;
+  this->m_NumberOfMetrics              = 0;
+  this->m_UseRelativeWeights           = false;
+  this->m_UseSharedTransformEvaluation = true;
   this->ComputeGradientOff();
 
+  this->m_SharedTransformEvaluationThreaderParameters.st_Metric = this;
+  this->m_SharedTransformEvaluationThreaderParameters.st_Group  = 0;
+
 } // end Constructor
 
 
@@ -194,6 +198,8 @@ CombinationImageToImageMetric< TFixedImage, TMovingImage >
     os << indent << "UseMetric: " << ( this->m_UseMetric[ i ] ? "true\n" : "false\n" );
     os << indent << "MetricComputationTime: " << this->m_MetricComputationTime[ i ] << "\n";
   }
+  os << "UseSharedTransformEvaluation: "
+     << ( this->m_UseSharedTransformEvaluation ? "true" : "false" ) << std::endl;
 
 } // end PrintSelf()
 
@@ -697,6 +703,168 @@ CombinationImageToImageMetric< TFixedImage, TMovingImage >
 } // end GetFinalMetricWeight()
 
 
+/**
+ * ************* InitializeSharedTransformEvaluationGroups *************
+ */
+
+template< class TFixedImage, class TMovingImage >
+void
+CombinationImageToImageMetric< TFixedImage, TMovingImage >
+::InitializeSharedTransformEvaluationGroups( void ) const
+{
+  this->m_SharedTransformEvaluationGroups.clear();
+  if( !this->m_UseSharedTransformEvaluation || !this->m_UseMultiThread )
+  {
+    return;
+  }
+
+  /** Group the penalty terms by image sampler, transform and moving mask.
+   * The samplers have been updated by BeforeThreadedGetValueAndDerivative(),
+   * so penalty terms with the same sampler have the same samples.
+   */
+  const ThreadIdType numberOfThreads = this->GetNumberOfThreads();
+  std::vector< SharedTransformEvaluationGroupType > groups;
+  for( unsigned int i = 0; i < this->m_NumberOfMetrics; ++i )
+  {
+    const TransformPenaltyTermType * penalty
+      = dynamic_cast< const TransformPenaltyTermType * >( this->m_Metrics[ i ].GetPointer() );
+    if( !penalty || !penalty->CanAccumulateSamples( numberOfThreads ) )
+    {
+      continue;
+    }
+
+    unsigned int g = 0;
+    for( ; g < groups.size(); ++g )
+    {
+      const TransformPenaltyTermType * first = groups[ g ].Penalties[ 0 ];
+      if( first->GetImageSampler() == penalty->GetImageSampler()
+        && first->GetTransform() == penalty->GetTransform()
+        && first->GetMovingImageMask() == penalty->GetMovingImageMask() )
+      {
+        break;
+      }
+    }
+    if( g == groups.size() )
+    {
+      groups.push_back( SharedTransformEvaluationGroupType() );
+      groups[ g ].Requirements = 0;
+    }
+    groups[ g ].Metrics.push_back( i );
+    groups[ g ].Penalties.push_back( penalty );
+    groups[ g ].Requirements |= penalty->GetSampleRequirements();
+  }
+
+  /** A single penalty term gains nothing from sharing. */
+  for( unsigned int g = 0; g < groups.size(); ++g )
+  {
+    if( groups[ g ].Metrics.size() > 1 )
+    {
+      this->m_SharedTransformEvaluationGroups.push_back( groups[ g ] );
+    }
+  }
+
+} // end InitializeSharedTransformEvaluationGroups()
+
+
+/**
+ * ******************* EvaluateSharedTransformGroup *******************
+ */
+
+template< class TFixedImage, class TMovingImage >
+void
+CombinationImageToImageMetric< TFixedImage, TMovingImage >
+::EvaluateSharedTransformGroup( const unsigned int group ) const
+{
+  this->m_SharedTransformEvaluationThreaderParameters.st_Group = group;
+
+  /** Setup threader. */
+  this->m_Threader->SetSingleMethod( this->SharedTransformEvaluationThreaderCallback,
+    const_cast< void * >( static_cast< const void * >(
+        &this->m_SharedTransformEvaluationThreaderParameters ) ) );
+
+  /** Launch. */
+  this->m_Threader->SingleMethodExecute();
+
+} // end EvaluateSharedTransformGroup()
+
+
+/**
+ * *************** SharedTransformEvaluationThreaderCallback *******
+ */
+
+template< class TFixedImage, class TMovingImage >
+ITK_THREAD_RETURN_TYPE
+CombinationImageToImageMetric< TFixedImage, TMovingImage >
+::SharedTransformEvaluationThreaderCallback( void * arg )
+{
+  ThreadInfoType * infoStruct = static_cast< ThreadInfoType * >( arg );
+  ThreadIdType     threadID   = infoStruct->ThreadID;
+
+  SharedTransformEvaluationThreaderParameterType * temp
+    = static_cast< SharedTransformEvaluationThreaderParameterType * >( infoStruct->UserData );
+
+  temp->st_Metric->ThreadedEvaluateSharedTransformGroup( threadID, temp->st_Group );
+
+  return ITK_THREAD_RETURN_VALUE;
+
+} // end SharedTransformEvaluationThreaderCallback()
+
+
+/**
+ * *************** ThreadedEvaluateSharedTransformGroup *******
+ */
+
+template< class TFixedImage, class TMovingImage >
+void
+CombinationImageToImageMetric< TFixedImage, TMovingImage >
+::ThreadedEvaluateSharedTransformGroup(
+  const ThreadIdType threadId, const unsigned int group ) const
+{
+  const SharedTransformEvaluationGroupType & sharedGroup
+    = this->m_SharedTransformEvaluationGroups[ group ];
+  const TransformPenaltyTermType * first = sharedGroup.Penalties[ 0 ];
+  const unsigned int numberOfPenalties   = sharedGroup.Penalties.size();
+
+  /** Get a handle to the sample container. */
+  PenaltySampleContainerPointer sampleContainer     = first->GetImageSampler()->GetOutput();
+  const unsigned long           sampleContainerSize = sampleContainer->Size();
+
+  /** Get the samples for this thread. */
+  const unsigned long nrOfSamplesPerThreads
+    = static_cast< unsigned long >( std::ceil( static_cast< double >( sampleContainerSize )
+    / static_cast< double >( this->GetNumberOfThreads() ) ) );
+
+  unsigned long pos_begin = nrOfSamplesPerThreads * threadId;
+  unsigned long pos_end   = nrOfSamplesPerThreads * ( threadId + 1 );
+  pos_begin = ( pos_begin > sampleContainerSize ) ? sampleContainerSize : pos_begin;
+  pos_end   = ( pos_end > sampleContainerSize ) ? sampleContainerSize : pos_end;
+
+  /** Create iterator over the sample container. */
+  typename PenaltySampleContainerType::ConstIterator fiter;
+  typename PenaltySampleContainerType::ConstIterator fbegin = sampleContainer->Begin();
+  typename PenaltySampleContainerType::ConstIterator fend   = sampleContainer->Begin();
+  fbegin                                                   += (int)pos_begin;
+  fend                                                     += (int)pos_end;
+
+  /** Evaluate the transform once per sample, and let all penalty terms
+   * accumulate their contribution.
+   */
+  PenaltySampleType sample;
+  for( fiter = fbegin; fiter != fend; ++fiter )
+  {
+    if( first->EvaluateSample( ( *fiter ).Value().m_ImageCoordinates,
+      sharedGroup.Requirements, sample ) )
+    {
+      for( unsigned int j = 0; j < numberOfPenalties; ++j )
+      {
+        sharedGroup.Penalties[ j ]->AccumulateSample( threadId, sample );
+      }
+    }
+  }
+
+} // end ThreadedEvaluateSharedTransformGroup()
+
+
 /**
  * ********************* GetValue ****************************
  */
@@ -858,9 +1026,44 @@ CombinationImageToImageMetric< TFixedImage, TMovingImage >
   /** Initialize some threading related parameters. */
   this->InitializeThreadingParameters();
 
-  /** Compute all metric values and derivatives. */
+  /** Compute the values and derivatives of the penalty terms that share
+   * the evaluation of the transform, one group at a time.
+   */
+  this->InitializeSharedTransformEvaluationGroups();
+  std::vector< bool > computed( this->m_NumberOfMetrics, false );
+  for( unsigned int g = 0; g < this->m_SharedTransformEvaluationGroups.size(); ++g )
+  {
+    const SharedTransformEvaluationGroupType & group
+      = this->m_SharedTransformEvaluationGroups[ g ];
+
+    timer.Reset();
+    timer.Start();
+    this->EvaluateSharedTransformGroup( g );
+    for( unsigned int j = 0; j < group.Metrics.size(); ++j )
+    {
+      const unsigned int i = group.Metrics[ j ];
+      group.Penalties[ j ]->AfterAccumulateSamples(
+        this->m_MetricValues[ i ], this->m_MetricDerivatives[ i ] );
+      computed[ i ] = true;
+    }
+    timer.Stop();
+
+    /** The computation time is divided over the penalty terms of the group. */
+    for( unsigned int j = 0; j < group.Metrics.size(); ++j )
+    {
+      this->m_MetricComputationTime[ group.Metrics[ j ] ]
+        = timer.GetMean() * 1000.0 / static_cast< double >( group.Metrics.size() );
+    }
+  }
+
+  /** Compute all other metric values and derivatives. */
   for( unsigned int i = 0; i < this->m_NumberOfMetrics; i++ )
   {
+    if( computed[ i ] )
+    {
+      continue;
+    }
+
     /** Compute ... */
     timer.Reset();
     timer.Start();
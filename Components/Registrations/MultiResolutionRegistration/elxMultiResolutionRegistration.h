@@ -37,6 +37,11 @@ namespace elastix
  * \parameter NumberOfResolutions: the number of resolutions used. \n
  *    example: <tt>(NumberOfResolutions 4)</tt> \n
  *    The default is 3.
+ * \parameter CropImagesToFixedMask: crop the fixed and moving image to the
+ *    footprint of the fixed mask before the pyramids are computed. \n
+ *    example: <tt>(CropImagesToFixedMask "true")</tt> \n
+ *    The default is "false". See the RegistrationBase for details and for
+ *    the CropImagesMargin parameter.
  *
  * \ingroup Registrations
  */
@@ -158,6 +163,10 @@ protected:
   /** Read the components from m_Elastix and set them in the Registration class. */
   virtual void SetComponents( void );
 
+  /** Possibly crop the images to the fixed mask, before the
+   * Superclass1 sets up the pyramids. */
+  virtual void PreparePyramids( void );
+
 private:
 
   /** The private constructor. */
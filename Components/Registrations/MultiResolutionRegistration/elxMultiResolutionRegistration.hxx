@@ -101,6 +101,32 @@ MultiResolutionRegistration< TElastix >
 } // end BeforeEachResolution()
 
 
+/**
+ * ******************* PreparePyramids ***********************
+ */
+
+template< class TElastix >
+void
+MultiResolutionRegistration< TElastix >
+::PreparePyramids( void )
+{
+  /** All components are initialized at this point, so the initial
+   * transform can be used to determine the moving image footprint.
+   */
+  this->CropImagesToFixedMask();
+
+  /** Reuse the fixed image pyramid of a previous registration, if possible. */
+  this->UseCachedFixedImagePyramid();
+
+  /** Call the superclass' implementation. */
+  this->Superclass1::PreparePyramids();
+
+  /** Store the fixed image pyramid for the next registrations. */
+  this->CacheFixedImagePyramid();
+
+} // end PreparePyramids()
+
+
 /**
  * *********************** SetComponents ************************
  */
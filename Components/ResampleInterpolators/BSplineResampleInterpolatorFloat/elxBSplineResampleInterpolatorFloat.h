@@ -19,7 +19,7 @@
 #define __elxBSplineResampleInterpolatorFloat_h
 
 #include "elxIncludes.h" // include first to avoid MSVS warning
-#include "itkBSplineInterpolateImageFunction.h"
+#include "itkMultiThreadedBSplineInterpolateImageFunction.h"
 
 namespace elastix
 {
@@ -53,7 +53,7 @@ namespace elastix
 template< class TElastix >
 class BSplineResampleInterpolatorFloat :
   public
-  itk::BSplineInterpolateImageFunction<
+  itk::MultiThreadedBSplineInterpolateImageFunction<
   typename ResampleInterpolatorBase< TElastix >::InputImageType,
   typename ResampleInterpolatorBase< TElastix >::CoordRepType,
   float >,   //CoefficientType
@@ -63,7 +63,7 @@ public:
 
   /** Standard ITK-stuff. */
   typedef BSplineResampleInterpolatorFloat Self;
-  typedef itk::BSplineInterpolateImageFunction<
+  typedef itk::MultiThreadedBSplineInterpolateImageFunction<
     typename ResampleInterpolatorBase< TElastix >::InputImageType,
     typename ResampleInterpolatorBase< TElastix >::CoordRepType,
     float >                                     Superclass1;
@@ -75,7 +75,7 @@ public:
   itkNewMacro( Self );
 
   /** Run-time type information (and related methods). */
-  itkTypeMacro( BSplineResampleInterpolatorFloat, BSplineInterpolateImageFunction );
+  itkTypeMacro( BSplineResampleInterpolatorFloat, MultiThreadedBSplineInterpolateImageFunction );
 
   /** Name of this class.
   * Use this name in the parameter file to select this specific resample interpolator. \n
@@ -76,6 +76,12 @@ namespace elastix
  *   <em>Nonrigid registration of dynamic medical imaging data using nD+t B-splines and a
  *   groupwise optimization approach</em>, C.T. Metz, S. Klein, M. Schaap, T. van Walsum and
  *   W.J. Niessen, Medical Image Analysis, in press.
+ * \parameter UseDyadicGridRefinement: compute the coefficients of the finer grid of the next
+ *   resolution exactly by dyadic subdivision, when the grid spacing halves. Choose from
+ *   {"true", "false"}. This is faster, and exact for spline orders 1 and 3, but the
+ *   coefficients near the border of the grid differ from those of the default method. \n
+ *   example: <tt>(UseDyadicGridRefinement "true")</tt> \n
+ *   The default is "false".
  *
  *
  * The transform parameters necessary for transformix, additionally defined by this class, are:
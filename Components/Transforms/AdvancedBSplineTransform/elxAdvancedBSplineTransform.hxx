@@ -99,6 +99,11 @@ AdvancedBSplineTransform< TElastix >
   this->m_GridUpsampler = GridUpsamplerType::New();
   this->m_GridUpsampler->SetBSplineOrder( this->m_SplineOrder );
 
+  bool useDyadicGridRefinement = false;
+  this->GetConfiguration()->ReadParameter( useDyadicGridRefinement,
+    "UseDyadicGridRefinement", this->GetComponentLabel(), 0, 0, false );
+  this->m_GridUpsampler->SetUseDyadicRefinement( useDyadicGridRefinement );
+
   return 0;
 } // end InitializeBSplineTransform()
 
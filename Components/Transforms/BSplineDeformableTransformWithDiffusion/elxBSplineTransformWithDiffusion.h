@@ -55,6 +55,13 @@ namespace elastix
  * deformation field arrow. Filtering of the deformation field is based
  * on some 'stiffness coefficient' image.
  *
+ * The deformation field is computed multi-threaded, in buffers that are
+ * kept during the registration. Since the B-spline parameters are reset to
+ * zero after each diffusion, the B-spline transform is only evaluated in the
+ * region of the deformation field that is covered by the support of the
+ * nonzero B-spline coefficients; elsewhere the field is taken from the
+ * intermediary deformation field.
+ *
  * \todo: this Transform has not been tested for images with Direction cosines
  * matrix other than the identity matrix.
  *
@@ -259,10 +266,6 @@ public:
   typedef typename ElastixType::MovingImageType MovingImageELXType;
 
   /** Other typedef's.*/
-  typedef itk::Image< short,
-    itkGetStaticConstMacro( SpaceDimension ) >      DummyImageType;
-  typedef itk::ImageRegionConstIterator<
-    DummyImageType >                                DummyIteratorType;
   typedef typename BSplineTransformType::Pointer BSplineTransformPointer;
   typedef typename Superclass1::Superclass       GenericDeformationFieldRegulizer;
 
@@ -369,6 +372,13 @@ protected:
   /** Member variables. */
   SpacingType m_GridSpacingFactor;
 
+  /** Get the region of the deformation field that changed since the last
+   * diffusion, i.e. the region covered by the support of the nonzero
+   * B-spline coefficients. Without an initial transform, the transform
+   * equals the intermediary deformation field outside this region.
+   */
+  RegionType ComputeChangedRegion( void ) const;
+
 private:
 
   /** The private constructor. */
@@ -394,6 +404,7 @@ private:
   RegionType                  m_DeformationRegion;
   OriginType                  m_DeformationOrigin;
   SpacingType                 m_DeformationSpacing;
+  RegionType                  m_ChangedRegion;
 
   /** Member variables for writing diffusion files. */
   bool               m_WriteDiffusionFiles;
@@ -1138,47 +1138,16 @@ BSplineTransformWithDiffusion< TElastix >
 
   /** ------------- 1: Create deformationField. ------------- */
 
-  /** First, create a dummyImage with the right region info, so
-   * that the TransformIndexToPhysicalPoint-functions will be right.
+  /** The B-spline parameters were reset after the last diffusion, so the
+   * deformation field only changed where the B-spline transform is nonzero.
    */
-  typename DummyImageType::Pointer dummyImage = DummyImageType::New();
-  dummyImage->SetRegions( this->m_DeformationRegion );
-  dummyImage->SetOrigin( this->m_DeformationOrigin );
-  dummyImage->SetSpacing( this->m_DeformationSpacing );
-
-  /** Setup an iterator over dummyImage and outputImage. */
-  DummyIteratorType       iter( dummyImage, this->m_DeformationRegion );
-  VectorImageIteratorType iterout( this->m_DeformationField, this->m_DeformationRegion );
-
-  /** Declare stuff. */
-  InputPointType  inputPoint;
-  OutputPointType outputPoint;
-  VectorType      diff_point;
-  IndexType       inputIndex;
-
-  /** Calculate the TransformPoint of all voxels of the image. */
-  iter.GoToBegin();
-  iterout.GoToBegin();
-  while( !iter.IsAtEnd() )
-  {
-    inputIndex = iter.GetIndex();
-    /** Transform the points to physical space. */
-    dummyImage->TransformIndexToPhysicalPoint( inputIndex, inputPoint );
-    /** Call TransformPoint. */
-    outputPoint = this->TransformPoint( inputPoint );
-    /** Calculate the difference. */
-    for( unsigned int i = 0; i < this->FixedImageDimension; i++ )
-    {
-      diff_point[ i ] = outputPoint[ i ] - inputPoint[ i ];
-    }
-    iterout.Set( diff_point );
-    ++iter;
-    ++iterout;
-  }
+  this->m_ChangedRegion = this->ComputeChangedRegion();
+  this->ComputeDeformationField( this->m_DeformationField, this->m_ChangedRegion );
 
   /** ------------- 2: Update the intermediary deformationFieldTransform. ------------- */
 
-  this->UpdateIntermediaryDeformationFieldTransform( this->m_DeformationField );
+  this->UpdateIntermediaryDeformationFieldTransform(
+    this->m_DeformationField, this->m_ChangedRegion );
 
   /** ------------- 3: Create GrayValueImage. ------------- */
 
@@ -1444,6 +1413,28 @@ BSplineTransformWithDiffusion< TElastix >
 } // end DiffuseDeformationField()
 
 
+/**
+ * ******************* ComputeChangedRegion ******************
+ */
+
+template< class TElastix >
+typename BSplineTransformWithDiffusion< TElastix >::RegionType
+BSplineTransformWithDiffusion< TElastix >
+::ComputeChangedRegion( void ) const
+{
+  /** An initial transform changes the complete deformation field. */
+  if( this->Superclass2::GetInitialTransform() != 0 )
+  {
+    return this->m_DeformationRegion;
+  }
+
+  /** Otherwise only the support of the nonzero B-spline coefficients changed. */
+  return this->ComputeBSplineSupportRegion(
+    this->m_BSplineTransform.GetPointer(), this->m_DeformationField.GetPointer() );
+
+} // end ComputeChangedRegion()
+
+
 /**
  * ******************* TransformPoint ******************
  */
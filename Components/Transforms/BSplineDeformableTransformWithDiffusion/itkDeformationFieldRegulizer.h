@@ -21,6 +21,7 @@
 
 #include "itkDeformationVectorFieldTransform.h"
 #include "itkImageRegionIterator.h"
+#include "itkMultiThreader.h"
 
 namespace itk
 {
@@ -87,6 +88,8 @@ public:
   typedef typename VectorImageType::RegionType  RegionType;
   typedef typename VectorImageType::SpacingType SpacingType;
   typedef typename VectorImageType::PointType   OriginType;
+  typedef typename VectorImageType::IndexType   IndexType;
+  typedef typename VectorImageType::SizeType    SizeType;
 
   /** Function to create and initialze the deformation fields. */
   void InitializeDeformationFields( void );
@@ -97,6 +100,12 @@ public:
   virtual void UpdateIntermediaryDeformationFieldTransform(
   typename VectorImageType::Pointer vecImage );
 
+  /** Function to update the intermediary deformation field in a region
+   * only, for when the deformation field did not change elsewhere.
+   */
+  virtual void UpdateIntermediaryDeformationFieldTransform(
+    typename VectorImageType::Pointer vecImage, const RegionType & region );
+
   /** itk Set macro for the region of the deformation field. */
   itkSetMacro( DeformationFieldRegion, RegionType );
 
@@ -112,6 +121,30 @@ public:
   /** Method to transform a point. */
   virtual OutputPointType TransformPoint( const InputPointType & inputPoint ) const;
 
+  /** Get the region of a deformation field that is covered by the support
+   * of the nonzero coefficients of a B-spline transform. Outside this region
+   * the B-spline transform is the identity. Returns an empty region if all
+   * coefficients are zero.
+   */
+  template< class TBSplineTransform >
+  static RegionType ComputeBSplineSupportRegion(
+    const TBSplineTransform * bsplineTransform, const VectorImageType * field );
+
+  /** Compute the deformation field of this transform, multi-threaded.
+   * Only in the changed region the complete transform is evaluated. Outside
+   * it the transform should equal the intermediary deformation field
+   * transform, and only that transform is evaluated.
+   */
+  void ComputeDeformationField( VectorImageType * field,
+    const RegionType & changedRegion ) const;
+
+  /** Set the number of threads of ComputeDeformationField(). */
+  void SetNumberOfThreads( ThreadIdType numberOfThreads )
+  {
+    this->m_Threader->SetNumberOfThreads( numberOfThreads );
+  }
+
+
 protected:
 
   /** The constructor. */
@@ -119,6 +152,25 @@ protected:
   /** The destructor. */
   virtual ~DeformationFieldRegulizer() {}
 
+  /** Typedefs for multi-threading. */
+  typedef itk::MultiThreader             ThreaderType;
+  typedef ThreaderType::ThreadInfoStruct ThreaderInfoType;
+
+  /** The arguments of ComputeDeformationField(), shared with the threads. */
+  struct DeformationFieldThreaderParameterType
+  {
+    const Self *      Transform;
+    VectorImageType * Field;
+    RegionType        ChangedRegion;
+  };
+
+  /** Deformation field threader callback function. */
+  static ITK_THREAD_RETURN_TYPE DeformationFieldThreaderCallback( void * arg );
+
+  /** Compute the deformation field in a part of the field. */
+  void ThreadedComputeDeformationField( VectorImageType * field,
+    const RegionType & changedRegion, const RegionType & region ) const;
+
 private:
 
   /** The private constructor. */
@@ -135,6 +187,8 @@ private:
   OriginType  m_DeformationFieldOrigin;
   SpacingType m_DeformationFieldSpacing;
 
+  ThreaderType::Pointer m_Threader;
+
 };
 
 } // end namespace itk
@@ -21,6 +21,9 @@
 
 #include "itkDeformationFieldRegulizer.h"
 
+#include <algorithm>
+#include <cmath>
+
 namespace itk
 {
 
@@ -36,6 +39,12 @@ DeformationFieldRegulizer< TAnyITKTransform >
   this->m_IntermediaryDeformationFieldTransform = 0;
   this->m_Initialized                           = false;
 
+  /** Create the threader for computing the deformation field. */
+  this->m_Threader = ThreaderType::New();
+#if ITK_VERSION_MAJOR < 5
+  this->m_Threader->SetUseThreadPool( false );
+#endif
+
 } // end Constructor
 
 
@@ -136,6 +145,249 @@ DeformationFieldRegulizer< TAnyITKTransform >
 } // end UpdateIntermediaryDeformationFieldTransform()
 
 
+/**
+ * ******** UpdateIntermediaryDeformationFieldTransform *********
+ */
+
+template< class TAnyITKTransform >
+void
+DeformationFieldRegulizer< TAnyITKTransform >
+::UpdateIntermediaryDeformationFieldTransform(
+  typename VectorImageType::Pointer vecImage, const RegionType & region )
+{
+  /** Only copy the region of the vecImage into the
+   * IntermediaryDeformationFieldTransform.
+   */
+  this->m_IntermediaryDeformationFieldTransform
+  ->SetCoefficientVectorImage( vecImage, region );
+
+} // end UpdateIntermediaryDeformationFieldTransform()
+
+
+/**
+ * ****************** ComputeBSplineSupportRegion ******************
+ */
+
+template< class TAnyITKTransform >
+template< class TBSplineTransform >
+typename DeformationFieldRegulizer< TAnyITKTransform >::RegionType
+DeformationFieldRegulizer< TAnyITKTransform >
+::ComputeBSplineSupportRegion(
+  const TBSplineTransform * bsplineTransform, const VectorImageType * field )
+{
+  typedef typename IndexType::IndexValueType IndexValueType;
+  typedef typename SizeType::SizeValueType   SizeValueType;
+
+  /** Find the bounding box of the nonzero B-spline coefficients. */
+  const typename TBSplineTransform::ParametersType & parameters
+    = bsplineTransform->GetParameters();
+  const typename TBSplineTransform::RegionType gridRegion
+    = bsplineTransform->GetGridRegion();
+  const unsigned long numberOfGridPoints = gridRegion.GetNumberOfPixels();
+
+  IndexType minIndex, maxIndex;
+  bool      found = false;
+  for( unsigned long p = 0; p < numberOfGridPoints; ++p )
+  {
+    bool nonzero = false;
+    for( unsigned int i = 0; i < InputSpaceDimension; i++ )
+    {
+      nonzero |= ( parameters[ p + i * numberOfGridPoints ] != 0.0 );
+    }
+    if( !nonzero )
+    {
+      continue;
+    }
+
+    /** Convert the offset of this coefficient to a grid index. */
+    unsigned long offset = p;
+    for( unsigned int i = 0; i < InputSpaceDimension; i++ )
+    {
+      const IndexValueType index = gridRegion.GetIndex()[ i ]
+        + static_cast< IndexValueType >( offset % gridRegion.GetSize()[ i ] );
+      offset /= gridRegion.GetSize()[ i ];
+      if( !found || index < minIndex[ i ] ) { minIndex[ i ] = index; }
+      if( !found || index > maxIndex[ i ] ) { maxIndex[ i ] = index; }
+    }
+    found = true;
+  }
+
+  /** Nothing changed. */
+  RegionType supportRegion = field->GetLargestPossibleRegion();
+  SizeType   zeroSize;
+  zeroSize.Fill( 0 );
+  if( !found )
+  {
+    supportRegion.SetSize( zeroSize );
+    return supportRegion;
+  }
+
+  /** The support of a coefficient extends (SplineOrder + 1) / 2 grid
+   * spacings to both sides. Map the corners of the support of the
+   * bounding box to the deformation field.
+   */
+  const double support
+    = ( static_cast< double >( TBSplineTransform::SplineOrder ) + 1.0 ) / 2.0;
+  const typename TBSplineTransform::OriginType gridOrigin
+    = bsplineTransform->GetGridOrigin();
+  const typename TBSplineTransform::SpacingType gridSpacing
+    = bsplineTransform->GetGridSpacing();
+  const typename TBSplineTransform::DirectionType gridDirection
+    = bsplineTransform->GetGridDirection();
+
+  IndexType minFieldIndex, maxFieldIndex;
+  for( unsigned int corner = 0; corner < ( 1u << InputSpaceDimension ); ++corner )
+  {
+    InputPointType point;
+    for( unsigned int i = 0; i < InputSpaceDimension; i++ )
+    {
+      point[ i ] = gridOrigin[ i ];
+    }
+    for( unsigned int j = 0; j < InputSpaceDimension; j++ )
+    {
+      const double gridIndex = ( ( corner >> j ) & 1u )
+        ? static_cast< double >( maxIndex[ j ] ) + support
+        : static_cast< double >( minIndex[ j ] ) - support;
+      for( unsigned int i = 0; i < InputSpaceDimension; i++ )
+      {
+        point[ i ] += gridDirection[ i ][ j ] * gridSpacing[ j ] * gridIndex;
+      }
+    }
+
+    ContinuousIndex< double, itkGetStaticConstMacro( InputSpaceDimension ) > cindex;
+    field->TransformPhysicalPointToContinuousIndex( point, cindex );
+    for( unsigned int i = 0; i < InputSpaceDimension; i++ )
+    {
+      const IndexValueType lower = static_cast< IndexValueType >( std::floor( cindex[ i ] ) );
+      const IndexValueType upper = static_cast< IndexValueType >( std::ceil( cindex[ i ] ) );
+      if( corner == 0 || lower < minFieldIndex[ i ] ) { minFieldIndex[ i ] = lower; }
+      if( corner == 0 || upper > maxFieldIndex[ i ] ) { maxFieldIndex[ i ] = upper; }
+    }
+  }
+
+  /** Crop the region by the deformation field. */
+  SizeType size;
+  for( unsigned int i = 0; i < InputSpaceDimension; i++ )
+  {
+    size[ i ] = static_cast< SizeValueType >( maxFieldIndex[ i ] - minFieldIndex[ i ] + 1 );
+  }
+  supportRegion.SetIndex( minFieldIndex );
+  supportRegion.SetSize( size );
+  if( !supportRegion.Crop( field->GetLargestPossibleRegion() ) )
+  {
+    supportRegion = field->GetLargestPossibleRegion();
+    supportRegion.SetSize( zeroSize );
+  }
+
+  return supportRegion;
+
+} // end ComputeBSplineSupportRegion()
+
+
+/**
+ * ******************* ComputeDeformationField ******************
+ */
+
+template< class TAnyITKTransform >
+void
+DeformationFieldRegulizer< TAnyITKTransform >
+::ComputeDeformationField( VectorImageType * field,
+  const RegionType & changedRegion ) const
+{
+  DeformationFieldThreaderParameterType parameters;
+  parameters.Transform     = this;
+  parameters.Field         = field;
+  parameters.ChangedRegion = changedRegion;
+
+  this->m_Threader->SetSingleMethod( this->DeformationFieldThreaderCallback, &parameters );
+  this->m_Threader->SingleMethodExecute();
+
+} // end ComputeDeformationField()
+
+
+/**
+ * ************** DeformationFieldThreaderCallback ***************
+ */
+
+template< class TAnyITKTransform >
+ITK_THREAD_RETURN_TYPE
+DeformationFieldRegulizer< TAnyITKTransform >
+::DeformationFieldThreaderCallback( void * arg )
+{
+  /** Get the current thread id and user data. */
+  ThreaderInfoType * infoStruct = static_cast< ThreaderInfoType * >( arg );
+  ThreadIdType       threadID   = infoStruct->ThreadID;
+  const DeformationFieldThreaderParameterType * parameters
+    = static_cast< const DeformationFieldThreaderParameterType * >( infoStruct->UserData );
+  const Self * self = parameters->Transform;
+
+  /** Distribute the slices in the last dimension evenly over the threads. */
+  const unsigned int  last            = InputSpaceDimension - 1;
+  RegionType          region          = parameters->Field->GetLargestPossibleRegion();
+  const SizeValueType numberOfThreads = self->m_Threader->GetNumberOfThreads();
+  const SizeValueType numberOfSlices  = region.GetSize( last );
+  const SizeValueType slicesPerThread
+    = ( numberOfSlices + numberOfThreads - 1 ) / numberOfThreads;
+  const SizeValueType begin = std::min( threadID * slicesPerThread, numberOfSlices );
+  const SizeValueType end   = std::min( begin + slicesPerThread, numberOfSlices );
+
+  if( begin < end )
+  {
+    region.SetIndex( last, region.GetIndex( last ) + static_cast< OffsetValueType >( begin ) );
+    region.SetSize( last, end - begin );
+    self->ThreadedComputeDeformationField(
+      parameters->Field, parameters->ChangedRegion, region );
+  }
+
+  return ITK_THREAD_RETURN_VALUE;
+
+} // end DeformationFieldThreaderCallback()
+
+
+/**
+ * ************** ThreadedComputeDeformationField ***************
+ */
+
+template< class TAnyITKTransform >
+void
+DeformationFieldRegulizer< TAnyITKTransform >
+::ThreadedComputeDeformationField( VectorImageType * field,
+  const RegionType & changedRegion, const RegionType & region ) const
+{
+  /** Declare stuff. */
+  InputPointType  inputPoint;
+  OutputPointType outputPoint;
+  VectorPixelType diff_point;
+
+  /** Calculate the TransformPoint of all voxels of the region. */
+  IteratorType iterout( field, region );
+  for( iterout.GoToBegin(); !iterout.IsAtEnd(); ++iterout )
+  {
+    /** Transform the index to physical space. */
+    const IndexType inputIndex = iterout.GetIndex();
+    field->TransformIndexToPhysicalPoint( inputIndex, inputPoint );
+
+    /** Call TransformPoint, or only that of the intermediary deformation field. */
+    if( changedRegion.IsInside( inputIndex ) )
+    {
+      outputPoint = this->TransformPoint( inputPoint );
+    }
+    else
+    {
+      outputPoint = this->m_IntermediaryDeformationFieldTransform->TransformPoint( inputPoint );
+    }
+
+    /** Calculate the difference. */
+    for( unsigned int i = 0; i < OutputSpaceDimension; i++ )
+    {
+      diff_point[ i ] = outputPoint[ i ] - inputPoint[ i ];
+    }
+    iterout.Set( diff_point );
+  }
+
+} // end ThreadedComputeDeformationField()
+
+
 } // end namespace itk
 
 #endif // end #ifndef __itkDeformationFieldRegulizer_HXX__
@@ -82,6 +82,7 @@ public:
   typedef typename Superclass::PixelType    CoefficientPixelType;
   typedef typename Superclass::ImageType    CoefficientImageType;
   typedef typename Superclass::ImagePointer CoefficientImagePointer;
+  typedef typename Superclass::RegionType   RegionType;
 
   /** Typedef's for VectorImage. */
   typedef Vector< float,
@@ -101,6 +102,14 @@ public:
    */
   virtual void SetCoefficientVectorImage( const CoefficientVectorImageType * vecImage );
 
+  /** Set the coefficients in a region of the deformation field only.
+   * The other coefficients are kept. This requires that a deformation
+   * field with the same region was set before; otherwise all coefficients
+   * are set.
+   */
+  virtual void SetCoefficientVectorImage( const CoefficientVectorImageType * vecImage,
+    const RegionType & region );
+
   /** Get the coefficient image as a vector image.
    * The vector image is created only on demand. The caller is
    * expected to provide a smart pointer to the resulting image;
@@ -123,6 +132,10 @@ private:
   /** The private copy constructor. */
   void operator=( const Self & );                   // purposely not implemented
 
+  /** Copy a region of the vector image to the coefficient images. */
+  void CopyCoefficientVectorImage( const CoefficientVectorImageType * vecImage,
+    const RegionType & region );
+
   /** Member variables. */
   CoefficientImagePointer m_Images[ SpaceDimension ];
 
@@ -72,30 +72,88 @@ void
 DeformationVectorFieldTransform< TScalarType, NDimensions >
 ::SetCoefficientVectorImage( const CoefficientVectorImageType * vecImage )
 {
-  /** Typedef's for iterators. */
-  typedef ImageRegionConstIterator< CoefficientVectorImageType > VectorIteratorType;
-  typedef ImageRegionIterator< CoefficientImageType >            IteratorType;
-
   /** Create array of images representing the B-spline
-   * coefficients in each dimension.
+   * coefficients in each dimension. The images of a previous
+   * call are reused if the deformation field has the same geometry.
    */
+  const RegionType region = vecImage->GetLargestPossibleRegion();
   for( unsigned int i = 0; i < SpaceDimension; i++ )
   {
-    this->m_Images[ i ] = CoefficientImageType::New();
-    this->m_Images[ i ]->SetRegions( vecImage->GetLargestPossibleRegion() );
-    this->m_Images[ i ]->SetOrigin( vecImage->GetOrigin() );
-    this->m_Images[ i ]->SetSpacing( vecImage->GetSpacing() );
-    this->m_Images[ i ]->Allocate();
+    if( this->m_Images[ i ].IsNull()
+      || this->m_Images[ i ]->GetBufferedRegion() != region
+      || this->m_Images[ i ]->GetOrigin() != vecImage->GetOrigin()
+      || this->m_Images[ i ]->GetSpacing() != vecImage->GetSpacing() )
+    {
+      this->m_Images[ i ] = CoefficientImageType::New();
+      this->m_Images[ i ]->SetRegions( region );
+      this->m_Images[ i ]->SetOrigin( vecImage->GetOrigin() );
+      this->m_Images[ i ]->SetSpacing( vecImage->GetSpacing() );
+      this->m_Images[ i ]->Allocate();
+    }
+  }
+
+  /** Copy one element of a vector to an image. */
+  this->CopyCoefficientVectorImage( vecImage, region );
+
+  /** Put it in the Superclass. */
+  this->SetCoefficientImages( this->m_Images );
+
+} // end SetCoefficientVectorImage()
+
+
+/**
+ * ******************* SetCoefficientVectorImage **********************
+ */
+
+template< class TScalarType, unsigned int NDimensions >
+void
+DeformationVectorFieldTransform< TScalarType, NDimensions >
+::SetCoefficientVectorImage( const CoefficientVectorImageType * vecImage,
+  const RegionType & region )
+{
+  /** Without coefficient images of this geometry, all are set. */
+  if( this->m_Images[ 0 ].IsNull()
+    || this->m_Images[ 0 ]->GetBufferedRegion() != vecImage->GetLargestPossibleRegion()
+    || this->m_Images[ 0 ]->GetOrigin() != vecImage->GetOrigin()
+    || this->m_Images[ 0 ]->GetSpacing() != vecImage->GetSpacing() )
+  {
+    this->SetCoefficientVectorImage( vecImage );
+    return;
+  }
+
+  /** Copy the region, the coefficient images are used by reference. */
+  RegionType croppedRegion = region;
+  if( !croppedRegion.Crop( vecImage->GetLargestPossibleRegion() ) )
+  {
+    return;
   }
+  this->CopyCoefficientVectorImage( vecImage, croppedRegion );
+  this->Modified();
+
+} // end SetCoefficientVectorImage()
+
+
+/**
+ * ******************* CopyCoefficientVectorImage **********************
+ */
+
+template< class TScalarType, unsigned int NDimensions >
+void
+DeformationVectorFieldTransform< TScalarType, NDimensions >
+::CopyCoefficientVectorImage( const CoefficientVectorImageType * vecImage,
+  const RegionType & region )
+{
+  /** Typedef's for iterators. */
+  typedef ImageRegionConstIterator< CoefficientVectorImageType > VectorIteratorType;
+  typedef ImageRegionIterator< CoefficientImageType >            IteratorType;
 
   /** Setup the iterators. */
-  VectorIteratorType vecit( vecImage, vecImage->GetLargestPossibleRegion() );
+  VectorIteratorType vecit( vecImage, region );
   vecit.GoToBegin();
   IteratorType it[ SpaceDimension ];
   for( unsigned int i = 0; i < SpaceDimension; i++ )
   {
-    it[ i ] = IteratorType( this->m_Images[ i ],
-      this->m_Images[ i ]->GetLargestPossibleRegion() );
+    it[ i ] = IteratorType( this->m_Images[ i ], region );
     it[ i ].GoToBegin();
   }
 
@@ -112,10 +170,7 @@ DeformationVectorFieldTransform< TScalarType, NDimensions >
     ++vecit;
   }
 
-  /** Put it in the Superclass. */
-  this->SetCoefficientImages( this->m_Images );
-
-} // end SetCoefficientVectorImage()
+} // end CopyCoefficientVectorImage()
 
 
 /**
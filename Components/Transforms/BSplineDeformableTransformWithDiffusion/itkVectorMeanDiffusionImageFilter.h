@@ -23,6 +23,7 @@
 #include "itkImage.h"
 #include "itkVector.h"
 #include "itkNumericTraits.h"
+#include "itkMultiThreader.h"
 
 #include "itkRescaleIntensityImageFilter.h"
 
@@ -37,6 +38,10 @@ namespace itk
  *
  * A mean filter is one of the family of linear filters.
  *
+ * The diffusion iterations are multi-threaded. The iterations alternate
+ * between the output and a temporary image, which is kept between updates,
+ * such that no images are copied or reallocated per iteration.
+ *
  * \sa Image
  * \sa Neighborhood
  * \sa NeighborhoodOperator
@@ -80,6 +85,7 @@ public:
   typedef typename InputImageType::RegionType InputImageRegionType;
   typedef typename InputImageType::SizeType   InputSizeType;
   typedef typename InputImageType::IndexType  IndexType;
+  typedef typename InputImageType::Pointer    InputImagePointer;
   typedef Vector< double,
     itkGetStaticConstMacro( InputImageDimension ) > VectorRealType;
   typedef Image< double,
@@ -140,6 +146,16 @@ protected:
    */
   void GenerateData( void );
 
+  /** Typedefs for multi-threading. */
+  typedef itk::MultiThreader             ThreaderType;
+  typedef ThreaderType::ThreadInfoStruct ThreaderInfoType;
+
+  /** Diffusion threader callback function. */
+  static ITK_THREAD_RETURN_TYPE DiffusionThreaderCallback( void * arg );
+
+  /** Do one diffusion iteration in a part of the image. */
+  void ThreadedDiffuse( const InputImageRegionType & region ) const;
+
 private:
 
   VectorMeanDiffusionImageFilter( const Self & );  // purposely not implemented
@@ -152,6 +168,13 @@ private:
   /** Declare member images. */
   GrayValueImagePointer m_GrayValueImage;
   DoubleImagePointer    m_Cx;
+  InputImagePointer     m_TemporaryImage;
+
+  /** The input and output of the current iteration. */
+  const InputImageType * m_IterationInput;
+  InputImageType *       m_IterationOutput;
+
+  ThreaderType::Pointer m_Threader;
 
   RescaleImageFilterPointer m_RescaleFilter;
 
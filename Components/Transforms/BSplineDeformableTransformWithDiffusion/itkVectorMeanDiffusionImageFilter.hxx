@@ -26,6 +26,7 @@
 #include "itkImageRegionConstIterator.h"
 #include "itkZeroFluxNeumannBoundaryCondition.h"
 #include "itkProgressReporter.h"
+#include "vnl/vnl_math.h"
 
 namespace itk
 {
@@ -41,9 +42,17 @@ VectorMeanDiffusionImageFilter< TInputImage, TGrayValueImage >
   /** Initialize things for the filter. */
   this->m_NumberOfIterations = 0;
   this->m_Radius.Fill( 1 );
-  this->m_RescaleFilter  = 0;
-  this->m_GrayValueImage = 0;
-  this->m_Cx             = 0;
+  this->m_RescaleFilter   = 0;
+  this->m_GrayValueImage  = 0;
+  this->m_Cx              = 0;
+  this->m_TemporaryImage  = 0;
+  this->m_IterationInput  = 0;
+  this->m_IterationOutput = 0;
+
+  this->m_Threader = ThreaderType::New();
+#if ITK_VERSION_MAJOR < 5
+  this->m_Threader->SetUseThreadPool( false );
+#endif
 
 } // end Constructor
 
@@ -115,31 +124,14 @@ void
 VectorMeanDiffusionImageFilter< TInputImage, TGrayValueImage >
 ::GenerateData( void )
 {
-  // \todo to avoid all the copying we can create a vector of
-  // outputs of size this->GetNumberOfIterations(). The last
-  // output should point to this->GetOutput(). In order to avoid
-  // a big memory footprint, at some iteration k, memory of the
-  // former iteration should be released: output[ k - 1 ] = 0,
-  // and memory of the current iteration should only now be created:
-  // output[ k ] = InputImageType::New(); ...; output[ k ]->Allocate().
-  // Only for the last iteration: output[ k ]( this->GetOutput() ).
-
   /** Create feature image. */
   this->FilterGrayValueImage();
 
-  /** Declare things. */
-  unsigned int                                        i, j;
-  ZeroFluxNeumannBoundaryCondition< InputImageType >  nbc;
-  ZeroFluxNeumannBoundaryCondition< DoubleImageType > nbc2;
-  NeighborhoodIterator< InputImageType >              nit;
-  NeighborhoodIterator< DoubleImageType >             nit2;
-  VectorRealType                                      sum;
-
   /** Allocate output. */
   typename InputImageType::ConstPointer input( this->GetInput() );
   typename InputImageType::Pointer      output( this->GetOutput() );
-  typename InputImageType::Pointer outputtmp = InputImageType::New();
-  output->SetRegions( input->GetLargestPossibleRegion() );
+  const InputImageRegionType            region = input->GetLargestPossibleRegion();
+  output->SetRegions( region );
 
   try
   {
@@ -155,151 +147,203 @@ VectorMeanDiffusionImageFilter< TInputImage, TGrayValueImage >
     throw excp;
   }
 
-  /** Allocate a temporary output image. */
-  outputtmp->SetSpacing( input->GetSpacing() );
-  outputtmp->SetOrigin( input->GetOrigin() );
-  outputtmp->SetRegions( input->GetLargestPossibleRegion() );
+  /** Without iterations, just copy input to output. */
+  const unsigned int numberOfIterations = this->GetNumberOfIterations();
+  if( numberOfIterations == 0 )
+  {
+    ImageRegionConstIterator< InputImageType > in_it( input, region );
+    ImageRegionIterator< InputImageType >      out_it( output, region );
+    while( !in_it.IsAtEnd() )
+    {
+      out_it.Set( in_it.Get() );
+      ++in_it;
+      ++out_it;
+    }
+    return;
+  }
 
-  try
+  /** Allocate a temporary output image, only if the region changed. */
+  if( numberOfIterations > 1
+    && ( this->m_TemporaryImage.IsNull()
+    || this->m_TemporaryImage->GetBufferedRegion() != region ) )
   {
-    outputtmp->Allocate();
+    this->m_TemporaryImage = InputImageType::New();
+    this->m_TemporaryImage->SetSpacing( input->GetSpacing() );
+    this->m_TemporaryImage->SetOrigin( input->GetOrigin() );
+    this->m_TemporaryImage->SetRegions( region );
+
+    try
+    {
+      this->m_TemporaryImage->Allocate();
+    }
+    catch( itk::ExceptionObject & excp )
+    {
+      /** Add information to the exception and throw again. */
+      excp.SetLocation( "VectorMeanDiffusionImageFilter - GenerateData()" );
+      std::string err_str = excp.GetDescription();
+      err_str += "\nError occurred while allocating a temporary copy.\n";
+      excp.SetDescription( err_str );
+      throw excp;
+    }
   }
-  catch( itk::ExceptionObject & excp )
+
+  /** Setup the threader. */
+#if ITK_VERSION_MAJOR >= 5
+  this->m_Threader->SetNumberOfThreads( this->GetNumberOfWorkUnits() );
+#else
+  this->m_Threader->SetNumberOfThreads( this->GetNumberOfThreads() );
+#endif
+  this->m_Threader->SetSingleMethod( this->DiffusionThreaderCallback, this );
+
+  /** The first iteration reads the input. The iterations then alternate
+   * between the output and the temporary image, starting such that the
+   * last iteration writes to the output.
+   */
+  this->m_IterationInput  = input;
+  this->m_IterationOutput = ( numberOfIterations % 2 == 1 )
+    ? output.GetPointer() : this->m_TemporaryImage.GetPointer();
+  for( unsigned int k = 0; k < numberOfIterations; k++ )
   {
-    /** Add information to the exception and throw again. */
-    excp.SetLocation( "VectorMeanDiffusionImageFilter - GenerateData()" );
-    std::string err_str = excp.GetDescription();
-    err_str += "\nError occurred while allocating a temporary copy.\n";
-    excp.SetDescription( err_str );
-    throw excp;
+    this->m_Threader->SingleMethodExecute();
+
+    this->m_IterationInput  = this->m_IterationOutput;
+    this->m_IterationOutput = ( this->m_IterationOutput == output.GetPointer() )
+      ? this->m_TemporaryImage.GetPointer() : output.GetPointer();
   }
+  this->m_IterationInput  = 0;
+  this->m_IterationOutput = 0;
+
+} // end GenerateData()
+
 
-  // support progress methods/callbacks
-  //ProgressReporter progress( this, threadId, outputRegionForThread.GetNumberOfPixels() );
-
-  /** Copy input to output. */
-  ImageRegionConstIterator< InputImageType > in_it(
-  input, input->GetLargestPossibleRegion() );
-  ImageRegionIterator< InputImageType > out_it(
-  output, input->GetLargestPossibleRegion() );
-  in_it.GoToBegin();
-  out_it.GoToBegin();
-  while( !in_it.IsAtEnd() )
+/**
+ * ***************** DiffusionThreaderCallback ******************
+ */
+
+template< class TInputImage, class TGrayValueImage >
+ITK_THREAD_RETURN_TYPE
+VectorMeanDiffusionImageFilter< TInputImage, TGrayValueImage >
+::DiffusionThreaderCallback( void * arg )
+{
+  /** Get the current thread id and user data. */
+  ThreaderInfoType * infoStruct = static_cast< ThreaderInfoType * >( arg );
+  ThreadIdType       threadID   = infoStruct->ThreadID;
+  const Self *       self       = static_cast< const Self * >( infoStruct->UserData );
+
+  /** Distribute the slices in the last dimension evenly over the threads. */
+  const unsigned int    last            = InputImageDimension - 1;
+  InputImageRegionType  region          = self->m_IterationOutput->GetBufferedRegion();
+  const SizeValueType   numberOfThreads = self->m_Threader->GetNumberOfThreads();
+  const SizeValueType   numberOfSlices  = region.GetSize( last );
+  const SizeValueType   slicesPerThread
+    = ( numberOfSlices + numberOfThreads - 1 ) / numberOfThreads;
+  const SizeValueType begin = vnl_math_min( threadID * slicesPerThread, numberOfSlices );
+  const SizeValueType end   = vnl_math_min( begin + slicesPerThread, numberOfSlices );
+
+  if( begin < end )
   {
-    out_it.Set( in_it.Get() );
-    ++in_it;
-    ++out_it;
+    region.SetIndex( last, region.GetIndex( last ) + static_cast< OffsetValueType >( begin ) );
+    region.SetSize( last, end - begin );
+    self->ThreadedDiffuse( region );
   }
 
-  /** Setup neighborhood iterator for the output deformation image. */
-  nit = NeighborhoodIterator< InputImageType >(
-    this->m_Radius, output, output->GetLargestPossibleRegion() );
-  unsigned int neighborhoodSize = nit.Size();
+  return ITK_THREAD_RETURN_VALUE;
+
+} // end DiffusionThreaderCallback()
+
+
+/**
+ * ********************** ThreadedDiffuse ***********************
+ */
+
+template< class TInputImage, class TGrayValueImage >
+void
+VectorMeanDiffusionImageFilter< TInputImage, TGrayValueImage >
+::ThreadedDiffuse( const InputImageRegionType & region ) const
+{
+  /** Declare things. */
+  unsigned int                                        i, j;
+  ZeroFluxNeumannBoundaryCondition< InputImageType >  nbc;
+  ZeroFluxNeumannBoundaryCondition< DoubleImageType > nbc2;
+  VectorRealType                                      sum;
+
+  /** Setup neighborhood iterator for the input deformation image. */
+  ConstNeighborhoodIterator< InputImageType > nit(
+    this->m_Radius, this->m_IterationInput, region );
+  const unsigned int neighborhoodSize = nit.Size();
   nit.OverrideBoundaryCondition( &nbc );
 
   /** Setup neighborhood iterator for the "stiffness coefficient" image. */
-  nit2 = NeighborhoodIterator< DoubleImageType >(
-    this->m_Radius, this->m_Cx, this->m_Cx->GetLargestPossibleRegion() );
+  ConstNeighborhoodIterator< DoubleImageType > nit2(
+    this->m_Radius, this->m_Cx, region );
   nit2.OverrideBoundaryCondition( &nbc2 );
 
-  /** Setup iterator over outputtmp. */
-  ImageRegionIterator< InputImageType > oit(
-  outputtmp, input->GetLargestPossibleRegion() );
-
-  /** Initialize c and ci. */
-  double c  = 0.0;
-  double ci = 0.0;
+  /** Setup iterator over the output of this iteration. */
+  ImageRegionIterator< InputImageType > oit( this->m_IterationOutput, region );
 
-  /** Loop over the number of iterations. */
-  for( unsigned int k = 0; k < this->GetNumberOfIterations(); k++ )
+  /** The actual work. */
+  while( !nit.IsAtEnd() )
   {
-    /** Reset the iterators. */
-    nit.GoToBegin();
-    nit2.GoToBegin();
-    oit.GoToBegin();
+    /** Get c. */
+    const double c = nit2.GetCenterPixel();
 
-    /** The actual work. */
-    while( !nit.IsAtEnd() )
+    /** Speed up: do not filter locations where c(x) = 0. */
+    if( c < 0.000001 )
     {
-      /** Speed up: do not filter locations where c(x) = 0. */
-      if( nit2.GetCenterPixel() < 0.000001 )
+      /** Just copy input to output. */
+      oit.Set( nit.GetCenterPixel() );
+    }
+    else
+    {
+      /** Initialize the sum to 0. */
+      for( j = 0; j < InputImageDimension; j++ )
       {
-        /** Just copy input to output. */
-        oit.Set( nit.GetCenterPixel() );
+        sum[ j ] = NumericTraits< double >::Zero;
       }
-      else
-      {
-        /** Initialize the sum to 0. */
-        for( j = 0; j < InputImageDimension; j++ )
-        {
-          sum[ j ] = NumericTraits< double >::Zero;
-        }
 
-        /** Initialize sumc. */
-        double sumc = 0.0;
+      /** Initialize sumc. */
+      double sumc = 0.0;
 
-        /** Calculate the weighted mean over the neighborhood.
-         * mean = SUthis->m_i{ ci * x_i } / SUthis->m_i{ ci }
-         */
-        for( i = 0; i < neighborhoodSize; ++i )
-        {
-          /** Get current pixel in this neighborhood. */
-          InputPixelType pix = nit.GetPixel( i );
-
-          /** Get ci-value on current index. */
-          ci = nit2.GetPixel( i );
-
-          /** Calculate SUthis->m_i{ ci } and SUthis->m_i{ ci * x_i }. */
-          sumc += ci;
-          for( j = 0; j < InputImageDimension; j++ )
-          {
-            sum[ j ] += ci * static_cast< double >( pix[ j ] );
-          }
-        }
+      /** Calculate the weighted mean over the neighborhood.
+       * mean = SUM_i{ ci * x_i } / SUM_i{ ci }
+       */
+      for( i = 0; i < neighborhoodSize; ++i )
+      {
+        /** Get current pixel in this neighborhood. */
+        const InputPixelType pix = nit.GetPixel( i );
+
+        /** Get ci-value on current index. */
+        const double ci = nit2.GetPixel( i );
 
-        /** Get the mean value by dividing by sumc. */
-        InputPixelType mean;
+        /** Calculate SUM_i{ ci } and SUM_i{ ci * x_i }. */
+        sumc += ci;
         for( j = 0; j < InputImageDimension; j++ )
         {
-          if( sumc < 0.00001 ) { mean[ j ] = 0.0; }
-          else { mean[ j ] = static_cast< ValueType >( sum[ j ] / sumc ); }
+          sum[ j ] += ci * static_cast< double >( pix[ j ] );
         }
+      }
 
-        /** Get c. */
-        c = nit2.GetCenterPixel();
-
-        /** Set 'y = (1 - c) * x + c * mean' to the temporary output. */
-        InputPixelType value = nit.GetCenterPixel() * ( 1.0 - c ) + mean * c;
-
-        /** Set it. */
-        oit.Set( value );
-
-      } // end if c < 0.000001
+      /** Get the mean value by dividing by sumc. */
+      InputPixelType mean;
+      for( j = 0; j < InputImageDimension; j++ )
+      {
+        if( sumc < 0.00001 ) { mean[ j ] = 0.0; }
+        else { mean[ j ] = static_cast< ValueType >( sum[ j ] / sumc ); }
+      }
 
-      /** Increase all iterators. */
-      ++nit;
-      ++nit2;
-      ++oit;
-      //progress.CompletedPixel();
+      /** Set 'y = (1 - c) * x + c * mean' to the output. */
+      oit.Set( nit.GetCenterPixel() * ( 1.0 - c ) + mean * c );
 
-    } // end while
+    } // end if c < 0.000001
 
-    /** Copy outputtmp to output. */
-    if( this->GetNumberOfIterations() > 0 )
-    {
-      out_it.GoToBegin();
-      oit.GoToBegin();
-      while( !out_it.IsAtEnd() )
-      {
-        out_it.Set( oit.Get() );
-        ++out_it;
-        ++oit;
-      }
-    } // end if GetNumberOfIterations() > 0
+    /** Increase all iterators. */
+    ++nit;
+    ++nit2;
+    ++oit;
 
-  } // end for NumberOfIterations
+  } // end while
 
-} // end GenerateData()
+} // end ThreadedDiffuse()
 
 
 /**
@@ -353,16 +397,17 @@ VectorMeanDiffusionImageFilter< TInputImage, TGrayValueImage >
    * a double image. No thresholding is performed.
    */
 
-  /** Create this->m_Cx. */
-  this->m_Cx = DoubleImageType::New();
-
   /** Rescale intensity of this->m_GrayValueImage to values between
-   * 0.0 and 1.0.
+   * 0.0 and 1.0. The rescale filter is reused for every update.
    */
-  this->m_RescaleFilter = RescaleImageFilterType::New();
-  this->m_RescaleFilter->SetOutputMinimum( 0.000001 );
-  this->m_RescaleFilter->SetOutputMaximum( 0.999999 );
+  if( this->m_RescaleFilter.IsNull() )
+  {
+    this->m_RescaleFilter = RescaleImageFilterType::New();
+    this->m_RescaleFilter->SetOutputMinimum( 0.000001 );
+    this->m_RescaleFilter->SetOutputMaximum( 0.999999 );
+  }
   this->m_RescaleFilter->SetInput( this->m_GrayValueImage );
+  this->m_RescaleFilter->Modified();
 
   /** First set this->m_Cx = rescaleFilter->GetOutput(). */
   this->m_Cx = this->m_RescaleFilter->GetOutput();
@@ -116,6 +116,12 @@ public:
   virtual void WritePyramidImage( const std::string & filename,
     const unsigned int & level ); // const;
 
+  /** Whether the output of this pyramid only depends on its input and
+   * schedule, so that it can be reused by a next registration of the same
+   * fixed image, see ElastixBase::GetUseDataCache().
+   */
+  virtual bool GetPyramidCanBeCached( void ) const { return true; }
+
 protected:
 
   /** The constructor. */
@@ -180,8 +180,12 @@ FixedImagePyramidBase< TElastix >
   typedef itk::ImageFileCastWriter< OutputImageType > WriterType;
   typename WriterType::Pointer writer = WriterType::New();
 
-  /** Setup the pipeline. */
-  writer->SetInput( this->GetAsITKBaseType()->GetOutput( level ) );
+  /** Setup the pipeline. The registration may use a pyramid with the output
+   * images of a previous registration instead of this one, see
+   * RegistrationBase::UseCachedFixedImagePyramid().
+   */
+  writer->SetInput( this->GetElastix()->GetElxRegistrationBase()->GetAsITKBaseType()
+    ->GetFixedImagePyramid()->GetOutput( level ) );
   writer->SetFileName( filename.c_str() );
   writer->SetOutputComponentType( resultImagePixelType.c_str() );
   writer->SetUseCompression( doCompression );
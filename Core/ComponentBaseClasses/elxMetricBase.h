@@ -213,6 +213,13 @@ protected:
 
   /** \todo the method GetExactDerivative could as well be added here. */
 
+  /** Read the parameter UseSampledEvaluation, for metrics that can be
+   * evaluated both with and without an image sampler. The metric should
+   * pass it on to UseImageSampler before the registration connects the
+   * image sampler, so in BeforeAll(). Default: false.
+   */
+  virtual bool ReadUseSampledEvaluation( void ) const;
+
   bool                             m_ShowExactMetricValue;
   ExactMetricImageSamplerPointer   m_ExactMetricSampler;
   MeasureType                      m_CurrentExactMetricValue;
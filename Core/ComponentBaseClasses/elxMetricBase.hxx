@@ -391,6 +391,23 @@ typename MetricBase< TElastix >::ImageSamplerBaseType
 
 } // end GetAdvancedMetricImageSampler()
 
+
+/**
+ * ******************* ReadUseSampledEvaluation ********************
+ */
+
+template< class TElastix >
+bool
+MetricBase< TElastix >
+::ReadUseSampledEvaluation( void ) const
+{
+  bool useSampledEvaluation = false;
+  this->m_Configuration->ReadParameter( useSampledEvaluation,
+    "UseSampledEvaluation", this->GetComponentLabel(), 0, -1 );
+  return useSampledEvaluation;
+
+} // end ReadUseSampledEvaluation()
+
 } // end namespace elastix
 
 #endif // end #ifndef __elxMetricBase_hxx
@@ -25,6 +25,8 @@
 #include "elxBaseComponentSE.h"
 #include "itkOptimizer.h"
 
+#include <deque>
+
 namespace elastix
 {
 
@@ -44,6 +46,25 @@ namespace elastix
  *    Choose one from {"true", "false"} for every resolution.\n
  *    example: <tt>(NewSamplesEveryIteration "true" "true" "true")</tt> \n
  *    Default is "false" for every resolution.\n
+ * \parameter UseConvergenceMonitor: if this flag is set to "true", optimizers that support
+ *    it stop a resolution as soon as convergence is detected, instead of always performing
+ *    MaximumNumberOfIterations iterations. Convergence is detected on exponentially smoothed
+ *    metric values and gradient magnitudes, because the values of a stochastic optimizer
+ *    are too noisy to compare directly. The smoothed metric value is written to the
+ *    IterationInfo, and the last row of the IterationInfo is the iteration at which
+ *    convergence was detected.\n
+ *    example: <tt>(UseConvergenceMonitor "true")</tt> \n
+ *    Default is "false" for every resolution.\n
+ * \parameter ConvergenceMonitorWindow: the number of iterations over which the smoothed
+ *    values are compared. The smoothing factor is 2 / (window + 1), and convergence is
+ *    only checked after two windows.\n
+ *    example: <tt>(ConvergenceMonitorWindow 50)</tt> \n
+ *    Default is 50 for every resolution.\n
+ * \parameter ConvergenceMonitorTolerance: convergence is detected when, over the last
+ *    window, the smoothed metric value improved by less than this fraction, and the
+ *    smoothed gradient magnitude decreased by less than this fraction.\n
+ *    example: <tt>(ConvergenceMonitorTolerance 0.001)</tt> \n
+ *    Default is 0.001 for every resolution.\n
  *
  * \ingroup Optimizers
  * \ingroup ComponentBaseClasses
@@ -94,9 +115,21 @@ public:
 
   /** Execute stuff before each new pyramid resolution:
    * \li Find out if new samples are used every new iteration in this resolution.
+   * \li Read the settings of the convergence monitor.
    */
   virtual void BeforeEachResolutionBase() ITK_OVERRIDE;
 
+  /** Check whether the convergence monitor detected convergence
+   * in the current iteration.
+   */
+  virtual bool GetConvergenceDetected( void ) const;
+
+  /** Stop the current resolution, because convergence was detected.
+   * Called by elastix after the iteration info of the iteration is written.
+   * Optimizers that call CheckForConvergence should override this function.
+   */
+  virtual void StopOptimizationAtConvergence( void ) {}
+
   /** Execute stuff after registration:
    * \li Compute and print MD5 hash of the transform parameters.
    */
@@ -123,6 +156,16 @@ protected:
   /** Check whether the user asked to select new samples every iteration. */
   virtual bool GetNewSamplesEveryIteration( void ) const;
 
+  /** Check whether the user asked to stop when convergence is detected. */
+  virtual bool GetUseConvergenceMonitor( void ) const;
+
+  /** Update the convergence monitor with the metric value and gradient
+   * magnitude of the current iteration. Returns true when convergence is
+   * detected. To be called in AfterEachIteration by optimizers that
+   * implement StopOptimizationAtConvergence.
+   */
+  virtual bool CheckForConvergence( const double value, const double gradientMagnitude );
+
 private:
 
   /** The private constructor. */
@@ -135,6 +178,17 @@ private:
    */
   bool m_NewSamplesEveryIteration;
 
+  /** Settings and state of the convergence monitor. */
+  bool                 m_UseConvergenceMonitor;
+  unsigned long        m_ConvergenceMonitorWindow;
+  double               m_ConvergenceMonitorTolerance;
+  unsigned long        m_ConvergenceMonitorIteration;
+  bool                 m_ConvergenceDetected;
+  double               m_SmoothedValue;
+  double               m_SmoothedGradientMagnitude;
+  std::deque< double > m_SmoothedValueHistory;
+  std::deque< double > m_SmoothedGradientMagnitudeHistory;
+
 };
 
 } // end namespace elastix
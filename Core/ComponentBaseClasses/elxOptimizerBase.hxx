@@ -21,7 +21,9 @@
 #include "elxOptimizerBase.h"
 
 #include "itkSingleValuedNonLinearOptimizer.h"
+#include "itkScaledSingleValuedNonLinearOptimizer.h"
 #include "itk_zlib.h"
+#include "vnl/vnl_math.h"
 
 namespace elastix
 {
@@ -36,6 +38,14 @@ OptimizerBase< TElastix >
 {
   this->m_NewSamplesEveryIteration = false;
 
+  this->m_UseConvergenceMonitor       = false;
+  this->m_ConvergenceMonitorWindow    = 50;
+  this->m_ConvergenceMonitorTolerance = 1e-3;
+  this->m_ConvergenceMonitorIteration = 0;
+  this->m_ConvergenceDetected         = false;
+  this->m_SmoothedValue               = 0.0;
+  this->m_SmoothedGradientMagnitude   = 0.0;
+
 } // end Constructor
 
 
@@ -79,6 +89,37 @@ OptimizerBase< TElastix >
   this->GetConfiguration()->ReadParameter( this->m_NewSamplesEveryIteration,
     "NewSamplesEveryIteration", this->GetComponentLabel(), level, 0 );
 
+  /** Check if the resolution should stop when convergence is detected. */
+  this->m_UseConvergenceMonitor = false;
+  this->GetConfiguration()->ReadParameter( this->m_UseConvergenceMonitor,
+    "UseConvergenceMonitor", this->GetComponentLabel(), level, 0 );
+  this->m_ConvergenceMonitorWindow = 50;
+  this->GetConfiguration()->ReadParameter( this->m_ConvergenceMonitorWindow,
+    "ConvergenceMonitorWindow", this->GetComponentLabel(), level, 0 );
+  this->m_ConvergenceMonitorWindow = vnl_math_max( this->m_ConvergenceMonitorWindow, 1UL );
+  this->m_ConvergenceMonitorTolerance = 1e-3;
+  this->GetConfiguration()->ReadParameter( this->m_ConvergenceMonitorTolerance,
+    "ConvergenceMonitorTolerance", this->GetComponentLabel(), level, 0 );
+
+  /** Reset the state of the monitor. */
+  this->m_ConvergenceMonitorIteration = 0;
+  this->m_ConvergenceDetected         = false;
+  this->m_SmoothedValue               = 0.0;
+  this->m_SmoothedGradientMagnitude   = 0.0;
+  this->m_SmoothedValueHistory.clear();
+  this->m_SmoothedGradientMagnitudeHistory.clear();
+
+  /** Add the smoothed metric value to the iteration info. */
+  if( this->m_UseConvergenceMonitor )
+  {
+    xl::xout[ "iteration" ].AddTargetCell( "2a:SmoothedMetric" );
+    xl::xout[ "iteration" ][ "2a:SmoothedMetric" ] << std::showpoint << std::fixed;
+  }
+  else
+  {
+    xl::xout[ "iteration" ].RemoveTargetCell( "2a:SmoothedMetric" );
+  }
+
 } // end BeforeEachResolutionBase()
 
 
@@ -151,6 +192,110 @@ OptimizerBase< TElastix >
 } // end GetNewSamplesEveryIteration()
 
 
+/**
+ * ****************** GetUseConvergenceMonitor ********************
+ */
+
+template< class TElastix >
+bool
+OptimizerBase< TElastix >
+::GetUseConvergenceMonitor( void ) const
+{
+  return this->m_UseConvergenceMonitor;
+
+} // end GetUseConvergenceMonitor()
+
+
+/**
+ * ****************** CheckForConvergence ********************
+ */
+
+template< class TElastix >
+bool
+OptimizerBase< TElastix >
+::CheckForConvergence( const double value, const double gradientMagnitude )
+{
+  if( !this->m_UseConvergenceMonitor )
+  {
+    return false;
+  }
+
+  /** Work with a value that decreases when the optimizer makes progress. */
+  const itk::ScaledSingleValuedNonLinearOptimizer * scaledOptimizer
+    = dynamic_cast< const itk::ScaledSingleValuedNonLinearOptimizer * >(
+    this->GetAsITKBaseType() );
+  const double sign = ( scaledOptimizer && scaledOptimizer->GetMaximize() ) ? -1.0 : 1.0;
+
+  /** Exponential smoothing, starting at the first value. */
+  const unsigned long window = this->m_ConvergenceMonitorWindow;
+  const double        beta   = 2.0 / ( window + 1.0 );
+  if( this->m_ConvergenceMonitorIteration == 0 )
+  {
+    this->m_SmoothedValue             = sign * value;
+    this->m_SmoothedGradientMagnitude = gradientMagnitude;
+  }
+  else
+  {
+    this->m_SmoothedValue += beta * ( sign * value - this->m_SmoothedValue );
+    this->m_SmoothedGradientMagnitude
+      += beta * ( gradientMagnitude - this->m_SmoothedGradientMagnitude );
+  }
+  ++this->m_ConvergenceMonitorIteration;
+
+  xl::xout[ "iteration" ][ "2a:SmoothedMetric" ] << sign * this->m_SmoothedValue;
+
+  /** Keep the smoothed values of the last window. */
+  this->m_SmoothedValueHistory.push_back( this->m_SmoothedValue );
+  this->m_SmoothedGradientMagnitudeHistory.push_back( this->m_SmoothedGradientMagnitude );
+  if( this->m_SmoothedValueHistory.size() > window + 1 )
+  {
+    this->m_SmoothedValueHistory.pop_front();
+    this->m_SmoothedGradientMagnitudeHistory.pop_front();
+  }
+
+  /** Let the smoothing settle before checking. */
+  if( this->m_ConvergenceMonitorIteration < 2 * window )
+  {
+    return false;
+  }
+
+  /** Compare with the smoothed values of one window ago. */
+  const double previousValue    = this->m_SmoothedValueHistory.front();
+  const double previousGradient = this->m_SmoothedGradientMagnitudeHistory.front();
+  const double valueImprovement = ( previousValue - this->m_SmoothedValue )
+    / ( vnl_math_abs( previousValue ) + 1e-14 );
+  const double gradientDecrease = ( previousGradient - this->m_SmoothedGradientMagnitude )
+    / ( previousGradient + 1e-14 );
+
+  this->m_ConvergenceDetected = valueImprovement < this->m_ConvergenceMonitorTolerance
+    && gradientDecrease < this->m_ConvergenceMonitorTolerance;
+  if( this->m_ConvergenceDetected )
+  {
+    elxout << "Convergence detected at iteration "
+           << this->m_ConvergenceMonitorIteration - 1
+           << ": the smoothed metric value improved by "
+           << valueImprovement << " in the last " << window << " iterations."
+           << std::endl;
+  }
+  return this->m_ConvergenceDetected;
+
+} // end CheckForConvergence()
+
+
+/**
+ * ****************** GetConvergenceDetected ********************
+ */
+
+template< class TElastix >
+bool
+OptimizerBase< TElastix >
+::GetConvergenceDetected( void ) const
+{
+  return this->m_ConvergenceDetected;
+
+} // end GetConvergenceDetected()
+
+
 /**
  * ****************** SetSinusScales ********************
  */
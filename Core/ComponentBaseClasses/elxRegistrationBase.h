@@ -23,10 +23,15 @@
 
 #include "elxBaseComponentSE.h"
 #include "itkMultiResolutionImageRegistrationMethod2.h"
+#include "itkMultiResolutionCachedPyramidImageFilter.h"
 
 /** Mask support. */
 #include "itkImageMaskSpatialObject2.h"
 #include "itkErodeMaskImageFilter.h"
+#include <map>
+
+/** Cropping support. */
+#include "itkAdvancedCombinationTransform.h"
 
 namespace elastix
 {
@@ -66,6 +71,33 @@ namespace elastix
  *    from one resolution level to another. Choose from {"true", "false"} \n
  *    example: <tt>(ErodeMovingMask2 "true" "false")</tt>
  *    This setting overrules ErodeMask and ErodeMovingMask.\n
+ * \parameter CropImagesToFixedMask: a flag to determine if the fixed and moving
+ *    image should be cropped to the footprint of the fixed mask, before the
+ *    image pyramids are computed. Choose from {"true", "false"} \n
+ *    example: <tt>(CropImagesToFixedMask "true")</tt> \n
+ *    The default is "false". The fixed image is cropped to the bounding box of
+ *    the fixed mask, and the moving image to the bounding box of its mapping by
+ *    the initial transform (or by the starting complete transform, if that is
+ *    linear). This saves memory and smoothing time when a small mask is used in
+ *    a large image. The result image and the transform grid are not affected.
+ *    After each resolution a warning is printed if points in the bounding box of
+ *    the fixed mask are mapped outside the cropped moving image, since samples
+ *    there are rejected.
+ *    Only supported by the MultiResolutionRegistration, with a single fixed
+ *    and moving image.\n
+ * \parameter CropImagesMargin: the margin in physical units that is added to
+ *    the bounding boxes, for each dimension. \n
+ *    example: <tt>(CropImagesMargin 20.0 20.0 10.0)</tt> \n
+ *    The default is four times the fixed image spacing times the shrink factor
+ *    of the coarsest fixed pyramid level, which covers the smoothing kernel of
+ *    the pyramid. For a B-spline transform, the moving bounding box also gets
+ *    the support of a control point, (BSplineTransformSplineOrder + 1) / 2 times
+ *    the final grid spacing.\n
+ * \parameter CropImagesMaximumDisplacement: the largest displacement in physical
+ *    units that the optimization is expected to add to the starting transform,
+ *    for each dimension. It is added to the margin of the moving bounding box. \n
+ *    example: <tt>(CropImagesMaximumDisplacement 10.0 10.0 5.0)</tt> \n
+ *    The default is 0.0.\n
  *
  * \ingroup Registrations
  * \ingroup ComponentBaseClasses
@@ -147,6 +179,32 @@ public:
     const std::string & whichMask,
     const unsigned int level ) const;
 
+  /** Crop the fixed and moving image of the registration to the footprint
+   * of the fixed mask, if the parameter CropImagesToFixedMask is true.
+   * Should be called before the image pyramids are set up. The cropped
+   * images are only used by the registration; the images in the elastix
+   * object are left untouched.
+   */
+  virtual void CropImagesToFixedMask( void );
+
+  /** Replace the fixed image pyramid of the registration by a pyramid that
+   * outputs the images that a previous registration in this process computed
+   * for the same fixed image and schedule, if the data cache of ElastixBase
+   * is used. Should be called before the image pyramids are set up.
+   */
+  virtual void UseCachedFixedImagePyramid( void );
+
+  /** Store the output images of the fixed image pyramid in the data cache of
+   * ElastixBase, for the next registrations. Should be called after the
+   * image pyramids are set up.
+   */
+  virtual void CacheFixedImagePyramid( void );
+
+  /** Execute stuff after each resolution:
+   * \li Check whether the moving image was cropped too small.
+   */
+  virtual void AfterEachResolutionBase( void );
+
 protected:
 
   /** The constructor. */
@@ -171,12 +229,25 @@ protected:
 
   typedef typename ITKBaseType::FixedImagePyramidType  FixedImagePyramidType;
   typedef typename ITKBaseType::MovingImagePyramidType MovingImagePyramidType;
+  typedef itk::MultiResolutionCachedPyramidImageFilter<
+    FixedImageType, FixedImageType >                  CachedFixedImagePyramidType;
+
+  /** Typedef's for cropping the images. */
+  typedef typename ITKBaseType::TransformType TransformType;
+  typedef itk::AdvancedCombinationTransform<
+    typename TransformType::ScalarType,
+    itkGetStaticConstMacro( FixedImageDimension ) >  CombinationTransformType;
+  typedef typename FixedImageType::PointType         FixedImagePointType;
 
   /** Some typedef's used for eroding the masks */
   typedef itk::ErodeMaskImageFilter< FixedMaskImageType >  FixedMaskErodeFilterType;
   typedef typename FixedMaskErodeFilterType::Pointer       FixedMaskErodeFilterPointer;
   typedef itk::ErodeMaskImageFilter< MovingMaskImageType > MovingMaskErodeFilterType;
   typedef typename MovingMaskErodeFilterType::Pointer      MovingMaskErodeFilterPointer;
+  typedef std::map< const FixedMaskImageType *,
+    FixedMaskErodeFilterPointer >                          FixedMaskErodeFilterMapType;
+  typedef std::map< const MovingMaskImageType *,
+    MovingMaskErodeFilterPointer >                         MovingMaskErodeFilterMapType;
 
   /** Generate a spatial object from a mask image, possibly after eroding the image
    * Input:
@@ -188,7 +259,9 @@ protected:
    * Output:
    * \li the mask as a spatial object, which can be set in a metric for example
    *
-   * This function is used by the registration components
+   * This function is used by the registration components.
+   * The eroded masks of all resolution levels are computed at the first
+   * call for a mask, and reused for the other levels.
    */
   FixedMaskSpatialObjectPointer GenerateFixedMaskSpatialObject(
     const FixedMaskImageType * maskImage, bool useMaskErosion,
@@ -204,12 +277,25 @@ protected:
    * Output:
    * \li the mask as a spatial object, which can be set in a metric for example
    *
-   * This function is used by the registration components
+   * This function is used by the registration components.
+   * The eroded masks of all resolution levels are computed at the first
+   * call for a mask, and reused for the other levels.
    */
   MovingMaskSpatialObjectPointer GenerateMovingMaskSpatialObject(
     const MovingMaskImageType * maskImage, bool useMaskErosion,
     const MovingImagePyramidType * pyramid, unsigned int level ) const;
 
+  /** Get the key of the fixed image pyramid in the data cache of ElastixBase.
+   * Returns an empty string if the pyramid cannot be cached.
+   */
+  std::string GetFixedImagePyramidCacheKey( void ) const;
+
+  /** Print a warning if points in the bounding box of the fixed mask are
+   * mapped outside the moving image cropped by CropImagesToFixedMask(),
+   * but inside the original moving image.
+   */
+  virtual void CheckCroppedMovingImage( void ) const;
+
 private:
 
   /** The private constructor. */
@@ -217,6 +303,15 @@ private:
   /** The private copy constructor. */
   void operator=( const Self & );     // purposely not implemented
 
+  /** The erosion filters, one for each mask, that hold the eroded masks of
+   * all resolution levels.
+   */
+  mutable FixedMaskErodeFilterMapType  m_FixedMaskErodeFilters;
+  mutable MovingMaskErodeFilterMapType m_MovingMaskErodeFilters;
+
+  /** The points in the fixed mask checked by CheckCroppedMovingImage(). */
+  std::vector< FixedImagePointType > m_CropCheckPoints;
+
 };
 
 } // end namespace elastix
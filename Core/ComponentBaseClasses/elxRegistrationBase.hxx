@@ -19,6 +19,9 @@
 #define __elxRegistrationBase_hxx
 
 #include "elxRegistrationBase.h"
+#include "itkRegionOfInterestImageFilter.h"
+#include "itkImageRegionConstIteratorWithIndex.h"
+#include "itkTimeProbe.h"
 
 namespace elastix
 {
@@ -93,6 +96,492 @@ RegistrationBase< TElastix >
 } // end ReadMaskParameters()
 
 
+/**
+ * ******************* CropImagesToFixedMask **********************
+ */
+
+template< class TElastix >
+void
+RegistrationBase< TElastix >
+::CropImagesToFixedMask( void )
+{
+  /** Check if cropping is wanted. */
+  bool cropImages = false;
+  this->GetConfiguration()->ReadParameter( cropImages,
+    "CropImagesToFixedMask", 0, false );
+  if( !cropImages )
+  {
+    return;
+  }
+
+  /** Check if cropping is possible. */
+  this->m_CropCheckPoints.clear();
+  ElastixType * elastix = this->GetElastix();
+  const FixedMaskImageType * fixedMask = elastix->GetFixedMask();
+  if( fixedMask == 0 )
+  {
+    xl::xout[ "warning" ]
+      << "WARNING: CropImagesToFixedMask is set to \"true\", but no fixed mask\n"
+      << "  is given. The images are not cropped." << std::endl;
+    return;
+  }
+  if( elastix->GetNumberOfFixedImages() > 1 || elastix->GetNumberOfMovingImages() > 1 )
+  {
+    xl::xout[ "warning" ]
+      << "WARNING: CropImagesToFixedMask is only supported for a single fixed\n"
+      << "  and moving image. The images are not cropped." << std::endl;
+    return;
+  }
+
+  itk::TimeProbe timer;
+  timer.Start();
+
+  ITKBaseType *           registration = this->GetAsITKBaseType();
+  const FixedImageType *  fixedImage   = registration->GetFixedImage();
+  const MovingImageType * movingImage  = registration->GetMovingImage();
+
+  typedef typename FixedImageType::RegionType              FixedRegionType;
+  typedef typename FixedImageType::IndexType               FixedIndexType;
+  typedef typename FixedImageType::SizeType                FixedSizeType;
+  typedef typename FixedImageType::PointType               FixedPointType;
+  typedef typename MovingImageType::RegionType             MovingRegionType;
+  typedef typename MovingImageType::IndexType              MovingIndexType;
+  typedef typename MovingImageType::SizeType               MovingSizeType;
+  typedef typename MovingImageType::PointType              MovingPointType;
+  typedef typename FixedImagePyramidType::ScheduleType     ScheduleType;
+  typedef typename FixedPointType::CoordRepType            CoordRepType;
+  typedef itk::ContinuousIndex< CoordRepType,
+    FixedImageDimension >                                  FixedCIndexType;
+  typedef itk::ContinuousIndex< CoordRepType,
+    MovingImageDimension >                                 MovingCIndexType;
+
+  /** Read the margin, or compute the default from the coarsest level of
+   * the fixed pyramid.
+   */
+  const ScheduleType fixedSchedule  = registration->GetFixedImagePyramid()->GetSchedule();
+  const ScheduleType movingSchedule = registration->GetMovingImagePyramid()->GetSchedule();
+  std::vector< double > margin( FixedImageDimension, 0.0 );
+  for( unsigned int d = 0; d < FixedImageDimension; ++d )
+  {
+    margin[ d ] = 4.0 * fixedSchedule[ 0 ][ d ] * fixedImage->GetSpacing()[ d ];
+    this->GetConfiguration()->ReadParameter( margin[ d ], "CropImagesMargin", d, false );
+  }
+
+  /** The moving image needs more margin, since the transform changes during
+   * the optimization. Add the expected displacement, and for a B-spline
+   * transform the support of a control point, (SplineOrder + 1) / 2 times
+   * the final grid spacing.
+   */
+  std::string transformName = "";
+  this->GetConfiguration()->ReadParameter( transformName, "Transform", 0, false );
+  const bool isBSpline = transformName.find( "BSpline" ) != std::string::npos;
+  unsigned int splineOrder = 3;
+  this->GetConfiguration()->ReadParameter( splineOrder,
+    "BSplineTransformSplineOrder", "", 0, 0, false );
+  std::vector< double > movingMargin( margin );
+  for( unsigned int d = 0; d < FixedImageDimension; ++d )
+  {
+    double maximumDisplacement = 0.0;
+    this->GetConfiguration()->ReadParameter( maximumDisplacement,
+      "CropImagesMaximumDisplacement", "", d, 0, false );
+    movingMargin[ d ] += maximumDisplacement;
+
+    if( isBSpline )
+    {
+      double finalGridSpacingInVoxels = 16.0;
+      double finalGridSpacing         = 0.0;
+      this->GetConfiguration()->ReadParameter( finalGridSpacingInVoxels,
+        "FinalGridSpacingInVoxels", "", d, 0, false );
+      if( !this->GetConfiguration()->ReadParameter( finalGridSpacing,
+        "FinalGridSpacingInPhysicalUnits", "", d, 0, false ) )
+      {
+        finalGridSpacing = finalGridSpacingInVoxels
+          * elastix->GetFixedImage()->GetSpacing()[ d ];
+      }
+      movingMargin[ d ] += 0.5 * ( splineOrder + 1 ) * finalGridSpacing;
+    }
+  }
+
+  /** Compute the bounding box of the nonzero voxels in the fixed mask. */
+  const FixedRegionType maskRegion = fixedMask->GetLargestPossibleRegion();
+  FixedIndexType        maskMin    = maskRegion.GetUpperIndex();
+  FixedIndexType        maskMax    = maskRegion.GetIndex();
+  bool                  maskIsEmpty = true;
+  itk::ImageRegionConstIteratorWithIndex< FixedMaskImageType > maskIt( fixedMask, maskRegion );
+  for( maskIt.GoToBegin(); !maskIt.IsAtEnd(); ++maskIt )
+  {
+    if( maskIt.Get() == itk::NumericTraits< MaskPixelType >::ZeroValue() )
+    {
+      continue;
+    }
+    const FixedIndexType & index = maskIt.GetIndex();
+    for( unsigned int d = 0; d < FixedImageDimension; ++d )
+    {
+      maskMin[ d ] = std::min( maskMin[ d ], index[ d ] );
+      maskMax[ d ] = std::max( maskMax[ d ], index[ d ] );
+    }
+    maskIsEmpty = false;
+  }
+  if( maskIsEmpty )
+  {
+    xl::xout[ "warning" ]
+      << "WARNING: CropImagesToFixedMask is set to \"true\", but the fixed mask\n"
+      << "  is empty. The images are not cropped." << std::endl;
+    return;
+  }
+
+  /** Store a lattice of points in the bounding box of the mask, to check
+   * after each resolution whether they are mapped inside the cropped moving
+   * image.
+   */
+  const unsigned int pointsPerDimension = 5;
+  unsigned int       numberOfPoints     = 1;
+  for( unsigned int d = 0; d < FixedImageDimension; ++d )
+  {
+    numberOfPoints *= pointsPerDimension;
+  }
+  std::vector< FixedPointType > checkPoints( numberOfPoints );
+  for( unsigned int p = 0; p < numberOfPoints; ++p )
+  {
+    FixedCIndexType latticeIndex;
+    unsigned int    rest = p;
+    for( unsigned int d = 0; d < FixedImageDimension; ++d )
+    {
+      const double fraction = static_cast< double >( rest % pointsPerDimension )
+        / static_cast< double >( pointsPerDimension - 1 );
+      rest /= pointsPerDimension;
+      latticeIndex[ d ] = maskMin[ d ] + fraction * ( maskMax[ d ] - maskMin[ d ] );
+    }
+    fixedMask->TransformContinuousIndexToPhysicalPoint( latticeIndex, checkPoints[ p ] );
+  }
+
+  /** Map the corners of the mask bounding box to the fixed image grid,
+   * and add the margin.
+   */
+  const unsigned int numberOfCorners = 1u << FixedImageDimension;
+  FixedCIndexType    fixedMin;
+  FixedCIndexType    fixedMax;
+  fixedMin.Fill( itk::NumericTraits< CoordRepType >::max() );
+  fixedMax.Fill( itk::NumericTraits< CoordRepType >::NonpositiveMin() );
+  for( unsigned int c = 0; c < numberOfCorners; ++c )
+  {
+    FixedCIndexType maskCorner;
+    for( unsigned int d = 0; d < FixedImageDimension; ++d )
+    {
+      maskCorner[ d ] = ( ( c >> d ) & 1 ) ? maskMax[ d ] + 0.5 : maskMin[ d ] - 0.5;
+    }
+    FixedPointType  point;
+    FixedCIndexType cindex;
+    fixedMask->TransformContinuousIndexToPhysicalPoint( maskCorner, point );
+    fixedImage->TransformPhysicalPointToContinuousIndex( point, cindex );
+    for( unsigned int d = 0; d < FixedImageDimension; ++d )
+    {
+      fixedMin[ d ] = std::min( fixedMin[ d ], cindex[ d ] );
+      fixedMax[ d ] = std::max( fixedMax[ d ], cindex[ d ] );
+    }
+  }
+
+  FixedRegionType fixedRegion;
+  for( unsigned int d = 0; d < FixedImageDimension; ++d )
+  {
+    const double marginInVoxels = margin[ d ] / fixedImage->GetSpacing()[ d ];
+    const itk::IndexValueType first = static_cast< itk::IndexValueType >(
+      std::floor( fixedMin[ d ] - marginInVoxels ) );
+    const itk::IndexValueType last = static_cast< itk::IndexValueType >(
+      std::ceil( fixedMax[ d ] + marginInVoxels ) );
+    fixedRegion.SetIndex( d, first );
+    fixedRegion.SetSize( d, static_cast< itk::SizeValueType >( std::max( last - first + 1,
+      static_cast< itk::IndexValueType >( 1 ) ) ) );
+  }
+  if( !fixedRegion.Crop( registration->GetFixedImageRegion() ) )
+  {
+    xl::xout[ "warning" ]
+      << "WARNING: The fixed mask does not overlap with the fixed image region.\n"
+      << "  The images are not cropped." << std::endl;
+    return;
+  }
+
+  /** Select the transform that maps the fixed region. At this point only a
+   * linear transform is guaranteed to be initialized, so otherwise only the
+   * initial transform is used, and the deformation is covered by the margin.
+   */
+  const TransformType *            transform   = registration->GetTransform();
+  const CombinationTransformType * combination =
+    dynamic_cast< const CombinationTransformType * >( transform );
+  if( combination != 0 && !combination->IsLinear() )
+  {
+    transform = combination->GetInitialTransform();
+  }
+
+  /** Map a lattice of points in the cropped fixed region to the moving
+   * image grid. The lattice includes the corners of the region.
+   */
+  MovingCIndexType movingMin;
+  MovingCIndexType movingMax;
+  movingMin.Fill( itk::NumericTraits< CoordRepType >::max() );
+  movingMax.Fill( itk::NumericTraits< CoordRepType >::NonpositiveMin() );
+  for( unsigned int p = 0; p < numberOfPoints; ++p )
+  {
+    FixedCIndexType latticeIndex;
+    unsigned int    rest = p;
+    for( unsigned int d = 0; d < FixedImageDimension; ++d )
+    {
+      const double fraction = static_cast< double >( rest % pointsPerDimension )
+        / static_cast< double >( pointsPerDimension - 1 );
+      rest /= pointsPerDimension;
+      latticeIndex[ d ] = fixedRegion.GetIndex()[ d ] - 0.5
+        + fraction * fixedRegion.GetSize()[ d ];
+    }
+    FixedPointType   fixedPoint;
+    MovingCIndexType cindex;
+    fixedImage->TransformContinuousIndexToPhysicalPoint( latticeIndex, fixedPoint );
+    const MovingPointType movingPoint = transform != 0
+      ? transform->TransformPoint( fixedPoint ) : fixedPoint;
+    movingImage->TransformPhysicalPointToContinuousIndex( movingPoint, cindex );
+    for( unsigned int d = 0; d < MovingImageDimension; ++d )
+    {
+      movingMin[ d ] = std::min( movingMin[ d ], cindex[ d ] );
+      movingMax[ d ] = std::max( movingMax[ d ], cindex[ d ] );
+    }
+  }
+
+  /** Add the moving margin, and the smoothing kernel of the moving pyramid. */
+  MovingRegionType movingRegion;
+  for( unsigned int d = 0; d < MovingImageDimension; ++d )
+  {
+    const double marginInVoxels = movingMargin[ d ] / movingImage->GetSpacing()[ d ]
+      + 2.0 * movingSchedule[ 0 ][ d ] + 1.0;
+    const itk::IndexValueType first = static_cast< itk::IndexValueType >(
+      std::floor( movingMin[ d ] - marginInVoxels ) );
+    const itk::IndexValueType last = static_cast< itk::IndexValueType >(
+      std::ceil( movingMax[ d ] + marginInVoxels ) );
+    movingRegion.SetIndex( d, first );
+    movingRegion.SetSize( d, static_cast< itk::SizeValueType >( std::max( last - first + 1,
+      static_cast< itk::IndexValueType >( 1 ) ) ) );
+  }
+  if( !movingRegion.Crop( movingImage->GetLargestPossibleRegion() ) )
+  {
+    xl::xout[ "warning" ]
+      << "WARNING: The mapped fixed mask does not overlap with the moving image.\n"
+      << "  The images are not cropped." << std::endl;
+    return;
+  }
+
+  /** Crop the images. */
+  typedef itk::RegionOfInterestImageFilter<
+    FixedImageType, FixedImageType >                      FixedCropFilterType;
+  typedef itk::RegionOfInterestImageFilter<
+    MovingImageType, MovingImageType >                    MovingCropFilterType;
+  typename FixedCropFilterType::Pointer  fixedCropper  = FixedCropFilterType::New();
+  typename MovingCropFilterType::Pointer movingCropper = MovingCropFilterType::New();
+  fixedCropper->SetInput( fixedImage );
+  fixedCropper->SetRegionOfInterest( fixedRegion );
+  movingCropper->SetInput( movingImage );
+  movingCropper->SetRegionOfInterest( movingRegion );
+
+  try
+  {
+    fixedCropper->Update();
+    movingCropper->Update();
+  }
+  catch( itk::ExceptionObject & excp )
+  {
+    /** Add information to the exception. */
+    excp.SetLocation( "RegistrationBase - CropImagesToFixedMask()" );
+    std::string err_str = excp.GetDescription();
+    err_str += "\nError while cropping the images to the fixed mask.\n";
+    excp.SetDescription( err_str );
+    /** Pass the exception to an higher level. */
+    throw excp;
+  }
+
+  typename FixedImageType::Pointer  croppedFixedImage  = fixedCropper->GetOutput();
+  typename MovingImageType::Pointer croppedMovingImage = movingCropper->GetOutput();
+  croppedFixedImage->DisconnectPipeline();
+  croppedMovingImage->DisconnectPipeline();
+
+  /** Set the cropped images in the registration. */
+  registration->SetFixedImage( croppedFixedImage );
+  registration->SetMovingImage( croppedMovingImage );
+  registration->SetFixedImageRegion( croppedFixedImage->GetLargestPossibleRegion() );
+  this->m_CropCheckPoints = checkPoints;
+
+  timer.Stop();
+  elxout << "Cropping the images to the fixed mask took: "
+         << static_cast< long >( timer.GetMean() * 1000 ) << " ms.\n"
+         << "  fixed image size: " << croppedFixedImage->GetLargestPossibleRegion().GetSize()
+         << " (was " << fixedImage->GetLargestPossibleRegion().GetSize() << ")\n"
+         << "  moving image size: " << croppedMovingImage->GetLargestPossibleRegion().GetSize()
+         << " (was " << movingImage->GetLargestPossibleRegion().GetSize() << ")"
+         << std::endl;
+
+} // end CropImagesToFixedMask()
+
+
+/**
+ * ******************* AfterEachResolutionBase **********************
+ */
+
+template< class TElastix >
+void
+RegistrationBase< TElastix >
+::AfterEachResolutionBase( void )
+{
+  /** Check if the moving image was cropped too small. */
+  this->CheckCroppedMovingImage();
+
+} // end AfterEachResolutionBase()
+
+
+/**
+ * ******************* CheckCroppedMovingImage **********************
+ */
+
+template< class TElastix >
+void
+RegistrationBase< TElastix >
+::CheckCroppedMovingImage( void ) const
+{
+  if( this->m_CropCheckPoints.empty() )
+  {
+    return;
+  }
+
+  typedef typename MovingImageType::PointType    MovingPointType;
+  typedef typename MovingPointType::CoordRepType CoordRepType;
+  typedef itk::ContinuousIndex< CoordRepType,
+    MovingImageDimension >                     MovingCIndexType;
+
+  /** Samples that are mapped outside the cropped moving image, but inside
+   * the original moving image, are rejected only because of the cropping.
+   */
+  const ITKBaseType *     registration       = this->GetAsITKBaseType();
+  const TransformType *   transform          = registration->GetTransform();
+  const MovingImageType * croppedMovingImage = registration->GetMovingImage();
+  const MovingImageType * movingImage        = this->GetElastix()->GetMovingImage();
+  unsigned int            numberOfOutside    = 0;
+  for( unsigned int p = 0; p < this->m_CropCheckPoints.size(); ++p )
+  {
+    const MovingPointType movingPoint = transform->TransformPoint( this->m_CropCheckPoints[ p ] );
+    MovingCIndexType      cindex;
+    movingImage->TransformPhysicalPointToContinuousIndex( movingPoint, cindex );
+    if( !movingImage->GetLargestPossibleRegion().IsInside( cindex ) )
+    {
+      continue;
+    }
+    croppedMovingImage->TransformPhysicalPointToContinuousIndex( movingPoint, cindex );
+    if( !croppedMovingImage->GetLargestPossibleRegion().IsInside( cindex ) )
+    {
+      ++numberOfOutside;
+    }
+  }
+
+  if( numberOfOutside > 0 )
+  {
+    xl::xout[ "warning" ]
+      << "WARNING: " << numberOfOutside << " of " << this->m_CropCheckPoints.size()
+      << " points in the bounding box of the fixed mask are mapped outside\n"
+      << "  the cropped moving image. Samples there are rejected, which changes\n"
+      << "  the result.\n"
+      << "  Increase CropImagesMargin or CropImagesMaximumDisplacement." << std::endl;
+  }
+
+} // end CheckCroppedMovingImage()
+
+
+/**
+ * ******************* GetFixedImagePyramidCacheKey **********************
+ */
+
+template< class TElastix >
+std::string
+RegistrationBase< TElastix >
+::GetFixedImagePyramidCacheKey( void ) const
+{
+  const ITKBaseType *           registration = this->GetAsITKBaseType();
+  const FixedImagePyramidType * pyramid      = registration->GetFixedImagePyramid();
+  const FixedImageType *        fixedImage   = registration->GetFixedImage();
+
+  /** Only the pyramid of a fixed image that is shared between registrations
+   * is cached, so not the pyramid of a cropped fixed image.
+   */
+  if( !ElastixBase::GetUseDataCache() || pyramid == 0
+    || fixedImage != this->GetElastix()->GetFixedImage()
+    || !this->GetElastix()->GetElxFixedImagePyramidBase()->GetPyramidCanBeCached() )
+  {
+    return "";
+  }
+
+  /** Pyramids of the same type and schedule give the same output. */
+  std::ostringstream key( "" );
+  key << "FixedImagePyramid " << pyramid->GetNameOfClass()
+      << " " << fixedImage << " " << fixedImage->GetMTime()
+      << " " << registration->GetNumberOfLevels()
+      << " " << pyramid->GetSchedule();
+  return key.str();
+
+} // end GetFixedImagePyramidCacheKey()
+
+
+/**
+ * ******************* UseCachedFixedImagePyramid **********************
+ */
+
+template< class TElastix >
+void
+RegistrationBase< TElastix >
+::UseCachedFixedImagePyramid( void )
+{
+  const std::string key = this->GetFixedImagePyramidCacheKey();
+  if( key.empty() )
+  {
+    return;
+  }
+
+  CachedFixedImagePyramidType * cachedPyramid = dynamic_cast< CachedFixedImagePyramidType * >(
+    ElastixBase::GetCachedObject( key ) );
+  if( cachedPyramid )
+  {
+    this->GetAsITKBaseType()->SetFixedImagePyramid( cachedPyramid );
+    elxout << "Using the fixed image pyramid of a previous registration." << std::endl;
+  }
+
+} // end UseCachedFixedImagePyramid()
+
+
+/**
+ * ******************* CacheFixedImagePyramid **********************
+ */
+
+template< class TElastix >
+void
+RegistrationBase< TElastix >
+::CacheFixedImagePyramid( void )
+{
+  /** A pyramid that was taken from the cache is not stored again. */
+  FixedImagePyramidType * pyramid = this->GetAsITKBaseType()->GetFixedImagePyramid();
+  if( dynamic_cast< CachedFixedImagePyramidType * >( pyramid ) )
+  {
+    return;
+  }
+
+  const std::string key = this->GetFixedImagePyramidCacheKey();
+  if( key.empty() )
+  {
+    return;
+  }
+
+  /** Only the output images are stored, not the pyramid component, which
+   * refers to the elastix object and configuration of this registration.
+   */
+  typename CachedFixedImagePyramidType::Pointer cachedPyramid
+    = CachedFixedImagePyramidType::New();
+  cachedPyramid->SetCachedPyramid( pyramid );
+  ElastixBase::SetCachedObject( key, cachedPyramid );
+
+} // end CacheFixedImagePyramid()
+
+
 /**
  * ******************* GenerateFixedMaskSpatialObject **********************
  */
@@ -118,15 +607,48 @@ RegistrationBase< TElastix >
     return fixedMaskSpatialObject;
   }
 
-  /** Erode, and convert to spatial object. */
-  FixedMaskErodeFilterPointer erosion = FixedMaskErodeFilterType::New();
-  erosion->SetInput( maskImage );
-  erosion->SetSchedule( pyramid->GetSchedule() );
-  erosion->SetIsMovingMask( false );
-  erosion->SetResolutionLevel( level );
+  /** Erode, and convert to spatial object. The erosion filter of this mask
+   * computes all levels at once, and is only executed again when the
+   * schedule changes.
+   */
+  FixedMaskErodeFilterPointer & erosion = this->m_FixedMaskErodeFilters[ maskImage ];
+  if( erosion.IsNull() )
+  {
+    /** The erosion of a fixed mask that is shared between registrations
+     * is taken from the data cache, if it is used.
+     */
+    std::ostringstream key( "" );
+    bool               maskIsShared = false;
+    for( unsigned int i = 0; i < this->GetElastix()->GetNumberOfFixedMasks(); ++i )
+    {
+      maskIsShared |= maskImage == this->GetElastix()->GetFixedMask( i );
+    }
+    if( maskIsShared )
+    {
+      key << "FixedMaskErosion " << maskImage << " " << maskImage->GetMTime();
+      erosion = dynamic_cast< FixedMaskErodeFilterType * >(
+        ElastixBase::GetCachedObject( key.str() ) );
+    }
+
+    if( erosion.IsNull() )
+    {
+      erosion = FixedMaskErodeFilterType::New();
+      erosion->SetInput( maskImage );
+      erosion->SetIsMovingMask( false );
+      erosion->ComputeAllLevelsOn();
+      if( maskIsShared )
+      {
+        ElastixBase::SetCachedObject( key.str(), erosion );
+      }
+    }
+  }
+  if( erosion->GetSchedule() != pyramid->GetSchedule() )
+  {
+    erosion->SetSchedule( pyramid->GetSchedule() );
+  }
 
   /** Set output of the erosion to fixedImageMaskAsImage. */
-  FixedMaskImagePointer erodedFixedMaskAsImage = erosion->GetOutput();
+  FixedMaskImagePointer erodedFixedMaskAsImage = erosion->GetOutput( level );
 
   /** Do the erosion. */
   try
@@ -144,9 +666,6 @@ RegistrationBase< TElastix >
     throw excp;
   }
 
-  /** Release some memory. */
-  erodedFixedMaskAsImage->DisconnectPipeline();
-
   fixedMaskSpatialObject->SetImage( erodedFixedMaskAsImage );
   return fixedMaskSpatialObject;
 
@@ -178,15 +697,25 @@ RegistrationBase< TElastix >
     return movingMaskSpatialObject;
   }
 
-  /** Erode, and convert to spatial object. */
-  MovingMaskErodeFilterPointer erosion = MovingMaskErodeFilterType::New();
-  erosion->SetInput( maskImage );
-  erosion->SetSchedule( pyramid->GetSchedule() );
-  erosion->SetIsMovingMask( true );
-  erosion->SetResolutionLevel( level );
+  /** Erode, and convert to spatial object. The erosion filter of this mask
+   * computes all levels at once, and is only executed again when the
+   * schedule changes.
+   */
+  MovingMaskErodeFilterPointer & erosion = this->m_MovingMaskErodeFilters[ maskImage ];
+  if( erosion.IsNull() )
+  {
+    erosion = MovingMaskErodeFilterType::New();
+    erosion->SetInput( maskImage );
+    erosion->SetIsMovingMask( true );
+    erosion->ComputeAllLevelsOn();
+  }
+  if( erosion->GetSchedule() != pyramid->GetSchedule() )
+  {
+    erosion->SetSchedule( pyramid->GetSchedule() );
+  }
 
   /** Set output of the erosion to movingImageMaskAsImage. */
-  MovingMaskImagePointer erodedMovingMaskAsImage = erosion->GetOutput();
+  MovingMaskImagePointer erodedMovingMaskAsImage = erosion->GetOutput( level );
 
   /** Do the erosion. */
   try
@@ -204,9 +733,6 @@ RegistrationBase< TElastix >
     throw excp;
   }
 
-  /** Release some memory */
-  erodedMovingMaskAsImage->DisconnectPipeline();
-
   movingMaskSpatialObject->SetImage( erodedMovingMaskAsImage );
   return movingMaskSpatialObject;
 
@@ -23,6 +23,8 @@
 
 #include "elxBaseComponentSE.h"
 #include "itkResampleImageFilter.h"
+#include "itkRayCastProjectionImageFilter.h"
+#include "itkWarpImageFilter.h"
 #include "elxProgressCommand.h"
 
 namespace elastix
@@ -64,6 +66,13 @@ namespace elastix
  *    of the written image is desired.\n
  *    example: <tt>(CompressResultImage "true")</tt> \n
  *    The default is "false".
+ * \parameter UseTransformedCoordinateCache: flag to store the transformed
+ *    coordinates of the output grid, as a displacement field of floats, when
+ *    an image is resampled. Following resamplings with the same transform
+ *    parameters and output grid, such as the images of a transformix batch,
+ *    then only interpolate. This costs one vector of floats per voxel.\n
+ *    example: <tt>(UseTransformedCoordinateCache "true")</tt> \n
+ *    The default is "false".
  *
  * \ingroup Resamplers
  * \ingroup ComponentBaseClasses
@@ -110,6 +119,12 @@ public:
   typedef typename ITKBaseType::OriginPointType  OriginPointType;
   typedef typename ITKBaseType::PixelType        OutputPixelType;
 
+  /** Typedef's for generating projection images with a ray caster. */
+  typedef itk::ImageSource< OutputImageType > ResultImageSourceType;
+  typedef itk::RayCastProjectionImageFilter<
+    InputImageType, OutputImageType, CoordRepType >  RayCastProjectionFilterType;
+  typedef typename RayCastProjectionFilterType::RayCasterType RayCastInterpolatorType;
+
   /** Typedef that is used in the elastix dll version. */
   typedef typename ElastixType::ParameterMapType ParameterMapType;
 
@@ -120,6 +135,15 @@ public:
   itkStaticConstMacro( ImageDimension, unsigned int,
     OutputImageType::ImageDimension );
 
+  /** Typedef's for the cache of transformed coordinates. */
+  typedef itk::Vector< float,
+    itkGetStaticConstMacro( ImageDimension ) >      CoordinateCacheVectorType;
+  typedef itk::Image< CoordinateCacheVectorType,
+    itkGetStaticConstMacro( ImageDimension ) >      CoordinateCacheImageType;
+  typedef itk::WarpImageFilter< InputImageType,
+    OutputImageType, CoordinateCacheImageType >     WarpFilterType;
+  typedef typename TransformType::ParametersType    TransformParametersType;
+
   /** Cast to ITKBaseType. */
   virtual ITKBaseType * GetAsITKBaseType( void )
   {
@@ -181,6 +205,22 @@ public:
   /** Function to create the result image in the format of an itk::Image. */
   virtual void CreateItkResultImage( void );
 
+  /** Function to resample another image than the input image, with the same
+   * transform and output grid, but with another interpolator, and to write
+   * the result to a file with the given pixel type. Used by the batch mode
+   * of transformix. The input and interpolator of the resampler are restored
+   * afterwards.
+   */
+  virtual void ResampleAndWriteResultImage( InputImageType * image,
+    InterpolatorType * interpolator, const std::string & resultImagePixelType,
+    const char * filename, const bool & showProgress = true );
+
+  /** Create an interpolator that resamples with B-splines of the given order.
+   * Order 0 gives a nearest neighbor interpolator, and order 1 a linear
+   * interpolator, which are cheaper than the equivalent B-spline interpolators.
+   */
+  static typename InterpolatorType::Pointer CreateInterpolator( const unsigned int splineOrder );
+
 protected:
 
   /** The constructor. */
@@ -191,6 +231,19 @@ protected:
   /** Method that sets the transform, the interpolator and the inputImage. */
   virtual void SetComponents( void );
 
+  /** Get the filter that produces the result image. This is the resampler
+   * itself, unless the resample interpolator is a ray caster. In that case
+   * the projection image is generated in one multi-threaded pass by a
+   * RayCastProjectionImageFilter, set up with the output grid of the resampler.
+   */
+  virtual ResultImageSourceType * GetResultImageSource( void );
+
+  /** Function to write the result output image to a file, with the given
+   * pixel type, instead of the ResultImagePixelType of the parameter file.
+   */
+  virtual void WriteResultImage( OutputImageType * image, const char * filename,
+    const std::string & resultImagePixelType, const bool & showProgress );
+
   /** Variable that defines to print the progress or not. */
   bool m_ShowProgress;
 
@@ -204,6 +257,20 @@ private:
   /** Release memory. */
   void ReleaseMemory( void );
 
+  /** The projection filter, only used with a ray cast resample interpolator. */
+  typename RayCastProjectionFilterType::Pointer m_RayCastProjectionFilter;
+
+  /** Compute the transformed coordinates of the output grid, unless the
+   * cache is still valid for the current transform and output grid.
+   */
+  void UpdateCoordinateCache( void );
+
+  /** The cache of transformed coordinates, and the filter that resamples with it. */
+  typename CoordinateCacheImageType::Pointer m_CoordinateCache;
+  const TransformType *                      m_CoordinateCacheTransform;
+  TransformParametersType                    m_CoordinateCacheParameters;
+  typename WarpFilterType::Pointer           m_WarpFilter;
+
 };
 
 } // end namespace elastix
@@ -22,7 +22,10 @@
 
 #include "itkImageFileCastWriter.h"
 #include "itkChangeInformationImageFilter.h"
-#include "itkAdvancedRayCastInterpolateImageFunction.h"
+#include "itkNearestNeighborInterpolateImageFunction.h"
+#include "itkLinearInterpolateImageFunction.h"
+#include "itkMultiThreadedBSplineInterpolateImageFunction.h"
+#include "itkTransformToDisplacementFieldFilter.h"
 #include "itkTimeProbe.h"
 
 namespace elastix
@@ -36,7 +39,8 @@ template< class TElastix >
 ResamplerBase< TElastix >
 ::ResamplerBase()
 {
-  this->m_ShowProgress = true;
+  this->m_ShowProgress             = true;
+  this->m_CoordinateCacheTransform = 0;
 } // end Constructor
 
 
@@ -314,6 +318,141 @@ ResamplerBase< TElastix >
 } // end SetComponents()
 
 
+/**
+ * ******************* GetResultImageSource ********************
+ */
+
+template< class TElastix >
+typename ResamplerBase< TElastix >::ResultImageSourceType *
+ResamplerBase< TElastix >
+::GetResultImageSource( void )
+{
+  ITKBaseType * resampler = this->GetAsITKBaseType();
+
+  /** Check if ResampleInterpolator is the RayCastResampleInterpolator. */
+  RayCastInterpolatorType * rayCaster = dynamic_cast< RayCastInterpolatorType * >(
+    const_cast< InterpolatorType * >( resampler->GetInterpolator() ) );
+  if( rayCaster == 0 )
+  {
+    /** Possibly interpolate at the cached transformed coordinates. */
+    bool useCoordinateCache = false;
+    this->m_Configuration->ReadParameter( useCoordinateCache,
+      "UseTransformedCoordinateCache", 0, false );
+    if( !useCoordinateCache )
+    {
+      return resampler;
+    }
+
+    this->UpdateCoordinateCache();
+    if( this->m_WarpFilter.IsNull() )
+    {
+      this->m_WarpFilter = WarpFilterType::New();
+    }
+    WarpFilterType * warper = this->m_WarpFilter;
+    warper->SetInput( resampler->GetInput() );
+    warper->SetInterpolator( const_cast< InterpolatorType * >( resampler->GetInterpolator() ) );
+    warper->SetDisplacementField( this->m_CoordinateCache );
+    warper->SetEdgePaddingValue( resampler->GetDefaultPixelValue() );
+    warper->SetOutputSize( resampler->GetSize() );
+    warper->SetOutputStartIndex( resampler->GetOutputStartIndex() );
+    warper->SetOutputOrigin( resampler->GetOutputOrigin() );
+    warper->SetOutputSpacing( resampler->GetOutputSpacing() );
+    warper->SetOutputDirection( resampler->GetOutputDirection() );
+    return warper;
+  }
+
+  /** Cast the rays with the transform of the ray caster, on the output
+   * grid of the resampler.
+   */
+  if( this->m_RayCastProjectionFilter.IsNull() )
+  {
+    this->m_RayCastProjectionFilter = RayCastProjectionFilterType::New();
+  }
+  RayCastProjectionFilterType * projector = this->m_RayCastProjectionFilter;
+  projector->SetInput( resampler->GetInput() );
+  projector->SetRayCaster( rayCaster );
+  projector->SetTransform( rayCaster->GetTransform() );
+  projector->SetSize( resampler->GetSize() );
+  projector->SetOutputStartIndex( resampler->GetOutputStartIndex() );
+  projector->SetOutputOrigin( resampler->GetOutputOrigin() );
+  projector->SetOutputSpacing( resampler->GetOutputSpacing() );
+  projector->SetOutputDirection( resampler->GetOutputDirection() );
+
+  return projector;
+
+} // end GetResultImageSource()
+
+
+/**
+ * ******************* UpdateCoordinateCache ********************
+ */
+
+template< class TElastix >
+void
+ResamplerBase< TElastix >
+::UpdateCoordinateCache( void )
+{
+  ITKBaseType *         resampler = this->GetAsITKBaseType();
+  const TransformType * transform = resampler->GetTransform();
+
+  /** The cache stays valid as long as the transform parameters and
+   * the output grid do not change.
+   */
+  if( this->m_CoordinateCache.IsNotNull()
+    && this->m_CoordinateCacheTransform == transform
+    && this->m_CoordinateCacheParameters == transform->GetParameters() )
+  {
+    const CoordinateCacheImageType * cache  = this->m_CoordinateCache;
+    const typename CoordinateCacheImageType::RegionType & region
+      = cache->GetLargestPossibleRegion();
+    if( region.GetSize() == resampler->GetSize()
+      && region.GetIndex() == resampler->GetOutputStartIndex()
+      && cache->GetOrigin() == resampler->GetOutputOrigin()
+      && cache->GetSpacing() == resampler->GetOutputSpacing()
+      && cache->GetDirection() == resampler->GetOutputDirection() )
+    {
+      return;
+    }
+  }
+
+  /** Transform all points of the output grid, multi-threaded, and store
+   * the displacements as floats.
+   */
+  typedef itk::TransformToDisplacementFieldFilter<
+    CoordinateCacheImageType, CoordRepType >          CoordinateGeneratorType;
+  typename CoordinateGeneratorType::Pointer generator = CoordinateGeneratorType::New();
+  generator->SetSize( resampler->GetSize() );
+  generator->SetOutputStartIndex( resampler->GetOutputStartIndex() );
+  generator->SetOutputOrigin( resampler->GetOutputOrigin() );
+  generator->SetOutputSpacing( resampler->GetOutputSpacing() );
+  generator->SetOutputDirection( resampler->GetOutputDirection() );
+  generator->SetTransform( transform );
+
+  this->m_CoordinateCache = 0;
+  try
+  {
+    generator->Update();
+  }
+  catch( itk::ExceptionObject & excp )
+  {
+    /** Add information to the exception. */
+    excp.SetLocation( "ResamplerBase - UpdateCoordinateCache()" );
+    std::string err_str = excp.GetDescription();
+    err_str += "\nError occurred while computing the transformed coordinates.\n";
+    excp.SetDescription( err_str );
+
+    /** Pass the exception to an higher level. */
+    throw excp;
+  }
+
+  this->m_CoordinateCache = generator->GetOutput();
+  this->m_CoordinateCache->DisconnectPipeline();
+  this->m_CoordinateCacheTransform  = transform;
+  this->m_CoordinateCacheParameters = transform->GetParameters();
+
+} // end UpdateCoordinateCache()
+
+
 /**
  * ******************* ResampleAndWriteResultImage ********************
  */
@@ -324,14 +463,15 @@ ResamplerBase< TElastix >
 ::ResampleAndWriteResultImage( const char * filename, const bool & showProgress )
 {
   /** Make sure the resampler is updated. */
-  this->GetAsITKBaseType()->Modified();
+  ResultImageSourceType * source = this->GetResultImageSource();
+  source->Modified();
 
   /** Add a progress observer to the resampler. */
 #ifndef _ELASTIX_BUILD_LIBRARY
   typename ProgressCommandType::Pointer progressObserver = ProgressCommandType::New();
   if( showProgress )
   {
-    progressObserver->ConnectObserver( this->GetAsITKBaseType() );
+    progressObserver->ConnectObserver( source );
     progressObserver->SetStartString( "  Progress: " );
     progressObserver->SetEndString( "%" );
   }
@@ -340,7 +480,7 @@ ResamplerBase< TElastix >
   /** Do the resampling. */
   try
   {
-    this->GetAsITKBaseType()->Update();
+    source->Update();
   }
   catch( itk::ExceptionObject & excp )
   {
@@ -355,13 +495,13 @@ ResamplerBase< TElastix >
   }
 
   /** Perform the writing. */
-  this->WriteResultImage( this->GetAsITKBaseType()->GetOutput(), filename, showProgress );
+  this->WriteResultImage( source->GetOutput(), filename, showProgress );
 
   /** Disconnect from the resampler. */
 #ifndef _ELASTIX_BUILD_LIBRARY
   if( showProgress )
   {
-    progressObserver->DisconnectObserver( this->GetAsITKBaseType() );
+    progressObserver->DisconnectObserver( source );
   }
 #endif
 
@@ -378,26 +518,28 @@ ResamplerBase< TElastix >
 ::WriteResultImage( OutputImageType * image,
   const char * filename, const bool & showProgress )
 {
-  /** Check if ResampleInterpolator is the RayCastResampleInterpolator  */
-  typedef itk::AdvancedRayCastInterpolateImageFunction<  InputImageType,
-    CoordRepType > RayCastInterpolatorType;
-  const RayCastInterpolatorType * testptr = dynamic_cast< const
-    RayCastInterpolatorType * >( this->GetAsITKBaseType()->GetInterpolator() );
-
-  /** If RayCastResampleInterpolator is used reset the Transform to
-   * overrule default Resampler settings.
-   */
-
-  if( testptr )
-  {
-    this->GetAsITKBaseType()->SetTransform(
-      ( const_cast< RayCastInterpolatorType * >( testptr ) )->GetTransform() );
-  }
-
-  /** Read output pixeltype from parameter the file. Replace possible " " with "_". */
+  /** Read output pixeltype from parameter the file. */
   std::string resultImagePixelType = "short";
   this->m_Configuration->ReadParameter( resultImagePixelType,
     "ResultImagePixelType", 0, false );
+
+  this->WriteResultImage( image, filename, resultImagePixelType, showProgress );
+
+} // end WriteResultImage()
+
+
+/**
+ * ******************* WriteResultImage ********************
+ */
+
+template< class TElastix >
+void
+ResamplerBase< TElastix >
+::WriteResultImage( OutputImageType * image, const char * filename,
+  const std::string & pixelType, const bool & showProgress )
+{
+  /** Replace possible " " in the pixel type with "_". */
+  std::string                                resultImagePixelType = pixelType;
   std::basic_string< char >::size_type       pos  = resultImagePixelType.find( " " );
   const std::basic_string< char >::size_type npos = std::basic_string< char >::npos;
   if( pos != npos ) { resultImagePixelType.replace( pos, 1, "_" ); }
@@ -457,6 +599,94 @@ ResamplerBase< TElastix >
 } // end WriteResultImage()
 
 
+/**
+ * ******************* ResampleAndWriteResultImage ********************
+ */
+
+template< class TElastix >
+void
+ResamplerBase< TElastix >
+::ResampleAndWriteResultImage( InputImageType * image,
+  InterpolatorType * interpolator, const std::string & resultImagePixelType,
+  const char * filename, const bool & showProgress )
+{
+  /** Temporarily replace the input and the interpolator of the resampler.
+   * The transform, and the output grid, stay the same.
+   */
+  ITKBaseType *                          resampler = this->GetAsITKBaseType();
+  typename InputImageType::ConstPointer  originalInput = resampler->GetInput();
+  typename InterpolatorType::Pointer     originalInterpolator
+    = const_cast< InterpolatorType * >( resampler->GetInterpolator() );
+  resampler->SetInput( image );
+  resampler->SetInterpolator( interpolator );
+
+  /** Do the resampling and the writing. */
+  ResultImageSourceType * source = 0;
+  try
+  {
+    source = this->GetResultImageSource();
+    source->Modified();
+    source->Update();
+    this->WriteResultImage( source->GetOutput(), filename,
+      resultImagePixelType, showProgress );
+  }
+  catch( itk::ExceptionObject & excp )
+  {
+    resampler->SetInput( originalInput );
+    resampler->SetInterpolator( originalInterpolator );
+
+    /** Add information to the exception. */
+    excp.SetLocation( "ResamplerBase - ResampleAndWriteResultImage()" );
+    std::string err_str = excp.GetDescription();
+    err_str += "\nError occurred while resampling the image " + std::string( filename ) + ".\n";
+    excp.SetDescription( err_str );
+
+    /** Pass the exception to an higher level. */
+    throw excp;
+  }
+
+  /** Restore the resampler, and release the output of this image. */
+  resampler->SetInput( originalInput );
+  resampler->SetInterpolator( originalInterpolator );
+  source->GetOutput()->ReleaseData();
+
+} // end ResampleAndWriteResultImage()
+
+
+/**
+ * ******************* CreateInterpolator ********************
+ */
+
+template< class TElastix >
+typename ResamplerBase< TElastix >::InterpolatorType::Pointer
+ResamplerBase< TElastix >
+::CreateInterpolator( const unsigned int splineOrder )
+{
+  typename InterpolatorType::Pointer interpolator;
+  if( splineOrder == 0 )
+  {
+    interpolator = itk::NearestNeighborInterpolateImageFunction<
+      InputImageType, CoordRepType >::New();
+  }
+  else if( splineOrder == 1 )
+  {
+    interpolator = itk::LinearInterpolateImageFunction<
+      InputImageType, CoordRepType >::New();
+  }
+  else
+  {
+    typedef itk::MultiThreadedBSplineInterpolateImageFunction<
+      InputImageType, CoordRepType, double >  BSplineInterpolatorType;
+    typename BSplineInterpolatorType::Pointer bsplineInterpolator
+      = BSplineInterpolatorType::New();
+    bsplineInterpolator->SetSplineOrder( splineOrder );
+    interpolator = bsplineInterpolator;
+  }
+  return interpolator;
+
+} // end CreateInterpolator()
+
+
 /*
  * ******************* CreateItkResultImage ********************
  * \todo: avoid code duplication with WriteResultImage function
@@ -470,12 +700,13 @@ ResamplerBase< TElastix >
   itk::DataObject::Pointer resultImage;
 
   /** Make sure the resampler is updated. */
-  this->GetAsITKBaseType()->Modified();
+  ResultImageSourceType * source = this->GetResultImageSource();
+  source->Modified();
 
 #ifndef _ELASTIX_BUILD_LIBRARY
   /** Add a progress observer to the resampler. */
   typename ProgressCommandType::Pointer progressObserver = ProgressCommandType::New();
-  progressObserver->ConnectObserver( this->GetAsITKBaseType() );
+  progressObserver->ConnectObserver( source );
   progressObserver->SetStartString( "  Progress: " );
   progressObserver->SetEndString( "%" );
 #endif
@@ -483,7 +714,7 @@ ResamplerBase< TElastix >
   /** Do the resampling. */
   try
   {
-    this->GetAsITKBaseType()->Update();
+    source->Update();
   }
   catch( itk::ExceptionObject & excp )
   {
@@ -497,22 +728,6 @@ ResamplerBase< TElastix >
     throw excp;
   }
 
-  /** Check if ResampleInterpolator is the RayCastResampleInterpolator */
-  typedef itk::AdvancedRayCastInterpolateImageFunction<  InputImageType,
-    CoordRepType > RayCastInterpolatorType;
-
-  const RayCastInterpolatorType * testptr = dynamic_cast< const
-    RayCastInterpolatorType * >( this->GetAsITKBaseType()->GetInterpolator() );
-
-  /** If RayCastResampleInterpolator is used reset the Transform to
-   * overrule default Resampler settings */
-
-  if( testptr )
-  {
-    this->GetAsITKBaseType()->SetTransform(
-      ( const_cast< RayCastInterpolatorType * >( testptr ) )->GetTransform() );
-  }
-
   /** Read output pixeltype from parameter the file. Replace possible " " with "_". */
   std::string resultImagePixelType = "short";
   this->m_Configuration->ReadParameter( resultImagePixelType,
@@ -531,7 +746,7 @@ ResamplerBase< TElastix >
   bool          retdc = this->GetElastix()->GetOriginalFixedImageDirection( originalDirection );
   infoChanger->SetOutputDirection( originalDirection );
   infoChanger->SetChangeDirection( retdc & !this->GetElastix()->GetUseDirectionCosines() );
-  infoChanger->SetInput( this->GetAsITKBaseType()->GetOutput() );
+  infoChanger->SetInput( source->GetOutput() );
 
   typedef itk::CastImageFilter< InputImageType,
     itk::Image< char, InputImageType::ImageDimension > >            CastFilterChar;
@@ -639,7 +854,7 @@ ResamplerBase< TElastix >
 
 #ifndef _ELASTIX_BUILD_LIBRARY
   /** Disconnect from the resampler. */
-  progressObserver->DisconnectObserver( this->GetAsITKBaseType() );
+  progressObserver->DisconnectObserver( source );
 #endif
 } // end CreateItkResultImage()
 
@@ -24,8 +24,10 @@
 #include "elxBaseComponentSE.h"
 #include "itkAdvancedTransform.h"
 #include "itkAdvancedCombinationTransform.h"
+#include "itkStackTransform.h"
 #include "elxComponentDatabase.h"
 #include "elxProgressCommand.h"
+#include "elxTransformParametersDataFile.h"
 
 #include <fstream>
 #include <iomanip>
@@ -51,6 +53,26 @@ namespace elastix
  *   "Compose" by composition: \f$T(x) = T_1 ( T_0(x) )\f$.\n
  *   example: <tt>(HowToCombineTransforms "Add")</tt>\n
  *   Default: "Add".
+ * \parameter UseBinaryFormatForTransformationParameters: Write the transform parameter
+ *   vector to a binary data file next to the transform parameter file, instead of writing
+ *   it as text. This is much faster for large transforms, such as B-splines with
+ *   many control points, also when WriteTransformParametersEachIteration is used.
+ *   The data file is memory-mapped when it is read, e.g. by transformix.\n
+ *   example: <tt>(UseBinaryFormatForTransformationParameters "true")</tt>\n
+ *   Default: "false".
+ * \parameter FlattenInitialTransform: Collapse an initial transform that consists of
+ *   several linear stages (e.g. translation, then affine) into one affine transform,
+ *   which is used to evaluate the metric. The stages themselves are kept, so the
+ *   transform parameter files are written as usual.\n
+ *   example: <tt>(FlattenInitialTransform "true")</tt>\n
+ *   Default: "false".
+ * \parameter FlattenNonLinearInitialTransform: Cache a nonlinear initial transform as a
+ *   displacement field on the fixed image grid of the current resolution, and use it
+ *   to evaluate the metric. Points outside the grid, and all derivatives, are still
+ *   computed by the initial transform. The field costs three floats per voxel, and is
+ *   recomputed for each resolution. The final resampling is not affected.\n
+ *   example: <tt>(FlattenNonLinearInitialTransform "true")</tt>\n
+ *   Default: "false".
  *
  * \transformparameter UseDirectionCosines: Controls whether to use or ignore the
  * direction cosines (world matrix, transform matrix) set in the images.
@@ -97,6 +119,9 @@ namespace elastix
  * \transformparameter TransformParameters: the transform parameter vector that defines the transformation.\n
  * example <tt>(TransformParameters 0.03 1.0 0.2 ...)</tt>\n
  * The number of entries is stored the NumberOfParameters entry.
+ * If UseBinaryFormatForTransformationParameters is "true", this entry holds the
+ * name of a binary data file instead, relative to the transform parameter file.\n
+ * example <tt>(TransformParameters "TransformParameters.0.txt.dat")</tt>\n
  * \transformparameter NumberOfParameters: the length of the transform parameter vector.\n
  * example <tt>(NumberOfParameters 722)</tt>\n
  * \transformparameter InitialTransformParametersFileName: The location/name of an initial
@@ -183,6 +208,9 @@ public:
     itkGetStaticConstMacro( FixedImageDimension ) >   CombinationTransformType;
   typedef typename
     CombinationTransformType::InitialTransformType InitialTransformType;
+  typedef itk::StackTransform< CoordRepType,
+    itkGetStaticConstMacro( FixedImageDimension ),
+    itkGetStaticConstMacro( MovingImageDimension ) >  StackTransformType;
 
   /** Typedef's from Transform. */
   typedef typename ITKBaseType::ParametersType ParametersType;
@@ -247,6 +275,16 @@ public:
    */
   virtual void BeforeRegistrationBase( void );
 
+  /** Execute stuff before each resolution:
+   * \li Possibly cache a nonlinear initial transform as a displacement field.
+   */
+  virtual void BeforeEachResolutionBase( void );
+
+  /** Execute stuff after each resolution:
+   * \li Release the displacement field of the initial transform.
+   */
+  virtual void AfterEachResolutionBase( void );
+
   /** Execute stuff after the registration:
    * \li Get and set the final parameters for the resampler.
    */
@@ -349,6 +387,28 @@ protected:
   void AutomaticScalesEstimationStackTransform(
     const unsigned int & numSubTransforms, ScalesType & scales ) const;
 
+  /** Compute the deformation field of a stack transform on the grid of the
+   * resampler. The points are transformed in batches, such that the sub
+   * transforms of the stack are evaluated concurrently.
+   */
+  typename DeformationFieldImageType::Pointer GenerateStackDeformationFieldImage(
+    const StackTransformType * stackTransform ) const;
+
+  /** Collapse the linear initial transforms of a chain of combination
+   * transforms into single affine transforms, and set them as the flattened
+   * initial transforms. Returns the flattened initial transform of the given
+   * combination transform.
+   */
+  static InitialTransformType * FlattenLinearInitialTransforms(
+    CombinationTransformType * combination );
+
+  /** Get the internal pixel types of the fixed and moving image, as given
+   * in the parameter file. The value "native" is replaced by the actual
+   * pixel type, which is needed by transformix.
+   */
+  void GetInternalImagePixelTypes(
+    std::string & fixedPixelType, std::string & movingPixelType ) const;
+
   /** Member variables. */
   ParametersType * m_TransformParametersPointer;
   std::string      m_TransformParametersFileName;
@@ -378,6 +438,16 @@ private:
   /** Boolean to decide whether or not the transform parameters are written in binary format. */
   bool m_UseBinaryFormatForTransformationParameters;
 
+  /** The memory-mapped data file that holds the transform parameters,
+   * if they were read in binary format.
+   */
+  TransformParametersDataFile::Pointer m_TransformParametersDataFile;
+
+  /** The initial transform as flattened in BeforeRegistrationBase, which is
+   * restored after each resolution.
+   */
+  typename InitialTransformType::Pointer m_LinearFlattenedInitialTransform;
+
 };
 
 } // end namespace elastix
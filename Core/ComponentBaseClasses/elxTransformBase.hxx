@@ -31,12 +31,20 @@
 #include "itkTransformToSpatialJacobianSource.h"
 #include "itkImageFileWriter.h"
 #include "itkImageGridSampler.h"
+#include "itkImageRegionIterator.h"
+#include "itkImageRegionIteratorWithIndex.h"
 #include "itkContinuousIndex.h"
 #include "itkChangeInformationImageFilter.h"
 #include "itkMesh.h"
 #include "itkMeshFileReader.h"
 #include "itkMeshFileWriter.h"
 #include "itkTransformMeshFilter.h"
+#include "itkAdvancedMatrixOffsetTransformBase.h"
+#include "itkCachedDisplacementFieldTransform.h"
+#include "itkTimeProbe.h"
+#include "itkImageFileCastWriter.h"
+
+#include <algorithm> // For std::replace.
 
 namespace itk
 {
@@ -296,9 +304,197 @@ TransformBase< TElastix >
     }
   }
 
+  /** Collapse chains of linear initial transforms, if desired. The initial
+   * transforms themselves are kept, since they are needed to write the
+   * transform parameter files.
+   */
+  bool flattenInitialTransform = false;
+  this->m_Configuration->ReadParameter(
+    flattenInitialTransform, "FlattenInitialTransform", 0, false );
+  this->m_LinearFlattenedInitialTransform = 0;
+  if( thisAsGrouper && flattenInitialTransform )
+  {
+    this->m_LinearFlattenedInitialTransform
+      = FlattenLinearInitialTransforms( thisAsGrouper );
+  }
+
 } // end BeforeRegistrationBase()
 
 
+/**
+ * ******************* BeforeEachResolutionBase *****************
+ */
+
+template< class TElastix >
+void
+TransformBase< TElastix >
+::BeforeEachResolutionBase( void )
+{
+  /** Check if a nonlinear initial transform should be cached. */
+  CombinationTransformType * thisAsGrouper = this->GetAsCombinationTransform();
+  if( !thisAsGrouper || thisAsGrouper->GetInitialTransform() == 0
+    || thisAsGrouper->GetInitialTransform()->IsLinear() )
+  {
+    return;
+  }
+  bool flattenNonLinearInitialTransform = false;
+  this->m_Configuration->ReadParameter( flattenNonLinearInitialTransform,
+    "FlattenNonLinearInitialTransform", 0, false );
+  if( !flattenNonLinearInitialTransform )
+  {
+    return;
+  }
+
+  /** Typedef's. */
+  typedef itk::CachedDisplacementFieldTransform< CoordRepType,
+    itkGetStaticConstMacro( FixedImageDimension ) >   CachedTransformType;
+  typedef typename CachedTransformType::DisplacementFieldType DisplacementFieldType;
+  typedef itk::TransformToDisplacementFieldFilter<
+    DisplacementFieldType, CoordRepType >             DisplacementFieldGeneratorType;
+
+  /** The field is computed on the grid of the fixed image of this resolution. */
+  const unsigned int level
+    = this->m_Registration->GetAsITKBaseType()->GetCurrentLevel();
+  FixedImageType * fixedImage = this->m_Registration->GetAsITKBaseType()
+    ->GetFixedImagePyramid()->GetOutput( level );
+  fixedImage->UpdateOutputInformation();
+
+  /** Use the linear flattening for the part of the chain that has it. */
+  InitialTransformType * initialTransform = thisAsGrouper->GetFlattenedInitialTransform();
+
+  itk::TimeProbe timer;
+  timer.Start();
+
+  typename DisplacementFieldGeneratorType::Pointer fieldGenerator
+    = DisplacementFieldGeneratorType::New();
+  fieldGenerator->SetSize( fixedImage->GetLargestPossibleRegion().GetSize() );
+  fieldGenerator->SetOutputStartIndex( fixedImage->GetLargestPossibleRegion().GetIndex() );
+  fieldGenerator->SetOutputSpacing( fixedImage->GetSpacing() );
+  fieldGenerator->SetOutputOrigin( fixedImage->GetOrigin() );
+  fieldGenerator->SetOutputDirection( fixedImage->GetDirection() );
+  fieldGenerator->SetTransform( initialTransform );
+
+  try
+  {
+    fieldGenerator->Update();
+  }
+  catch( itk::ExceptionObject & excp )
+  {
+    /** Add information to the exception. */
+    excp.SetLocation( "TransformBase - BeforeEachResolutionBase()" );
+    std::string err_str = excp.GetDescription();
+    err_str += "\nError occurred while caching the initial transform.\n";
+    excp.SetDescription( err_str );
+
+    /** Pass the exception to an higher level. */
+    throw excp;
+  }
+
+  typename CachedTransformType::Pointer cachedTransform = CachedTransformType::New();
+  cachedTransform->SetCachedTransform( initialTransform );
+  cachedTransform->SetDisplacementField( fieldGenerator->GetOutput() );
+  thisAsGrouper->SetFlattenedInitialTransform( cachedTransform );
+
+  timer.Stop();
+  elxout << "  Caching the initial transform as a displacement field took "
+         << static_cast< long >( timer.GetMean() * 1000 ) << " ms." << std::endl;
+
+} // end BeforeEachResolutionBase()
+
+
+/**
+ * ******************* AfterEachResolutionBase ******************
+ */
+
+template< class TElastix >
+void
+TransformBase< TElastix >
+::AfterEachResolutionBase( void )
+{
+  /** Release the displacement field, so that the final resampling and the
+   * next resolution use the initial transform itself.
+   */
+  CombinationTransformType * thisAsGrouper = this->GetAsCombinationTransform();
+  if( thisAsGrouper )
+  {
+    thisAsGrouper->SetFlattenedInitialTransform(
+      this->m_LinearFlattenedInitialTransform );
+  }
+
+} // end AfterEachResolutionBase()
+
+
+/**
+ * ************** FlattenLinearInitialTransforms ****************
+ */
+
+template< class TElastix >
+typename TransformBase< TElastix >::InitialTransformType
+* TransformBase< TElastix >
+::FlattenLinearInitialTransforms( CombinationTransformType * combination )
+{
+  InitialTransformType * initialTransform = combination->GetInitialTransform();
+  CombinationTransformType * initialAsGrouper
+    = dynamic_cast< CombinationTransformType * >( initialTransform );
+
+  /** A single transform, or the end of the chain, needs no flattening. */
+  if( !initialAsGrouper || initialAsGrouper->GetNumberOfTransforms() < 2 )
+  {
+    return initialTransform;
+  }
+
+  /** A nonlinear initial transform is kept, but its own initial transforms
+   * may still be flattened.
+   */
+  if( !initialTransform->IsLinear() )
+  {
+    FlattenLinearInitialTransforms( initialAsGrouper );
+    return initialTransform;
+  }
+
+  /** Linear transforms are affine, so the matrix and offset follow from
+   * the images of the origin and of the unit vectors.
+   */
+  typedef itk::AdvancedMatrixOffsetTransformBase< CoordRepType,
+    itkGetStaticConstMacro( FixedImageDimension ),
+    itkGetStaticConstMacro( FixedImageDimension ) >   AffineTransformType;
+  typedef typename AffineTransformType::MatrixType       MatrixType;
+  typedef typename AffineTransformType::OutputVectorType OutputVectorType;
+
+  InputPointType point;
+  point.Fill( 0.0 );
+  const OutputPointType origin = initialTransform->TransformPoint( point );
+
+  MatrixType matrix;
+  for( unsigned int i = 0; i < FixedImageDimension; ++i )
+  {
+    point.Fill( 0.0 );
+    point[ i ] = 1.0;
+    const OutputPointType image = initialTransform->TransformPoint( point );
+    for( unsigned int j = 0; j < FixedImageDimension; ++j )
+    {
+      matrix[ j ][ i ] = image[ j ] - origin[ j ];
+    }
+  }
+  OutputVectorType offset;
+  for( unsigned int j = 0; j < FixedImageDimension; ++j )
+  {
+    offset[ j ] = origin[ j ];
+  }
+
+  typename AffineTransformType::Pointer affineTransform = AffineTransformType::New();
+  affineTransform->SetMatrix( matrix );
+  affineTransform->SetOffset( offset );
+  combination->SetFlattenedInitialTransform( affineTransform );
+
+  elxout << "  The " << initialAsGrouper->GetNumberOfTransforms()
+         << " linear initial transforms are flattened into one." << std::endl;
+
+  return combination->GetFlattenedInitialTransform();
+
+} // end FlattenLinearInitialTransforms()
+
+
 /**
  * ******************* GetInitialTransform **********************
  */
@@ -411,27 +607,46 @@ TransformBase< TElastix >
   /** Read the TransformParameters. */
   if( this->m_ReadWriteTransformParameters )
   {
-    /** Get the TransformParameters pointer. */
+    /** Get the TransformParameters pointer. Delete it before the data
+     * file, since it may point into the mapped memory.
+     */
     if( this->m_TransformParametersPointer )
     {
       delete this->m_TransformParametersPointer;
     }
-    this->m_TransformParametersPointer = new ParametersType( numberOfParameters );
+    this->m_TransformParametersPointer  = 0;
+    this->m_TransformParametersDataFile = 0;
 
     /** Read the TransformParameters. */
     std::size_t numberOfParametersFound = 0;
     std::vector< ValueType > vecPar;
     if( useBinaryFormatForTransformationParameters )
     {
+      /** Map the data file in memory, and use the mapped values as the
+       * transform parameters, without copying or parsing them.
+       */
       std::string dataFileName = "";
       this->m_Configuration->ReadParameter( dataFileName, "TransformParameters", 0 );
-      std::ifstream infile( dataFileName.c_str(), std::ios::in | std::ios::binary );
-      infile.read( reinterpret_cast<char *>( this->m_TransformParametersPointer->data_block() ), sizeof( ValueType ) * numberOfParameters );
-      numberOfParametersFound = infile.gcount() / sizeof( ValueType ); // for sanity check
-      infile.close();
+      dataFileName = TransformParametersDataFile::FindDataFile(
+        dataFileName, this->m_Configuration->GetParameterFileName() );
+
+      std::string errorMessage = "";
+      this->m_TransformParametersDataFile = TransformParametersDataFile::New();
+      if( !this->m_TransformParametersDataFile->Map( dataFileName, errorMessage ) )
+      {
+        itkExceptionMacro( << errorMessage );
+      }
+      numberOfParametersFound = this->m_TransformParametersDataFile->GetNumberOfValues(); // for sanity check
+
+      this->m_TransformParametersPointer = new ParametersType();
+      this->m_TransformParametersPointer->SetData(
+        this->m_TransformParametersDataFile->GetValues(),
+        std::min( numberOfParametersFound, static_cast< std::size_t >( numberOfParameters ) ),
+        false );
     }
     else
     {
+      this->m_TransformParametersPointer = new ParametersType( numberOfParameters );
       vecPar.resize( numberOfParameters, itk::NumericTraits< ValueType >::ZeroValue() );
       this->m_Configuration->ReadParameter( vecPar, "TransformParameters",
         0, numberOfParameters - 1, true );
@@ -699,14 +914,20 @@ TransformBase< TElastix >
   {
     if( this->m_UseBinaryFormatForTransformationParameters )
     {
-      /** Writing in binary format is faster for large vectors, and slightly more accurate. */
-      std::string dataFileName = this->GetTransformParametersFileName();
-      dataFileName += ".dat";
-      xout[ "transpar" ] << "(TransformParameters \"" << dataFileName << "\")" << std::endl;
-
-      std::ofstream outfile( dataFileName.c_str(), ios::out | ios::binary );
-      outfile.write( reinterpret_cast<const char *>( param.data_block() ), sizeof( ValueType ) * nrP );
-      outfile.close();
+      /** Writing in binary format is faster for large vectors, and slightly more accurate.
+       * The data file is referenced relative to the transform parameter file.
+       */
+      const std::string dataFileName = this->GetTransformParametersFileName() + ".dat";
+      xout[ "transpar" ] << "(TransformParameters \""
+                         << itksys::SystemTools::GetFilenameName( dataFileName )
+                         << "\")" << std::endl;
+
+      std::string errorMessage = "";
+      if( !TransformParametersDataFile::Write( dataFileName,
+        param.data_block(), nrP, errorMessage ) )
+      {
+        xout[ "error" ] << errorMessage << std::endl;
+      }
     }
     else
     {
@@ -766,8 +987,7 @@ TransformBase< TElastix >
   /** Write image pixel types. */
   std::string fixpix = "float";
   std::string movpix = "float";
-  this->m_Configuration->ReadParameter( fixpix, "FixedInternalImagePixelType", 0 );
-  this->m_Configuration->ReadParameter( movpix, "MovingInternalImagePixelType", 0 );
+  this->GetInternalImagePixelTypes( fixpix, movpix );
   xout[ "transpar" ] << "(FixedInternalImagePixelType \""
                      << fixpix << "\")" << std::endl;
   xout[ "transpar" ] << "(MovingInternalImagePixelType \""
@@ -948,8 +1168,7 @@ TransformBase< TElastix >
   /** Write image pixel types. */
   std::string fixpix = "float";
   std::string movpix = "float";
-  this->m_Configuration->ReadParameter( fixpix, "FixedInternalImagePixelType", 0 );
-  this->m_Configuration->ReadParameter( movpix, "MovingInternalImagePixelType", 0 );
+  this->GetInternalImagePixelTypes( fixpix, movpix );
 
   parameterName = "FixedInternalImagePixelType";
   parameterValues.push_back( fixpix );
@@ -1515,6 +1734,17 @@ TransformBase< TElastix >
     this->m_Elastix->GetElxResamplerBase()->GetAsITKBaseType()->GetOutputDirection() );
   defGenerator->SetTransform( const_cast< const ITKBaseType * >( this->GetAsITKBaseType() ) );
 
+  /** A stack transform without initial transform is evaluated in batches,
+   * see GenerateStackDeformationFieldImage().
+   */
+  const CombinationTransformType * combinationTransform = this->GetAsCombinationTransform();
+  const StackTransformType *       stackTransform       = 0;
+  if( combinationTransform != 0 && combinationTransform->GetInitialTransform() == 0 )
+  {
+    stackTransform = dynamic_cast< const StackTransformType * >(
+      combinationTransform->GetCurrentTransform() );
+  }
+
   /** Possibly change direction cosines to their original value, as specified
    * in the tp-file, or by the fixed image. This is only necessary when
    * the UseDirectionCosines flag was set to false. */
@@ -1535,6 +1765,10 @@ TransformBase< TElastix >
 
   try
   {
+    if( stackTransform != 0 )
+    {
+      infoChanger->SetInput( this->GenerateStackDeformationFieldImage( stackTransform ) );
+    }
     infoChanger->Update();
   }
   catch ( itk::ExceptionObject & excp )
@@ -1553,6 +1787,80 @@ TransformBase< TElastix >
 } // end GenerateDeformationFieldImage()
 
 
+/**
+ * ************** GenerateStackDeformationFieldImage **********************
+ */
+
+template< class TElastix >
+typename TransformBase< TElastix >::DeformationFieldImageType::Pointer
+TransformBase< TElastix >
+::GenerateStackDeformationFieldImage( const StackTransformType * stackTransform ) const
+{
+  /** Typedef's. */
+  typedef typename DeformationFieldImageType::RegionType DeformationFieldRegionType;
+  typedef itk::ImageRegionIteratorWithIndex<
+    DeformationFieldImageType >                       PointIteratorType;
+  typedef itk::ImageRegionIterator<
+    DeformationFieldImageType >                       FieldIteratorType;
+  typedef typename StackTransformType::InputPointContainerType  InputPointContainerType;
+  typedef typename StackTransformType::OutputPointContainerType OutputPointContainerType;
+
+  /** Create the deformation field on the grid of the resampler. */
+  const DeformationFieldRegionType region(
+    this->m_Elastix->GetElxResamplerBase()->GetAsITKBaseType()->GetOutputStartIndex(),
+    this->m_Elastix->GetElxResamplerBase()->GetAsITKBaseType()->GetSize() );
+  typename DeformationFieldImageType::Pointer deformationField
+    = DeformationFieldImageType::New();
+  deformationField->SetRegions( region );
+  deformationField->SetSpacing(
+    this->m_Elastix->GetElxResamplerBase()->GetAsITKBaseType()->GetOutputSpacing() );
+  deformationField->SetOrigin(
+    this->m_Elastix->GetElxResamplerBase()->GetAsITKBaseType()->GetOutputOrigin() );
+  deformationField->SetDirection(
+    this->m_Elastix->GetElxResamplerBase()->GetAsITKBaseType()->GetOutputDirection() );
+  deformationField->Allocate();
+
+  /** Transform the points of the grid in chunks of consecutive voxels, to
+   * limit the memory use. A chunk covers one or a few slices, and its points
+   * are distributed over the threads per sub transform.
+   */
+  const std::size_t        chunkSize = 1 << 18;
+  InputPointContainerType  points;
+  OutputPointContainerType transformedPoints;
+  points.reserve( std::min( chunkSize,
+    static_cast< std::size_t >( region.GetNumberOfPixels() ) ) );
+
+  PointIteratorType pointIt( deformationField, region );
+  FieldIteratorType fieldIt( deformationField, region );
+  InputPointType    point;
+  VectorPixelType   displacement;
+  while( !pointIt.IsAtEnd() )
+  {
+    points.clear();
+    for( ; !pointIt.IsAtEnd() && points.size() < chunkSize; ++pointIt )
+    {
+      deformationField->TransformIndexToPhysicalPoint( pointIt.GetIndex(), point );
+      points.push_back( point );
+    }
+
+    stackTransform->TransformPoints( points, transformedPoints );
+
+    for( std::size_t i = 0; i < points.size(); ++i, ++fieldIt )
+    {
+      for( unsigned int d = 0; d < FixedImageDimension; ++d )
+      {
+        displacement[ d ] = static_cast< float >(
+          transformedPoints[ i ][ d ] - points[ i ][ d ] );
+      }
+      fieldIt.Set( displacement );
+    }
+  }
+
+  return deformationField;
+
+} // end GenerateStackDeformationFieldImage()
+
+
 /**
  * ************** WriteDeformationFieldImage **********************
  */
@@ -2036,6 +2344,36 @@ TransformBase< TElastix >
 } // end AutomaticScalesEstimationStackTransform()
 
 
+/**
+ * ******************* GetInternalImagePixelTypes **********************
+ */
+
+template< class TElastix >
+void
+TransformBase< TElastix >
+::GetInternalImagePixelTypes(
+  std::string & fixedPixelType, std::string & movingPixelType ) const
+{
+  this->m_Configuration->ReadParameter( fixedPixelType, "FixedInternalImagePixelType", 0 );
+  this->m_Configuration->ReadParameter( movingPixelType, "MovingInternalImagePixelType", 0 );
+
+  /** ITK describes for example unsigned short as "unsigned_short". */
+  if( fixedPixelType == "native" )
+  {
+    fixedPixelType = itk::ImageFileCastWriter< FixedImageType >::New()
+      ->GetDefaultOutputComponentType();
+    std::replace( fixedPixelType.begin(), fixedPixelType.end(), '_', ' ' );
+  }
+  if( movingPixelType == "native" )
+  {
+    movingPixelType = itk::ImageFileCastWriter< MovingImageType >::New()
+      ->GetDefaultOutputComponentType();
+    std::replace( movingPixelType.begin(), movingPixelType.end(), '_', ' ' );
+  }
+
+} // end GetInternalImagePixelTypes()
+
+
 } // end namespace elastix
 
 #endif // end #ifndef __elxTransformBase_hxx
@@ -136,8 +136,8 @@ ComponentDatabase::GetCreator(
   const ComponentDescriptionType & name,
   IndexType i )
 {
-  /** Get the map */
-  CreatorMapType map = GetCreatorMap();
+  /** Get the map, without copying it. */
+  CreatorMapType & map = GetCreatorMap();
 
   /** Make a key with the input arguments */
   CreatorMapKeyType key( name, i );
@@ -145,7 +145,8 @@ ComponentDatabase::GetCreator(
   /** Check if this key has been defined. If yes, return the 'creator'
    * that is linked to it.
    */
-  if( map.count( key ) == 0 )    // of gewoon !map.count( key ) als boven??
+  CreatorMapType::const_iterator it = map.find( key );
+  if( it == map.end() )
   {
     xout[ "error" ] << "Error: " << std::endl;
     xout[ "error" ] << name << "(index " << i << ") - This component is not installed!" << std::endl;
@@ -153,7 +154,7 @@ ComponentDatabase::GetCreator(
   }
   else
   {
-    return map[ key ];
+    return it->second;
   }
 
 } // end GetCreator
@@ -170,8 +171,8 @@ ComponentDatabase::GetIndex(
   const PixelTypeDescriptionType & movingPixelType,
   ImageDimensionType movingDimension )
 {
-  /** Get the map */
-  IndexMapType map = GetIndexMap();
+  /** Get the map, without copying it. */
+  IndexMapType & map = GetIndexMap();
 
   /** Make a key with the input arguments */
   ImageTypeDescriptionType fixedImage( fixedPixelType, fixedDimension );
@@ -202,6 +203,27 @@ ComponentDatabase::GetIndex(
 } // end GetIndex
 
 
+/**
+ * ************************* HasIndex ***************************
+ */
+
+bool
+ComponentDatabase::HasIndex(
+  const PixelTypeDescriptionType & fixedPixelType,
+  ImageDimensionType fixedDimension,
+  const PixelTypeDescriptionType & movingPixelType,
+  ImageDimensionType movingDimension )
+{
+  /** Make a key with the input arguments */
+  ImageTypeDescriptionType fixedImage( fixedPixelType, fixedDimension );
+  ImageTypeDescriptionType movingImage( movingPixelType, movingDimension );
+  IndexMapKeyType          key( fixedImage, movingImage );
+
+  return this->GetIndexMap().count( key ) > 0;
+
+} // end HasIndex
+
+
 } // end namespace elastix
 
 #endif // end ifndef __elxComponentDatabase_cxx
@@ -136,6 +136,15 @@ public:
     const PixelTypeDescriptionType & movingPixelType,
     ImageDimensionType movingDimension );
 
+  /** Check if a combination of ImageTypes is supported, without reporting
+   * an error if it is not.
+   */
+  bool HasIndex(
+    const PixelTypeDescriptionType & fixedPixelType,
+    ImageDimensionType fixedDimension,
+    const PixelTypeDescriptionType & movingPixelType,
+    ImageDimensionType movingDimension );
+
 protected:
 
   ComponentDatabase(){}
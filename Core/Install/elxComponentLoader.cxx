@@ -154,10 +154,43 @@ ComponentLoader::LoadComponents( const char * /** argv0 */ )
     }
   }   //end if !ImageTypeSupportInstalled
 
-  elxout << "Installing all components." << std::endl;
+  /** The components themselves are installed by InstallComponents(),
+   * once the image types are known.
+   */
+  return 0;
+
+} // end LoadComponents
+
+
+/**
+ * ****************** InstallComponents **************************
+ */
+
+int
+ComponentLoader::InstallComponents( ComponentDatabaseType::IndexType index )
+{
+  /** Check if the components for this index were installed already. */
+  if( this->m_InstalledIndices.count( index ) > 0 )
+  {
+    return 0;
+  }
+
+  /** Report the image types of this index. */
+  elxout << "Installing the components for the image types:";
+  ComponentDatabaseType::IndexMapType & indexMap = this->m_ComponentDatabase->GetIndexMap();
+  for( ComponentDatabaseType::IndexMapType::const_iterator it = indexMap.begin();
+    it != indexMap.end(); ++it )
+  {
+    if( it->second == index )
+    {
+      elxout << " fixed " << it->first.first.first << " " << it->first.first.second << "D,"
+             << " moving " << it->first.second.first << " " << it->first.second.second << "D";
+    }
+  }
+  elxout << "." << std::endl;
 
-  /** Fill the component database */
-  installReturnCode = InstallAllComponents( this->m_ComponentDatabase );
+  /** Fill the component database for this index only. */
+  int installReturnCode = InstallAllComponents( this->m_ComponentDatabase, index );
 
   if( installReturnCode )
   {
@@ -166,11 +199,13 @@ ComponentLoader::LoadComponents( const char * /** argv0 */ )
     return installReturnCode;
   }
 
+  this->m_InstalledIndices.insert( index );
+
   elxout << "InstallingComponents was successful.\n" << std::endl;
 
   return 0;
 
-} // end LoadComponents
+} // end InstallComponents
 
 
 /**
@@ -22,6 +22,8 @@
 #include "elxComponentDatabase.h"
 #include "xoutmain.h"
 
+#include <set>
+
 namespace elastix
 {
 
@@ -36,6 +38,11 @@ namespace elastix
 *
 * Each new component (a new metric for example should "make itself
 * known" by calling the elxInstallMacro, which is defined in elxMacro.h.
+*
+* LoadComponents() only installs the supported image types. The components
+* are installed per image type, on the first call of InstallComponents()
+* for its index, such that a run only fills the database for the image
+* types it uses.
 */
 
 class ComponentLoader : public itk::Object
@@ -64,6 +71,11 @@ public:
    * to find the program directory, but is not used anymore. */
   virtual int LoadComponents( const char * argv0 );
 
+  /** Function to install the components for the image types with the
+   * given index, if that was not done before. Returns 0 when successful.
+   */
+  virtual int InstallComponents( ComponentDatabaseType::IndexType index );
+
   /** Function to unload components. */
   virtual void UnloadComponents( void );
 
@@ -78,6 +90,9 @@ protected:
   bool m_ImageTypeSupportInstalled;
   virtual int   InstallSupportedImageTypes( void );
 
+  /** The indices for which the components are installed. */
+  std::set< ComponentDatabaseType::IndexType > m_InstalledIndices;
+
 private:
 
   /** Standard private (copy)constructor. */
@@ -28,8 +28,10 @@
  * the InstallComponent functions implemented by the components. */
 #include "elxInstallComponentFunctionDeclarations.h"
 
+/** Install all components for the image types with the given index. */
 int
-InstallAllComponents( elx::ComponentDatabase * _cdb )
+InstallAllComponents( elx::ComponentDatabase * _cdb,
+  elx::ComponentDatabase::IndexType _index )
 {
   int ret = 0;
 
@@ -82,11 +82,13 @@
  * IMPORTANT: only one template argument <class TElastix> is allowed. Not more,
  * not less.
  *
- * Details: a function "int _classname##InstallComponent( _cdb )" is defined.
- * In this function a template is defined, _classname##_install<VIndex>.
- * It contains the ElastixTypedef<VIndex>, and recursive function DO(cdb).
- * DO installs the component for all defined ElastixTypedefs (so for all
- * supported image types).
+ * Details: a function "int _classname##InstallComponent( _cdb, _index )" is
+ * defined. In this function a template is defined, _classname##_install<VIndex>.
+ * It contains the ElastixTypedef<VIndex>, and recursive function DO(cdb, index).
+ * DO walks over all defined ElastixTypedefs (so over all supported image
+ * types), and installs the component only for the one with VIndex == index.
+ * In this way only the components of the image types that are actually
+ * used are put in the component database.
  *
  */
 #define elxInstallMacro( _classname ) \
@@ -96,13 +98,17 @@
 public: \
     typedef typename::elx::ElastixTypedef< VIndex >::ElastixType ElastixType; \
     typedef::elx::ComponentDatabase::ComponentDescriptionType    ComponentDescriptionType; \
-    static int DO( ::elx::ComponentDatabase * cdb ) \
+    static int DO( ::elx::ComponentDatabase * cdb, \
+      ::elx::ComponentDatabase::IndexType index ) \
     { \
-      ComponentDescriptionType name  = ::elx::_classname< ElastixType >::elxGetClassNameStatic(); \
-      int                      dummy = ::elx::InstallFunctions< ::elx::_classname< ElastixType > >::InstallComponent( name, VIndex, cdb ); \
+      if( index == VIndex ) \
+      { \
+        ComponentDescriptionType name = ::elx::_classname< ElastixType >::elxGetClassNameStatic(); \
+        return ::elx::InstallFunctions< ::elx::_classname< ElastixType > >::InstallComponent( name, VIndex, cdb ); \
+      } \
       if( ::elx::ElastixTypedef< VIndex + 1 >::Defined() ) \
-      { return _classname##_install< VIndex + 1 >::DO( cdb ); } \
-      return dummy;  \
+      { return _classname##_install< VIndex + 1 >::DO( cdb, index ); } \
+      return 0;  \
     } \
   }; \
   template< > \
@@ -110,13 +116,15 @@ public: \
   { \
 public: \
     typedef::elx::ComponentDatabase::ComponentDescriptionType ComponentDescriptionType; \
-    static int DO( ::elx::ComponentDatabase * /** cdb */ ) \
+    static int DO( ::elx::ComponentDatabase * /** cdb */, \
+      ::elx::ComponentDatabase::IndexType /** index */ ) \
     { return 0; } \
   }; \
   extern "C" int _classname##InstallComponent( \
-  ::elx::ComponentDatabase * _cdb ) \
+  ::elx::ComponentDatabase * _cdb, \
+  ::elx::ComponentDatabase::IndexType _index ) \
   { \
-    int _InstallDummy##_classname = _classname##_install< 1 >::DO( _cdb  ); \
+    int _InstallDummy##_classname = _classname##_install< 1 >::DO( _cdb, _index ); \
     return _InstallDummy##_classname; \
   } //ignore semicolon
 
@@ -139,7 +147,8 @@ public: \
  */
 #define elxInstallComponentFunctionDeclarationMacro( _classname ) \
   extern "C" int _classname##InstallComponent( \
-  ::elx::ComponentDatabase * _cdb )
+  ::elx::ComponentDatabase * _cdb, \
+  ::elx::ComponentDatabase::IndexType _index )
 
 /**
  * elxInstallComponentFunctionCallMacro
@@ -159,7 +168,7 @@ public: \
  * See also elxInstallAllComponents.h.
  */
 #define elxInstallComponentFunctionCallMacro( _classname ) \
-  ret |= _classname##InstallComponent( _cdb )
+  ret |= _classname##InstallComponent( _cdb, _index )
 
 /**
  * elxPrepareImageTypeSupportMacro
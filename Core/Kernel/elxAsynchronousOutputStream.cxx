@@ -0,0 +1,436 @@
+/*=========================================================================
+ *
+ *  Copyright UMC Utrecht and contributors
+ *
+ *  Licensed under the Apache License, Version 2.0 (the "License");
+ *  you may not use this file except in compliance with the License.
+ *  You may obtain a copy of the License at
+ *
+ *        http://www.apache.org/licenses/LICENSE-2.0.txt
+ *
+ *  Unless required by applicable law or agreed to in writing, software
+ *  distributed under the License is distributed on an "AS IS" BASIS,
+ *  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *  See the License for the specific language governing permissions and
+ *  limitations under the License.
+ *
+ *=========================================================================*/
+#include "elxAsynchronousOutputStream.h"
+
+#include <itksys/SystemTools.hxx>
+
+namespace elastix
+{
+
+namespace
+{
+
+/** The collected text is queued when it gets this long, also without a
+ * flush, so that the memory use stays limited.
+ */
+const std::string::size_type MaximumCollectedTextSize = 1 << 20;
+
+/** The time in milliseconds that the writer thread waits when the queue
+ * is empty.
+ */
+const unsigned int WriterThreadDelay = 10;
+
+} // end namespace
+
+
+/**
+ * ******************* Constructor *******************
+ */
+
+AsynchronousOutputStream
+::AsynchronousOutputStream() : Superclass( 0 )
+{
+  this->rdbuf( &this->m_StreamBuffer );
+
+} // end Constructor
+
+
+/**
+ * ******************* Destructor *******************
+ */
+
+AsynchronousOutputStream
+::~AsynchronousOutputStream()
+{
+  this->m_StreamBuffer.StopWriterThread();
+
+} // end Destructor
+
+
+/**
+ * ******************* SetDestination *******************
+ */
+
+void
+AsynchronousOutputStream
+::SetDestination( std::ostream * destination )
+{
+  this->m_StreamBuffer.SetDestination( destination );
+  this->clear();
+
+} // end SetDestination()
+
+
+/**
+ * ******************* GetDestination *******************
+ */
+
+std::ostream *
+AsynchronousOutputStream
+::GetDestination( void ) const
+{
+  return this->m_StreamBuffer.GetDestination();
+
+} // end GetDestination()
+
+
+/**
+ * ******************* StartWriterThread *******************
+ */
+
+void
+AsynchronousOutputStream
+::StartWriterThread( void )
+{
+  this->m_StreamBuffer.StartWriterThread();
+
+} // end StartWriterThread()
+
+
+/**
+ * ******************* StopWriterThread *******************
+ */
+
+void
+AsynchronousOutputStream
+::StopWriterThread( void )
+{
+  this->m_StreamBuffer.StopWriterThread();
+
+} // end StopWriterThread()
+
+
+/**
+ * ******************* GetWriterThreadRunning *******************
+ */
+
+bool
+AsynchronousOutputStream
+::GetWriterThreadRunning( void ) const
+{
+  return this->m_StreamBuffer.GetWriterThreadRunning();
+
+} // end GetWriterThreadRunning()
+
+
+/**
+ * ******************* StreamBuffer Constructor *******************
+ */
+
+AsynchronousOutputStream::StreamBuffer
+::StreamBuffer()
+{
+  this->m_Destination         = 0;
+  this->m_StopWriterThread    = false;
+  this->m_WriterThreadId      = 0;
+  this->m_WriterThreadRunning = false;
+
+} // end StreamBuffer Constructor
+
+
+/**
+ * ******************* StreamBuffer Destructor *******************
+ */
+
+AsynchronousOutputStream::StreamBuffer
+::~StreamBuffer()
+{
+  this->StopWriterThread();
+
+} // end StreamBuffer Destructor
+
+
+/**
+ * ******************* SetDestination *******************
+ */
+
+void
+AsynchronousOutputStream::StreamBuffer
+::SetDestination( std::ostream * destination )
+{
+  this->StopWriterThread();
+  this->m_Destination = destination;
+
+} // end SetDestination()
+
+
+/**
+ * ******************* StartWriterThread *******************
+ */
+
+void
+AsynchronousOutputStream::StreamBuffer
+::StartWriterThread( void )
+{
+  if( this->m_WriterThreadRunning || this->m_Destination == 0 )
+  {
+    return;
+  }
+
+  /** The threader is only created here, since the streams of xout are
+   * global objects, which are constructed before ITK is ready.
+   */
+  if( this->m_Threader.IsNull() )
+  {
+    this->m_Threader = ThreaderType::New();
+  }
+
+  this->m_StopWriterThread    = false;
+  this->m_WriterThreadId      = this->m_Threader->SpawnThread(
+    WriterThreadCallback, this );
+  this->m_WriterThreadRunning = true;
+
+} // end StartWriterThread()
+
+
+/**
+ * ******************* StopWriterThread *******************
+ */
+
+void
+AsynchronousOutputStream::StreamBuffer
+::StopWriterThread( void )
+{
+  if( !this->m_WriterThreadRunning )
+  {
+    return;
+  }
+
+  /** Let the writer thread write the remaining text and wait for it. */
+  this->QueueCollectedText();
+  this->LockQueue();
+  this->m_StopWriterThread = true;
+  this->UnlockQueue();
+
+  this->m_Threader->TerminateThread( this->m_WriterThreadId );
+  this->m_WriterThreadRunning = false;
+
+} // end StopWriterThread()
+
+
+/**
+ * ******************* overflow *******************
+ */
+
+AsynchronousOutputStream::StreamBuffer::int_type
+AsynchronousOutputStream::StreamBuffer
+::overflow( int_type c )
+{
+  if( traits_type::eq_int_type( c, traits_type::eof() ) )
+  {
+    return traits_type::not_eof( c );
+  }
+
+  if( this->m_WriterThreadRunning )
+  {
+    this->m_CollectedText += traits_type::to_char_type( c );
+    if( this->m_CollectedText.size() >= MaximumCollectedTextSize )
+    {
+      this->QueueCollectedText();
+    }
+  }
+  else if( this->m_Destination != 0 )
+  {
+    this->m_Destination->put( traits_type::to_char_type( c ) );
+    if( !this->m_Destination->good() )
+    {
+      return traits_type::eof();
+    }
+  }
+  return c;
+
+} // end overflow()
+
+
+/**
+ * ******************* xsputn *******************
+ */
+
+std::streamsize
+AsynchronousOutputStream::StreamBuffer
+::xsputn( const char * s, std::streamsize n )
+{
+  if( this->m_WriterThreadRunning )
+  {
+    this->m_CollectedText.append( s, static_cast< std::string::size_type >( n ) );
+    if( this->m_CollectedText.size() >= MaximumCollectedTextSize )
+    {
+      this->QueueCollectedText();
+    }
+  }
+  else if( this->m_Destination != 0 )
+  {
+    this->m_Destination->write( s, n );
+    if( !this->m_Destination->good() )
+    {
+      return 0;
+    }
+  }
+  return n;
+
+} // end xsputn()
+
+
+/**
+ * ******************* sync *******************
+ */
+
+int
+AsynchronousOutputStream::StreamBuffer
+::sync( void )
+{
+  if( this->m_WriterThreadRunning )
+  {
+    this->QueueCollectedText();
+  }
+  else if( this->m_Destination != 0 )
+  {
+    this->m_Destination->flush();
+    if( this->m_Destination->bad() )
+    {
+      return -1;
+    }
+  }
+  return 0;
+
+} // end sync()
+
+
+/**
+ * ******************* seekoff *******************
+ */
+
+AsynchronousOutputStream::StreamBuffer::pos_type
+AsynchronousOutputStream::StreamBuffer
+::seekoff( off_type off, std::ios_base::seekdir way, std::ios_base::openmode which )
+{
+  if( off == 0 && way == std::ios_base::cur && ( which & std::ios_base::out )
+    && !this->m_WriterThreadRunning && this->m_Destination != 0 )
+  {
+    return this->m_Destination->tellp();
+  }
+  return pos_type( off_type( -1 ) );
+
+} // end seekoff()
+
+
+/**
+ * ******************* QueueCollectedText *******************
+ */
+
+void
+AsynchronousOutputStream::StreamBuffer
+::QueueCollectedText( void )
+{
+  if( this->m_CollectedText.empty() )
+  {
+    return;
+  }
+
+  this->LockQueue();
+  if( this->m_QueuedText.empty() )
+  {
+    this->m_QueuedText.swap( this->m_CollectedText );
+  }
+  else
+  {
+    this->m_QueuedText.append( this->m_CollectedText );
+  }
+  this->UnlockQueue();
+
+  this->m_CollectedText.clear();
+
+} // end QueueCollectedText()
+
+
+/**
+ * ******************* LockQueue *******************
+ */
+
+void
+AsynchronousOutputStream::StreamBuffer
+::LockQueue( void )
+{
+#if ITK_VERSION_MAJOR >= 5
+  this->m_QueueMutex.lock();
+#else
+  this->m_QueueMutex.Lock();
+#endif
+
+} // end LockQueue()
+
+
+/**
+ * ******************* UnlockQueue *******************
+ */
+
+void
+AsynchronousOutputStream::StreamBuffer
+::UnlockQueue( void )
+{
+#if ITK_VERSION_MAJOR >= 5
+  this->m_QueueMutex.unlock();
+#else
+  this->m_QueueMutex.Unlock();
+#endif
+
+} // end UnlockQueue()
+
+
+/**
+ * ******************* WriterThreadCallback *******************
+ */
+
+ITK_THREAD_RETURN_TYPE
+AsynchronousOutputStream::StreamBuffer
+::WriterThreadCallback( void * arg )
+{
+  ThreadInfoType * infoStruct = static_cast< ThreadInfoType * >( arg );
+  StreamBuffer *   buffer     = static_cast< StreamBuffer * >( infoStruct->UserData );
+
+  /** Take the queued text and write it, until the thread should stop.
+   * The text and the stop flag are taken together, so that all text that
+   * was queued before StopWriterThread() is written.
+   */
+  std::string text;
+  bool        stop = false;
+  while( !stop )
+  {
+    buffer->LockQueue();
+    text.swap( buffer->m_QueuedText );
+    stop = buffer->m_StopWriterThread;
+    buffer->UnlockQueue();
+
+    if( !text.empty() )
+    {
+      buffer->m_Destination->write( text.data(), static_cast< std::streamsize >( text.size() ) );
+      buffer->m_Destination->flush();
+      text.clear();
+    }
+    else if( !stop )
+    {
+      itksys::SystemTools::Delay( WriterThreadDelay );
+    }
+  }
+
+  return ITK_THREAD_RETURN_VALUE;
+
+} // end WriterThreadCallback()
+
+
+} // end namespace elastix
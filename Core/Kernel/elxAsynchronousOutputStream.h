@@ -0,0 +1,175 @@
+/*=========================================================================
+ *
+ *  Copyright UMC Utrecht and contributors
+ *
+ *  Licensed under the Apache License, Version 2.0 (the "License");
+ *  you may not use this file except in compliance with the License.
+ *  You may obtain a copy of the License at
+ *
+ *        http://www.apache.org/licenses/LICENSE-2.0.txt
+ *
+ *  Unless required by applicable law or agreed to in writing, software
+ *  distributed under the License is distributed on an "AS IS" BASIS,
+ *  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *  See the License for the specific language governing permissions and
+ *  limitations under the License.
+ *
+ *=========================================================================*/
+#ifndef __elxAsynchronousOutputStream_h
+#define __elxAsynchronousOutputStream_h
+
+#include "itkMultiThreader.h"
+
+#if ITK_VERSION_MAJOR >= 5
+#include <mutex>
+#else
+#include "itkSimpleFastMutexLock.h"
+#endif
+
+#include <ostream>
+#include <streambuf>
+#include <string>
+
+namespace elastix
+{
+
+/**
+ * \class AsynchronousOutputStream
+ * \brief An output stream that can leave the writing to a background thread.
+ *
+ * The text written to this stream is passed on to a destination stream,
+ * such as the log file, std::cout or an IterationInfo file. By default,
+ * this happens directly, as if the destination was used itself.
+ *
+ * After StartWriterThread(), the text is only collected in memory. A flush
+ * of this stream, for example by std::endl or by xoutrow::Flush(), appends
+ * the collected text to a queue, protected by a mutex. A background thread,
+ * spawned by an itk::MultiThreader, takes the text from the queue, writes
+ * it to the destination, and flushes the destination. So, a slow file
+ * system does not hold up the thread that writes to this stream; the text
+ * only reaches the destination somewhat later. StopWriterThread() waits
+ * until all text is written, and returns to direct writing.
+ *
+ * While the writer thread runs, the destination should only be written
+ * through this stream, and this stream should be used by one thread.
+ */
+
+class AsynchronousOutputStream : public std::ostream
+{
+public:
+
+  /** Standard typedefs. */
+  typedef AsynchronousOutputStream Self;
+  typedef std::ostream             Superclass;
+
+  /** Constructor and destructor. The destructor stops the writer thread. */
+  AsynchronousOutputStream();
+  virtual ~AsynchronousOutputStream();
+
+  /** Set/Get the destination stream. Setting it stops the writer thread.
+   * Without a destination, the text is discarded.
+   */
+  void SetDestination( std::ostream * destination );
+
+  std::ostream * GetDestination( void ) const;
+
+  /** Start writing the text in a background thread. */
+  void StartWriterThread( void );
+
+  /** Write all text that is collected or queued, stop the background
+   * thread and write the text directly again.
+   */
+  void StopWriterThread( void );
+
+  /** Get whether the text is written by the background thread. */
+  bool GetWriterThreadRunning( void ) const;
+
+private:
+
+  AsynchronousOutputStream( const Self & ); // purposely not implemented
+  void operator=( const Self & );           // purposely not implemented
+
+  /** The stream buffer, which collects the text, or passes it on. */
+  class StreamBuffer : public std::streambuf
+  {
+public:
+
+    typedef itk::MultiThreader              ThreaderType;
+    typedef ThreaderType::ThreadInfoStruct  ThreadInfoType;
+#if ITK_VERSION_MAJOR >= 5
+    typedef std::mutex MutexType;
+#else
+    typedef itk::SimpleFastMutexLock MutexType;
+#endif
+
+    StreamBuffer();
+    virtual ~StreamBuffer();
+
+    void SetDestination( std::ostream * destination );
+
+    std::ostream * GetDestination( void ) const { return this->m_Destination; }
+
+    void StartWriterThread( void );
+
+    void StopWriterThread( void );
+
+    bool GetWriterThreadRunning( void ) const { return this->m_WriterThreadRunning; }
+
+protected:
+
+    /** Write one character, a sequence of characters, or flush. */
+    virtual int_type overflow( int_type c );
+
+    virtual std::streamsize xsputn( const char * s, std::streamsize n );
+
+    virtual int sync( void );
+
+    /** Report the position of the destination, when it is written directly.
+     * The ProgressCommand uses it to find out if std::cout is a console.
+     */
+    virtual pos_type seekoff( off_type off, std::ios_base::seekdir way,
+      std::ios_base::openmode which );
+
+private:
+
+    StreamBuffer( const StreamBuffer & );   // purposely not implemented
+    void operator=( const StreamBuffer & ); // purposely not implemented
+
+    /** Append the collected text to the queue of the writer thread. */
+    void QueueCollectedText( void );
+
+    /** Lock and unlock the queue. */
+    void LockQueue( void );
+
+    void UnlockQueue( void );
+
+    /** The function executed by the writer thread. */
+    static ITK_THREAD_RETURN_TYPE WriterThreadCallback( void * arg );
+
+    std::ostream * m_Destination;
+
+    /** The text written since the last flush, only used by the thread that
+     * writes to the stream.
+     */
+    std::string m_CollectedText;
+
+    /** The text that the writer thread should write, and whether it should
+     * stop, protected by m_QueueMutex.
+     */
+    std::string m_QueuedText;
+    bool        m_StopWriterThread;
+    MutexType   m_QueueMutex;
+
+    ThreaderType::Pointer m_Threader;
+    itk::ThreadIdType     m_WriterThreadId;
+    bool                  m_WriterThreadRunning;
+
+  };
+
+  StreamBuffer m_StreamBuffer;
+
+};
+
+} // end namespace elastix
+
+#endif // end #ifndef __elxAsynchronousOutputStream_h
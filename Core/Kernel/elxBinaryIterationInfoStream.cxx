@@ -0,0 +1,323 @@
+/*=========================================================================
+ *
+ *  Copyright UMC Utrecht and contributors
+ *
+ *  Licensed under the Apache License, Version 2.0 (the "License");
+ *  you may not use this file except in compliance with the License.
+ *  You may obtain a copy of the License at
+ *
+ *        http://www.apache.org/licenses/LICENSE-2.0.txt
+ *
+ *  Unless required by applicable law or agreed to in writing, software
+ *  distributed under the License is distributed on an "AS IS" BASIS,
+ *  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *  See the License for the specific language governing permissions and
+ *  limitations under the License.
+ *
+ *=========================================================================*/
+#include "elxBinaryIterationInfoStream.h"
+
+#include <algorithm>
+#include <cctype>
+#include <cstdlib>
+#include <cstring>
+#include <limits>
+
+namespace elastix
+{
+
+namespace
+{
+
+/** The header of a binary IterationInfo file. */
+struct IterationInfoHeader
+{
+  char         Magic[ 8 ];
+  unsigned int Version;
+  unsigned int ValueSize;
+  unsigned int ByteOrderMark;
+  unsigned int NumberOfColumns;
+};
+
+const char         IterationInfoMagic[ 8 ] = { 'E', 'L', 'X', 'I', 'T', 'E', 'R', '\0' };
+const unsigned int IterationInfoVersion    = 1;
+const unsigned int IterationInfoByteOrder  = 0x01020304;
+
+/** Split a row in its cells, which are separated by tabs. */
+void
+SplitRow( const std::string & row, std::vector< std::string > & cells )
+{
+  cells.clear();
+  std::string::size_type begin = 0;
+  while( true )
+  {
+    const std::string::size_type end = row.find( '\t', begin );
+    cells.push_back( row.substr( begin, end - begin ) );
+    if( end == std::string::npos )
+    {
+      break;
+    }
+    begin = end + 1;
+  }
+
+} // end SplitRow()
+
+
+/** Convert a cell to a number, or NaN if it is not a number. */
+double
+ConvertCell( const std::string & cell )
+{
+  const char * begin = cell.c_str();
+  char *       end   = 0;
+  const double value = std::strtod( begin, &end );
+  if( end == begin )
+  {
+    return std::numeric_limits< double >::quiet_NaN();
+  }
+  for( ; *end != '\0'; ++end )
+  {
+    if( !std::isspace( static_cast< unsigned char >( *end ) ) )
+    {
+      return std::numeric_limits< double >::quiet_NaN();
+    }
+  }
+  return value;
+
+} // end ConvertCell()
+
+
+} // end namespace
+
+
+/**
+ * ******************* Constructor *******************
+ */
+
+BinaryIterationInfoStream
+::BinaryIterationInfoStream() : Superclass( 0 )
+{
+  this->rdbuf( &this->m_StreamBuffer );
+
+} // end Constructor
+
+
+/**
+ * ******************* Destructor *******************
+ */
+
+BinaryIterationInfoStream
+::~BinaryIterationInfoStream()
+{
+  //nothing
+
+} // end Destructor
+
+
+/**
+ * ******************* SetDestination *******************
+ */
+
+void
+BinaryIterationInfoStream
+::SetDestination( std::ostream * destination )
+{
+  this->m_StreamBuffer.SetDestination( destination );
+  this->clear();
+
+} // end SetDestination()
+
+
+/**
+ * ******************* GetDestination *******************
+ */
+
+std::ostream *
+BinaryIterationInfoStream
+::GetDestination( void ) const
+{
+  return this->m_StreamBuffer.GetDestination();
+
+} // end GetDestination()
+
+
+/**
+ * ******************* StreamBuffer Constructor *******************
+ */
+
+BinaryIterationInfoStream::StreamBuffer
+::StreamBuffer()
+{
+  this->m_Destination     = 0;
+  this->m_HeaderWritten   = false;
+  this->m_NumberOfColumns = 0;
+
+} // end StreamBuffer Constructor
+
+
+/**
+ * ******************* StreamBuffer Destructor *******************
+ */
+
+BinaryIterationInfoStream::StreamBuffer
+::~StreamBuffer()
+{
+  //nothing
+
+} // end StreamBuffer Destructor
+
+
+/**
+ * ******************* SetDestination *******************
+ */
+
+void
+BinaryIterationInfoStream::StreamBuffer
+::SetDestination( std::ostream * destination )
+{
+  this->m_Destination     = destination;
+  this->m_HeaderWritten   = false;
+  this->m_NumberOfColumns = 0;
+  this->m_Row.clear();
+
+} // end SetDestination()
+
+
+/**
+ * ******************* overflow *******************
+ */
+
+BinaryIterationInfoStream::StreamBuffer::int_type
+BinaryIterationInfoStream::StreamBuffer
+::overflow( int_type c )
+{
+  if( traits_type::eq_int_type( c, traits_type::eof() ) )
+  {
+    return traits_type::not_eof( c );
+  }
+
+  const char character = traits_type::to_char_type( c );
+  if( character == '\n' )
+  {
+    this->WriteRow();
+  }
+  else
+  {
+    this->m_Row += character;
+  }
+  return c;
+
+} // end overflow()
+
+
+/**
+ * ******************* xsputn *******************
+ */
+
+std::streamsize
+BinaryIterationInfoStream::StreamBuffer
+::xsputn( const char * s, std::streamsize n )
+{
+  const char * end = s + n;
+  while( s != end )
+  {
+    const char * newline = std::find( s, end, '\n' );
+    this->m_Row.append( s, newline );
+    if( newline == end )
+    {
+      break;
+    }
+    this->WriteRow();
+    s = newline + 1;
+  }
+  return n;
+
+} // end xsputn()
+
+
+/**
+ * ******************* sync *******************
+ */
+
+int
+BinaryIterationInfoStream::StreamBuffer
+::sync( void )
+{
+  if( this->m_Destination != 0 )
+  {
+    this->m_Destination->flush();
+    if( this->m_Destination->bad() )
+    {
+      return -1;
+    }
+  }
+  return 0;
+
+} // end sync()
+
+
+/**
+ * ******************* WriteRow *******************
+ */
+
+void
+BinaryIterationInfoStream::StreamBuffer
+::WriteRow( void )
+{
+  if( this->m_Destination == 0 || this->m_Row.empty() )
+  {
+    this->m_Row.clear();
+    return;
+  }
+
+  std::vector< std::string > cells;
+  SplitRow( this->m_Row, cells );
+  this->m_Row.clear();
+
+  /** The first row contains the names of the columns. */
+  if( !this->m_HeaderWritten )
+  {
+    this->m_NumberOfColumns = static_cast< unsigned int >( cells.size() );
+
+    IterationInfoHeader header;
+    std::memset( &header, 0, sizeof( IterationInfoHeader ) );
+    std::memcpy( header.Magic, IterationInfoMagic, sizeof( IterationInfoMagic ) );
+    header.Version         = IterationInfoVersion;
+    header.ValueSize       = sizeof( ValueType );
+    header.ByteOrderMark   = IterationInfoByteOrder;
+    header.NumberOfColumns = this->m_NumberOfColumns;
+
+    /** The names, padded so that the records are aligned. */
+    std::string names;
+    for( unsigned int i = 0; i < this->m_NumberOfColumns; ++i )
+    {
+      names += cells[ i ];
+      names += '\0';
+    }
+    const std::string::size_type size = sizeof( IterationInfoHeader ) + names.size();
+    names.append( ( sizeof( ValueType ) - size % sizeof( ValueType ) ) % sizeof( ValueType ), '\0' );
+
+    this->m_Destination->write( reinterpret_cast< const char * >( &header ),
+      sizeof( IterationInfoHeader ) );
+    this->m_Destination->write( names.data(), static_cast< std::streamsize >( names.size() ) );
+    this->m_Values.resize( this->m_NumberOfColumns );
+    this->m_HeaderWritten = true;
+    return;
+  }
+
+  /** The values of a row; missing cells are stored as NaN. */
+  for( unsigned int i = 0; i < this->m_NumberOfColumns; ++i )
+  {
+    this->m_Values[ i ] = i < cells.size()
+      ? ConvertCell( cells[ i ] )
+      : std::numeric_limits< ValueType >::quiet_NaN();
+  }
+  if( this->m_NumberOfColumns > 0 )
+  {
+    this->m_Destination->write( reinterpret_cast< const char * >( &this->m_Values[ 0 ] ),
+      static_cast< std::streamsize >( sizeof( ValueType ) * this->m_NumberOfColumns ) );
+  }
+
+} // end WriteRow()
+
+
+} // end namespace elastix
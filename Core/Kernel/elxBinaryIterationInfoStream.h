@@ -0,0 +1,120 @@
+/*=========================================================================
+ *
+ *  Copyright UMC Utrecht and contributors
+ *
+ *  Licensed under the Apache License, Version 2.0 (the "License");
+ *  you may not use this file except in compliance with the License.
+ *  You may obtain a copy of the License at
+ *
+ *        http://www.apache.org/licenses/LICENSE-2.0.txt
+ *
+ *  Unless required by applicable law or agreed to in writing, software
+ *  distributed under the License is distributed on an "AS IS" BASIS,
+ *  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *  See the License for the specific language governing permissions and
+ *  limitations under the License.
+ *
+ *=========================================================================*/
+#ifndef __elxBinaryIterationInfoStream_h
+#define __elxBinaryIterationInfoStream_h
+
+#include <ostream>
+#include <streambuf>
+#include <string>
+#include <vector>
+
+namespace elastix
+{
+
+/**
+ * \class BinaryIterationInfoStream
+ * \brief An output stream that converts the iteration info table to binary.
+ *
+ * The rows of xout["iteration"] are written to this stream as text, with
+ * the cells separated by tabs. This stream converts them to a compact
+ * binary format, and writes that to a destination stream, which should be
+ * opened in binary mode:
+ * \li The header: the magic string "ELXITER", a format version, the size
+ *   of one value, a byte order mark and the number of columns, each a
+ *   32 bit unsigned integer. The header is taken from the first row, which
+ *   xoutrow::WriteHeaders() writes.
+ * \li The names of the columns, each terminated by a zero, padded with
+ *   zeros to a multiple of 8 bytes.
+ * \li One record per iteration, with the value of each column as a double.
+ *   A cell that is not a number is stored as NaN.
+ *
+ * The values are those of the text table, so with the same precision.
+ * The number of rows follows from the size of the file.
+ */
+
+class BinaryIterationInfoStream : public std::ostream
+{
+public:
+
+  /** Standard typedefs. */
+  typedef BinaryIterationInfoStream Self;
+  typedef std::ostream              Superclass;
+
+  /** The type of the values in the file. */
+  typedef double ValueType;
+
+  /** Constructor and destructor. */
+  BinaryIterationInfoStream();
+  virtual ~BinaryIterationInfoStream();
+
+  /** Set/Get the destination stream. Setting it starts a new table, of
+   * which the first row is the header.
+   */
+  void SetDestination( std::ostream * destination );
+
+  std::ostream * GetDestination( void ) const;
+
+private:
+
+  BinaryIterationInfoStream( const Self & ); // purposely not implemented
+  void operator=( const Self & );            // purposely not implemented
+
+  /** The stream buffer, which converts each row when it is complete. */
+  class StreamBuffer : public std::streambuf
+  {
+public:
+
+    StreamBuffer();
+    virtual ~StreamBuffer();
+
+    void SetDestination( std::ostream * destination );
+
+    std::ostream * GetDestination( void ) const { return this->m_Destination; }
+
+protected:
+
+    /** Write one character, a sequence of characters, or flush. */
+    virtual int_type overflow( int_type c );
+
+    virtual std::streamsize xsputn( const char * s, std::streamsize n );
+
+    virtual int sync( void );
+
+private:
+
+    StreamBuffer( const StreamBuffer & );   // purposely not implemented
+    void operator=( const StreamBuffer & ); // purposely not implemented
+
+    /** Write the header or a record for the current row. */
+    void WriteRow( void );
+
+    std::ostream *           m_Destination;
+    std::string              m_Row;
+    bool                     m_HeaderWritten;
+    unsigned int             m_NumberOfColumns;
+    std::vector< ValueType > m_Values;
+
+  };
+
+  StreamBuffer m_StreamBuffer;
+
+};
+
+} // end namespace elastix
+
+#endif // end #ifndef __elxBinaryIterationInfoStream_h
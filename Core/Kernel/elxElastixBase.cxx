@@ -16,6 +16,7 @@
  *
  *=========================================================================*/
 #include "elxElastixBase.h"
+#include "elxAsynchronousOutputStream.h"
 #include <sstream>
 #include "itkMersenneTwisterRandomVariateGenerator.h"
 
@@ -36,6 +37,9 @@ ElastixBase::ElastixBase()
   /** The default output precision of elxout is set to 6. */
   this->m_DefaultOutputPrecision = 6;
 
+  /** The output is written directly by default. */
+  this->m_UseAsynchronousOutput = false;
+
   /** Create the component containers. */
   this->m_FixedImagePyramidContainer    = ObjectContainerType::New();
   this->m_MovingImagePyramidContainer   = ObjectContainerType::New();
@@ -351,6 +355,21 @@ ElastixBase::BeforeRegistrationBase( void )
 
   xout.AddTargetCell( "iteration", &this->m_IterationInfo );
 
+  /** Flush the iteration info only once every so many iterations. */
+  unsigned int flushInterval = 1;
+  this->GetConfiguration()->ReadParameter( flushInterval,
+    "IterationInfoFlushInterval", 0, false );
+  this->m_IterationInfo.SetFlushInterval( flushInterval );
+
+  /** Write the output in background threads, if desired. */
+  this->m_UseAsynchronousOutput = false;
+  this->GetConfiguration()->ReadParameter( this->m_UseAsynchronousOutput,
+    "UseAsynchronousOutput", 0, false );
+  if( this->m_UseAsynchronousOutput )
+  {
+    this->StartAsynchronousOutput();
+  }
+
 } // end BeforeRegistrationBase()
 
 
@@ -361,12 +380,84 @@ ElastixBase::BeforeRegistrationBase( void )
 void
 ElastixBase::AfterRegistrationBase( void )
 {
+  /** Write the iteration info that is still buffered. */
+  this->m_IterationInfo.Flush();
+
+  /** Write the rest of the output directly again. */
+  this->StopAsynchronousOutput();
+
   /** Remove the "iteration" writing field. */
   xl::xout.RemoveTargetCell( "iteration" );
 
 } // end AfterRegistrationBase()
 
 
+/**
+ * **************** AfterEachResolutionBase *********************
+ */
+
+void
+ElastixBase::AfterEachResolutionBase( void )
+{
+  /** Write the rows of this resolution that are still buffered. */
+  this->m_IterationInfo.Flush();
+
+} // end AfterEachResolutionBase()
+
+
+/**
+ * **************** StartAsynchronousOutput *********************
+ */
+
+void
+ElastixBase::StartAsynchronousOutput( void )
+{
+  typedef xl::xoutbase_type::CStreamMapType CStreamMapType;
+
+  const CStreamMapType & outputs = xl::xout.GetCOutputs();
+  for( CStreamMapType::const_iterator it = outputs.begin(); it != outputs.end(); ++it )
+  {
+    AsynchronousOutputStream * output
+      = dynamic_cast< AsynchronousOutputStream * >( it->second );
+    if( output )
+    {
+      output->StartWriterThread();
+    }
+  }
+
+} // end StartAsynchronousOutput()
+
+
+/**
+ * **************** StopAsynchronousOutput **********************
+ */
+
+void
+ElastixBase::StopAsynchronousOutput( void )
+{
+  typedef xl::xoutbase_type::CStreamMapType CStreamMapType;
+
+  /** The outputs of the iteration info include the IterationInfo file. */
+  const CStreamMapType * outputMaps[ 2 ] = {
+    &xl::xout.GetCOutputs(), &this->m_IterationInfo.GetCOutputs()
+  };
+  for( unsigned int i = 0; i < 2; ++i )
+  {
+    for( CStreamMapType::const_iterator it = outputMaps[ i ]->begin();
+      it != outputMaps[ i ]->end(); ++it )
+    {
+      AsynchronousOutputStream * output
+        = dynamic_cast< AsynchronousOutputStream * >( it->second );
+      if( output )
+      {
+        output->StopWriterThread();
+      }
+    }
+  }
+
+} // end StopAsynchronousOutput()
+
+
 /**
  * ********************* GenerateFileNameContainer ******************
  */
@@ -456,6 +547,106 @@ ElastixBase::GenerateFileNameContainer(
 } // end GenerateFileNameContainer()
 
 
+/**
+ * ****************** Initialization of static members *********
+ */
+
+bool                       ElastixBase::s_UseDataCache = false;
+ElastixBase::DataCacheType ElastixBase::s_DataCache;
+unsigned long              ElastixBase::s_NumberOfDataCacheHits = 0;
+
+
+/**
+ * ******************** SetUseDataCache ********************
+ */
+
+void
+ElastixBase::SetUseDataCache( const bool _arg )
+{
+  s_UseDataCache = _arg;
+  if( !_arg )
+  {
+    ClearDataCache();
+  }
+
+} // end SetUseDataCache()
+
+
+/**
+ * ******************** GetUseDataCache ********************
+ */
+
+bool
+ElastixBase::GetUseDataCache( void )
+{
+  return s_UseDataCache;
+
+} // end GetUseDataCache()
+
+
+/**
+ * ******************** GetCachedObject ********************
+ */
+
+ElastixBase::ObjectType *
+ElastixBase::GetCachedObject( const std::string & key )
+{
+  if( !s_UseDataCache )
+  {
+    return 0;
+  }
+
+  DataCacheType::const_iterator it = s_DataCache.find( key );
+  if( it == s_DataCache.end() )
+  {
+    return 0;
+  }
+  ++s_NumberOfDataCacheHits;
+  return it->second.GetPointer();
+
+} // end GetCachedObject()
+
+
+/**
+ * ******************** SetCachedObject ********************
+ */
+
+void
+ElastixBase::SetCachedObject( const std::string & key, ObjectType * object )
+{
+  if( s_UseDataCache )
+  {
+    s_DataCache[ key ] = object;
+  }
+
+} // end SetCachedObject()
+
+
+/**
+ * ******************** GetNumberOfDataCacheHits ********************
+ */
+
+unsigned long
+ElastixBase::GetNumberOfDataCacheHits( void )
+{
+  return s_NumberOfDataCacheHits;
+
+} // end GetNumberOfDataCacheHits()
+
+
+/**
+ * ******************** ClearDataCache ********************
+ */
+
+void
+ElastixBase::ClearDataCache( void )
+{
+  s_DataCache.clear();
+  s_NumberOfDataCacheHits = 0;
+
+} // end ClearDataCache()
+
+
 /**
  * ******************** GetUseDirectionCosines ********************
  */
@@ -41,6 +41,7 @@
 
 #include <fstream>
 #include <iomanip>
+#include <map>
 
 /** Like itkGet/SetObjectMacro, but in these macros the itkDebugMacro is
  * not called. Besides, they are not virtual, since
@@ -97,6 +98,21 @@ namespace elastix
  *   Most importantly, it affects the output precision of the parameters in the transform parameter file.\n
  *   example: <tt>(DefaultOutputPrecision 6)</tt>\n
  *   Default value: 6.
+ * \parameter IterationInfoFlushInterval: The number of iterations after which the
+ *   iteration info is flushed to the log file, the IterationInfo file and the screen.
+ *   Flushing less often saves time for fast iterations, for example when the output
+ *   directory is on a network file system. The rows are still written during the
+ *   iterations, unless UseAsynchronousOutput is set. The iteration info is always flushed
+ *   after each resolution. A value of 0 only flushes after each resolution.\n
+ *   example: <tt>(IterationInfoFlushInterval 100)</tt>\n
+ *   Default value: 1.
+ * \parameter UseAsynchronousOutput: Whether the log file, the screen and the IterationInfo
+ *   files are written by background threads during the registration. A flush then only
+ *   hands the text to the background thread, so slow writes do not delay the iterations.
+ *   The output appears somewhat later, and may be lost if elastix is killed.
+ *   The background threads are stopped after the registration.\n
+ *   example: <tt>(UseAsynchronousOutput "true")</tt>\n
+ *   Default value: "false".
  *
  * The command line arguments used by this class are:
  * \commandlinearg -f: mandatory argument for elastix with the file name of the fixed image. \n
@@ -133,9 +149,21 @@ namespace elastix
  * \commandlinearg -threads: optional argument for both elastix and transformix to
  *    specify the maximum number of threads used by this process. Default: no maximum. \n
  *    example: <tt>-threads 2</tt> \n
+ * \commandlinearg -jobs: optional argument for elastix to run it as a server. Every
+ *    line of the given file ("-" for stdin, or a named pipe) is a job, which gives
+ *    the remaining arguments, for example "-m moving1.mhd -out out1". The fixed image,
+ *    the fixed masks, and data computed from them are kept in memory between jobs. \n
+ *    example: <tt>-jobs jobs.txt</tt> \n
  * \commandlinearg -in: optional argument for transformix with the file name of an input image. \n
  *    example: <tt>-in inputImage.mhd</tt> \n
  *    If this option is skipped, a deformation field of the transform will be generated.
+ * \commandlinearg -batch: optional argument for transformix with the name of a file that
+ *    lists more input images, one per line, each optionally followed by the interpolation
+ *    order (0-5), the result pixel type and the result name. \n
+ *    example: <tt>-batch batch.txt</tt>, with a line <tt>labels.mhd 0 unsigned_char labelsResult</tt> \n
+ *    The transform is read and initialized only once for all images. The defaults are
+ *    the FinalBSplineInterpolationOrder and ResultImagePixelType of the transform
+ *    parameter file, and the name "result.<i>".
  *
  * \ingroup Kernel
  */
@@ -333,6 +361,18 @@ public:
 
   virtual void AfterRegistrationBase( void );
 
+  /** Write the iteration info that is still buffered after each resolution. */
+  virtual void AfterEachResolutionBase( void );
+
+  /** Get whether the output is written by background threads during the
+   * registration, see the UseAsynchronousOutput parameter.
+   */
+  virtual bool GetUseAsynchronousOutput( void ) const
+  {
+    return this->m_UseAsynchronousOutput;
+  }
+
+
   /** Get the default precision of xout.
    * (The value assumed when no DefaultOutputPrecision is given in the
    * parameter file.
@@ -364,6 +404,28 @@ public:
   /** Set configuration vector. Library only. */
   virtual void SetConfigurations( std::vector< ConfigurationPointer > & configurations ) = 0;
 
+  /** Functions for the data cache. When elastix registers several moving
+   * images to the same fixed image in one process (see the -jobs command
+   * line argument), data that only depends on the fixed image, such as the
+   * fixed image pyramid and the eroded fixed masks, is stored in this cache
+   * and reused by the next registrations. The cache is shared by all
+   * ElastixBase objects. It is not used by default; when it is not used,
+   * GetCachedObject returns 0 and SetCachedObject does nothing.
+   */
+  static void SetUseDataCache( const bool _arg );
+
+  static bool GetUseDataCache( void );
+
+  static ObjectType * GetCachedObject( const std::string & key );
+
+  static void SetCachedObject( const std::string & key, ObjectType * object );
+
+  /** Get the number of times an object was found in the data cache. */
+  static unsigned long GetNumberOfDataCacheHits( void );
+
+  /** Remove all objects from the data cache. */
+  static void ClearDataCache( void );
+
 protected:
 
   ElastixBase();
@@ -373,6 +435,13 @@ protected:
   DBIndexType              m_DBIndex;
   ComponentDatabasePointer m_ComponentDatabase;
 
+  /** Start and stop the background threads of the outputs of xout and of
+   * the iteration info that are AsynchronousOutputStreams.
+   */
+  void StartAsynchronousOutput( void );
+
+  void StopAsynchronousOutput( void );
+
   FlatDirectionCosinesType m_OriginalFixedImageDirection;
 
   /** Convenient mini class to load the files specified by a filename container
@@ -507,6 +576,8 @@ private:
 
   int m_DefaultOutputPrecision;
 
+  bool m_UseAsynchronousOutput;
+
   /** The component containers. These containers contain
    * SmartPointer's to itk::Object.
    */
@@ -546,6 +617,12 @@ private:
   /** Use or ignore direction cosines. */
   bool m_UseDirectionCosines;
 
+  /** The data cache. */
+  typedef std::map< std::string, ObjectPointer > DataCacheType;
+  static bool          s_UseDataCache;
+  static DataCacheType s_DataCache;
+  static unsigned long s_NumberOfDataCacheHits;
+
   /** Read a series of command line options that satisfy the following syntax:
    * {-f,-f0} \<filename0\> [-f1 \<filename1\> [ -f2 \<filename2\> ... ] ]
    *
@@ -26,9 +26,12 @@
 
 #include "elxElastixMain.h"
 
+#include "elxAsynchronousOutputStream.h"
 #include "elxMacro.h"
 #include "itkMultiThreader.h"
 
+#include <algorithm> // For std::replace.
+
 #ifdef ELASTIX_USE_OPENCL
 #include "itkOpenCLSetup.h"
 #endif
@@ -56,6 +59,12 @@ xoutsimple_type g_CoutOnlyXout;
 xoutsimple_type g_LogOnlyXout;
 std::ofstream   g_LogFileStream;
 
+/** The log file and std::cout are written through these streams, which
+ * can leave the writing to a background thread, see UseAsynchronousOutput.
+ */
+AsynchronousOutputStream g_AsynchronousLogFileStream;
+AsynchronousOutputStream g_AsynchronousCoutStream;
+
 /**
  * ********************* xoutSetup ******************************
  *
@@ -84,18 +93,20 @@ xoutSetup( const char * logfilename, bool setupLogging, bool setupCout )
   }
 
   /** Set std::cout and the logfile as outputs of xout. */
+  g_AsynchronousLogFileStream.SetDestination( &g_LogFileStream );
+  g_AsynchronousCoutStream.SetDestination( &std::cout );
   if( setupLogging )
   {
-    returndummy |= xout.AddOutput( "log", &g_LogFileStream );
+    returndummy |= xout.AddOutput( "log", &g_AsynchronousLogFileStream );
   }
   if( setupCout )
   {
-    returndummy |= xout.AddOutput( "cout", &std::cout );
+    returndummy |= xout.AddOutput( "cout", &g_AsynchronousCoutStream );
   }
 
   /** Set outputs of LogOnly and CoutOnly. */
-  returndummy |= g_LogOnlyXout.AddOutput( "log", &g_LogFileStream );
-  returndummy |= g_CoutOnlyXout.AddOutput( "cout", &std::cout );
+  returndummy |= g_LogOnlyXout.AddOutput( "log", &g_AsynchronousLogFileStream );
+  returndummy |= g_CoutOnlyXout.AddOutput( "cout", &g_AsynchronousCoutStream );
 
   /** Copy the outputs to the warning-, error- and standard-xouts. */
   g_WarningXout.SetOutputs( xout.GetCOutputs() );
@@ -123,6 +134,32 @@ xoutSetup( const char * logfilename, bool setupLogging, bool setupCout )
 } // end xoutSetup()
 
 
+/**
+ * ********************* xoutSetLogFile ******************************
+ *
+ * NB: this function is a global function, not part of the ElastixMain
+ * class!!
+ */
+
+int
+xoutSetLogFile( const char * logfilename )
+{
+  /** The outputs of xout refer to the stream, so only reopen it. */
+  g_AsynchronousLogFileStream.StopWriterThread();
+  g_LogFileStream.close();
+  g_LogFileStream.clear();
+  g_LogFileStream.open( logfilename );
+  g_AsynchronousLogFileStream.clear();
+  if( !g_LogFileStream.is_open() )
+  {
+    std::cerr << "ERROR: LogFile cannot be opened!" << std::endl;
+    return 1;
+  }
+  return 0;
+
+} // end xoutSetLogFile()
+
+
 /**
  * ********************* Constructor ****************************
  */
@@ -510,8 +547,9 @@ ElastixMain::InitDBIndex( void )
       /** Read it from the fixed image header. */
       try
       {
+        PixelTypeDescriptionType fixedPixelType;
         this->GetImageInformationFromFile( fixedImageFileName,
-          this->m_FixedImageDimension );
+          fixedPixelType, this->m_FixedImageDimension );
       }
       catch( itk::ExceptionObject & err )
       {
@@ -588,8 +626,9 @@ ElastixMain::InitDBIndex( void )
       /** Read it from the moving image header. */
       try
       {
+        PixelTypeDescriptionType movingPixelType;
         this->GetImageInformationFromFile( movingImageFileName,
-          this->m_MovingImageDimension );
+          movingPixelType, this->m_MovingImageDimension );
       }
       catch( itk::ExceptionObject & err )
       {
@@ -648,6 +687,9 @@ ElastixMain::InitDBIndex( void )
 
     if( this->s_CDB.IsNotNull() )
     {
+      /** Replace the "native" internal pixel types by the actual ones. */
+      this->ResolveNativePixelTypes();
+
       /** Get the DBIndex from the ComponentDatabase. */
       this->m_DBIndex = this->s_CDB->GetIndex(
         this->m_FixedImagePixelType,
@@ -660,6 +702,13 @@ ElastixMain::InitDBIndex( void )
         xout[ "error" ] << "Something went wrong in the ComponentDatabase" << std::endl;
         return 1;
       }
+
+      /** Install the components for these image types. */
+      int installReturnCode = this->InstallComponents();
+      if( installReturnCode != 0 )
+      {
+        return installReturnCode;
+      }
     } // end if s_CDB!=0
 
   } // end if m_Configuration->Initialized();
@@ -676,6 +725,101 @@ ElastixMain::InitDBIndex( void )
 } // end InitDBIndex()
 
 
+/**
+ * ********************* ResolveNativePixelTypes ***********************
+ *
+ * Replaces the internal pixel type "native" by the component type of the
+ * image on disk, such that for example short CT data is not converted to
+ * float. If elastix was not compiled for the resulting combination of
+ * image types, "float" is used instead.
+ */
+
+void
+ElastixMain::ResolveNativePixelTypes( void )
+{
+  const bool fixedIsNative  = this->m_FixedImagePixelType == "native";
+  const bool movingIsNative = this->m_MovingImagePixelType == "native";
+  if( !fixedIsNative && !movingIsNative )
+  {
+    return;
+  }
+
+  PixelTypeDescriptionType fixedPixelType  = this->m_FixedImagePixelType;
+  PixelTypeDescriptionType movingPixelType = this->m_MovingImagePixelType;
+
+#ifndef _ELASTIX_BUILD_LIBRARY
+  /** Read the component types from the image headers. */
+  const char * imageArguments[ 2 ][ 2 ] = { { "-f", "-f0" }, { "-m", "-m0" } };
+  for( unsigned int i = 0; i < 2; ++i )
+  {
+    if( ( i == 0 && !fixedIsNative ) || ( i == 1 && !movingIsNative ) )
+    {
+      continue;
+    }
+
+    std::string imageFileName
+      = this->m_Configuration->GetCommandLineArgument( imageArguments[ i ][ 0 ] );
+    if( imageFileName == "" )
+    {
+      imageFileName = this->m_Configuration->GetCommandLineArgument( imageArguments[ i ][ 1 ] );
+    }
+
+    PixelTypeDescriptionType pixelType     = "float";
+    ImageDimensionType       dummyDimension = 0;
+    try
+    {
+      this->GetImageInformationFromFile( imageFileName, pixelType, dummyDimension );
+    }
+    catch( itk::ExceptionObject & err )
+    {
+      xout[ "warning" ] << "WARNING: could not read the pixel type of "
+                        << imageFileName << "\n" << err << std::endl;
+      pixelType = "float";
+    }
+    if( i == 0 )
+    {
+      fixedPixelType = pixelType;
+    }
+    else
+    {
+      movingPixelType = pixelType;
+    }
+  }
+#else
+  /** The images are passed in memory; their pixel type is not known here. */
+  if( fixedIsNative )
+  {
+    fixedPixelType = "float";
+  }
+  if( movingIsNative )
+  {
+    movingPixelType = "float";
+  }
+#endif
+
+  /** Fall back to float if this combination of image types is not compiled in. */
+  if( !this->s_CDB->HasIndex( fixedPixelType, this->m_FixedImageDimension,
+    movingPixelType, this->m_MovingImageDimension ) )
+  {
+    xout[ "warning" ] << "WARNING: elastix was not compiled for the native pixel types ("
+                      << fixedPixelType << ", " << movingPixelType
+                      << ") of the images; \"float\" is used instead." << std::endl;
+    if( fixedIsNative )
+    {
+      fixedPixelType = "float";
+    }
+    if( movingIsNative )
+    {
+      movingPixelType = "float";
+    }
+  }
+
+  this->m_FixedImagePixelType  = fixedPixelType;
+  this->m_MovingImagePixelType = movingPixelType;
+
+} // end ResolveNativePixelTypes()
+
+
 /**
  * ********************* SetElastixLevel ************************
  */
@@ -761,6 +905,27 @@ ElastixMain::LoadComponents( void )
 } // end LoadComponents()
 
 
+/**
+ * ********************* InstallComponents **************************
+ *
+ * Store the New() functions of the components for the image types
+ * of m_DBIndex in the component database, if not done before.
+ */
+
+int
+ElastixMain::InstallComponents( void )
+{
+  /** A component database that was set from outside is assumed to be complete. */
+  if( this->s_ComponentLoader.IsNull() )
+  {
+    return 0;
+  }
+
+  return this->s_ComponentLoader->InstallComponents( this->m_DBIndex );
+
+} // end InstallComponents()
+
+
 /**
  * ********************* UnloadComponents **************************
  */
@@ -1030,6 +1195,7 @@ ElastixMain::GetTransformParametersMap( void ) const
 void
 ElastixMain::GetImageInformationFromFile(
   const std::string & filename,
+  PixelTypeDescriptionType & pixelType,
   ImageDimensionType & imageDimension ) const
 {
   if( filename != "" )
@@ -1049,8 +1215,6 @@ ElastixMain::GetImageInformationFromFile(
 
     /** Extract the required information. */
     itk::SmartPointer<const itk::ImageIOBase> testImageIO = testReader->GetImageIO();
-    //itk::ImageIOBase::IOComponentType componentType = testImageIO->GetComponentType();
-    //pixelType = itk::ImageIOBase::GetComponentTypeAsString( componentType );
     if( testImageIO.IsNull() )
     {
       /** Extra check. In principal, ITK the testreader should already have thrown an exception
@@ -1058,6 +1222,10 @@ ElastixMain::GetImageInformationFromFile(
       itkExceptionMacro( << "ERROR: ImageIO object was not created, but no exception was thrown." );
     }
     imageDimension = testImageIO->GetNumberOfDimensions();
+
+    /** ITK describes for example unsigned short as "unsigned_short". */
+    pixelType = itk::ImageIOBase::GetComponentTypeAsString( testImageIO->GetComponentType() );
+    std::replace( pixelType.begin(), pixelType.end(), '_', ' ' );
   } // end if
 
 } // end GetImageInformationFromFile()
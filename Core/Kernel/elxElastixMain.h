@@ -54,6 +54,15 @@ namespace elastix
  */
 extern int xoutSetup( const char * logfilename, bool setupLogging, bool setupCout );
 
+/**
+ * function xoutSetLogFile
+ * Close the logfile that was opened by xoutSetup, and continue logging
+ * to another logfile. Used when one process runs several registrations.
+ *
+ * It returns 0 if everything went ok. 1 otherwise.
+ */
+extern int xoutSetLogFile( const char * logfilename );
+
 /**
  * \class ElastixMain
  * \brief A class with all functionality to configure elastix.
@@ -69,11 +78,16 @@ extern int xoutSetup( const char * logfilename, bool setupLogging, bool setupCou
  * \parameter FixedInternalImagePixelType: the pixel type of the internal
  * fixed image representation. The fixed image is automatically converted
  * to this type.\n
+ * Choose "native" to keep the pixel type of the fixed image on disk, for
+ * example short for CT data, which halves the memory of the image and its
+ * pyramid compared to float. The interpolators convert to real values.
+ * If elastix was not compiled for the native type, "float" is used.\n
  * example: <tt>(FixedInternalImagePixelType "float")</tt>\n
  * Default/recommended: "float"\n
  * \parameter MovingInternalImagePixelType: the pixel type of the internal
  * moving image representation. The moving image is automatically converted
- * to this type.\n
+ * to this type. Choose "native" to keep the pixel type of the moving image
+ * on disk, see FixedInternalImagePixelType.\n
  * example: <tt>(MovingInternalImagePixelType "float")</tt>\n
  * Default/recommended: "float"\n
  *
@@ -344,6 +358,9 @@ protected:
   static ComponentLoaderPointer   s_ComponentLoader;
   virtual int LoadComponents( void );
 
+  /** Install the components for the image types of m_DBIndex, on first use. */
+  virtual int InstallComponents( void );
+
   /** InitDBIndex sets m_DBIndex by asking the ImageTypes
    * from the Configuration object and obtaining the corresponding
    * DB index from the ComponentDatabase.
@@ -378,8 +395,12 @@ protected:
 
   /** Helper function to obtain information from images on disk. */
   void GetImageInformationFromFile( const std::string & filename,
+    PixelTypeDescriptionType & pixelType,
     ImageDimensionType & imageDimension ) const;
 
+  /** Replace the internal pixel type "native" by the pixel type of the images. */
+  void ResolveNativePixelTypes( void );
+
 private:
 
   ElastixMain( const Self & );     // purposely not implemented
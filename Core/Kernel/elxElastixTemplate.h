@@ -19,6 +19,8 @@
 #define __elxElastixTemplate_h
 
 #include "elxElastixBase.h"
+#include "elxAsynchronousOutputStream.h"
+#include "elxBinaryIterationInfoStream.h"
 #include "itkObject.h"
 
 #include "itkObjectFactory.h"
@@ -42,6 +44,7 @@
 
 #include <sstream>
 #include <fstream>
+#include <map>
 
 /**
  * Macro that defines to functions. In the case of
@@ -94,6 +97,13 @@ namespace elastix
  *    example: <tt>(WriteTransformParametersEachResolution "true")</tt>\n
  *    This parameter can not be specified for each resolution separately.
  *    Default value: "false".
+ * \parameter IterationInfoFileFormat: The format of the IterationInfo files, "text"
+ *    or "binary". The text format writes the table of the screen to
+ *    IterationInfo.<ElastixLevel>.R<Resolution>.txt. The binary format writes it
+ *    compactly to IterationInfo.<ElastixLevel>.R<Resolution>.bin, with a double
+ *    per cell, see BinaryIterationInfoStream.\n
+ *    example: <tt>(IterationInfoFileFormat "binary")</tt>\n
+ *    Default value: "text".
  * \parameter UseDirectionCosines: Controls whether to use or ignore the
  * direction cosines (world matrix, transform matrix) set in the images.
  * Voxel spacing and image origin are always taken into account, regardless
@@ -381,7 +391,13 @@ protected:
   /** Open the IterationInfoFile, where the table with iteration info is written to. */
   virtual void OpenIterationInfoFile( void );
 
-  std::ofstream m_IterationInfoFile;
+  /** The IterationInfo file, and the streams through which it is written.
+   * The asynchronous stream is declared last, so that it writes its
+   * remaining text before the other streams are destroyed.
+   */
+  std::ofstream             m_IterationInfoFile;
+  BinaryIterationInfoStream m_BinaryIterationInfoFile;
+  AsynchronousOutputStream  m_AsynchronousIterationInfoFile;
 
   /** Used by the callback functions, BeforeEachResolution() etc.).
    * This method calls a function in each component, in the following order:
@@ -409,6 +425,15 @@ protected:
   /** Set the direction in the superclass' m_OriginalFixedImageDirection variable */
   virtual void SetOriginalFixedImageDirection( const FixedImageDirectionType & arg );
 
+  /** Apply the transform to all images in the batch file of transformix.
+   * Every line of this file gives an input image, and optionally the
+   * interpolation order, the result pixel type and the result name:
+   * <tt>labels.mhd 0 unsigned_char labelsResult</tt>. All images are
+   * resampled with the same transform and resampler. Returns the number
+   * of images that could not be resampled.
+   */
+  virtual int ApplyTransformToBatch( const std::string & batchFileName );
+
 private:
 
   ElastixTemplate( const Self & ); // purposely not implemented
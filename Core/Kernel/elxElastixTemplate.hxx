@@ -320,6 +320,7 @@ ElastixTemplate< TFixedImage, TMovingImage >
     /** Clean up before returning - very important for exception safety of the xout global static object */
     if( xoutlibrary::xout_valid() )
     {
+      this->StopAsynchronousOutput();
       xoutlibrary::xout.RemoveTargetCell("iteration");
     }
 
@@ -515,12 +516,162 @@ ElastixTemplate< TFixedImage, TMovingImage >
            << this->ConvertSecondsToDHMS( timer.GetMean(), 2 ) << std::endl;
   }
 
+  /** Resample the images of the batch file, if given. */
+#ifndef _ELASTIX_BUILD_LIBRARY
+  const std::string batchFileName
+    = this->GetConfiguration()->GetCommandLineArgument( "-batch" );
+  if( !batchFileName.empty() )
+  {
+    timer.Reset();
+    timer.Start();
+    elxout << "Resampling the images of the batch file and writing to disk ..." << std::endl;
+    const int numberOfFailures = this->ApplyTransformToBatch( batchFileName );
+    timer.Stop();
+    elxout << "  Resampling the batch took "
+           << this->ConvertSecondsToDHMS( timer.GetMean(), 2 ) << std::endl;
+    if( numberOfFailures != 0 )
+    {
+      xout[ "error" ] << "ERROR: " << numberOfFailures
+                      << " image(s) of the batch file could not be resampled." << std::endl;
+      return 1;
+    }
+  }
+#endif
+
   /** Return a value. */
   return 0;
 
 } // end ApplyTransform()
 
 
+/**
+ * ********************* ApplyTransformToBatch ******************
+ */
+
+template< class TFixedImage, class TMovingImage >
+int
+ElastixTemplate< TFixedImage, TMovingImage >
+::ApplyTransformToBatch( const std::string & batchFileName )
+{
+  std::ifstream batchFile( batchFileName.c_str() );
+  if( !batchFile.is_open() )
+  {
+    xout[ "error" ] << "ERROR: the batch file \"" << batchFileName
+                    << "\" could not be opened." << std::endl;
+    return 1;
+  }
+
+  /** The defaults are taken from the transform parameter file. */
+  std::string resultImageFormat = "mhd";
+  this->GetConfiguration()->ReadParameter( resultImageFormat,
+    "ResultImageFormat", 0, false );
+  std::string defaultPixelType = "short";
+  this->GetConfiguration()->ReadParameter( defaultPixelType,
+    "ResultImagePixelType", 0, false );
+  unsigned int defaultSplineOrder = 3;
+  this->GetConfiguration()->ReadParameter( defaultSplineOrder,
+    "FinalBSplineInterpolationOrder", 0, false );
+
+  /** The interpolators are shared by images with the same order. */
+  typedef typename ResamplerBaseType::InterpolatorType InterpolatorType;
+  std::map< unsigned int, typename InterpolatorType::Pointer > interpolators;
+
+  int          numberOfFailures = 0;
+  unsigned int imageNumber      = 0;
+  std::string  line;
+  while( std::getline( batchFile, line ) )
+  {
+    /** Split the line in fields; skip empty lines and comments. */
+    std::istringstream         lineStream( line );
+    std::vector< std::string > fields;
+    std::string                field;
+    while( lineStream >> field )
+    {
+      fields.push_back( field );
+    }
+    if( fields.empty() || fields[ 0 ][ 0 ] == '#' )
+    {
+      continue;
+    }
+
+    unsigned int splineOrder = defaultSplineOrder;
+    std::string  pixelType   = fields.size() > 2 ? fields[ 2 ] : defaultPixelType;
+    std::ostringstream resultName( "" );
+    if( fields.size() > 3 )
+    {
+      resultName << fields[ 3 ];
+    }
+    else
+    {
+      resultName << "result." << imageNumber;
+    }
+    ++imageNumber;
+
+    bool validLine = fields.size() <= 4;
+    if( fields.size() > 1 )
+    {
+      std::istringstream orderStream( fields[ 1 ] );
+      validLine &= ( orderStream >> splineOrder ) && orderStream.eof() && splineOrder <= 5;
+    }
+    if( !validLine )
+    {
+      xout[ "error" ] << "ERROR: invalid line in the batch file: \"" << line << "\"\n"
+                      << "  Expected: <input image> [<interpolation order 0-5>] "
+                      << "[<result pixel type>] [<result name>]" << std::endl;
+      ++numberOfFailures;
+      continue;
+    }
+
+    const std::string resultFileName
+      = this->GetConfiguration()->GetCommandLineArgument( "-out" )
+      + resultName.str() + "." + resultImageFormat;
+
+    TimerType timer;
+    timer.Start();
+    try
+    {
+      /** Read the image. */
+      FileNameContainerPointer fileNames = FileNameContainerType::New();
+      fileNames->CreateElementAt( 0 ) = fields[ 0 ];
+      DataObjectContainerPointer images = MovingImageLoaderType::GenerateImageContainer(
+        fileNames, "Batch Image", this->GetUseDirectionCosines() );
+      MovingImageType * image
+        = dynamic_cast< MovingImageType * >( images->ElementAt( 0 ).GetPointer() );
+      if( image == 0 )
+      {
+        xout[ "error" ] << "ERROR: the image \"" << fields[ 0 ]
+                        << "\" of the batch file could not be read as a moving image."
+                        << std::endl;
+        ++numberOfFailures;
+        continue;
+      }
+
+      /** Resample and write it. */
+      if( interpolators.count( splineOrder ) == 0 )
+      {
+        interpolators[ splineOrder ] = ResamplerBaseType::CreateInterpolator( splineOrder );
+      }
+      this->GetElxResamplerBase()->ResampleAndWriteResultImage(
+        image, interpolators[ splineOrder ], pixelType, resultFileName.c_str(), false );
+    }
+    catch( itk::ExceptionObject & excp )
+    {
+      xout[ "error" ] << excp << std::endl;
+      ++numberOfFailures;
+      continue;
+    }
+    timer.Stop();
+
+    elxout << "  Resampling \"" << fields[ 0 ] << "\" with interpolation order "
+           << splineOrder << " to \"" << resultFileName << "\" took "
+           << this->ConvertSecondsToDHMS( timer.GetMean(), 2 ) << std::endl;
+  }
+
+  return numberOfFailures;
+
+} // end ApplyTransformToBatch()
+
+
 /**
  * ************************ BeforeAll ***************************
  */
@@ -818,6 +969,15 @@ ElastixTemplate< TFixedImage, TMovingImage >
   /** Count the number of iterations. */
   this->m_IterationCounter++;
 
+  /** Stop this resolution if the optimizer detected convergence. This is
+   * done after the iteration info is written, so that the last row of the
+   * iteration info is the iteration at which the optimizer stopped.
+   */
+  if( this->GetElxOptimizerBase()->GetConvergenceDetected() )
+  {
+    this->GetElxOptimizerBase()->StopOptimizationAtConvergence();
+  }
+
   /** Start timer for next iteration. */
   this->m_IterationTimer.Reset();
   this->m_IterationTimer.Start();
@@ -1190,31 +1350,66 @@ ElastixTemplate< TFixedImage, TMovingImage >
 
   /** Remove the current iteration info output file, if any. */
   xout[ "iteration" ].RemoveOutput( "IterationInfoFile" );
+  this->m_AsynchronousIterationInfoFile.StopWriterThread();
 
   if( this->m_IterationInfoFile.is_open() )
   {
     this->m_IterationInfoFile.close();
   }
 
+  /** Read the format of the IterationInfo file. */
+  std::string format = "text";
+  this->m_Configuration->ReadParameter( format, "IterationInfoFileFormat", 0, false );
+  const bool binary = ( format == "binary" );
+  if( !binary && format != "text" )
+  {
+    xout[ "warning" ] << "WARNING: IterationInfoFileFormat \"" << format
+                      << "\" is not supported; \"text\" is used instead." << std::endl;
+  }
+
   /** Create the IterationInfo filename for this resolution. */
   std::ostringstream makeFileName( "" );
   makeFileName << this->m_Configuration->GetCommandLineArgument( "-out" )
                << "IterationInfo."
                << this->m_Configuration->GetElastixLevel()
                << ".R" << this->GetElxRegistrationBase()->GetAsITKBaseType()->GetCurrentLevel()
-               << ".txt";
+               << ( binary ? ".bin" : ".txt" );
   std::string fileName = makeFileName.str();
 
   /** Open the IterationInfoFile. */
-  this->m_IterationInfoFile.open( fileName.c_str() );
+  std::ios_base::openmode mode = std::ios_base::out;
+  if( binary )
+  {
+    mode |= std::ios_base::binary;
+  }
+  this->m_IterationInfoFile.clear();
+  this->m_IterationInfoFile.open( fileName.c_str(), mode );
   if( !( this->m_IterationInfoFile.is_open() ) )
   {
     xout[ "error" ] << "ERROR: File \"" << fileName << "\" could not be opened!" << std::endl;
   }
   else
   {
+    /** The table is written through the asynchronous stream, which writes
+     * it to the file directly, or in a background thread. In the binary
+     * format, that thread also converts the text to binary.
+     */
+    if( binary )
+    {
+      this->m_BinaryIterationInfoFile.SetDestination( &this->m_IterationInfoFile );
+      this->m_AsynchronousIterationInfoFile.SetDestination( &this->m_BinaryIterationInfoFile );
+    }
+    else
+    {
+      this->m_AsynchronousIterationInfoFile.SetDestination( &this->m_IterationInfoFile );
+    }
+    if( this->GetUseAsynchronousOutput() )
+    {
+      this->m_AsynchronousIterationInfoFile.StartWriterThread();
+    }
+
     /** Add this file to the list of outputs of xout["iteration"]. */
-    xout[ "iteration" ].AddOutput( "IterationInfoFile", &( this->m_IterationInfoFile ) );
+    xout[ "iteration" ].AddOutput( "IterationInfoFile", &( this->m_AsynchronousIterationInfoFile ) );
   }
 
 } // end OpenIterationInfoFile()
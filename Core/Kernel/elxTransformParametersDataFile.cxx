@@ -0,0 +1,353 @@
+/*=========================================================================
+ *
+ *  Copyright UMC Utrecht and contributors
+ *
+ *  Licensed under the Apache License, Version 2.0 (the "License");
+ *  you may not use this file except in compliance with the License.
+ *  You may obtain a copy of the License at
+ *
+ *        http://www.apache.org/licenses/LICENSE-2.0.txt
+ *
+ *  Unless required by applicable law or agreed to in writing, software
+ *  distributed under the License is distributed on an "AS IS" BASIS,
+ *  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *  See the License for the specific language governing permissions and
+ *  limitations under the License.
+ *
+ *=========================================================================*/
+#include "elxTransformParametersDataFile.h"
+
+#include <itksys/SystemTools.hxx>
+#include <cstring>
+#include <fstream>
+#include <sstream>
+
+#ifdef _WIN32
+#ifndef NOMINMAX
+#define NOMINMAX
+#endif
+#include <windows.h>
+#else
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+namespace elastix
+{
+
+namespace
+{
+
+/** The header of a data file. Its size is a multiple of 32 bytes, so that
+ * the values that follow are aligned for vectorized access.
+ */
+struct DataFileHeader
+{
+  char         Magic[ 8 ];
+  unsigned int Version;
+  unsigned int ValueSize;
+  unsigned int ByteOrderMark;
+  unsigned int Reserved;
+  char         NumberOfValues[ 8 ]; // 64 bit unsigned integer
+};
+
+const char         DataFileMagic[ 8 ]  = { 'E', 'L', 'X', 'T', 'P', 'A', 'R', '\0' };
+const unsigned int DataFileVersion     = 1;
+const unsigned int DataFileByteOrder   = 0x01020304;
+const std::size_t  DataFileHeaderSize  = 32;
+
+} // end namespace
+
+
+/**
+ * ******************* Constructor *******************
+ */
+
+TransformParametersDataFile
+::TransformParametersDataFile()
+{
+  this->m_MappedData     = 0;
+  this->m_MappedSize     = 0;
+  this->m_Values         = 0;
+  this->m_NumberOfValues = 0;
+#ifdef _WIN32
+  this->m_FileHandle    = INVALID_HANDLE_VALUE;
+  this->m_MappingHandle = 0;
+#endif
+
+} // end Constructor
+
+
+/**
+ * ******************* Destructor *******************
+ */
+
+TransformParametersDataFile
+::~TransformParametersDataFile()
+{
+  this->Unmap();
+
+} // end Destructor
+
+
+/**
+ * ******************* Write *******************
+ */
+
+bool
+TransformParametersDataFile
+::Write( const std::string & fileName,
+  const ValueType * values, const std::size_t numberOfValues,
+  std::string & errorMessage )
+{
+  /** Fill the header. */
+  char           headerBuffer[ DataFileHeaderSize ];
+  DataFileHeader header;
+  std::memset( headerBuffer, 0, DataFileHeaderSize );
+  std::memset( &header, 0, sizeof( DataFileHeader ) );
+  std::memcpy( header.Magic, DataFileMagic, sizeof( DataFileMagic ) );
+  header.Version       = DataFileVersion;
+  header.ValueSize     = sizeof( ValueType );
+  header.ByteOrderMark = DataFileByteOrder;
+  const unsigned long long n = numberOfValues;
+  std::memcpy( header.NumberOfValues, &n, sizeof( n ) );
+  std::memcpy( headerBuffer, &header, sizeof( DataFileHeader ) );
+
+  /** Write the header and the values in one go. */
+  std::ofstream outfile( fileName.c_str(), std::ios::out | std::ios::binary );
+  if( !outfile.is_open() )
+  {
+    errorMessage = "ERROR: the transform parameter data file \""
+      + fileName + "\" could not be opened for writing.";
+    return false;
+  }
+  outfile.write( headerBuffer, DataFileHeaderSize );
+  outfile.write( reinterpret_cast< const char * >( values ),
+    sizeof( ValueType ) * numberOfValues );
+  outfile.close();
+
+  if( outfile.fail() )
+  {
+    errorMessage = "ERROR: writing the transform parameter data file \""
+      + fileName + "\" failed.";
+    return false;
+  }
+  return true;
+
+} // end Write()
+
+
+/**
+ * ******************* Map *******************
+ */
+
+bool
+TransformParametersDataFile
+::Map( const std::string & fileName, std::string & errorMessage )
+{
+  this->Unmap();
+
+  /** Map the complete file. */
+#ifdef _WIN32
+  HANDLE file = CreateFileA( fileName.c_str(), GENERIC_READ, FILE_SHARE_READ,
+    0, OPEN_EXISTING, FILE_ATTRIBUTE_NORMAL | FILE_FLAG_SEQUENTIAL_SCAN, 0 );
+  if( file == INVALID_HANDLE_VALUE )
+  {
+    errorMessage = "ERROR: the transform parameter data file \"" + fileName + "\" could not be opened.";
+    return false;
+  }
+  this->m_FileHandle = file;
+
+  LARGE_INTEGER fileSize;
+  if( !GetFileSizeEx( file, &fileSize ) )
+  {
+    this->Unmap();
+    errorMessage = "ERROR: the size of the transform parameter data file \"" + fileName + "\" is unknown.";
+    return false;
+  }
+  this->m_MappedSize = static_cast< std::size_t >( fileSize.QuadPart );
+
+  if( this->m_MappedSize > 0 )
+  {
+    this->m_MappingHandle = CreateFileMappingA( file, 0, PAGE_WRITECOPY, 0, 0, 0 );
+    if( this->m_MappingHandle != 0 )
+    {
+      this->m_MappedData = MapViewOfFile( this->m_MappingHandle, FILE_MAP_COPY, 0, 0, 0 );
+    }
+    if( this->m_MappedData == 0 )
+    {
+      this->Unmap();
+      errorMessage = "ERROR: the transform parameter data file \"" + fileName + "\" could not be mapped.";
+      return false;
+    }
+  }
+#else
+  const int file = open( fileName.c_str(), O_RDONLY );
+  if( file < 0 )
+  {
+    errorMessage = "ERROR: the transform parameter data file \"" + fileName + "\" could not be opened.";
+    return false;
+  }
+
+  struct stat fileStatus;
+  if( fstat( file, &fileStatus ) != 0 )
+  {
+    close( file );
+    errorMessage = "ERROR: the size of the transform parameter data file \"" + fileName + "\" is unknown.";
+    return false;
+  }
+  this->m_MappedSize = static_cast< std::size_t >( fileStatus.st_size );
+
+  if( this->m_MappedSize > 0 )
+  {
+    void * data = mmap( 0, this->m_MappedSize, PROT_READ | PROT_WRITE, MAP_PRIVATE, file, 0 );
+    if( data == MAP_FAILED )
+    {
+      close( file );
+      this->m_MappedSize = 0;
+      errorMessage = "ERROR: the transform parameter data file \"" + fileName + "\" could not be mapped.";
+      return false;
+    }
+    this->m_MappedData = data;
+  }
+
+  /** The mapping stays valid after closing the file. */
+  close( file );
+#endif
+
+  /** Interpret the header, if any. */
+  char * bytes = static_cast< char * >( this->m_MappedData );
+  if( this->m_MappedSize >= DataFileHeaderSize
+    && std::memcmp( bytes, DataFileMagic, sizeof( DataFileMagic ) ) == 0 )
+  {
+    DataFileHeader header;
+    std::memcpy( &header, bytes, sizeof( DataFileHeader ) );
+    unsigned long long n = 0;
+    std::memcpy( &n, header.NumberOfValues, sizeof( n ) );
+
+    std::ostringstream problem( "" );
+    if( header.ByteOrderMark != DataFileByteOrder )
+    {
+      problem << "it was written on a machine with a different byte order.";
+    }
+    else if( header.Version > DataFileVersion )
+    {
+      problem << "it has version " << header.Version
+              << ", which is newer than this version of elastix supports.";
+    }
+    else if( header.ValueSize != sizeof( ValueType ) )
+    {
+      problem << "it stores values of " << header.ValueSize
+              << " bytes, instead of " << sizeof( ValueType ) << ".";
+    }
+    else if( ( this->m_MappedSize - DataFileHeaderSize ) / sizeof( ValueType ) < n )
+    {
+      problem << "it should contain " << n << " values, but the file is truncated.";
+    }
+    if( !problem.str().empty() )
+    {
+      this->Unmap();
+      errorMessage = "ERROR: the transform parameter data file \"" + fileName
+        + "\" cannot be read, since " + problem.str();
+      return false;
+    }
+
+    this->m_Values         = reinterpret_cast< ValueType * >( bytes + DataFileHeaderSize );
+    this->m_NumberOfValues = static_cast< std::size_t >( n );
+  }
+  else
+  {
+    /** A plain array of values, as written by older versions. */
+    this->m_Values         = reinterpret_cast< ValueType * >( bytes );
+    this->m_NumberOfValues = this->m_MappedSize / sizeof( ValueType );
+  }
+
+  return true;
+
+} // end Map()
+
+
+/**
+ * ******************* Unmap *******************
+ */
+
+void
+TransformParametersDataFile
+::Unmap( void )
+{
+#ifdef _WIN32
+  if( this->m_MappedData )
+  {
+    UnmapViewOfFile( this->m_MappedData );
+  }
+  if( this->m_MappingHandle )
+  {
+    CloseHandle( this->m_MappingHandle );
+  }
+  if( this->m_FileHandle != INVALID_HANDLE_VALUE )
+  {
+    CloseHandle( this->m_FileHandle );
+  }
+  this->m_MappingHandle = 0;
+  this->m_FileHandle    = INVALID_HANDLE_VALUE;
+#else
+  if( this->m_MappedData )
+  {
+    munmap( this->m_MappedData, this->m_MappedSize );
+  }
+#endif
+
+  this->m_MappedData     = 0;
+  this->m_MappedSize     = 0;
+  this->m_Values         = 0;
+  this->m_NumberOfValues = 0;
+
+} // end Unmap()
+
+
+/**
+ * ******************* FindDataFile *******************
+ */
+
+std::string
+TransformParametersDataFile
+::FindDataFile( const std::string & dataFileName,
+  const std::string & transformParameterFileName )
+{
+  if( !itksys::SystemTools::FileIsFullPath( dataFileName.c_str() )
+    && !transformParameterFileName.empty() )
+  {
+    const std::string directory = itksys::SystemTools::GetFilenamePath( transformParameterFileName );
+    if( !directory.empty() )
+    {
+      const std::string nextToParameterFile = directory + "/" + dataFileName;
+      if( itksys::SystemTools::FileExists( nextToParameterFile.c_str(), true ) )
+      {
+        return nextToParameterFile;
+      }
+    }
+  }
+  return dataFileName;
+
+} // end FindDataFile()
+
+
+/**
+ * ******************* PrintSelf *******************
+ */
+
+void
+TransformParametersDataFile
+::PrintSelf( std::ostream & os, itk::Indent indent ) const
+{
+  Superclass::PrintSelf( os, indent );
+
+  os << indent << "MappedSize: " << this->m_MappedSize << std::endl;
+  os << indent << "NumberOfValues: " << this->m_NumberOfValues << std::endl;
+
+} // end PrintSelf()
+
+
+} // end namespace elastix
@@ -0,0 +1,127 @@
+/*=========================================================================
+ *
+ *  Copyright UMC Utrecht and contributors
+ *
+ *  Licensed under the Apache License, Version 2.0 (the "License");
+ *  you may not use this file except in compliance with the License.
+ *  You may obtain a copy of the License at
+ *
+ *        http://www.apache.org/licenses/LICENSE-2.0.txt
+ *
+ *  Unless required by applicable law or agreed to in writing, software
+ *  distributed under the License is distributed on an "AS IS" BASIS,
+ *  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *  See the License for the specific language governing permissions and
+ *  limitations under the License.
+ *
+ *=========================================================================*/
+#ifndef __elxTransformParametersDataFile_h
+#define __elxTransformParametersDataFile_h
+
+#include "itkObject.h"
+#include "itkObjectFactory.h"
+
+#include <string>
+#include <cstddef>
+
+namespace elastix
+{
+
+/**
+ * \class TransformParametersDataFile
+ * \brief Binary sidecar file for the parameters of a transform.
+ *
+ * When UseBinaryFormatForTransformationParameters is set, the parameter
+ * vector of a transform is not written as text to the transform parameter
+ * file, but to a separate binary data file, which is referenced from the
+ * text file. This class writes and reads such data files.
+ *
+ * The file starts with a small header, which stores the magic string
+ * "ELXTPAR", a format version, the size of one value, a byte order mark and
+ * the number of values. The values follow directly, aligned at 32 bytes.
+ * Files without this header, as written by older versions of elastix,
+ * are read as a plain array of values.
+ *
+ * Reading maps the file in memory, copy-on-write, so that the parameters
+ * can be used without copying or parsing them. Pages are only loaded when
+ * they are touched, and changing the values does not change the file.
+ * The mapping stays valid until Unmap() is called, or this object is
+ * destroyed.
+ */
+
+class TransformParametersDataFile : public itk::Object
+{
+public:
+
+  /** Standard ITK stuff. */
+  typedef TransformParametersDataFile     Self;
+  typedef itk::Object                     Superclass;
+  typedef itk::SmartPointer< Self >       Pointer;
+  typedef itk::SmartPointer< const Self > ConstPointer;
+
+  /** Method for creation through the object factory. */
+  itkNewMacro( Self );
+
+  /** Run-time type information (and related methods). */
+  itkTypeMacro( TransformParametersDataFile, itk::Object );
+
+  /** The type of the values in the file. */
+  typedef double ValueType;
+
+  /** Write numberOfValues values to a data file. Returns false and sets
+   * the errorMessage if the file could not be written.
+   */
+  static bool Write( const std::string & fileName,
+    const ValueType * values, const std::size_t numberOfValues,
+    std::string & errorMessage );
+
+  /** Map a data file in memory. Returns false and sets the errorMessage
+   * if the file could not be opened, or is not a valid data file.
+   */
+  bool Map( const std::string & fileName, std::string & errorMessage );
+
+  /** Release the mapping. */
+  void Unmap( void );
+
+  /** Get a pointer to the mapped values. The values may be changed;
+   * that does not affect the file.
+   */
+  ValueType * GetValues( void ) const { return this->m_Values; }
+
+  /** Get the number of mapped values. */
+  std::size_t GetNumberOfValues( void ) const { return this->m_NumberOfValues; }
+
+  /** Find the data file that is referenced from a transform parameter file.
+   * A relative file name is first looked up next to the transform parameter
+   * file, and then relative to the current directory.
+   */
+  static std::string FindDataFile( const std::string & dataFileName,
+    const std::string & transformParameterFileName );
+
+protected:
+
+  TransformParametersDataFile();
+  virtual ~TransformParametersDataFile();
+
+  void PrintSelf( std::ostream & os, itk::Indent indent ) const;
+
+private:
+
+  TransformParametersDataFile( const Self & ); // purposely not implemented
+  void operator=( const Self & );              // purposely not implemented
+
+  void *      m_MappedData;
+  std::size_t m_MappedSize;
+  ValueType * m_Values;
+  std::size_t m_NumberOfValues;
+
+#ifdef _WIN32
+  void * m_FileHandle;
+  void * m_MappingHandle;
+#endif
+
+};
+
+} // end namespace elastix
+
+#endif // end #ifndef __elxTransformParametersDataFile_h
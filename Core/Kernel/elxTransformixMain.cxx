@@ -310,6 +310,13 @@ TransformixMain::InitDBIndex( void )
         xl::xout[ "error" ] << "Something went wrong in the ComponentDatabase." << std::endl;
         return 1;
       }
+
+      /** Install the components for these image types. */
+      int installReturnCode = this->InstallComponents();
+      if( installReturnCode != 0 )
+      {
+        return installReturnCode;
+      }
     } //end if s_CDB!=0
 
   } // end if m_Configuration->Initialized();
@@ -19,6 +19,8 @@
 #include "elastix.h"
 #include "elxElastixMain.h"
 
+#include <fstream>
+
 int
 main( int argc, char ** argv )
 {
@@ -113,19 +115,7 @@ main( int argc, char ** argv )
       if( key == "-out" )
       {
         /** Make sure that last character of the output folder equals a '/' or '\'. */
-        const char last = value[ value.size() - 1 ];
-        if( last != '/' && last != '\\' ) { value.append( "/" ); }
-        value = itksys::SystemTools::ConvertToOutputPath( value.c_str() );
-
-        /** Note that on Windows, in case the output folder contains a space,
-         * the path name is double quoted by ConvertToOutputPath, which is undesirable.
-         * So, we remove these quotes again.
-         */
-        if( itksys::SystemTools::StringStartsWith( value.c_str(), "\"" )
-          && itksys::SystemTools::StringEndsWith(   value.c_str(), "\"" ) )
-        {
-          value = value.substr( 1, value.length() - 2 );
-        }
+        value = ConvertToOutputFolder( value );
 
         /** Save this information. */
         outFolderPresent = true;
@@ -160,6 +150,30 @@ main( int argc, char ** argv )
     returndummy |= -1;
   }
 
+  /** Check if the -jobs option is given. In that case elastix runs as a
+   * server: it runs a registration for every line of the job file, and
+   * keeps the fixed image, the fixed masks and the data that is computed
+   * from them in memory between these registrations.
+   */
+  const bool     serverMode = argMap.count( "-jobs" ) > 0;
+  std::ifstream  jobFile;
+  std::istream * jobStream = &std::cin;
+  if( serverMode )
+  {
+    const std::string jobFileName = argMap[ "-jobs" ];
+    argMap.erase( "-jobs" );
+    if( jobFileName != "-" )
+    {
+      jobFile.open( jobFileName.c_str() );
+      if( !jobFile.is_open() )
+      {
+        std::cerr << "ERROR: the job file \"" << jobFileName << "\" could not be opened." << std::endl;
+        returndummy |= -3;
+      }
+      jobStream = &jobFile;
+    }
+  }
+
   /** Check if the -out option is given. */
   if( outFolderPresent )
   {
@@ -217,86 +231,210 @@ main( int argc, char ** argv )
          << static_cast< unsigned int >( info.GetProcessorClockFrequency() )
          << " MHz." << std::endl;
 
-  /**
-   * ********************* START REGISTRATION *********************
-   *
-   * Do the (possibly multiple) registration(s).
-   */
+  /** In server mode, the data that only depends on the fixed image is cached. */
+  if( serverMode )
+  {
+    elx::ElastixBase::SetUseDataCache( true );
+    elxout << "\nelastix runs as a server, and waits for jobs." << std::endl;
+  }
+
+  /** The command line arguments, which are completed by the job arguments. */
+  const ArgumentMapType commandLineArgMap   = argMap;
+  ArgumentMapType       fixedImageArguments = GetFixedImageArguments( argMap );
+  unsigned long         jobNumber           = 0;
+  double                firstJobTime        = 0.0;
+  bool                  moreJobs            = true;
 
-  for( unsigned int i = 0; i < nrOfParameterFiles; i++ )
+  while( moreJobs )
   {
-    /** Create another instance of ElastixMain. */
-    elastices.push_back( ElastixMainType::New() );
-
-    /** Set stuff we get from a former registration. */
-    elastices[ i ]->SetInitialTransform( transform );
-    elastices[ i ]->SetFixedImageContainer( fixedImageContainer );
-    elastices[ i ]->SetMovingImageContainer( movingImageContainer );
-    elastices[ i ]->SetFixedMaskContainer( fixedMaskContainer );
-    elastices[ i ]->SetMovingMaskContainer( movingMaskContainer );
-    elastices[ i ]->SetOriginalFixedImageDirectionFlat( fixedImageOriginalDirection );
-
-    /** Set the current elastix-level. */
-    elastices[ i ]->SetElastixLevel( i );
-    elastices[ i ]->SetTotalNumberOfElastixLevels( nrOfParameterFiles );
-
-    /** Delete the previous ParameterFileName. */
-    if( argMap.count( "-p" ) )
+    /** Read the arguments of the next job. Jobs may give or override every
+     * argument, except for the parameter files. Jobs with other fixed images
+     * or masks than the previous job do not use the cached data.
+     */
+    if( serverMode )
+    {
+      std::string jobLine;
+      if( !std::getline( *jobStream, jobLine ) )
+      {
+        break;
+      }
+      const std::vector< std::string > jobArguments = SplitJobLine( jobLine );
+      if( jobArguments.empty() || jobArguments[ 0 ][ 0 ] == '#' )
+      {
+        continue;
+      }
+
+      argMap = commandLineArgMap;
+      bool validJob = jobArguments.size() % 2 == 0;
+      for( unsigned int i = 0; validJob && i < jobArguments.size(); i += 2 )
+      {
+        const std::string & key   = jobArguments[ i ];
+        std::string         value = jobArguments[ i + 1 ];
+        validJob = key.size() > 1 && key[ 0 ] == '-' && key != "-p" && key != "-jobs";
+        if( key == "-out" )
+        {
+          value = ConvertToOutputFolder( value );
+        }
+        argMap[ key ] = value;
+      }
+      validJob = validJob && itksys::SystemTools::FileIsDirectory( argMap[ "-out" ].c_str() );
+      if( !validJob || elx::xoutSetLogFile( ( argMap[ "-out" ] + "elastix.log" ).c_str() ) != 0 )
+      {
+        std::cout << "elastix job " << jobNumber << " failed: invalid arguments or output "
+                  << "directory \"" << jobLine << "\"." << std::endl;
+        ++jobNumber;
+        continue;
+      }
+
+      /** The fixed images and masks of the previous job, and the cached
+       * pyramids and masks, are only used when this job has the same fixed
+       * image arguments, given by the job line or the command line.
+       */
+      const ArgumentMapType jobFixedImageArguments = GetFixedImageArguments( argMap );
+      if( jobFixedImageArguments != fixedImageArguments )
+      {
+        fixedImageArguments = jobFixedImageArguments;
+        fixedImageContainer = 0;
+        fixedMaskContainer  = 0;
+        fixedImageOriginalDirection.clear();
+        elx::ElastixBase::ClearDataCache();
+      }
+    }
+    else
     {
-      argMap.erase( "-p" );
+      moreJobs = false;
     }
 
-    /** Read the first parameterFileName in the queue. */
-    ArgPairType argPair = parameterFileList.front();
-    parameterFileList.pop();
+    /** Every job starts without moving images and initial transform. */
+    transform            = 0;
+    movingImageContainer = 0;
+    movingMaskContainer  = 0;
+
+    itk::TimeProbe jobTimer;
+    jobTimer.Start();
+    const unsigned long   numberOfCacheHits     = elx::ElastixBase::GetNumberOfDataCacheHits();
+    ParameterFileListType jobParameterFileList  = parameterFileList;
+    elastices.clear();
+
+    /**
+     * ********************* START REGISTRATION *********************
+     *
+     * Do the (possibly multiple) registration(s).
+     */
 
-    /** Put it in the ArgumentMap. */
-    argMap.insert( ArgumentMapEntryType( argPair.first, argPair.second ) );
+    for( unsigned int i = 0; i < nrOfParameterFiles; i++ )
+    {
+      /** Create another instance of ElastixMain. */
+      elastices.push_back( ElastixMainType::New() );
+
+      /** Set stuff we get from a former registration. */
+      elastices[ i ]->SetInitialTransform( transform );
+      elastices[ i ]->SetFixedImageContainer( fixedImageContainer );
+      elastices[ i ]->SetMovingImageContainer( movingImageContainer );
+      elastices[ i ]->SetFixedMaskContainer( fixedMaskContainer );
+      elastices[ i ]->SetMovingMaskContainer( movingMaskContainer );
+      elastices[ i ]->SetOriginalFixedImageDirectionFlat( fixedImageOriginalDirection );
+
+      /** Set the current elastix-level. */
+      elastices[ i ]->SetElastixLevel( i );
+      elastices[ i ]->SetTotalNumberOfElastixLevels( nrOfParameterFiles );
+
+      /** Delete the previous ParameterFileName. */
+      if( argMap.count( "-p" ) )
+      {
+        argMap.erase( "-p" );
+      }
 
-    /** Print a start message. */
-    elxout << "-------------------------------------------------------------------------" << "\n" << std::endl;
-    elxout << "Running elastix with parameter file " << i
-           << ": \"" << argMap[ "-p" ] << "\".\n" << std::endl;
+      /** Read the first parameterFileName in the queue. */
+      ArgPairType argPair = jobParameterFileList.front();
+      jobParameterFileList.pop();
 
-    /** Declare a timer, start it and print the start time. */
-    itk::TimeProbe timer;
-    timer.Start();
-    elxout << "Current time: " << GetCurrentDateAndTime() << "." << std::endl;
+      /** Put it in the ArgumentMap. */
+      argMap.insert( ArgumentMapEntryType( argPair.first, argPair.second ) );
 
-    /** Start registration. */
-    returndummy = elastices[ i ]->Run( argMap );
+      /** Print a start message. */
+      elxout << "-------------------------------------------------------------------------" << "\n" << std::endl;
+      elxout << "Running elastix with parameter file " << i
+             << ": \"" << argMap[ "-p" ] << "\".\n" << std::endl;
 
-    /** Check for errors. */
-    if( returndummy != 0 )
-    {
-      xl::xout[ "error" ] << "Errors occurred!" << std::endl;
-      return returndummy;
-    }
+      /** Declare a timer, start it and print the start time. */
+      itk::TimeProbe timer;
+      timer.Start();
+      elxout << "Current time: " << GetCurrentDateAndTime() << "." << std::endl;
 
-    /** Get the transform, the fixedImage and the movingImage
-     * in order to put it in the (possibly) next registration.
-     */
-    transform                   = elastices[ i ]->GetModifiableFinalTransform();
-    fixedImageContainer         = elastices[ i ]->GetModifiableFixedImageContainer();
-    movingImageContainer        = elastices[ i ]->GetModifiableMovingImageContainer();
-    fixedMaskContainer          = elastices[ i ]->GetModifiableFixedMaskContainer();
-    movingMaskContainer         = elastices[ i ]->GetModifiableMovingMaskContainer();
-    fixedImageOriginalDirection = elastices[ i ]->GetOriginalFixedImageDirectionFlat();
+      /** Start registration. */
+      returndummy = elastices[ i ]->Run( argMap );
+
+      /** Check for errors. */
+      if( returndummy != 0 )
+      {
+        xl::xout[ "error" ] << "Errors occurred!" << std::endl;
+        break;
+      }
+
+      /** Get the transform, the fixedImage and the movingImage
+       * in order to put it in the (possibly) next registration.
+       */
+      transform                   = elastices[ i ]->GetModifiableFinalTransform();
+      fixedImageContainer         = elastices[ i ]->GetModifiableFixedImageContainer();
+      movingImageContainer        = elastices[ i ]->GetModifiableMovingImageContainer();
+      fixedMaskContainer          = elastices[ i ]->GetModifiableFixedMaskContainer();
+      movingMaskContainer         = elastices[ i ]->GetModifiableMovingMaskContainer();
+      fixedImageOriginalDirection = elastices[ i ]->GetOriginalFixedImageDirectionFlat();
+
+      /** Print a finish message. */
+      elxout << "Running elastix with parameter file " << i
+             << ": \"" << argMap[ "-p" ] << "\", has finished.\n" << std::endl;
+
+      /** Stop timer and print it. */
+      timer.Stop();
+      elxout << "\nCurrent time: " << GetCurrentDateAndTime() << "." << std::endl;
+      elxout << "Time used for running elastix with this parameter file:\n  "
+             << ConvertSecondsToDHMS( timer.GetMean(), 1 ) << ".\n" << std::endl;
 
-    /** Print a finish message. */
-    elxout << "Running elastix with parameter file " << i
-           << ": \"" << argMap[ "-p" ] << "\", has finished.\n" << std::endl;
+      /** Try to release some memory. */
+      elastices[ i ] = 0;
 
-    /** Stop timer and print it. */
-    timer.Stop();
-    elxout << "\nCurrent time: " << GetCurrentDateAndTime() << "." << std::endl;
-    elxout << "Time used for running elastix with this parameter file:\n  "
-           << ConvertSecondsToDHMS( timer.GetMean(), 1 ) << ".\n" << std::endl;
+    } // end loop over registrations
 
-    /** Try to release some memory. */
-    elastices[ i ] = 0;
+    jobTimer.Stop();
 
-  } // end loop over registrations
+    /** Without a server, errors end elastix. */
+    if( !serverMode )
+    {
+      if( returndummy != 0 )
+      {
+        return returndummy;
+      }
+      break;
+    }
+
+    /** Report the job. After an error, nothing of this job is kept. */
+    if( returndummy != 0 )
+    {
+      fixedImageContainer = 0;
+      fixedMaskContainer  = 0;
+      fixedImageOriginalDirection.clear();
+      elx::ElastixBase::ClearDataCache();
+      std::cout << "elastix job " << jobNumber << " failed, see \""
+                << argMap[ "-out" ] << "elastix.log\"." << std::endl;
+      returndummy = 0;
+    }
+    else
+    {
+      if( jobNumber == 0 )
+      {
+        firstJobTime = jobTimer.GetMean();
+      }
+      std::cout << "elastix job " << jobNumber << " finished in "
+                << ConvertSecondsToDHMS( jobTimer.GetMean(), 3 ) << ", reusing "
+                << elx::ElastixBase::GetNumberOfDataCacheHits() - numberOfCacheHits
+                << " cached objects; the first job took "
+                << ConvertSecondsToDHMS( firstJobTime, 3 ) << "." << std::endl;
+    }
+    ++jobNumber;
+
+  } // end loop over jobs
 
   elxout << "-------------------------------------------------------------------------" << "\n" << std::endl;
 
@@ -310,16 +448,14 @@ main( int argc, char ** argv )
    * are deleted before the modules are closed.
    */
 
-  for( unsigned int i = 0; i < nrOfParameterFiles; i++ )
-  {
-    elastices[ i ] = 0;
-  }
+  elastices.clear();
 
   transform            = 0;
   fixedImageContainer  = 0;
   movingImageContainer = 0;
   fixedMaskContainer   = 0;
   movingMaskContainer  = 0;
+  elx::ElastixBase::SetUseDataCache( false );
 
   /** Close the modules. */
   ElastixMainType::UnloadComponents();
@@ -364,7 +500,12 @@ PrintHelp( void )
   std::cout << "  -t0       parameter file for initial transform\n";
   std::cout << "  -priority set the process priority to high, abovenormal, normal (default),\n"
             << "            belownormal, or idle (Windows only option)\n";
-  std::cout << "  -threads  set the maximum number of threads of elastix\n"
+  std::cout << "  -threads  set the maximum number of threads of elastix\n";
+  std::cout << "  -jobs     run as a server: read a registration job from every line of\n"
+            << "            this file (\"-\" for stdin, or a named pipe). A job gives the\n"
+            << "            other arguments, such as \"-m moving.mhd -out dir\". The fixed\n"
+            << "            image and mask, and data computed from them, are kept in\n"
+            << "            memory between jobs.\n"
             << std::endl;
 
   /** The parameter file.*/
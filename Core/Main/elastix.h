@@ -25,12 +25,14 @@
 #include <string>
 #include <vector>
 #include <queue>
+#include <map>
 #include "itkObject.h"
 #include "itkDataObject.h"
 #include <itksys/SystemTools.hxx>
 #include <itksys/SystemInformation.hxx>
 #include "itkTimeProbe.h"
 #include <time.h>
+#include <cctype>
 
 /** Declare PrintHelp function.
  *
@@ -84,6 +86,89 @@ ConvertSecondsToDHMS( const double totalSeconds, const unsigned int precision =
 } // end ConvertSecondsToDHMS()
 
 
+/** Make sure that the last character of an output folder equals a '/' or '\',
+ * and convert it to the output path format of the platform.
+ */
+std::string
+ConvertToOutputFolder( std::string value )
+{
+  const char last = value[ value.size() - 1 ];
+  if( last != '/' && last != '\\' ) { value.append( "/" ); }
+  value = itksys::SystemTools::ConvertToOutputPath( value.c_str() );
+
+  /** Note that on Windows, in case the output folder contains a space,
+   * the path name is double quoted by ConvertToOutputPath, which is undesirable.
+   * So, we remove these quotes again.
+   */
+  if( itksys::SystemTools::StringStartsWith( value.c_str(), "\"" )
+    && itksys::SystemTools::StringEndsWith(   value.c_str(), "\"" ) )
+  {
+    value = value.substr( 1, value.length() - 2 );
+  }
+
+  return value;
+
+} // end ConvertToOutputFolder()
+
+
+/** Split a line of a job file into arguments, which are separated by white
+ * space. Arguments that contain spaces can be enclosed in double quotes.
+ */
+std::vector< std::string >
+SplitJobLine( const std::string & line )
+{
+  std::vector< std::string > arguments;
+  std::string                argument;
+  bool                       inArgument = false;
+  bool                       quoted     = false;
+  for( std::string::size_type i = 0; i < line.size(); ++i )
+  {
+    const char c = line[ i ];
+    if( c == '"' )
+    {
+      quoted     = !quoted;
+      inArgument = true;
+    }
+    else if( !quoted && std::isspace( static_cast< unsigned char >( c ) ) )
+    {
+      if( inArgument ) { arguments.push_back( argument ); }
+      argument.clear();
+      inArgument = false;
+    }
+    else
+    {
+      argument  += c;
+      inArgument = true;
+    }
+  }
+  if( inArgument ) { arguments.push_back( argument ); }
+
+  return arguments;
+
+} // end SplitJobLine()
+
+
+/** Get the arguments that give the fixed image data, i.e. the fixed images
+ * and masks, which all start with "-f".
+ */
+std::map< std::string, std::string >
+GetFixedImageArguments( const std::map< std::string, std::string > & argMap )
+{
+  std::map< std::string, std::string > fixedImageArguments;
+  std::map< std::string, std::string >::const_iterator it;
+  for( it = argMap.begin(); it != argMap.end(); ++it )
+  {
+    if( it->first.compare( 0, 2, "-f" ) == 0 )
+    {
+      fixedImageArguments.insert( *it );
+    }
+  }
+
+  return fixedImageArguments;
+
+} // end GetFixedImageArguments()
+
+
 /** Returns current date and time as a string. */
 std::string
 GetCurrentDateAndTime( void )
@@ -126,12 +126,13 @@ main( int argc, char ** argv )
 
   /** Check that at least one of the following options is given. */
   if( argMap.count( "-in" ) == 0
+    && argMap.count( "-batch" ) == 0
     && argMap.count( "-ipp" ) == 0
     && argMap.count( "-def" ) == 0
     && argMap.count( "-jac" ) == 0
     && argMap.count( "-jacmat" ) == 0 )
   {
-    std::cerr << "ERROR: At least one of the CommandLine options \"-in\", "
+    std::cerr << "ERROR: At least one of the CommandLine options \"-in\", \"-batch\", "
               << "\"-def\", \"-jac\", or \"-jacmat\" should be given!" << std::endl;
     returndummy |= -1;
   }
@@ -258,6 +259,10 @@ PrintHelp( void )
   /** Optional arguments. */
   std::cout << "Optional extra commands:\n";
   std::cout << "  -in       input image to deform\n";
+  std::cout << "  -batch    file with more input images to deform, one per line:\n"
+            << "            <image> [<interpolation order>] [<result pixel type>] [<result name>]\n"
+            << "            for example \"labels.mhd 0 unsigned_char labelsResult\". All images\n"
+            << "            are resampled with the same transform, which is read only once.\n";
   std::cout << "  -def      file containing input-image points; the point are transformed\n"
             << "            according to the specified transform-parameter file\n";
   std::cout << "            use \"-def all\" to transform all points from the input-image, which\n"
@@ -269,7 +274,7 @@ PrintHelp( void )
   std::cout << "  -priority set the process priority to high, abovenormal, normal (default),\n"
             << "            belownormal, or idle (Windows only option)\n";
   std::cout << "  -threads  set the maximum number of threads of transformix\n";
-  std::cout << "\nAt least one of the options \"-in\", \"-def\", \"-jac\", or \"-jacmat\" should be given.\n"
+  std::cout << "\nAt least one of the options \"-in\", \"-batch\", \"-def\", \"-jac\", or \"-jacmat\" should be given.\n"
             << std::endl;
 
   /** The parameter file. */
@@ -30,6 +30,8 @@
 #include "vnl/vnl_math.h"
 #include "itkTimeProbe.h"
 
+#include <vector>
+
 //-------------------------------------------------------------------------------------
 
 // Test function templated over the dimension
@@ -279,6 +281,105 @@ TestInterpolators( void )
 } // end TestInterpolator()
 
 
+// Compare the batch interpolation with the interpolation per point,
+// and measure the throughput of both.
+template< unsigned int Dimension, class TPixel >
+bool
+TestBatchInterpolation( const char * pixelTypeName )
+{
+  typedef itk::Image< TPixel, Dimension >        InputImageType;
+  typedef typename InputImageType::SizeType      SizeType;
+  typedef typename InputImageType::SpacingType   SpacingType;
+  typedef typename InputImageType::DirectionType DirectionType;
+  typedef itk::AdvancedLinearInterpolateImageFunction<
+    InputImageType, double >                                           InterpolatorType;
+  typedef typename InterpolatorType::ContinuousIndexType               ContinuousIndexType;
+  typedef typename InterpolatorType::CovariantVectorType               CovariantVectorType;
+  typedef typename InterpolatorType::OutputType                        OutputType;
+  typedef itk::ImageRegionIterator< InputImageType >                   IteratorType;
+  typedef itk::Statistics::MersenneTwisterRandomVariateGenerator      RandomNumberGeneratorType;
+
+  RandomNumberGeneratorType::Pointer randomNum = RandomNumberGeneratorType::GetInstance();
+
+  /** Create a random image, large enough not to fit in the cache. */
+  SizeType size; SpacingType spacing;
+  for( unsigned int i = 0; i < Dimension; ++i )
+  {
+    size[ i ]    = Dimension == 2 ? 1024 : 128;
+    spacing[ i ] = randomNum->GetUniformVariate( 0.5, 2.0 );
+  }
+  DirectionType direction; direction.Fill( 0.0 );
+  for( unsigned int i = 0; i < Dimension; ++i )
+  {
+    direction[ i ][ Dimension - 1 - i ] = ( i % 2 == 0 ) ? 1.0 : -1.0;
+  }
+
+  typename InputImageType::Pointer image = InputImageType::New();
+  image->SetRegions( size );
+  image->SetSpacing( spacing );
+  image->SetDirection( direction );
+  image->Allocate();
+  IteratorType it( image, image->GetLargestPossibleRegion() );
+  for( it.GoToBegin(); !it.IsAtEnd(); ++it )
+  {
+    it.Set( static_cast< TPixel >( randomNum->GetUniformVariate( 0, 255 ) ) );
+  }
+
+  typename InterpolatorType::Pointer interpolator = InterpolatorType::New();
+  interpolator->SetInputImage( image );
+
+  /** Random points, some of them just outside the image. */
+  const unsigned int                 numberOfPoints = 1000000;
+  std::vector< ContinuousIndexType > points( numberOfPoints );
+  for( unsigned int i = 0; i < numberOfPoints; ++i )
+  {
+    for( unsigned int d = 0; d < Dimension; ++d )
+    {
+      points[ i ][ d ] = randomNum->GetUniformVariate( -1.5, size[ d ] + 0.5 );
+    }
+  }
+
+  std::vector< OutputType >          values( numberOfPoints ), batchValues( numberOfPoints );
+  std::vector< CovariantVectorType > derivs( numberOfPoints ), batchDerivs( numberOfPoints );
+
+  itk::TimeProbe timer;
+  timer.Start();
+  for( unsigned int i = 0; i < numberOfPoints; ++i )
+  {
+    interpolator->EvaluateValueAndDerivativeAtContinuousIndex(
+      points[ i ], values[ i ], derivs[ i ] );
+  }
+  timer.Stop();
+  const double timePerPoint = timer.GetMean();
+
+  timer.Reset(); timer.Start();
+  interpolator->EvaluateValueAndDerivativeAtContinuousIndices(
+    &points[ 0 ], &batchValues[ 0 ], &batchDerivs[ 0 ], numberOfPoints );
+  timer.Stop();
+  const double timeBatch = timer.GetMean();
+
+  std::cout << Dimension << "D " << pixelTypeName << ": "
+            << 1.0e-6 * numberOfPoints / timePerPoint << " Mpoints/s per point, "
+            << 1.0e-6 * numberOfPoints / timeBatch << " Mpoints/s in batch, speedup "
+            << timePerPoint / timeBatch << std::endl;
+
+  for( unsigned int i = 0; i < numberOfPoints; ++i )
+  {
+    if( vnl_math_abs( values[ i ] - batchValues[ i ] ) > 1.0e-3
+      || ( derivs[ i ] - batchDerivs[ i ] ).GetVnlVector().magnitude() > 1.0e-3 )
+    {
+      std::cerr << "ERROR: the batch interpolation differs at " << points[ i ]
+                << ": " << batchValues[ i ] << " " << batchDerivs[ i ]
+                << " instead of " << values[ i ] << " " << derivs[ i ] << std::endl;
+      return false;
+    }
+  }
+
+  return true;
+
+} // end TestBatchInterpolation()
+
+
 int
 main( int argc, char ** argv )
 {
@@ -292,5 +393,14 @@ main( int argc, char ** argv )
   success = TestInterpolators< 3 >();
   if( !success ) { return EXIT_FAILURE; }
 
+  std::cerr << "\n\n\n-----------------------------------\n\n\n";
+
+  // Batch tests
+  success = TestBatchInterpolation< 2, short >( "short" )
+    && TestBatchInterpolation< 2, float >( "float" )
+    && TestBatchInterpolation< 3, short >( "short" )
+    && TestBatchInterpolation< 3, float >( "float" );
+  if( !success ) { return EXIT_FAILURE; }
+
   return EXIT_SUCCESS;
 } // end main
@@ -0,0 +1,198 @@
+/*=========================================================================
+ *
+ *  Copyright UMC Utrecht and contributors
+ *
+ *  Licensed under the Apache License, Version 2.0 (the "License");
+ *  you may not use this file except in compliance with the License.
+ *  You may obtain a copy of the License at
+ *
+ *        http://www.apache.org/licenses/LICENSE-2.0.txt
+ *
+ *  Unless required by applicable law or agreed to in writing, software
+ *  distributed under the License is distributed on an "AS IS" BASIS,
+ *  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *  See the License for the specific language governing permissions and
+ *  limitations under the License.
+ *
+ *=========================================================================*/
+#include "elxAsynchronousOutputStream.h"
+#include "elxBinaryIterationInfoStream.h"
+
+#include <cmath>
+#include <cstdlib>
+#include <cstring>
+#include <iostream>
+#include <sstream>
+#include <string>
+
+//-------------------------------------------------------------------------------------
+// Checks the output streams of the iteration info:
+// - the AsynchronousOutputStream should pass the text on directly without a
+//   writer thread, and write exactly the same text with a writer thread,
+//   flushed or not, after the thread is stopped;
+// - the BinaryIterationInfoStream should write the header, the column names
+//   and a record of doubles per row, also behind an AsynchronousOutputStream.
+
+/** Write a table like the iteration info, with or without flushes. */
+std::string
+WriteTable( std::ostream & stream, const unsigned int numberOfRows, const bool flush )
+{
+  std::ostringstream expected;
+  stream << "1:ItNr\t2:Metric\tTime[ms]\n";
+  expected << "1:ItNr\t2:Metric\tTime[ms]\n";
+  for( unsigned int i = 0; i < numberOfRows; ++i )
+  {
+    std::ostringstream row;
+    row << i << "\t" << -1.0 / ( i + 1.0 ) << "\t" << ( i % 7 == 0 ? "-" : "0.5" ) << "\n";
+    stream << row.str();
+    expected << row.str();
+    if( flush )
+    {
+      stream.flush();
+    }
+  }
+  return expected.str();
+
+} // end WriteTable()
+
+
+/** Check the asynchronous stream. */
+bool
+TestAsynchronousOutputStream( void )
+{
+  elastix::AsynchronousOutputStream stream;
+  std::ostringstream                destination;
+  stream.SetDestination( &destination );
+
+  /** Without a writer thread, the text is written directly. */
+  stream << "direct " << 12;
+  if( destination.str() != "direct 12" )
+  {
+    std::cerr << "ERROR: the text was not written directly." << std::endl;
+    return false;
+  }
+
+  /** With a writer thread, all text is written after stopping it. */
+  for( unsigned int flush = 0; flush < 2; ++flush )
+  {
+    destination.str( "" );
+    stream.StartWriterThread();
+    if( !stream.GetWriterThreadRunning() )
+    {
+      std::cerr << "ERROR: the writer thread was not started." << std::endl;
+      return false;
+    }
+    const std::string expected = WriteTable( stream, 20000, flush == 1 );
+    stream.StopWriterThread();
+    if( destination.str() != expected )
+    {
+      std::cerr << "ERROR: the writer thread wrote " << destination.str().size()
+                << " characters instead of " << expected.size()
+                << ( flush == 1 ? ", with" : ", without" ) << " flushes." << std::endl;
+      return false;
+    }
+  }
+
+  return true;
+
+} // end TestAsynchronousOutputStream()
+
+
+/** Check the binary iteration info written to destination. */
+bool
+CheckBinaryIterationInfo( const std::string & data, const unsigned int numberOfRows )
+{
+  const char         magic[ 8 ]      = { 'E', 'L', 'X', 'I', 'T', 'E', 'R', '\0' };
+  const unsigned int numberOfColumns = 3;
+  const std::string  names( "1:ItNr\0" "2:Metric\0" "Time[ms]\0", 25 );
+  const std::size_t  headerSize      = 24 + 32; // header, names and padding
+
+  if( data.size() != headerSize + numberOfRows * numberOfColumns * sizeof( double ) )
+  {
+    std::cerr << "ERROR: the binary file has " << data.size() << " bytes." << std::endl;
+    return false;
+  }
+
+  unsigned int header[ 4 ];
+  std::memcpy( header, data.data() + 8, sizeof( header ) );
+  if( std::memcmp( data.data(), magic, 8 ) != 0
+    || header[ 0 ] != 1 || header[ 1 ] != sizeof( double )
+    || header[ 2 ] != 0x01020304 || header[ 3 ] != numberOfColumns
+    || data.compare( 24, names.size(), names ) != 0 )
+  {
+    std::cerr << "ERROR: the header of the binary file is wrong." << std::endl;
+    return false;
+  }
+
+  for( unsigned int i = 0; i < numberOfRows; ++i )
+  {
+    double values[ 3 ];
+    std::memcpy( values, data.data() + headerSize + i * sizeof( values ), sizeof( values ) );
+
+    /** The metric is compared with the same precision as the text. */
+    std::ostringstream metric;
+    metric << -1.0 / ( i + 1.0 );
+    const bool timeIsNaN = ( i % 7 == 0 );
+    if( values[ 0 ] != i || values[ 1 ] != std::atof( metric.str().c_str() )
+      || ( timeIsNaN ? !( values[ 2 ] != values[ 2 ] ) : values[ 2 ] != 0.5 ) )
+    {
+      std::cerr << "ERROR: row " << i << " of the binary file is wrong: "
+                << values[ 0 ] << " " << values[ 1 ] << " " << values[ 2 ] << std::endl;
+      return false;
+    }
+  }
+
+  return true;
+
+} // end CheckBinaryIterationInfo()
+
+
+/** Check the binary stream, directly and behind the asynchronous stream. */
+bool
+TestBinaryIterationInfoStream( void )
+{
+  const unsigned int numberOfRows = 1000;
+
+  std::ostringstream                 destination( std::ios_base::out | std::ios_base::binary );
+  elastix::BinaryIterationInfoStream binaryStream;
+  binaryStream.SetDestination( &destination );
+  WriteTable( binaryStream, numberOfRows, true );
+  if( !CheckBinaryIterationInfo( destination.str(), numberOfRows ) )
+  {
+    return false;
+  }
+
+  /** A new destination gets a new header. */
+  destination.str( "" );
+  binaryStream.SetDestination( &destination );
+  elastix::AsynchronousOutputStream asynchronousStream;
+  asynchronousStream.SetDestination( &binaryStream );
+  asynchronousStream.StartWriterThread();
+  WriteTable( asynchronousStream, numberOfRows, true );
+  asynchronousStream.StopWriterThread();
+  if( !CheckBinaryIterationInfo( destination.str(), numberOfRows ) )
+  {
+    return false;
+  }
+
+  return true;
+
+} // end TestBinaryIterationInfoStream()
+
+
+int
+main( int argc, char * argv[] )
+{
+  if( !TestAsynchronousOutputStream() )
+  {
+    return EXIT_FAILURE;
+  }
+  if( !TestBinaryIterationInfoStream() )
+  {
+    return EXIT_FAILURE;
+  }
+
+  /** Return a value. */
+  return EXIT_SUCCESS;
+
+} // end main
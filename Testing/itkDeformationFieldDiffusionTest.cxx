@@ -0,0 +1,428 @@
+/*=========================================================================
+ *
+ *  Copyright UMC Utrecht and contributors
+ *
+ *  Licensed under the Apache License, Version 2.0 (the "License");
+ *  you may not use this file except in compliance with the License.
+ *  You may obtain a copy of the License at
+ *
+ *        http://www.apache.org/licenses/LICENSE-2.0.txt
+ *
+ *  Unless required by applicable law or agreed to in writing, software
+ *  distributed under the License is distributed on an "AS IS" BASIS,
+ *  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *  See the License for the specific language governing permissions and
+ *  limitations under the License.
+ *
+ *=========================================================================*/
+#include "BSplineDeformableTransformWithDiffusion/itkDeformationFieldRegulizer.h"
+#include "BSplineDeformableTransformWithDiffusion/itkVectorMeanDiffusionImageFilter.h"
+#include "itkAdvancedBSplineDeformableTransform.h"
+#include "itkAdvancedCombinationTransform.h"
+#include "itkConstNeighborhoodIterator.h"
+#include "itkImageRegionIterator.h"
+#include "itkImageRegionConstIteratorWithIndex.h"
+#include "itkMersenneTwisterRandomVariateGenerator.h"
+#include "itkRescaleIntensityImageFilter.h"
+#include "itkZeroFluxNeumannBoundaryCondition.h"
+
+#include <algorithm>
+#include <cmath>
+
+//-------------------------------------------------------------------------------------
+// Checks the multi-threaded deformation field computation and diffusion of
+// the BSplineTransformWithDiffusion against single-threaded full evaluations
+// on a small grid:
+// - the deformation field that is only evaluated completely in the support
+//   region of the nonzero B-spline coefficients, against TransformPoint()
+//   of all voxels;
+// - the update of the intermediary deformation field in that region only,
+//   against an update with the full field;
+// - the diffusion, which alternates between the output and a temporary
+//   image, against a copy per iteration, for 0, odd and even numbers of
+//   iterations, with the same filter.
+
+const unsigned int Dimension = 2;
+typedef itk::AdvancedCombinationTransform< double, Dimension >        CombinationTransformType;
+typedef itk::DeformationFieldRegulizer< CombinationTransformType >    RegulizerType;
+typedef itk::AdvancedBSplineDeformableTransform< double, Dimension, 3 > BSplineTransformType;
+typedef RegulizerType::IntermediaryDFTransformType                    IntermediaryTransformType;
+typedef IntermediaryTransformType::CoefficientImageType               CoefficientImageType;
+typedef IntermediaryTransformType::CoefficientImagePointer            CoefficientImagePointer;
+typedef RegulizerType::VectorImageType                                VectorImageType;
+typedef VectorImageType::PixelType                                    VectorType;
+typedef VectorImageType::RegionType                                   RegionType;
+typedef itk::Image< short, Dimension >                                GrayValueImageType;
+typedef itk::Image< double, Dimension >                               DoubleImageType;
+typedef itk::VectorMeanDiffusionImageFilter<
+  VectorImageType, GrayValueImageType >                               DiffusionFilterType;
+typedef itk::Statistics::MersenneTwisterRandomVariateGenerator        RandomGeneratorType;
+
+/** Create a vector image with random vectors. */
+VectorImageType::Pointer
+CreateRandomField( const RegionType & region, RandomGeneratorType * randomGenerator )
+{
+  VectorImageType::Pointer field = VectorImageType::New();
+  field->SetRegions( region );
+  field->Allocate();
+  itk::ImageRegionIterator< VectorImageType > it( field, region );
+  for( it.GoToBegin(); !it.IsAtEnd(); ++it )
+  {
+    VectorType vector;
+    for( unsigned int i = 0; i < Dimension; ++i )
+    {
+      vector[ i ] = randomGenerator->GetUniformVariate( -2.0, 2.0 );
+    }
+    it.Set( vector );
+  }
+  return field;
+
+} // end CreateRandomField()
+
+
+/** Compare two vector images. */
+bool
+CompareFields( const char * name, const VectorImageType * actual,
+  const VectorImageType * expected, const double tolerance )
+{
+  itk::ImageRegionConstIteratorWithIndex< VectorImageType > it(
+    expected, expected->GetLargestPossibleRegion() );
+  for( it.GoToBegin(); !it.IsAtEnd(); ++it )
+  {
+    const VectorType a = actual->GetPixel( it.GetIndex() );
+    const VectorType e = it.Get();
+    for( unsigned int i = 0; i < Dimension; ++i )
+    {
+      if( std::abs( a[ i ] - e[ i ] ) > tolerance * std::max( 1.0, std::abs( e[ i ] ) ) )
+      {
+        std::cerr << "ERROR: " << name << " at " << it.GetIndex() << " is "
+                  << a << ", but should be " << e << "." << std::endl;
+        return false;
+      }
+    }
+  }
+  return true;
+
+} // end CompareFields()
+
+
+/** Compute the deformation field of a transform single-threaded,
+ * with TransformPoint() at all voxels.
+ */
+VectorImageType::Pointer
+ComputeFullDeformationField( const RegulizerType * transform, const RegionType & region )
+{
+  VectorImageType::Pointer field = VectorImageType::New();
+  field->SetRegions( region );
+  field->Allocate();
+  itk::ImageRegionIterator< VectorImageType > it( field, region );
+  for( it.GoToBegin(); !it.IsAtEnd(); ++it )
+  {
+    RegulizerType::InputPointType point;
+    field->TransformIndexToPhysicalPoint( it.GetIndex(), point );
+    const RegulizerType::OutputPointType transformed = transform->TransformPoint( point );
+    VectorType                           vector;
+    for( unsigned int i = 0; i < Dimension; ++i )
+    {
+      vector[ i ] = transformed[ i ] - point[ i ];
+    }
+    it.Set( vector );
+  }
+  return field;
+
+} // end ComputeFullDeformationField()
+
+
+/** Compare the deformation field of the regulizer, computed in the changed
+ * region only and multi-threaded, with the full single-threaded field, and
+ * check the update of the intermediary deformation field in that region.
+ */
+bool
+CompareDeformationField( const char * name, RegulizerType * regulizer,
+  BSplineTransformType * bsplineTransform, const RegionType & region,
+  const bool expectEmptyRegion )
+{
+  VectorImageType::Pointer field = VectorImageType::New();
+  field->SetRegions( region );
+  field->Allocate();
+
+  const RegionType changedRegion
+    = RegulizerType::ComputeBSplineSupportRegion( bsplineTransform, field.GetPointer() );
+  std::cerr << name << ": changed region = " << changedRegion.GetIndex()
+            << " " << changedRegion.GetSize() << std::endl;
+  if( expectEmptyRegion != ( changedRegion.GetNumberOfPixels() == 0 )
+    || changedRegion.GetNumberOfPixels() >= region.GetNumberOfPixels() )
+  {
+    std::cerr << "ERROR: unexpected changed region." << std::endl;
+    return false;
+  }
+
+  /** Outside the changed region the B-spline transform should be the identity. */
+  itk::ImageRegionConstIteratorWithIndex< VectorImageType > it( field, region );
+  for( it.GoToBegin(); !it.IsAtEnd(); ++it )
+  {
+    if( changedRegion.IsInside( it.GetIndex() ) )
+    {
+      continue;
+    }
+    BSplineTransformType::InputPointType point;
+    field->TransformIndexToPhysicalPoint( it.GetIndex(), point );
+    if( point.EuclideanDistanceTo( bsplineTransform->TransformPoint( point ) ) > 1e-12 )
+    {
+      std::cerr << "ERROR: the B-spline transform is not the identity at "
+                << it.GetIndex() << ", outside the changed region." << std::endl;
+      return false;
+    }
+  }
+
+  /** The field in the changed region only, against the full field. */
+  regulizer->SetNumberOfThreads( 3 );
+  regulizer->ComputeDeformationField( field, changedRegion );
+  VectorImageType::Pointer fullField = ComputeFullDeformationField( regulizer, region );
+  if( !CompareFields( "the deformation field", field, fullField, 1e-6 ) )
+  {
+    return false;
+  }
+
+  /** The intermediary deformation field, updated in the changed region only,
+   * should equal an intermediary deformation field set from the full field.
+   */
+  regulizer->UpdateIntermediaryDeformationFieldTransform( field, changedRegion );
+  IntermediaryTransformType::Pointer fullIntermediary = IntermediaryTransformType::New();
+  fullIntermediary->SetCoefficientVectorImage( fullField );
+  const CoefficientImagePointer * coefficients
+    = regulizer->GetIntermediaryDeformationFieldTransform()->GetCoefficientImages();
+  const CoefficientImagePointer * fullCoefficients = fullIntermediary->GetCoefficientImages();
+  for( unsigned int i = 0; i < Dimension; ++i )
+  {
+    itk::ImageRegionConstIteratorWithIndex< CoefficientImageType > cit(
+      fullCoefficients[ i ], region );
+    for( cit.GoToBegin(); !cit.IsAtEnd(); ++cit )
+    {
+      if( coefficients[ i ]->GetPixel( cit.GetIndex() ) != cit.Get() )
+      {
+        std::cerr << "ERROR: the intermediary deformation field at " << cit.GetIndex()
+                  << " is " << coefficients[ i ]->GetPixel( cit.GetIndex() )
+                  << ", but should be " << cit.Get() << "." << std::endl;
+        return false;
+      }
+    }
+  }
+
+  return true;
+
+} // end CompareDeformationField()
+
+
+/** Diffuse a vector field single-threaded, with a copy per iteration,
+ * as the VectorMeanDiffusionImageFilter did before.
+ */
+VectorImageType::Pointer
+DiffuseReference( const VectorImageType * input, const DoubleImageType * cx,
+  const VectorImageType::SizeType & radius, const unsigned int numberOfIterations )
+{
+  const RegionType region = input->GetLargestPossibleRegion();
+
+  VectorImageType::Pointer output = VectorImageType::New();
+  output->SetRegions( region );
+  output->Allocate();
+  VectorImageType::Pointer outputtmp = VectorImageType::New();
+  outputtmp->SetRegions( region );
+  outputtmp->Allocate();
+
+  /** Copy input to output. */
+  itk::ImageRegionConstIterator< VectorImageType > in_it( input, region );
+  itk::ImageRegionIterator< VectorImageType >      out_it( output, region );
+  for( ; !in_it.IsAtEnd(); ++in_it, ++out_it )
+  {
+    out_it.Set( in_it.Get() );
+  }
+
+  itk::ZeroFluxNeumannBoundaryCondition< VectorImageType > nbc;
+  itk::ZeroFluxNeumannBoundaryCondition< DoubleImageType > nbc2;
+  for( unsigned int k = 0; k < numberOfIterations; ++k )
+  {
+    itk::ConstNeighborhoodIterator< VectorImageType > nit( radius, output, region );
+    nit.OverrideBoundaryCondition( &nbc );
+    itk::ConstNeighborhoodIterator< DoubleImageType > nit2( radius, cx, region );
+    nit2.OverrideBoundaryCondition( &nbc2 );
+    itk::ImageRegionIterator< VectorImageType > oit( outputtmp, region );
+
+    for( ; !nit.IsAtEnd(); ++nit, ++nit2, ++oit )
+    {
+      const double c = nit2.GetCenterPixel();
+      if( c < 0.000001 )
+      {
+        oit.Set( nit.GetCenterPixel() );
+        continue;
+      }
+
+      double sum[ Dimension ];
+      std::fill( sum, sum + Dimension, 0.0 );
+      double sumc = 0.0;
+      for( unsigned int i = 0; i < nit.Size(); ++i )
+      {
+        const VectorType pix = nit.GetPixel( i );
+        const double     ci  = nit2.GetPixel( i );
+        sumc += ci;
+        for( unsigned int j = 0; j < Dimension; ++j )
+        {
+          sum[ j ] += ci * static_cast< double >( pix[ j ] );
+        }
+      }
+
+      VectorType mean;
+      for( unsigned int j = 0; j < Dimension; ++j )
+      {
+        mean[ j ] = sumc < 0.00001 ? 0.0 : sum[ j ] / sumc;
+      }
+      oit.Set( nit.GetCenterPixel() * ( 1.0 - c ) + mean * c );
+    }
+
+    /** Copy outputtmp to output. */
+    itk::ImageRegionConstIterator< VectorImageType > tmp_it( outputtmp, region );
+    for( out_it.GoToBegin(); !out_it.IsAtEnd(); ++tmp_it, ++out_it )
+    {
+      out_it.Set( tmp_it.Get() );
+    }
+  }
+
+  return output;
+
+} // end DiffuseReference()
+
+
+int
+main( int argc, char * argv[] )
+{
+  RandomGeneratorType::Pointer randomGenerator = RandomGeneratorType::GetInstance();
+  randomGenerator->SetSeed( 42 );
+
+  /** A small deformation field. */
+  VectorImageType::SizeType fieldSize;
+  fieldSize[ 0 ] = 24;
+  fieldSize[ 1 ] = 21;
+  const RegionType fieldRegion( fieldSize );
+
+  try
+  {
+    /** A B-spline grid that covers the field, with nonzero coefficients
+     * in a small block only.
+     */
+    BSplineTransformType::SizeType gridSize;
+    gridSize[ 0 ] = 11;
+    gridSize[ 1 ] = 10;
+    BSplineTransformType::SpacingType gridSpacing;
+    gridSpacing.Fill( 3.0 );
+    BSplineTransformType::OriginType gridOrigin;
+    gridOrigin.Fill( -6.0 );
+    BSplineTransformType::DirectionType gridDirection;
+    gridDirection.SetIdentity();
+
+    BSplineTransformType::Pointer bsplineTransform = BSplineTransformType::New();
+    bsplineTransform->SetGridOrigin( gridOrigin );
+    bsplineTransform->SetGridSpacing( gridSpacing );
+    bsplineTransform->SetGridRegion( BSplineTransformType::RegionType( gridSize ) );
+    bsplineTransform->SetGridDirection( gridDirection );
+
+    const unsigned int numberOfGridPoints = gridSize[ 0 ] * gridSize[ 1 ];
+    BSplineTransformType::ParametersType parameters( bsplineTransform->GetNumberOfParameters() );
+    parameters.Fill( 0.0 );
+    bsplineTransform->SetParameters( parameters );
+
+    /** The regulizer, with a random intermediary deformation field. */
+    RegulizerType::Pointer regulizer = RegulizerType::New();
+    regulizer->SetCurrentTransform( bsplineTransform.GetPointer() );
+    regulizer->SetDeformationFieldRegion( fieldRegion );
+    RegulizerType::SpacingType fieldSpacing;
+    fieldSpacing.Fill( 1.0 );
+    regulizer->SetDeformationFieldSpacing( fieldSpacing );
+    RegulizerType::OriginType fieldOrigin;
+    fieldOrigin.Fill( 0.0 );
+    regulizer->SetDeformationFieldOrigin( fieldOrigin );
+    regulizer->InitializeDeformationFields();
+    regulizer->UpdateIntermediaryDeformationFieldTransform(
+      CreateRandomField( fieldRegion, randomGenerator ) );
+
+    /** Without nonzero coefficients nothing changed. */
+    if( !CompareDeformationField( "zero coefficients", regulizer,
+      bsplineTransform, fieldRegion, true ) )
+    {
+      return 1;
+    }
+
+    /** Nonzero coefficients in a block of the grid. */
+    for( unsigned int y = 4; y < 6; ++y )
+    {
+      for( unsigned int x = 5; x < 7; ++x )
+      {
+        for( unsigned int i = 0; i < Dimension; ++i )
+        {
+          parameters[ i * numberOfGridPoints + y * gridSize[ 0 ] + x ]
+            = randomGenerator->GetUniformVariate( -1.0, 1.0 );
+        }
+      }
+    }
+    bsplineTransform->SetParameters( parameters );
+    if( !CompareDeformationField( "nonzero block", regulizer,
+      bsplineTransform, fieldRegion, false ) )
+    {
+      return 1;
+    }
+
+    /** The diffusion, with a random stiffness image. */
+    GrayValueImageType::Pointer grayValueImage = GrayValueImageType::New();
+    grayValueImage->SetRegions( fieldRegion );
+    grayValueImage->Allocate();
+    itk::ImageRegionIterator< GrayValueImageType > git( grayValueImage, fieldRegion );
+    for( git.GoToBegin(); !git.IsAtEnd(); ++git )
+    {
+      git.Set( static_cast< short >( randomGenerator->GetIntegerVariate( 1000 ) ) );
+    }
+
+    typedef itk::RescaleIntensityImageFilter< GrayValueImageType, DoubleImageType > RescaleFilterType;
+    RescaleFilterType::Pointer rescaler = RescaleFilterType::New();
+    rescaler->SetInput( grayValueImage );
+    rescaler->SetOutputMinimum( 0.000001 );
+    rescaler->SetOutputMaximum( 0.999999 );
+    rescaler->Update();
+
+    VectorImageType::Pointer input = CreateRandomField( fieldRegion, randomGenerator );
+    VectorImageType::SizeType radius;
+    radius.Fill( 1 );
+
+    DiffusionFilterType::Pointer diffusion = DiffusionFilterType::New();
+    diffusion->SetInput( input );
+    diffusion->SetGrayValueImage( grayValueImage );
+    diffusion->SetRadius( radius );
+#if ITK_VERSION_MAJOR >= 5
+    diffusion->SetNumberOfWorkUnits( 3 );
+#else
+    diffusion->SetNumberOfThreads( 3 );
+#endif
+
+    /** Odd, even and 0 iterations, reusing the temporary image. */
+    const unsigned int numbersOfIterations[ 5 ] = { 3, 2, 0, 1, 4 };
+    for( unsigned int n = 0; n < 5; ++n )
+    {
+      diffusion->SetNumberOfIterations( numbersOfIterations[ n ] );
+      diffusion->Update();
+      VectorImageType::Pointer reference = DiffuseReference(
+        input, rescaler->GetOutput(), radius, numbersOfIterations[ n ] );
+      std::cerr << "Diffusion with " << numbersOfIterations[ n ] << " iterations." << std::endl;
+      if( !CompareFields( "the diffused field", diffusion->GetOutput(), reference, 1e-6 ) )
+      {
+        return 1;
+      }
+    }
+  }
+  catch( itk::ExceptionObject & excp )
+  {
+    std::cerr << excp << std::endl;
+    return 1;
+  }
+
+  /** Return a value. */
+  return 0;
+
+} // end main
@@ -0,0 +1,133 @@
+/*=========================================================================
+ *
+ *  Copyright UMC Utrecht and contributors
+ *
+ *  Licensed under the Apache License, Version 2.0 (the "License");
+ *  you may not use this file except in compliance with the License.
+ *  You may obtain a copy of the License at
+ *
+ *        http://www.apache.org/licenses/LICENSE-2.0.txt
+ *
+ *  Unless required by applicable law or agreed to in writing, software
+ *  distributed under the License is distributed on an "AS IS" BASIS,
+ *  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *  See the License for the specific language governing permissions and
+ *  limitations under the License.
+ *
+ *=========================================================================*/
+#include "itkErodeMaskImageFilter.h"
+#include "itkImage.h"
+#include "itkImageRegionConstIterator.h"
+#include "itkImageRegionIteratorWithIndex.h"
+#include "itkTimeProbe.h"
+
+#include <iomanip>
+
+//-------------------------------------------------------------------------------------
+
+int
+main( int argc, char * argv[] )
+{
+  /** Some basic type definitions. */
+  const unsigned int Dimension = 3;
+  typedef unsigned char                          MaskPixelType;
+  typedef itk::Image< MaskPixelType, Dimension > MaskImageType;
+  typedef itk::ErodeMaskImageFilter< MaskImageType > ErodeFilterType;
+  typedef ErodeFilterType::ScheduleType              ScheduleType;
+
+  /** Create a mask with a sphere and a box, touching the image border. */
+  MaskImageType::SizeType size;
+  size[ 0 ] = 80; size[ 1 ] = 70; size[ 2 ] = 60;
+  MaskImageType::Pointer mask = MaskImageType::New();
+  mask->SetRegions( size );
+  mask->Allocate();
+
+  itk::ImageRegionIteratorWithIndex< MaskImageType > it( mask, mask->GetLargestPossibleRegion() );
+  for( it.GoToBegin(); !it.IsAtEnd(); ++it )
+  {
+    const MaskImageType::IndexType & index = it.GetIndex();
+    const double dx = index[ 0 ] - 30.0;
+    const double dy = index[ 1 ] - 35.0;
+    const double dz = index[ 2 ] - 30.0;
+    const bool   inSphere = dx * dx + dy * dy + dz * dz < 22.0 * 22.0;
+    const bool   inBox    = index[ 0 ] > 50 && index[ 1 ] > 10 && index[ 2 ] < 40;
+    it.Set( ( inSphere || inBox ) ? 1 : 0 );
+  }
+
+  /** A typical schedule, with a non-monotonic last level. */
+  ScheduleType schedule( 4, Dimension );
+  for( unsigned int d = 0; d < Dimension; ++d )
+  {
+    schedule[ 0 ][ d ] = 8;
+    schedule[ 1 ][ d ] = 4;
+    schedule[ 2 ][ d ] = 1;
+    schedule[ 3 ][ d ] = 2;
+  }
+  schedule[ 1 ][ 2 ] = 2;
+
+  for( unsigned int moving = 0; moving < 2; ++moving )
+  {
+    /** Compute all levels at once. */
+    ErodeFilterType::Pointer allLevels = ErodeFilterType::New();
+    allLevels->SetInput( mask );
+    allLevels->SetSchedule( schedule );
+    allLevels->SetIsMovingMask( moving == 1 );
+    allLevels->ComputeAllLevelsOn();
+
+    itk::TimeProbe timer;
+    timer.Start();
+    allLevels->Update();
+    timer.Stop();
+    std::cerr << "IsMovingMask: " << moving << std::endl;
+    std::cerr << "  all levels at once: "
+              << std::setprecision( 4 ) << timer.GetMean() * 1000 << " ms" << std::endl;
+
+    /** Compare with the masks of each level computed separately. */
+    timer.Reset();
+    for( unsigned int level = 0; level < schedule.rows(); ++level )
+    {
+      ErodeFilterType::Pointer oneLevel = ErodeFilterType::New();
+      oneLevel->SetInput( mask );
+      oneLevel->SetSchedule( schedule );
+      oneLevel->SetIsMovingMask( moving == 1 );
+      oneLevel->SetResolutionLevel( level );
+
+      timer.Start();
+      oneLevel->Update();
+      timer.Stop();
+
+      itk::ImageRegionConstIterator< MaskImageType > itAll(
+        allLevels->GetOutput( level ), mask->GetLargestPossibleRegion() );
+      itk::ImageRegionConstIterator< MaskImageType > itOne(
+        oneLevel->GetOutput(), mask->GetLargestPossibleRegion() );
+      unsigned long numberOfDifferences = 0;
+      unsigned long numberOfInside      = 0;
+      for( ; !itOne.IsAtEnd(); ++itAll, ++itOne )
+      {
+        numberOfInside += itOne.Get() != 0;
+        if( ( itAll.Get() != 0 ) != ( itOne.Get() != 0 ) )
+        {
+          ++numberOfDifferences;
+        }
+      }
+
+      std::cerr << "  level " << level << ": " << numberOfInside
+                << " voxels inside the eroded mask" << std::endl;
+      if( numberOfDifferences != 0 )
+      {
+        std::cerr << "ERROR: the mask of level " << level << " differs in "
+                  << numberOfDifferences << " voxels when computing all levels at once."
+                  << std::endl;
+        return 1;
+      }
+    }
+    std::cerr << "  each level separately: "
+              << std::setprecision( 4 ) << timer.GetTotal() * 1000 << " ms" << std::endl;
+  }
+
+  std::cerr << "The results are good." << std::endl;
+
+  /** Return a value. */
+  return 0;
+
+} // end main
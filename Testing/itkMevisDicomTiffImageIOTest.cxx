@@ -32,7 +32,9 @@
 //-------------------------------------------------------------------------------------
 // This test tests the itkMevisDicomTiffImageIO library. The test is performed
 // in 2D, 3D, and 4D, for a unsigned char image. An artificial image is generated,
-// written to disk, read from disk, and compared to the original.
+// written to disk, read from disk, and compared to the original. The image is
+// also written in pieces, and a region of it is read, which only decodes the
+// tiles that overlap with that region.
 
 template< unsigned int Dimension >
 int
@@ -195,6 +197,70 @@ testMevis( void )
     return 1;
   }
 
+  /** Write the image in pieces, and read it back. */
+  typename WriterType::Pointer streamingWriter = WriterType::New();
+  typename ReaderType::Pointer streamedReader  = ReaderType::New();
+  std::string streamedfile( "testimageMevisDicomTiffStreamed.tif" );
+  streamingWriter->SetFileName( streamedfile );
+  streamingWriter->SetInput( inputImage );
+  streamingWriter->SetNumberOfStreamDivisions( 3 );
+  streamedReader->SetFileName( streamedfile );
+
+  /** Read a region that does not start or end at the tile boundaries. */
+  typename ReaderType::Pointer regionReader = ReaderType::New();
+  regionReader->SetFileName( testfile );
+  typename ImageType::RegionType region = inputImage->GetLargestPossibleRegion();
+  for( unsigned int i = 0; i < Dimension; ++i )
+  {
+    region.SetIndex( i, 1 + i );
+    region.SetSize( i, size[ i ] - 3 - i );
+  }
+
+  try
+  {
+    task = "Streamed writing";
+    streamingWriter->Update();
+    task = "Reading of the streamed image";
+    streamedReader->Update();
+    task = "Reading a region";
+    regionReader->UpdateOutputInformation();
+    regionReader->GetOutput()->SetRequestedRegion( region );
+    regionReader->Update();
+  }
+  catch( itk::ExceptionObject & err )
+  {
+    std::cerr << "ERROR: " << task << " mevis dicomtiff failed." << std::endl;
+    std::cerr << err << std::endl;
+    return 1;
+  }
+
+  comparisonFilter = ComparisonFilterType::New();
+  comparisonFilter->SetTestInput( streamedReader->GetOutput() );
+  comparisonFilter->SetValidInput( inputImage );
+  comparisonFilter->Update();
+  if( comparisonFilter->GetNumberOfPixelsWithDifferences() > 0 )
+  {
+    std::cerr << "ERROR: the pixel values are not correct after a streamed write" << std::endl;
+    return 1;
+  }
+
+  typename ImageType::Pointer regionImage = regionReader->GetOutput();
+  if( regionImage->GetBufferedRegion() != region )
+  {
+    std::cerr << "ERROR: the region that is read is " << regionImage->GetBufferedRegion()
+              << " instead of " << region << std::endl;
+    return 1;
+  }
+  IteratorType rit( regionImage, region );
+  for( rit.GoToBegin(); !rit.IsAtEnd(); ++rit )
+  {
+    if( rit.Get() != inputImage->GetPixel( rit.GetIndex() ) )
+    {
+      std::cerr << "ERROR: the pixel values are not correct after reading a region" << std::endl;
+      return 1;
+    }
+  }
+
   return 0;
 
 } // end templated function
@@ -0,0 +1,154 @@
+/*=========================================================================
+ *
+ *  Copyright UMC Utrecht and contributors
+ *
+ *  Licensed under the Apache License, Version 2.0 (the "License");
+ *  you may not use this file except in compliance with the License.
+ *  You may obtain a copy of the License at
+ *
+ *        http://www.apache.org/licenses/LICENSE-2.0.txt
+ *
+ *  Unless required by applicable law or agreed to in writing, software
+ *  distributed under the License is distributed on an "AS IS" BASIS,
+ *  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *  See the License for the specific language governing permissions and
+ *  limitations under the License.
+ *
+ *=========================================================================*/
+#include "itkParameterFileParser.h"
+#include "itkParameterMapInterface.h"
+#include "itkTimeProbe.h"
+
+#include <itksys/SystemTools.hxx>
+
+#include <cmath>
+#include <fstream>
+#include <iomanip>
+
+//-------------------------------------------------------------------------------------
+// Benchmark of reading a TransformParameters file of about 6 MB, as written
+// for a B-spline grid, and of reading its parameters. The reported throughput
+// shows how the parser scales to the files of dense grids.
+
+int
+main( int argc, char * argv[] )
+{
+  /** Check. */
+  if( argc != 2 )
+  {
+    std::cerr << "ERROR: You should specify an output directory." << std::endl;
+    return 1;
+  }
+  const std::string fileName = std::string( argv[ 1 ] )
+    + "/TransformParameters_ParameterFileParserTest.txt";
+
+  /** Write a transform parameter file with half a million parameters. */
+  const unsigned int numberOfParameters = 500000;
+  std::vector< double > parameters( numberOfParameters );
+  for( unsigned int i = 0; i < numberOfParameters; ++i )
+  {
+    parameters[ i ] = std::sin( 0.001 * i ) * ( 1.0 + i % 100 );
+  }
+
+  itk::TimeProbe timer;
+  timer.Start();
+  {
+    std::ofstream outfile( fileName.c_str() );
+    outfile << std::setprecision( 10 );
+    outfile << "(Transform \"BSplineTransform\")\n";
+    outfile << "(NumberOfParameters " << numberOfParameters << ")\n";
+    outfile << "(TransformParameters";
+    for( unsigned int i = 0; i < numberOfParameters; ++i )
+    {
+      outfile << " " << parameters[ i ];
+    }
+    outfile << ")\n";
+    outfile << "(InitialTransformParametersFileName \"NoInitialTransform\")\n";
+    outfile << "(GridSize 55 55 55)  // a comment\n";
+    outfile << "(HowToCombineTransforms \"Compose\")\n";
+  }
+  timer.Stop();
+  const double fileSize = static_cast< double >(
+    itksys::SystemTools::FileLength( fileName.c_str() ) );
+  std::cerr << "Writing the file of " << std::setprecision( 4 )
+            << fileSize / 1024.0 / 1024.0 << " MB took "
+            << timer.GetMean() << " s." << std::endl;
+
+  /** Parse the file. */
+  itk::ParameterFileParser::Pointer parser = itk::ParameterFileParser::New();
+  parser->SetParameterFileName( fileName );
+  timer.Reset();
+  timer.Start();
+  try
+  {
+    parser->ReadParameterFile();
+  }
+  catch( itk::ExceptionObject & e )
+  {
+    std::cerr << e << std::endl;
+    return 1;
+  }
+  timer.Stop();
+  std::cerr << "Parsing the file took " << timer.GetMean() << " s ("
+            << fileSize / 1024.0 / 1024.0 / timer.GetMean() << " MB/s)." << std::endl;
+
+  /** Parse the values. */
+  itk::ParameterMapInterface::Pointer parameterMapInterface
+    = itk::ParameterMapInterface::New();
+  timer.Reset();
+  timer.Start();
+  parameterMapInterface->SetParameterMap( parser->GetParameterMap() );
+  timer.Stop();
+  std::cerr << "Setting the parameter map took " << timer.GetMean() << " s." << std::endl;
+
+  /** Read all parameters, as done by the TransformBase. */
+  std::vector< double > readParameters( numberOfParameters, 0.0 );
+  std::string           errorMessage = "";
+  timer.Reset();
+  timer.Start();
+  bool found = parameterMapInterface->ReadParameter( readParameters,
+    "TransformParameters", 0, numberOfParameters - 1, true, errorMessage );
+  timer.Stop();
+  std::cerr << "Reading the TransformParameters took " << timer.GetMean() << " s." << std::endl;
+
+  /** Read a parameter many times, as done in every iteration. */
+  const unsigned int numberOfReads = 1000000;
+  unsigned int       gridSize = 0;
+  timer.Reset();
+  timer.Start();
+  for( unsigned int i = 0; i < numberOfReads; ++i )
+  {
+    found &= parameterMapInterface->ReadParameter( gridSize,
+      "GridSize", i % 3, false, errorMessage );
+  }
+  timer.Stop();
+  std::cerr << "Reading a parameter took " << timer.GetMean() / numberOfReads * 1.0e9
+            << " ns on average." << std::endl;
+
+  itksys::SystemTools::RemoveFile( fileName.c_str() );
+
+  /** Check the results. */
+  if( !found || gridSize != 55
+    || parameterMapInterface->CountNumberOfParameterEntries( "TransformParameters" )
+    != numberOfParameters )
+  {
+    std::cerr << "ERROR: not all parameters were found." << std::endl;
+    return 1;
+  }
+  for( unsigned int i = 0; i < numberOfParameters; ++i )
+  {
+    if( std::abs( readParameters[ i ] - parameters[ i ] )
+      > 1.0e-8 * ( 1.0 + std::abs( parameters[ i ] ) ) )
+    {
+      std::cerr << "ERROR: parameter " << i << " was read as " << readParameters[ i ]
+                << ", but it should be " << parameters[ i ] << "." << std::endl;
+      return 1;
+    }
+  }
+
+  std::cerr << "The results are good." << std::endl;
+
+  /** Return a value. */
+  return 0;
+
+} // end main
@@ -0,0 +1,216 @@
+/*=========================================================================
+ *
+ *  Copyright UMC Utrecht and contributors
+ *
+ *  Licensed under the Apache License, Version 2.0 (the "License");
+ *  you may not use this file except in compliance with the License.
+ *  You may obtain a copy of the License at
+ *
+ *        http://www.apache.org/licenses/LICENSE-2.0.txt
+ *
+ *  Unless required by applicable law or agreed to in writing, software
+ *  distributed under the License is distributed on an "AS IS" BASIS,
+ *  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *  See the License for the specific language governing permissions and
+ *  limitations under the License.
+ *
+ *=========================================================================*/
+#include "GradientDifference/itkGradientDifferenceImageToImageMetric2.h"
+#include "NormalizedGradientCorrelation/itkNormalizedGradientCorrelationImageToImageMetric.h"
+#include "PatternIntensity/itkPatternIntensityImageToImageMetric.h"
+#include "itkAdvancedCombinationTransform.h"
+#include "itkAdvancedEuler3DTransform.h"
+#include "itkAdvancedRayCastInterpolateImageFunction.h"
+#include "itkImageFullSampler.h"
+#include "itkImageRegionIterator.h"
+#include "itkMersenneTwisterRandomVariateGenerator.h"
+
+#include <algorithm>
+#include <cmath>
+#include <iomanip>
+
+//-------------------------------------------------------------------------------------
+// Checks that the 2D-3D metrics give the same value and derivative when they
+// are only evaluated at the samples of an image sampler (UseSampledEvaluation),
+// as when they are evaluated on the full projection, if all pixels of the
+// fixed image are sampled.
+
+const unsigned int Dimension = 3;
+typedef float                                                    PixelType;
+typedef itk::Image< PixelType, Dimension >                       ImageType;
+typedef itk::AdvancedCombinationTransform< double, Dimension >   CombinationTransformType;
+typedef itk::AdvancedEuler3DTransform< double >                  EulerTransformType;
+typedef itk::AdvancedRayCastInterpolateImageFunction<
+  ImageType, double >                                            RayCastInterpolatorType;
+typedef itk::ImageFullSampler< ImageType >                       SamplerType;
+typedef CombinationTransformType::ParametersType                 ParametersType;
+typedef itk::Statistics::MersenneTwisterRandomVariateGenerator   RandomGeneratorType;
+
+/** Fill an image with random values. */
+void
+FillRandom( ImageType * image, RandomGeneratorType * randomGenerator )
+{
+  image->Allocate();
+  itk::ImageRegionIterator< ImageType > it( image, image->GetLargestPossibleRegion() );
+  for( it.GoToBegin(); !it.IsAtEnd(); ++it )
+  {
+    it.Set( randomGenerator->GetUniformVariate( 0.0, 100.0 ) );
+  }
+
+} // end FillRandom()
+
+
+/** Create and initialize a metric, with its own transform and ray caster. */
+template< class TMetric >
+typename TMetric::Pointer
+CreateMetric( ImageType * fixedImage, ImageType * movingImage,
+  const bool useSampledEvaluation )
+{
+  EulerTransformType::Pointer       euler       = EulerTransformType::New();
+  CombinationTransformType::Pointer combination = CombinationTransformType::New();
+  combination->SetCurrentTransform( euler );
+
+  RayCastInterpolatorType::InputPointType focalPoint;
+  focalPoint.Fill( 0.0 );
+  focalPoint[ 2 ] = -100.0;
+  RayCastInterpolatorType::Pointer rayCaster = RayCastInterpolatorType::New();
+  rayCaster->SetTransform( combination );
+  rayCaster->SetFocalPoint( focalPoint );
+  rayCaster->SetThreshold( 0.0 );
+
+  typename TMetric::ScalesType scales( combination->GetNumberOfParameters() );
+  scales.Fill( 1.0 );
+
+  typename TMetric::Pointer metric = TMetric::New();
+  metric->SetFixedImage( fixedImage );
+  metric->SetMovingImage( movingImage );
+  metric->SetFixedImageRegion( fixedImage->GetLargestPossibleRegion() );
+  metric->SetTransform( combination.GetPointer() );
+  metric->SetInterpolator( rayCaster );
+  metric->SetScales( scales );
+  metric->SetNumberOfThreads( 2 );
+  metric->SetUseMultiThread( true );
+  metric->SetUseSampledEvaluation( useSampledEvaluation );
+  if( useSampledEvaluation )
+  {
+    metric->SetImageSampler( SamplerType::New() );
+  }
+  metric->Initialize();
+
+  return metric;
+
+} // end CreateMetric()
+
+
+/** Compare the sampled and the full evaluation of a metric. */
+template< class TMetric >
+bool
+CompareSampledWithFull( const char * name,
+  ImageType * fixedImage, ImageType * movingImage )
+{
+  typename TMetric::Pointer full    = CreateMetric< TMetric >( fixedImage, movingImage, false );
+  typename TMetric::Pointer sampled = CreateMetric< TMetric >( fixedImage, movingImage, true );
+
+  /** A small rotation and translation. */
+  ParametersType parameters( 6 );
+  parameters[ 0 ] = 0.02;
+  parameters[ 1 ] = -0.01;
+  parameters[ 2 ] = 0.03;
+  parameters[ 3 ] = 0.5;
+  parameters[ 4 ] = -0.3;
+  parameters[ 5 ] = 0.2;
+
+  const double fullValue    = full->GetValue( parameters );
+  const double sampledValue = sampled->GetValue( parameters );
+
+  typename TMetric::DerivativeType fullDerivative;
+  typename TMetric::DerivativeType sampledDerivative;
+  full->GetDerivative( parameters, fullDerivative );
+  sampled->GetDerivative( parameters, sampledDerivative );
+
+  std::cerr << name << ": full value = " << fullValue
+            << ", sampled value = " << sampledValue
+            << ", number of samples = " << sampled->GetNumberOfPixelsCounted() << std::endl;
+
+  const double tolerance = 1e-6;
+  if( sampled->GetNumberOfPixelsCounted() == 0 )
+  {
+    std::cerr << "ERROR: no samples were counted." << std::endl;
+    return false;
+  }
+  if( std::abs( sampledValue - fullValue ) > tolerance * std::max( 1.0, std::abs( fullValue ) ) )
+  {
+    std::cerr << "ERROR: the sampled value differs from the full value." << std::endl;
+    return false;
+  }
+  if( ( sampledDerivative - fullDerivative ).inf_norm()
+    > tolerance * std::max( 1.0, fullDerivative.inf_norm() ) )
+  {
+    std::cerr << "ERROR: the sampled derivative " << sampledDerivative
+              << " differs from the full derivative " << fullDerivative << std::endl;
+    return false;
+  }
+
+  return true;
+
+} // end CompareSampledWithFull()
+
+
+int
+main( int argc, char * argv[] )
+{
+  /** Typedefs. */
+  typedef itk::GradientDifferenceImageToImageMetric< ImageType, ImageType >            GDMetricType;
+  typedef itk::NormalizedGradientCorrelationImageToImageMetric< ImageType, ImageType > NGCMetricType;
+  typedef itk::PatternIntensityImageToImageMetric< ImageType, ImageType >              PIMetricType;
+
+  RandomGeneratorType::Pointer randomGenerator = RandomGeneratorType::GetInstance();
+  randomGenerator->SetSeed( 42 );
+
+  /** A small volume around the origin. */
+  ImageType::SizeType movingSize;
+  movingSize.Fill( 16 );
+  ImageType::PointType movingOrigin;
+  movingOrigin.Fill( -7.5 );
+  ImageType::Pointer movingImage = ImageType::New();
+  movingImage->SetRegions( movingSize );
+  movingImage->SetOrigin( movingOrigin );
+  FillRandom( movingImage, randomGenerator );
+
+  /** A small detector behind the volume, seen from the focal point. */
+  ImageType::SizeType fixedSize;
+  fixedSize[ 0 ] = 20;
+  fixedSize[ 1 ] = 20;
+  fixedSize[ 2 ] = 1;
+  ImageType::SpacingType fixedSpacing;
+  fixedSpacing.Fill( 2.0 );
+  ImageType::PointType fixedOrigin;
+  fixedOrigin[ 0 ] = -19.0;
+  fixedOrigin[ 1 ] = -19.0;
+  fixedOrigin[ 2 ] = 50.0;
+  ImageType::Pointer fixedImage = ImageType::New();
+  fixedImage->SetRegions( fixedSize );
+  fixedImage->SetSpacing( fixedSpacing );
+  fixedImage->SetOrigin( fixedOrigin );
+  FillRandom( fixedImage, randomGenerator );
+
+  std::cerr << std::setprecision( 10 );
+  try
+  {
+    if( !CompareSampledWithFull< GDMetricType >( "GradientDifference", fixedImage, movingImage )
+      || !CompareSampledWithFull< NGCMetricType >( "NormalizedGradientCorrelation", fixedImage, movingImage )
+      || !CompareSampledWithFull< PIMetricType >( "PatternIntensity", fixedImage, movingImage ) )
+    {
+      return 1;
+    }
+  }
+  catch( itk::ExceptionObject & excp )
+  {
+    std::cerr << excp << std::endl;
+    return 1;
+  }
+
+  /** Return a value. */
+  return 0;
+
+} // end main
@@ -0,0 +1,542 @@
+/*=========================================================================
+ *
+ *  Copyright UMC Utrecht and contributors
+ *
+ *  Licensed under the Apache License, Version 2.0 (the "License");
+ *  you may not use this file except in compliance with the License.
+ *  You may obtain a copy of the License at
+ *
+ *        http://www.apache.org/licenses/LICENSE-2.0.txt
+ *
+ *  Unless required by applicable law or agreed to in writing, software
+ *  distributed under the License is distributed on an "AS IS" BASIS,
+ *  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *  See the License for the specific language governing permissions and
+ *  limitations under the License.
+ *
+ *=========================================================================*/
+#include "RigidityPenalty/itkSeparableConvolutionEngine.h"
+#include "RigidityPenalty/itkTransformRigidityPenaltyTerm.h"
+#include "itkAdvancedBSplineDeformableTransform.h"
+#include "itkLinearInterpolateImageFunction.h"
+#include "itkNeighborhoodOperatorImageFilter.h"
+#include "itkImageRegionIterator.h"
+#include "itkImageRegionConstIteratorWithIndex.h"
+#include "itkMersenneTwisterRandomVariateGenerator.h"
+
+#include <algorithm>
+#include <cmath>
+#include <iomanip>
+
+//-------------------------------------------------------------------------------------
+// Checks the SeparableConvolutionEngine against the chain of
+// NeighborhoodOperatorImageFilters that the TransformRigidityPenaltyTerm
+// used before, on the coefficient images of a random B-spline grid:
+// - the engine outputs, for regions of interest inside the grid and at
+//   its borders;
+// - the rigidity penalty value, for a rigid region inside the grid and
+//   one at its border;
+// - the rigidity penalty derivative, by finite differences, which also
+//   checks the padded box around the rigid region.
+
+const unsigned int Dimension = 3;
+typedef float                                                         PixelType;
+typedef itk::Image< PixelType, Dimension >                            ImageType;
+typedef itk::AdvancedBSplineDeformableTransform< double, Dimension, 3 > TransformType;
+typedef TransformType::ParametersType                                 ParametersType;
+typedef TransformType::ImageType                                      CoefficientImageType;
+typedef CoefficientImageType::Pointer                                 CoefficientImagePointer;
+typedef CoefficientImageType::RegionType                              RegionType;
+typedef CoefficientImageType::SpacingType                             SpacingType;
+typedef itk::SeparableConvolutionEngine< CoefficientImageType >       EngineType;
+typedef EngineType::NeighborhoodType                                  NeighborhoodType;
+typedef EngineType::SeparableOperatorType                             SeparableOperatorType;
+typedef itk::NeighborhoodOperatorImageFilter<
+  CoefficientImageType, CoefficientImageType >                        NOIFType;
+typedef itk::TransformRigidityPenaltyTerm< ImageType, double >        RigidityPenaltyType;
+typedef RigidityPenaltyType::MeasureType                              MeasureType;
+typedef RigidityPenaltyType::DerivativeType                           DerivativeType;
+typedef itk::Statistics::MersenneTwisterRandomVariateGenerator        RandomGeneratorType;
+
+/** The three kinds of 1D kernels of the rigidity penalty term. */
+enum KernelKindType { Smooth, FirstDerivative, SecondDerivative };
+
+/** Create a 3-tap 1D operator along a dimension, like
+ * TransformRigidityPenaltyTerm::Create1DOperator() does.
+ */
+NeighborhoodType
+Create1DOperator( const unsigned int dimension, const KernelKindType kind, const double scale )
+{
+  NeighborhoodType::SizeType radius;
+  radius.Fill( 0 );
+  radius[ dimension ] = 1;
+  NeighborhoodType op;
+  op.SetRadius( radius );
+  if( kind == Smooth )
+  {
+    op[ 0 ] = 1.0 / 6.0; op[ 1 ] = 4.0 / 6.0; op[ 2 ] = 1.0 / 6.0;
+  }
+  else if( kind == FirstDerivative )
+  {
+    op[ 0 ] = -0.5 * scale; op[ 1 ] = 0.0; op[ 2 ] = 0.5 * scale;
+  }
+  else
+  {
+    op[ 0 ] = 0.5 * scale; op[ 1 ] = -1.0 * scale; op[ 2 ] = 0.5 * scale;
+  }
+  return op;
+
+} // end Create1DOperator()
+
+
+/** Create a separable operator from the kernels of the three dimensions. */
+SeparableOperatorType
+CreateSeparableOperator( const KernelKindType kind0, const double scale0,
+  const KernelKindType kind1, const double scale1,
+  const KernelKindType kind2, const double scale2 )
+{
+  SeparableOperatorType op( Dimension );
+  op[ 0 ] = Create1DOperator( 0, kind0, scale0 );
+  op[ 1 ] = Create1DOperator( 1, kind1, scale1 );
+  op[ 2 ] = Create1DOperator( 2, kind2, scale2 );
+  return op;
+
+} // end CreateSeparableOperator()
+
+
+/** Create the operators A, B, D, E, G, C, F, H and I of the rigidity
+ * penalty term, in the order in which it passes them to the engine.
+ */
+std::vector< SeparableOperatorType >
+CreateRigidityOperators( const SpacingType & s )
+{
+  std::vector< SeparableOperatorType > operators;
+  operators.push_back( CreateSeparableOperator( // A
+    FirstDerivative, 1.0 / s[ 0 ], Smooth, 1.0, Smooth, 1.0 ) );
+  operators.push_back( CreateSeparableOperator( // B
+    Smooth, 1.0, FirstDerivative, 1.0 / s[ 1 ], Smooth, 1.0 ) );
+  operators.push_back( CreateSeparableOperator( // D
+    SecondDerivative, 1.0 / ( s[ 0 ] * s[ 0 ] ), Smooth, 1.0, Smooth, 1.0 ) );
+  operators.push_back( CreateSeparableOperator( // E
+    Smooth, 1.0, SecondDerivative, 1.0 / ( s[ 1 ] * s[ 1 ] ), Smooth, 1.0 ) );
+  operators.push_back( CreateSeparableOperator( // G
+    FirstDerivative, 1.0 / ( s[ 0 ] * s[ 1 ] ),
+    FirstDerivative, 1.0 / ( s[ 0 ] * s[ 1 ] ), Smooth, 1.0 ) );
+  operators.push_back( CreateSeparableOperator( // C
+    Smooth, 1.0, Smooth, 1.0, FirstDerivative, 1.0 / s[ 2 ] ) );
+  operators.push_back( CreateSeparableOperator( // F
+    Smooth, 1.0, Smooth, 1.0, SecondDerivative, 1.0 / ( s[ 2 ] * s[ 2 ] ) ) );
+  operators.push_back( CreateSeparableOperator( // H
+    FirstDerivative, 1.0 / ( s[ 0 ] * s[ 2 ] ), Smooth, 1.0,
+    FirstDerivative, 1.0 / ( s[ 0 ] * s[ 2 ] ) ) );
+  operators.push_back( CreateSeparableOperator( // I
+    Smooth, 1.0, FirstDerivative, 1.0 / ( s[ 1 ] * s[ 2 ] ),
+    FirstDerivative, 1.0 / ( s[ 1 ] * s[ 2 ] ) ) );
+  return operators;
+
+} // end CreateRigidityOperators()
+
+
+/** Apply a separable operator with a chain of NeighborhoodOperatorImageFilters,
+ * to the complete image.
+ */
+CoefficientImagePointer
+FilterWithChain( CoefficientImageType * input, const SeparableOperatorType & op )
+{
+  NOIFType::Pointer filters[ Dimension ];
+  for( unsigned int d = 0; d < Dimension; ++d )
+  {
+    filters[ d ] = NOIFType::New();
+    filters[ d ]->SetOperator( op[ d ] );
+    if( d == 0 )
+    {
+      filters[ d ]->SetInput( input );
+    }
+    else
+    {
+      filters[ d ]->SetInput( filters[ d - 1 ]->GetOutput() );
+    }
+  }
+  filters[ Dimension - 1 ]->Update();
+
+  CoefficientImagePointer output = filters[ Dimension - 1 ]->GetOutput();
+  output->DisconnectPipeline();
+  return output;
+
+} // end FilterWithChain()
+
+
+/** Get the coefficient images of the transform, for some parameters. */
+std::vector< CoefficientImagePointer >
+GetCoefficientImages( TransformType * transform, const ParametersType & parameters )
+{
+  transform->SetParameters( parameters );
+  std::vector< CoefficientImagePointer > images( Dimension );
+  for( unsigned int i = 0; i < Dimension; ++i )
+  {
+    images[ i ] = transform->GetCoefficientImages()[ i ];
+  }
+  return images;
+
+} // end GetCoefficientImages()
+
+
+/** Compare the engine outputs with the chains, for a region of interest.
+ * Outside the region of interest the outputs should be zero.
+ */
+bool
+CompareEngineWithChain( EngineType * engine,
+  const std::vector< CoefficientImagePointer > & inputs,
+  const std::vector< SeparableOperatorType > & operators,
+  const RegionType & regionOfInterest )
+{
+  engine->SetRegionOfInterest( regionOfInterest );
+  engine->Filter( inputs );
+
+  const RegionType & imageRegion = inputs[ 0 ]->GetLargestPossibleRegion();
+  RegionType         croppedRegion = regionOfInterest;
+  if( !croppedRegion.Crop( imageRegion ) )
+  {
+    croppedRegion = RegionType();
+  }
+
+  const double tolerance = 1e-12;
+  for( unsigned int i = 0; i < inputs.size(); ++i )
+  {
+    for( unsigned int o = 0; o < operators.size(); ++o )
+    {
+      CoefficientImagePointer reference = FilterWithChain( inputs[ i ], operators[ o ] );
+      itk::ImageRegionConstIteratorWithIndex< CoefficientImageType > it( reference, imageRegion );
+      for( it.GoToBegin(); !it.IsAtEnd(); ++it )
+      {
+        const bool   inside   = croppedRegion.IsInside( it.GetIndex() );
+        const double expected = inside ? it.Get() : 0.0;
+        const double actual   = engine->GetOutput( i, o )->GetPixel( it.GetIndex() );
+        if( std::abs( actual - expected ) > tolerance * std::max( 1.0, std::abs( expected ) ) )
+        {
+          std::cerr << "ERROR: the engine output of input " << i << " and operator " << o
+                    << " at " << it.GetIndex() << " is " << actual << ", but should be "
+                    << expected << ", for the region of interest " << regionOfInterest << std::endl;
+          return false;
+        }
+      }
+    }
+  }
+
+  return true;
+
+} // end CompareEngineWithChain()
+
+
+/** Compute the linearity, orthonormality and properness conditions of the
+ * rigidity penalty term with the chains, over the complete grid.
+ */
+void
+ComputeReferenceConditions( const std::vector< CoefficientImagePointer > & inputs,
+  const CoefficientImageType * rigidityImage, const std::vector< SeparableOperatorType > & operators,
+  MeasureType & linearity, MeasureType & orthonormality, MeasureType & properness )
+{
+  /** Filter all inputs with all operators A, B, D, E, G, C, F, H and I. */
+  const unsigned int numberOfOperators = static_cast< unsigned int >( operators.size() );
+  std::vector< std::vector< CoefficientImagePointer > > filtered( Dimension );
+  for( unsigned int i = 0; i < Dimension; ++i )
+  {
+    filtered[ i ].resize( numberOfOperators );
+    for( unsigned int o = 0; o < numberOfOperators; ++o )
+    {
+      filtered[ i ][ o ] = FilterWithChain( inputs[ i ], operators[ o ] );
+    }
+  }
+
+  linearity      = 0.0;
+  orthonormality = 0.0;
+  properness     = 0.0;
+  double rigiditySum = 0.0;
+
+  const RegionType & region = rigidityImage->GetLargestPossibleRegion();
+  itk::ImageRegionConstIteratorWithIndex< CoefficientImageType > it( rigidityImage, region );
+  for( it.GoToBegin(); !it.IsAtEnd(); ++it )
+  {
+    const double                          w     = it.Get();
+    const CoefficientImageType::IndexType index = it.GetIndex();
+    rigiditySum += w;
+
+    double f[ Dimension ][ 9 ];
+    for( unsigned int i = 0; i < Dimension; ++i )
+    {
+      for( unsigned int o = 0; o < numberOfOperators; ++o )
+      {
+        f[ i ][ o ] = filtered[ i ][ o ]->GetPixel( index );
+      }
+    }
+
+    /** The first derivatives, as named in the rigidity penalty term. */
+    const double mu1_A = f[ 0 ][ 0 ], mu2_A = f[ 1 ][ 0 ], mu3_A = f[ 2 ][ 0 ];
+    const double mu1_B = f[ 0 ][ 1 ], mu2_B = f[ 1 ][ 1 ], mu3_B = f[ 2 ][ 1 ];
+    const double mu1_C = f[ 0 ][ 5 ], mu2_C = f[ 1 ][ 5 ], mu3_C = f[ 2 ][ 5 ];
+
+    orthonormality += w * (
+      std::pow( ( 1.0 + mu1_A ) * ( 1.0 + mu1_A ) + mu2_A * mu2_A + mu3_A * mu3_A - 1.0, 2.0 )
+      + std::pow( ( 1.0 + mu1_A ) * mu1_B + mu2_A * ( 1.0 + mu2_B ) + mu3_A * mu3_B, 2.0 )
+      + std::pow( ( 1.0 + mu1_A ) * mu1_C + mu2_A * mu2_C + mu3_A * ( 1.0 + mu3_C ), 2.0 )
+      + std::pow( mu1_B * mu1_B + ( 1.0 + mu2_B ) * ( 1.0 + mu2_B ) + mu3_B * mu3_B - 1.0, 2.0 )
+      + std::pow( mu1_B * mu1_C + ( 1.0 + mu2_B ) * mu2_C + mu3_B * ( 1.0 + mu3_C ), 2.0 )
+      + std::pow( mu1_C * mu1_C + mu2_C * mu2_C + ( 1.0 + mu3_C ) * ( 1.0 + mu3_C ) - 1.0, 2.0 ) );
+
+    properness += w * std::pow(
+      -mu1_C * ( 1.0 + mu2_B ) * mu3_A
+      + mu1_B * mu2_C * mu3_A
+      + mu1_C * mu2_A * mu3_B
+      - ( 1.0 + mu1_A ) * mu2_C * mu3_B
+      - mu1_B * mu2_A * ( 1.0 + mu3_C )
+      + ( 1.0 + mu1_A ) * ( 1.0 + mu2_B ) * ( 1.0 + mu3_C )
+      - 1.0, 2.0 );
+
+    /** The second derivatives D, E, G, F, H and I. */
+    const unsigned int secondDerivatives[ 6 ] = { 2, 3, 4, 6, 7, 8 };
+    for( unsigned int i = 0; i < Dimension; ++i )
+    {
+      for( unsigned int k = 0; k < 6; ++k )
+      {
+        const double value = f[ i ][ secondDerivatives[ k ] ];
+        linearity += w * value * value;
+      }
+    }
+  }
+
+  linearity      /= rigiditySum;
+  orthonormality /= rigiditySum;
+  properness     /= rigiditySum;
+
+} // end ComputeReferenceConditions()
+
+
+/** Compare two values, relative to the largest of 1 and the reference. */
+bool
+CompareValue( const char * name, const double actual, const double expected, const double tolerance )
+{
+  if( std::abs( actual - expected ) > tolerance * std::max( 1.0, std::abs( expected ) ) )
+  {
+    std::cerr << "ERROR: the " << name << " is " << actual
+              << ", but should be " << expected << "." << std::endl;
+    return false;
+  }
+  return true;
+
+} // end CompareValue()
+
+
+/** Compare the rigidity penalty term with the chains, for a rigid region.
+ * The derivative is compared with finite differences of the value, if requested.
+ */
+bool
+ComparePenaltyWithChain( const char * name, TransformType * transform, ImageType * image,
+  const ParametersType & parameters, const RegionType & rigidRegion,
+  const bool checkDerivative, RandomGeneratorType * randomGenerator )
+{
+  /** A rigidity image on the B-spline grid, which is nonzero in the rigid region only. */
+  CoefficientImagePointer rigidityImage = CoefficientImageType::New();
+  rigidityImage->SetRegions( transform->GetGridRegion() );
+  rigidityImage->SetSpacing( transform->GetGridSpacing() );
+  rigidityImage->SetOrigin( transform->GetGridOrigin() );
+  rigidityImage->SetDirection( transform->GetGridDirection() );
+  rigidityImage->Allocate();
+  rigidityImage->FillBuffer( 0.0 );
+  itk::ImageRegionIterator< CoefficientImageType > it( rigidityImage, rigidRegion );
+  for( it.GoToBegin(); !it.IsAtEnd(); ++it )
+  {
+    it.Set( randomGenerator->GetUniformVariate( 0.5, 1.0 ) );
+  }
+
+  RigidityPenaltyType::Pointer penalty = RigidityPenaltyType::New();
+  penalty->SetFixedImage( image );
+  penalty->SetMovingImage( image );
+  penalty->SetFixedImageRegion( image->GetLargestPossibleRegion() );
+  penalty->SetInterpolator( itk::LinearInterpolateImageFunction< ImageType, double >::New() );
+  penalty->SetTransform( transform );
+  penalty->SetNumberOfThreads( 3 );
+  penalty->SetUseFixedRigidityImage( true );
+  penalty->SetUseMovingRigidityImage( false );
+  penalty->SetFixedRigidityImage( rigidityImage );
+  penalty->SetDilateRigidityImages( false );
+  penalty->SetLinearityConditionWeight( 1.0 );
+  penalty->SetOrthonormalityConditionWeight( 2.0 );
+  penalty->SetPropernessConditionWeight( 0.5 );
+  penalty->Initialize();
+
+  /** The reference, with the chains over the complete grid. */
+  const std::vector< SeparableOperatorType > operators
+    = CreateRigidityOperators( transform->GetGridSpacing() );
+  MeasureType linearity = 0.0, orthonormality = 0.0, properness = 0.0;
+  ComputeReferenceConditions( GetCoefficientImages( transform, parameters ),
+    rigidityImage, operators, linearity, orthonormality, properness );
+  const MeasureType referenceValue = 1.0 * linearity + 2.0 * orthonormality + 0.5 * properness;
+
+  const double tolerance = 1e-10;
+  const MeasureType value = penalty->GetValue( parameters );
+  std::cerr << name << ": value = " << value << ", reference = " << referenceValue << std::endl;
+  if( !CompareValue( "linearity condition", penalty->GetLinearityConditionValue(), linearity, tolerance )
+    || !CompareValue( "orthonormality condition", penalty->GetOrthonormalityConditionValue(), orthonormality, tolerance )
+    || !CompareValue( "properness condition", penalty->GetPropernessConditionValue(), properness, tolerance )
+    || !CompareValue( "rigidity penalty value", value, referenceValue, tolerance ) )
+  {
+    return false;
+  }
+
+  MeasureType    valueWithDerivative = 0.0;
+  DerivativeType derivative;
+  penalty->GetValueAndDerivative( parameters, valueWithDerivative, derivative );
+  if( !CompareValue( "value of GetValueAndDerivative", valueWithDerivative, referenceValue, tolerance ) )
+  {
+    return false;
+  }
+  if( !checkDerivative )
+  {
+    return true;
+  }
+
+  /** Central differences of the value, for all parameters. */
+  const double   delta = 1e-5;
+  ParametersType perturbed( parameters );
+  DerivativeType finiteDifference( parameters.GetSize() );
+  for( unsigned int p = 0; p < parameters.GetSize(); ++p )
+  {
+    perturbed[ p ] = parameters[ p ] + delta;
+    const MeasureType plus = penalty->GetValue( perturbed );
+    perturbed[ p ] = parameters[ p ] - delta;
+    const MeasureType minus = penalty->GetValue( perturbed );
+    perturbed[ p ] = parameters[ p ];
+    finiteDifference[ p ] = ( plus - minus ) / ( 2.0 * delta );
+  }
+
+  const double derivativeTolerance = 1e-6;
+  const double norm                = finiteDifference.inf_norm();
+  const double difference          = ( derivative - finiteDifference ).inf_norm();
+  std::cerr << name << ": |derivative|_inf = " << norm
+            << ", |derivative - finite difference|_inf = " << difference << std::endl;
+  if( norm == 0.0 || difference > derivativeTolerance * std::max( 1.0, norm ) )
+  {
+    std::cerr << "ERROR: the derivative differs from the finite differences of the value." << std::endl;
+    return false;
+  }
+
+  return true;
+
+} // end ComparePenaltyWithChain()
+
+
+int
+main( int argc, char * argv[] )
+{
+  RandomGeneratorType::Pointer randomGenerator = RandomGeneratorType::GetInstance();
+  randomGenerator->SetSeed( 42 );
+
+  /** A random B-spline grid, with a different size and spacing per dimension. */
+  TransformType::SizeType gridSize;
+  gridSize[ 0 ] = 9; gridSize[ 1 ] = 8; gridSize[ 2 ] = 7;
+  TransformType::SpacingType gridSpacing;
+  gridSpacing[ 0 ] = 2.0; gridSpacing[ 1 ] = 3.0; gridSpacing[ 2 ] = 4.0;
+  TransformType::OriginType gridOrigin;
+  gridOrigin.Fill( -6.0 );
+  TransformType::DirectionType gridDirection;
+  gridDirection.SetIdentity();
+
+  TransformType::Pointer transform = TransformType::New();
+  transform->SetGridOrigin( gridOrigin );
+  transform->SetGridSpacing( gridSpacing );
+  transform->SetGridRegion( RegionType( gridSize ) );
+  transform->SetGridDirection( gridDirection );
+
+  ParametersType parameters( transform->GetNumberOfParameters() );
+  for( unsigned int i = 0; i < parameters.GetSize(); ++i )
+  {
+    parameters[ i ] = randomGenerator->GetUniformVariate( -1.0, 1.0 );
+  }
+
+  std::cerr << std::setprecision( 12 );
+  try
+  {
+    /** Compare the engine with the chains, on the coefficient images. */
+    const std::vector< CoefficientImagePointer > inputs
+      = GetCoefficientImages( transform, parameters );
+    const std::vector< SeparableOperatorType > operators
+      = CreateRigidityOperators( gridSpacing );
+
+    EngineType::Pointer engine = EngineType::New();
+    engine->SetNumberOfThreads( 3 );
+    engine->SetOperators( operators );
+
+    /** The regions of interest: the complete grid, the interior, the lower
+     * and upper corners, a single pixel at the border, a region that sticks
+     * out of the grid, and the interior again, after a larger region.
+     */
+    std::vector< RegionType > regions;
+    RegionType::IndexType     index;
+    RegionType::SizeType      size;
+    regions.push_back( RegionType( gridSize ) );
+    index[ 0 ] = 2; index[ 1 ] = 3; index[ 2 ] = 1;
+    size[ 0 ]  = 4; size[ 1 ]  = 3; size[ 2 ]  = 4;
+    regions.push_back( RegionType( index, size ) );
+    index.Fill( 0 );
+    size.Fill( 2 );
+    regions.push_back( RegionType( index, size ) );
+    index[ 0 ] = 6; index[ 1 ] = 5; index[ 2 ] = 4;
+    size.Fill( 3 );
+    regions.push_back( RegionType( index, size ) );
+    index[ 0 ] = 8; index[ 1 ] = 7; index[ 2 ] = 0;
+    size.Fill( 1 );
+    regions.push_back( RegionType( index, size ) );
+    index.Fill( -2 );
+    size.Fill( 5 );
+    regions.push_back( RegionType( index, size ) );
+    regions.push_back( RegionType( gridSize ) );
+    const RegionType interiorRegion = regions[ 1 ];
+    regions.push_back( interiorRegion );
+
+    for( unsigned int r = 0; r < regions.size(); ++r )
+    {
+      if( !CompareEngineWithChain( engine, inputs, operators, regions[ r ] ) )
+      {
+        return 1;
+      }
+    }
+    std::cerr << "The engine outputs match the chains for all regions of interest." << std::endl;
+
+    /** An image that covers the grid. */
+    ImageType::SizeType imageSize;
+    imageSize.Fill( 16 );
+    ImageType::Pointer image = ImageType::New();
+    image->SetRegions( imageSize );
+    image->Allocate();
+    image->FillBuffer( 1.0f );
+
+    /** Compare the penalty term for a rigid region inside the grid, such that
+     * the padded box around it is inside the grid too, and the derivative.
+     */
+    index[ 0 ] = 3; index[ 1 ] = 3; index[ 2 ] = 2;
+    size[ 0 ]  = 3; size[ 1 ]  = 2; size[ 2 ]  = 3;
+    if( !ComparePenaltyWithChain( "interior rigid region", transform, image,
+      parameters, RegionType( index, size ), true, randomGenerator ) )
+    {
+      return 1;
+    }
+
+    /** Compare the penalty value for a rigid region at the upper border of the grid. */
+    index[ 0 ] = 6; index[ 1 ] = 5; index[ 2 ] = 0;
+    size[ 0 ]  = 3; size[ 1 ]  = 3; size[ 2 ]  = 2;
+    if( !ComparePenaltyWithChain( "border rigid region", transform, image,
+      parameters, RegionType( index, size ), false, randomGenerator ) )
+    {
+      return 1;
+    }
+  }
+  catch( itk::ExceptionObject & excp )
+  {
+    std::cerr << excp << std::endl;
+    return 1;
+  }
+
+  /** Return a value. */
+  return 0;
+
+} // end main
@@ -0,0 +1,221 @@
+/*=========================================================================
+ *
+ *  Copyright UMC Utrecht and contributors
+ *
+ *  Licensed under the Apache License, Version 2.0 (the "License");
+ *  you may not use this file except in compliance with the License.
+ *  You may obtain a copy of the License at
+ *
+ *        http://www.apache.org/licenses/LICENSE-2.0.txt
+ *
+ *  Unless required by applicable law or agreed to in writing, software
+ *  distributed under the License is distributed on an "AS IS" BASIS,
+ *  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *  See the License for the specific language governing permissions and
+ *  limitations under the License.
+ *
+ *=========================================================================*/
+#include "itkStackTransform.h"
+#include "itkAdvancedBSplineDeformableTransform.h"
+#include "itkMersenneTwisterRandomVariateGenerator.h"
+
+// Report timings
+#include "itkTimeProbe.h"
+
+#include <algorithm>
+#include <iomanip>
+
+//-------------------------------------------------------------------------------------
+// Compares the serial evaluation of a stack of B-spline transforms, point by
+// point, with the evaluation of batches of points by TransformPoints() and
+// GetJacobians(), for 20 to 100 time points.
+
+int
+main( int argc, char * argv[] )
+{
+  /** Typedefs. */
+  const unsigned int Dimension   = 4;
+  const unsigned int SplineOrder = 3;
+  typedef double CoordinateRepresentationType;
+
+  typedef itk::StackTransform<
+    CoordinateRepresentationType, Dimension, Dimension >      StackTransformType;
+  typedef itk::AdvancedBSplineDeformableTransform<
+    CoordinateRepresentationType, Dimension - 1, SplineOrder > BSplineTransformType;
+
+  typedef StackTransformType::InputPointType                      InputPointType;
+  typedef StackTransformType::OutputPointType                     OutputPointType;
+  typedef StackTransformType::ParametersType                      ParametersType;
+  typedef StackTransformType::JacobianType                        JacobianType;
+  typedef StackTransformType::NonZeroJacobianIndicesType          NonZeroJacobianIndicesType;
+  typedef StackTransformType::InputPointContainerType             InputPointContainerType;
+  typedef StackTransformType::OutputPointContainerType            OutputPointContainerType;
+  typedef StackTransformType::JacobianContainerType               JacobianContainerType;
+  typedef StackTransformType::NonZeroJacobianIndicesContainerType NonZeroJacobianIndicesContainerType;
+
+  typedef BSplineTransformType::ImageType ImageType;
+  typedef ImageType::RegionType           RegionType;
+  typedef ImageType::SizeType             SizeType;
+  typedef ImageType::IndexType            IndexType;
+  typedef ImageType::SpacingType          SpacingType;
+  typedef ImageType::PointType            OriginType;
+  typedef ImageType::DirectionType        DirectionType;
+
+  typedef itk::Statistics::MersenneTwisterRandomVariateGenerator RandomGeneratorType;
+
+  /** The number of points per time point. Distinguish between
+   * Debug and Release mode.
+   */
+#ifndef NDEBUG
+  const unsigned int pointsPerTimePoint = 200;
+#else
+  const unsigned int pointsPerTimePoint = 5000;
+#endif
+
+  /** The Jacobian of a point takes about 7.5 KB, so the Jacobians are
+   * computed in chunks of points, reusing the containers of the results.
+   */
+  const unsigned int jacobianChunkSize = 1024;
+
+  /** Setup a B-spline sub transform with a grid of 12 x 12 x 12 control points. */
+  SizeType gridSize;
+  gridSize.Fill( 12 );
+  IndexType gridIndex;
+  gridIndex.Fill( 0 );
+  SpacingType gridSpacing;
+  gridSpacing.Fill( 10.0 );
+  OriginType gridOrigin;
+  gridOrigin.Fill( -15.0 );
+  DirectionType gridDirection;
+  gridDirection.SetIdentity();
+
+  BSplineTransformType::Pointer subTransform = BSplineTransformType::New();
+  subTransform->SetGridOrigin( gridOrigin );
+  subTransform->SetGridSpacing( gridSpacing );
+  subTransform->SetGridRegion( RegionType( gridIndex, gridSize ) );
+  subTransform->SetGridDirection( gridDirection );
+  ParametersType subParameters( subTransform->GetNumberOfParameters() );
+  subParameters.Fill( 0.0 );
+  subTransform->SetParameters( subParameters );
+
+  RandomGeneratorType::Pointer randomGenerator = RandomGeneratorType::GetInstance();
+  randomGenerator->SetSeed( 42 );
+
+  std::cerr << std::setprecision( 4 );
+  std::cerr << "Points per time point = " << pointsPerTimePoint << std::endl;
+
+  const unsigned int numbersOfTimePoints[] = { 20, 50, 100 };
+  for( unsigned int n = 0; n < 3; ++n )
+  {
+    const unsigned int numberOfTimePoints = numbersOfTimePoints[ n ];
+
+    /** Create the stack transform, with random parameters. */
+    StackTransformType::Pointer stackTransform = StackTransformType::New();
+    stackTransform->SetNumberOfSubTransforms( numberOfTimePoints );
+    stackTransform->SetStackOrigin( 0.0 );
+    stackTransform->SetStackSpacing( 1.0 );
+    stackTransform->SetAllSubTransforms( subTransform );
+
+    ParametersType parameters( stackTransform->GetNumberOfParameters() );
+    for( unsigned int i = 0; i < parameters.GetSize(); ++i )
+    {
+      parameters[ i ] = randomGenerator->GetUniformVariate( -2.0, 2.0 );
+    }
+    stackTransform->SetParameters( parameters );
+
+    /** Sample random points inside the grid. Like the samples of the groupwise
+     * metrics, consecutive points are in different time points.
+     */
+    InputPointContainerType points( numberOfTimePoints * pointsPerTimePoint );
+    for( unsigned int i = 0; i < points.size(); ++i )
+    {
+      for( unsigned int d = 0; d < Dimension - 1; ++d )
+      {
+        points[ i ][ d ] = randomGenerator->GetUniformVariate( 0.0, 80.0 );
+      }
+      points[ i ][ Dimension - 1 ] = i % numberOfTimePoints;
+    }
+
+    /** Time the transformation of the points. */
+    OutputPointContainerType serialPoints( points.size() );
+    OutputPointContainerType batchPoints;
+    itk::TimeProbe           timeProbeSerialPoints, timeProbeBatchPoints;
+
+    timeProbeSerialPoints.Start();
+    for( unsigned int i = 0; i < points.size(); ++i )
+    {
+      serialPoints[ i ] = stackTransform->TransformPoint( points[ i ] );
+    }
+    timeProbeSerialPoints.Stop();
+
+    timeProbeBatchPoints.Start();
+    stackTransform->TransformPoints( points, batchPoints );
+    timeProbeBatchPoints.Stop();
+
+    for( unsigned int i = 0; i < points.size(); ++i )
+    {
+      if( serialPoints[ i ].EuclideanDistanceTo( batchPoints[ i ] ) > 1e-10 )
+      {
+        std::cerr << "ERROR: the batch result of point " << points[ i ]
+                  << " differs from the serial result." << std::endl;
+        return 1;
+      }
+    }
+
+    /** Time the computation of the Jacobians, per chunk of points. Since
+     * consecutive points are in different time points, a chunk covers all
+     * sub transforms.
+     */
+    InputPointContainerType             chunk;
+    JacobianType                        serialJacobian;
+    NonZeroJacobianIndicesType          serialNzji;
+    JacobianContainerType               batchJacobians;
+    NonZeroJacobianIndicesContainerType batchNzjis;
+    itk::TimeProbe                      timeProbeSerialJacobians, timeProbeBatchJacobians;
+    for( unsigned int begin = 0; begin < points.size(); begin += jacobianChunkSize )
+    {
+      const unsigned int end = std::min( begin + jacobianChunkSize,
+        static_cast< unsigned int >( points.size() ) );
+      chunk.assign( points.begin() + begin, points.begin() + end );
+
+      timeProbeSerialJacobians.Start();
+      for( unsigned int i = 0; i < chunk.size(); ++i )
+      {
+        stackTransform->GetJacobian( chunk[ i ], serialJacobian, serialNzji );
+      }
+      timeProbeSerialJacobians.Stop();
+
+      timeProbeBatchJacobians.Start();
+      stackTransform->GetJacobians( chunk, batchJacobians, batchNzjis );
+      timeProbeBatchJacobians.Stop();
+    }
+
+    /** Check the Jacobians of the last chunk. */
+    for( unsigned int i = 0; i < chunk.size(); ++i )
+    {
+      stackTransform->GetJacobian( chunk[ i ], serialJacobian, serialNzji );
+      if( serialNzji != batchNzjis[ i ]
+        || ( serialJacobian - batchJacobians[ i ] ).array_inf_norm() > 1e-10 )
+      {
+        std::cerr << "ERROR: the batch Jacobian of point " << chunk[ i ]
+                  << " differs from the serial Jacobian." << std::endl;
+        return 1;
+      }
+    }
+
+    /** Report timings. */
+    std::cerr << "Time points = " << numberOfTimePoints << std::endl;
+    std::cerr << "  TransformPoint: serial = " << timeProbeSerialPoints.GetMean()
+              << " s, batch = " << timeProbeBatchPoints.GetMean()
+              << " s, speedup factor = "
+              << timeProbeSerialPoints.GetMean() / timeProbeBatchPoints.GetMean() << std::endl;
+    std::cerr << "  GetJacobian:    serial = " << timeProbeSerialJacobians.GetTotal()
+              << " s, batch = " << timeProbeBatchJacobians.GetTotal()
+              << " s, speedup factor = "
+              << timeProbeSerialJacobians.GetTotal() / timeProbeBatchJacobians.GetTotal() << std::endl;
+  }
+
+  /** Return a value. */
+  return 0;
+
+} // end main
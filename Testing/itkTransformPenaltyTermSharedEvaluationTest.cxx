@@ -0,0 +1,237 @@
+/*=========================================================================
+ *
+ *  Copyright UMC Utrecht and contributors
+ *
+ *  Licensed under the Apache License, Version 2.0 (the "License");
+ *  you may not use this file except in compliance with the License.
+ *  You may obtain a copy of the License at
+ *
+ *        http://www.apache.org/licenses/LICENSE-2.0.txt
+ *
+ *  Unless required by applicable law or agreed to in writing, software
+ *  distributed under the License is distributed on an "AS IS" BASIS,
+ *  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *  See the License for the specific language governing permissions and
+ *  limitations under the License.
+ *
+ *=========================================================================*/
+#include "BendingEnergyPenalty/itkTransformBendingEnergyPenaltyTerm.h"
+#include "DisplacementMagnitudePenalty/itkDisplacementMagnitudePenaltyTerm.h"
+#include "itkAdvancedBSplineDeformableTransform.h"
+#include "itkImageGridSampler.h"
+#include "itkLinearInterpolateImageFunction.h"
+#include "itkMersenneTwisterRandomVariateGenerator.h"
+#include "itkImageRegionIterator.h"
+
+#include <algorithm>
+#include <cmath>
+#include <iomanip>
+
+//-------------------------------------------------------------------------------------
+// Checks that the shared evaluation of the transform penalty terms, as done
+// by the CombinationImageToImageMetric, gives the same value, derivative and
+// number of counted samples as the standalone GetValueAndDerivative().
+
+const unsigned int Dimension = 3;
+typedef float                                     PixelType;
+typedef itk::Image< PixelType, Dimension >        ImageType;
+typedef itk::TransformPenaltyTerm< ImageType >    PenaltyTermType;
+typedef PenaltyTermType::ParametersType           ParametersType;
+typedef PenaltyTermType::MeasureType              MeasureType;
+typedef PenaltyTermType::DerivativeType           DerivativeType;
+typedef PenaltyTermType::SampleType               SampleType;
+typedef PenaltyTermType::ImageSampleContainerType ImageSampleContainerType;
+
+/** Compute the value and derivative of a penalty term the way the
+ * CombinationImageToImageMetric does, with the samples split over the threads.
+ */
+bool
+GetSharedValueAndDerivative( PenaltyTermType * penalty,
+  const ParametersType & parameters, const unsigned int numberOfThreads,
+  MeasureType & value, DerivativeType & derivative )
+{
+  penalty->SetUseMetricSingleThreaded( true );
+  penalty->BeforeThreadedGetValueAndDerivative( parameters );
+  penalty->SetUseMetricSingleThreaded( false );
+
+  if( !penalty->CanAccumulateSamples( numberOfThreads ) )
+  {
+    std::cerr << "ERROR: " << penalty->GetNameOfClass()
+              << " cannot accumulate samples." << std::endl;
+    return false;
+  }
+
+  const ImageSampleContainerType * sampleContainer
+    = penalty->GetImageSampler()->GetOutput();
+  const unsigned long numberOfSamples = sampleContainer->Size();
+  const unsigned long perThread
+    = ( numberOfSamples + numberOfThreads - 1 ) / numberOfThreads;
+
+  SampleType sample;
+  for( unsigned int threadId = 0; threadId < numberOfThreads; ++threadId )
+  {
+    const unsigned long begin = std::min( threadId * perThread, numberOfSamples );
+    const unsigned long end   = std::min( begin + perThread, numberOfSamples );
+    for( unsigned long i = begin; i < end; ++i )
+    {
+      if( penalty->EvaluateSample( sampleContainer->ElementAt( i ).m_ImageCoordinates,
+        penalty->GetSampleRequirements(), sample ) )
+      {
+        penalty->AccumulateSample( threadId, sample );
+      }
+    }
+  }
+
+  penalty->AfterAccumulateSamples( value, derivative );
+  return true;
+
+} // end GetSharedValueAndDerivative()
+
+
+/** Compare the standalone and the shared evaluation of a penalty term. */
+bool
+CompareSharedWithStandalone( PenaltyTermType * penalty,
+  const ParametersType & parameters, const unsigned int numberOfThreads )
+{
+  MeasureType    standaloneValue = 0.0;
+  DerivativeType standaloneDerivative;
+  penalty->GetValueAndDerivative( parameters, standaloneValue, standaloneDerivative );
+  const unsigned long standaloneCount = penalty->GetNumberOfPixelsCounted();
+
+  MeasureType    sharedValue = 0.0;
+  DerivativeType sharedDerivative;
+  if( !GetSharedValueAndDerivative( penalty, parameters, numberOfThreads,
+    sharedValue, sharedDerivative ) )
+  {
+    return false;
+  }
+  const unsigned long sharedCount = penalty->GetNumberOfPixelsCounted();
+
+  std::cerr << penalty->GetNameOfClass() << ": standalone value = "
+            << standaloneValue << ", shared value = " << sharedValue
+            << ", counted samples = " << standaloneCount << std::endl;
+
+  const double tolerance = 1e-10;
+  if( standaloneCount == 0 || sharedCount != standaloneCount )
+  {
+    std::cerr << "ERROR: the number of counted samples of the shared evaluation ("
+              << sharedCount << ") differs from the standalone evaluation ("
+              << standaloneCount << ")." << std::endl;
+    return false;
+  }
+  if( std::abs( sharedValue - standaloneValue )
+    > tolerance * std::max( 1.0, std::abs( standaloneValue ) ) )
+  {
+    std::cerr << "ERROR: the value of the shared evaluation differs from the "
+              << "standalone evaluation." << std::endl;
+    return false;
+  }
+  if( sharedDerivative.GetSize() != standaloneDerivative.GetSize()
+    || ( sharedDerivative - standaloneDerivative ).inf_norm()
+    > tolerance * std::max( 1.0, standaloneDerivative.inf_norm() ) )
+  {
+    std::cerr << "ERROR: the derivative of the shared evaluation differs from the "
+              << "standalone evaluation." << std::endl;
+    return false;
+  }
+
+  return true;
+
+} // end CompareSharedWithStandalone()
+
+
+int
+main( int argc, char * argv[] )
+{
+  /** Typedefs. */
+  typedef itk::AdvancedBSplineDeformableTransform< double, Dimension, 3 > TransformType;
+  typedef itk::TransformBendingEnergyPenaltyTerm< ImageType >             BendingEnergyType;
+  typedef itk::DisplacementMagnitudePenaltyTerm< ImageType >              DisplacementMagnitudeType;
+  typedef itk::ImageGridSampler< ImageType >                              SamplerType;
+  typedef itk::LinearInterpolateImageFunction< ImageType, double >        InterpolatorType;
+  typedef itk::Statistics::MersenneTwisterRandomVariateGenerator          RandomGeneratorType;
+
+  const unsigned int numberOfThreads = 4;
+
+  RandomGeneratorType::Pointer randomGenerator = RandomGeneratorType::GetInstance();
+  randomGenerator->SetSeed( 42 );
+
+  /** Create a small image with random values. */
+  ImageType::SizeType imageSize;
+  imageSize.Fill( 20 );
+  ImageType::Pointer image = ImageType::New();
+  image->SetRegions( imageSize );
+  image->Allocate();
+  itk::ImageRegionIterator< ImageType > it( image, image->GetLargestPossibleRegion() );
+  for( it.GoToBegin(); !it.IsAtEnd(); ++it )
+  {
+    it.Set( randomGenerator->GetUniformVariate( 0.0, 100.0 ) );
+  }
+
+  /** Create a B-spline transform covering the image, with random parameters. */
+  TransformType::OriginType gridOrigin;
+  gridOrigin.Fill( -5.0 );
+  TransformType::SpacingType gridSpacing;
+  gridSpacing.Fill( 5.0 );
+  TransformType::SizeType gridSize;
+  gridSize.Fill( 7 );
+  TransformType::DirectionType gridDirection;
+  gridDirection.SetIdentity();
+
+  TransformType::Pointer transform = TransformType::New();
+  transform->SetGridOrigin( gridOrigin );
+  transform->SetGridSpacing( gridSpacing );
+  transform->SetGridRegion( TransformType::RegionType( gridSize ) );
+  transform->SetGridDirection( gridDirection );
+
+  ParametersType parameters( transform->GetNumberOfParameters() );
+  for( unsigned int i = 0; i < parameters.GetSize(); ++i )
+  {
+    parameters[ i ] = randomGenerator->GetUniformVariate( -1.0, 1.0 );
+  }
+  transform->SetParameters( parameters );
+
+  /** Sample every other voxel. */
+  SamplerType::SampleGridSpacingType samplingSpacing;
+  samplingSpacing.Fill( 2 );
+  SamplerType::Pointer sampler = SamplerType::New();
+  sampler->SetSampleGridSpacing( samplingSpacing );
+
+  /** Create the penalty terms, sharing the sampler and the transform. */
+  BendingEnergyType::Pointer         bendingEnergy         = BendingEnergyType::New();
+  DisplacementMagnitudeType::Pointer displacementMagnitude = DisplacementMagnitudeType::New();
+  PenaltyTermType *                  penalties[ 2 ]        = {
+    bendingEnergy.GetPointer(), displacementMagnitude.GetPointer() };
+
+  std::cerr << std::setprecision( 10 );
+  for( unsigned int p = 0; p < 2; ++p )
+  {
+    PenaltyTermType * penalty = penalties[ p ];
+    penalty->SetFixedImage( image );
+    penalty->SetMovingImage( image );
+    penalty->SetFixedImageRegion( image->GetLargestPossibleRegion() );
+    penalty->SetInterpolator( InterpolatorType::New() );
+    penalty->SetTransform( transform.GetPointer() );
+    penalty->SetImageSampler( sampler );
+    penalty->SetNumberOfThreads( numberOfThreads );
+    penalty->SetUseMultiThread( true );
+    try
+    {
+      penalty->Initialize();
+    }
+    catch( itk::ExceptionObject & excp )
+    {
+      std::cerr << excp << std::endl;
+      return 1;
+    }
+
+    if( !CompareSharedWithStandalone( penalty, parameters, numberOfThreads ) )
+    {
+      return 1;
+    }
+  }
+
+  /** Return a value. */
+  return 0;
+
+} // end main
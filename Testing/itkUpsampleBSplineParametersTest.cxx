@@ -0,0 +1,330 @@
+/*=========================================================================
+ *
+ *  Copyright UMC Utrecht and contributors
+ *
+ *  Licensed under the Apache License, Version 2.0 (the "License");
+ *  you may not use this file except in compliance with the License.
+ *  You may obtain a copy of the License at
+ *
+ *        http://www.apache.org/licenses/LICENSE-2.0.txt
+ *
+ *  Unless required by applicable law or agreed to in writing, software
+ *  distributed under the License is distributed on an "AS IS" BASIS,
+ *  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *  See the License for the specific language governing permissions and
+ *  limitations under the License.
+ *
+ *=========================================================================*/
+#include "itkUpsampleBSplineParametersFilter.h"
+#include "itkArray.h"
+#include "itkImage.h"
+#include "itkMersenneTwisterRandomVariateGenerator.h"
+
+#include <algorithm>
+#include <cmath>
+#include <cstdlib>
+#include <iostream>
+#include <sstream>
+#include <string>
+#include <vector>
+
+//-------------------------------------------------------------------------------------
+// Checks the upsampling of B-spline parameters from a grid to a grid with
+// half the spacing, for spline orders 1, 2 and 3, in 2D and 3D:
+// - for odd orders, the spline of the coefficients of the dyadic refinement
+//   should equal the spline of the current coefficients everywhere, so at
+//   the required grid nodes and between them;
+// - for order 3, the spline of the coefficients of the general resampling
+//   should equal the spline of the current coefficients at the required grid
+//   nodes. The resampling evaluates the current coefficients as a cubic
+//   spline, so this only holds for order 3;
+// - for order 2, and for grids that are not a dyadic refinement, the filter
+//   should fall back to the general resampling.
+// The splines are evaluated directly, as the sum of the coefficients times
+// the B-spline basis functions.
+
+typedef itk::Array< double >                                   ArrayType;
+typedef itk::Statistics::MersenneTwisterRandomVariateGenerator RandomGeneratorType;
+
+/** The centered B-spline of order 1, 2 or 3. */
+double
+BSplineKernel( const unsigned int order, const double u )
+{
+  const double a = std::abs( u );
+  if( order == 1 )
+  {
+    return a < 1.0 ? 1.0 - a : 0.0;
+  }
+  if( order == 2 )
+  {
+    if( a < 0.5 )
+    {
+      return 0.75 - a * a;
+    }
+    return a < 1.5 ? 0.5 * ( 1.5 - a ) * ( 1.5 - a ) : 0.0;
+  }
+  if( a < 1.0 )
+  {
+    return ( 4.0 - 6.0 * a * a + 3.0 * a * a * a ) / 6.0;
+  }
+  return a < 2.0 ? ( 2.0 - a ) * ( 2.0 - a ) * ( 2.0 - a ) / 6.0 : 0.0;
+
+} // end BSplineKernel()
+
+
+/** Evaluate component j of a spline at the continuous index cindex of its grid. */
+double
+EvaluateSpline( const ArrayType & parameters, const std::vector< unsigned int > & gridSize,
+  const unsigned int order, const unsigned int j, const std::vector< double > & cindex )
+{
+  const unsigned int dimension          = gridSize.size();
+  unsigned int       numberOfGridPoints = 1;
+  for( unsigned int d = 0; d < dimension; ++d )
+  {
+    numberOfGridPoints *= gridSize[ d ];
+  }
+
+  double value = 0.0;
+  for( unsigned int k = 0; k < numberOfGridPoints; ++k )
+  {
+    double       weight = 1.0;
+    unsigned int rest   = k;
+    for( unsigned int d = 0; d < dimension; ++d )
+    {
+      weight *= BSplineKernel( order, cindex[ d ] - static_cast< double >( rest % gridSize[ d ] ) );
+      rest   /= gridSize[ d ];
+    }
+    value += weight * parameters[ j * numberOfGridPoints + k ];
+  }
+  return value;
+
+} // end EvaluateSpline()
+
+
+/** Compare the spline of the required grid with the spline of the current
+ * grid, at a lattice with the given step in required grid units.
+ */
+bool
+CompareSplines( const std::string & name,
+  const ArrayType & currentParameters, const std::vector< unsigned int > & currentSize,
+  const ArrayType & requiredParameters, const std::vector< unsigned int > & requiredSize,
+  const unsigned int order, const double step, const double tolerance )
+{
+  /** The required grid has half the spacing, and starts at index 1 of the
+   * current grid. Only points where all nonzero basis functions of both
+   * grids have a coefficient are compared.
+   */
+  const unsigned int dimension = requiredSize.size();
+  const double       first     = static_cast< double >( order / 2 );
+  const double       last      = static_cast< double >( requiredSize[ 0 ] - 1 ) - first;
+  const unsigned int numberOfSteps
+    = static_cast< unsigned int >( std::floor( ( last - first ) / step + 0.5 ) ) + 1;
+  unsigned int numberOfPoints = 1;
+  for( unsigned int d = 0; d < dimension; ++d )
+  {
+    numberOfPoints *= numberOfSteps;
+  }
+
+  double maxError = 0.0;
+  for( unsigned int p = 0; p < numberOfPoints; ++p )
+  {
+    std::vector< double > requiredIndex( dimension );
+    std::vector< double > currentIndex( dimension );
+    unsigned int          rest = p;
+    for( unsigned int d = 0; d < dimension; ++d )
+    {
+      requiredIndex[ d ] = first + step * ( rest % numberOfSteps );
+      currentIndex[ d ]  = 1.0 + 0.5 * requiredIndex[ d ];
+      rest              /= numberOfSteps;
+    }
+    for( unsigned int j = 0; j < dimension; ++j )
+    {
+      const double currentValue = EvaluateSpline(
+        currentParameters, currentSize, order, j, currentIndex );
+      const double requiredValue = EvaluateSpline(
+        requiredParameters, requiredSize, order, j, requiredIndex );
+      maxError = std::max( maxError, std::abs( requiredValue - currentValue ) );
+    }
+  }
+
+  std::cerr << name << ": maximum difference " << maxError << std::endl;
+  if( maxError > tolerance )
+  {
+    std::cerr << "ERROR: the upsampled spline differs from the current spline." << std::endl;
+    return false;
+  }
+  return true;
+
+} // end CompareSplines()
+
+
+/** Check that two parameter arrays are equal. */
+bool
+CompareParameters( const std::string & name, const ArrayType & a, const ArrayType & b )
+{
+  if( a.GetSize() != b.GetSize() )
+  {
+    std::cerr << "ERROR: " << name << ": the number of parameters differs." << std::endl;
+    return false;
+  }
+  for( unsigned int i = 0; i < a.GetSize(); ++i )
+  {
+    if( a[ i ] != b[ i ] )
+    {
+      std::cerr << "ERROR: " << name << ": parameter " << i << " is " << a[ i ]
+                << " instead of " << b[ i ] << std::endl;
+      return false;
+    }
+  }
+  return true;
+
+} // end CompareParameters()
+
+
+/** Upsample random parameters, with and without dyadic refinement. */
+template< unsigned int VDimension >
+bool
+TestUpsampling( const unsigned int order, RandomGeneratorType * randomGenerator )
+{
+  typedef itk::Image< double, VDimension > ImageType;
+  typedef itk::UpsampleBSplineParametersFilter<
+    ArrayType, ImageType >                  UpsampleFilterType;
+  typedef typename ImageType::RegionType    RegionType;
+  typedef typename ImageType::SizeType      SizeType;
+  typedef typename ImageType::SpacingType   SpacingType;
+  typedef typename ImageType::PointType     OriginType;
+  typedef typename ImageType::DirectionType DirectionType;
+
+  std::ostringstream name;
+  name << VDimension << "D, order " << order;
+
+  /** The current grid, and a required grid with half the spacing, whose
+   * nodes coincide with the current nodes or lie halfway between them.
+   */
+  SizeType currentSize;
+  currentSize.Fill( 6 );
+  SpacingType currentSpacing;
+  currentSpacing.Fill( 2.0 );
+  OriginType currentOrigin;
+  currentOrigin.Fill( 0.0 );
+  SizeType requiredSize;
+  requiredSize.Fill( 8 );
+  SpacingType requiredSpacing;
+  requiredSpacing.Fill( 1.0 );
+  OriginType requiredOrigin;
+  requiredOrigin.Fill( 2.0 );
+  DirectionType direction;
+  direction.SetIdentity();
+
+  const RegionType currentRegion( currentSize );
+  const RegionType requiredRegion( requiredSize );
+  std::vector< unsigned int > currentGridSize( VDimension, 6 );
+  std::vector< unsigned int > requiredGridSize( VDimension, 8 );
+
+  ArrayType currentParameters( currentRegion.GetNumberOfPixels() * VDimension );
+  for( unsigned int i = 0; i < currentParameters.GetSize(); ++i )
+  {
+    currentParameters[ i ] = randomGenerator->GetUniformVariate( -1.0, 1.0 );
+  }
+
+  typename UpsampleFilterType::Pointer filters[ 2 ];
+  ArrayType                            requiredParameters[ 2 ];
+  for( unsigned int f = 0; f < 2; ++f )
+  {
+    filters[ f ] = UpsampleFilterType::New();
+    filters[ f ]->SetCurrentGridOrigin( currentOrigin );
+    filters[ f ]->SetCurrentGridSpacing( currentSpacing );
+    filters[ f ]->SetCurrentGridDirection( direction );
+    filters[ f ]->SetCurrentGridRegion( currentRegion );
+    filters[ f ]->SetRequiredGridOrigin( requiredOrigin );
+    filters[ f ]->SetRequiredGridSpacing( requiredSpacing );
+    filters[ f ]->SetRequiredGridDirection( direction );
+    filters[ f ]->SetRequiredGridRegion( requiredRegion );
+    filters[ f ]->SetBSplineOrder( order );
+    filters[ f ]->SetNumberOfThreads( 3 );
+    filters[ f ]->SetUseDyadicRefinement( f == 0 );
+    filters[ f ]->UpsampleParameters( currentParameters, requiredParameters[ f ] );
+  }
+
+  /** The refinement is exact for odd orders; even orders use the resampling. */
+  if( order % 2 == 1 )
+  {
+    if( !CompareSplines( name.str() + ", dyadic refinement at the nodes",
+      currentParameters, currentGridSize, requiredParameters[ 0 ], requiredGridSize,
+      order, 1.0, 1e-10 ) )
+    {
+      return false;
+    }
+    if( !CompareSplines( name.str() + ", dyadic refinement between the nodes",
+      currentParameters, currentGridSize, requiredParameters[ 0 ], requiredGridSize,
+      order, 0.25, 1e-10 ) )
+    {
+      return false;
+    }
+  }
+  else if( !CompareParameters( name.str() + ", fall back for even orders",
+    requiredParameters[ 0 ], requiredParameters[ 1 ] ) )
+  {
+    return false;
+  }
+
+  /** The resampling interpolates the current spline at the required nodes. */
+  if( order == 3 )
+  {
+    if( !CompareSplines( name.str() + ", resampling at the nodes",
+      currentParameters, currentGridSize, requiredParameters[ 1 ], requiredGridSize,
+      order, 1.0, 1e-6 ) )
+    {
+      return false;
+    }
+  }
+
+  /** A grid with a spacing that does not halve is not a dyadic refinement. */
+  SpacingType otherSpacing;
+  otherSpacing.Fill( 1.5 );
+  for( unsigned int f = 0; f < 2; ++f )
+  {
+    filters[ f ]->SetRequiredGridSpacing( otherSpacing );
+    filters[ f ]->UpsampleParameters( currentParameters, requiredParameters[ f ] );
+  }
+  if( !CompareParameters( name.str() + ", fall back for other spacings",
+    requiredParameters[ 0 ], requiredParameters[ 1 ] ) )
+  {
+    return false;
+  }
+
+  return true;
+
+} // end TestUpsampling()
+
+
+int
+main( int argc, char * argv[] )
+{
+  RandomGeneratorType::Pointer randomGenerator = RandomGeneratorType::GetInstance();
+  randomGenerator->SetSeed( 42 );
+
+  try
+  {
+    for( unsigned int order = 1; order <= 3; ++order )
+    {
+      if( !TestUpsampling< 2 >( order, randomGenerator ) )
+      {
+        return EXIT_FAILURE;
+      }
+      if( !TestUpsampling< 3 >( order, randomGenerator ) )
+      {
+        return EXIT_FAILURE;
+      }
+    }
+  }
+  catch( itk::ExceptionObject & excp )
+  {
+    std::cerr << excp << std::endl;
+    return EXIT_FAILURE;
+  }
+
+  /** Return a value. */
+  return EXIT_SUCCESS;
+
+} // end main